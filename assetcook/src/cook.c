@@ -0,0 +1,451 @@
+#include "cook.h"
+#include "cook_manifest.h"
+
+#include <containers/darray.h>
+#include <core/clock.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <core/xxhash.h>
+#include <platform/filesystem.h>
+#include <resources/resource_types.h>
+#include <resources/loaders/image_loader.h>
+#include <resources/loaders/mesh_loader.h>
+#include <systems/job_system.h>
+#include <systems/resource_system.h>
+#include <systems/vfs_system.h>
+
+typedef enum cook_asset_type {
+    COOK_ASSET_TYPE_MODEL,
+    COOK_ASSET_TYPE_TEXTURE,
+    COOK_ASSET_TYPE_MATERIAL,
+    COOK_ASSET_TYPE_SHADER,
+    COOK_ASSET_TYPE_MAX
+} cook_asset_type;
+
+// one source asset, and what became of it. filled in by the job that cooks it
+typedef struct cook_asset {
+    cook_asset_type type;
+    // which of the cooker's source extensions it has
+    u32 extension_index;
+    // relative to the asset directory, such as "models/falcon.obj"
+    char path[VFS_MAX_PATH_LENGTH];
+    // the resource name it is loaded by, such as "falcon"
+    char name[VFS_MAX_PATH_LENGTH];
+
+    const cook_options* options;
+    const cook_manifest* manifest;
+
+    u64 content_hash;
+    b8 up_to_date;
+    b8 success;
+} cook_asset;
+
+typedef b8 (*pfn_cook_asset)(cook_asset* asset);
+
+// how one type of asset is cooked
+typedef struct cooker {
+    const char* name;
+    // where the sources are, relative to the asset directory. matches the loader's type path
+    const char* directory;
+    u32 extension_count;
+    // the source extensions, in the same order of preference as the loader
+    const char* extensions[4];
+    // the extension of the cooked file, written alongside the source. 0 if the cooker only validates
+    const char* cooked_extension;
+    // bump whenever the cooked output changes, so everything of the type is cooked again
+    u32 version;
+    pfn_cook_asset cook;
+} cooker;
+
+static b8 cook_model(cook_asset* asset);
+static b8 cook_texture(cook_asset* asset);
+static b8 cook_material(cook_asset* asset);
+static b8 cook_shader(cook_asset* asset);
+
+static const cooker cookers[COOK_ASSET_TYPE_MAX] = {
+    {"model", "models/", 1, {".obj"}, ".ksm", 6, cook_model},
+    {"texture", "textures/", 4, {".tga", ".png", ".jpg", ".bmp"}, ".kti", 1, cook_texture},
+    {"material", "materials/", 1, {".kmt"}, 0, 1, cook_material},
+    {"shader", "shaders/", 1, {".shadercfg"}, 0, 1, cook_shader}};
+
+// NOTE: begin hashing
+
+// hashes a file's content, starting from seed. a missing file fails, an empty one is fine
+static b8 hash_file(const char* path, u64 seed, u64* out_hash) {
+    file_mapping mapping;
+    if (!filesystem_map(path, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+        return false;
+    }
+    *out_hash = xxhash64(mapping.data, mapping.size, seed);
+    filesystem_unmap(&mapping);
+    return true;
+}
+
+// an obj depends on the material libraries it names, as those become .kmt files when it is imported. each one found is
+// chained into the hash
+static b8 hash_obj_dependencies(const cook_asset* asset, const char* obj_path, u64* in_out_hash) {
+    file_mapping mapping;
+    if (!filesystem_map(obj_path, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+        return false;
+    }
+
+    char directory[VFS_MAX_PATH_LENGTH] = "";
+    string_directory_from_path(directory, obj_path);
+
+    const char* text = mapping.data;
+    u64 position = 0;
+    b8 result = true;
+    while (position < mapping.size) {
+        u64 line_end = position;
+        while (line_end < mapping.size && text[line_end] != '\n') {
+            line_end++;
+        }
+
+        if (line_end - position > 7 && strings_nequal(text + position, "mtllib ", 7)) {
+            char line[VFS_MAX_PATH_LENGTH] = "";
+            u64 length = line_end - position - 7;
+            if (length >= VFS_MAX_PATH_LENGTH) {
+                length = VFS_MAX_PATH_LENGTH - 1;
+            }
+            kcopy_memory(line, text + position + 7, length);
+            char mtl_path[VFS_MAX_PATH_LENGTH * 2];
+            string_format(mtl_path, "%s%s", directory, string_trim(line));
+            if (!hash_file(mtl_path, *in_out_hash, in_out_hash)) {
+                KERROR("Model '%s' uses material library '%s', which could not be read.", asset->path, mtl_path);
+                result = false;
+                break;
+            }
+        }
+        position = line_end + 1;
+    }
+
+    filesystem_unmap(&mapping);
+    return result;
+}
+
+// NOTE: end hashing
+
+// NOTE: begin cookers
+
+static b8 cook_model(cook_asset* asset) {
+    // importing writes the .ksm, along with a .kmt for each material in the obj's material libraries. cooking is the
+    // time to spend on optimizing the mesh, simplifying it into levels of detail and splitting those into meshlets
+    mesh_resource_params params = mesh_loader_cook_params(asset->options->pack_meshes);
+    params.force_import = true;
+    resource r;
+    if (!resource_system_load(asset->name, RESOURCE_TYPE_MESH, &params, &r)) {
+        return false;
+    }
+    resource_system_unload(&r);
+    return true;
+}
+
+static b8 cook_texture(cook_asset* asset) {
+    // cooked the way the texture system asks for them. cube map faces are loaded the other way up, which costs them a
+    // copy rather than a decode
+    image_resource_params params = {};
+    params.flip_y = true;
+    params.force_import = true;
+    resource r;
+    if (!resource_system_load(asset->name, RESOURCE_TYPE_IMAGE, &params, &r)) {
+        return false;
+    }
+
+    char cooked_path[VFS_MAX_PATH_LENGTH * 2];
+    string_format(cooked_path, "%s/%s%s%s", asset->options->asset_directory, cookers[asset->type].directory, asset->name, cookers[asset->type].cooked_extension);
+    b8 result = image_loader_write_kti(cooked_path, r.data, true);
+    resource_system_unload(&r);
+    return result;
+}
+
+// warns about a texture a material uses that can't be found, as it would fail at runtime instead
+static void check_texture_exists(const cook_asset* asset, const char* texture_name) {
+    if (!texture_name[0]) {
+        return;
+    }
+    const cooker* textures = &cookers[COOK_ASSET_TYPE_TEXTURE];
+    char path[VFS_MAX_PATH_LENGTH];
+    string_format(path, "%s%s%s", textures->directory, texture_name, textures->cooked_extension);
+    if (vfs_exists(path)) {
+        return;
+    }
+    for (u32 i = 0; i < textures->extension_count; ++i) {
+        string_format(path, "%s%s%s", textures->directory, texture_name, textures->extensions[i]);
+        if (vfs_exists(path)) {
+            return;
+        }
+    }
+    KWARN("Material '%s' uses texture '%s', which could not be found.", asset->path, texture_name);
+}
+
+static b8 cook_material(cook_asset* asset) {
+    // materials are small enough that parsing them is not worth cooking away. they are just checked
+    resource r;
+    if (!resource_system_load(asset->name, RESOURCE_TYPE_MATERIAL, 0, &r)) {
+        return false;
+    }
+    material_config* config = r.data;
+    check_texture_exists(asset, config->diffuse_map_name);
+    check_texture_exists(asset, config->specular_map_name);
+    check_texture_exists(asset, config->normal_map_name);
+    resource_system_unload(&r);
+    return true;
+}
+
+static b8 cook_shader(cook_asset* asset) {
+    // same as materials, just checked
+    resource r;
+    if (!resource_system_load(asset->name, RESOURCE_TYPE_SHADER, 0, &r)) {
+        return false;
+    }
+    resource_system_unload(&r);
+    return true;
+}
+
+// NOTE: end cookers
+
+static void cook_asset_job_entry(void* params) {
+    cook_asset* asset = params;
+    const cooker* c = &cookers[asset->type];
+
+    char source_path[VFS_MAX_PATH_LENGTH * 2];
+    string_format(source_path, "%s/%s", asset->options->asset_directory, asset->path);
+    // packing changes what a model cooks to, so it is part of the hash
+    u64 seed = asset->type == COOK_ASSET_TYPE_MODEL && asset->options->pack_meshes ? 1 : 0;
+    if (!hash_file(source_path, seed, &asset->content_hash)) {
+        KERROR("Unable to read %s '%s'.", c->name, asset->path);
+        asset->success = false;
+        return;
+    }
+    if (asset->type == COOK_ASSET_TYPE_MODEL && !hash_obj_dependencies(asset, source_path, &asset->content_hash)) {
+        asset->success = false;
+        return;
+    }
+
+    if (!asset->options->force) {
+        const cook_manifest_entry* entry = cook_manifest_find(asset->manifest, asset->path);
+        b8 output_exists = true;
+        if (c->cooked_extension) {
+            char cooked_path[VFS_MAX_PATH_LENGTH * 2];
+            string_format(cooked_path, "%s/%s%s%s", asset->options->asset_directory, c->directory, asset->name, c->cooked_extension);
+            output_exists = filesystem_exists(cooked_path);
+        }
+        if (entry && entry->content_hash == asset->content_hash && entry->cooker_version == c->version && output_exists) {
+            asset->up_to_date = true;
+            asset->success = true;
+            return;
+        }
+    }
+
+    KINFO("Cooking %s '%s'...", c->name, asset->path);
+    asset->success = c->cook(asset);
+    if (!asset->success) {
+        KERROR("Failed to cook %s '%s'.", c->name, asset->path);
+    }
+}
+
+// files found in the asset directory, sorted by type
+typedef struct asset_scan {
+    cook_asset* assets;  // darray
+    const cook_options* options;
+    const cook_manifest* manifest;
+} asset_scan;
+
+// finds the start of a path's extension, including the dot. 0 if it has none
+static const char* path_extension(const char* path) {
+    const char* extension = 0;
+    for (const char* c = path; *c; ++c) {
+        if (*c == '.') {
+            extension = c;
+        } else if (*c == '/') {
+            extension = 0;
+        }
+    }
+    return extension;
+}
+
+static void on_file_found(const char* path, u64 size, void* user_data) {
+    asset_scan* scan = user_data;
+    const char* extension = path_extension(path);
+    if (!extension) {
+        return;
+    }
+
+    for (u32 type = 0; type < COOK_ASSET_TYPE_MAX; ++type) {
+        const cooker* c = &cookers[type];
+        u64 directory_length = string_length(c->directory);
+        if (!strings_nequal(path, c->directory, directory_length)) {
+            continue;
+        }
+        for (u32 e = 0; e < c->extension_count; ++e) {
+            if (!strings_equali(extension, c->extensions[e])) {
+                continue;
+            }
+
+            cook_asset asset;
+            kzero_memory(&asset, sizeof(cook_asset));
+            asset.type = type;
+            asset.extension_index = e;
+            asset.options = scan->options;
+            asset.manifest = scan->manifest;
+            string_ncopy(asset.path, path, VFS_MAX_PATH_LENGTH - 1);
+            kcopy_memory(asset.name, path + directory_length, (u64)(extension - path) - directory_length);
+
+            // the loader only ever picks one source per name (the first extension found), so only that one is cooked
+            u64 count = darray_length(scan->assets);
+            for (u64 i = 0; i < count; ++i) {
+                cook_asset* existing = &scan->assets[i];
+                if (existing->type == type && strings_equal(existing->name, asset.name)) {
+                    if (e < existing->extension_index) {
+                        *existing = asset;
+                    }
+                    return;
+                }
+            }
+            darray_push(scan->assets, asset);
+            return;
+        }
+    }
+}
+
+// cooks every asset of the given types as a job each, and waits for them all
+static void cook_wave(cook_asset* assets, u32 type_mask) {
+    job_counter counter = {};
+    u64 count = darray_length(assets);
+    for (u64 i = 0; i < count; ++i) {
+        if (type_mask & (1 << assets[i].type)) {
+            job_info info = job_create(cook_asset_job_entry, &assets[i], JOB_PRIORITY_NORMAL);
+            info.counter = &counter;
+            info.use_fiber = true;
+            job_system_submit(info);
+        }
+    }
+    job_system_wait(&counter);
+}
+
+// NOTE: begin archive
+
+// true if a file only exists to be cooked, so has no place in an archive. sources are left out only once they have
+// been cooked, so anything that failed still ships in a form the engine can load. the import manifests next to each
+// .ksm only matter alongside the obj, so they go too
+static b8 is_cooked_source(cook_asset* assets, const char* path) {
+    const char* extension = path_extension(path);
+    if (extension && (strings_equali(extension, ".mtl") || strings_equali(extension, ".glsl") || strings_equali(extension, ".meta"))) {
+        return true;
+    }
+    u64 count = darray_length(assets);
+    for (u64 i = 0; i < count; ++i) {
+        if (assets[i].success && cookers[assets[i].type].cooked_extension && strings_equal(assets[i].path, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct archive_scan {
+    const cook_options* options;
+    cook_asset* assets;
+    // darray
+    vfs_archive_file* files;
+} archive_scan;
+
+static void on_archive_file_found(const char* path, u64 size, void* user_data) {
+    archive_scan* scan = user_data;
+    char manifest_name[VFS_MAX_PATH_LENGTH] = "";
+    string_filename_from_path(manifest_name, scan->options->manifest_path);
+    if (strings_equal(path, manifest_name) || is_cooked_source(scan->assets, path)) {
+        return;
+    }
+
+    char source_path[VFS_MAX_PATH_LENGTH * 2];
+    string_format(source_path, "%s/%s", scan->options->asset_directory, path);
+    vfs_archive_file file;
+    file.path = string_duplicate(path);
+    file.source_path = string_duplicate(source_path);
+    file.compress = true;
+    darray_push(scan->files, file);
+}
+
+static b8 write_archive(const cook_options* options, cook_asset* assets) {
+    archive_scan scan;
+    scan.options = options;
+    scan.assets = assets;
+    scan.files = darray_create(vfs_archive_file);
+    b8 result = filesystem_walk_directory(options->asset_directory, on_archive_file_found, &scan);
+
+    u32 count = (u32)darray_length(scan.files);
+    if (result) {
+        KINFO("Writing %u files to archive '%s'...", count, options->archive_path);
+        result = vfs_archive_write(options->archive_path, count, scan.files, 0);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        kfree((char*)scan.files[i].path, string_length(scan.files[i].path) + 1, MEMORY_TAG_STRING);
+        kfree((char*)scan.files[i].source_path, string_length(scan.files[i].source_path) + 1, MEMORY_TAG_STRING);
+    }
+    darray_destroy(scan.files);
+    return result;
+}
+
+// NOTE: end archive
+
+b8 cook_assets(const cook_options* options, cook_results* out_results) {
+    kzero_memory(out_results, sizeof(cook_results));
+    clock timer;
+    clock_start(&timer);
+
+    cook_manifest manifest;
+    cook_manifest_create(&manifest);
+    if (!options->force) {
+        cook_manifest_load(options->manifest_path, &manifest);
+    }
+
+    asset_scan scan;
+    scan.assets = darray_create(cook_asset);
+    scan.options = options;
+    scan.manifest = &manifest;
+    if (!filesystem_walk_directory(options->asset_directory, on_file_found, &scan)) {
+        KERROR("Unable to read asset directory '%s'.", options->asset_directory);
+        darray_destroy(scan.assets);
+        cook_manifest_destroy(&manifest);
+        return false;
+    }
+    cook_asset* assets = scan.assets;
+    u64 count = darray_length(assets);
+    KINFO("Found %llu assets in '%s'.", count, options->asset_directory);
+
+    // models go first, as importing one writes .kmt files that the materials are then checked from
+    cook_wave(assets, 1 << COOK_ASSET_TYPE_MODEL);
+    cook_wave(assets, ~(1 << COOK_ASSET_TYPE_MODEL));
+
+    // the new manifest has everything that is now cooked. anything that failed is left out, so it is tried again
+    cook_manifest next_manifest;
+    cook_manifest_create(&next_manifest);
+    for (u64 i = 0; i < count; ++i) {
+        if (!assets[i].success) {
+            out_results->failed_count++;
+            continue;
+        }
+        if (assets[i].up_to_date) {
+            out_results->up_to_date_count++;
+        } else {
+            out_results->cooked_count++;
+        }
+        cook_manifest_add(&next_manifest, assets[i].path, assets[i].content_hash, cookers[assets[i].type].version);
+    }
+    b8 result = cook_manifest_save(options->manifest_path, &next_manifest);
+    cook_manifest_destroy(&next_manifest);
+    cook_manifest_destroy(&manifest);
+
+    if (options->archive_path && !write_archive(options, assets)) {
+        KERROR("Failed to write archive '%s'.", options->archive_path);
+        result = false;
+    }
+
+    darray_destroy(assets);
+
+    clock_update(&timer);
+    KINFO("Cooked %u, %u up to date, %u failed in %.2fs.", out_results->cooked_count, out_results->up_to_date_count, out_results->failed_count, timer.elapsed);
+    return result && out_results->failed_count == 0;
+}
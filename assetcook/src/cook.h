@@ -0,0 +1,32 @@
+#pragma once
+
+#include <defines.h>
+
+typedef struct cook_options {
+    // @brief the asset directory. cooked files are written alongside their sources, where the engine looks for them
+    const char* asset_directory;
+    // @brief where the manifest of what has been cooked is kept
+    const char* manifest_path;
+    // @brief optional. if set, an archive of everything the engine needs (cooked files rather than their sources) is
+    // written here once cooking is done
+    const char* archive_path;
+    // @brief cook everything, even what the manifest says is up to date
+    b8 force;
+    // @brief store model vertices and indices packed, which makes the .ksm files smaller but means they are unpacked on
+    // load. see mesh_resource_params.pack_streams
+    b8 pack_meshes;
+} cook_options;
+
+typedef struct cook_results {
+    u32 cooked_count;
+    u32 up_to_date_count;
+    u32 failed_count;
+} cook_results;
+
+// @brief cooks every model, texture, material and shader config in the asset directory that has changed since it was
+// last cooked. the assets are cooked in parallel on the job system, which (along with the vfs and resource systems)
+// must already be running, with the resource system's base path set to the asset directory
+// @param options how to cook
+// @param out_results a pointer to hold counts of what happened
+// @return true if everything cooked (or was already up to date), otherwise false
+b8 cook_assets(const cook_options* options, cook_results* out_results);
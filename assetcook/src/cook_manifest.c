@@ -0,0 +1,109 @@
+#include "cook_manifest.h"
+
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <core/xxhash.h>
+#include <platform/filesystem.h>
+
+#include <stdio.h>  // sscanf
+
+// bump if the layout of the file changes. older manifests are then ignored, so everything is cooked again
+#define COOK_MANIFEST_VERSION 1
+
+void cook_manifest_create(cook_manifest* out_manifest) {
+    out_manifest->entries = darray_create(cook_manifest_entry);
+}
+
+void cook_manifest_destroy(cook_manifest* manifest) {
+    if (manifest->entries) {
+        darray_destroy(manifest->entries);
+        manifest->entries = 0;
+    }
+}
+
+void cook_manifest_load(const char* path, cook_manifest* out_manifest) {
+    file_handle f;
+    if (!filesystem_exists(path) || !filesystem_open(path, FILE_MODE_READ, false, &f)) {
+        return;
+    }
+
+    char line_buffer[VFS_MAX_PATH_LENGTH + 64];
+    char* p = &line_buffer[0];
+    u64 line_length = 0;
+    u32 line_number = 0;
+    b8 version_ok = false;
+    while (filesystem_read_line(&f, sizeof(line_buffer), &p, &line_length)) {
+        line_number++;
+        char* line = string_trim(line_buffer);
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+
+        if (!version_ok) {
+            u32 version = 0;
+            if (sscanf(line, "version=%u", &version) != 1 || version != COOK_MANIFEST_VERSION) {
+                KWARN("Cook manifest '%s' is from a different version, everything will be cooked.", path);
+                break;
+            }
+            version_ok = true;
+            continue;
+        }
+
+        cook_manifest_entry entry;
+        kzero_memory(&entry, sizeof(cook_manifest_entry));
+        if (sscanf(line, "%llx %u %511[^\n]", &entry.content_hash, &entry.cooker_version, entry.path) != 3) {
+            KWARN("Skipping malformed line %u of cook manifest '%s'.", line_number, path);
+            continue;
+        }
+        entry.path_hash = xxhash64(entry.path, string_length(entry.path), 0);
+        darray_push(out_manifest->entries, entry);
+    }
+
+    filesystem_close(&f);
+}
+
+b8 cook_manifest_save(const char* path, const cook_manifest* manifest) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &f)) {
+        KERROR("Unable to open cook manifest '%s' for writing.", path);
+        return false;
+    }
+
+    char line_buffer[VFS_MAX_PATH_LENGTH + 64];
+    filesystem_write_line(&f, "#assetcook manifest. content hash, cooker version, source path");
+    string_format(line_buffer, "version=%u", COOK_MANIFEST_VERSION);
+    filesystem_write_line(&f, line_buffer);
+    u64 count = darray_length(manifest->entries);
+    for (u64 i = 0; i < count; ++i) {
+        const cook_manifest_entry* entry = &manifest->entries[i];
+        string_format(line_buffer, "%016llx %u %s", entry->content_hash, entry->cooker_version, entry->path);
+        filesystem_write_line(&f, line_buffer);
+    }
+
+    filesystem_close(&f);
+    return true;
+}
+
+const cook_manifest_entry* cook_manifest_find(const cook_manifest* manifest, const char* path) {
+    u64 path_hash = xxhash64(path, string_length(path), 0);
+    u64 count = darray_length(manifest->entries);
+    for (u64 i = 0; i < count; ++i) {
+        const cook_manifest_entry* entry = &manifest->entries[i];
+        if (entry->path_hash == path_hash && strings_equal(entry->path, path)) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+void cook_manifest_add(cook_manifest* manifest, const char* path, u64 content_hash, u32 cooker_version) {
+    cook_manifest_entry entry;
+    kzero_memory(&entry, sizeof(cook_manifest_entry));
+    entry.path_hash = xxhash64(path, string_length(path), 0);
+    entry.content_hash = content_hash;
+    entry.cooker_version = cooker_version;
+    string_ncopy(entry.path, path, VFS_MAX_PATH_LENGTH - 1);
+    darray_push(manifest->entries, entry);
+}
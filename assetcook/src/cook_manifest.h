@@ -0,0 +1,51 @@
+#pragma once
+
+#include <defines.h>
+#include <systems/vfs_system.h>
+
+// the manifest is how assetcook knows what is already cooked. one line per source asset, holding the hash of its
+// content (and anything it depends on) along with the version of the cooker that cooked it. if both still match, and
+// the cooked output is still there, the asset is skipped
+
+typedef struct cook_manifest_entry {
+    // @brief the hash of path, so lookups can skip most string compares
+    u64 path_hash;
+    // @brief the hash of the source content when it was cooked
+    u64 content_hash;
+    // @brief the version of the cooker used
+    u32 cooker_version;
+    // @brief the path of the source, relative to the asset directory
+    char path[VFS_MAX_PATH_LENGTH];
+} cook_manifest_entry;
+
+typedef struct cook_manifest {
+    // darray
+    cook_manifest_entry* entries;
+} cook_manifest;
+
+// @brief creates an empty manifest
+void cook_manifest_create(cook_manifest* out_manifest);
+
+// @brief destroys a manifest
+void cook_manifest_destroy(cook_manifest* manifest);
+
+// @brief loads a manifest written by cook_manifest_save. a missing or unreadable file gives an empty manifest, which
+// just means everything gets cooked
+// @param path the path of the manifest file
+// @param out_manifest a pointer to hold the manifest. must be created already
+void cook_manifest_load(const char* path, cook_manifest* out_manifest);
+
+// @brief writes a manifest out
+// @param path the path of the manifest file
+// @param manifest the manifest to write
+// @return true on success, otherwise false
+b8 cook_manifest_save(const char* path, const cook_manifest* manifest);
+
+// @brief finds the entry for a source path
+// @param manifest the manifest to search
+// @param path the path of the source, relative to the asset directory
+// @return the entry, or 0 if there is none
+const cook_manifest_entry* cook_manifest_find(const cook_manifest* manifest, const char* path);
+
+// @brief adds an entry
+void cook_manifest_add(cook_manifest* manifest, const char* path, u64 content_hash, u32 cooker_version);
@@ -0,0 +1,161 @@
+#include "cook.h"
+
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/logger.h>
+#include <memory/linear_allocator.h>
+#include <platform/async_io.h>
+#include <systems/job_system.h>
+#include <systems/resource_system.h>
+#include <systems/vfs_system.h>
+
+// assetcook - cooks the assets ahead of time, so the engine never has to. run from the bin folder like the testbed, or
+// pass the asset directory. see print_usage for the options
+
+// just the engine systems the loaders need. no window, renderer or game
+typedef struct assetcook_state {
+    linear_allocator systems_allocator;
+
+    u64 job_system_memory_requirement;
+    void* job_system_state;
+
+    u64 async_io_memory_requirement;
+    void* async_io_state;
+
+    u64 vfs_system_memory_requirement;
+    void* vfs_system_state;
+
+    u64 resource_system_memory_requirement;
+    void* resource_system_state;
+} assetcook_state;
+
+static void print_usage() {
+    KINFO("usage: assetcook [options] [asset_directory]");
+    KINFO("  asset_directory    the assets to cook. defaults to ../assets");
+    KINFO("  -f, --force        cook everything, even what is up to date");
+    KINFO("  -a, --archive <path>  also write an archive of the cooked assets for the engine to mount");
+    KINFO("  -j, --jobs <count>    the number of worker threads. defaults to one less than the processor count");
+    KINFO("  -p, --pack-meshes  store model vertices and indices packed. smaller, but unpacked on load");
+}
+
+static b8 systems_startup(assetcook_state* state, const char* asset_directory, u8 worker_count) {
+    linear_allocator_create(MEBIBYTES(16), 0, &state->systems_allocator);
+
+    job_system_config job_sys_config;
+    job_sys_config.worker_count = worker_count;
+    job_sys_config.max_job_count = 1024;
+    job_sys_config.fiber_count = 64;
+    job_sys_config.fiber_stack_size = KIBIBYTES(512);
+    job_system_initialize(&state->job_system_memory_requirement, 0, job_sys_config);
+    state->job_system_state = linear_allocator_allocate(&state->systems_allocator, state->job_system_memory_requirement);
+    if (!job_system_initialize(&state->job_system_memory_requirement, state->job_system_state, job_sys_config)) {
+        KFATAL("Failed to initialize job system.");
+        return false;
+    }
+
+    async_io_config async_io_conf;
+    async_io_conf.max_request_count = 256;
+    async_io_conf.fallback_thread_count = 4;
+    async_io_conf.force_fallback = false;
+    async_io_initialize(&state->async_io_memory_requirement, 0, async_io_conf);
+    state->async_io_state = linear_allocator_allocate(&state->systems_allocator, state->async_io_memory_requirement);
+    if (!async_io_initialize(&state->async_io_memory_requirement, state->async_io_state, async_io_conf)) {
+        KFATAL("Failed to initialize async io.");
+        return false;
+    }
+
+    vfs_system_config vfs_sys_config;
+    vfs_sys_config.max_mount_count = 4;
+    vfs_system_initialize(&state->vfs_system_memory_requirement, 0, vfs_sys_config);
+    state->vfs_system_state = linear_allocator_allocate(&state->systems_allocator, state->vfs_system_memory_requirement);
+    if (!vfs_system_initialize(&state->vfs_system_memory_requirement, state->vfs_system_state, vfs_sys_config)) {
+        KFATAL("Failed to initialize vfs.");
+        return false;
+    }
+
+    // no archive, only ever the sources are cooked
+    resource_system_config resource_sys_config;
+    resource_sys_config.asset_base_path = (char*)asset_directory;
+    resource_sys_config.archive_path = 0;
+    resource_sys_config.max_loader_count = 32;
+    resource_sys_config.max_async_load_count = 0;
+    resource_sys_config.max_concurrent_load_count = 0;
+    // everything is loaded once, so a cache would only hold on to memory
+    resource_sys_config.cache_budget = 0;
+    resource_sys_config.max_cache_entry_count = 0;
+    resource_system_initialize(&state->resource_system_memory_requirement, 0, resource_sys_config);
+    state->resource_system_state = linear_allocator_allocate(&state->systems_allocator, state->resource_system_memory_requirement);
+    if (!resource_system_initialize(&state->resource_system_memory_requirement, state->resource_system_state, resource_sys_config)) {
+        KFATAL("Failed to initialize resource system.");
+        return false;
+    }
+
+    return true;
+}
+
+static void systems_shutdown(assetcook_state* state) {
+    if (state->resource_system_state) {
+        resource_system_shutdown(state->resource_system_state);
+    }
+    if (state->vfs_system_state) {
+        vfs_system_shutdown(state->vfs_system_state);
+    }
+    if (state->async_io_state) {
+        async_io_shutdown(state->async_io_state);
+    }
+    if (state->job_system_state) {
+        job_system_shutdown(state->job_system_state);
+    }
+    linear_allocator_destroy(&state->systems_allocator);
+}
+
+int main(int argc, char** argv) {
+    cook_options options;
+    kzero_memory(&options, sizeof(cook_options));
+    options.asset_directory = "../assets";
+    u8 worker_count = 0;
+
+    for (i32 i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strings_equal(arg, "-f") || strings_equal(arg, "--force")) {
+            options.force = true;
+        } else if (strings_equal(arg, "-p") || strings_equal(arg, "--pack-meshes")) {
+            options.pack_meshes = true;
+        } else if ((strings_equal(arg, "-a") || strings_equal(arg, "--archive")) && i + 1 < argc) {
+            options.archive_path = argv[++i];
+        } else if ((strings_equal(arg, "-j") || strings_equal(arg, "--jobs")) && i + 1 < argc) {
+            if (!string_to_u8(argv[++i], &worker_count)) {
+                print_usage();
+                return 1;
+            }
+        } else if (arg[0] == '-') {
+            print_usage();
+            return strings_equal(arg, "-h") || strings_equal(arg, "--help") ? 0 : 1;
+        } else {
+            options.asset_directory = arg;
+        }
+    }
+
+    memory_system_configuration memory_system_config = {};
+    memory_system_config.total_alloc_size = GIBIBYTES(1);
+    if (!memory_system_initialize(memory_system_config)) {
+        KFATAL("Failed to initialize memory system.");
+        return 1;
+    }
+
+    char manifest_path[512];
+    string_format(manifest_path, "%s/assetcook.manifest", options.asset_directory);
+    options.manifest_path = manifest_path;
+
+    assetcook_state state;
+    kzero_memory(&state, sizeof(assetcook_state));
+    b8 result = systems_startup(&state, options.asset_directory, worker_count);
+    if (result) {
+        cook_results results;
+        result = cook_assets(&options, &results);
+    }
+    systems_shutdown(&state);
+    memory_system_shutdown();
+
+    return result ? 0 : 1;
+}
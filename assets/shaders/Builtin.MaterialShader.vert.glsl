@@ -2,11 +2,12 @@
 
 // allows us to take in individual vertex data and configure it to pass to the fragment shader
 // in from the application side
-layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_normal;
-layout(location = 2) in vec2 in_texcoord;
-layout(location = 3) in vec4 in_colour;
-layout(location = 4) in vec4 in_tangent;
+// packed vertices (vertex_3d_packed). the position is 0-1 within the geometry's bounds, which the model matrix scales
+// back out, with the tangent handedness in w. the normal and tangent are octahedral encoded
+layout(location = 0) in vec4 in_position;
+layout(location = 1) in vec2 in_normal;
+layout(location = 2) in vec2 in_tangent;
+layout(location = 3) in vec2 in_texcoord;
 
 // very similar to a stucture in c
 // each uniform will have a unique binding - its like the slot the uniform fits into
@@ -39,19 +40,30 @@ layout(location = 1) out struct dto {
     vec4 tangent;
 } out_dto;
 
+// the reverse of octahedral_encode in geometry_utils.c
+vec3 octahedral_decode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
 void main() {
+    vec3 position = in_position.xyz;
     out_dto.tex_coord = in_texcoord; // pass the tex coords to the frag shader
-    out_dto.colour = in_colour;
+    // colour isn't stored when packed, and was always white
+    out_dto.colour = vec4(1.0);
     // fragment position in world space
-    out_dto.frag_position = vec3(u_push_constants.model * vec4(in_position, 1.0));
+    out_dto.frag_position = vec3(u_push_constants.model * vec4(position, 1.0));
     // copy the normal over
     mat3 m3_model = mat3(u_push_constants.model);
-    out_dto.normal = normalize(m3_model * in_normal);
-    out_dto.tangent = vec4(normalize(m3_model * in_tangent.xyz), in_tangent.w);
+    out_dto.normal = normalize(m3_model * octahedral_decode(in_normal));
+    out_dto.tangent = vec4(normalize(m3_model * octahedral_decode(in_tangent)), in_position.w * 2.0 - 1.0);
 	out_dto.ambient = global_ubo.ambient_colour;
     out_dto.view_position = global_ubo.view_position;
     // the final position sent to the fragment shader, is projection matrix times the view matrix times the position, when we add a model matrix, it will go in between view and position, the order is important
-    gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(in_position, 1.0); 
+    gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(position, 1.0); 
 
     out_mode = global_ubo.mode;
 }
\ No newline at end of file
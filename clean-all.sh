@@ -25,4 +25,11 @@ then
 echo "Error:"$ERRORLEVEL && exit
 fi
 
+make -f makefile.assetcook.linux.mak clean
+ERRORLEVEL=$?
+if [ $ERRORLEVEL -ne 0 ]
+then
+echo "Error:"$ERRORLEVEL && exit
+fi
+
 echo "All assemblies cleaned successfully."
\ No newline at end of file
@@ -8,8 +8,10 @@
 #include "core/kmemory.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/input_recording.h"
 #include "core/clock.h"
 #include "core/kstring.h"
+#include "core/profiler.h"
 
 #include "memory/linear_allocator.h"
 
@@ -23,6 +25,10 @@
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
 #include "systems/render_view_system.h"
+#include "systems/job_system.h"
+#include "platform/async_io.h"
+#include "systems/vfs_system.h"
+#include "systems/hot_reload_system.h"
 
 // TODO: temp
 #include "math/kmath.h"
@@ -53,14 +59,34 @@ typedef struct application_state {
     u64 logging_system_memory_requirement;  // where the amount of storage that is needed for the logger system is stored
     void* logging_system_state;             // a pointer to where the logger system state is being stored
 
+    // profiler state allocation
+    u64 profiler_memory_requirement;
+    void* profiler_state;
+
     // input system state allocation
     u64 input_system_memory_requirement;  // where the amount of storage that is needed for the input system is stored
     void* input_system_state;             // a pointer to where the input state is being store
 
+    // input recording system state allocation
+    u64 input_recording_memory_requirement;
+    void* input_recording_state;
+
     // platform system state allocation
     u64 platform_system_memory_requirement;  // where the amount of storage that is needed for the platform system is stored
     void* platform_system_state;             // a pointer to where the platform state is being store
 
+    // job system state allocation
+    u64 job_system_memory_requirement;
+    void* job_system_state;
+
+    // async io state allocation
+    u64 async_io_memory_requirement;
+    void* async_io_state;
+
+    // vfs state allocation
+    u64 vfs_system_memory_requirement;
+    void* vfs_system_state;
+
     // resource system state allocation
     u64 resource_system_memory_requirement;  // where the amount of storage that is needed for the resource system is stored
     void* resource_system_state;             // a pointer to where the resource state is being store
@@ -90,6 +116,9 @@ typedef struct application_state {
     u64 camera_system_memory_requirement;
     void* camera_system_state;
 
+    u64 hot_reload_system_memory_requirement;
+    void* hot_reload_system_state;
+
     // TODO: temp
     skybox sb;
 
@@ -141,6 +170,59 @@ b8 event_on_debug_event(u16 code, void* sender, void* listener_inst, event_conte
 
     return true;
 }
+
+// a test mesh streamed in from file. it is read and parsed on the job system, then its geometry is acquired (which
+// uploads it to the renderer) once it lands back on the main thread
+typedef struct test_mesh_load {
+    const char* name;
+    transform transform;
+} test_mesh_load;
+
+static test_mesh_load test_mesh_loads[2];
+
+// a test mesh changed on disk. its geometries are replaced in place, unless it now has a different number of them
+static void on_test_mesh_reloaded(const resource* mesh_resource, void* user_data) {
+    mesh* m = user_data;
+    geometry_config* configs = (geometry_config*)mesh_resource->data;
+    u32 geometry_count = mesh_resource->data_size;
+    if (geometry_count == m->geometry_count) {
+        for (u32 i = 0; i < geometry_count; ++i) {
+            geometry_system_reload(m->geometries[i], configs[i]);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < m->geometry_count; ++i) {
+        geometry_system_release(m->geometries[i]);
+    }
+    kfree(m->geometries, sizeof(geometry*) * m->geometry_count, MEMORY_TAG_ARRAY);
+    m->geometry_count = geometry_count;
+    m->geometries = kallocate(sizeof(geometry*) * m->geometry_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < m->geometry_count; ++i) {
+        m->geometries[i] = geometry_system_acquire_from_config(configs[i], true);
+    }
+}
+
+static void on_test_mesh_loaded(b8 success, resource* mesh_resource, void* user_data) {
+    test_mesh_load* load = user_data;
+    if (!success) {
+        KERROR("Failed to load test mesh '%s'!", load->name);
+        return;
+    }
+    if (app_state->mesh_count < 10) {
+        mesh* m = &app_state->meshes[app_state->mesh_count];
+        geometry_config* configs = (geometry_config*)mesh_resource->data;
+        m->geometry_count = mesh_resource->data_size;
+        m->geometries = kallocate(sizeof(geometry*) * m->geometry_count, MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < m->geometry_count; ++i) {
+            m->geometries[i] = geometry_system_acquire_from_config(configs[i], true);
+        }
+        m->transform = load->transform;
+        app_state->mesh_count++;
+        hot_reload_system_watch(RESOURCE_TYPE_MESH, load->name, on_test_mesh_reloaded, m);
+    }
+    resource_system_unload(mesh_resource);
+}
 // TODO: end temporary
 
 // create a game, this will include evey external thing, like testbed or an editor
@@ -192,6 +274,14 @@ b8 application_create(game* game_inst) {
         return false;                                                                                          // and boot out
     }
 
+    // profiler. stood up as early as possible so that every thread started after it can name itself in captures
+    profiler_initialize(&app_state->profiler_memory_requirement, 0, game_inst->app_config.profiler);
+    app_state->profiler_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->profiler_memory_requirement);
+    if (!profiler_initialize(&app_state->profiler_memory_requirement, app_state->profiler_state, game_inst->app_config.profiler)) {
+        KERROR("Failed to initialize profiler; shutting down.");
+        return false;
+    }
+
     // initialize the input system
     // first pass pass in the the pointer to the requirement field to get the size required
     input_system_initialize(&app_state->input_system_memory_requirement, 0);
@@ -200,6 +290,14 @@ b8 application_create(game* game_inst) {
     // second pass actually initializes the input system, pass it a pointer to the required memory, and a pointer to where the memory is
     input_system_initialize(&app_state->input_system_memory_requirement, app_state->input_system_state);
 
+    // input recording/replay. sits right after the input system since it hooks every input_process_ call
+    input_recording_initialize(&app_state->input_recording_memory_requirement, 0, game_inst->app_config.input_recording);
+    app_state->input_recording_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->input_recording_memory_requirement);
+    if (!input_recording_initialize(&app_state->input_recording_memory_requirement, app_state->input_recording_state, game_inst->app_config.input_recording)) {
+        KERROR("Failed to initialize input recording system; shutting down.");
+        return false;
+    }
+
     // event listeners - register for engine level events
     event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
@@ -225,11 +323,52 @@ b8 application_create(game* game_inst) {
         return false;
     }
 
+    // job system. workers are started on the second call, one less than the processor count so the main thread keeps a core to itself
+    job_system_config job_sys_config;
+    job_sys_config.worker_count = 0;
+    job_sys_config.max_job_count = 1024;
+    job_sys_config.fiber_count = 32;
+    job_sys_config.fiber_stack_size = KIBIBYTES(512);
+    job_system_initialize(&app_state->job_system_memory_requirement, 0, job_sys_config);
+    app_state->job_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->job_system_memory_requirement);
+    if (!job_system_initialize(&app_state->job_system_memory_requirement, app_state->job_system_state, job_sys_config)) {
+        KFATAL("Failed to initialize job system. Aborting application.");
+        return false;
+    }
+
+    // async io. file reads that loader jobs can park on, serviced by io_uring where the kernel allows it
+    async_io_config async_io_conf;
+    async_io_conf.max_request_count = 256;
+    async_io_conf.fallback_thread_count = 4;
+    async_io_conf.force_fallback = false;
+    async_io_initialize(&app_state->async_io_memory_requirement, 0, async_io_conf);
+    app_state->async_io_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->async_io_memory_requirement);
+    if (!async_io_initialize(&app_state->async_io_memory_requirement, app_state->async_io_state, async_io_conf)) {
+        KFATAL("Failed to initialize async io. Aborting application.");
+        return false;
+    }
+
+    // vfs. the resource system mounts its asset directory and archive into it
+    vfs_system_config vfs_sys_config;
+    vfs_sys_config.max_mount_count = 8;
+    vfs_system_initialize(&app_state->vfs_system_memory_requirement, 0, vfs_sys_config);
+    app_state->vfs_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->vfs_system_memory_requirement);
+    if (!vfs_system_initialize(&app_state->vfs_system_memory_requirement, app_state->vfs_system_state, vfs_sys_config)) {
+        KFATAL("Failed to initialize vfs. Aborting application.");
+        return false;
+    }
+
     // resource system. on the first call only the memory requirements will be returned, memory is then allocated for the resource system
     // on the second call the system is actually initialized
     resource_system_config resource_sys_config;
     resource_sys_config.asset_base_path = "../assets";
+    resource_sys_config.archive_path = "../assets.kpak";
     resource_sys_config.max_loader_count = 32;
+    resource_sys_config.max_async_load_count = 1024;
+    resource_sys_config.max_concurrent_load_count = 0;
+    // enough that swapping materials back and forth, or reloading a level, comes straight from memory
+    resource_sys_config.cache_budget = MEBIBYTES(256);
+    resource_sys_config.max_cache_entry_count = 1024;
     resource_system_initialize(&app_state->resource_system_memory_requirement, 0, resource_sys_config);
     app_state->resource_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->resource_system_memory_requirement);
     if (!resource_system_initialize(&app_state->resource_system_memory_requirement, app_state->resource_system_state, resource_sys_config)) {
@@ -310,6 +449,18 @@ b8 application_create(game* game_inst) {
         return false;
     }
 
+    // hot reloading. reloads into the texture, material, shader and geometry systems, so comes after them
+    hot_reload_system_config hot_reload_sys_config;
+    hot_reload_sys_config.debounce_ms = 200;
+    hot_reload_sys_config.max_pending_count = 64;
+    hot_reload_sys_config.max_watch_count = 64;
+    hot_reload_system_initialize(&app_state->hot_reload_system_memory_requirement, 0, hot_reload_sys_config);
+    app_state->hot_reload_system_state = linear_allocator_allocate(&app_state->systems_allocator, app_state->hot_reload_system_memory_requirement);
+    if (!hot_reload_system_initialize(&app_state->hot_reload_system_memory_requirement, app_state->hot_reload_system_state, hot_reload_sys_config)) {
+        KFATAL("Failed to initialize hot reload system. Application cannot continue.");
+        return false;
+    }
+
     render_view_system_config render_view_sys_config = {};
     render_view_sys_config.max_view_count = 251;
     render_view_system_initialize(&app_state->renderer_view_system_memory_requirement, 0, render_view_sys_config);
@@ -397,6 +548,8 @@ b8 application_create(game* game_inst) {
     cube_mesh->geometry_count = 1;
     cube_mesh->geometries = kallocate(sizeof(mesh*) * cube_mesh->geometry_count, MEMORY_TAG_ARRAY);
     geometry_config g_config = geometry_system_generate_cube_config(10.0f, 10.0f, 10.0f, 1.0f, 1.0f, "test_cube", "test_material");
+    // the material shader takes packed vertices
+    geometry_system_config_pack_vertices(&g_config);
     cube_mesh->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh->transform = transform_create();
     app_state->mesh_count++;
@@ -409,6 +562,7 @@ b8 application_create(game* game_inst) {
     cube_mesh_2->geometry_count = 1;
     cube_mesh_2->geometries = kallocate(sizeof(mesh*) * cube_mesh_2->geometry_count, MEMORY_TAG_ARRAY);
     g_config = geometry_system_generate_cube_config(5.0f, 5.0f, 5.0f, 1.0f, 1.0f, "test_cube_2", "test_material");
+    geometry_system_config_pack_vertices(&g_config);
     cube_mesh_2->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh_2->transform = transform_from_position((vec3){10.0f, 0.0f, 1.0f});
     // set the first cube as the parent to the second
@@ -422,6 +576,7 @@ b8 application_create(game* game_inst) {
     cube_mesh_3->geometry_count = 1;
     cube_mesh_3->geometries = kallocate(sizeof(mesh*) * cube_mesh_3->geometry_count, MEMORY_TAG_ARRAY);
     g_config = geometry_system_generate_cube_config(2.0f, 2.0f, 2.0f, 1.0f, 1.0f, "test_cube_2", "test_material");
+    geometry_system_config_pack_vertices(&g_config);
     cube_mesh_3->geometries[0] = geometry_system_acquire_from_config(g_config, true);
     cube_mesh_3->transform = transform_from_position((vec3){5.0f, 0.0f, 1.0f});
     // set the second cube as the parent to the third
@@ -430,38 +585,15 @@ b8 application_create(game* game_inst) {
     // clean up the allocations for the geometry config
     geometry_system_config_dispose(&g_config);
 
-    // a test mesh loaded from file
-    mesh* car_mesh = &app_state->meshes[app_state->mesh_count];
-    resource car_mesh_resource = {};
-    if (!resource_system_load("falcon", RESOURCE_TYPE_MESH, 0, &car_mesh_resource)) {
-        KERROR("Failed to load car test mesh!");
-    } else {
-        geometry_config* configs = (geometry_config*)car_mesh_resource.data;
-        car_mesh->geometry_count = car_mesh_resource.data_size;
-        car_mesh->geometries = kallocate(sizeof(geometry*) * car_mesh->geometry_count, MEMORY_TAG_ARRAY);
-        for (u32 i = 0; i < car_mesh->geometry_count; ++i) {
-            car_mesh->geometries[i] = geometry_system_acquire_from_config(configs[i], true);
-        }
-        car_mesh->transform = transform_from_position((vec3){15.0f, 0.0f, 1.0f});
-        resource_system_unload(&car_mesh_resource);
-        app_state->mesh_count++;
-    }
-
-    // a test mesh loaded from file
-    mesh* sponza_mesh = &app_state->meshes[app_state->mesh_count];
-    resource sponza_mesh_resource = {};
-    if (!resource_system_load("sponza", RESOURCE_TYPE_MESH, 0, &sponza_mesh_resource)) {
-        KERROR("Failed to load sponza mesh!");
-    } else {
-        geometry_config* sponza_configs = (geometry_config*)sponza_mesh_resource.data;
-        sponza_mesh->geometry_count = sponza_mesh_resource.data_size;
-        sponza_mesh->geometries = kallocate(sizeof(mesh*) * sponza_mesh->geometry_count, MEMORY_TAG_ARRAY);
-        for (u32 i = 0; i < sponza_mesh->geometry_count; ++i) {
-            sponza_mesh->geometries[i] = geometry_system_acquire_from_config(sponza_configs[i], true);
-        }
-        sponza_mesh->transform = transform_from_position_rotation_scale((vec3){15.0f, 0.0f, 1.0f}, quat_identity(), (vec3){0.05f, 0.05f, 0.05f});
-        resource_system_unload(&sponza_mesh_resource);
-        app_state->mesh_count++;
+    // test meshes loaded from file. they stream in over the first few frames rather than holding up startup
+    test_mesh_loads[0].name = "falcon";
+    test_mesh_loads[0].transform = transform_from_position((vec3){15.0f, 0.0f, 1.0f});
+    test_mesh_loads[1].name = "sponza";
+    test_mesh_loads[1].transform = transform_from_position_rotation_scale((vec3){15.0f, 0.0f, 1.0f}, quat_identity(), (vec3){0.05f, 0.05f, 0.05f});
+    for (u32 i = 0; i < 2; ++i) {
+        resource_load_info load_info = resource_load_info_create(test_mesh_loads[i].name, RESOURCE_TYPE_MESH, on_test_mesh_loaded, &test_mesh_loads[i]);
+        load_info.priority = JOB_PRIORITY_HIGH;
+        resource_system_load_async(load_info);
     }
 
     // load up some test ui geometry
@@ -470,6 +602,7 @@ b8 application_create(game* game_inst) {
     ui_config.vertex_count = 4;
     ui_config.index_size = sizeof(u32);
     ui_config.index_count = 6;
+    ui_config.lod_count = 0;
     string_ncopy(ui_config.material_name, "test_ui_material", MATERIAL_NAME_MAX_LENGTH);
     string_ncopy(ui_config.name, "test_ui_geometry", GEOMETRY_NAME_MAX_LENGTH);
 
@@ -535,6 +668,12 @@ b8 application_run() {
     u8 frame_count = 0;                    // declare with 0 - to keep track of the frames per second
     f64 target_frame_seconds = 1.0f / 60;  // target frame rate of 60 frames per second - so this gives us a 60th of a second 1/60s - for places where the frame rate may need to be limited
 
+    // frame timing stats, only tracked while replaying recorded input
+    u64 replay_frame_count = 0;
+    f64 replay_total_seconds = 0;
+    f64 replay_min_seconds = 0;
+    f64 replay_max_seconds = 0;
+
     // test of the memory subsystem
     KINFO(get_memory_usage_str())
     // this is basically the "game" loop at the moment will run as long as app state remains true
@@ -543,13 +682,31 @@ b8 application_run() {
             app_state->is_running = false;  // shut down application layer
         }
 
+        // pick up any asset files that changed. reloads are applied from job_system_update, as they finish
+        hot_reload_system_update();
+
+        // run the completion callbacks of any jobs that finished since last frame
+        job_system_update();
+        async_io_update();
+
         if (!app_state->is_suspended) {
+            KPROFILE_SCOPE("frame");
+
             // update clock and get delta time
             clock_update(&app_state->clock);                      // update the elapsed time
             f64 current_time = app_state->clock.elapsed;          // grab the clocks current elapsed time
             f64 delta = (current_time - app_state->last_time);    // create delta by taking the current time and subtracting from it the last time
             f64 frame_start_time = platform_get_absolute_time();  // get the time from the os and set it to frame start time - to keep track of how long each frame takes to render
 
+            // when replaying, the recording drives both the input and the frame delta. the platform still gets pumped
+            // above for window messages, but any live input it produces is dropped by the input system
+            if (input_recording_is_replaying()) {
+                if (!input_recording_replay_frame(&delta)) {
+                    app_state->is_running = false;
+                    break;
+                }
+            }
+
             if (!app_state->game_inst->update(app_state->game_inst, (f32)delta)) {  // run the update routine. the zero is in polace of delta time for now, will be fixed later
                 KFATAL("Game update failed, shutting down.");
                 app_state->is_running = false;  // shut down the application layer
@@ -642,6 +799,17 @@ b8 application_run() {
                 frame_count++;  // increment the frame count
             }
 
+            // keep track of frame times for replays, so benchmark runs have something to report
+            if (input_recording_is_replaying()) {
+                replay_frame_count++;
+                replay_total_seconds += frame_elapsed_time;
+                replay_min_seconds = (replay_frame_count == 1 || frame_elapsed_time < replay_min_seconds) ? frame_elapsed_time : replay_min_seconds;
+                replay_max_seconds = frame_elapsed_time > replay_max_seconds ? frame_elapsed_time : replay_max_seconds;
+            }
+
+            // close out the frame in the recording, if there is one
+            input_recording_end_frame(delta);
+
             // NOTE: input update/state copying should always be handled after any input should be recorder, i.e. before this line
             // as a safety, input is the last thing to be updated before this frame ends
             input_update(delta);
@@ -653,6 +821,14 @@ b8 application_run() {
 
     app_state->is_running = false;  // in the event it exits the loop while true make sure it shutsdown
 
+    if (replay_frame_count > 0) {
+        KINFO("Replay frame times over %llu frames: avg %.3fms, min %.3fms, max %.3fms.",
+              replay_frame_count,
+              (replay_total_seconds / replay_frame_count) * 1000.0,
+              replay_min_seconds * 1000.0,
+              replay_max_seconds * 1000.0);
+    }
+
     // event listeners - unregister
     event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
@@ -662,6 +838,21 @@ b8 application_run() {
     event_unregister(EVENT_CODE_DEBUG0, 0, event_on_debug_event);
     // TODO: end temp
 
+    // nothing more gets reloaded, and any reload still in flight is dropped
+    hot_reload_system_shutdown(app_state->hot_reload_system_state);
+
+    // let any reads still in flight finish first, so no job is left parked on one
+    async_io_shutdown(app_state->async_io_state);
+
+    // stop the job system workers before tearing down any of the systems their jobs might be using
+    job_system_shutdown(app_state->job_system_state);
+
+    // with the workers stopped nothing else is recording, so this gets a clean capture
+    profiler_shutdown(app_state->profiler_state);
+
+    // shutdown input recording first so anything buffered gets written out
+    input_recording_shutdown(app_state->input_recording_state);
+
     // shutdown the input system  -  pass it the pointer to where the state is being stored
     input_system_shutdown(app_state->input_system_state);
 
@@ -687,6 +878,7 @@ b8 application_run() {
 
     // shut down the resource system
     resource_system_shutdown(app_state->resource_system_state);
+    vfs_system_shutdown(app_state->vfs_system_state);
 
     // shut down the platform layer -  pass it the pointer to where the state is being stored
     platform_system_shutdown(app_state->platform_system_state);
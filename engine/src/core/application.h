@@ -1,6 +1,8 @@
 #pragma once
 
 #include "defines.h"
+#include "core/input_recording.h"
+#include "core/profiler.h"
 
 struct game;
 
@@ -21,6 +23,13 @@ typedef struct application_config {
 
     // the application name used in the window, if applicable
     char* name;
+
+    // @brief input recording/replay settings. leave zeroed to disable. replaying a recording with a fixed timestep
+    // gives the same camera path every run, which is what benchmark runs need
+    input_recording_config input_recording;
+
+    // @brief profiler settings. leave zeroed to have the profiler idle until profiler_set_enabled is called
+    profiler_config profiler;
 } application_config;
 
 // self explanitory, use in external applications to keep user code and engine code separated
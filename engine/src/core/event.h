@@ -28,11 +28,11 @@ typedef struct event_context {
 // should return true if handled
 typedef b8 (*PFN_on_event)(u16 code, void* sender, void* listener_inst, event_context data);  // pfn - pointer function. takes in number that ids message explicitly, pointer to the sender, pass the listener instance, then the data
 
-// initialize and shutdown the system - not exported, for engine only
+// initialize and shutdown the system - for the engine only, exported so the tests can run it
 // initialize the event subsystem, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
 // on the second pass - pass in the state as well as the memory rewuirement and actually initialize the subsystem
-void event_system_initialize(u64* memory_requirement, void* state);
-void event_system_shutdown(void* state);
+KAPI void event_system_initialize(u64* memory_requirement, void* state);
+KAPI void event_system_shutdown(void* state);
 
 // register to the listener for when events are sent with the provided code.  events with duplicate listener/callback combos will not be registered again and will cause this to return false
 // @param code the evet code to listen for
@@ -2,6 +2,7 @@
 #include "core/event.h"
 #include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/input_recording.h"
 
 typedef struct keyboard_state {
     b8 keys[256];  // match to defined keys
@@ -54,6 +55,11 @@ void input_update(f64 delta_time) {
 
 // keyboard internal functions
 void input_process_key(keys key, b8 pressed) {  // takes in a key and whether it is pressed or not
+    // give the recorder a look first. while replaying, live input gets dropped here
+    if (!input_recording_on_key(key, pressed)) {
+        return;
+    }
+
     // only handle this if the state has actually changed
     if (state_ptr && state_ptr->keyboard_current.keys[key] != pressed) {  // check to see if the state has actually changed
         // update internal state
@@ -87,6 +93,10 @@ void input_process_key(keys key, b8 pressed) {  // takes in a key and whether it
 
 // mouse internal functions
 void input_process_button(buttons button, b8 pressed) {
+    if (!input_recording_on_button(button, pressed)) {
+        return;
+    }
+
     // if the state has changed, fire an event
     if (state_ptr->mouse_current.buttons[button] != pressed) {  // check to see if the state has actually changed
         state_ptr->mouse_current.buttons[button] = pressed;     // if they have changed set current button to pressed
@@ -99,6 +109,10 @@ void input_process_button(buttons button, b8 pressed) {
 }
 
 void input_process_mouse_move(i16 x, i16 y) {
+    if (!input_recording_on_mouse_move(x, y)) {
+        return;
+    }
+
     // only process if actually different
     if (state_ptr->mouse_current.x != x || state_ptr->mouse_current.y != y) {  // check to see if either of the positions have changed
         // NOTE: enable this if debugging.
@@ -117,6 +131,10 @@ void input_process_mouse_move(i16 x, i16 y) {
 }
 
 void input_process_mouse_wheel(i8 z_delta) {
+    if (!input_recording_on_mouse_wheel(z_delta)) {
+        return;
+    }
+
     // NOTE: no internal state to update
 
     // fire the event
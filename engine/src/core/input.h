@@ -273,8 +273,8 @@ typedef enum keys {
 
 // initialize the input subsystem, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
 // on the second pass - pass in the state as well as the memory rewuirement and actually initialize the subsystem
-void input_system_initialize(u64* memory_requirement, void* state);
-void input_system_shutdown(void* state);
+KAPI void input_system_initialize(u64* memory_requirement, void* state);
+KAPI void input_system_shutdown(void* state);
 
 void input_update(f64 delta_time);  // this will be called once per frame. delta may or may not be needed
 
@@ -284,8 +284,8 @@ KAPI b8 input_is_key_up(keys key);
 KAPI b8 input_was_key_down(keys key);  // previous frames state
 KAPI b8 input_was_key_up(keys key);    // previous frames state
 
-// need the ability to process a key - this is an internal only function
-void input_process_key(keys key, b8 pressed);  // this is what is called from the os - this is what will be used to update the current state of a key - based on what is passed here
+// need the ability to process a key - this is an internal only function, exported so the tests can stand in for the os
+KAPI void input_process_key(keys key, b8 pressed);  // this is what is called from the os - this is what will be used to update the current state of a key - based on what is passed here
 
 // mouse input - almost the same as keyboard but with movement added in
 KAPI b8 input_is_button_down(buttons button);
@@ -295,7 +295,7 @@ KAPI b8 input_was_button_up(buttons button);
 KAPI void input_get_mouse_position(i32* x, i32* y);
 KAPI void input_get_previous_mouse_position(i32* x, i32* y);
 
-// internal process functions
-void input_process_button(buttons button, b8 pressed);
-void input_process_mouse_move(i16 x, i16 y);
-void input_process_mouse_wheel(i8 z_delta);
+// internal process functions, exported so the tests can stand in for the os
+KAPI void input_process_button(buttons button, b8 pressed);
+KAPI void input_process_mouse_move(i16 x, i16 y);
+KAPI void input_process_mouse_wheel(i8 z_delta);
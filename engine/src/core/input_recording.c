@@ -0,0 +1,304 @@
+#include "input_recording.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "platform/filesystem.h"
+
+// file layout:
+//   header - u32 magic, u16 version, u16 reserved
+//   records - a u8 record type, followed by the payload for that type. every frame ends with a FRAME_END record
+#define INPUT_RECORDING_MAGIC 0x5052494BU  // 'KIRP' in little endian
+#define INPUT_RECORDING_VERSION 0x0001U
+
+// the write buffer is flushed to disk once it gets within this many bytes of being full
+#define INPUT_RECORDING_BUFFER_SIZE KIBIBYTES(64)
+#define INPUT_RECORDING_MAX_RECORD_SIZE 8
+
+typedef enum input_record_type {
+    INPUT_RECORD_TYPE_FRAME_END = 0,    // f32 delta time
+    INPUT_RECORD_TYPE_KEY = 1,          // u8 key, u8 pressed
+    INPUT_RECORD_TYPE_BUTTON = 2,       // u8 button, u8 pressed
+    INPUT_RECORD_TYPE_MOUSE_MOVE = 3,   // i16 x, i16 y
+    INPUT_RECORD_TYPE_MOUSE_WHEEL = 4,  // i8 z delta
+} input_record_type;
+
+typedef struct input_recording_header {
+    u32 magic;
+    u16 version;
+    u16 reserved;
+} input_recording_header;
+
+typedef struct input_recording_state {
+    input_recording_config config;
+
+    // recording
+    file_handle file;
+    u64 buffer_used;
+    u8 buffer[INPUT_RECORDING_BUFFER_SIZE];
+
+    // replay
+    u8* replay_data;    // the entire recording, read in at startup
+    u64 replay_size;    // size of replay_data in bytes
+    u64 replay_offset;  // read position in replay_data
+    b8 is_dispatching;  // true while recorded input is being fed to the input system
+    u64 frame_count;    // frames recorded or replayed so far
+} input_recording_state;
+
+static input_recording_state* state_ptr;
+
+static void flush_buffer() {
+    if (state_ptr->buffer_used == 0) {
+        return;
+    }
+    u64 written = 0;
+    if (!filesystem_write(&state_ptr->file, state_ptr->buffer_used, state_ptr->buffer, &written)) {
+        KERROR("input_recording - failed to write to '%s'. Recording stopped.", state_ptr->config.file_path);
+        filesystem_close(&state_ptr->file);
+        state_ptr->config.mode = INPUT_RECORDING_MODE_NONE;
+    }
+    state_ptr->buffer_used = 0;
+}
+
+static void write_record(input_record_type type, const void* payload, u64 payload_size) {
+    if (state_ptr->buffer_used + INPUT_RECORDING_MAX_RECORD_SIZE > INPUT_RECORDING_BUFFER_SIZE) {
+        flush_buffer();
+    }
+    state_ptr->buffer[state_ptr->buffer_used++] = (u8)type;
+    kcopy_memory(state_ptr->buffer + state_ptr->buffer_used, payload, payload_size);
+    state_ptr->buffer_used += payload_size;
+}
+
+// @brief returns true if the input should be let through to the input system
+static b8 on_input(input_record_type type, const void* payload, u64 payload_size) {
+    if (!state_ptr) {
+        return true;
+    }
+    switch (state_ptr->config.mode) {
+        case INPUT_RECORDING_MODE_RECORD:
+            write_record(type, payload, payload_size);
+            return true;
+        case INPUT_RECORDING_MODE_REPLAY:
+            // drop live input, only the recording drives the input system
+            return state_ptr->is_dispatching;
+        default:
+            return true;
+    }
+}
+
+static b8 open_recording(input_recording_state* state) {
+    if (!filesystem_open(state->config.file_path, FILE_MODE_WRITE, true, &state->file)) {
+        KERROR("input_recording - unable to open '%s' for recording.", state->config.file_path);
+        return false;
+    }
+
+    input_recording_header header = {INPUT_RECORDING_MAGIC, INPUT_RECORDING_VERSION, 0};
+    u64 written = 0;
+    if (!filesystem_write(&state->file, sizeof(input_recording_header), &header, &written)) {
+        KERROR("input_recording - unable to write header to '%s'.", state->config.file_path);
+        filesystem_close(&state->file);
+        return false;
+    }
+
+    KINFO("Recording input to '%s'.", state->config.file_path);
+    return true;
+}
+
+static b8 open_replay(input_recording_state* state) {
+    file_handle f;
+    if (!filesystem_open(state->config.file_path, FILE_MODE_READ, true, &f)) {
+        KERROR("input_recording - unable to open '%s' for replay.", state->config.file_path);
+        return false;
+    }
+
+    u64 size = 0;
+    if (!filesystem_size(&f, &size) || size < sizeof(input_recording_header)) {
+        KERROR("input_recording - '%s' is too small to be an input recording.", state->config.file_path);
+        filesystem_close(&f);
+        return false;
+    }
+
+    state->replay_data = kallocate(size, MEMORY_TAG_ARRAY);
+    state->replay_size = size;
+    u64 read = 0;
+    if (!filesystem_read_all_bytes(&f, state->replay_data, &read)) {
+        KERROR("input_recording - failed to read '%s'.", state->config.file_path);
+        filesystem_close(&f);
+        return false;
+    }
+    filesystem_close(&f);
+
+    input_recording_header* header = (input_recording_header*)state->replay_data;
+    if (header->magic != INPUT_RECORDING_MAGIC || header->version != INPUT_RECORDING_VERSION) {
+        KERROR("input_recording - '%s' is not a valid input recording (or is of an unsupported version).", state->config.file_path);
+        return false;
+    }
+    state->replay_offset = sizeof(input_recording_header);
+
+    if (state->config.fixed_timestep > 0) {
+        KINFO("Replaying input from '%s' with a fixed timestep of %.4fs.", state->config.file_path, state->config.fixed_timestep);
+    } else {
+        KINFO("Replaying input from '%s' using recorded frame times.", state->config.file_path);
+    }
+    return true;
+}
+
+b8 input_recording_initialize(u64* memory_requirement, void* state, input_recording_config config) {
+    *memory_requirement = sizeof(input_recording_state);
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, sizeof(input_recording_state));
+    input_recording_state* s = state;
+    s->config = config;
+
+    if (config.mode != INPUT_RECORDING_MODE_NONE && !config.file_path) {
+        KERROR("input_recording_initialize - a file path is required to record or replay input.");
+        return false;
+    }
+
+    if (config.mode == INPUT_RECORDING_MODE_RECORD && !open_recording(s)) {
+        return false;
+    } else if (config.mode == INPUT_RECORDING_MODE_REPLAY && !open_replay(s)) {
+        if (s->replay_data) {
+            kfree(s->replay_data, s->replay_size, MEMORY_TAG_ARRAY);
+        }
+        return false;
+    }
+
+    state_ptr = s;
+    return true;
+}
+
+void input_recording_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    if (state_ptr->config.mode == INPUT_RECORDING_MODE_RECORD) {
+        flush_buffer();
+        filesystem_close(&state_ptr->file);
+        KINFO("Input recording finished: %llu frames written to '%s'.", state_ptr->frame_count, state_ptr->config.file_path);
+    }
+
+    if (state_ptr->replay_data) {
+        kfree(state_ptr->replay_data, state_ptr->replay_size, MEMORY_TAG_ARRAY);
+        state_ptr->replay_data = 0;
+    }
+
+    state_ptr = 0;
+}
+
+b8 input_recording_is_recording() {
+    return state_ptr && state_ptr->config.mode == INPUT_RECORDING_MODE_RECORD;
+}
+
+b8 input_recording_is_replaying() {
+    return state_ptr && state_ptr->config.mode == INPUT_RECORDING_MODE_REPLAY;
+}
+
+b8 input_recording_on_key(keys key, b8 pressed) {
+    u8 payload[2] = {(u8)key, (u8)pressed};
+    return on_input(INPUT_RECORD_TYPE_KEY, payload, sizeof(payload));
+}
+
+b8 input_recording_on_button(buttons button, b8 pressed) {
+    u8 payload[2] = {(u8)button, (u8)pressed};
+    return on_input(INPUT_RECORD_TYPE_BUTTON, payload, sizeof(payload));
+}
+
+b8 input_recording_on_mouse_move(i16 x, i16 y) {
+    i16 payload[2] = {x, y};
+    return on_input(INPUT_RECORD_TYPE_MOUSE_MOVE, payload, sizeof(payload));
+}
+
+b8 input_recording_on_mouse_wheel(i8 z_delta) {
+    return on_input(INPUT_RECORD_TYPE_MOUSE_WHEEL, &z_delta, sizeof(i8));
+}
+
+void input_recording_end_frame(f64 delta_time) {
+    if (!input_recording_is_recording()) {
+        return;
+    }
+    // NOTE: the game only ever sees the delta as an f32, so there is no point storing more than that
+    f32 delta = (f32)delta_time;
+    write_record(INPUT_RECORD_TYPE_FRAME_END, &delta, sizeof(f32));
+    state_ptr->frame_count++;
+}
+
+b8 input_recording_replay_frame(f64* out_delta_time) {
+    if (!input_recording_is_replaying()) {
+        return false;
+    }
+
+    const u8* data = state_ptr->replay_data;
+    u64 size = state_ptr->replay_size;
+    u64* offset = &state_ptr->replay_offset;
+
+    state_ptr->is_dispatching = true;
+    b8 frame_complete = false;
+    while (*offset < size && !frame_complete) {
+        input_record_type type = data[(*offset)++];
+        const u8* payload = data + *offset;
+        u64 payload_size = 0;
+        switch (type) {
+            case INPUT_RECORD_TYPE_FRAME_END:
+                payload_size = sizeof(f32);
+                break;
+            case INPUT_RECORD_TYPE_KEY:
+            case INPUT_RECORD_TYPE_BUTTON:
+                payload_size = 2;
+                break;
+            case INPUT_RECORD_TYPE_MOUSE_MOVE:
+                payload_size = sizeof(i16) * 2;
+                break;
+            case INPUT_RECORD_TYPE_MOUSE_WHEEL:
+                payload_size = sizeof(i8);
+                break;
+            default:
+                KERROR("input_recording_replay_frame - unknown record type %u at offset %llu. Stopping replay.", type, *offset - 1);
+                *offset = size;
+                state_ptr->is_dispatching = false;
+                return false;
+        }
+
+        if (*offset + payload_size > size) {
+            KWARN("input_recording_replay_frame - recording ends with a truncated record. Stopping replay.");
+            *offset = size;
+            break;
+        }
+
+        switch (type) {
+            case INPUT_RECORD_TYPE_FRAME_END: {
+                f32 delta;
+                kcopy_memory(&delta, payload, sizeof(f32));
+                *out_delta_time = state_ptr->config.fixed_timestep > 0 ? state_ptr->config.fixed_timestep : (f64)delta;
+                frame_complete = true;
+            } break;
+            case INPUT_RECORD_TYPE_KEY:
+                input_process_key((keys)payload[0], payload[1]);
+                break;
+            case INPUT_RECORD_TYPE_BUTTON:
+                input_process_button((buttons)payload[0], payload[1]);
+                break;
+            case INPUT_RECORD_TYPE_MOUSE_MOVE: {
+                i16 pos[2];
+                kcopy_memory(pos, payload, sizeof(pos));
+                input_process_mouse_move(pos[0], pos[1]);
+            } break;
+            case INPUT_RECORD_TYPE_MOUSE_WHEEL:
+                input_process_mouse_wheel((i8)payload[0]);
+                break;
+        }
+        *offset += payload_size;
+    }
+    state_ptr->is_dispatching = false;
+
+    if (frame_complete) {
+        state_ptr->frame_count++;
+        return true;
+    }
+
+    KINFO("Input replay finished after %llu frames.", state_ptr->frame_count);
+    return false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+#include "core/input.h"
+
+// @brief the mode the input recording system runs in
+typedef enum input_recording_mode {
+    // @brief input is neither recorded or replayed
+    INPUT_RECORDING_MODE_NONE = 0,
+    // @brief all processed input, along with the frame deltas, is written to file
+    INPUT_RECORDING_MODE_RECORD = 1,
+    // @brief input is read back from file and fed to the input system in place of the platform input
+    INPUT_RECORDING_MODE_REPLAY = 2
+} input_recording_mode;
+
+// @brief the configuration for the input recording system
+typedef struct input_recording_config {
+    // @brief the mode to run in. NONE disables the system entirely
+    input_recording_mode mode;
+    // @brief the path of the file to record to or replay from
+    const char* file_path;
+    // @brief the fixed timestep (in seconds) handed out per frame on replay. if 0, the recorded frame deltas are used instead
+    f64 fixed_timestep;
+} input_recording_config;
+
+// initialize the input recording system, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
+// on the second pass - pass in the state as well as the memory requirement and actually initialize the system
+KAPI b8 input_recording_initialize(u64* memory_requirement, void* state, input_recording_config config);
+
+// shut down the input recording system. flushes anything still waiting to be written out
+KAPI void input_recording_shutdown(void* state);
+
+// @brief indicates if input is currently being recorded
+KAPI b8 input_recording_is_recording();
+
+// @brief indicates if input is currently being replayed from file
+KAPI b8 input_recording_is_replaying();
+
+// internal hooks called by the input system at the start of each input_process_ function.
+// records the call if recording. while replaying, only input coming from the recording itself is let through
+// @return true if the input should continue to be processed, otherwise false
+b8 input_recording_on_key(keys key, b8 pressed);
+b8 input_recording_on_button(buttons button, b8 pressed);
+b8 input_recording_on_mouse_move(i16 x, i16 y);
+b8 input_recording_on_mouse_wheel(i8 z_delta);
+
+// @brief marks the end of a frame in the recording, storing the frame delta. does nothing when not recording
+// @param delta_time the delta time of the frame that just finished
+KAPI void input_recording_end_frame(f64 delta_time);
+
+// @brief replays all input recorded for the next frame through the input system. should be called once per frame
+// in place of processing platform input
+// @param out_delta_time a pointer to hold the delta time to be used for this frame
+// @return true if a frame was replayed, false once the end of the recording has been reached
+KAPI b8 input_recording_replay_frame(f64* out_delta_time);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "defines.h"
+
+// portable atomic operations. clang and gcc get the __atomic builtins, msvc gets the Interlocked family (which are all
+// full barriers, so the memory order is simply ignored there). everything is inline, there is nothing to link against
+
+// @brief the memory ordering of an atomic operation. when in doubt use SEQ_CST
+typedef enum katomic_order {
+    KATOMIC_RELAXED = 0,
+    KATOMIC_ACQUIRE = 2,
+    KATOMIC_RELEASE = 3,
+    KATOMIC_ACQ_REL = 4,
+    KATOMIC_SEQ_CST = 5
+} katomic_order;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+
+KINLINE i32 katomic_load_i32(const volatile i32* ptr, katomic_order order) {
+    i32 value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+KINLINE void katomic_store_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    _InterlockedExchange((volatile long*)ptr, value);
+}
+KINLINE i32 katomic_fetch_add_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    return _InterlockedExchangeAdd((volatile long*)ptr, value);
+}
+KINLINE i32 katomic_exchange_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    return _InterlockedExchange((volatile long*)ptr, value);
+}
+KINLINE b8 katomic_compare_exchange_i32(volatile i32* ptr, i32* expected, i32 desired, katomic_order order) {
+    i32 previous = _InterlockedCompareExchange((volatile long*)ptr, desired, *expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+KINLINE i64 katomic_load_i64(const volatile i64* ptr, katomic_order order) {
+    i64 value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+KINLINE void katomic_store_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    _InterlockedExchange64(ptr, value);
+}
+KINLINE i64 katomic_fetch_add_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    return _InterlockedExchangeAdd64(ptr, value);
+}
+KINLINE i64 katomic_exchange_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    return _InterlockedExchange64(ptr, value);
+}
+KINLINE b8 katomic_compare_exchange_i64(volatile i64* ptr, i64* expected, i64 desired, katomic_order order) {
+    i64 previous = _InterlockedCompareExchange64(ptr, desired, *expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+KINLINE void* katomic_load_ptr(void* const volatile* ptr, katomic_order order) {
+    void* value = *ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+KINLINE void katomic_store_ptr(void* volatile* ptr, void* value, katomic_order order) {
+    _InterlockedExchangePointer(ptr, value);
+}
+KINLINE b8 katomic_compare_exchange_ptr(void* volatile* ptr, void** expected, void* desired, katomic_order order) {
+    void* previous = _InterlockedCompareExchangePointer(ptr, desired, *expected);
+    if (previous == *expected) {
+        return true;
+    }
+    *expected = previous;
+    return false;
+}
+
+KINLINE void katomic_thread_fence(katomic_order order) {
+    _ReadWriteBarrier();
+    if (order == KATOMIC_SEQ_CST) {
+        __faststorefence();
+    }
+}
+
+// @brief hints to the cpu that this is a spin-wait loop
+KINLINE void katomic_pause() {
+    _mm_pause();
+}
+
+#else
+
+KINLINE i32 katomic_load_i32(const volatile i32* ptr, katomic_order order) {
+    return __atomic_load_n(ptr, order);
+}
+KINLINE void katomic_store_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    __atomic_store_n(ptr, value, order);
+}
+KINLINE i32 katomic_fetch_add_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    return __atomic_fetch_add(ptr, value, order);
+}
+KINLINE i32 katomic_exchange_i32(volatile i32* ptr, i32 value, katomic_order order) {
+    return __atomic_exchange_n(ptr, value, order);
+}
+// @brief if *ptr equals *expected, stores desired and returns true. otherwise writes the current value to expected and returns false
+KINLINE b8 katomic_compare_exchange_i32(volatile i32* ptr, i32* expected, i32 desired, katomic_order order) {
+    // failure ordering can not be release, and can not be stronger than the success ordering
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, order, order == KATOMIC_SEQ_CST ? KATOMIC_SEQ_CST : KATOMIC_RELAXED);
+}
+
+KINLINE i64 katomic_load_i64(const volatile i64* ptr, katomic_order order) {
+    return __atomic_load_n(ptr, order);
+}
+KINLINE void katomic_store_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    __atomic_store_n(ptr, value, order);
+}
+KINLINE i64 katomic_fetch_add_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    return __atomic_fetch_add(ptr, value, order);
+}
+KINLINE i64 katomic_exchange_i64(volatile i64* ptr, i64 value, katomic_order order) {
+    return __atomic_exchange_n(ptr, value, order);
+}
+KINLINE b8 katomic_compare_exchange_i64(volatile i64* ptr, i64* expected, i64 desired, katomic_order order) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, order, order == KATOMIC_SEQ_CST ? KATOMIC_SEQ_CST : KATOMIC_RELAXED);
+}
+
+KINLINE void* katomic_load_ptr(void* const volatile* ptr, katomic_order order) {
+    return __atomic_load_n(ptr, order);
+}
+KINLINE void katomic_store_ptr(void* volatile* ptr, void* value, katomic_order order) {
+    __atomic_store_n(ptr, value, order);
+}
+KINLINE b8 katomic_compare_exchange_ptr(void* volatile* ptr, void** expected, void* desired, katomic_order order) {
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, order, order == KATOMIC_SEQ_CST ? KATOMIC_SEQ_CST : KATOMIC_RELAXED);
+}
+
+KINLINE void katomic_thread_fence(katomic_order order) {
+    __atomic_thread_fence(order);
+}
+
+// @brief hints to the cpu that this is a spin-wait loop
+KINLINE void katomic_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif
@@ -0,0 +1,350 @@
+#include "kbinary.h"
+
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+
+// NOTE: begin reader
+
+void kbinary_reader_from_memory(const void* data, u64 size, kbinary_reader* out_reader) {
+    kzero_memory(out_reader, sizeof(kbinary_reader));
+    out_reader->data = data;
+    out_reader->data_size = data ? size : 0;
+    out_reader->size = out_reader->data_size;
+}
+
+b8 kbinary_reader_open_mapped(const char* path, kbinary_reader* out_reader) {
+    kzero_memory(out_reader, sizeof(kbinary_reader));
+    file_mapping mapping;
+    if (!filesystem_map(path, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+        return false;
+    }
+    kbinary_reader_from_memory(mapping.data, mapping.size, out_reader);
+    out_reader->mapping = mapping;
+    out_reader->owns_mapping = true;
+    return true;
+}
+
+b8 kbinary_reader_from_file(file_handle* file, u64 buffer_size, kbinary_reader* out_reader) {
+    kzero_memory(out_reader, sizeof(kbinary_reader));
+    u64 size = 0;
+    if (!file || !file->is_valid || !filesystem_size(file, &size)) {
+        return false;
+    }
+    out_reader->file = *file;
+    out_reader->size = size;
+    out_reader->buffer_size = buffer_size ? buffer_size : KBINARY_DEFAULT_BUFFER_SIZE;
+    out_reader->buffer = kallocate(out_reader->buffer_size, MEMORY_TAG_ARRAY);
+    out_reader->data = out_reader->buffer;
+    return true;
+}
+
+void kbinary_reader_close(kbinary_reader* reader) {
+    if (reader->buffer) {
+        kfree(reader->buffer, reader->buffer_size, MEMORY_TAG_ARRAY);
+    }
+    if (reader->owns_mapping) {
+        filesystem_unmap(&reader->mapping);
+    }
+    kzero_memory(reader, sizeof(kbinary_reader));
+}
+
+u64 kbinary_reader_remaining(const kbinary_reader* reader) {
+    return reader->failed ? 0 : reader->size - (reader->data_offset + reader->position);
+}
+
+b8 kbinary_read(kbinary_reader* reader, u64 size, void* out_data) {
+    if (reader->failed) {
+        return false;
+    }
+    // checked against the whole stream up front, so a file is never partly read for a value that isn't there
+    if (size > kbinary_reader_remaining(reader)) {
+        reader->failed = true;
+        return false;
+    }
+
+    u8* out = out_data;
+    while (size > 0) {
+        u64 buffered = reader->data_size - reader->position;
+        if (buffered == 0) {
+            // only files get here, memory has everything in data
+            u64 file_remaining = reader->size - reader->data_offset - reader->data_size;
+            reader->data_offset += reader->data_size;
+            reader->position = 0;
+            reader->data_size = 0;
+            u64 bytes_read = 0;
+            if (out && size >= reader->buffer_size) {
+                // too big to be worth buffering, so straight into the destination
+                if (!filesystem_read(&reader->file, size, out, &bytes_read)) {
+                    reader->failed = true;
+                    return false;
+                }
+                reader->data_offset += size;
+                return true;
+            }
+            u64 to_read = file_remaining < reader->buffer_size ? file_remaining : reader->buffer_size;
+            if (!filesystem_read(&reader->file, to_read, reader->buffer, &bytes_read)) {
+                KERROR("kbinary_read - the file ended early.");
+                reader->failed = true;
+                return false;
+            }
+            reader->data_size = to_read;
+            continue;
+        }
+
+        u64 count = size < buffered ? size : buffered;
+        if (out) {
+            kcopy_memory(out, reader->data + reader->position, count);
+            out += count;
+        }
+        reader->position += count;
+        size -= count;
+    }
+    return true;
+}
+
+b8 kbinary_read_array(kbinary_reader* reader, u64 count, u64 element_size, void* out_data) {
+    if (element_size && count > (u64)-1 / element_size) {
+        reader->failed = true;
+        return false;
+    }
+    return kbinary_read(reader, count * element_size, out_data);
+}
+
+// little endian values are put together a byte at a time, which compilers turn back into a plain load
+static b8 read_le(kbinary_reader* reader, u32 size, u64* out_value) {
+    u8 bytes[8];
+    if (!kbinary_read(reader, size, bytes)) {
+        return false;
+    }
+    u64 value = 0;
+    for (u32 i = 0; i < size; ++i) {
+        value |= (u64)bytes[i] << (i * 8);
+    }
+    *out_value = value;
+    return true;
+}
+
+b8 kbinary_read_u8(kbinary_reader* reader, u8* out_value) {
+    return kbinary_read(reader, sizeof(u8), out_value);
+}
+
+b8 kbinary_read_u16(kbinary_reader* reader, u16* out_value) {
+    u64 value = 0;
+    if (!read_le(reader, sizeof(u16), &value)) {
+        return false;
+    }
+    *out_value = (u16)value;
+    return true;
+}
+
+b8 kbinary_read_u32(kbinary_reader* reader, u32* out_value) {
+    u64 value = 0;
+    if (!read_le(reader, sizeof(u32), &value)) {
+        return false;
+    }
+    *out_value = (u32)value;
+    return true;
+}
+
+b8 kbinary_read_u64(kbinary_reader* reader, u64* out_value) {
+    return read_le(reader, sizeof(u64), out_value);
+}
+
+b8 kbinary_read_i32(kbinary_reader* reader, i32* out_value) {
+    return kbinary_read_u32(reader, (u32*)out_value);
+}
+
+b8 kbinary_read_f32(kbinary_reader* reader, f32* out_value) {
+    u32 bits = 0;
+    if (!kbinary_read_u32(reader, &bits)) {
+        return false;
+    }
+    kcopy_memory(out_value, &bits, sizeof(f32));
+    return true;
+}
+
+b8 kbinary_read_string(kbinary_reader* reader, u32 max_length, char* out_string) {
+    u32 length = 0;
+    if (!kbinary_read_u32(reader, &length)) {
+        return false;
+    }
+    if (length == 0 || length > max_length) {
+        reader->failed = true;
+        return false;
+    }
+    if (!kbinary_read(reader, length, out_string)) {
+        return false;
+    }
+    // the terminator is stored, but don't rely on it
+    out_string[length - 1] = 0;
+    return true;
+}
+
+// NOTE: end reader
+
+// NOTE: begin writer
+
+static void writer_create(u64 buffer_size, kbinary_writer* out_writer) {
+    kzero_memory(out_writer, sizeof(kbinary_writer));
+    out_writer->buffer_size = buffer_size ? buffer_size : KBINARY_DEFAULT_BUFFER_SIZE;
+    out_writer->buffer = kallocate(out_writer->buffer_size, MEMORY_TAG_ARRAY);
+}
+
+b8 kbinary_writer_open(const char* path, u64 buffer_size, kbinary_writer* out_writer) {
+    kzero_memory(out_writer, sizeof(kbinary_writer));
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        return false;
+    }
+    kbinary_writer_from_file(&f, buffer_size, out_writer);
+    out_writer->owns_file = true;
+    return true;
+}
+
+void kbinary_writer_from_file(file_handle* file, u64 buffer_size, kbinary_writer* out_writer) {
+    writer_create(buffer_size, out_writer);
+    out_writer->file = *file;
+}
+
+void kbinary_writer_to_memory(u64 initial_size, kbinary_writer* out_writer) {
+    writer_create(initial_size, out_writer);
+}
+
+const void* kbinary_writer_data(const kbinary_writer* writer, u64* out_size) {
+    if (writer->file.is_valid) {
+        *out_size = 0;
+        return 0;
+    }
+    *out_size = writer->buffer_used;
+    return writer->buffer;
+}
+
+static b8 writer_flush(kbinary_writer* writer) {
+    if (writer->buffer_used == 0 || writer->failed) {
+        return !writer->failed;
+    }
+    u64 written = 0;
+    if (!filesystem_write(&writer->file, writer->buffer_used, writer->buffer, &written) || written != writer->buffer_used) {
+        KERROR("kbinary_writer - failed to write to file.");
+        writer->failed = true;
+        return false;
+    }
+    writer->buffer_used = 0;
+    return true;
+}
+
+b8 kbinary_writer_close(kbinary_writer* writer) {
+    b8 result = !writer->failed;
+    if (writer->file.is_valid) {
+        result = writer_flush(writer);
+        if (writer->owns_file) {
+            filesystem_close(&writer->file);
+        }
+    }
+    if (writer->buffer) {
+        kfree(writer->buffer, writer->buffer_size, MEMORY_TAG_ARRAY);
+    }
+    kzero_memory(writer, sizeof(kbinary_writer));
+    return result;
+}
+
+b8 kbinary_write(kbinary_writer* writer, u64 size, const void* data) {
+    if (writer->failed) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+
+    if (writer->buffer_used + size > writer->buffer_size) {
+        if (!writer->file.is_valid) {
+            // memory grows to fit, doubling so appends stay cheap
+            u64 new_size = writer->buffer_size * 2;
+            while (new_size < writer->buffer_used + size) {
+                new_size *= 2;
+            }
+            u8* new_buffer = kallocate(new_size, MEMORY_TAG_ARRAY);
+            kcopy_memory(new_buffer, writer->buffer, writer->buffer_used);
+            kfree(writer->buffer, writer->buffer_size, MEMORY_TAG_ARRAY);
+            writer->buffer = new_buffer;
+            writer->buffer_size = new_size;
+        } else {
+            if (!writer_flush(writer)) {
+                return false;
+            }
+            if (size >= writer->buffer_size) {
+                // too big to be worth buffering, so straight to the file
+                u64 written = 0;
+                if (!filesystem_write(&writer->file, size, data, &written) || written != size) {
+                    KERROR("kbinary_writer - failed to write to file.");
+                    writer->failed = true;
+                    return false;
+                }
+                writer->position += size;
+                return true;
+            }
+        }
+    }
+
+    kcopy_memory(writer->buffer + writer->buffer_used, data, size);
+    writer->buffer_used += size;
+    writer->position += size;
+    return true;
+}
+
+b8 kbinary_write_pad_to(kbinary_writer* writer, u64 offset) {
+    static const u8 zeros[64] = {0};
+    while (writer->position < offset) {
+        u64 count = offset - writer->position > sizeof(zeros) ? sizeof(zeros) : offset - writer->position;
+        if (!kbinary_write(writer, count, zeros)) {
+            return false;
+        }
+    }
+    return !writer->failed;
+}
+
+b8 kbinary_write_align(kbinary_writer* writer, u64 alignment) {
+    return kbinary_write_pad_to(writer, (writer->position + alignment - 1) & ~(alignment - 1));
+}
+
+static b8 write_le(kbinary_writer* writer, u32 size, u64 value) {
+    u8 bytes[8];
+    for (u32 i = 0; i < size; ++i) {
+        bytes[i] = (u8)(value >> (i * 8));
+    }
+    return kbinary_write(writer, size, bytes);
+}
+
+b8 kbinary_write_u8(kbinary_writer* writer, u8 value) {
+    return kbinary_write(writer, sizeof(u8), &value);
+}
+
+b8 kbinary_write_u16(kbinary_writer* writer, u16 value) {
+    return write_le(writer, sizeof(u16), value);
+}
+
+b8 kbinary_write_u32(kbinary_writer* writer, u32 value) {
+    return write_le(writer, sizeof(u32), value);
+}
+
+b8 kbinary_write_u64(kbinary_writer* writer, u64 value) {
+    return write_le(writer, sizeof(u64), value);
+}
+
+b8 kbinary_write_i32(kbinary_writer* writer, i32 value) {
+    return write_le(writer, sizeof(u32), (u32)value);
+}
+
+b8 kbinary_write_f32(kbinary_writer* writer, f32 value) {
+    u32 bits = 0;
+    kcopy_memory(&bits, &value, sizeof(f32));
+    return write_le(writer, sizeof(u32), bits);
+}
+
+b8 kbinary_write_string(kbinary_writer* writer, const char* str) {
+    u32 length = (u32)string_length(str) + 1;
+    return kbinary_write_u32(writer, length) && kbinary_write(writer, length, str);
+}
+
+// NOTE: end writer
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+// buffered binary streams, for reading and writing the engine's binary formats. small reads and writes are gathered
+// into one large buffer, so they cost a copy rather than a trip to the os each. the typed helpers are always little
+// endian on disk, whatever the platform. raw blocks (kbinary_read, kbinary_write and the array helpers) are copied as
+// they are, which is the same thing on every platform the engine runs on.
+//
+// errors are sticky: once a read runs off the end or a write fails, every call after it fails too, and nothing more is
+// read or written. so a run of reads can be checked once at the end, with no partial values ever trusted
+
+// the buffer size used when 0 is passed
+#define KBINARY_DEFAULT_BUFFER_SIZE KIBIBYTES(64)
+
+// @brief reads from a block of memory, a mapped file, or an open file
+typedef struct kbinary_reader {
+    // @brief the bytes that can be read without going back to the file. for memory and mapped files, all of them
+    const u8* data;
+    // @brief the number of bytes in data
+    u64 data_size;
+    // @brief the read position within data
+    u64 position;
+    // @brief where data starts in the stream as a whole
+    u64 data_offset;
+    // @brief the size of the stream as a whole
+    u64 size;
+    // @brief true once anything has failed
+    b8 failed;
+
+    // @brief the file being read, if reading a file
+    file_handle file;
+    // @brief the buffer for reading the file into. 0 if not reading a file
+    u8* buffer;
+    u64 buffer_size;
+    // @brief set if the reader mapped the file itself, so it is unmapped on close
+    file_mapping mapping;
+    b8 owns_mapping;
+} kbinary_reader;
+
+// @brief writes to a file, or to a block of memory that grows as needed
+typedef struct kbinary_writer {
+    // @brief the file being written. not valid when writing to memory
+    file_handle file;
+    // @brief set if the writer opened the file itself, so it is closed on close
+    b8 owns_file;
+    // @brief buffered data not yet written to the file. when writing to memory, everything written so far
+    u8* buffer;
+    u64 buffer_size;
+    u64 buffer_used;
+    // @brief the total number of bytes written, including any still in the buffer
+    u64 position;
+    // @brief true once anything has failed
+    b8 failed;
+} kbinary_writer;
+
+// NOTE: begin reader
+
+// @brief reads from a block of memory, such as a vfs_file. nothing is copied, so the memory must outlive the reader
+// @param data the memory to read
+// @param size the number of bytes that can be read
+// @param out_reader a pointer to hold the reader
+KAPI void kbinary_reader_from_memory(const void* data, u64 size, kbinary_reader* out_reader);
+
+// @brief maps a file, and reads from that. nothing is read until it is touched
+// @param path the path of the file
+// @param out_reader a pointer to hold the reader
+// @return true on success, otherwise false
+KAPI b8 kbinary_reader_open_mapped(const char* path, kbinary_reader* out_reader);
+
+// @brief reads the whole of a file already opened for reading (in binary), from the start. the file is left open on
+// close
+// @param file the file. must stay open until the reader is closed
+// @param buffer_size how much is read from the file at a time. 0 for KBINARY_DEFAULT_BUFFER_SIZE
+// @param out_reader a pointer to hold the reader
+// @return true on success, otherwise false
+KAPI b8 kbinary_reader_from_file(file_handle* file, u64 buffer_size, kbinary_reader* out_reader);
+
+// @brief frees everything held by a reader, unmapping the file if it mapped it
+KAPI void kbinary_reader_close(kbinary_reader* reader);
+
+// @brief the number of bytes left to read
+KAPI u64 kbinary_reader_remaining(const kbinary_reader* reader);
+
+// @brief copies the next size bytes out
+// @param reader the reader
+// @param size the number of bytes
+// @param out_data where to copy them. can be 0 to just skip them
+// @return true on success. false if there are not that many left, or anything has failed before
+KAPI b8 kbinary_read(kbinary_reader* reader, u64 size, void* out_data);
+
+// @brief reads count elements of element_size each, checking the total size cannot overflow first
+KAPI b8 kbinary_read_array(kbinary_reader* reader, u64 count, u64 element_size, void* out_data);
+
+KAPI b8 kbinary_read_u8(kbinary_reader* reader, u8* out_value);
+KAPI b8 kbinary_read_u16(kbinary_reader* reader, u16* out_value);
+KAPI b8 kbinary_read_u32(kbinary_reader* reader, u32* out_value);
+KAPI b8 kbinary_read_u64(kbinary_reader* reader, u64* out_value);
+KAPI b8 kbinary_read_i32(kbinary_reader* reader, i32* out_value);
+KAPI b8 kbinary_read_f32(kbinary_reader* reader, f32* out_value);
+
+// @brief reads a string written by kbinary_write_string. that is a u32 length, counting the terminator, then the
+// characters and terminator
+// @param reader the reader
+// @param max_length the size of out_string, including the terminator
+// @param out_string a buffer to hold the string. always terminated on success
+// @return true on success. false if the string is empty, longer than max_length, or runs off the end
+KAPI b8 kbinary_read_string(kbinary_reader* reader, u32 max_length, char* out_string);
+
+// NOTE: end reader
+
+// NOTE: begin writer
+
+// @brief creates (or truncates) a file and writes to it
+// @param path the path of the file
+// @param buffer_size how much is gathered before it is written to the file. 0 for KBINARY_DEFAULT_BUFFER_SIZE
+// @param out_writer a pointer to hold the writer
+// @return true on success, otherwise false
+KAPI b8 kbinary_writer_open(const char* path, u64 buffer_size, kbinary_writer* out_writer);
+
+// @brief writes to a file already opened for writing (in binary), from wherever it is now. the file is left open on
+// close
+// @param file the file. must stay open until the writer is closed
+// @param buffer_size how much is gathered before it is written to the file. 0 for KBINARY_DEFAULT_BUFFER_SIZE
+// @param out_writer a pointer to hold the writer
+KAPI void kbinary_writer_from_file(file_handle* file, u64 buffer_size, kbinary_writer* out_writer);
+
+// @brief writes to memory, which grows as it is needed. see kbinary_writer_data
+// @param initial_size how much memory to start with. 0 for KBINARY_DEFAULT_BUFFER_SIZE
+// @param out_writer a pointer to hold the writer
+KAPI void kbinary_writer_to_memory(u64 initial_size, kbinary_writer* out_writer);
+
+// @brief everything written to a memory writer so far. only valid until the next write or close
+// @param writer the writer
+// @param out_size a pointer to hold the number of bytes
+// @return the data, or 0 if this is not a memory writer
+KAPI const void* kbinary_writer_data(const kbinary_writer* writer, u64* out_size);
+
+// @brief writes out anything still buffered, then frees everything held by the writer, closing the file if it opened
+// it
+// @return true if everything was written, otherwise false
+KAPI b8 kbinary_writer_close(kbinary_writer* writer);
+
+// @brief writes size bytes
+// @return true on success. false if it could not be written, or anything has failed before
+KAPI b8 kbinary_write(kbinary_writer* writer, u64 size, const void* data);
+
+// @brief writes zeroes until the position is a multiple of alignment, which must be a power of 2
+KAPI b8 kbinary_write_align(kbinary_writer* writer, u64 alignment);
+
+// @brief writes zeroes until the position reaches offset. does nothing if it already has
+KAPI b8 kbinary_write_pad_to(kbinary_writer* writer, u64 offset);
+
+KAPI b8 kbinary_write_u8(kbinary_writer* writer, u8 value);
+KAPI b8 kbinary_write_u16(kbinary_writer* writer, u16 value);
+KAPI b8 kbinary_write_u32(kbinary_writer* writer, u32 value);
+KAPI b8 kbinary_write_u64(kbinary_writer* writer, u64 value);
+KAPI b8 kbinary_write_i32(kbinary_writer* writer, i32 value);
+KAPI b8 kbinary_write_f32(kbinary_writer* writer, f32 value);
+
+// @brief writes a u32 length, counting the terminator, then the string and its terminator
+KAPI b8 kbinary_write_string(kbinary_writer* writer, const char* str);
+
+// NOTE: end writer
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "defines.h"
+#include "core/kmutex.h"
+
+// @brief pass as the timeout to wait on a condition variable until it is signaled, no matter how long that takes
+#define KCONDVAR_WAIT_INFINITE 0xFFFFFFFFFFFFFFFFULL
+
+// @brief a condition variable. lets threads sleep until some condition (guarded by a mutex) may have changed. waits can
+// wake up spuriously, so always check the condition again in a loop after waking
+typedef struct kcondvar {
+    // @brief platform specific data for the condition variable
+    void* internal_data;
+} kcondvar;
+
+// @brief creates a condition variable
+// @param out_condvar a pointer to hold the created condition variable
+// @return true if created successfully, otherwise false
+KAPI b8 kcondvar_create(kcondvar* out_condvar);
+
+// @brief destroys the given condition variable. nothing should be waiting on it
+// @param condvar a pointer to the condition variable to destroy
+KAPI void kcondvar_destroy(kcondvar* condvar);
+
+// @brief atomically unlocks the mutex and sleeps until signaled or the timeout passes. the mutex is locked again before returning
+// @param condvar a pointer to the condition variable to wait on
+// @param mutex a pointer to the mutex guarding the condition. must be locked by the calling thread
+// @param timeout_ms the maximum time to wait in milliseconds, or KCONDVAR_WAIT_INFINITE
+// @return true if woken up, false on timeout or error
+KAPI b8 kcondvar_wait(kcondvar* condvar, kmutex* mutex, u64 timeout_ms);
+
+// @brief wakes up one thread waiting on the condition variable, if there is one
+KAPI b8 kcondvar_signal(kcondvar* condvar);
+
+// @brief wakes up every thread waiting on the condition variable
+KAPI b8 kcondvar_broadcast(kcondvar* condvar);
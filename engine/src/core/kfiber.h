@@ -0,0 +1,40 @@
+#pragma once
+
+#include "defines.h"
+
+// @brief a fiber is a stack and a saved set of registers that can be switched to and from on a single thread. unlike
+// threads, fibers never preempt one another, the running fiber keeps going until it explicitly switches away
+typedef struct kfiber {
+    // @brief platform specific data for the fiber
+    void* internal_data;
+} kfiber;
+
+// @brief the function a fiber starts running. this must never return, switch to another fiber instead
+typedef void (*pfn_fiber_start)(void*);
+
+// @brief turns the calling thread into a fiber, so it has something to save its state into when switching to another
+// fiber (and something for other fibers to switch back to). required once per thread before any switching
+// @param out_fiber a pointer to hold the fiber for the thread
+// @return true on success, otherwise false
+KAPI b8 kfiber_create_from_thread(kfiber* out_fiber);
+
+// @brief undoes kfiber_create_from_thread. must be called on the same thread, while running on the thread's own fiber
+// @param fiber a pointer to the fiber of the thread
+KAPI void kfiber_destroy_from_thread(kfiber* fiber);
+
+// @brief creates a new fiber with its own stack. it will not start running until it is first switched to
+// @param stack_size the size of the stack in bytes
+// @param start_function_ptr the function to run when first switched to. must never return
+// @param params passed to start_function_ptr. optional
+// @param out_fiber a pointer to hold the created fiber
+// @return true on success, otherwise false
+KAPI b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void* params, kfiber* out_fiber);
+
+// @brief destroys a fiber, freeing its stack. must not be the fiber currently running
+// @param fiber a pointer to the fiber to destroy
+KAPI void kfiber_destroy(kfiber* fiber);
+
+// @brief saves the current state into from, then starts running to. returns once something switches back to from
+// @param from the fiber currently running on this thread
+// @param to the fiber to switch to. must not be running on any thread
+KAPI void kfiber_switch(kfiber* from, kfiber* to);
@@ -2,6 +2,7 @@
 
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "core/kmutex.h"
 #include "platform/platform.h"
 #include "memory/dynamic_allocator.h"
 
@@ -44,6 +45,7 @@ typedef struct memory_system_state {
     u64 allocator_memory_requirement;    // how much memory is needed for allocations
     dynamic_allocator allocator;         // store a dynamic allocator
     void* allocator_block;               // pointer to actual block of memory in the allocator
+    kmutex allocation_mutex;             // allocations can come from the job system worker threads, so the allocator and stats are guarded by this
 } memory_system_state;
 
 // define a pointer to where the memory state is going to be stored -- to privately track it in the memory system
@@ -85,6 +87,11 @@ b8 memory_system_initialize(memory_system_configuration config) {
         return false;
     }
 
+    if (!kmutex_create(&state_ptr->allocation_mutex)) {
+        KFATAL("Unable to create allocation mutex!");
+        return false;
+    }
+
     KDEBUG("Memory system successfully allocated %llu bytes.", config.total_alloc_size);
     return true;
 }
@@ -92,6 +99,7 @@ b8 memory_system_initialize(memory_system_configuration config) {
 // shutdown the memory subsystem, just pass it the pointer to the state
 void memory_system_shutdown() {
     if (state_ptr) {
+        kmutex_destroy(&state_ptr->allocation_mutex);
         dynamic_allocator_destroy(&state_ptr->allocator);
         // free the entire block
         platform_free(state_ptr, state_ptr->allocator_memory_requirement + sizeof(memory_system_state));
@@ -106,11 +114,13 @@ void* kallocate(u64 size, memory_tag tag) {
     // either allocate from the system's allocator or the os. the latter shouldnt ever really happen
     void* block = 0;
     if (state_ptr) {
+        kmutex_lock(&state_ptr->allocation_mutex);
         state_ptr->stats.tolal_allocated += size;          // add the size that is passed in to total allocated. size in bytes
         state_ptr->stats.tagged_allocations[tag] += size;  // add size to tagged allocated, using tag to match the proper index - how we track memory per category
         state_ptr->alloc_count++;                          // everytime memory is allocated increment the count of dynamic allocations
 
         block = dynamic_allocator_allocate(&state_ptr->allocator, size);
+        kmutex_unlock(&state_ptr->allocation_mutex);
     } else {
         // if the system is not up yet, warn about it, but give memory for now
         KWARN("kallocate was called before the memory system was initialized.");
@@ -133,9 +143,11 @@ void kfree(void* block, u64 size, memory_tag tag) {
     }
 
     if (state_ptr) {
+        kmutex_lock(&state_ptr->allocation_mutex);
         state_ptr->stats.tolal_allocated -= size;          // remove the size passed in from total allocated stats
         state_ptr->stats.tagged_allocations[tag] -= size;  // remove the size passed in from tagged allocations at index of tag
         b8 result = dynamic_allocator_free(&state_ptr->allocator, block, size);
+        kmutex_unlock(&state_ptr->allocation_mutex);
 
         // if the free failed, its possible this is because the allocation was made before the system had been initialized.
         // since this should absolutely be an exeption to the rule, try freeing it on the platform level. if this fails,
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "defines.h"
+
+// @brief a mutex to be used for synchronization purposes. a mutex (or mutual exclusion) is used to limit access to a
+// resource when there are multiple threads of execution around that resource
+typedef struct kmutex {
+    // @brief platform specific data for the mutex
+    void* internal_data;
+} kmutex;
+
+// @brief creates a mutex
+// @param out_mutex a pointer to hold the created mutex
+// @return true if created successfully, otherwise false
+KAPI b8 kmutex_create(kmutex* out_mutex);
+
+// @brief destroys the provided mutex
+// @param mutex a pointer to the mutex to be destroyed
+KAPI void kmutex_destroy(kmutex* mutex);
+
+// @brief creates a mutex lock. blocks until the lock is obtained
+// @param mutex a pointer to the mutex
+// @return true if locked successfully, otherwise false
+KAPI b8 kmutex_lock(kmutex* mutex);
+
+// @brief attempts to lock the mutex without blocking
+// @param mutex a pointer to the mutex
+// @return true if the lock was obtained, false if the mutex is already locked
+KAPI b8 kmutex_try_lock(kmutex* mutex);
+
+// @brief unlocks the given mutex
+// @param mutex the mutex to unlock
+// @return true if unlocked successfully, otherwise false
+KAPI b8 kmutex_unlock(kmutex* mutex);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "defines.h"
+
+// @brief pass as the timeout to wait on a semaphore until it is signaled, no matter how long that takes
+#define KSEMAPHORE_WAIT_INFINITE 0xFFFFFFFFFFFFFFFFULL
+
+// @brief a counting semaphore. each signal increments the count and releases one waiting thread, each wait
+// decrements it, blocking while it is at zero
+typedef struct ksemaphore {
+    // @brief platform specific data for the semaphore
+    void* internal_data;
+} ksemaphore;
+
+// @brief creates a semaphore
+// @param start_count the count the semaphore starts at
+// @param out_semaphore a pointer to hold the created semaphore
+// @return true if created successfully, otherwise false
+KAPI b8 ksemaphore_create(u32 start_count, ksemaphore* out_semaphore);
+
+// @brief destroys the provided semaphore
+// @param semaphore a pointer to the semaphore to be destroyed
+KAPI void ksemaphore_destroy(ksemaphore* semaphore);
+
+// @brief signals the semaphore, releasing one waiting thread (if there is one)
+// @param semaphore a pointer to the semaphore to signal
+// @return true if signaled successfully, otherwise false
+KAPI b8 ksemaphore_signal(ksemaphore* semaphore);
+
+// @brief waits on the semaphore until it is signaled or the timeout has passed
+// @param semaphore a pointer to the semaphore to wait on
+// @param timeout_ms the maximum time to wait in milliseconds, or KSEMAPHORE_WAIT_INFINITE
+// @return true if the semaphore was signaled, false on timeout or error
+KAPI b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms);
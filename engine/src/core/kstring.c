@@ -43,7 +43,7 @@ b8 strings_equali(const char* str0, const char* str1) {
 // @param length the maximum number of characters to be compared
 // @return true if the same, otherwise false
 KAPI b8 strings_nequal(const char* str0, const char* str1, u64 length) {
-    return strncmp(str0, str1, length);
+    return strncmp(str0, str1, length) == 0;
 }
 
 // @brief case insensitive string comparison for a number of characters
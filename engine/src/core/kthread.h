@@ -0,0 +1,76 @@
+#pragma once
+
+#include "defines.h"
+
+// @brief represents a process thread in the system to be used for work. generally should not be created directly in
+// user code. this calls to the platform specific thread implementation
+typedef struct kthread {
+    // @brief platform specific data for the thread
+    void* internal_data;
+    // @brief the platform thread id
+    u64 thread_id;
+} kthread;
+
+// @brief a pointer to a function to be invoked when the thread starts. the return value is the exit code of the thread
+typedef u32 (*pfn_thread_start)(void*);
+
+// @brief creates a new thread, immediately calling the function pointed to
+// @param start_function_ptr the pointer to the function to be invoked immediately. required
+// @param params a pointer to any data to be passed to the start_function_ptr. optional, pass 0/null if not required
+// @param out_thread a pointer to hold the created thread
+// @return true if successfully created, otherwise false
+KAPI b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread);
+
+// @brief detaches the thread, so its resources are cleaned up automatically once it finishes. a detached thread can no
+// longer be waited on
+// @param thread a pointer to the thread to detach
+// @return true if detached successfully, otherwise false
+KAPI b8 kthread_detach(kthread* thread);
+
+// @brief blocks until the provided thread has finished, then cleans up the thread's resources
+// @param thread a pointer to the thread to wait on
+// @return true if the thread was waited on successfully, otherwise false
+KAPI b8 kthread_wait(kthread* thread);
+
+// @brief gives up the rest of the calling thread's time slice to any other thread ready to run
+KAPI void kthread_yield();
+
+// @brief obtains the identifier of the calling thread
+KAPI u64 kthread_get_current_id();
+
+// @brief restricts the thread to only run on the given logical processor
+// @param thread a pointer to the thread
+// @param processor_index the index of the logical processor, from 0 up to platform_get_processor_count() - 1
+// @return true if the affinity was set, otherwise false
+KAPI b8 kthread_set_affinity(kthread* thread, u32 processor_index);
+
+// @brief sets the name of the thread, as shown in debuggers and profilers. long names may be truncated (linux keeps 15 characters)
+// @param thread a pointer to the thread
+// @param name the name to give the thread
+// @return true if the name was set, otherwise false
+KAPI b8 kthread_set_name(kthread* thread, const char* name);
+
+// NOTE: for thread local variables known at compile time use KTHREAD_LOCAL from defines.h. the below are for when the
+// number of them is not known until runtime
+
+// @brief a thread local storage slot. every thread sees its own value, which starts out as 0
+typedef struct ktls_slot {
+    // @brief the platform specific key of the slot
+    u64 key;
+} ktls_slot;
+
+// @brief creates a new thread local storage slot
+// @param out_slot a pointer to hold the created slot
+// @return true if created successfully, otherwise false
+KAPI b8 ktls_slot_create(ktls_slot* out_slot);
+
+// @brief destroys the given slot. values still held by threads are not cleaned up
+// @param slot a pointer to the slot to destroy
+KAPI void ktls_slot_destroy(ktls_slot* slot);
+
+// @brief sets the calling thread's value of the slot
+// @return true if set successfully, otherwise false
+KAPI b8 ktls_slot_set(ktls_slot* slot, void* value);
+
+// @brief gets the calling thread's value of the slot, or 0 if it was never set on this thread
+KAPI void* ktls_slot_get(ktls_slot* slot);
@@ -0,0 +1,187 @@
+#include "lz4.h"
+
+#include "core/kmemory.h"
+
+#define LZ4_MIN_MATCH 4
+// the last 5 bytes of a block are always literals, and no match can start within 12 bytes of the end
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 16
+// after this many misses in a row, start skipping ahead faster. keeps incompressible data from being slow to cook
+#define LZ4_SKIP_TRIGGER 6
+
+static u32 read_u32(const u8* p) {
+    u32 value;
+    kcopy_memory(&value, p, sizeof(u32));
+    return value;
+}
+
+static u32 hash_sequence(u32 sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+// lengths of 15 or more spill over into extra bytes, 255 at a time
+static u8* write_length(u8* op, u64 length) {
+    length -= 15;
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (u8)length;
+    return op;
+}
+
+static u8* write_literals(u8* op, const u8* literals, u64 length, u8* token) {
+    *token = (u8)((length >= 15 ? 15 : length) << 4);
+    if (length >= 15) {
+        op = write_length(op, length);
+    }
+    kcopy_memory(op, literals, length);
+    return op + length;
+}
+
+u64 lz4_compress_bound(u64 size) {
+    return size + size / 255 + 16;
+}
+
+u64 lz4_compress(const void* source, u64 source_size, void* dest, u64 dest_capacity) {
+    if (dest_capacity < lz4_compress_bound(source_size)) {
+        return 0;
+    }
+
+    const u8* src = source;
+    const u8* end = src + source_size;
+    const u8* ip = src;
+    const u8* anchor = src;
+    u8* op = dest;
+
+    if (source_size > LZ4_MATCH_FIND_LIMIT) {
+        const u8* match_limit = end - LZ4_LAST_LITERALS;
+        const u8* find_limit = end - LZ4_MATCH_FIND_LIMIT;
+        // the most recent position each hash was seen at. starts zeroed, which is a valid (if rarely matching) position
+        u64 table_size = sizeof(u32) << LZ4_HASH_BITS;
+        u32* table = kallocate(table_size, MEMORY_TAG_ARRAY);
+
+        u32 misses = 0;
+        while (ip <= find_limit) {
+            u32 sequence = read_u32(ip);
+            u32 hash = hash_sequence(sequence);
+            const u8* ref = src + table[hash];
+            table[hash] = (u32)(ip - src);
+
+            if (ref >= ip || (u64)(ip - ref) > LZ4_MAX_OFFSET || read_u32(ref) != sequence) {
+                ip += 1 + (misses++ >> LZ4_SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            // grow the match backwards into the pending literals, then forwards as far as it goes
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const u8* match_end = ip + LZ4_MIN_MATCH;
+            const u8* ref_end = ref + LZ4_MIN_MATCH;
+            while (match_end < match_limit && *match_end == *ref_end) {
+                match_end++;
+                ref_end++;
+            }
+
+            u8* token = op++;
+            op = write_literals(op, anchor, (u64)(ip - anchor), token);
+
+            u16 offset = (u16)(ip - ref);
+            *op++ = (u8)(offset & 0xFF);
+            *op++ = (u8)(offset >> 8);
+
+            u64 match_length = (u64)(match_end - ip) - LZ4_MIN_MATCH;
+            *token |= (u8)(match_length >= 15 ? 15 : match_length);
+            if (match_length >= 15) {
+                op = write_length(op, match_length);
+            }
+
+            ip = match_end;
+            anchor = ip;
+        }
+
+        kfree(table, table_size, MEMORY_TAG_ARRAY);
+    }
+
+    // whatever is left goes out as a final run of literals, with no match
+    u8* token = op++;
+    op = write_literals(op, anchor, (u64)(end - anchor), token);
+    return (u64)(op - (u8*)dest);
+}
+
+// reads the extra bytes of a length that was 15 in the token. false if the input runs out first
+static b8 read_length(const u8** ip, const u8* end, u64* length) {
+    u8 value;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        value = *(*ip)++;
+        *length += value;
+    } while (value == 255);
+    return true;
+}
+
+b8 lz4_decompress(const void* source, u64 source_size, void* dest, u64 dest_size) {
+    const u8* ip = source;
+    const u8* end = ip + source_size;
+    u8* op = dest;
+    u8* out_start = dest;
+    u8* out_end = op + dest_size;
+
+    while (ip < end) {
+        u8 token = *ip++;
+
+        u64 literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(&ip, end, &literal_length)) {
+            return false;
+        }
+        if (literal_length > (u64)(end - ip) || literal_length > (u64)(out_end - op)) {
+            return false;
+        }
+        kcopy_memory(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // the last sequence has literals only
+        if (ip == end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        u64 offset = (u64)ip[0] | ((u64)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (u64)(op - out_start)) {
+            return false;
+        }
+
+        u64 match_length = token & 15;
+        if (match_length == 15 && !read_length(&ip, end, &match_length)) {
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > (u64)(out_end - op)) {
+            return false;
+        }
+
+        const u8* match = op - offset;
+        if (offset >= match_length) {
+            kcopy_memory(op, match, match_length);
+            op += match_length;
+        } else {
+            // overlapping, which is how runs are encoded. has to go a byte at a time so it reads what it just wrote
+            for (u64 i = 0; i < match_length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == out_end;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "defines.h"
+
+// a small implementation of the lz4 block format (not the frame format, so there is no header or checksum, the caller
+// keeps track of sizes). the output can be read by any other lz4 block decoder, and vice versa. it favours decode speed
+// over ratio, which is the right trade for assets read every run and written once at cook time
+
+// @brief the largest size compressing size bytes can produce. dest must be at least this big
+KAPI u64 lz4_compress_bound(u64 size);
+
+// @brief compresses a block of data
+// @param source the data to compress
+// @param source_size the size of the data in bytes
+// @param dest where to write the compressed data
+// @param dest_capacity the size of dest. must be at least lz4_compress_bound(source_size)
+// @return the compressed size in bytes, or 0 if dest is too small
+KAPI u64 lz4_compress(const void* source, u64 source_size, void* dest, u64 dest_capacity);
+
+// @brief decompresses a block of data. the input is fully bounds checked, so corrupt data fails rather than reading or
+// writing out of bounds
+// @param source the compressed data
+// @param source_size the size of the compressed data in bytes
+// @param dest where to write the decompressed data
+// @param dest_size the exact size of the decompressed data
+// @return true if the data decompressed to exactly dest_size bytes, otherwise false
+KAPI b8 lz4_decompress(const void* source, u64 source_size, void* dest, u64 dest_size);
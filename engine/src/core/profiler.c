@@ -0,0 +1,263 @@
+#include "profiler.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/katomic.h"
+#include "platform/platform.h"
+#include "platform/filesystem.h"
+
+// the most threads that can record at once. threads past this are simply not recorded
+#define PROFILER_MAX_THREADS 32
+#define PROFILER_THREAD_NAME_LENGTH 32
+#define PROFILER_DEFAULT_EVENTS_PER_THREAD 8192
+
+// the capture is built up in this and written out whenever it gets within a line of being full
+#define PROFILER_WRITE_BUFFER_SIZE KIBIBYTES(64)
+#define PROFILER_MAX_LINE_LENGTH 512
+
+// a single completed scope. only begin and end are kept, nesting falls out of the timestamps
+typedef struct profile_event {
+    const char* name;
+    u64 start_ns;
+    u64 end_ns;
+} profile_event;
+
+// each thread only ever writes to its own buffer, so recording needs no locking
+typedef struct profiler_thread {
+    // set (with release) once the rest of this is filled in, so the exporter can tell the slot is usable
+    volatile i32 is_ready;
+    char name[PROFILER_THREAD_NAME_LENGTH];
+    // the total number of events ever written. the newest event is at (write_index - 1) & event_mask
+    volatile i64 write_index;
+    profile_event* events;
+} profiler_thread;
+
+typedef struct profiler_state {
+    profiler_config config;
+    volatile i32 enabled;
+    u32 events_per_thread;
+    u32 event_mask;
+    // everything in the capture is relative to this
+    u64 start_ns;
+    volatile i32 thread_count;
+    profiler_thread threads[PROFILER_MAX_THREADS];
+    // followed by PROFILER_MAX_THREADS * events_per_thread events
+} profiler_state;
+
+static profiler_state* state_ptr;
+
+// the calling thread's slot, claimed on the thread's first recorded event
+static KTHREAD_LOCAL profiler_thread* local_thread;
+
+static u32 round_up_pow2(u32 value) {
+    u32 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// NOTE: not inlined so the thread local is read fresh every call. a scope in a fiber job can end on a different thread
+// than it began on, and the compiler would otherwise be free to reuse an address it looked up before the switch
+static KNOINLINE profiler_thread* get_thread() {
+    if (local_thread) {
+        return local_thread;
+    }
+
+    i32 index = katomic_fetch_add_i32(&state_ptr->thread_count, 1, KATOMIC_SEQ_CST);
+    if (index >= PROFILER_MAX_THREADS) {
+        return 0;
+    }
+
+    profiler_thread* thread = &state_ptr->threads[index];
+    string_format(thread->name, "thread %i", index);
+    thread->write_index = 0;
+    thread->events = (profile_event*)((u8*)state_ptr + sizeof(profiler_state)) + (u64)index * state_ptr->events_per_thread;
+    katomic_store_i32(&thread->is_ready, 1, KATOMIC_RELEASE);
+
+    local_thread = thread;
+    return thread;
+}
+
+b8 profiler_initialize(u64* memory_requirement, void* state, profiler_config config) {
+    u32 events_per_thread = round_up_pow2(config.events_per_thread ? config.events_per_thread : PROFILER_DEFAULT_EVENTS_PER_THREAD);
+    *memory_requirement = sizeof(profiler_state) + sizeof(profile_event) * PROFILER_MAX_THREADS * (u64)events_per_thread;
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, sizeof(profiler_state));
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->events_per_thread = events_per_thread;
+    state_ptr->event_mask = events_per_thread - 1;
+    state_ptr->start_ns = platform_get_absolute_time_ns();
+    katomic_store_i32(&state_ptr->enabled, config.enabled, KATOMIC_RELEASE);
+
+    // initialize is run on the main thread, so take the first slot for it
+    profiler_set_thread_name("main");
+
+    if (config.enabled) {
+        KINFO("Profiler recording, %u events per thread.", events_per_thread);
+    }
+    return true;
+}
+
+void profiler_shutdown(void* state) {
+    if (state_ptr) {
+        katomic_store_i32(&state_ptr->enabled, 0, KATOMIC_RELEASE);
+        if (state_ptr->config.capture_path) {
+            profiler_write_chrome_trace(state_ptr->config.capture_path);
+        }
+    }
+    local_thread = 0;
+    state_ptr = 0;
+}
+
+void profiler_set_enabled(b8 enabled) {
+    if (state_ptr) {
+        katomic_store_i32(&state_ptr->enabled, enabled, KATOMIC_RELEASE);
+    }
+}
+
+b8 profiler_is_enabled() {
+    return state_ptr && katomic_load_i32(&state_ptr->enabled, KATOMIC_RELAXED);
+}
+
+void profiler_set_thread_name(const char* name) {
+    if (!state_ptr) {
+        return;
+    }
+    profiler_thread* thread = get_thread();
+    if (thread) {
+        string_ncopy(thread->name, name, PROFILER_THREAD_NAME_LENGTH - 1);
+        thread->name[PROFILER_THREAD_NAME_LENGTH - 1] = 0;
+    }
+}
+
+profile_scope profiler_scope_begin(const char* name) {
+    profile_scope scope;
+    scope.name = name;
+    scope.start_ns = 0;
+    if (state_ptr && katomic_load_i32(&state_ptr->enabled, KATOMIC_RELAXED)) {
+        scope.start_ns = platform_get_absolute_time_ns();
+    }
+    return scope;
+}
+
+void profiler_scope_end(profile_scope* scope) {
+    if (!scope->start_ns || !state_ptr) {
+        return;
+    }
+    u64 end_ns = platform_get_absolute_time_ns();
+
+    profiler_thread* thread = get_thread();
+    if (!thread) {
+        return;
+    }
+
+    // only this thread writes to its buffer, so a plain read of the index is fine. the store after is what publishes the event
+    i64 index = thread->write_index;
+    profile_event* event = &thread->events[index & state_ptr->event_mask];
+    event->name = scope->name;
+    event->start_ns = scope->start_ns;
+    event->end_ns = end_ns;
+    katomic_store_i64(&thread->write_index, index + 1, KATOMIC_RELEASE);
+}
+
+typedef struct trace_writer {
+    file_handle file;
+    u8* buffer;
+    u64 used;
+    b8 failed;
+} trace_writer;
+
+static void trace_flush(trace_writer* writer) {
+    if (writer->used == 0 || writer->failed) {
+        return;
+    }
+    u64 written = 0;
+    if (!filesystem_write(&writer->file, writer->used, writer->buffer, &written) || written != writer->used) {
+        writer->failed = true;
+    }
+    writer->used = 0;
+}
+
+static void trace_append(trace_writer* writer, const char* text, i32 length) {
+    if (length <= 0) {
+        return;
+    }
+    if (writer->used + length > PROFILER_WRITE_BUFFER_SIZE) {
+        trace_flush(writer);
+    }
+    kcopy_memory(writer->buffer + writer->used, text, length);
+    writer->used += length;
+}
+
+b8 profiler_write_chrome_trace(const char* path) {
+    if (!state_ptr) {
+        return false;
+    }
+
+    trace_writer writer = {};
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &writer.file)) {
+        KERROR("profiler_write_chrome_trace - unable to open '%s' for writing.", path);
+        return false;
+    }
+    writer.buffer = kallocate(PROFILER_WRITE_BUFFER_SIZE, MEMORY_TAG_ARRAY);
+
+    // chrome's trace event format. every scope becomes a complete ("X") event, timestamps and durations are in microseconds.
+    // NOTE: names are written as is, without escaping, so they must not contain quotes or backslashes
+    char line[PROFILER_MAX_LINE_LENGTH];
+    i32 length = string_format(line, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    trace_append(&writer, line, length);
+
+    u64 event_count = 0;
+    b8 first = true;
+    i32 thread_count = katomic_load_i32(&state_ptr->thread_count, KATOMIC_ACQUIRE);
+    if (thread_count > PROFILER_MAX_THREADS) {
+        thread_count = PROFILER_MAX_THREADS;
+    }
+    for (i32 t = 0; t < thread_count; ++t) {
+        profiler_thread* thread = &state_ptr->threads[t];
+        if (!katomic_load_i32(&thread->is_ready, KATOMIC_ACQUIRE)) {
+            continue;
+        }
+
+        // name the thread, so the viewer shows something more useful than an id
+        length = string_format(line, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%i,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t, thread->name);
+        trace_append(&writer, line, length);
+        first = false;
+
+        // once the ring has wrapped only the newest events_per_thread are still there
+        i64 end = katomic_load_i64(&thread->write_index, KATOMIC_ACQUIRE);
+        i64 begin = end > (i64)state_ptr->events_per_thread ? end - state_ptr->events_per_thread : 0;
+        for (i64 i = begin; i < end; ++i) {
+            profile_event* event = &thread->events[i & state_ptr->event_mask];
+            length = string_format(line,
+                                   ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+                                   event->name,
+                                   t,
+                                   (event->start_ns - state_ptr->start_ns) / 1000.0,
+                                   (event->end_ns - event->start_ns) / 1000.0);
+            trace_append(&writer, line, length);
+        }
+        event_count += end - begin;
+    }
+
+    length = string_format(line, "\n]}\n");
+    trace_append(&writer, line, length);
+    trace_flush(&writer);
+
+    b8 success = !writer.failed;
+    kfree(writer.buffer, PROFILER_WRITE_BUFFER_SIZE, MEMORY_TAG_ARRAY);
+    filesystem_close(&writer.file);
+
+    if (success) {
+        KINFO("Profiler capture of %llu events across %i threads written to '%s'.", event_count, thread_count, path);
+    } else {
+        KERROR("profiler_write_chrome_trace - failed writing to '%s'.", path);
+    }
+    return success;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "defines.h"
+
+// disable profiling by commenting out the below line. every KPROFILE_ macro then compiles away to nothing
+#define KPROFILER_ENABLED
+
+// @brief the configuration for the profiler
+typedef struct profiler_config {
+    // @brief start recording straight away. recording can also be turned on and off later with profiler_set_enabled
+    b8 enabled;
+    // @brief the size of each thread's ring buffer, in events. once full the oldest events are overwritten. rounded up to
+    // a power of 2. 0 uses a default of 8192
+    u32 events_per_thread;
+    // @brief if set, a chrome trace of whatever is in the buffers is written here on shutdown
+    const char* capture_path;
+} profiler_config;
+
+// @brief a scope being timed. filled in by profiler_scope_begin, and recorded by profiler_scope_end
+typedef struct profile_scope {
+    const char* name;
+    // @brief 0 if the profiler was not recording when the scope began, in which case nothing is recorded
+    u64 start_ns;
+} profile_scope;
+
+// initialize the profiler, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
+// on the second pass - pass in the state as well as the memory requirement and actually initialize the system
+b8 profiler_initialize(u64* memory_requirement, void* state, profiler_config config);
+
+// shut down the profiler. writes out the capture first if a capture path was configured
+void profiler_shutdown(void* state);
+
+// @brief turns recording on or off. scopes that began while recording was off are not recorded
+KAPI void profiler_set_enabled(b8 enabled);
+
+// @brief indicates if the profiler is currently recording
+KAPI b8 profiler_is_enabled();
+
+// @brief names the calling thread in captures. the name is copied
+KAPI void profiler_set_thread_name(const char* name);
+
+// @brief starts timing a scope. use the KPROFILE_ macros rather than calling this directly
+// @param name the name of the scope. must be a string literal (or otherwise outlive the profiler), only the pointer is kept
+KAPI profile_scope profiler_scope_begin(const char* name);
+
+// @brief stops timing a scope, and records it to the calling thread's buffer
+KAPI void profiler_scope_end(profile_scope* scope);
+
+// @brief writes everything currently held in the buffers to a chrome trace event file, which can be opened in
+// chrome://tracing or ui.perfetto.dev. threads keep recording while this runs, so events being overwritten at the
+// same time can come out garbled. pause recording first (profiler_set_enabled) for a clean capture
+// @param path the path of the file to write
+// @return true on success, otherwise false
+KAPI b8 profiler_write_chrome_trace(const char* path);
+
+#ifdef KPROFILER_ENABLED
+#define KPROFILE_CONCAT_INNER(a, b) a##b
+#define KPROFILE_CONCAT(a, b) KPROFILE_CONCAT_INNER(a, b)
+
+// @brief times from here to the end of the enclosing block (including early returns and breaks). clang/gcc only, as it
+// relies on the cleanup attribute. use KPROFILE_BEGIN/KPROFILE_END anywhere else
+#if defined(__clang__) || defined(__gcc__) || defined(__GNUC__)
+#define KPROFILE_SCOPE(name) profile_scope KPROFILE_CONCAT(_kprofile_scope_, __LINE__) __attribute__((cleanup(profiler_scope_end))) = profiler_scope_begin(name)
+#else
+#define KPROFILE_SCOPE(name)
+#endif
+
+// @brief times from KPROFILE_BEGIN to the matching KPROFILE_END, for regions that do not line up with a block
+#define KPROFILE_BEGIN(scope, name) profile_scope scope = profiler_scope_begin(name)
+#define KPROFILE_END(scope) profiler_scope_end(&scope)
+#else
+#define KPROFILE_SCOPE(name)
+#define KPROFILE_BEGIN(scope, name)
+#define KPROFILE_END(scope)
+#endif
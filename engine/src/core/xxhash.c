@@ -0,0 +1,145 @@
+#include "xxhash.h"
+
+#include "core/kmemory.h"
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+// reads through a copy, as the data has no alignment guarantees. assumes a little endian host, like the rest of the engine
+static KINLINE u64 read_u64(const u8* p) {
+    u64 value;
+    kcopy_memory(&value, p, sizeof(u64));
+    return value;
+}
+
+static KINLINE u32 read_u32(const u8* p) {
+    u32 value;
+    kcopy_memory(&value, p, sizeof(u32));
+    return value;
+}
+
+static KINLINE u64 rotl64(u64 x, u32 r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static KINLINE u64 round64(u64 accumulator, u64 input) {
+    accumulator += input * XXH_PRIME64_2;
+    accumulator = rotl64(accumulator, 31);
+    return accumulator * XXH_PRIME64_1;
+}
+
+static KINLINE u64 merge_round64(u64 hash, u64 accumulator) {
+    hash ^= round64(0, accumulator);
+    return hash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+// runs the four lanes over as many whole 32 byte stripes as there are. returns how many bytes were consumed
+static u64 consume_stripes(u64* acc, const u8* p, u64 size) {
+    u64 consumed = 0;
+    while (size - consumed >= 32) {
+        acc[0] = round64(acc[0], read_u64(p + consumed));
+        acc[1] = round64(acc[1], read_u64(p + consumed + 8));
+        acc[2] = round64(acc[2], read_u64(p + consumed + 16));
+        acc[3] = round64(acc[3], read_u64(p + consumed + 24));
+        consumed += 32;
+    }
+    return consumed;
+}
+
+static void reset_accumulators(u64* acc, u64 seed) {
+    acc[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    acc[1] = seed + XXH_PRIME64_2;
+    acc[2] = seed;
+    acc[3] = seed - XXH_PRIME64_1;
+}
+
+// folds the lanes (or the seed, for inputs under a stripe) together, then mixes in the leftover tail bytes
+static u64 finalize(const u64* acc, u64 seed, u64 total_size, const u8* tail, u64 tail_size) {
+    u64 hash;
+    if (total_size >= 32) {
+        hash = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+        hash = merge_round64(hash, acc[0]);
+        hash = merge_round64(hash, acc[1]);
+        hash = merge_round64(hash, acc[2]);
+        hash = merge_round64(hash, acc[3]);
+    } else {
+        hash = seed + XXH_PRIME64_5;
+    }
+    hash += total_size;
+
+    while (tail_size >= 8) {
+        hash ^= round64(0, read_u64(tail));
+        hash = rotl64(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        tail += 8;
+        tail_size -= 8;
+    }
+    if (tail_size >= 4) {
+        hash ^= (u64)read_u32(tail) * XXH_PRIME64_1;
+        hash = rotl64(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        tail += 4;
+        tail_size -= 4;
+    }
+    while (tail_size > 0) {
+        hash ^= (*tail) * XXH_PRIME64_5;
+        hash = rotl64(hash, 11) * XXH_PRIME64_1;
+        tail++;
+        tail_size--;
+    }
+
+    // avalanche
+    hash ^= hash >> 33;
+    hash *= XXH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= XXH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 xxhash64(const void* data, u64 size, u64 seed) {
+    const u8* p = data;
+    u64 acc[4];
+    reset_accumulators(acc, seed);
+    u64 consumed = size >= 32 ? consume_stripes(acc, p, size) : 0;
+    return finalize(acc, seed, size, p + consumed, size - consumed);
+}
+
+void xxhash64_begin(xxhash64_state* state, u64 seed) {
+    kzero_memory(state, sizeof(xxhash64_state));
+    state->seed = seed;
+    reset_accumulators(state->accumulators, seed);
+}
+
+void xxhash64_update(xxhash64_state* state, const void* data, u64 size) {
+    const u8* p = data;
+    state->total_size += size;
+
+    // top up a part filled stripe first
+    if (state->buffer_size > 0) {
+        u64 fill = 32 - state->buffer_size;
+        if (fill > size) {
+            fill = size;
+        }
+        kcopy_memory(state->buffer + state->buffer_size, p, fill);
+        state->buffer_size += (u32)fill;
+        p += fill;
+        size -= fill;
+        if (state->buffer_size < 32) {
+            return;
+        }
+        consume_stripes(state->accumulators, state->buffer, 32);
+        state->buffer_size = 0;
+    }
+
+    u64 consumed = consume_stripes(state->accumulators, p, size);
+    if (size > consumed) {
+        kcopy_memory(state->buffer, p + consumed, size - consumed);
+        state->buffer_size = (u32)(size - consumed);
+    }
+}
+
+u64 xxhash64_end(const xxhash64_state* state) {
+    return finalize(state->accumulators, state->seed, state->total_size, state->buffer, state->buffer_size);
+}
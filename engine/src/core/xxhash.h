@@ -0,0 +1,33 @@
+#pragma once
+
+#include "defines.h"
+
+// xxhash64, a fast non-cryptographic hash. good for telling if content has changed (cooked assets, caches) and for
+// hash tables keyed on larger blobs. gives the same results as the reference implementation, so hashes written to
+// disk can be checked by other tools
+
+// @brief hashes a block of memory in one go
+// @param data the data to hash. can be 0 if size is 0
+// @param size the size of the data in bytes
+// @param seed a seed to start from. the same data and seed always give the same hash
+// @return the 64 bit hash
+KAPI u64 xxhash64(const void* data, u64 size, u64 seed);
+
+// @brief the running state of a hash that is fed data a piece at a time, such as a file read in chunks
+typedef struct xxhash64_state {
+    u64 accumulators[4];
+    u64 total_size;
+    u8 buffer[32];
+    u32 buffer_size;
+    u64 seed;
+} xxhash64_state;
+
+// @brief starts a streamed hash
+KAPI void xxhash64_begin(xxhash64_state* state, u64 seed);
+
+// @brief feeds more data into a streamed hash
+KAPI void xxhash64_update(xxhash64_state* state, const void* data, u64 size);
+
+// @brief finishes a streamed hash. gives the same result as xxhash64 over all of the data at once. the state can be
+// fed more data afterwards, and finished again
+KAPI u64 xxhash64_end(const xxhash64_state* state);
@@ -130,6 +130,13 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #define KNOINLINE
 #endif
 
+// @brief marks a global or static variable as having its own separate copy on every thread
+#if defined(_MSC_VER) && !defined(__clang__)
+#define KTHREAD_LOCAL __declspec(thread)
+#else
+#define KTHREAD_LOCAL _Thread_local
+#endif
+
 // @brief gets the number of bytes from amount of gibibytes (GiB) (1024*1024*1024)
 #define GIBIBYTES(amount) amount * 1024 * 1024 * 1024
 // @brief gets the number of bytes from amount of mebibytes (MiB) (1024*1024)
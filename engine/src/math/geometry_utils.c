@@ -1,91 +1,599 @@
 #include "geometry_utils.h"
 
 #include "kmath.h"
+#include "core/kmemory.h"
 #include "core/logger.h"
+#include "core/profiler.h"
+#include "core/xxhash.h"
+#include "systems/job_system.h"
 
-// @brief calculates normals for the given vertex and index data. modifies vertices in place
-// @param vertex_count the number of vertices
-// @param vertices an array of vertices
-// @param index_count the number of indices.
-// @param indices an array of indices
-void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
-    for (u32 i = 0; i < index_count; i += 3) {
-        u32 i0 = indices[i + 0];
-        u32 i1 = indices[i + 1];
-        u32 i2 = indices[i + 2];
+// NOTE: begin normals and tangents
+
+// both are worked out in two passes, each a batch of triangles or vertices at a time. a batch is laid out as a
+// structure of arrays, so each simd lane takes a triangle or vertex of its own:
+//   1. each triangle's normal, or tangent, weighted by its area. in jobs over ranges of the triangles
+//   2. each vertex sums those of the triangles it is part of, then is normalized and, for tangents, made perpendicular
+//      to the normal (gram-schmidt). in jobs over ranges of the vertices. each job goes through every index, but only
+//      adds up its own vertices, so no two jobs write to the same place and the sums are the same however it's split
+// both have sse and avx versions of the maths, and a plain c one for everything else
+
+#if defined(__x86_64__) || defined(_M_X64)
+// sse2 is part of x86-64, so it is always there
+#define GEOMETRY_HAS_SSE 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// avx is only used if the cpu says it has it, so it is built into functions of its own rather than everywhere
+#define GEOMETRY_HAS_AVX 1
+#define GEOMETRY_AVX_TARGET __attribute__((target("avx")))
+#include <cpuid.h>
+#endif
+#endif
+
+// the lanes in a batch. enough for avx
+#define FRAME_BATCH_SIZE 8
+// the triangles each job takes on in the first pass. a multiple of FRAME_BATCH_SIZE, so no two jobs share a batch
+#define FRAME_FACE_JOB_SIZE 16384
+// the fewest vertices worth a job of their own in the second pass. every job reads all the indices, so there are never
+// more jobs than threads to run them
+#define FRAME_VERTEX_JOB_MIN_SIZE 16384
+
+static b8 simd_level_known = false;
+static geometry_simd_level simd_level = GEOMETRY_SIMD_LEVEL_SCALAR;
+
+// the edges and texture coordinate deltas of a batch of triangles. unused lanes are zero
+typedef struct face_batch {
+    f32 e1x[FRAME_BATCH_SIZE], e1y[FRAME_BATCH_SIZE], e1z[FRAME_BATCH_SIZE];
+    f32 e2x[FRAME_BATCH_SIZE], e2y[FRAME_BATCH_SIZE], e2z[FRAME_BATCH_SIZE];
+    f32 du1[FRAME_BATCH_SIZE], dv1[FRAME_BATCH_SIZE], du2[FRAME_BATCH_SIZE], dv2[FRAME_BATCH_SIZE];
+} face_batch;
 
-        vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
-        vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+// the summed values of a batch of vertices, normalized in place. for tangents, also the normals they go around
+typedef struct vertex_batch {
+    f32 x[FRAME_BATCH_SIZE], y[FRAME_BATCH_SIZE], z[FRAME_BATCH_SIZE], w[FRAME_BATCH_SIZE];
+    f32 nx[FRAME_BATCH_SIZE], ny[FRAME_BATCH_SIZE], nz[FRAME_BATCH_SIZE];
+} vertex_batch;
 
-        vec3 normal = vec3_normalized(vec3_cross(edge1, edge2));
+typedef struct frame_work {
+    geometry_simd_level level;
+    b8 tangents;
+    vertex_3d* vertices;
+    const u32* indices;
+    u32 index_count;
+    // the value of each triangle, x, y, z and w one after the other, so summing one up is a single load. w is the
+    // handedness weighted by area, for tangents only. padded out to a whole batch
+    f32* faces;
+} frame_work;
 
-        // NOTE: this just generates a face normal. smoothing out should be done in a separate pass if desired
-        vertices[i0].normal = normal;
-        vertices[i1].normal = normal;
-        vertices[i2].normal = normal;
+typedef struct frame_job {
+    frame_work* work;
+    u32 begin;
+    u32 end;
+} frame_job;
+
+static geometry_simd_level simd_level_supported() {
+#if defined(GEOMETRY_HAS_AVX)
+    // the cpu has to have it, and the os has to save the registers
+    u32 a = 0, b = 0, c = 0, d = 0;
+    if (__get_cpuid(1, &a, &b, &c, &d) && (c & bit_OSXSAVE) && (c & bit_AVX)) {
+        u32 xcr0_low = 0, xcr0_high = 0;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        if ((xcr0_low & 6) == 6) {
+            return GEOMETRY_SIMD_LEVEL_AVX;
+        }
     }
+#endif
+#if defined(GEOMETRY_HAS_SSE)
+    return GEOMETRY_SIMD_LEVEL_SSE;
+#else
+    return GEOMETRY_SIMD_LEVEL_SCALAR;
+#endif
 }
 
-// @brief calculates tangents for the given vertex and index data. modifies vertices in place
-// @param vertex_count the number of vertices
-// @param vertices an array of vertices
-// @param index_count the number of indices.
-// @param indices an array of indices
-void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
-    for (u32 i = 0; i < index_count; i += 3) {
-        u32 i0 = indices[i + 0];
-        u32 i1 = indices[i + 1];
-        u32 i2 = indices[i + 2];
+geometry_simd_level geometry_simd_level_get() {
+    if (!simd_level_known) {
+        simd_level = simd_level_supported();
+        simd_level_known = true;
+    }
+    return simd_level;
+}
 
-        vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
-        vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+geometry_simd_level geometry_simd_level_set(geometry_simd_level level) {
+    geometry_simd_level supported = simd_level_supported();
+    simd_level = level < supported ? level : supported;
+    simd_level_known = true;
+    return simd_level;
+}
 
-        f32 deltaU1 = vertices[i1].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV1 = vertices[i1].texcoord.y - vertices[i0].texcoord.y;
+// each triangle's normal is the cross product of its edges, which is already as long as twice its area. its tangent is
+// the direction u increases in, made as long as the normal. the handedness is kept as it has always been: -1 where the
+// texture coordinates wind the same way as the triangle, 1 where they're mirrored
+static void face_batch_scalar(const face_batch* b, u32 count, b8 tangents, f32* out_faces) {
+    for (u32 i = 0; i < count; ++i) {
+        f32* out = &out_faces[i * 4];
+        f32 nx = b->e1y[i] * b->e2z[i] - b->e1z[i] * b->e2y[i];
+        f32 ny = b->e1z[i] * b->e2x[i] - b->e1x[i] * b->e2z[i];
+        f32 nz = b->e1x[i] * b->e2y[i] - b->e1y[i] * b->e2x[i];
+        if (!tangents) {
+            out[0] = nx;
+            out[1] = ny;
+            out[2] = nz;
+            out[3] = 0.0f;
+            continue;
+        }
+        f32 area = ksqrt(nx * nx + ny * ny + nz * nz);
+        f32 det = b->du1[i] * b->dv2[i] - b->du2[i] * b->dv1[i];
+        f32 tx = b->dv2[i] * b->e1x[i] - b->dv1[i] * b->e2x[i];
+        f32 ty = b->dv2[i] * b->e1y[i] - b->dv1[i] * b->e2y[i];
+        f32 tz = b->dv2[i] * b->e1z[i] - b->dv1[i] * b->e2z[i];
+        f32 length = ksqrt(tx * tx + ty * ty + tz * tz);
+        // no direction at all where the texture coordinates don't span a triangle
+        f32 signed_area = det < 0.0f ? -area : area;
+        f32 scale = det != 0.0f && length > 0.0f ? signed_area / length : 0.0f;
+        out[0] = tx * scale;
+        out[1] = ty * scale;
+        out[2] = tz * scale;
+        out[3] = det != 0.0f ? -signed_area : 0.0f;
+    }
+}
+
+static void vertex_batch_scalar(vertex_batch* b, u32 count, b8 tangents) {
+    for (u32 i = 0; i < count; ++i) {
+        if (tangents) {
+            f32 d = b->nx[i] * b->x[i] + b->ny[i] * b->y[i] + b->nz[i] * b->z[i];
+            b->x[i] -= b->nx[i] * d;
+            b->y[i] -= b->ny[i] * d;
+            b->z[i] -= b->nz[i] * d;
+            b->w[i] = b->w[i] < 0.0f ? -1.0f : 1.0f;
+        }
+        f32 length = ksqrt(b->x[i] * b->x[i] + b->y[i] * b->y[i] + b->z[i] * b->z[i]);
+        f32 inverse = length > 0.0f ? 1.0f / length : 0.0f;
+        b->x[i] *= inverse;
+        b->y[i] *= inverse;
+        b->z[i] *= inverse;
+    }
+}
+
+#if defined(GEOMETRY_HAS_SSE)
+// the same as face_batch_scalar, for the 4 lanes from lane
+static void face_batch_sse(const face_batch* b, u32 lane, b8 tangents, f32* out_faces) {
+    __m128 e1x = _mm_loadu_ps(b->e1x + lane), e1y = _mm_loadu_ps(b->e1y + lane), e1z = _mm_loadu_ps(b->e1z + lane);
+    __m128 e2x = _mm_loadu_ps(b->e2x + lane), e2y = _mm_loadu_ps(b->e2y + lane), e2z = _mm_loadu_ps(b->e2z + lane);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+    __m128 w = _mm_setzero_ps();
+    if (tangents) {
+        __m128 zero = _mm_setzero_ps();
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 du1 = _mm_loadu_ps(b->du1 + lane), dv1 = _mm_loadu_ps(b->dv1 + lane);
+        __m128 du2 = _mm_loadu_ps(b->du2 + lane), dv2 = _mm_loadu_ps(b->dv2 + lane);
+        __m128 area = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+        __m128 tx = _mm_sub_ps(_mm_mul_ps(dv2, e1x), _mm_mul_ps(dv1, e2x));
+        __m128 ty = _mm_sub_ps(_mm_mul_ps(dv2, e1y), _mm_mul_ps(dv1, e2y));
+        __m128 tz = _mm_sub_ps(_mm_mul_ps(dv2, e1z), _mm_mul_ps(dv1, e2z));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+        __m128 signed_area = _mm_or_ps(area, _mm_and_ps(det, sign));
+        __m128 has_det = _mm_cmpneq_ps(det, zero);
+        // the division is masked off afterwards where it would have been by zero
+        __m128 scale = _mm_and_ps(_mm_div_ps(signed_area, length), _mm_and_ps(has_det, _mm_cmpgt_ps(length, zero)));
+        x = _mm_mul_ps(tx, scale);
+        y = _mm_mul_ps(ty, scale);
+        z = _mm_mul_ps(tz, scale);
+        w = _mm_and_ps(_mm_xor_ps(signed_area, sign), has_det);
+    }
+    // lanes back into one triangle after another
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    f32* out = out_faces + lane * 4;
+    _mm_storeu_ps(out, x);
+    _mm_storeu_ps(out + 4, y);
+    _mm_storeu_ps(out + 8, z);
+    _mm_storeu_ps(out + 12, w);
+}
+
+// the same as vertex_batch_scalar, for the 4 lanes from lane
+static void vertex_batch_sse(vertex_batch* b, u32 lane, b8 tangents) {
+    __m128 zero = _mm_setzero_ps();
+    __m128 x = _mm_loadu_ps(b->x + lane), y = _mm_loadu_ps(b->y + lane), z = _mm_loadu_ps(b->z + lane);
+    if (tangents) {
+        __m128 nx = _mm_loadu_ps(b->nx + lane), ny = _mm_loadu_ps(b->ny + lane), nz = _mm_loadu_ps(b->nz + lane);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, x), _mm_mul_ps(ny, y)), _mm_mul_ps(nz, z));
+        x = _mm_sub_ps(x, _mm_mul_ps(nx, d));
+        y = _mm_sub_ps(y, _mm_mul_ps(ny, d));
+        z = _mm_sub_ps(z, _mm_mul_ps(nz, d));
+        __m128 negative = _mm_cmplt_ps(_mm_loadu_ps(b->w + lane), zero);
+        _mm_storeu_ps(b->w + lane, _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-1.0f)), _mm_andnot_ps(negative, _mm_set1_ps(1.0f))));
+    }
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    __m128 inverse = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), length), _mm_cmpgt_ps(length, zero));
+    _mm_storeu_ps(b->x + lane, _mm_mul_ps(x, inverse));
+    _mm_storeu_ps(b->y + lane, _mm_mul_ps(y, inverse));
+    _mm_storeu_ps(b->z + lane, _mm_mul_ps(z, inverse));
+}
+#endif
 
-        f32 deltaU2 = vertices[i2].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV2 = vertices[i2].texcoord.y - vertices[i0].texcoord.y;
+#if defined(GEOMETRY_HAS_AVX)
+// the same as face_batch_scalar, for all 8 lanes
+GEOMETRY_AVX_TARGET static void face_batch_avx(const face_batch* b, b8 tangents, f32* out_faces) {
+    __m256 e1x = _mm256_loadu_ps(b->e1x), e1y = _mm256_loadu_ps(b->e1y), e1z = _mm256_loadu_ps(b->e1z);
+    __m256 e2x = _mm256_loadu_ps(b->e2x), e2y = _mm256_loadu_ps(b->e2y), e2z = _mm256_loadu_ps(b->e2z);
+    __m256 x = _mm256_sub_ps(_mm256_mul_ps(e1y, e2z), _mm256_mul_ps(e1z, e2y));
+    __m256 y = _mm256_sub_ps(_mm256_mul_ps(e1z, e2x), _mm256_mul_ps(e1x, e2z));
+    __m256 z = _mm256_sub_ps(_mm256_mul_ps(e1x, e2y), _mm256_mul_ps(e1y, e2x));
+    __m256 w = _mm256_setzero_ps();
+    if (tangents) {
+        __m256 zero = _mm256_setzero_ps();
+        __m256 sign = _mm256_set1_ps(-0.0f);
+        __m256 du1 = _mm256_loadu_ps(b->du1), dv1 = _mm256_loadu_ps(b->dv1);
+        __m256 du2 = _mm256_loadu_ps(b->du2), dv2 = _mm256_loadu_ps(b->dv2);
+        __m256 area = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+        __m256 det = _mm256_sub_ps(_mm256_mul_ps(du1, dv2), _mm256_mul_ps(du2, dv1));
+        __m256 tx = _mm256_sub_ps(_mm256_mul_ps(dv2, e1x), _mm256_mul_ps(dv1, e2x));
+        __m256 ty = _mm256_sub_ps(_mm256_mul_ps(dv2, e1y), _mm256_mul_ps(dv1, e2y));
+        __m256 tz = _mm256_sub_ps(_mm256_mul_ps(dv2, e1z), _mm256_mul_ps(dv1, e2z));
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, tx), _mm256_mul_ps(ty, ty)), _mm256_mul_ps(tz, tz)));
+        __m256 signed_area = _mm256_or_ps(area, _mm256_and_ps(det, sign));
+        __m256 has_det = _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ);
+        __m256 scale = _mm256_and_ps(_mm256_div_ps(signed_area, length), _mm256_and_ps(has_det, _mm256_cmp_ps(length, zero, _CMP_GT_OQ)));
+        x = _mm256_mul_ps(tx, scale);
+        y = _mm256_mul_ps(ty, scale);
+        z = _mm256_mul_ps(tz, scale);
+        w = _mm256_and_ps(_mm256_xor_ps(signed_area, sign), has_det);
+    }
+    // lanes back into one triangle after another. a 4x4 transpose within each half, then the halves put in order
+    __m256 xy_low = _mm256_unpacklo_ps(x, y);
+    __m256 xy_high = _mm256_unpackhi_ps(x, y);
+    __m256 zw_low = _mm256_unpacklo_ps(z, w);
+    __m256 zw_high = _mm256_unpackhi_ps(z, w);
+    __m256 t0 = _mm256_shuffle_ps(xy_low, zw_low, 0x44);
+    __m256 t1 = _mm256_shuffle_ps(xy_low, zw_low, 0xee);
+    __m256 t2 = _mm256_shuffle_ps(xy_high, zw_high, 0x44);
+    __m256 t3 = _mm256_shuffle_ps(xy_high, zw_high, 0xee);
+    _mm256_storeu_ps(out_faces, _mm256_permute2f128_ps(t0, t1, 0x20));
+    _mm256_storeu_ps(out_faces + 8, _mm256_permute2f128_ps(t2, t3, 0x20));
+    _mm256_storeu_ps(out_faces + 16, _mm256_permute2f128_ps(t0, t1, 0x31));
+    _mm256_storeu_ps(out_faces + 24, _mm256_permute2f128_ps(t2, t3, 0x31));
+}
 
-        f32 dividend = (deltaU1 * deltaV2 - deltaU2 * deltaV1);
-        f32 fc = 1.0f / dividend;
+// the same as vertex_batch_scalar, for all 8 lanes
+GEOMETRY_AVX_TARGET static void vertex_batch_avx(vertex_batch* b, b8 tangents) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 x = _mm256_loadu_ps(b->x), y = _mm256_loadu_ps(b->y), z = _mm256_loadu_ps(b->z);
+    if (tangents) {
+        __m256 nx = _mm256_loadu_ps(b->nx), ny = _mm256_loadu_ps(b->ny), nz = _mm256_loadu_ps(b->nz);
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, x), _mm256_mul_ps(ny, y)), _mm256_mul_ps(nz, z));
+        x = _mm256_sub_ps(x, _mm256_mul_ps(nx, d));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(ny, d));
+        z = _mm256_sub_ps(z, _mm256_mul_ps(nz, d));
+        __m256 negative = _mm256_cmp_ps(_mm256_loadu_ps(b->w), zero, _CMP_LT_OQ);
+        _mm256_storeu_ps(b->w, _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_set1_ps(-1.0f), negative));
+    }
+    __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+    __m256 inverse = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+    _mm256_storeu_ps(b->x, _mm256_mul_ps(x, inverse));
+    _mm256_storeu_ps(b->y, _mm256_mul_ps(y, inverse));
+    _mm256_storeu_ps(b->z, _mm256_mul_ps(z, inverse));
+}
+#endif
 
-        // need to study more math for this stuff
-        vec3 tangent = (vec3){
-            (fc * (deltaV2 * edge1.x - deltaV1 * edge2.x)),
-            (fc * (deltaV2 * edge1.y - deltaV1 * edge2.y)),
-            (fc * (deltaV2 * edge1.z - deltaV1 * edge2.z))};
+// writes a whole batch of FRAME_BATCH_SIZE triangles to out_faces, except in plain c, which writes only count
+static void face_batch_run(geometry_simd_level level, const face_batch* b, u32 count, b8 tangents, f32* out_faces) {
+#if defined(GEOMETRY_HAS_AVX)
+    if (level == GEOMETRY_SIMD_LEVEL_AVX) {
+        face_batch_avx(b, tangents, out_faces);
+        return;
+    }
+#endif
+#if defined(GEOMETRY_HAS_SSE)
+    if (level >= GEOMETRY_SIMD_LEVEL_SSE) {
+        face_batch_sse(b, 0, tangents, out_faces);
+        face_batch_sse(b, 4, tangents, out_faces);
+        return;
+    }
+#endif
+    face_batch_scalar(b, count, tangents, out_faces);
+}
 
-        tangent = vec3_normalized(tangent);
+static void vertex_batch_run(geometry_simd_level level, vertex_batch* b, u32 count, b8 tangents) {
+#if defined(GEOMETRY_HAS_AVX)
+    if (level == GEOMETRY_SIMD_LEVEL_AVX) {
+        vertex_batch_avx(b, tangents);
+        return;
+    }
+#endif
+#if defined(GEOMETRY_HAS_SSE)
+    if (level >= GEOMETRY_SIMD_LEVEL_SSE) {
+        vertex_batch_sse(b, 0, tangents);
+        vertex_batch_sse(b, 4, tangents);
+        return;
+    }
+#endif
+    vertex_batch_scalar(b, count, tangents);
+}
 
-        f32 sx = deltaU1, sy = deltaU2;
-        f32 tx = deltaV1, ty = deltaV2;
-        f32 handedness = ((tx * sy - ty * sx) < 0.0f) ? -1.0f : 1.0f;  // to flip the normals if the geometry is flipped
-        vec4 t4 = vec4_from_vec3(tangent, handedness);
-        vertices[i0].tangent = t4;
-        vertices[i1].tangent = t4;
-        vertices[i2].tangent = t4;
+static void face_job_entry(void* params) {
+    frame_job* job = params;
+    frame_work* work = job->work;
+    const vertex_3d* vertices = work->vertices;
+    face_batch batch;
+    for (u32 first = job->begin; first < job->end; first += FRAME_BATCH_SIZE) {
+        u32 count = job->end - first < FRAME_BATCH_SIZE ? job->end - first : FRAME_BATCH_SIZE;
+        if (count < FRAME_BATCH_SIZE) {
+            kzero_memory(&batch, sizeof(face_batch));
+        }
+        // the gather, from the vertices into lanes
+        for (u32 i = 0; i < count; ++i) {
+            const u32* triangle = &work->indices[(first + i) * 3];
+            const vertex_3d* v0 = &vertices[triangle[0]];
+            const vertex_3d* v1 = &vertices[triangle[1]];
+            const vertex_3d* v2 = &vertices[triangle[2]];
+            batch.e1x[i] = v1->position.x - v0->position.x;
+            batch.e1y[i] = v1->position.y - v0->position.y;
+            batch.e1z[i] = v1->position.z - v0->position.z;
+            batch.e2x[i] = v2->position.x - v0->position.x;
+            batch.e2y[i] = v2->position.y - v0->position.y;
+            batch.e2z[i] = v2->position.z - v0->position.z;
+            batch.du1[i] = v1->texcoord.x - v0->texcoord.x;
+            batch.dv1[i] = v1->texcoord.y - v0->texcoord.y;
+            batch.du2[i] = v2->texcoord.x - v0->texcoord.x;
+            batch.dv2[i] = v2->texcoord.y - v0->texcoord.y;
+        }
+        face_batch_run(work->level, &batch, count, work->tangents, work->faces + (u64)first * 4);
     }
 }
 
-b8 vertex3d_equal(vertex_3d vert_0, vertex_3d vert_1) {
-    return vec3_compare(vert_0.position, vert_1.position, K_FLOAT_EPSILON) &&
-           vec3_compare(vert_0.normal, vert_1.normal, K_FLOAT_EPSILON) &&
-           vec2_compare(vert_0.texcoord, vert_1.texcoord, K_FLOAT_EPSILON) &&
-           vec4_compare(vert_0.colour, vert_1.colour, K_FLOAT_EPSILON) &&
-           vec4_compare(vert_0.tangent, vert_1.tangent, K_FLOAT_EPSILON);
+// any direction perpendicular to the normal, for tangents where the texture coordinates give none
+static vec3 any_tangent(vec3 normal) {
+    vec3 axis = kabs(normal.x) < 0.9f ? vec3_create(1.0f, 0.0f, 0.0f) : vec3_create(0.0f, 1.0f, 0.0f);
+    vec3 tangent = vec3_sub(axis, vec3_mul_scalar(normal, vec3_dot(normal, axis)));
+    return vec3_length(tangent) > 0.0f ? vec3_normalized(tangent) : vec3_create(1.0f, 0.0f, 0.0f);
 }
 
-void reassign_index(u32 index_count, u32* indices, u32 from, u32 to) {
-    for (u32 i = 0; i < index_count; ++i) {
-        if (indices[i] == from) {
-            indices[i] = to;
-        } else if (indices[i] > from) {
-            // pull in all indices higher than 'from' by 1
-            indices[i]--;
+static void vertex_job_entry(void* params) {
+    frame_job* job = params;
+    frame_work* work = job->work;
+    vertex_3d* vertices = work->vertices;
+    u32 vertex_count = job->end - job->begin;
+
+    // the sums for this job's vertices, along with whether each is in a triangle at all
+    u64 sums_size = sizeof(f32) * 4 * vertex_count;
+    f32* sums = kallocate(sums_size, MEMORY_TAG_ARRAY);
+    b8* used = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    const f32* faces = work->faces;
+    for (u32 i = 0; i < work->index_count; ++i) {
+        u32 v = work->indices[i] - job->begin;
+        if (v >= vertex_count) {
+            continue;
         }
+        const f32* face = &faces[(u64)(i / 3) * 4];
+        f32* sum = &sums[(u64)v * 4];
+#if defined(GEOMETRY_HAS_SSE)
+        if (work->level >= GEOMETRY_SIMD_LEVEL_SSE) {
+            _mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), _mm_loadu_ps(face)));
+        } else
+#endif
+        {
+            sum[0] += face[0];
+            sum[1] += face[1];
+            sum[2] += face[2];
+            sum[3] += face[3];
+        }
+        used[v] = true;
     }
+
+    vertex_batch batch;
+    for (u32 first = 0; first < vertex_count; first += FRAME_BATCH_SIZE) {
+        u32 count = vertex_count - first < FRAME_BATCH_SIZE ? vertex_count - first : FRAME_BATCH_SIZE;
+        if (count < FRAME_BATCH_SIZE) {
+            kzero_memory(&batch, sizeof(vertex_batch));
+        }
+        for (u32 i = 0; i < count; ++i) {
+            const f32* sum = &sums[(u64)(first + i) * 4];
+            batch.x[i] = sum[0];
+            batch.y[i] = sum[1];
+            batch.z[i] = sum[2];
+            batch.w[i] = sum[3];
+            if (work->tangents) {
+                const vec3* normal = &vertices[job->begin + first + i].normal;
+                batch.nx[i] = normal->x;
+                batch.ny[i] = normal->y;
+                batch.nz[i] = normal->z;
+            }
+        }
+
+        vertex_batch_run(work->level, &batch, count, work->tangents);
+
+        // and the scatter back out
+        for (u32 i = 0; i < count; ++i) {
+            if (!used[first + i]) {
+                continue;
+            }
+            vertex_3d* vertex = &vertices[job->begin + first + i];
+            vec3 value = vec3_create(batch.x[i], batch.y[i], batch.z[i]);
+            if (!work->tangents) {
+                vertex->normal = value;
+            } else {
+                if (value.x == 0.0f && value.y == 0.0f && value.z == 0.0f) {
+                    value = any_tangent(vertex->normal);
+                }
+                vertex->tangent = vec4_from_vec3(value, batch.w[i]);
+            }
+        }
+    }
+
+    kfree(used, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(sums, sums_size, MEMORY_TAG_ARRAY);
 }
 
+// splits [0, count) into job_count ranges, each a multiple of FRAME_BATCH_SIZE, and waits for them. run right here if
+// there's just the one, or no workers to split it between
+static void frame_run(pfn_job_entry entry_point, frame_work* work, u32 count, u32 job_count) {
+    if (job_count <= 1 || job_system_worker_count() == 0) {
+        frame_job job = {work, 0, count};
+        entry_point(&job);
+        return;
+    }
+
+    u32 range = (count + job_count - 1) / job_count;
+    range = (range + FRAME_BATCH_SIZE - 1) / FRAME_BATCH_SIZE * FRAME_BATCH_SIZE;
+    frame_job* jobs = kallocate(sizeof(frame_job) * job_count, MEMORY_TAG_ARRAY);
+    job_info* infos = kallocate(sizeof(job_info) * job_count, MEMORY_TAG_ARRAY);
+    job_counter counter = {};
+    u32 submitted = 0;
+    for (u32 begin = 0; begin < count; begin += range) {
+        jobs[submitted].work = work;
+        jobs[submitted].begin = begin;
+        jobs[submitted].end = count - begin < range ? count : begin + range;
+        // something is waiting on these
+        infos[submitted] = job_create(entry_point, &jobs[submitted], JOB_PRIORITY_HIGH);
+        infos[submitted].counter = &counter;
+        submitted++;
+    }
+    job_system_submit_batch(infos, submitted);
+    job_system_wait(&counter);
+    kfree(infos, sizeof(job_info) * job_count, MEMORY_TAG_ARRAY);
+    kfree(jobs, sizeof(frame_job) * job_count, MEMORY_TAG_ARRAY);
+}
+
+static void generate_frames(u32 vertex_count, vertex_3d* vertices, u32 index_count, const u32* indices, b8 tangents) {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || vertex_count == 0) {
+        return;
+    }
+
+    frame_work work = {};
+    work.level = geometry_simd_level_get();
+    work.tangents = tangents;
+    work.vertices = vertices;
+    work.indices = indices;
+    work.index_count = triangle_count * 3;
+    // padded, so the simd versions can always write a whole batch
+    u64 faces_size = sizeof(f32) * 4 * (((u64)triangle_count + FRAME_BATCH_SIZE - 1) / FRAME_BATCH_SIZE * FRAME_BATCH_SIZE);
+    work.faces = kallocate(faces_size, MEMORY_TAG_ARRAY);
+
+    u32 thread_count = job_system_worker_count() + 1;
+    u32 vertex_job_count = (vertex_count + FRAME_VERTEX_JOB_MIN_SIZE - 1) / FRAME_VERTEX_JOB_MIN_SIZE;
+    frame_run(face_job_entry, &work, triangle_count, (triangle_count + FRAME_FACE_JOB_SIZE - 1) / FRAME_FACE_JOB_SIZE);
+    frame_run(vertex_job_entry, &work, vertex_count, vertex_job_count < thread_count ? vertex_job_count : thread_count);
+
+    kfree(work.faces, faces_size, MEMORY_TAG_ARRAY);
+}
+
+void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
+    KPROFILE_SCOPE("geometry_generate_normals");
+    generate_frames(vertex_count, vertices, index_count, indices, false);
+}
+
+void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
+    KPROFILE_SCOPE("geometry_generate_tangents");
+    generate_frames(vertex_count, vertices, index_count, indices, true);
+}
+
+// NOTE: end normals and tangents
+
+// NOTE: begin welding
+
+// each attribute of a vertex is turned into a whole number, and vertices with all the same numbers are welded. exactly,
+// that is the bits of each float. with an epsilon, the nearest multiple of epsilon to each float
+#define WELD_KEY_COUNT (sizeof(vertex_3d) / sizeof(f32))
+
+typedef struct weld_key {
+    i64 values[WELD_KEY_COUNT];
+} weld_key;
+
+static void weld_key_create(const vertex_3d* vertex, f64 inverse_epsilon, weld_key* out_key) {
+    const f32* attributes = (const f32*)vertex;
+    for (u32 i = 0; i < WELD_KEY_COUNT; ++i) {
+        f32 value = attributes[i];
+        if (inverse_epsilon == 0.0) {
+            // -0 and 0 are the same vertex
+            u32 bits = 0;
+            if (value != 0.0f) {
+                kcopy_memory(&bits, &value, sizeof(f32));
+            }
+            out_key->values[i] = bits;
+        } else {
+            // in doubles, so big coordinates with a small epsilon don't lose the cell they are in
+            f64 cell = (f64)value * inverse_epsilon;
+            if (cell > 9.0e18) {
+                cell = 9.0e18;
+            } else if (cell < -9.0e18) {
+                cell = -9.0e18;
+            }
+            // rounded rather than floored, so values sitting on a multiple of epsilon (as exporters tend to write) are in
+            // the middle of a cell rather than on the edge of two
+            out_key->values[i] = (i64)(cell < 0.0 ? cell - 0.5 : cell + 0.5);
+        }
+    }
+}
+
+static b8 weld_keys_equal(const weld_key* a, const weld_key* b) {
+    for (u32 i = 0; i < WELD_KEY_COUNT; ++i) {
+        if (a->values[i] != b->values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void geometry_weld_vertices(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 epsilon, u32* out_vertex_count, vertex_3d** out_vertices, u32* out_remap) {
+    KPROFILE_SCOPE("geometry_weld_vertices");
+    f64 inverse_epsilon = epsilon > 0.0f ? 1.0 / (f64)epsilon : 0.0;
+
+    // open addressing, at most half full. each slot holds 1 + the first vertex seen with that key, or 0 if empty
+    u64 slot_count = 16;
+    while (slot_count < (u64)vertex_count * 2) {
+        slot_count *= 2;
+    }
+    u64 mask = slot_count - 1;
+    u32* slots = kallocate(sizeof(u32) * slot_count, MEMORY_TAG_ARRAY);
+    u32* remap = out_remap ? out_remap : kallocate(sizeof(u32) * (vertex_count ? vertex_count : 1), MEMORY_TAG_ARRAY);
+
+    // each vertex is looked up once, and either welded to the first one like it or becomes the next unique one
+    u32 unique_count = 0;
+    weld_key key;
+    weld_key other_key;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        weld_key_create(&vertices[v], inverse_epsilon, &key);
+        u64 slot = xxhash64(&key, sizeof(weld_key), 0) & mask;
+        while (slots[slot]) {
+            u32 other = slots[slot] - 1;
+            weld_key_create(&vertices[other], inverse_epsilon, &other_key);
+            if (weld_keys_equal(&key, &other_key)) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        if (slots[slot]) {
+            remap[v] = remap[slots[slot] - 1];
+        } else {
+            slots[slot] = v + 1;
+            remap[v] = unique_count++;
+        }
+    }
+
+    // unique vertices keep their first appearance's order, so the result doesn't depend on the hash
+    *out_vertices = kallocate(sizeof(vertex_3d) * (unique_count ? unique_count : 1), MEMORY_TAG_ARRAY);
+    u32 written = 0;
+    for (u32 v = 0; v < vertex_count && written < unique_count; ++v) {
+        if (remap[v] == written) {
+            (*out_vertices)[written++] = vertices[v];
+        }
+    }
+    for (u32 i = 0; i < index_count; ++i) {
+        indices[i] = remap[indices[i]];
+    }
+    *out_vertex_count = unique_count;
+
+    if (!out_remap) {
+        kfree(remap, sizeof(u32) * (vertex_count ? vertex_count : 1), MEMORY_TAG_ARRAY);
+    }
+    kfree(slots, sizeof(u32) * slot_count, MEMORY_TAG_ARRAY);
+}
+
+// NOTE: end welding
+
 // @brief de-duplicates vertices, leaving only unique ones. leaves the original vertices array intact. allocates a new array
 // in out_vertices. modifies indices in place. original vertex array should be freed by the caller
 // @param vertex_count the number of vertices in the array
@@ -95,37 +603,1445 @@ void reassign_index(u32 index_count, u32* indices, u32 from, u32 to) {
 // @param out_vertex_count a pointer to hold the final vertex count
 // @param out_vertices a pointer to hold the array of de-duplicated vertices
 void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices) {
-    // create new arrays for the collection to sit in
-    vertex_3d* unique_verts = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
-    *out_vertex_count = 0;
+    geometry_weld_vertices(vertex_count, vertices, index_count, indices, K_FLOAT_EPSILON, out_vertex_count, out_vertices, 0);
+
+    u32 removed_count = vertex_count - *out_vertex_count;
+    KDEBUG("geometry_deduplicate_vertices: removed %d vertices, orig/now %d/%d.", removed_count, vertex_count, *out_vertex_count);
+}
+
+// NOTE: begin mesh optimization
+
+// the cache forsyth's scoring models. an lru, bigger than any real fifo, which is fine as only the order matters
+#define FORSYTH_CACHE_SIZE 32
+// valences past this all score the same
+#define FORSYTH_MAX_VALENCE 32
+
+// the scores, from forsyth's "linear-speed vertex cache optimisation". a vertex scores for how recently it was used (the
+// last triangle's get a flat score, so they aren't always picked straight back up) and for how few triangles it has
+// left, so lone triangles get finished off rather than stranded
+typedef struct forsyth_scores {
+    f32 cache[FORSYTH_CACHE_SIZE];
+    f32 valence[FORSYTH_MAX_VALENCE + 1];
+} forsyth_scores;
+
+static void forsyth_scores_create(forsyth_scores* out_scores) {
+    for (u32 i = 0; i < FORSYTH_CACHE_SIZE; ++i) {
+        if (i < 3) {
+            out_scores->cache[i] = 0.75f;
+        } else {
+            // (1 - (position - 3) / (size - 3)) ^ 1.5
+            f32 scaler = 1.0f - (f32)(i - 3) / (f32)(FORSYTH_CACHE_SIZE - 3);
+            out_scores->cache[i] = scaler * ksqrt(scaler);
+        }
+    }
+    out_scores->valence[0] = 0.0f;
+    for (u32 i = 1; i <= FORSYTH_MAX_VALENCE; ++i) {
+        // 2 * valence ^ -0.5
+        out_scores->valence[i] = 2.0f / ksqrt((f32)i);
+    }
+}
+
+static f32 forsyth_vertex_score(const forsyth_scores* scores, i32 cache_position, u32 remaining) {
+    if (remaining == 0) {
+        // no triangles left to draw with it
+        return -1.0f;
+    }
+    f32 score = cache_position >= 0 ? scores->cache[cache_position] : 0.0f;
+    return score + scores->valence[remaining < FORSYTH_MAX_VALENCE ? remaining : FORSYTH_MAX_VALENCE];
+}
+
+void geometry_optimize_vertex_cache(u32 vertex_count, u32 index_count, u32* indices) {
+    KPROFILE_SCOPE("geometry_optimize_vertex_cache");
+    u32 triangle_count = index_count / 3;
+    if (triangle_count < 2 || vertex_count == 0) {
+        return;
+    }
+    forsyth_scores scores;
+    forsyth_scores_create(&scores);
 
-    u32 found_count = 0;
+    // the triangles using each vertex. the first remaining[v] of each vertex's run are the ones not yet drawn
+    u32* offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    u32* remaining = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* adjacency = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        remaining[indices[i]]++;
+    }
     for (u32 v = 0; v < vertex_count; ++v) {
-        b8 found = false;
-        for (u32 u = 0; u < *out_vertex_count; ++u) {
-            if (vertex3d_equal(vertices[v], unique_verts[u])) {
-                // reassign indices, DO NOT COPY
-                reassign_index(index_count, indices, v - found_count, u);
-                found = true;
-                found_count++;
+        offsets[v + 1] = offsets[v] + remaining[v];
+        remaining[v] = 0;
+    }
+    for (u32 t = 0; t < triangle_count; ++t) {
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = indices[t * 3 + c];
+            adjacency[offsets[v] + remaining[v]++] = t;
+        }
+    }
+
+    i32* cache_positions = kallocate(sizeof(i32) * vertex_count, MEMORY_TAG_ARRAY);
+    f32* vertex_scores = kallocate(sizeof(f32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        cache_positions[v] = -1;
+        vertex_scores[v] = forsyth_vertex_score(&scores, -1, remaining[v]);
+    }
+    f32* triangle_scores = kallocate(sizeof(f32) * triangle_count, MEMORY_TAG_ARRAY);
+    b8* drawn = kallocate(sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    u32 best = INVALID_ID;
+    f32 best_score = -1.0f;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        const u32* tri = &indices[t * 3];
+        triangle_scores[t] = vertex_scores[tri[0]] + vertex_scores[tri[1]] + vertex_scores[tri[2]];
+        if (triangle_scores[t] > best_score) {
+            best_score = triangle_scores[t];
+            best = t;
+        }
+    }
+
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    u32 cache[FORSYTH_CACHE_SIZE + 3];
+    u32 new_cache[FORSYTH_CACHE_SIZE + 3];
+    u32 cache_count = 0;
+    u32 cursor = 0;
+    for (u32 out = 0; out < triangle_count; ++out) {
+        if (best == INVALID_ID) {
+            // nothing in the cache is worth carrying on from, so pick up the input where it was left. keeps this linear,
+            // rather than searching every triangle each time a piece of the mesh is finished
+            while (drawn[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const u32* tri = &indices[best * 3];
+        output[out * 3 + 0] = tri[0];
+        output[out * 3 + 1] = tri[1];
+        output[out * 3 + 2] = tri[2];
+        drawn[best] = true;
+
+        // the triangle's vertices go to the front of the cache, pushing the rest back
+        u32 new_count = 0;
+        for (u32 c = 0; c < 3; ++c) {
+            u32 v = tri[c];
+            new_cache[new_count++] = v;
+            // no longer waiting to be drawn with this vertex
+            u32* run = &adjacency[offsets[v]];
+            for (u32 i = 0; i < remaining[v]; ++i) {
+                if (run[i] == best) {
+                    run[i] = run[remaining[v] - 1];
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+        for (u32 i = 0; i < cache_count; ++i) {
+            u32 v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                new_cache[new_count++] = v;
+            }
+        }
+
+        // rescore everything that was or is in the cache, then the triangles using them. the best of those is next
+        for (u32 i = 0; i < new_count; ++i) {
+            u32 v = new_cache[i];
+            cache_positions[v] = i < FORSYTH_CACHE_SIZE ? (i32)i : -1;
+            vertex_scores[v] = forsyth_vertex_score(&scores, cache_positions[v], remaining[v]);
+        }
+        best = INVALID_ID;
+        best_score = -1.0f;
+        for (u32 i = 0; i < new_count; ++i) {
+            u32 v = new_cache[i];
+            const u32* run = &adjacency[offsets[v]];
+            for (u32 j = 0; j < remaining[v]; ++j) {
+                u32 t = run[j];
+                const u32* other = &indices[t * 3];
+                f32 score = vertex_scores[other[0]] + vertex_scores[other[1]] + vertex_scores[other[2]];
+                triangle_scores[t] = score;
+                if (score > best_score || (score == best_score && t < best)) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = new_count < FORSYTH_CACHE_SIZE ? new_count : FORSYTH_CACHE_SIZE;
+        kcopy_memory(cache, new_cache, sizeof(u32) * cache_count);
+    }
+
+    kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(drawn, sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(triangle_scores, sizeof(f32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(vertex_scores, sizeof(f32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(cache_positions, sizeof(i32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(remaining, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+}
+
+// a fifo cache, simulated with a timestamp per vertex that goes up on every miss. a vertex is still in the cache if
+// fewer than cache_size misses have happened since it was last loaded. returns the number of misses for the triangle
+static u32 fifo_cache_triangle(const u32* tri, u32* timestamps, u32* timestamp, u32 cache_size) {
+    u32 misses = 0;
+    for (u32 c = 0; c < 3; ++c) {
+        u32 v = tri[c];
+        if (*timestamp - timestamps[v] > cache_size) {
+            timestamps[v] = (*timestamp)++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+void geometry_analyze_vertex_cache(u32 vertex_count, u32 index_count, const u32* indices, u32 cache_size, geometry_cache_stats* out_stats) {
+    out_stats->acmr = 0.0f;
+    out_stats->atvr = 0.0f;
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || vertex_count == 0) {
+        return;
+    }
+    u32* timestamps = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    // starting past the cache size, so every vertex starts out missing
+    u32 timestamp = cache_size + 1;
+    u64 misses = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        misses += fifo_cache_triangle(&indices[t * 3], timestamps, &timestamp, cache_size);
+    }
+    kfree(timestamps, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    out_stats->acmr = (f32)misses / (f32)triangle_count;
+    out_stats->atvr = (f32)misses / (f32)vertex_count;
+}
+
+typedef struct overdraw_cluster {
+    u32 start;
+    u32 count;
+    f32 sort_key;
+} overdraw_cluster;
+
+void geometry_optimize_overdraw(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 threshold) {
+    KPROFILE_SCOPE("geometry_optimize_overdraw");
+    u32 triangle_count = index_count / 3;
+    if (triangle_count < 2 || vertex_count == 0) {
+        return;
+    }
+
+    // hard boundaries are where the cache optimized order starts afresh (every vertex of the triangle misses), so the
+    // order can be broken there at no cost
+    u32* timestamps = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    b8* hard_boundaries = kallocate(sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    u32 timestamp = GEOMETRY_FIFO_CACHE_SIZE + 1;
+    u64 total_misses = 0;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 misses = fifo_cache_triangle(&indices[t * 3], timestamps, &timestamp, GEOMETRY_FIFO_CACHE_SIZE);
+        hard_boundaries[t] = misses == 3;
+        total_misses += misses;
+    }
+    f32 limit = ((f32)total_misses / (f32)triangle_count) * threshold;
+
+    // soft boundaries are the hard ones where the cluster so far, drawn from a cold cache, is still within threshold of
+    // the whole mesh. larger clusters cost less cache efficiency when they are moved around
+    overdraw_cluster* clusters = kallocate(sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+    u32 cluster_count = 0;
+    u32 cluster_start = 0;
+    u64 cluster_misses = 0;
+    timestamp += GEOMETRY_FIFO_CACHE_SIZE + 1;
+    for (u32 t = 0; t < triangle_count; ++t) {
+        if (t > cluster_start && hard_boundaries[t] && (f32)cluster_misses / (f32)(t - cluster_start) <= limit) {
+            clusters[cluster_count].start = cluster_start;
+            clusters[cluster_count].count = t - cluster_start;
+            cluster_count++;
+            cluster_start = t;
+            cluster_misses = 0;
+            // cold cache for the next one
+            timestamp += GEOMETRY_FIFO_CACHE_SIZE + 1;
+        }
+        cluster_misses += fifo_cache_triangle(&indices[t * 3], timestamps, &timestamp, GEOMETRY_FIFO_CACHE_SIZE);
+    }
+    clusters[cluster_count].start = cluster_start;
+    clusters[cluster_count].count = triangle_count - cluster_start;
+    cluster_count++;
+    kfree(hard_boundaries, sizeof(b8) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(timestamps, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    // clusters on the outside facing outward are drawn first, as they are the most likely to hide the rest. that is
+    // the area weighted centroid of each, against the centroid of the mesh, along the cluster's average normal
+    vec3* centroids = kallocate(sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+    vec3* normals = kallocate(sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+    vec3 mesh_centroid = vec3_zero();
+    f32 mesh_area = 0.0f;
+    for (u32 c = 0; c < cluster_count; ++c) {
+        vec3 centroid = vec3_zero();
+        vec3 normal = vec3_zero();
+        f32 area = 0.0f;
+        for (u32 t = clusters[c].start; t < clusters[c].start + clusters[c].count; ++t) {
+            vec3 p0 = vertices[indices[t * 3 + 0]].position;
+            vec3 p1 = vertices[indices[t * 3 + 1]].position;
+            vec3 p2 = vertices[indices[t * 3 + 2]].position;
+            // twice the area, in the length of the cross product
+            vec3 cross = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+            f32 triangle_area = vec3_length(cross);
+            centroid = vec3_add(centroid, vec3_mul_scalar(vec3_add(vec3_add(p0, p1), p2), triangle_area / 3.0f));
+            normal = vec3_add(normal, cross);
+            area += triangle_area;
+        }
+        mesh_centroid = vec3_add(mesh_centroid, centroid);
+        mesh_area += area;
+        centroids[c] = area > 0.0f ? vec3_mul_scalar(centroid, 1.0f / area) : centroid;
+        f32 normal_length = vec3_length(normal);
+        normals[c] = normal_length > 0.0f ? vec3_mul_scalar(normal, 1.0f / normal_length) : normal;
+    }
+    mesh_centroid = mesh_area > 0.0f ? vec3_mul_scalar(mesh_centroid, 1.0f / mesh_area) : mesh_centroid;
+    for (u32 c = 0; c < cluster_count; ++c) {
+        clusters[c].sort_key = vec3_dot(vec3_sub(centroids[c], mesh_centroid), normals[c]);
+    }
+    kfree(normals, sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+    kfree(centroids, sizeof(vec3) * cluster_count, MEMORY_TAG_ARRAY);
+
+    // a stable merge sort, highest key first, so the order is the same everywhere
+    overdraw_cluster* scratch = kallocate(sizeof(overdraw_cluster) * cluster_count, MEMORY_TAG_ARRAY);
+    for (u32 width = 1; width < cluster_count; width *= 2) {
+        for (u32 left = 0; left < cluster_count; left += width * 2) {
+            u32 middle = left + width < cluster_count ? left + width : cluster_count;
+            u32 right = left + width * 2 < cluster_count ? left + width * 2 : cluster_count;
+            u32 a = left;
+            u32 b = middle;
+            for (u32 i = left; i < right; ++i) {
+                if (a < middle && (b >= right || clusters[a].sort_key >= clusters[b].sort_key)) {
+                    scratch[i] = clusters[a++];
+                } else {
+                    scratch[i] = clusters[b++];
+                }
+            }
+        }
+        kcopy_memory(clusters, scratch, sizeof(overdraw_cluster) * cluster_count);
+    }
+    kfree(scratch, sizeof(overdraw_cluster) * cluster_count, MEMORY_TAG_ARRAY);
+
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    u32 written = 0;
+    for (u32 c = 0; c < cluster_count; ++c) {
+        kcopy_memory(&output[written], &indices[clusters[c].start * 3], sizeof(u32) * clusters[c].count * 3);
+        written += clusters[c].count * 3;
+    }
+    kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(clusters, sizeof(overdraw_cluster) * triangle_count, MEMORY_TAG_ARRAY);
+}
+
+void geometry_optimize_vertex_fetch(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices) {
+    KPROFILE_SCOPE("geometry_optimize_vertex_fetch");
+    if (vertex_count == 0) {
+        return;
+    }
+    // numbered in the order the indices first use them, then any that aren't used at all
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        remap[v] = INVALID_ID;
+    }
+    u32 next = 0;
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 v = indices[i];
+        if (remap[v] == INVALID_ID) {
+            remap[v] = next++;
+        }
+        indices[i] = remap[v];
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        if (remap[v] == INVALID_ID) {
+            remap[v] = next++;
+        }
+    }
+
+    vertex_3d* reordered = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        reordered[remap[v]] = vertices[v];
+    }
+    kcopy_memory(vertices, reordered, sizeof(vertex_3d) * vertex_count);
+    kfree(reordered, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+}
+
+// NOTE: end mesh optimization
+
+// NOTE: begin simplification
+
+// the sum of the squared distances to a set of planes, each weighted by the area of the triangle it came from. a plane
+// n.p + d = 0 adds weight * (n n^T, n d, d^2), and the sum at a point p is p^T A p + 2 b.p + c. kept in doubles, as the
+// terms mostly cancel out
+typedef struct quadric {
+    f64 a00, a11, a22, a01, a02, a12;
+    f64 b0, b1, b2;
+    f64 c;
+    f64 weight;
+} quadric;
+
+static void quadric_add_plane(quadric* q, vec3 normal, f32 d, f32 weight) {
+    f64 x = normal.x;
+    f64 y = normal.y;
+    f64 z = normal.z;
+    f64 w = weight;
+    q->a00 += w * x * x;
+    q->a11 += w * y * y;
+    q->a22 += w * z * z;
+    q->a01 += w * x * y;
+    q->a02 += w * x * z;
+    q->a12 += w * y * z;
+    q->b0 += w * x * d;
+    q->b1 += w * y * d;
+    q->b2 += w * z * d;
+    q->c += w * d * d;
+    q->weight += w;
+}
+
+static void quadric_add(quadric* q, const quadric* other) {
+    q->a00 += other->a00;
+    q->a11 += other->a11;
+    q->a22 += other->a22;
+    q->a01 += other->a01;
+    q->a02 += other->a02;
+    q->a12 += other->a12;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->weight += other->weight;
+}
+
+// the average squared distance from p to the planes, which makes the error independent of how finely the mesh is cut up
+static f64 quadric_error(const quadric* q, vec3 p) {
+    if (q->weight <= 0.0) {
+        return 0.0;
+    }
+    f64 x = p.x;
+    f64 y = p.y;
+    f64 z = p.z;
+    f64 error = x * x * q->a00 + y * y * q->a11 + z * z * q->a22 + 2.0 * (x * y * q->a01 + x * z * q->a02 + y * z * q->a12) +
+                2.0 * (x * q->b0 + y * q->b1 + z * q->b2) + q->c;
+    return error > 0.0 ? error / q->weight : 0.0;
+}
+
+// numbers each vertex by the first vertex with exactly the same position, so the vertices either side of a seam are
+// seen as the one point they are
+static void position_remap(u32 vertex_count, const vertex_3d* vertices, u32* out_remap) {
+    u64 slot_count = 16;
+    while (slot_count < (u64)vertex_count * 2) {
+        slot_count *= 2;
+    }
+    u64 mask = slot_count - 1;
+    // 1 + the vertex, or 0 if empty
+    u32* slots = kallocate(sizeof(u32) * slot_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        // -0 and 0 are the same place
+        vec3 p = vertices[v].position;
+        p.x = p.x == 0.0f ? 0.0f : p.x;
+        p.y = p.y == 0.0f ? 0.0f : p.y;
+        p.z = p.z == 0.0f ? 0.0f : p.z;
+        u64 slot = xxhash64(&p, sizeof(vec3), 0) & mask;
+        while (slots[slot]) {
+            vec3 other = vertices[slots[slot] - 1].position;
+            if (other.x == p.x && other.y == p.y && other.z == p.z) {
                 break;
             }
+            slot = (slot + 1) & mask;
         }
+        if (!slots[slot]) {
+            slots[slot] = v + 1;
+        }
+        out_remap[v] = slots[slot] - 1;
+    }
+    kfree(slots, sizeof(u32) * slot_count, MEMORY_TAG_ARRAY);
+}
+
+// counts of directed edges between positions, in an open addressed table at most half full
+typedef struct simplify_edge_table {
+    u64* keys;
+    u32* counts;
+    u64 slot_count;
+} simplify_edge_table;
 
-        if (!found) {
-            // copy over to unique.
-            unique_verts[*out_vertex_count] = vertices[v];
-            (*out_vertex_count)++;
+#define SIMPLIFY_EMPTY_EDGE ((u64)-1)
+
+static u32* simplify_edge_count(simplify_edge_table* table, u32 from, u32 to, b8 insert) {
+    u64 key = ((u64)from << 32) | to;
+    u64 mask = table->slot_count - 1;
+    u64 slot = xxhash64(&key, sizeof(u64), 0) & mask;
+    while (table->keys[slot] != SIMPLIFY_EMPTY_EDGE) {
+        if (table->keys[slot] == key) {
+            return &table->counts[slot];
         }
+        slot = (slot + 1) & mask;
+    }
+    if (!insert) {
+        return 0;
     }
+    table->keys[slot] = key;
+    return &table->counts[slot];
+}
 
-    // allocate new vertices array
-    *out_vertices = kallocate(sizeof(vertex_3d) * (*out_vertex_count), MEMORY_TAG_ARRAY);
-    // copy over unique
-    kcopy_memory(*out_vertices, unique_verts, sizeof(vertex_3d) * (*out_vertex_count));
-    // destroy temp array
-    kfree(unique_verts, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+// locks every position that can't be collapsed safely. that is the seams, where more than one vertex has the position,
+// and the positions on an edge that isn't shared by exactly two triangles, one each way round (open borders, and
+// anything non manifold)
+static void simplify_lock_positions(u32 vertex_count, u32 index_count, const u32* indices, const u32* positions, b8* out_locked) {
+    u32* wedge_counts = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        wedge_counts[positions[v]]++;
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        out_locked[v] = wedge_counts[v] > 1;
+    }
+    kfree(wedge_counts, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
 
-    u32 removed_count = vertex_count - *out_vertex_count;
-    KDEBUG("geometry_deduplicate_vertices: removed %d vertices, orig/now %d%d.", removed_count, vertex_count, *out_vertex_count);
-}
\ No newline at end of file
+    simplify_edge_table table;
+    table.slot_count = 16;
+    while (table.slot_count < (u64)index_count * 2) {
+        table.slot_count *= 2;
+    }
+    table.keys = kallocate(sizeof(u64) * table.slot_count, MEMORY_TAG_ARRAY);
+    table.counts = kallocate(sizeof(u32) * table.slot_count, MEMORY_TAG_ARRAY);
+    for (u64 i = 0; i < table.slot_count; ++i) {
+        table.keys[i] = SIMPLIFY_EMPTY_EDGE;
+    }
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 from = positions[indices[i]];
+        u32 to = positions[indices[i % 3 == 2 ? i - 2 : i + 1]];
+        if (from != to) {
+            (*simplify_edge_count(&table, from, to, true))++;
+        }
+    }
+    for (u32 i = 0; i < index_count; ++i) {
+        u32 from = positions[indices[i]];
+        u32 to = positions[indices[i % 3 == 2 ? i - 2 : i + 1]];
+        if (from == to) {
+            continue;
+        }
+        u32* forward = simplify_edge_count(&table, from, to, false);
+        u32* back = simplify_edge_count(&table, to, from, false);
+        if (*forward != 1 || !back || *back != 1) {
+            out_locked[from] = true;
+            out_locked[to] = true;
+        }
+    }
+    kfree(table.counts, sizeof(u32) * table.slot_count, MEMORY_TAG_ARRAY);
+    kfree(table.keys, sizeof(u64) * table.slot_count, MEMORY_TAG_ARRAY);
+}
+
+// true if collapsing v0 onto v1 would turn any of v0's triangles that stay over, or stand one on its edge
+static b8 simplify_collapse_flips(const vertex_3d* vertices, const u32* indices, const u32* triangles, u32 triangle_count, u32 v0, u32 v1) {
+    vec3 p0 = vertices[v0].position;
+    vec3 p1 = vertices[v1].position;
+    for (u32 i = 0; i < triangle_count; ++i) {
+        const u32* tri = &indices[triangles[i] * 3];
+        if (tri[0] == v1 || tri[1] == v1 || tri[2] == v1) {
+            // goes away with the edge
+            continue;
+        }
+        u32 corner = tri[0] == v0 ? 0 : (tri[1] == v0 ? 1 : 2);
+        vec3 a = vertices[tri[(corner + 1) % 3]].position;
+        vec3 b = vertices[tri[(corner + 2) % 3]].position;
+        vec3 before = vec3_cross(vec3_sub(a, p0), vec3_sub(b, p0));
+        vec3 after = vec3_cross(vec3_sub(a, p1), vec3_sub(b, p1));
+        // more than about 75 degrees of turn is as good as over
+        if (vec3_dot(before, after) <= 0.25f * vec3_length(before) * vec3_length(after)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct simplify_collapse {
+    u32 vertex;
+    u32 target;
+    f64 cost;
+} simplify_collapse;
+
+u32 geometry_simplify(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 target_index_count, f32 target_error, u32* out_indices, f32* out_error) {
+    KPROFILE_SCOPE("geometry_simplify");
+    index_count -= index_count % 3;
+    kcopy_memory(out_indices, indices, sizeof(u32) * index_count);
+    if (out_error) {
+        *out_error = 0.0f;
+    }
+    if (vertex_count == 0 || index_count <= target_index_count) {
+        return index_count;
+    }
+
+    u32* positions = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    position_remap(vertex_count, vertices, positions);
+    b8* locked = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    simplify_lock_positions(vertex_count, index_count, out_indices, positions, locked);
+
+    // the planes of the triangles around each position
+    quadric* quadrics = kallocate(sizeof(quadric) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < index_count; i += 3) {
+        vec3 p0 = vertices[out_indices[i + 0]].position;
+        vec3 p1 = vertices[out_indices[i + 1]].position;
+        vec3 p2 = vertices[out_indices[i + 2]].position;
+        vec3 cross = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+        f32 length = vec3_length(cross);
+        if (length <= 0.0f) {
+            continue;
+        }
+        vec3 normal = vec3_mul_scalar(cross, 1.0f / length);
+        f32 d = -vec3_dot(normal, p0);
+        for (u32 c = 0; c < 3; ++c) {
+            quadric_add_plane(&quadrics[positions[out_indices[i + c]]], normal, d, length * 0.5f);
+        }
+    }
+
+    u32* offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    u32* counts = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    // indices only ever go down, so sized for the first pass
+    u32 adjacency_size = index_count;
+    u32* adjacency = kallocate(sizeof(u32) * adjacency_size, MEMORY_TAG_ARRAY);
+    simplify_collapse* collapses = kallocate(sizeof(simplify_collapse) * vertex_count, MEMORY_TAG_ARRAY);
+    simplify_collapse* scratch = kallocate(sizeof(simplify_collapse) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* remap = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    b8* touched = kallocate(sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    f64 error_limit = (f64)target_error * (f64)target_error;
+    f64 max_error = 0.0;
+
+    // each pass collapses the cheapest edges it can without them touching, then the costs are worked out afresh
+    while (index_count > target_index_count) {
+        // the triangles around each vertex
+        kzero_memory(counts, sizeof(u32) * vertex_count);
+        for (u32 i = 0; i < index_count; ++i) {
+            counts[out_indices[i]]++;
+        }
+        for (u32 v = 0; v < vertex_count; ++v) {
+            offsets[v + 1] = offsets[v] + counts[v];
+            counts[v] = 0;
+        }
+        for (u32 i = 0; i < index_count; ++i) {
+            u32 v = out_indices[i];
+            adjacency[offsets[v] + counts[v]++] = i / 3;
+        }
+
+        // the cheapest edge to collapse each unlocked vertex along, of those that turn nothing over. collapsing onto v1
+        // costs the distance from v1 to the planes v0 had, and so on down from the original triangles
+        for (u32 v = 0; v < vertex_count; ++v) {
+            collapses[v].vertex = v;
+            collapses[v].target = INVALID_ID;
+            collapses[v].cost = 0.0;
+        }
+        for (u32 i = 0; i < index_count; ++i) {
+            u32 v0 = out_indices[i];
+            if (locked[positions[v0]]) {
+                continue;
+            }
+            u32 first = i - i % 3;
+            for (u32 c = 1; c < 3; ++c) {
+                u32 v1 = out_indices[first + (i - first + c) % 3];
+                f64 cost = quadric_error(&quadrics[positions[v0]], vertices[v1].position);
+                simplify_collapse* best = &collapses[v0];
+                if (best->target != INVALID_ID && (cost > best->cost || (cost == best->cost && v1 >= best->target))) {
+                    continue;
+                }
+                if (!simplify_collapse_flips(vertices, out_indices, &adjacency[offsets[v0]], offsets[v0 + 1] - offsets[v0], v0, v1)) {
+                    best->target = v1;
+                    best->cost = cost;
+                }
+            }
+        }
+        u32 collapse_count = 0;
+        for (u32 v = 0; v < vertex_count; ++v) {
+            if (collapses[v].target != INVALID_ID && collapses[v].cost <= error_limit) {
+                collapses[collapse_count++] = collapses[v];
+            }
+        }
+        if (collapse_count == 0) {
+            break;
+        }
+
+        // a stable merge sort, cheapest first, so ties go in vertex order
+        for (u32 width = 1; width < collapse_count; width *= 2) {
+            for (u32 left = 0; left < collapse_count; left += width * 2) {
+                u32 middle = left + width < collapse_count ? left + width : collapse_count;
+                u32 right = left + width * 2 < collapse_count ? left + width * 2 : collapse_count;
+                u32 a = left;
+                u32 b = middle;
+                for (u32 i = left; i < right; ++i) {
+                    if (a < middle && (b >= right || collapses[a].cost <= collapses[b].cost)) {
+                        scratch[i] = collapses[a++];
+                    } else {
+                        scratch[i] = collapses[b++];
+                    }
+                }
+            }
+            kcopy_memory(collapses, scratch, sizeof(simplify_collapse) * collapse_count);
+        }
+
+        // once a vertex collapses, nothing else around it does this pass, so the mesh around every other collapse is
+        // still as it was when it was checked for flips
+        for (u32 v = 0; v < vertex_count; ++v) {
+            remap[v] = v;
+            touched[v] = false;
+        }
+        u32 triangles_to_remove = (index_count - target_index_count + 2) / 3;
+        u32 removed = 0;
+        u32 collapsed = 0;
+        for (u32 i = 0; i < collapse_count && removed < triangles_to_remove; ++i) {
+            u32 v0 = collapses[i].vertex;
+            u32 v1 = collapses[i].target;
+            if (touched[v0] || touched[v1]) {
+                continue;
+            }
+            const u32* triangles = &adjacency[offsets[v0]];
+            u32 triangle_count = offsets[v0 + 1] - offsets[v0];
+            remap[v0] = v1;
+            quadric_add(&quadrics[positions[v1]], &quadrics[positions[v0]]);
+            max_error = collapses[i].cost > max_error ? collapses[i].cost : max_error;
+            collapsed++;
+            touched[v1] = true;
+            for (u32 t = 0; t < triangle_count; ++t) {
+                const u32* tri = &out_indices[triangles[t] * 3];
+                touched[tri[0]] = true;
+                touched[tri[1]] = true;
+                touched[tri[2]] = true;
+                if (tri[0] == v1 || tri[1] == v1 || tri[2] == v1) {
+                    removed++;
+                }
+            }
+        }
+        if (collapsed == 0) {
+            break;
+        }
+
+        // the collapsed edges' triangles now have two corners the same, and are dropped
+        u32 written = 0;
+        for (u32 i = 0; i < index_count; i += 3) {
+            u32 a = remap[out_indices[i + 0]];
+            u32 b = remap[out_indices[i + 1]];
+            u32 c = remap[out_indices[i + 2]];
+            if (a != b && b != c && a != c) {
+                out_indices[written++] = a;
+                out_indices[written++] = b;
+                out_indices[written++] = c;
+            }
+        }
+        index_count = written;
+    }
+
+    kfree(touched, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(remap, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(scratch, sizeof(simplify_collapse) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(collapses, sizeof(simplify_collapse) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency, sizeof(u32) * adjacency_size, MEMORY_TAG_ARRAY);
+    kfree(counts, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(quadrics, sizeof(quadric) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(locked, sizeof(b8) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(positions, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    if (out_error) {
+        *out_error = (f32)ksqrt((f32)max_error);
+    }
+    return index_count;
+}
+
+// NOTE: end simplification
+
+// NOTE: begin meshlets
+
+// meshlets are grown a triangle at a time from the first triangle not yet in one, always taking a neighbour (sharing a
+// position) that fits. those adding the fewest new vertices go first, then those nearest the meshlet that face the
+// same way, so meshlets come out round and flat, which is what culls well. a meshlet is finished once it is full, or no
+// neighbour fits
+
+// a sphere around the meshlet's vertices, and a cone around the directions its triangles face. the sphere is centered
+// on their bounding box, which is a little larger than the smallest sphere, but the same every time
+static void meshlet_bounds(const vertex_3d* vertices, const u32* indices, geometry_meshlet* meshlet) {
+    vec3 min_extents = vertices[indices[0]].position;
+    vec3 max_extents = min_extents;
+    for (u32 i = 1; i < meshlet->index_count; ++i) {
+        vec3 p = vertices[indices[i]].position;
+        for (u32 c = 0; c < 3; ++c) {
+            min_extents.elements[c] = p.elements[c] < min_extents.elements[c] ? p.elements[c] : min_extents.elements[c];
+            max_extents.elements[c] = p.elements[c] > max_extents.elements[c] ? p.elements[c] : max_extents.elements[c];
+        }
+    }
+    meshlet->center = vec3_mul_scalar(vec3_add(min_extents, max_extents), 0.5f);
+    f32 radius_squared = 0.0f;
+    for (u32 i = 0; i < meshlet->index_count; ++i) {
+        vec3 d = vec3_sub(vertices[indices[i]].position, meshlet->center);
+        f32 distance_squared = vec3_dot(d, d);
+        radius_squared = distance_squared > radius_squared ? distance_squared : radius_squared;
+    }
+    meshlet->radius = ksqrt(radius_squared);
+
+    // the cone's axis is the average direction, and it is as wide as the triangle furthest from that. the cutoff is the
+    // sine of that angle, which is the cosine of the widest the direction to the camera can be from the axis while
+    // still seeing only backs (the angle plus 90 degrees, turned round)
+    vec3 axis = vec3_zero();
+    for (u32 i = 0; i < meshlet->index_count; i += 3) {
+        vec3 p0 = vertices[indices[i + 0]].position;
+        vec3 normal = vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0));
+        f32 length = vec3_length(normal);
+        if (length > 0.0f) {
+            axis = vec3_add(axis, vec3_mul_scalar(normal, 1.0f / length));
+        }
+    }
+    f32 axis_length = vec3_length(axis);
+    meshlet->cone_axis = axis_length > 0.0f ? vec3_mul_scalar(axis, 1.0f / axis_length) : vec3_create(0.0f, 0.0f, 1.0f);
+    meshlet->cone_cutoff = 1.0f;
+    if (axis_length == 0.0f) {
+        return;
+    }
+    f32 min_dot = 1.0f;
+    for (u32 i = 0; i < meshlet->index_count; i += 3) {
+        vec3 p0 = vertices[indices[i + 0]].position;
+        vec3 normal = vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0));
+        f32 length = vec3_length(normal);
+        if (length > 0.0f) {
+            f32 d = vec3_dot(normal, meshlet->cone_axis) / length;
+            min_dot = d < min_dot ? d : min_dot;
+        }
+    }
+    // at 90 degrees or more, some triangle faces every camera
+    if (min_dot > 0.0f) {
+        meshlet->cone_cutoff = ksqrt(1.0f - min_dot * min_dot);
+    }
+}
+
+u32 geometry_build_meshlets(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, u32 max_vertices, u32 max_triangles, geometry_meshlet* out_meshlets) {
+    KPROFILE_SCOPE("geometry_build_meshlets");
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0 || vertex_count == 0) {
+        return 0;
+    }
+    max_vertices = max_vertices < 3 ? 3 : max_vertices;
+    max_triangles = max_triangles < 1 ? 1 : max_triangles;
+
+    // the triangles around each position, so neighbours are found across seams
+    u32* positions = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    position_remap(vertex_count, vertices, positions);
+    u32* adjacency_offsets = kallocate(sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    u32* adjacency = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        adjacency_offsets[positions[indices[i]] + 1]++;
+    }
+    for (u32 v = 0; v < vertex_count; ++v) {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+    }
+    u32* adjacency_fill = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < triangle_count * 3; ++i) {
+        u32 p = positions[indices[i]];
+        adjacency[adjacency_offsets[p] + adjacency_fill[p]++] = i / 3;
+    }
+    kfree(adjacency_fill, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    vec3* centroids = kallocate(sizeof(vec3) * triangle_count, MEMORY_TAG_ARRAY);
+    vec3* normals = kallocate(sizeof(vec3) * triangle_count, MEMORY_TAG_ARRAY);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        vec3 p0 = vertices[indices[t * 3 + 0]].position;
+        vec3 p1 = vertices[indices[t * 3 + 1]].position;
+        vec3 p2 = vertices[indices[t * 3 + 2]].position;
+        centroids[t] = vec3_mul_scalar(vec3_add(vec3_add(p0, p1), p2), 1.0f / 3.0f);
+        vec3 normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+        f32 length = vec3_length(normal);
+        normals[t] = length > 0.0f ? vec3_mul_scalar(normal, 1.0f / length) : vec3_zero();
+    }
+
+    // 1 + the meshlet each triangle is in, or was last a candidate for, and each vertex was last counted in. 0 for none
+    u32* triangle_meshlets = kallocate(sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    u32* candidate_meshlets = kallocate(sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    u32* vertex_meshlets = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* candidates = kallocate(sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    u32* meshlet_triangle_counts = kallocate(sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+
+    u32 meshlet_count = 0;
+    u32 first_free = 0;
+    while (true) {
+        while (first_free < triangle_count && triangle_meshlets[first_free]) {
+            first_free++;
+        }
+        if (first_free == triangle_count) {
+            break;
+        }
+
+        u32 id = meshlet_count + 1;
+        u32 meshlet_vertex_count = 0;
+        u32 meshlet_triangle_count = 0;
+        u32 candidate_count = 0;
+        vec3 centroid_sum = vec3_zero();
+        vec3 normal_sum = vec3_zero();
+        u32 next = first_free;
+        while (next != INVALID_ID) {
+            triangle_meshlets[next] = id;
+            meshlet_triangle_count++;
+            centroid_sum = vec3_add(centroid_sum, centroids[next]);
+            normal_sum = vec3_add(normal_sum, normals[next]);
+            for (u32 c = 0; c < 3; ++c) {
+                u32 v = indices[next * 3 + c];
+                if (vertex_meshlets[v] != id) {
+                    vertex_meshlets[v] = id;
+                    meshlet_vertex_count++;
+                }
+                u32 p = positions[v];
+                for (u32 a = adjacency_offsets[p]; a < adjacency_offsets[p + 1]; ++a) {
+                    u32 t = adjacency[a];
+                    if (!triangle_meshlets[t] && candidate_meshlets[t] != id) {
+                        candidate_meshlets[t] = id;
+                        candidates[candidate_count++] = t;
+                    }
+                }
+            }
+            if (meshlet_triangle_count == max_triangles) {
+                break;
+            }
+
+            vec3 center = vec3_mul_scalar(centroid_sum, 1.0f / (f32)meshlet_triangle_count);
+            f32 normal_length = vec3_length(normal_sum);
+            vec3 axis = normal_length > 0.0f ? vec3_mul_scalar(normal_sum, 1.0f / normal_length) : vec3_zero();
+            next = INVALID_ID;
+            u32 best_new_count = 4;
+            f32 best_cost = 0.0f;
+            u32 kept = 0;
+            for (u32 i = 0; i < candidate_count; ++i) {
+                u32 t = candidates[i];
+                if (triangle_meshlets[t]) {
+                    continue;
+                }
+                candidates[kept++] = t;
+                u32 new_count = 0;
+                for (u32 c = 0; c < 3; ++c) {
+                    new_count += vertex_meshlets[indices[t * 3 + c]] != id;
+                }
+                if (meshlet_vertex_count + new_count > max_vertices) {
+                    continue;
+                }
+                // further for facing another way, from 1x the distance facing the same way to 3x facing the opposite
+                f32 cost = vec3_distance(centroids[t], center) * (2.0f - vec3_dot(normals[t], axis));
+                if (new_count < best_new_count || (new_count == best_new_count && (cost < best_cost || (cost == best_cost && t < next)))) {
+                    next = t;
+                    best_new_count = new_count;
+                    best_cost = cost;
+                }
+            }
+            candidate_count = kept;
+        }
+        meshlet_triangle_counts[meshlet_count++] = meshlet_triangle_count;
+    }
+
+    // each meshlet's triangles together, meshlets in the order they were made and triangles in the order they were in.
+    // both follow the order the triangles came in, so most of any optimization for the vertex cache is kept
+    u32* cursors = kallocate(sizeof(u32) * meshlet_count, MEMORY_TAG_ARRAY);
+    u32 offset = 0;
+    for (u32 m = 0; m < meshlet_count; ++m) {
+        cursors[m] = offset;
+        out_meshlets[m].index_offset = offset * 3;
+        out_meshlets[m].index_count = meshlet_triangle_counts[m] * 3;
+        offset += meshlet_triangle_counts[m];
+    }
+    u32* output = kallocate(sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    for (u32 t = 0; t < triangle_count; ++t) {
+        u32 to = cursors[triangle_meshlets[t] - 1]++;
+        kcopy_memory(&output[to * 3], &indices[t * 3], sizeof(u32) * 3);
+    }
+    kcopy_memory(indices, output, sizeof(u32) * triangle_count * 3);
+    kfree(output, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(cursors, sizeof(u32) * meshlet_count, MEMORY_TAG_ARRAY);
+
+    kfree(meshlet_triangle_counts, sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(candidates, sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(vertex_meshlets, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(candidate_meshlets, sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(triangle_meshlets, sizeof(u32) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(normals, sizeof(vec3) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(centroids, sizeof(vec3) * triangle_count, MEMORY_TAG_ARRAY);
+    kfree(adjacency, sizeof(u32) * triangle_count * 3, MEMORY_TAG_ARRAY);
+    kfree(adjacency_offsets, sizeof(u32) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(positions, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+
+    for (u32 m = 0; m < meshlet_count; ++m) {
+        meshlet_bounds(vertices, &indices[out_meshlets[m].index_offset], &out_meshlets[m]);
+    }
+    return meshlet_count;
+}
+
+u32 geometry_cull_meshlets(u32 meshlet_count, const geometry_meshlet* meshlets, mat4 model, const frustum* f, vec3 camera_position, geometry_index_range* out_ranges) {
+    // spheres grow by the largest scale. cones only hold up under a uniform scale that doesn't mirror, so they are left
+    // out otherwise
+    vec3 axes[3];
+    f32 scales[3];
+    for (u32 i = 0; i < 3; ++i) {
+        axes[i] = vec3_create(model.data[i * 4 + 0], model.data[i * 4 + 1], model.data[i * 4 + 2]);
+        scales[i] = vec3_length(axes[i]);
+    }
+    f32 max_scale = scales[0] > scales[1] ? scales[0] : scales[1];
+    max_scale = max_scale > scales[2] ? max_scale : scales[2];
+    f32 min_scale = scales[0] < scales[1] ? scales[0] : scales[1];
+    min_scale = min_scale < scales[2] ? min_scale : scales[2];
+    b8 cones = min_scale > 0.0f && max_scale <= min_scale * 1.001f && vec3_dot(vec3_cross(axes[0], axes[1]), axes[2]) > 0.0f;
+    f32 inverse_scale = cones ? 1.0f / max_scale : 0.0f;
+
+    u32 range_count = 0;
+    for (u32 m = 0; m < meshlet_count; ++m) {
+        const geometry_meshlet* meshlet = &meshlets[m];
+        vec3 center = vec3_transform(meshlet->center, model);
+        f32 radius = meshlet->radius * max_scale;
+        if (!frustum_intersects_sphere(f, center, radius)) {
+            continue;
+        }
+        if (cones && meshlet->cone_cutoff < 1.0f) {
+            vec3 a = meshlet->cone_axis;
+            vec3 axis = vec3_mul_scalar(vec3_add(vec3_add(vec3_mul_scalar(axes[0], a.x), vec3_mul_scalar(axes[1], a.y)), vec3_mul_scalar(axes[2], a.z)), inverse_scale);
+            vec3 to_center = vec3_sub(center, camera_position);
+            if (vec3_dot(to_center, axis) >= meshlet->cone_cutoff * vec3_length(to_center) + radius) {
+                continue;
+            }
+        }
+        // joined onto the range before where they meet, so fewer draws are needed
+        if (range_count > 0 && out_ranges[range_count - 1].index_offset + out_ranges[range_count - 1].index_count == meshlet->index_offset) {
+            out_ranges[range_count - 1].index_count += meshlet->index_count;
+        } else {
+            out_ranges[range_count].index_offset = meshlet->index_offset;
+            out_ranges[range_count].index_count = meshlet->index_count;
+            range_count++;
+        }
+    }
+    return range_count;
+}
+
+// NOTE: end meshlets
+
+// NOTE: begin shapes
+
+// each shape is made in its own space, then brought through its transform. normals go through the inverse transpose,
+// which for the rows of a matrix is the cross products of the other two, scaled by the determinant. a transform that
+// mirrors flips the triangles over too, so they are wound back the right way. tangents are worked out once the whole
+// batch is done, from the texture coordinates, as they would be for any other mesh
+
+typedef struct shape_writer {
+    vertex_3d* vertices;
+    u32* indices;
+    u32 vertex_count;
+    u32 index_count;
+} shape_writer;
+
+// the segments a shape actually gets, once raised to the least it can have
+static void shape_segments(const geometry_shape* shape, u32* out_x, u32* out_y) {
+    u32 min_x = 1;
+    u32 min_y = 1;
+    if (shape->type == GEOMETRY_SHAPE_SPHERE) {
+        min_x = 3;
+        min_y = 2;
+    } else if (shape->type == GEOMETRY_SHAPE_CYLINDER) {
+        min_x = 3;
+    }
+    *out_x = shape->segments_x > min_x ? shape->segments_x : min_x;
+    *out_y = shape->segments_y > min_y ? shape->segments_y : min_y;
+}
+
+static void shape_size(const geometry_shape* shape, u32* out_vertex_count, u32* out_index_count) {
+    u32 x, y;
+    shape_segments(shape, &x, &y);
+    switch (shape->type) {
+        case GEOMETRY_SHAPE_PLANE:
+            *out_vertex_count = (x + 1) * (y + 1);
+            *out_index_count = x * y * 6;
+            break;
+        case GEOMETRY_SHAPE_CUBE:
+            *out_vertex_count = 6 * 4;
+            *out_index_count = 6 * 6;
+            break;
+        case GEOMETRY_SHAPE_SPHERE:
+            // the rings at the poles are a triangle per segment rather than a quad
+            *out_vertex_count = (x + 1) * (y + 1);
+            *out_index_count = x * (y - 1) * 6;
+            break;
+        case GEOMETRY_SHAPE_CYLINDER:
+            // the side, then a centre and a rim for each cap
+            *out_vertex_count = (x + 1) * (y + 1) + 2 * (x + 1);
+            *out_index_count = x * y * 6 + 2 * x * 3;
+            break;
+        default:
+            *out_vertex_count = 0;
+            *out_index_count = 0;
+            break;
+    }
+}
+
+static void shape_vertex(shape_writer* writer, vec3 position, vec3 normal, vec2 texcoord) {
+    vertex_3d* v = &writer->vertices[writer->vertex_count++];
+    v->position = position;
+    v->normal = normal;
+    v->texcoord = texcoord;
+    v->colour = vec4_one();
+    v->tangent = vec4_zero();
+}
+
+static void shape_triangle(shape_writer* writer, u32 a, u32 b, u32 c) {
+    writer->indices[writer->index_count++] = a;
+    writer->indices[writer->index_count++] = b;
+    writer->indices[writer->index_count++] = c;
+}
+
+// a grid of quads from corner, across u and along v, facing the way u cross v does. the texture goes across the grid
+// once, times tiling
+static void shape_grid(shape_writer* writer, vec3 corner, vec3 u, vec3 v, vec3 normal, u32 u_count, u32 v_count, vec2 tiling) {
+    u32 first = writer->vertex_count;
+    for (u32 j = 0; j <= v_count; ++j) {
+        f32 fv = (f32)j / (f32)v_count;
+        for (u32 i = 0; i <= u_count; ++i) {
+            f32 fu = (f32)i / (f32)u_count;
+            vec3 position = vec3_add(corner, vec3_add(vec3_mul_scalar(u, fu), vec3_mul_scalar(v, fv)));
+            shape_vertex(writer, position, normal, vec2_create(fu * tiling.x, fv * tiling.y));
+        }
+    }
+    for (u32 j = 0; j < v_count; ++j) {
+        for (u32 i = 0; i < u_count; ++i) {
+            u32 a = first + j * (u_count + 1) + i;
+            u32 c = a + u_count + 1;
+            shape_triangle(writer, a, c + 1, c);
+            shape_triangle(writer, a, a + 1, c + 1);
+        }
+    }
+}
+
+static void shape_cube(shape_writer* writer, vec3 size, vec2 tiling) {
+    // each face's normal, then the way across and the way along it
+    static const f32 faces[6][3][3] = {
+        {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},     // front
+        {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},   // back
+        {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},    // left
+        {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},    // right
+        {{0, -1, 0}, {-1, 0, 0}, {0, 0, -1}},  // bottom
+        {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}}};   // top
+    vec3 half = vec3_mul_scalar(size, 0.5f);
+    for (u32 f = 0; f < 6; ++f) {
+        vec3 n = vec3_create(faces[f][0][0], faces[f][0][1], faces[f][0][2]);
+        vec3 u = vec3_create(faces[f][1][0], faces[f][1][1], faces[f][1][2]);
+        vec3 v = vec3_create(faces[f][2][0], faces[f][2][1], faces[f][2][2]);
+        vec3 corner = vec3_mul(vec3_sub(vec3_sub(n, u), v), half);
+        shape_grid(writer, corner, vec3_mul(u, size), vec3_mul(v, size), n, 1, 1, tiling);
+    }
+}
+
+// the sine and cosine of a step around a circle of count steps. the ends of the seam come out exactly the same
+static void shape_angle(u32 step, u32 count, f32* out_sin, f32* out_cos) {
+    f32 angle = K_PI_2 * (f32)(step % count) / (f32)count;
+    *out_sin = ksin(angle);
+    *out_cos = kcos(angle);
+}
+
+static void shape_sphere(shape_writer* writer, vec3 size, u32 segments, u32 rings, vec2 tiling) {
+    vec3 half = vec3_mul_scalar(size, 0.5f);
+    // normals of a stretched sphere are those of a round one, divided by the stretch. multiplying by the other two
+    // axes' stretch is the same once normalized, and never divides by 0
+    vec3 normal_scale = vec3_create(half.y * half.z, half.x * half.z, half.x * half.y);
+    u32 first = writer->vertex_count;
+    for (u32 r = 0; r <= rings; ++r) {
+        // from the top down, with the poles exactly on the axis
+        f32 ring_sin = 0.0f;
+        f32 ring_cos = r == 0 ? 1.0f : -1.0f;
+        if (r > 0 && r < rings) {
+            ring_sin = ksin(K_PI * (f32)r / (f32)rings);
+            ring_cos = kcos(K_PI * (f32)r / (f32)rings);
+        }
+        for (u32 s = 0; s <= segments; ++s) {
+            f32 segment_sin, segment_cos;
+            shape_angle(s, segments, &segment_sin, &segment_cos);
+            vec3 unit = vec3_create(ring_sin * segment_cos, ring_cos, ring_sin * segment_sin);
+            vec2 texcoord = vec2_create((f32)s / (f32)segments * tiling.x, (1.0f - (f32)r / (f32)rings) * tiling.y);
+            shape_vertex(writer, vec3_mul(unit, half), vec3_normalized(vec3_mul(unit, normal_scale)), texcoord);
+        }
+    }
+    for (u32 r = 0; r < rings; ++r) {
+        for (u32 s = 0; s < segments; ++s) {
+            u32 a = first + r * (segments + 1) + s;
+            u32 c = a + segments + 1;
+            // the poles are a single point, so the triangle that would have two corners there is left out
+            if (r != rings - 1) {
+                shape_triangle(writer, a, c + 1, c);
+            }
+            if (r != 0) {
+                shape_triangle(writer, a, a + 1, c + 1);
+            }
+        }
+    }
+}
+
+static void shape_cylinder(shape_writer* writer, vec3 size, u32 segments, u32 rings, vec2 tiling) {
+    vec3 half = vec3_mul_scalar(size, 0.5f);
+    // the side, from the top down
+    u32 first = writer->vertex_count;
+    for (u32 r = 0; r <= rings; ++r) {
+        f32 along = (f32)r / (f32)rings;
+        for (u32 s = 0; s <= segments; ++s) {
+            f32 segment_sin, segment_cos;
+            shape_angle(s, segments, &segment_sin, &segment_cos);
+            vec3 position = vec3_create(segment_cos * half.x, half.y - along * size.y, segment_sin * half.z);
+            vec3 normal = vec3_normalized(vec3_create(segment_cos * half.z, 0.0f, segment_sin * half.x));
+            shape_vertex(writer, position, normal, vec2_create((f32)s / (f32)segments * tiling.x, (1.0f - along) * tiling.y));
+        }
+    }
+    for (u32 r = 0; r < rings; ++r) {
+        for (u32 s = 0; s < segments; ++s) {
+            u32 a = first + r * (segments + 1) + s;
+            u32 c = a + segments + 1;
+            shape_triangle(writer, a, c + 1, c);
+            shape_triangle(writer, a, a + 1, c + 1);
+        }
+    }
+
+    // the caps, a fan each, with the texture laid flat across them
+    for (u32 cap = 0; cap < 2; ++cap) {
+        f32 side = cap == 0 ? 1.0f : -1.0f;
+        vec3 normal = vec3_create(0.0f, side, 0.0f);
+        u32 centre = writer->vertex_count;
+        shape_vertex(writer, vec3_create(0.0f, side * half.y, 0.0f), normal, vec2_create(0.5f * tiling.x, 0.5f * tiling.y));
+        for (u32 s = 0; s < segments; ++s) {
+            f32 segment_sin, segment_cos;
+            shape_angle(s, segments, &segment_sin, &segment_cos);
+            vec3 position = vec3_create(segment_cos * half.x, side * half.y, segment_sin * half.z);
+            vec2 texcoord = vec2_create((segment_cos * 0.5f + 0.5f) * tiling.x, (segment_sin * 0.5f + 0.5f) * tiling.y);
+            shape_vertex(writer, position, normal, texcoord);
+        }
+        for (u32 s = 0; s < segments; ++s) {
+            u32 current = centre + 1 + s;
+            u32 next = centre + 1 + (s + 1) % segments;
+            if (cap == 0) {
+                shape_triangle(writer, centre, next, current);
+            } else {
+                shape_triangle(writer, centre, current, next);
+            }
+        }
+    }
+}
+
+// brings the vertices and triangles written since first_vertex and first_index through a transform
+static void shape_transform(shape_writer* writer, u32 first_vertex, u32 first_index, mat4 transform) {
+    vec3 axes[3];
+    for (u32 i = 0; i < 3; ++i) {
+        axes[i] = vec3_create(transform.data[i * 4 + 0], transform.data[i * 4 + 1], transform.data[i * 4 + 2]);
+    }
+    vec3 normal_axes[3] = {vec3_cross(axes[1], axes[2]), vec3_cross(axes[2], axes[0]), vec3_cross(axes[0], axes[1])};
+    b8 mirrored = vec3_dot(normal_axes[0], axes[0]) < 0.0f;
+    for (u32 i = 0; i < 3 && mirrored; ++i) {
+        normal_axes[i] = vec3_mul_scalar(normal_axes[i], -1.0f);
+    }
+
+    for (u32 v = first_vertex; v < writer->vertex_count; ++v) {
+        vertex_3d* vertex = &writer->vertices[v];
+        vec3 n = vertex->normal;
+        vertex->position = vec3_transform(vertex->position, transform);
+        vertex->normal = vec3_normalized(vec3_add(vec3_add(vec3_mul_scalar(normal_axes[0], n.x), vec3_mul_scalar(normal_axes[1], n.y)), vec3_mul_scalar(normal_axes[2], n.z)));
+    }
+    if (mirrored) {
+        for (u32 i = first_index; i < writer->index_count; i += 3) {
+            u32 temp = writer->indices[i + 1];
+            writer->indices[i + 1] = writer->indices[i + 2];
+            writer->indices[i + 2] = temp;
+        }
+    }
+}
+
+void geometry_shapes_size(u32 shape_count, const geometry_shape* shapes, u32* out_vertex_count, u32* out_index_count) {
+    *out_vertex_count = 0;
+    *out_index_count = 0;
+    for (u32 i = 0; i < shape_count; ++i) {
+        u32 vertex_count, index_count;
+        shape_size(&shapes[i], &vertex_count, &index_count);
+        *out_vertex_count += vertex_count;
+        *out_index_count += index_count;
+    }
+}
+
+void geometry_generate_shapes(u32 shape_count, const geometry_shape* shapes, vertex_3d* out_vertices, u32* out_indices, geometry_index_range* out_ranges) {
+    KPROFILE_SCOPE("geometry_generate_shapes");
+    shape_writer writer = {out_vertices, out_indices, 0, 0};
+    for (u32 i = 0; i < shape_count; ++i) {
+        const geometry_shape* shape = &shapes[i];
+        u32 first_vertex = writer.vertex_count;
+        u32 first_index = writer.index_count;
+        u32 x, y;
+        shape_segments(shape, &x, &y);
+        switch (shape->type) {
+            case GEOMETRY_SHAPE_PLANE:
+                shape_grid(&writer, vec3_create(-shape->size.x * 0.5f, -shape->size.y * 0.5f, 0.0f), vec3_create(shape->size.x, 0, 0), vec3_create(0, shape->size.y, 0), vec3_create(0, 0, 1), x, y, shape->tiling);
+                break;
+            case GEOMETRY_SHAPE_CUBE:
+                shape_cube(&writer, shape->size, shape->tiling);
+                break;
+            case GEOMETRY_SHAPE_SPHERE:
+                shape_sphere(&writer, shape->size, x, y, shape->tiling);
+                break;
+            case GEOMETRY_SHAPE_CYLINDER:
+                shape_cylinder(&writer, shape->size, x, y, shape->tiling);
+                break;
+            default:
+                KWARN("geometry_generate_shapes - unknown shape type %u, skipping.", shape->type);
+                break;
+        }
+        shape_transform(&writer, first_vertex, first_index, shape->transform);
+        if (out_ranges) {
+            out_ranges[i].index_offset = first_index;
+            out_ranges[i].index_count = writer.index_count - first_index;
+        }
+    }
+    geometry_generate_tangents(writer.vertex_count, out_vertices, writer.index_count, out_indices);
+}
+
+// NOTE: end shapes
+
+// NOTE: begin vertex packing
+
+// rounds to the nearest half, ties to even, as the gpu would. out of range values become infinity
+static u16 f32_to_f16(f32 value) {
+    u32 bits = 0;
+    kcopy_memory(&bits, &value, sizeof(f32));
+    u32 sign = (bits >> 16) & 0x8000;
+    u32 biased = (bits >> 23) & 0xff;
+    u32 mantissa = bits & 0x7fffff;
+    if (biased == 0xff) {
+        // infinity stays infinity, and nan stays nan
+        return (u16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    i32 exponent = (i32)biased - 127 + 15;
+    if (exponent >= 31) {
+        return (u16)(sign | 0x7c00);
+    }
+    if (exponent <= 0) {
+        // too small for a normal half, so denormal, or 0
+        if (exponent < -10) {
+            return (u16)sign;
+        }
+        mantissa |= 0x800000;
+        u32 shift = (u32)(14 - exponent);
+        u32 half = mantissa >> shift;
+        u32 remainder = mantissa & ((1u << shift) - 1);
+        u32 halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            half++;
+        }
+        return (u16)(sign | half);
+    }
+    // rounding up can carry into the exponent, which is still the right answer
+    u32 half = sign | ((u32)exponent << 10) | (mantissa >> 13);
+    u32 remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return (u16)half;
+}
+
+static f32 f16_to_f32(u16 half) {
+    u32 sign = (u32)(half & 0x8000) << 16;
+    u32 exponent = (half >> 10) & 0x1f;
+    u32 mantissa = half & 0x3ff;
+    u32 bits = 0;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // denormal, made normal
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    } else {
+        bits = sign;
+    }
+    f32 value = 0.0f;
+    kcopy_memory(&value, &bits, sizeof(f32));
+    return value;
+}
+
+static i16 snorm16_encode(f32 value) {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    f32 scaled = value * 32767.0f;
+    return (i16)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static f32 snorm16_decode(i16 value) {
+    f32 decoded = (f32)value / 32767.0f;
+    return decoded < -1.0f ? -1.0f : decoded;
+}
+
+// a unit vector onto the faces of an octahedron, which unfolds onto a square. the lower half is folded out over the
+// corners. far more even than storing x and y and working z out, for the same bits
+static void octahedral_encode(vec3 v, i16* out_encoded) {
+    f32 length = kabs(v.x) + kabs(v.y) + kabs(v.z);
+    if (length <= 0.0f) {
+        out_encoded[0] = 0;
+        out_encoded[1] = 0;
+        return;
+    }
+    f32 x = v.x / length;
+    f32 y = v.y / length;
+    if (v.z < 0.0f) {
+        f32 folded_x = (1.0f - kabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        f32 folded_y = (1.0f - kabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+    out_encoded[0] = snorm16_encode(x);
+    out_encoded[1] = snorm16_encode(y);
+}
+
+// the same as the material shader's decode
+static vec3 octahedral_decode(const i16* encoded) {
+    vec3 v = vec3_create(snorm16_decode(encoded[0]), snorm16_decode(encoded[1]), 0.0f);
+    v.z = 1.0f - kabs(v.x) - kabs(v.y);
+    if (v.z < 0.0f) {
+        f32 x = (1.0f - kabs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+        f32 y = (1.0f - kabs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+        v.x = x;
+        v.y = y;
+    }
+    return vec3_normalized(v);
+}
+
+// the size of the cube positions are packed into. the largest side of the bounds, so nothing is skewed
+static f32 packed_position_scale(vec3 min_extents, vec3 max_extents) {
+    vec3 size = vec3_sub(max_extents, min_extents);
+    f32 scale = size.x > size.y ? size.x : size.y;
+    scale = scale > size.z ? scale : size.z;
+    return scale > 0.0f ? scale : 1.0f;
+}
+
+b8 geometry_pack_vertices(u32 vertex_count, const vertex_3d* vertices, vec3 min_extents, vec3 max_extents, vertex_3d_packed* out_vertices) {
+    f32 inverse_scale = 1.0f / packed_position_scale(min_extents, max_extents);
+    b8 constant_colour = true;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        const vertex_3d* in = &vertices[v];
+        vertex_3d_packed* out = &out_vertices[v];
+        vec3 relative = vec3_mul_scalar(vec3_sub(in->position, min_extents), inverse_scale);
+        for (u32 c = 0; c < 3; ++c) {
+            f32 value = relative.elements[c] < 0.0f ? 0.0f : (relative.elements[c] > 1.0f ? 1.0f : relative.elements[c]);
+            out->position[c] = (u16)(value * 65535.0f + 0.5f);
+        }
+        out->position[3] = in->tangent.w < 0.0f ? 0 : 65535;
+        octahedral_encode(in->normal, out->normal);
+        octahedral_encode(vec3_create(in->tangent.x, in->tangent.y, in->tangent.z), out->tangent);
+        out->texcoord[0] = f32_to_f16(in->texcoord.x);
+        out->texcoord[1] = f32_to_f16(in->texcoord.y);
+
+        const vec4* first = &vertices[0].colour;
+        constant_colour = constant_colour && in->colour.r == first->r && in->colour.g == first->g && in->colour.b == first->b && in->colour.a == first->a;
+    }
+    return constant_colour;
+}
+
+void geometry_unpack_vertices(u32 vertex_count, const vertex_3d_packed* vertices, vec3 min_extents, vec3 max_extents, vertex_3d* out_vertices) {
+    f32 scale = packed_position_scale(min_extents, max_extents);
+    for (u32 v = 0; v < vertex_count; ++v) {
+        const vertex_3d_packed* in = &vertices[v];
+        vertex_3d* out = &out_vertices[v];
+        vec3 relative = vec3_create(in->position[0] / 65535.0f, in->position[1] / 65535.0f, in->position[2] / 65535.0f);
+        out->position = vec3_add(min_extents, vec3_mul_scalar(relative, scale));
+        out->normal = octahedral_decode(in->normal);
+        vec3 tangent = octahedral_decode(in->tangent);
+        out->tangent = vec4_create(tangent.x, tangent.y, tangent.z, in->position[3] ? 1.0f : -1.0f);
+        out->texcoord = vec2_create(f16_to_f32(in->texcoord[0]), f16_to_f32(in->texcoord[1]));
+        out->colour = vec4_one();
+    }
+}
+
+mat4 geometry_packed_position_transform(vec3 min_extents, vec3 max_extents) {
+    f32 scale = packed_position_scale(min_extents, max_extents);
+    return mat4_mul(mat4_scale(vec3_create(scale, scale, scale)), mat4_translation(min_extents));
+}
+
+// NOTE: end vertex packing
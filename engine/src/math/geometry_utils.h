@@ -1,20 +1,58 @@
 #pragma once
 
 #include "math_types.h"
+#include "resources/resource_types.h"
 
-// @brief calculates normals for the given vertex and index data. modifies vertices in place
+// @brief the instruction sets the batch kernels (normal and tangent generation) can use
+typedef enum geometry_simd_level {
+    // @brief plain c, on any cpu
+    GEOMETRY_SIMD_LEVEL_SCALAR = 0,
+    // @brief 4 lanes at a time. always there on x86-64
+    GEOMETRY_SIMD_LEVEL_SSE = 1,
+    // @brief 8 lanes at a time, where the cpu and os support it
+    GEOMETRY_SIMD_LEVEL_AVX = 2
+} geometry_simd_level;
+
+// @brief the instruction set in use. the best the cpu supports, unless set otherwise
+KAPI geometry_simd_level geometry_simd_level_get();
+
+// @brief sets the instruction set to use, for comparing them. anything the cpu doesn't support falls back to the best
+// it does
+// @param level the instruction set to use
+// @return the instruction set that will actually be used
+KAPI geometry_simd_level geometry_simd_level_set(geometry_simd_level level);
+
+// @brief calculates smooth normals for the given vertex and index data, each the sum of the normals of the triangles
+// the vertex is part of, weighted by their area. modifies vertices in place. vertices in no triangle are left alone.
+// split across the job system for large meshes
 // @param vertex_count the number of vertices
 // @param vertices an array of vertices
 // @param index_count the number of indices.
 // @param indices an array of indices
-void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+KAPI void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
 
-// @brief calculates tangents for the given vertex and index data. modifies vertices in place
+// @brief calculates tangents for the given vertex and index data, each the sum of the tangents of the triangles the
+// vertex is part of, weighted by their area, then made perpendicular to the vertex's normal. where the texture
+// coordinates give no direction, any perpendicular one is used. modifies vertices in place. vertices in no triangle are
+// left alone. split across the job system for large meshes
 // @param vertex_count the number of vertices
 // @param vertices an array of vertices
 // @param index_count the number of indices.
 // @param indices an array of indices
-void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+KAPI void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+
+// @brief welds vertices that are the same into one, in a single pass over a hash table. the first of each set of welded
+// vertices is kept, in the order they first appear. allocates a new array in out_vertices, which the caller frees
+// @param vertex_count the number of vertices in the array
+// @param vertices the vertices to be welded. not modified
+// @param index_count the number of indices in the array
+// @param indices the array of indices. modified in place to point at the welded vertices
+// @param epsilon 0 to only weld vertices whose attributes are exactly equal. otherwise every attribute is snapped to the
+// nearest multiple of epsilon, and vertices that snap to the same values are welded
+// @param out_vertex_count a pointer to hold the number of welded vertices
+// @param out_vertices a pointer to hold the array of welded vertices
+// @param out_remap optional. an array of vertex_count entries to hold the welded index of each original vertex
+KAPI void geometry_weld_vertices(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 epsilon, u32* out_vertex_count, vertex_3d** out_vertices, u32* out_remap);
 
 // @brief de-duplicates vertices, leaving only unique ones. leaves the original vertices array intact. allocates a new array
 // in out_vertices. modifies indices in place. original vertex array should be freed by the caller
@@ -24,4 +62,170 @@ void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index
 // @param indices the array of indices. modified in place as vertices are removed
 // @param out_vertex_count a pointer to hold the final vertex count
 // @param out_vertices a pointer to hold the array of de-duplicated vertices
-void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices);
\ No newline at end of file
+void geometry_deduplicate_vertices(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices, u32* out_vertex_count, vertex_3d** out_vertices);
+// the fifo cache size vertex cache statistics are given for, and the overdraw pass assumes. about what gpus have had
+#define GEOMETRY_FIFO_CACHE_SIZE 16
+
+// @brief how well an index buffer uses the gpu's post transform vertex cache
+typedef struct geometry_cache_stats {
+    // @brief average cache miss ratio, the vertices transformed per triangle. 3 at worst, and approaching 0.5 for a
+    // large regular grid at best
+    f32 acmr;
+    // @brief average transformed vertex ratio, the times each vertex is transformed. 1 at best
+    f32 atvr;
+} geometry_cache_stats;
+
+// @brief simulates a fifo vertex cache over an index buffer
+// @param vertex_count the number of vertices the indices refer to
+// @param index_count the number of indices
+// @param indices the indices, as a triangle list
+// @param cache_size the number of vertices the cache holds, such as GEOMETRY_FIFO_CACHE_SIZE
+// @param out_stats a pointer to hold the results
+KAPI void geometry_analyze_vertex_cache(u32 vertex_count, u32 index_count, const u32* indices, u32 cache_size, geometry_cache_stats* out_stats);
+
+// @brief reorders triangles to make the most of the gpu's post transform vertex cache, using tom forsyth's linear speed
+// algorithm. the result only depends on the input, so it is the same on every machine
+// @param vertex_count the number of vertices the indices refer to
+// @param index_count the number of indices
+// @param indices the indices, as a triangle list. reordered in place
+KAPI void geometry_optimize_vertex_cache(u32 vertex_count, u32 index_count, u32* indices);
+
+// @brief reorders clusters of triangles so the outermost, outward facing ones are drawn first, to cut down overdraw.
+// meant to run after geometry_optimize_vertex_cache, which it keeps most of the benefit of
+// @param vertex_count the number of vertices
+// @param vertices the vertices. only the positions are used
+// @param index_count the number of indices
+// @param indices the indices, as a triangle list. reordered in place
+// @param threshold how much worse the cache miss ratio is allowed to get, such as 1.05 for 5%. higher gives smaller
+// clusters, which can be ordered better
+KAPI void geometry_optimize_overdraw(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, f32 threshold);
+
+// @brief reorders vertices into the order the indices first use them, so vertex fetches run through memory in order.
+// meant to run last, as it depends on the triangle order. any vertices not used are moved to the end
+// @param vertex_count the number of vertices
+// @param vertices the vertices. reordered in place
+// @param index_count the number of indices
+// @param indices the indices. rewritten to match
+KAPI void geometry_optimize_vertex_fetch(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+
+// @brief simplifies a mesh down towards target_index_count by collapsing edges, the ones that move the surface least
+// first, as measured by garland and heckbert's quadric error metric. vertices are only ever collapsed onto a neighbour,
+// never moved or created, so the result indexes the same vertices and can share their buffer. vertices on open borders
+// and on attribute seams (where vertices share a position but not uvs or normals) are kept where they are. the result
+// only depends on the input, so it is the same on every machine
+// @param vertex_count the number of vertices
+// @param vertices the vertices. only the positions are used
+// @param index_count the number of indices
+// @param indices the indices, as a triangle list
+// @param target_index_count the number of indices to stop at. may not be reached, if there is nothing left to collapse
+// that is within target_error
+// @param target_error the furthest the surface is allowed to move, in the same units as the positions
+// @param out_indices an array of at least index_count indices to hold the result
+// @param out_error a pointer to hold how far the surface moved at most. optional
+// @return the number of indices written to out_indices
+KAPI u32 geometry_simplify(u32 vertex_count, const vertex_3d* vertices, u32 index_count, const u32* indices, u32 target_index_count, f32 target_error, u32* out_indices, f32* out_error);
+
+// the most vertices and triangles the importer puts in a meshlet. the sizes mesh shaders work best with, should meshlets
+// ever be drawn that way
+#define GEOMETRY_MESHLET_MAX_VERTICES 64
+#define GEOMETRY_MESHLET_MAX_TRIANGLES 124
+
+// @brief splits triangles into meshlets, small clusters of neighbouring triangles that face much the same way, each
+// with a bounding sphere and a cone around the directions it faces to cull it by. the triangles are reordered so each
+// meshlet's are together, keeping the order they were in as far as possible. the result only depends on the input, so
+// it is the same on every machine
+// @param vertex_count the number of vertices
+// @param vertices the vertices. only the positions are used
+// @param index_count the number of indices
+// @param indices the indices, as a triangle list. reordered in place
+// @param max_vertices the most vertices in a meshlet, such as GEOMETRY_MESHLET_MAX_VERTICES. at least 3
+// @param max_triangles the most triangles in a meshlet, such as GEOMETRY_MESHLET_MAX_TRIANGLES
+// @param out_meshlets an array of at least index_count / 3 meshlets to hold the result. their index offsets are into
+// indices
+// @return the number of meshlets written to out_meshlets
+KAPI u32 geometry_build_meshlets(u32 vertex_count, const vertex_3d* vertices, u32 index_count, u32* indices, u32 max_vertices, u32 max_triangles, geometry_meshlet* out_meshlets);
+
+// @brief culls meshlets outside a frustum, or facing away from the camera, and gathers the indices of the rest into as
+// few ranges as it can, in order. the result only depends on the input, so it is the same on every machine
+// @param meshlet_count the number of meshlets
+// @param meshlets the meshlets, in the order their indices are in
+// @param model the model matrix, from the meshlets' local space into the frustum's
+// @param f the frustum, such as from frustum_from_matrix
+// @param camera_position where the camera is, in the frustum's space
+// @param out_ranges an array of at least meshlet_count ranges to hold the result
+// @return the number of ranges written to out_ranges. 0 if every meshlet was culled
+KAPI u32 geometry_cull_meshlets(u32 meshlet_count, const geometry_meshlet* meshlets, mat4 model, const frustum* f, vec3 camera_position, geometry_index_range* out_ranges);
+
+// @brief the shapes geometry_generate_shapes can make. each fills a box of the shape's size, centred on the origin,
+// before its transform is applied
+typedef enum geometry_shape_type {
+    // a grid in x and y, facing +z. size.z is not used. segments_x by segments_y quads
+    GEOMETRY_SHAPE_PLANE,
+    // a box, with each face a quad of its own. the segments are not used
+    GEOMETRY_SHAPE_CUBE,
+    // a sphere, stretched to the size. segments_x around y, at least 3, and segments_y from top to bottom, at least 2
+    GEOMETRY_SHAPE_SPHERE,
+    // a capped cylinder along y, stretched to the size. segments_x around y, at least 3, and segments_y along it
+    GEOMETRY_SHAPE_CYLINDER
+} geometry_shape_type;
+
+// @brief one shape for geometry_generate_shapes
+typedef struct geometry_shape {
+    geometry_shape_type type;
+    // @brief the size of the box the shape fills
+    vec3 size;
+    // @brief how finely the shape is divided. see geometry_shape_type. anything below the least is raised to it
+    u32 segments_x;
+    u32 segments_y;
+    // @brief the number of times the texture repeats across the shape (or across each face, for a cube) on each axis
+    vec2 tiling;
+    // @brief where the shape goes. positions, normals and tangents are all brought through it. mat4_identity to leave
+    // it where it was made
+    mat4 transform;
+} geometry_shape;
+
+// @brief the number of vertices and indices geometry_generate_shapes needs for a batch of shapes, so buffers can be
+// made (or taken from an allocator) for it up front
+// @param shape_count the number of shapes
+// @param shapes the shapes
+// @param out_vertex_count a pointer to hold the number of vertices
+// @param out_index_count a pointer to hold the number of indices
+KAPI void geometry_shapes_size(u32 shape_count, const geometry_shape* shapes, u32* out_vertex_count, u32* out_index_count);
+
+// @brief generates a batch of shapes into one set of vertices and indices, with normals and tangents, so they can all go
+// up as one geometry. each shape is placed by its own transform, so a whole floor of tiles or a stack of crates is a
+// single upload and a single draw. for many copies that move on their own, generate the shape once, with the identity
+// transform, and have every mesh share the one geometry instead. the result only depends on the input, so it is the
+// same on every machine
+// @param shape_count the number of shapes
+// @param shapes the shapes
+// @param out_vertices an array of at least the vertex count from geometry_shapes_size to hold the vertices
+// @param out_indices an array of at least the index count from geometry_shapes_size to hold the indices, as a triangle
+// list. triangles wind counter clockwise seen from outside
+// @param out_ranges an array of shape_count to hold the range of the indices each shape ended up in, so shapes can be
+// drawn on their own. optional
+KAPI void geometry_generate_shapes(u32 shape_count, const geometry_shape* shapes, vertex_3d* out_vertices, u32* out_indices, geometry_index_range* out_ranges);
+
+// @brief packs vertices into vertex_3d_packed. positions are stored relative to a cube around the given bounds, with the
+// same scale on every axis, so the transform that brings them back never skews a normal
+// @param vertex_count the number of vertices
+// @param vertices the vertices to pack
+// @param min_extents the minimum of the bounds. positions outside the bounds are clamped to them
+// @param max_extents the maximum of the bounds
+// @param out_vertices an array of vertex_count to hold the packed vertices
+// @return true if every vertex had the same colour, so nothing was lost leaving it out
+KAPI b8 geometry_pack_vertices(u32 vertex_count, const vertex_3d* vertices, vec3 min_extents, vec3 max_extents, vertex_3d_packed* out_vertices);
+
+// @brief unpacks vertices packed by geometry_pack_vertices, to within the precision they were packed at. colours come out
+// white
+// @param vertex_count the number of vertices
+// @param vertices the packed vertices
+// @param min_extents the minimum of the bounds they were packed with
+// @param max_extents the maximum of the bounds they were packed with
+// @param out_vertices an array of vertex_count to hold the unpacked vertices
+KAPI void geometry_unpack_vertices(u32 vertex_count, const vertex_3d_packed* vertices, vec3 min_extents, vec3 max_extents, vertex_3d* out_vertices);
+
+// @brief the transform from packed positions (each from 0 to 1) back to where they were. applied before the model matrix
+// @param min_extents the minimum of the bounds the positions were packed with
+// @param max_extents the maximum of the bounds the positions were packed with
+KAPI mat4 geometry_packed_position_transform(vec3 min_extents, vec3 max_extents);
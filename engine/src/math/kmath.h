@@ -1185,6 +1185,43 @@ KINLINE quat quat_slerp(quat q_0, quat q_1, f32 percentage) {
         (v0.w * s0) + (v1.w * s1)};
 }
 
+// frustum ------------------------------------------------------------------------------------------------------------------------------------------------
+
+// @brief extracts the frustum a view projection matrix sees (gribb and hartmann's method). the planes are in world space
+// for mat4_mul(view, projection), or in a model's local space if the model matrix is multiplied in first
+// @param view_projection the view matrix multiplied by the projection
+// @return the frustum, with its planes normalized
+KINLINE frustum frustum_from_matrix(mat4 view_projection) {
+    const f32* m = view_projection.data;
+    frustum out_frustum;
+    // each plane is the last column of the matrix plus or minus one of the others
+    for (u32 i = 0; i < 6; ++i) {
+        u32 column = i / 2;
+        f32 sign = (i % 2) == 0 ? 1.0f : -1.0f;
+        vec4 plane = vec4_create(m[3] + sign * m[column], m[7] + sign * m[4 + column], m[11] + sign * m[8 + column], m[15] + sign * m[12 + column]);
+        f32 length = ksqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        f32 inverse = length > 0.0f ? 1.0f / length : 0.0f;
+        out_frustum.planes[i] = vec4_create(plane.x * inverse, plane.y * inverse, plane.z * inverse, plane.w * inverse);
+    }
+    return out_frustum;
+}
+
+// @brief checks whether any of a sphere could be inside a frustum. may say so for a sphere just outside a corner, but
+// never says otherwise for one that is inside
+// @param f the frustum
+// @param center the center of the sphere
+// @param radius the radius of the sphere
+// @return true if the sphere is, or may be, inside the frustum
+KINLINE b8 frustum_intersects_sphere(const frustum* f, vec3 center, f32 radius) {
+    for (u32 i = 0; i < 6; ++i) {
+        const vec4* p = &f->planes[i];
+        if (p->x * center.x + p->y * center.y + p->z * center.z + p->w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // @brief converts provided degrees to radians
 // @param degrees the degrees to be converted
 // @retun the amount in radians
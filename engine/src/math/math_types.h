@@ -87,6 +87,12 @@ typedef struct extents_3d {
     vec3 max;
 } extents_3d;
 
+// @brief the space a camera sees, as 6 planes (left, right, bottom, top, near and far). each is a normal in xyz, pointing
+// inward, and the distance from the origin in w, so a point p is inside when dot(xyz, p) + w >= 0 for every plane
+typedef struct frustum {
+    vec4 planes[6];
+} frustum;
+
 // vertex is an individual point of geometry, that holds various bits of information, not only position, but texture mappinc coords, color, ect -
 // these want to be in this order everywhere the are used
 typedef struct vertex_3d {
@@ -102,6 +108,20 @@ typedef struct vertex_3d {
     vec4 tangent;
 } vertex_3d;
 
+// @brief a vertex_3d packed into 20 bytes rather than 64, which is what the material shader draws. the colour is left
+// out, as the material shader has never used it. see geometry_pack_vertices
+typedef struct vertex_3d_packed {
+    // @brief the position within the geometry's bounds, as unsigned normalized 16 bit values. the bounds are brought back
+    // with geometry_packed_position_transform. the 4th is the handedness of the tangent, 0 for -1 and 65535 for 1
+    u16 position[4];
+    // @brief the normal, octahedral encoded into two signed normalized 16 bit values
+    i16 normal[2];
+    // @brief the direction of the tangent, encoded the same way as the normal
+    i16 tangent[2];
+    // @brief the texture coordinates, as half floats
+    u16 texcoord[2];
+} vertex_3d_packed;
+
 // for 2 dimentional renderering
 typedef struct vertex_2d {
     vec2 position;
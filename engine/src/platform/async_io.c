@@ -0,0 +1,821 @@
+#include "async_io.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/katomic.h"
+#include "platform/platform.h"
+
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if KPLATFORM_LINUX
+#include <sys/syscall.h>
+// io_uring is driven through raw syscalls, so there is no dependency on liburing. it only needs headers new enough to know about it
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define KOHI_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+#define ASYNC_IO_MAX_PATH_LENGTH 512
+#define ASYNC_IO_DEFAULT_REQUEST_COUNT 256
+#define ASYNC_IO_DEFAULT_THREAD_COUNT 4
+// the number of submission queue entries. reads past this many in flight wait in an overflow list until there is room
+#define ASYNC_IO_RING_ENTRIES 64
+
+typedef struct async_request {
+    b8 in_use;
+    u32 generation;
+    volatile i32 status;
+
+    char path[ASYNC_IO_MAX_PATH_LENGTH];
+    u64 offset;
+    u64 size;
+    u8* data;
+    b8 owns_data;
+    u64 bytes_read;
+
+    pfn_async_read_complete callback;
+    void* user_data;
+    job_counter* counter;
+
+    // the open file, -1 if not open
+    i64 file;
+    // used for the pending, overflow and completed lists. only ever on one at a time
+    struct async_request* next;
+#ifdef KOHI_IO_URING
+    struct iovec iov;
+#endif
+} async_request;
+
+// a simple fifo of requests, linked through next
+typedef struct request_list {
+    async_request* head;
+    async_request* tail;
+} request_list;
+
+#ifdef KOHI_IO_URING
+typedef struct io_uring_ring {
+    i32 fd;
+
+    // guards the submission queue, in_flight and overflow
+    kmutex submit_lock;
+    u32 in_flight;
+    request_list overflow;
+
+    void* sq_ring;
+    u64 sq_ring_size;
+    volatile u32* sq_head;
+    volatile u32* sq_tail;
+    u32 sq_mask;
+    u32 sq_entries;
+    u32* sq_array;
+    struct io_uring_sqe* sqes;
+    u64 sqes_size;
+
+    // only ever touched by the reaper thread
+    void* cq_ring;
+    u64 cq_ring_size;
+    volatile u32* cq_head;
+    volatile u32* cq_tail;
+    u32 cq_mask;
+    struct io_uring_cqe* cqes;
+
+    kthread reaper;
+} io_uring_ring;
+#endif
+
+typedef struct async_io_state {
+    async_io_config config;
+    // cleared under request_lock, so no read can start once it is seen to be 0
+    volatile i32 running;
+    b8 using_io_uring;
+    // reads started but not yet finished. shutdown waits for this to hit 0 before stopping anything
+    volatile i32 outstanding;
+
+    // guards the free list, running, and in_use/generation of every request
+    kmutex request_lock;
+    async_request* requests;
+    u32* free_requests;
+    u32 free_request_count;
+
+    // finished reads with a callback, waiting to be handed over in async_io_update
+    kmutex completed_lock;
+    request_list completed;
+
+    // the fallback thread pool. one signal per pending request
+    kmutex pending_lock;
+    request_list pending;
+    ksemaphore pending_available;
+    kthread* threads;
+    u32 thread_count;
+
+#ifdef KOHI_IO_URING
+    io_uring_ring ring;
+#endif
+} async_io_state;
+
+static async_io_state* state_ptr;
+
+static void list_push(request_list* list, async_request* request) {
+    request->next = 0;
+    if (list->tail) {
+        list->tail->next = request;
+    } else {
+        list->head = request;
+    }
+    list->tail = request;
+}
+
+static async_request* list_pop(request_list* list) {
+    async_request* request = list->head;
+    if (request) {
+        list->head = request->next;
+        if (!list->head) {
+            list->tail = 0;
+        }
+        request->next = 0;
+    }
+    return request;
+}
+
+// NOTE: begin platform file access
+#if KPLATFORM_WINDOWS
+static b8 file_open(const char* path, i64* out_file, u64* out_size) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    *out_file = (i64)file;
+    *out_size = (u64)size.QuadPart;
+    return true;
+}
+
+static i64 file_read_at(i64 file, void* buffer, u64 size, u64 offset) {
+    // ReadFile takes a 32 bit size, so big reads come back short and go around again
+    DWORD to_read = size > 0x40000000ULL ? 0x40000000UL : (DWORD)size;
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD)(offset & 0xFFFFFFFFULL);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD read = 0;
+    if (!ReadFile((HANDLE)file, buffer, to_read, &read, &overlapped)) {
+        return -1;
+    }
+    return (i64)read;
+}
+
+static void file_close(i64 file) {
+    CloseHandle((HANDLE)file);
+}
+#else
+static b8 file_open(const char* path, i64* out_file, u64* out_size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    *out_file = fd;
+    *out_size = (u64)info.st_size;
+    return true;
+}
+
+static i64 file_read_at(i64 file, void* buffer, u64 size, u64 offset) {
+    ssize_t result;
+    do {
+        result = pread((int)file, buffer, size, (off_t)offset);
+    } while (result == -1 && errno == EINTR);
+    return result;
+}
+
+static void file_close(i64 file) {
+    close((int)file);
+}
+#endif
+// NOTE: end platform file access
+
+// opens the file and sets up the buffer. false if the read can not go ahead
+static b8 prepare_request(async_request* request) {
+    u64 file_size = 0;
+    if (!file_open(request->path, &request->file, &file_size)) {
+        KERROR("async_io - unable to open file: '%s'", request->path);
+        request->file = -1;
+        return false;
+    }
+    if (request->offset > file_size) {
+        KERROR("async_io - read offset %llu is past the end of file: '%s'", request->offset, request->path);
+        return false;
+    }
+    if (request->size == 0) {
+        request->size = file_size - request->offset;
+    } else if (request->offset + request->size > file_size) {
+        KERROR("async_io - read of %llu bytes at %llu runs past the end of file: '%s'", request->size, request->offset, request->path);
+        return false;
+    }
+    if (!request->data && request->size > 0) {
+        request->data = kallocate(request->size, MEMORY_TAG_ARRAY);
+        request->owns_data = true;
+    }
+    return true;
+}
+
+// called from whichever thread the read finished on. the request must not be touched after this, as it can be
+// collected (and reused) straight away
+static void finish_request(async_request* request, b8 success) {
+    if (request->file != -1) {
+        file_close(request->file);
+        request->file = -1;
+    }
+    if (!success && request->owns_data && request->data) {
+        kfree(request->data, request->size, MEMORY_TAG_ARRAY);
+        request->data = 0;
+    }
+    if (!success) {
+        request->bytes_read = 0;
+    }
+
+    job_counter* counter = request->counter;
+    i32 status = success ? ASYNC_READ_STATUS_COMPLETE : ASYNC_READ_STATUS_FAILED;
+    if (request->callback) {
+        // the counter goes first, so anything waiting on it is released before the callback runs
+        katomic_store_i32(&request->status, status, KATOMIC_RELEASE);
+        if (counter) {
+            job_counter_decrement(counter);
+        }
+        kmutex_lock(&state_ptr->completed_lock);
+        list_push(&state_ptr->completed, request);
+        kmutex_unlock(&state_ptr->completed_lock);
+        katomic_fetch_add_i32(&state_ptr->outstanding, -1, KATOMIC_RELEASE);
+    } else {
+        // the status goes first, so anything released by the counter finds the read finished when it polls
+        katomic_store_i32(&request->status, status, KATOMIC_RELEASE);
+        if (counter) {
+            job_counter_decrement(counter);
+        }
+        katomic_fetch_add_i32(&state_ptr->outstanding, -1, KATOMIC_RELEASE);
+    }
+}
+
+static void release_request(async_request* request) {
+    kmutex_lock(&state_ptr->request_lock);
+    request->in_use = false;
+    request->generation++;
+    state_ptr->free_requests[state_ptr->free_request_count++] = (u32)(request - state_ptr->requests);
+    kmutex_unlock(&state_ptr->request_lock);
+}
+
+static async_read_result request_result(async_request* request) {
+    async_read_result result;
+    result.status = katomic_load_i32(&request->status, KATOMIC_ACQUIRE);
+    result.data = request->data;
+    result.size = request->bytes_read;
+    return result;
+}
+
+// NOTE: begin thread pool
+// reads the whole request with plain blocking reads
+static void process_request_blocking(async_request* request) {
+    if (!prepare_request(request)) {
+        finish_request(request, false);
+        return;
+    }
+    while (request->bytes_read < request->size) {
+        i64 read = file_read_at(request->file, request->data + request->bytes_read, request->size - request->bytes_read, request->offset + request->bytes_read);
+        if (read <= 0) {
+            KERROR("async_io - read failed part way through file: '%s'", request->path);
+            finish_request(request, false);
+            return;
+        }
+        request->bytes_read += read;
+    }
+    finish_request(request, true);
+}
+
+static u32 async_io_thread_run(void* params) {
+    while (true) {
+        ksemaphore_wait(&state_ptr->pending_available, KSEMAPHORE_WAIT_INFINITE);
+        kmutex_lock(&state_ptr->pending_lock);
+        async_request* request = list_pop(&state_ptr->pending);
+        kmutex_unlock(&state_ptr->pending_lock);
+        if (request) {
+            process_request_blocking(request);
+        } else if (!katomic_load_i32(&state_ptr->running, KATOMIC_ACQUIRE)) {
+            // shutdown only wakes everyone once the queue has drained
+            break;
+        }
+    }
+    return 0;
+}
+// NOTE: end thread pool
+
+// NOTE: begin io_uring
+#ifdef KOHI_IO_URING
+static i32 io_uring_setup(u32 entries, struct io_uring_params* params) {
+    return (i32)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static i32 io_uring_enter(i32 fd, u32 to_submit, u32 min_complete, u32 flags) {
+    return (i32)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, 0, 0);
+}
+
+// queues up a read of whatever is left of the request. submit_lock must be held
+static void ring_push_read(io_uring_ring* ring, async_request* request) {
+    u32 tail = *ring->sq_tail;
+    u32 index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    kzero_memory(sqe, sizeof(struct io_uring_sqe));
+
+    request->iov.iov_base = request->data + request->bytes_read;
+    request->iov.iov_len = request->size - request->bytes_read;
+    // READV rather than READ, as it is available on every kernel that has io_uring at all
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = (i32)request->file;
+    sqe->addr = (u64)&request->iov;
+    sqe->len = 1;
+    sqe->off = request->offset + request->bytes_read;
+    sqe->user_data = (u64)request;
+
+    ring->sq_array[index] = index;
+    // the kernel picks the entry up once it sees the new tail, so everything above has to be visible first
+    katomic_store_i32((volatile i32*)ring->sq_tail, (i32)(tail + 1), KATOMIC_RELEASE);
+}
+
+// submits as much of the overflow list as there is room for. submit_lock must be held
+static void ring_submit_overflow(io_uring_ring* ring) {
+    u32 count = 0;
+    while (ring->in_flight < ring->sq_entries && ring->overflow.head) {
+        ring_push_read(ring, list_pop(&ring->overflow));
+        ring->in_flight++;
+        count++;
+    }
+    if (count) {
+        io_uring_enter(ring->fd, count, 0, 0);
+    }
+}
+
+static void ring_submit(io_uring_ring* ring, async_request* request) {
+    kmutex_lock(&ring->submit_lock);
+    if (ring->in_flight < ring->sq_entries) {
+        ring_push_read(ring, request);
+        ring->in_flight++;
+        io_uring_enter(ring->fd, 1, 0, 0);
+    } else {
+        // the completion queue is sized off the submission queue, so never have more in flight than it can hold
+        list_push(&ring->overflow, request);
+    }
+    kmutex_unlock(&ring->submit_lock);
+}
+
+// wakes the reaper up with a no-op, which completes straight away. user_data of 0 marks it as not being a read
+static void ring_wake(io_uring_ring* ring) {
+    kmutex_lock(&ring->submit_lock);
+    u32 tail = *ring->sq_tail;
+    u32 index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    kzero_memory(sqe, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    ring->sq_array[index] = index;
+    katomic_store_i32((volatile i32*)ring->sq_tail, (i32)(tail + 1), KATOMIC_RELEASE);
+    io_uring_enter(ring->fd, 1, 0, 0);
+    kmutex_unlock(&ring->submit_lock);
+}
+
+// the only thread that reads the completion queue. keeps going after shutdown starts until nothing is in flight
+static u32 io_uring_reaper_run(void* params) {
+    io_uring_ring* ring = &state_ptr->ring;
+    while (true) {
+        u32 head = *ring->cq_head;
+        u32 tail = (u32)katomic_load_i32((volatile i32*)ring->cq_tail, KATOMIC_ACQUIRE);
+        if (head == tail) {
+            kmutex_lock(&ring->submit_lock);
+            b8 idle = ring->in_flight == 0 && !ring->overflow.head;
+            kmutex_unlock(&ring->submit_lock);
+            if (idle && !katomic_load_i32(&state_ptr->running, KATOMIC_ACQUIRE)) {
+                break;
+            }
+            // EINTR just goes back around
+            io_uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+            continue;
+        }
+
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+        async_request* request = (async_request*)cqe->user_data;
+        i32 result = cqe->res;
+        katomic_store_i32((volatile i32*)ring->cq_head, (i32)(head + 1), KATOMIC_RELEASE);
+        if (!request) {
+            continue;
+        }
+
+        kmutex_lock(&ring->submit_lock);
+        ring->in_flight--;
+        kmutex_unlock(&ring->submit_lock);
+
+        if (result == -EAGAIN || result == -EINTR) {
+            ring_submit(ring, request);
+        } else if (result <= 0) {
+            // 0 means the file got shorter since it was opened
+            KERROR("async_io - read failed part way through file: '%s'", request->path);
+            finish_request(request, false);
+        } else {
+            request->bytes_read += (u64)result;
+            if (request->bytes_read < request->size) {
+                // short read, go around again for the rest
+                ring_submit(ring, request);
+            } else {
+                finish_request(request, true);
+            }
+        }
+
+        kmutex_lock(&ring->submit_lock);
+        ring_submit_overflow(ring);
+        kmutex_unlock(&ring->submit_lock);
+    }
+    return 0;
+}
+
+static b8 ring_create(io_uring_ring* ring) {
+    kzero_memory(ring, sizeof(io_uring_ring));
+    struct io_uring_params params;
+    kzero_memory(&params, sizeof(struct io_uring_params));
+    ring->fd = io_uring_setup(ASYNC_IO_RING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        // not an error, io_uring is often missing or blocked (containers, older kernels)
+        KDEBUG("io_uring_setup failed (errno %i), falling back to the thread pool.", errno);
+        return false;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    b8 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(0, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(ring->fd);
+        return false;
+    }
+    if (single_mmap) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(0, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            munmap(ring->sq_ring, ring->sq_ring_size);
+            close(ring->fd);
+            return false;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(0, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (!single_mmap) {
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        }
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(ring->fd);
+        return false;
+    }
+
+    u8* sq = ring->sq_ring;
+    ring->sq_head = (volatile u32*)(sq + params.sq_off.head);
+    ring->sq_tail = (volatile u32*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = *(u32*)(sq + params.sq_off.ring_entries);
+    ring->sq_array = (u32*)(sq + params.sq_off.array);
+
+    u8* cq = ring->cq_ring;
+    ring->cq_head = (volatile u32*)(cq + params.cq_off.head);
+    ring->cq_tail = (volatile u32*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    kmutex_create(&ring->submit_lock);
+    return true;
+}
+
+static void ring_destroy(io_uring_ring* ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    kmutex_destroy(&ring->submit_lock);
+}
+#endif
+// NOTE: end io_uring
+
+// undoes a partial initialize. nothing has been started by this point, so it is only the sync objects. destroying ones
+// that were never created is fine
+static void initialize_failed() {
+    ksemaphore_destroy(&state_ptr->pending_available);
+    kmutex_destroy(&state_ptr->pending_lock);
+    kmutex_destroy(&state_ptr->completed_lock);
+    kmutex_destroy(&state_ptr->request_lock);
+    state_ptr = 0;
+}
+
+b8 async_io_initialize(u64* memory_requirement, void* state, async_io_config config) {
+    if (config.max_request_count == 0) {
+        config.max_request_count = ASYNC_IO_DEFAULT_REQUEST_COUNT;
+    }
+    if (config.fallback_thread_count == 0) {
+        config.fallback_thread_count = ASYNC_IO_DEFAULT_THREAD_COUNT;
+    }
+
+    u64 requests_size = sizeof(async_request) * config.max_request_count;
+    u64 free_list_size = sizeof(u32) * config.max_request_count;
+    u64 threads_size = sizeof(kthread) * config.fallback_thread_count;
+    *memory_requirement = sizeof(async_io_state) + requests_size + free_list_size + threads_size;
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->requests = (void*)((u8*)state + sizeof(async_io_state));
+    state_ptr->free_requests = (void*)((u8*)state_ptr->requests + requests_size);
+    state_ptr->threads = (void*)((u8*)state_ptr->free_requests + free_list_size);
+
+    // hand out the lowest slots first
+    for (u32 i = 0; i < config.max_request_count; ++i) {
+        state_ptr->requests[i].file = -1;
+        state_ptr->free_requests[i] = config.max_request_count - 1 - i;
+    }
+    state_ptr->free_request_count = config.max_request_count;
+
+    if (!kmutex_create(&state_ptr->request_lock) || !kmutex_create(&state_ptr->completed_lock) || !kmutex_create(&state_ptr->pending_lock)) {
+        KERROR("async_io_initialize - failed to create mutexes.");
+        initialize_failed();
+        return false;
+    }
+    katomic_store_i32(&state_ptr->running, 1, KATOMIC_RELEASE);
+
+#ifdef KOHI_IO_URING
+    if (!config.force_fallback && ring_create(&state_ptr->ring)) {
+        if (kthread_create(io_uring_reaper_run, 0, &state_ptr->ring.reaper)) {
+            kthread_set_name(&state_ptr->ring.reaper, "kohi_io_uring");
+            state_ptr->using_io_uring = true;
+            KINFO("Async io started using io_uring, %u entries.", state_ptr->ring.sq_entries);
+            return true;
+        }
+        ring_destroy(&state_ptr->ring);
+    }
+#endif
+
+    if (!ksemaphore_create(0, &state_ptr->pending_available)) {
+        KERROR("async_io_initialize - failed to create semaphore.");
+        initialize_failed();
+        return false;
+    }
+    for (u32 i = 0; i < config.fallback_thread_count; ++i) {
+        if (!kthread_create(async_io_thread_run, 0, &state_ptr->threads[i])) {
+            KERROR("async_io_initialize - failed to create io thread %u.", i);
+            break;
+        }
+        char name[16];
+        string_format(name, "kohi_io_%u", i);
+        kthread_set_name(&state_ptr->threads[i], name);
+        state_ptr->thread_count++;
+    }
+    if (state_ptr->thread_count == 0) {
+        initialize_failed();
+        return false;
+    }
+    KINFO("Async io started using %u threads.", state_ptr->thread_count);
+    return true;
+}
+
+void async_io_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+    // stop new reads from starting, then let the ones already going finish so nothing waiting on them is left hanging
+    kmutex_lock(&state_ptr->request_lock);
+    katomic_store_i32(&state_ptr->running, 0, KATOMIC_RELEASE);
+    kmutex_unlock(&state_ptr->request_lock);
+    while (katomic_load_i32(&state_ptr->outstanding, KATOMIC_ACQUIRE) > 0) {
+        platform_sleep(1);
+    }
+
+#ifdef KOHI_IO_URING
+    if (state_ptr->using_io_uring) {
+        ring_wake(&state_ptr->ring);
+        kthread_wait(&state_ptr->ring.reaper);
+        ring_destroy(&state_ptr->ring);
+    }
+#endif
+    if (state_ptr->thread_count) {
+        for (u32 i = 0; i < state_ptr->thread_count; ++i) {
+            ksemaphore_signal(&state_ptr->pending_available);
+        }
+        for (u32 i = 0; i < state_ptr->thread_count; ++i) {
+            kthread_wait(&state_ptr->threads[i]);
+        }
+        ksemaphore_destroy(&state_ptr->pending_available);
+    }
+
+    // results nobody collected
+    for (u32 i = 0; i < state_ptr->config.max_request_count; ++i) {
+        async_request* request = &state_ptr->requests[i];
+        if (request->in_use && request->owns_data && request->data) {
+            kfree(request->data, request->size, MEMORY_TAG_ARRAY);
+        }
+    }
+
+    kmutex_destroy(&state_ptr->pending_lock);
+    kmutex_destroy(&state_ptr->completed_lock);
+    kmutex_destroy(&state_ptr->request_lock);
+    state_ptr = 0;
+}
+
+void async_io_update() {
+    if (!state_ptr) {
+        return;
+    }
+    // take the whole list at once, so callbacks are free to start more reads
+    kmutex_lock(&state_ptr->completed_lock);
+    request_list completed = state_ptr->completed;
+    state_ptr->completed.head = state_ptr->completed.tail = 0;
+    kmutex_unlock(&state_ptr->completed_lock);
+
+    async_request* request;
+    while ((request = list_pop(&completed))) {
+        request->callback(request_result(request), request->user_data);
+        release_request(request);
+    }
+}
+
+async_read_handle async_io_read(const async_read_info* info) {
+    if (!state_ptr || !info || !info->path) {
+        return 0;
+    }
+    if (info->buffer && info->size == 0) {
+        KERROR("async_io_read - a size is required when reading into a supplied buffer.");
+        return 0;
+    }
+    if (string_length(info->path) >= ASYNC_IO_MAX_PATH_LENGTH) {
+        KERROR("async_io_read - path is too long: '%s'", info->path);
+        return 0;
+    }
+
+    kmutex_lock(&state_ptr->request_lock);
+    if (!state_ptr->running) {
+        kmutex_unlock(&state_ptr->request_lock);
+        return 0;
+    }
+    if (state_ptr->free_request_count == 0) {
+        kmutex_unlock(&state_ptr->request_lock);
+        KWARN("async_io_read - all %u requests are in use.", state_ptr->config.max_request_count);
+        return 0;
+    }
+    u32 index = state_ptr->free_requests[--state_ptr->free_request_count];
+    async_request* request = &state_ptr->requests[index];
+    request->in_use = true;
+    u32 generation = request->generation;
+    katomic_fetch_add_i32(&state_ptr->outstanding, 1, KATOMIC_RELAXED);
+    kmutex_unlock(&state_ptr->request_lock);
+
+    string_ncopy(request->path, info->path, ASYNC_IO_MAX_PATH_LENGTH);
+    request->offset = info->offset;
+    request->size = info->size;
+    request->data = info->buffer;
+    request->owns_data = false;
+    request->bytes_read = 0;
+    request->callback = info->callback;
+    request->user_data = info->user_data;
+    request->counter = info->counter;
+    request->file = -1;
+    request->next = 0;
+    katomic_store_i32(&request->status, ASYNC_READ_STATUS_PENDING, KATOMIC_RELEASE);
+    if (request->counter) {
+        job_counter_increment(request->counter);
+    }
+
+    // worked out up front, as the request may be finished and collected before the submit below returns
+    async_read_handle handle = ((u64)generation << 32) | (u64)(index + 1);
+
+#ifdef KOHI_IO_URING
+    if (state_ptr->using_io_uring) {
+        // opening is cheap next to the read, so it is done here rather than bounced through another thread
+        if (!prepare_request(request)) {
+            finish_request(request, false);
+        } else if (request->size == 0) {
+            finish_request(request, true);
+        } else {
+            ring_submit(&state_ptr->ring, request);
+        }
+        return handle;
+    }
+#endif
+
+    kmutex_lock(&state_ptr->pending_lock);
+    list_push(&state_ptr->pending, request);
+    kmutex_unlock(&state_ptr->pending_lock);
+    ksemaphore_signal(&state_ptr->pending_available);
+    return handle;
+}
+
+b8 async_io_poll(async_read_handle handle, async_read_result* out_result) {
+    if (!state_ptr || !handle || !out_result) {
+        return false;
+    }
+    u32 index = (u32)(handle & 0xFFFFFFFFULL) - 1;
+    u32 generation = (u32)(handle >> 32);
+    if (index >= state_ptr->config.max_request_count) {
+        return false;
+    }
+
+    async_request* request = &state_ptr->requests[index];
+    kmutex_lock(&state_ptr->request_lock);
+    b8 valid = request->in_use && request->generation == generation && !request->callback;
+    kmutex_unlock(&state_ptr->request_lock);
+    if (!valid) {
+        KWARN("async_io_poll - invalid handle, or the read was submitted with a callback.");
+        return false;
+    }
+    if (katomic_load_i32(&request->status, KATOMIC_ACQUIRE) == ASYNC_READ_STATUS_PENDING) {
+        return false;
+    }
+
+    *out_result = request_result(request);
+    release_request(request);
+    return true;
+}
+
+b8 async_io_read_file_wait(const char* path, void** out_data, u64* out_size) {
+    *out_data = 0;
+    *out_size = 0;
+
+    if (state_ptr) {
+        job_counter counter = {};
+        async_read_info info = {};
+        info.path = path;
+        info.counter = &counter;
+        async_read_handle handle = async_io_read(&info);
+        if (handle) {
+            job_system_wait(&counter);
+            async_read_result result;
+            if (!async_io_poll(handle, &result) || result.status != ASYNC_READ_STATUS_COMPLETE) {
+                return false;
+            }
+            *out_data = result.data;
+            *out_size = result.size;
+            return true;
+        }
+        // out of requests, so just read it here instead
+    }
+
+    i64 file = -1;
+    u64 size = 0;
+    if (!file_open(path, &file, &size)) {
+        KERROR("async_io_read_file_wait - unable to open file: '%s'", path);
+        return false;
+    }
+    u8* data = size ? kallocate(size, MEMORY_TAG_ARRAY) : 0;
+    u64 total = 0;
+    while (total < size) {
+        i64 read = file_read_at(file, data + total, size - total, total);
+        if (read <= 0) {
+            KERROR("async_io_read_file_wait - read failed part way through file: '%s'", path);
+            kfree(data, size, MEMORY_TAG_ARRAY);
+            file_close(file);
+            return false;
+        }
+        total += read;
+    }
+    file_close(file);
+    *out_data = data;
+    *out_size = size;
+    return true;
+}
+
+b8 async_io_is_using_io_uring() {
+    return state_ptr && state_ptr->using_io_uring;
+}
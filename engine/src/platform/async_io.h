@@ -0,0 +1,90 @@
+#pragma once
+
+#include "defines.h"
+#include "systems/job_system.h"
+
+// @brief identifies an in flight read. 0 is never a valid handle
+typedef u64 async_read_handle;
+
+typedef enum async_read_status {
+    ASYNC_READ_STATUS_PENDING = 0,
+    ASYNC_READ_STATUS_COMPLETE = 1,
+    ASYNC_READ_STATUS_FAILED = 2
+} async_read_status;
+
+// @brief the outcome of a read
+typedef struct async_read_result {
+    async_read_status status;
+    // @brief the bytes read. if the request did not supply its own buffer, this was allocated by the read and now
+    // belongs to whoever received the result. free it with kfree(data, size, MEMORY_TAG_ARRAY). 0 on failure
+    void* data;
+    // @brief the number of bytes read
+    u64 size;
+} async_read_result;
+
+// @brief called on the main thread (from async_io_update) once a read has finished, successfully or not
+typedef void (*pfn_async_read_complete)(async_read_result result, void* user_data);
+
+// @brief everything needed to start a read. copied on submit, so it can live on the stack
+typedef struct async_read_info {
+    // @brief the path of the file to read. required
+    const char* path;
+    // @brief where in the file to start reading from
+    u64 offset;
+    // @brief the number of bytes to read. 0 reads everything from offset to the end of the file
+    u64 size;
+    // @brief optional buffer to read into, which must be at least size bytes. if 0, one is allocated for the read
+    void* buffer;
+    // @brief optional. if set, it is called with the result and the handle is released automatically. if not, the
+    // result must be collected with async_io_poll
+    pfn_async_read_complete callback;
+    // @brief passed to the callback
+    void* user_data;
+    // @brief optional counter, incremented on submit and decremented once the read finishes (before the callback
+    // runs). lets a fiber job park on the read with job_system_wait, leaving the worker free for other jobs
+    job_counter* counter;
+} async_read_info;
+
+typedef struct async_io_config {
+    // @brief the max number of reads that can be in flight (submitted but not yet collected) at once
+    u32 max_request_count;
+    // @brief the number of threads servicing reads when io_uring is not available (or force_fallback is set)
+    u8 fallback_thread_count;
+    // @brief skip io_uring and always use the thread pool
+    b8 force_fallback;
+} async_io_config;
+
+// initialize the async io system, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
+// on the second pass - pass in the state as well as the memory requirement and actually initialize the system
+KAPI b8 async_io_initialize(u64* memory_requirement, void* state, async_io_config config);
+
+// shut down the async io system. waits for reads already in flight, then drops any results that were not collected
+KAPI void async_io_shutdown(void* state);
+
+// @brief runs the callbacks of any reads that finished since the last call. must be called on the main thread, once per frame
+KAPI void async_io_update();
+
+// @brief starts reading from a file without blocking the caller
+// @param info the read to start
+// @return a handle to the read, or 0 if it could not be started (in which case no callback is run, and the counter is
+// left untouched)
+KAPI async_read_handle async_io_read(const async_read_info* info);
+
+// @brief checks if a read submitted without a callback has finished. once this returns true the handle is released,
+// and the result belongs to the caller
+// @param handle the read to check
+// @param out_result a pointer to hold the result
+// @return true if the read has finished, false if it is still pending (or the handle is not valid)
+KAPI b8 async_io_poll(async_read_handle handle, async_read_result* out_result);
+
+// @brief reads a whole file, blocking until it is done. inside a fiber job the fiber is parked for the length of the
+// read instead, so many of these can be in flight at once from loader jobs. falls back to a plain read if the async
+// io system is not running
+// @param path the path of the file to read
+// @param out_data a pointer to hold the file contents. free with kfree(data, size, MEMORY_TAG_ARRAY)
+// @param out_size a pointer to hold the size of the file
+// @return true on success, otherwise false
+KAPI b8 async_io_read_file_wait(const char* path, void** out_data, u64* out_size);
+
+// @brief indicates if reads are being serviced by io_uring, rather than the fallback thread pool
+KAPI b8 async_io_is_using_io_uring();
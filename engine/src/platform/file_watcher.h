@@ -0,0 +1,35 @@
+#pragma once
+
+#include "defines.h"
+
+// the longest path reported by a watcher, relative to the watched directory
+#define FILE_WATCHER_MAX_PATH_LENGTH 512
+
+// @brief watches a directory (and everything below it) for files being written
+typedef struct file_watcher {
+    // @brief platform specific data for the watcher
+    void* internal_data;
+} file_watcher;
+
+// @brief called once for each file that was written
+// @param path the path of the file, relative to the watched directory and using forward slashes, such as
+// "textures/cobblestone.png"
+// @param user_data the user_data passed to file_watcher_poll
+typedef void (*pfn_file_watcher_callback)(const char* path, void* user_data);
+
+// @brief starts watching a directory and all of its subdirectories, including ones created later
+// @param directory the path of the directory to watch
+// @param out_watcher a pointer to hold the watcher
+// @return true on success, otherwise false. always false on platforms without a watcher
+KAPI b8 file_watcher_create(const char* directory, file_watcher* out_watcher);
+
+// @brief stops watching and frees everything held by the watcher
+KAPI void file_watcher_destroy(file_watcher* watcher);
+
+// @brief reports every file that has finished being written since the last poll. never blocks. a file can be reported
+// more than once for what looks like a single save, as editors often write in several steps
+// @param watcher a pointer to the watcher
+// @param callback called for each file that was written
+// @param user_data passed to the callback. optional
+// @return the number of files reported
+KAPI u32 file_watcher_poll(file_watcher* watcher, pfn_file_watcher_callback callback, void* user_data);
@@ -7,6 +7,16 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#if KPLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <dirent.h>
+#endif
+
+// the longest path filesystem_walk_directory will build
+#define FILESYSTEM_MAX_WALK_PATH 512
+
 b8 filesystem_exists(const char* path) {
 #ifdef _MSC_VER
     struct _stat buffer;
@@ -156,4 +166,223 @@ b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* o
     }
     // if there wasnt a handle to a file handle
     return false;
-}
\ No newline at end of file
+}
+
+b8 filesystem_rename(const char* from, const char* to) {
+#if KPLATFORM_WINDOWS
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+#if KPLATFORM_WINDOWS
+b8 filesystem_map(const char* path, file_access_pattern pattern, file_mapping* out_mapping) {
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+    // the access pattern on windows is a hint to the cache manager, given when the file is opened
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (pattern == FILE_ACCESS_PATTERN_SEQUENTIAL) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (pattern == FILE_ACCESS_PATTERN_RANDOM) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        KERROR("filesystem_map - unable to open file: '%s'", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        KERROR("filesystem_map - unable to get the size of file: '%s'", path);
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {
+        // nothing to map, which is not an error
+        CloseHandle(file);
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    // the view keeps the mapping (and the file) alive by itself, so the handles can go straight away
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!data) {
+        KERROR("filesystem_map - unable to map file: '%s'", path);
+        return false;
+    }
+
+    out_mapping->data = data;
+    out_mapping->size = (u64)size.QuadPart;
+    return true;
+}
+
+void filesystem_unmap(file_mapping* mapping) {
+    if (mapping->data) {
+        UnmapViewOfFile(mapping->data);
+    }
+    mapping->data = 0;
+    mapping->size = 0;
+}
+#else
+b8 filesystem_map(const char* path, file_access_pattern pattern, file_mapping* out_mapping) {
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+    // NOTE: opened through stdio just for the descriptor, as fcntl.h clashes with file_handle on some systems
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        KERROR("filesystem_map - unable to open file: '%s'", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fileno(file), &info) != 0) {
+        KERROR("filesystem_map - unable to get the size of file: '%s'", path);
+        fclose(file);
+        return false;
+    }
+    if (info.st_size == 0) {
+        // mmap refuses a length of 0. nothing to map, which is not an error
+        fclose(file);
+        return true;
+    }
+
+    void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    // the mapping holds its own reference to the file
+    fclose(file);
+    if (data == MAP_FAILED) {
+        KERROR("filesystem_map - unable to map file: '%s'", path);
+        return false;
+    }
+
+    // hints only, so failure here is not worth reporting
+    if (pattern == FILE_ACCESS_PATTERN_SEQUENTIAL) {
+        madvise(data, info.st_size, MADV_SEQUENTIAL);
+        // start reading ahead now, rather than on the first fault
+        madvise(data, info.st_size, MADV_WILLNEED);
+    } else if (pattern == FILE_ACCESS_PATTERN_RANDOM) {
+        madvise(data, info.st_size, MADV_RANDOM);
+    }
+
+    out_mapping->data = data;
+    out_mapping->size = (u64)info.st_size;
+    return true;
+}
+
+void filesystem_unmap(file_mapping* mapping) {
+    if (mapping->data) {
+        munmap((void*)mapping->data, mapping->size);
+    }
+    mapping->data = 0;
+    mapping->size = 0;
+}
+#endif
+
+// path holds the directory being walked, with the relative part of it starting at relative_offset
+#if KPLATFORM_WINDOWS
+static b8 walk_directory(char* path, u64 length, u64 relative_offset, pfn_filesystem_walk callback, void* user_data) {
+    if (length + 3 >= FILESYSTEM_MAX_WALK_PATH) {
+        KERROR("filesystem_walk_directory - path too long: '%s'", path);
+        return false;
+    }
+    strcpy(path + length, "/*");
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(path, &find_data);
+    path[length] = 0;
+    if (find == INVALID_HANDLE_VALUE) {
+        KERROR("filesystem_walk_directory - unable to open directory: '%s'", path);
+        return false;
+    }
+
+    b8 result = true;
+    do {
+        const char* name = find_data.cFileName;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        u64 name_length = strlen(name);
+        if (length + 1 + name_length >= FILESYSTEM_MAX_WALK_PATH) {
+            KWARN("filesystem_walk_directory - skipping '%s/%s', the path is too long.", path, name);
+            continue;
+        }
+        path[length] = '/';
+        strcpy(path + length + 1, name);
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            result = walk_directory(path, length + 1 + name_length, relative_offset, callback, user_data) && result;
+        } else {
+            u64 size = ((u64)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+            callback(path + relative_offset, size, user_data);
+        }
+        path[length] = 0;
+    } while (FindNextFileA(find, &find_data));
+
+    FindClose(find);
+    return result;
+}
+#else
+static b8 walk_directory(char* path, u64 length, u64 relative_offset, pfn_filesystem_walk callback, void* user_data) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        KERROR("filesystem_walk_directory - unable to open directory: '%s'", path);
+        return false;
+    }
+
+    b8 result = true;
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        const char* name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        u64 name_length = strlen(name);
+        if (length + 1 + name_length >= FILESYSTEM_MAX_WALK_PATH) {
+            KWARN("filesystem_walk_directory - skipping '%s/%s', the path is too long.", path, name);
+            continue;
+        }
+        path[length] = '/';
+        strcpy(path + length + 1, name);
+
+        // d_type is not filled in on every file system, so stat is the reliable way to tell
+        struct stat info;
+        if (stat(path, &info) == 0) {
+            if (S_ISDIR(info.st_mode)) {
+                result = walk_directory(path, length + 1 + name_length, relative_offset, callback, user_data) && result;
+            } else if (S_ISREG(info.st_mode)) {
+                callback(path + relative_offset, (u64)info.st_size, user_data);
+            }
+        }
+        path[length] = 0;
+    }
+
+    closedir(dir);
+    return result;
+}
+#endif
+
+b8 filesystem_walk_directory(const char* path, pfn_filesystem_walk callback, void* user_data) {
+    if (!path || !callback) {
+        return false;
+    }
+    char buffer[FILESYSTEM_MAX_WALK_PATH];
+    u64 length = strlen(path);
+    // a trailing separator would otherwise end up doubled
+    while (length > 1 && (path[length - 1] == '/' || path[length - 1] == '\\')) {
+        length--;
+    }
+    if (length + 1 >= FILESYSTEM_MAX_WALK_PATH) {
+        KERROR("filesystem_walk_directory - path too long: '%s'", path);
+        return false;
+    }
+    memcpy(buffer, path, length);
+    buffer[length] = 0;
+    // relative paths start after the separator that follows the root
+    return walk_directory(buffer, length, length + 1, callback, user_data);
+}
@@ -15,6 +15,23 @@ typedef enum file_modes {
     FILE_MODE_WRITE = 0x2
 } file_modes;
 
+// @brief a hint for how a mapped file is going to be read, so the os can read ahead (or not) to suit
+typedef enum file_access_pattern {
+    FILE_ACCESS_PATTERN_NORMAL = 0,
+    // @brief read front to back. pages are read ahead aggressively
+    FILE_ACCESS_PATTERN_SEQUENTIAL = 1,
+    // @brief jumped around in. read ahead is turned off, so only the pages actually touched are read
+    FILE_ACCESS_PATTERN_RANDOM = 2
+} file_access_pattern;
+
+// @brief a read only view of an entire file, mapped into memory
+typedef struct file_mapping {
+    // @brief the contents of the file. 0 if the file is empty
+    const void* data;
+    // @brief the size of the file in bytes
+    u64 size;
+} file_mapping;
+
 // checks if a file with the given path exists
 // @param path the path of the file to be checked
 // @returns true if exists, otherwise false
@@ -82,3 +99,37 @@ KAPI b8 filesystem_read_all_text(file_handle* handle, char* out_text, u64* out_b
 // @param out_bytes_written a pointer to a number which will be populated with the number of bytes actually written to the file
 // @returns true is a success, and false otherwise
 KAPI b8 filesystem_write(file_handle* handle, u64 data_size, const void* data, u64* out_bytes_written);
+
+// @brief moves a file, replacing anything already at the new path. within one volume the swap is atomic, so anything
+// that still has the old file open or mapped goes on seeing the old contents, and nothing ever sees a partial file
+// @param from the path of the file to move
+// @param to where to move it
+// @return true on success, otherwise false
+KAPI b8 filesystem_rename(const char* from, const char* to);
+
+// @brief maps the whole of a file into memory, read only. pages are only read from disk as they are first touched, and
+// nothing is copied into a separate buffer, so parsing straight out of data is as cheap as reading a file gets. the
+// mapping does not depend on any open file_handle, and stays valid until filesystem_unmap
+// @param path the path of the file to map
+// @param pattern how the data will be read
+// @param out_mapping a pointer to hold the mapping
+// @return true on success, otherwise false
+KAPI b8 filesystem_map(const char* path, file_access_pattern pattern, file_mapping* out_mapping);
+
+// @brief unmaps a file mapped with filesystem_map. data must not be used after this
+// @param mapping a pointer to the mapping to unmap
+KAPI void filesystem_unmap(file_mapping* mapping);
+
+// @brief called once for each file found by filesystem_walk_directory
+// @param path the path of the file relative to the directory being walked, always with forward slashes. only valid for the
+// length of the call
+// @param size the size of the file in bytes
+// @param user_data the user data passed to filesystem_walk_directory
+typedef void (*pfn_filesystem_walk)(const char* path, u64 size, void* user_data);
+
+// @brief visits every file in a directory, and all of its subdirectories. order is whatever the os returns
+// @param path the path of the directory to walk
+// @param callback called for each file
+// @param user_data passed to the callback
+// @return true if everything could be walked, otherwise false
+KAPI b8 filesystem_walk_directory(const char* path, pfn_filesystem_walk callback, void* user_data);
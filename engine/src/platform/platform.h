@@ -35,7 +35,13 @@ void platform_console_write_error(const char* message, u8 colour);
 // also need a way to retrieve the time in the platform layer - this is done differently one each platform
 f64 platform_get_absolute_time();
 
+// @brief the same clock as platform_get_absolute_time, in whole nanoseconds. cheaper to read and to do maths on, used for profiling
+u64 platform_get_absolute_time_ns();
+
 // Sleep on the thread for the provided ms this blocks the main thread. ---miliseconds(ms)
 // Should only be used for giving time back to the OS for unused uopdate power.
 // therefore it is not exported.
-void platform_sleep(u64 ms);
\ No newline at end of file
+void platform_sleep(u64 ms);
+
+// @brief obtains the number of logical processor cores on the system. used to size things like the job system worker pool
+i32 platform_get_processor_count();
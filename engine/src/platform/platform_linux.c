@@ -3,6 +3,11 @@
 // dont even really understand how linux works, so this was all very confusing
 // this file will not collide with the win32 c file, so if it is i fucked it up somewhere along the way
 
+// needed for the pthread affinity and naming extensions. has to come before any system header is pulled in
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "platform.h"
 
 // Linux platform layer.
@@ -11,6 +16,14 @@
 #include "core/logger.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kcondvar.h"
+#include "core/kfiber.h"
+#include "core/katomic.h"
+#include "core/kstring.h"
+#include "platform/file_watcher.h"
 
 #include "containers/darray.h"
 
@@ -20,6 +33,18 @@
 #include <X11/Xlib.h>
 #include <X11/Xlib-xcb.h>  // sudo apt-get install libxkbcommon-x11-dev libx11-xcb-dev
 #include <sys/time.h>
+#include <sys/sysinfo.h>  // get_nprocs
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>  // syscall
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 #if _POSIX_C_SOURCE >= 199309L
 #include <time.h>  // nanosleep
@@ -317,6 +342,12 @@ f64 platform_get_absolute_time() {
     return now.tv_sec + now.tv_nsec * 0.000000001;
 }
 
+u64 platform_get_absolute_time_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
+}
+
 void platform_sleep(u64 ms) {
 #if _POSIX_C_SOURCE >= 199309L
     struct timespec ts;
@@ -331,6 +362,591 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+i32 platform_get_processor_count() {
+    // get_nprocs_conf would include cores that are currently offline
+    return get_nprocs();
+}
+
+// NOTE: begin threads
+// pthreads want a void* (*)(void*), so the start function and params are carried through this to a trampoline
+typedef struct linux_thread_start {
+    pfn_thread_start function;
+    void* params;
+} linux_thread_start;
+
+static void* linux_thread_entry(void* arg) {
+    linux_thread_start start = *(linux_thread_start*)arg;
+    platform_free(arg, false);
+    return (void*)(u64)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        return false;
+    }
+
+    linux_thread_start* start = platform_allocate(sizeof(linux_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t handle;
+    i32 result = pthread_create(&handle, 0, linux_thread_entry, start);
+    if (result != 0) {
+        platform_free(start, false);
+        KERROR("kthread_create - failed to create thread: %s", strerror(result));
+        return false;
+    }
+
+    out_thread->thread_id = (u64)handle;
+    out_thread->internal_data = 0;
+    return true;
+}
+
+b8 kthread_wait(kthread* thread) {
+    if (!thread || !thread->thread_id) {
+        return false;
+    }
+    i32 result = pthread_join((pthread_t)thread->thread_id, 0);
+    if (result != 0) {
+        KERROR("kthread_wait - failed to join thread: %s", strerror(result));
+        return false;
+    }
+    thread->thread_id = 0;
+    return true;
+}
+
+b8 kthread_detach(kthread* thread) {
+    if (!thread || !thread->thread_id) {
+        return false;
+    }
+    i32 result = pthread_detach((pthread_t)thread->thread_id);
+    if (result != 0) {
+        KERROR("kthread_detach - failed to detach thread: %s", strerror(result));
+        return false;
+    }
+    thread->thread_id = 0;
+    return true;
+}
+
+void kthread_yield() {
+    sched_yield();
+}
+
+u64 kthread_get_current_id() {
+    return (u64)pthread_self();
+}
+
+b8 kthread_set_affinity(kthread* thread, u32 processor_index) {
+    if (!thread || !thread->thread_id || processor_index >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor_index, &set);
+    i32 result = pthread_setaffinity_np((pthread_t)thread->thread_id, sizeof(cpu_set_t), &set);
+    if (result != 0) {
+        KWARN("kthread_set_affinity - failed to set affinity to processor %u: %s", processor_index, strerror(result));
+        return false;
+    }
+    return true;
+}
+
+b8 kthread_set_name(kthread* thread, const char* name) {
+    if (!thread || !thread->thread_id || !name) {
+        return false;
+    }
+    // linux only allows 16 characters, including the terminator, and fails outright on anything longer
+    char truncated[16];
+    string_ncopy(truncated, name, 15);
+    truncated[15] = 0;
+    return pthread_setname_np((pthread_t)thread->thread_id, truncated) == 0;
+}
+
+b8 ktls_slot_create(ktls_slot* out_slot) {
+    if (!out_slot) {
+        return false;
+    }
+    pthread_key_t key;
+    i32 result = pthread_key_create(&key, 0);
+    if (result != 0) {
+        KERROR("ktls_slot_create - failed to create slot: %s", strerror(result));
+        return false;
+    }
+    out_slot->key = (u64)key;
+    return true;
+}
+
+void ktls_slot_destroy(ktls_slot* slot) {
+    if (slot) {
+        pthread_key_delete((pthread_key_t)slot->key);
+    }
+}
+
+b8 ktls_slot_set(ktls_slot* slot, void* value) {
+    return slot && pthread_setspecific((pthread_key_t)slot->key, value) == 0;
+}
+
+void* ktls_slot_get(ktls_slot* slot) {
+    return slot ? pthread_getspecific((pthread_key_t)slot->key) : 0;
+}
+// NOTE: end threads
+
+// NOTE: begin mutexes
+b8 kmutex_create(kmutex* out_mutex) {
+    if (!out_mutex) {
+        return false;
+    }
+    pthread_mutex_t* mutex = platform_allocate(sizeof(pthread_mutex_t), false);
+    i32 result = pthread_mutex_init(mutex, 0);
+    if (result != 0) {
+        platform_free(mutex, false);
+        KERROR("kmutex_create - failed to create mutex: %s", strerror(result));
+        return false;
+    }
+    out_mutex->internal_data = mutex;
+    return true;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_try_lock(kmutex* mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return pthread_mutex_trylock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+// NOTE: end mutexes
+
+// NOTE: begin semaphores
+// semaphores sit directly on a futex. the fast path (count above zero) never enters the kernel, and the futex wait
+// timeout is relative on the monotonic clock, so a wall clock change can't stretch or cut short a timed wait
+typedef struct linux_semaphore {
+    volatile i32 count;
+    volatile i32 waiter_count;
+} linux_semaphore;
+
+static i64 futex_wait(volatile i32* address, i32 expected, const struct timespec* timeout) {
+    return syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, timeout, 0, 0);
+}
+
+static i64 futex_wake(volatile i32* address, i32 count) {
+    return syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+b8 ksemaphore_create(u32 start_count, ksemaphore* out_semaphore) {
+    if (!out_semaphore) {
+        return false;
+    }
+    linux_semaphore* semaphore = platform_allocate(sizeof(linux_semaphore), false);
+    semaphore->count = (i32)start_count;
+    semaphore->waiter_count = 0;
+    out_semaphore->internal_data = semaphore;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        platform_free(semaphore->internal_data, false);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    linux_semaphore* s = semaphore->internal_data;
+    katomic_fetch_add_i32(&s->count, 1, KATOMIC_SEQ_CST);
+    // only bother the kernel if somebody is actually asleep
+    if (katomic_load_i32(&s->waiter_count, KATOMIC_SEQ_CST) > 0) {
+        futex_wake(&s->count, 1);
+    }
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    linux_semaphore* s = semaphore->internal_data;
+    f64 deadline = timeout_ms == KSEMAPHORE_WAIT_INFINITE ? 0 : platform_get_absolute_time() + (timeout_ms / 1000.0);
+
+    while (true) {
+        // take one if there is one to take
+        i32 count = katomic_load_i32(&s->count, KATOMIC_ACQUIRE);
+        while (count > 0) {
+            if (katomic_compare_exchange_i32(&s->count, &count, count - 1, KATOMIC_SEQ_CST)) {
+                return true;
+            }
+        }
+
+        struct timespec ts;
+        struct timespec* timeout = 0;
+        if (timeout_ms != KSEMAPHORE_WAIT_INFINITE) {
+            f64 remaining = deadline - platform_get_absolute_time();
+            if (remaining <= 0) {
+                return false;
+            }
+            ts.tv_sec = (time_t)remaining;
+            ts.tv_nsec = (long)((remaining - (f64)ts.tv_sec) * 1000000000.0);
+            timeout = &ts;
+        }
+
+        // the kernel only puts this thread to sleep if count is still 0, so a signal between the check above and
+        // here is never lost. EAGAIN, EINTR and ETIMEDOUT all just go back around the loop
+        katomic_fetch_add_i32(&s->waiter_count, 1, KATOMIC_SEQ_CST);
+        futex_wait(&s->count, 0, timeout);
+        katomic_fetch_add_i32(&s->waiter_count, -1, KATOMIC_SEQ_CST);
+    }
+}
+// NOTE: end semaphores
+
+// NOTE: begin condition variables
+b8 kcondvar_create(kcondvar* out_condvar) {
+    if (!out_condvar) {
+        return false;
+    }
+    // use the monotonic clock for timed waits rather than the default realtime one
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_t* cond = platform_allocate(sizeof(pthread_cond_t), false);
+    i32 result = pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (result != 0) {
+        platform_free(cond, false);
+        KERROR("kcondvar_create - failed to create condition variable: %s", strerror(result));
+        return false;
+    }
+    out_condvar->internal_data = cond;
+    return true;
+}
+
+void kcondvar_destroy(kcondvar* condvar) {
+    if (condvar && condvar->internal_data) {
+        pthread_cond_destroy(condvar->internal_data);
+        platform_free(condvar->internal_data, false);
+        condvar->internal_data = 0;
+    }
+}
+
+b8 kcondvar_wait(kcondvar* condvar, kmutex* mutex, u64 timeout_ms) {
+    if (!condvar || !condvar->internal_data || !mutex || !mutex->internal_data) {
+        return false;
+    }
+    if (timeout_ms == KCONDVAR_WAIT_INFINITE) {
+        return pthread_cond_wait(condvar->internal_data, mutex->internal_data) == 0;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(condvar->internal_data, mutex->internal_data, &ts) == 0;
+}
+
+b8 kcondvar_signal(kcondvar* condvar) {
+    return condvar && condvar->internal_data && pthread_cond_signal(condvar->internal_data) == 0;
+}
+
+b8 kcondvar_broadcast(kcondvar* condvar) {
+    return condvar && condvar->internal_data && pthread_cond_broadcast(condvar->internal_data) == 0;
+}
+// NOTE: end condition variables
+
+// NOTE: begin fibers
+// built on ucontext. swapcontext also saves and restores the signal mask, which costs a syscall per switch, but that
+// is still well under what loader style jobs spend between switches
+typedef struct linux_fiber {
+    ucontext_t context;
+    void* stack;      // 0 for a thread's own fiber
+    u64 stack_size;   // including the guard page
+    pfn_fiber_start start;
+    void* params;
+} linux_fiber;
+
+// makecontext only passes ints, so the fiber pointer comes through in two halves
+static void linux_fiber_entry(u32 low, u32 high) {
+    linux_fiber* fiber = (linux_fiber*)(((u64)high << 32) | (u64)low);
+    fiber->start(fiber->params);
+    // start functions must never return, as there is nowhere to return to
+    KFATAL("A fiber start function returned. This is not allowed.");
+    abort();
+}
+
+b8 kfiber_create_from_thread(kfiber* out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy_from_thread(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        platform_free(fiber->internal_data, false);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void* params, kfiber* out_fiber) {
+    if (!start_function_ptr || !out_fiber) {
+        return false;
+    }
+
+    // a guard page at the bottom of the stack turns an overflow into a crash instead of silent corruption
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 total_size = get_aligned(stack_size, page_size) + page_size;
+    void* stack = mmap(0, total_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        KERROR("kfiber_create - failed to allocate a %llu byte stack: %s", total_size, strerror(errno));
+        return false;
+    }
+    mprotect(stack, page_size, PROT_NONE);
+
+    linux_fiber* fiber = platform_allocate(sizeof(linux_fiber), false);
+    platform_zero_memory(fiber, sizeof(linux_fiber));
+    fiber->stack = stack;
+    fiber->stack_size = total_size;
+    fiber->start = start_function_ptr;
+    fiber->params = params;
+
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = (u8*)stack + page_size;
+    fiber->context.uc_stack.ss_size = total_size - page_size;
+    fiber->context.uc_link = 0;
+    u64 address = (u64)fiber;
+    makecontext(&fiber->context, (void (*)())linux_fiber_entry, 2, (u32)(address & 0xFFFFFFFF), (u32)(address >> 32));
+
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+    if (fiber && fiber->internal_data) {
+        linux_fiber* f = fiber->internal_data;
+        if (f->stack) {
+            munmap(f->stack, f->stack_size);
+        }
+        platform_free(f, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber* from, kfiber* to) {
+    linux_fiber* from_fiber = from->internal_data;
+    linux_fiber* to_fiber = to->internal_data;
+    swapcontext(&from_fiber->context, &to_fiber->context);
+}
+// NOTE: end fibers
+
+// NOTE: begin file watcher
+// inotify only watches a single directory, not what is below it, so every subdirectory gets a watch of its own
+typedef struct linux_watched_directory {
+    i32 descriptor;
+    // relative to the watched directory. empty for the watched directory itself
+    char path[FILE_WATCHER_MAX_PATH_LENGTH];
+} linux_watched_directory;
+
+typedef struct linux_file_watcher {
+    i32 fd;
+    char root[FILE_WATCHER_MAX_PATH_LENGTH];
+    // darray
+    linux_watched_directory* directories;
+} linux_file_watcher;
+
+// close_write covers files saved in place, moved_to covers the write to a temp file and rename that most editors and
+// tools do. create is only there for directories, files are not reported until they are closed
+#define LINUX_FILE_WATCHER_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR)
+
+static linux_watched_directory* linux_file_watcher_find(linux_file_watcher* watcher, i32 descriptor) {
+    u64 count = darray_length(watcher->directories);
+    for (u64 i = 0; i < count; ++i) {
+        if (watcher->directories[i].descriptor == descriptor) {
+            return &watcher->directories[i];
+        }
+    }
+    return 0;
+}
+
+static void linux_file_watcher_join(char* out_path, const char* directory, const char* name) {
+    if (directory[0]) {
+        snprintf(out_path, FILE_WATCHER_MAX_PATH_LENGTH, "%s/%s", directory, name);
+    } else {
+        snprintf(out_path, FILE_WATCHER_MAX_PATH_LENGTH, "%s", name);
+    }
+}
+
+// watches a directory and everything below it. when callback is set, the files already in there are reported as well,
+// since a directory that has just been created can be written into before the watch on it exists
+static void linux_file_watcher_add_tree(linux_file_watcher* watcher, const char* relative_path, pfn_file_watcher_callback callback, void* user_data, u32* report_count) {
+    char full_path[FILE_WATCHER_MAX_PATH_LENGTH];
+    linux_file_watcher_join(full_path, watcher->root, relative_path);
+
+    i32 descriptor = inotify_add_watch(watcher->fd, full_path, LINUX_FILE_WATCHER_MASK);
+    if (descriptor < 0) {
+        KWARN("file_watcher - failed to watch '%s': %s", full_path, strerror(errno));
+        return;
+    }
+    // watching the same directory twice gives back the same descriptor, nothing more to do
+    if (linux_file_watcher_find(watcher, descriptor)) {
+        return;
+    }
+    linux_watched_directory directory;
+    directory.descriptor = descriptor;
+    snprintf(directory.path, FILE_WATCHER_MAX_PATH_LENGTH, "%s", relative_path);
+    darray_push(watcher->directories, directory);
+
+    DIR* dir = opendir(full_path);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        char child_path[FILE_WATCHER_MAX_PATH_LENGTH];
+        linux_file_watcher_join(child_path, relative_path, entry->d_name);
+
+        b8 is_directory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            // not every file system fills in the type
+            char child_full_path[FILE_WATCHER_MAX_PATH_LENGTH];
+            linux_file_watcher_join(child_full_path, watcher->root, child_path);
+            struct stat info;
+            is_directory = stat(child_full_path, &info) == 0 && S_ISDIR(info.st_mode);
+        }
+
+        if (is_directory) {
+            linux_file_watcher_add_tree(watcher, child_path, callback, user_data, report_count);
+        } else if (callback) {
+            callback(child_path, user_data);
+            (*report_count)++;
+        }
+    }
+    closedir(dir);
+}
+
+b8 file_watcher_create(const char* directory, file_watcher* out_watcher) {
+    if (!directory || !out_watcher) {
+        return false;
+    }
+    out_watcher->internal_data = 0;
+
+    i32 fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        KERROR("file_watcher_create - inotify_init1 failed: %s", strerror(errno));
+        return false;
+    }
+
+    linux_file_watcher* watcher = platform_allocate(sizeof(linux_file_watcher), false);
+    watcher->fd = fd;
+    snprintf(watcher->root, FILE_WATCHER_MAX_PATH_LENGTH, "%s", directory);
+    watcher->directories = darray_create(linux_watched_directory);
+    linux_file_watcher_add_tree(watcher, "", 0, 0, 0);
+    if (darray_length(watcher->directories) == 0) {
+        // the directory itself could not be watched
+        darray_destroy(watcher->directories);
+        close(fd);
+        platform_free(watcher, false);
+        return false;
+    }
+
+    out_watcher->internal_data = watcher;
+    return true;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+    if (watcher && watcher->internal_data) {
+        linux_file_watcher* w = watcher->internal_data;
+        // closing the descriptor drops every watch on it
+        close(w->fd);
+        darray_destroy(w->directories);
+        platform_free(w, false);
+        watcher->internal_data = 0;
+    }
+}
+
+u32 file_watcher_poll(file_watcher* watcher, pfn_file_watcher_callback callback, void* user_data) {
+    if (!watcher || !watcher->internal_data || !callback) {
+        return 0;
+    }
+    linux_file_watcher* w = watcher->internal_data;
+
+    u32 report_count = 0;
+    u8 buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (true) {
+        ssize_t length = read(w->fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN, nothing left to read
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            linux_watched_directory* directory = linux_file_watcher_find(w, event->wd);
+            if (!directory) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // the directory was deleted or moved away. swap the last one into its place
+                u64 count = darray_length(w->directories);
+                *directory = w->directories[count - 1];
+                darray_length_set(w->directories, count - 1);
+                continue;
+            }
+            if (!event->len) {
+                continue;
+            }
+
+            // built before anything is added, which could move the directories around
+            char path[FILE_WATCHER_MAX_PATH_LENGTH];
+            linux_file_watcher_join(path, directory->path, event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    linux_file_watcher_add_tree(w, path, callback, user_data, &report_count);
+                }
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                callback(path, user_data);
+                report_count++;
+            }
+        }
+    }
+
+    return report_count;
+}
+// NOTE: end file watcher
+
 void platform_get_required_extension_names(const char*** names_darray) {
     darray_push(*names_darray, &"VK_KHR_xcb_surface");  // VK_KHR_xlib_surface?
 }
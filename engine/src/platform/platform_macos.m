@@ -5,11 +5,20 @@
 #include "core/logger.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kcondvar.h"
+#include "core/kfiber.h"
+#include "platform/file_watcher.h"
 
 #include "containers/darray.h"
 
 #include <mach/mach_time.h>
 #include <crt_externs.h>
+#include <pthread.h>
+#include <sched.h>
+#include <dispatch/dispatch.h>
 
 #import <Foundation/Foundation.h>
 #import <Cocoa/Cocoa.h>
@@ -423,6 +432,14 @@ f64 platform_get_absolute_time() {
     return mach_absolute_time();
 }
 
+u64 platform_get_absolute_time_ns() {
+    static mach_timebase_info_data_t timebase = {0, 0};
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+}
+
 void platform_sleep(u64 ms) {
 #if _POSIX_C_SOURCE >= 199309L
     struct timespec ts;
@@ -437,6 +454,259 @@ void platform_sleep(u64 ms) {
 #endif
 }
 
+i32 platform_get_processor_count() {
+    return (i32)[[NSProcessInfo processInfo] activeProcessorCount];
+}
+
+// NOTE: begin threads
+typedef struct macos_thread_start {
+    pfn_thread_start function;
+    void* params;
+} macos_thread_start;
+
+static void* macos_thread_entry(void* arg) {
+    macos_thread_start start = *(macos_thread_start*)arg;
+    platform_free(arg, false);
+    return (void*)(u64)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void* params, kthread* out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        return false;
+    }
+    macos_thread_start* start = platform_allocate(sizeof(macos_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    pthread_t handle;
+    if (pthread_create(&handle, 0, macos_thread_entry, start) != 0) {
+        platform_free(start, false);
+        KERROR("kthread_create - failed to create thread.");
+        return false;
+    }
+    out_thread->internal_data = (void*)handle;
+    out_thread->thread_id = (u64)handle;
+    return true;
+}
+
+b8 kthread_wait(kthread* thread) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    b8 result = pthread_join((pthread_t)thread->internal_data, 0) == 0;
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return result;
+}
+
+b8 kthread_detach(kthread* thread) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    b8 result = pthread_detach((pthread_t)thread->internal_data) == 0;
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return result;
+}
+
+void kthread_yield() {
+    sched_yield();
+}
+
+u64 kthread_get_current_id() {
+    return (u64)pthread_self();
+}
+
+b8 kthread_set_affinity(kthread* thread, u32 processor_index) {
+    // macOS has no way of pinning a thread to a core
+    return false;
+}
+
+b8 kthread_set_name(kthread* thread, const char* name) {
+    // macOS can only name the calling thread
+    if (!thread || !name || (pthread_t)thread->internal_data != pthread_self()) {
+        return false;
+    }
+    return pthread_setname_np(name) == 0;
+}
+
+b8 ktls_slot_create(ktls_slot* out_slot) {
+    pthread_key_t key;
+    if (!out_slot || pthread_key_create(&key, 0) != 0) {
+        return false;
+    }
+    out_slot->key = (u64)key;
+    return true;
+}
+
+void ktls_slot_destroy(ktls_slot* slot) {
+    if (slot) {
+        pthread_key_delete((pthread_key_t)slot->key);
+    }
+}
+
+b8 ktls_slot_set(ktls_slot* slot, void* value) {
+    return slot && pthread_setspecific((pthread_key_t)slot->key, value) == 0;
+}
+
+void* ktls_slot_get(ktls_slot* slot) {
+    return slot ? pthread_getspecific((pthread_key_t)slot->key) : 0;
+}
+// NOTE: end threads
+
+// NOTE: begin mutexes
+b8 kmutex_create(kmutex* out_mutex) {
+    if (!out_mutex) {
+        return false;
+    }
+    pthread_mutex_t* mutex = platform_allocate(sizeof(pthread_mutex_t), false);
+    if (pthread_mutex_init(mutex, 0) != 0) {
+        platform_free(mutex, false);
+        KERROR("kmutex_create - failed to create mutex.");
+        return false;
+    }
+    out_mutex->internal_data = mutex;
+    return true;
+}
+
+void kmutex_destroy(kmutex* mutex) {
+    if (mutex && mutex->internal_data) {
+        pthread_mutex_destroy(mutex->internal_data);
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex* mutex) {
+    return mutex && mutex->internal_data && pthread_mutex_lock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_try_lock(kmutex* mutex) {
+    return mutex && mutex->internal_data && pthread_mutex_trylock(mutex->internal_data) == 0;
+}
+
+b8 kmutex_unlock(kmutex* mutex) {
+    return mutex && mutex->internal_data && pthread_mutex_unlock(mutex->internal_data) == 0;
+}
+// NOTE: end mutexes
+
+// NOTE: begin semaphores
+// unnamed posix semaphores are not supported on macOS, so use dispatch semaphores instead
+b8 ksemaphore_create(u32 start_count, ksemaphore* out_semaphore) {
+    if (!out_semaphore) {
+        return false;
+    }
+    out_semaphore->internal_data = (void*)dispatch_semaphore_create(start_count);
+    return out_semaphore->internal_data != 0;
+}
+
+void ksemaphore_destroy(ksemaphore* semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        dispatch_release((dispatch_semaphore_t)semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    dispatch_semaphore_signal((dispatch_semaphore_t)semaphore->internal_data);
+    return true;
+}
+
+b8 ksemaphore_wait(ksemaphore* semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    dispatch_time_t timeout = timeout_ms == KSEMAPHORE_WAIT_INFINITE ? DISPATCH_TIME_FOREVER : dispatch_time(DISPATCH_TIME_NOW, (i64)timeout_ms * NSEC_PER_MSEC);
+    return dispatch_semaphore_wait((dispatch_semaphore_t)semaphore->internal_data, timeout) == 0;
+}
+// NOTE: end semaphores
+
+// NOTE: begin condition variables
+b8 kcondvar_create(kcondvar* out_condvar) {
+    if (!out_condvar) {
+        return false;
+    }
+    pthread_cond_t* cond = platform_allocate(sizeof(pthread_cond_t), false);
+    if (pthread_cond_init(cond, 0) != 0) {
+        platform_free(cond, false);
+        return false;
+    }
+    out_condvar->internal_data = cond;
+    return true;
+}
+
+void kcondvar_destroy(kcondvar* condvar) {
+    if (condvar && condvar->internal_data) {
+        pthread_cond_destroy(condvar->internal_data);
+        platform_free(condvar->internal_data, false);
+        condvar->internal_data = 0;
+    }
+}
+
+b8 kcondvar_wait(kcondvar* condvar, kmutex* mutex, u64 timeout_ms) {
+    if (!condvar || !condvar->internal_data || !mutex || !mutex->internal_data) {
+        return false;
+    }
+    if (timeout_ms == KCONDVAR_WAIT_INFINITE) {
+        return pthread_cond_wait(condvar->internal_data, mutex->internal_data) == 0;
+    }
+    // relative waits avoid the realtime clock entirely
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
+    return pthread_cond_timedwait_relative_np(condvar->internal_data, mutex->internal_data, &ts) == 0;
+}
+
+b8 kcondvar_signal(kcondvar* condvar) {
+    return condvar && condvar->internal_data && pthread_cond_signal(condvar->internal_data) == 0;
+}
+
+b8 kcondvar_broadcast(kcondvar* condvar) {
+    return condvar && condvar->internal_data && pthread_cond_broadcast(condvar->internal_data) == 0;
+}
+// NOTE: end condition variables
+
+// NOTE: begin fibers
+// TODO: ucontext is deprecated on macOS. until there is a hand written context switch, fibers are unsupported and the
+// job system falls back to running fiber jobs directly on its worker threads
+b8 kfiber_create_from_thread(kfiber* out_fiber) {
+    return false;
+}
+
+void kfiber_destroy_from_thread(kfiber* fiber) {
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void* params, kfiber* out_fiber) {
+    return false;
+}
+
+void kfiber_destroy(kfiber* fiber) {
+}
+
+void kfiber_switch(kfiber* from, kfiber* to) {
+}
+// NOTE: end fibers
+
+// NOTE: begin file watcher
+// TODO: FSEvents covers this, with kFSEventStreamCreateFlagFileEvents. until then hot reloading is unavailable on this platform
+b8 file_watcher_create(const char* directory, file_watcher* out_watcher) {
+    if (out_watcher) {
+        out_watcher->internal_data = 0;
+    }
+    return false;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+}
+
+u32 file_watcher_poll(file_watcher* watcher, pfn_file_watcher_callback callback, void* user_data) {
+    return 0;
+}
+// NOTE: end file watcher
+
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_EXT_metal_surface");
 }
@@ -8,6 +8,12 @@
 #include "core/logger.h"
 #include "core/input.h"
 #include "core/event.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/kcondvar.h"
+#include "core/kfiber.h"
+#include "platform/file_watcher.h"
 
 #include "containers/darray.h"
 
@@ -230,11 +236,372 @@ f64 platform_get_absolute_time() {
     return (f64)now_time.QuadPart * clock_frequency;  // calculates the elapsed time since the start time in seconds by converting the value of now_time.QuadPart (which is an int representing the current time per the performance counter) to a f64 then multiplying it by clock_frequency, the reciprocal of the frequency of the performance counter, which was calculated and set up in the clock_setup function.
 }
 
+u64 platform_get_absolute_time_ns() {
+    static u64 counter_frequency = 0;
+    if (!counter_frequency) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        counter_frequency = (u64)frequency.QuadPart;
+    }
+    LARGE_INTEGER now_time;
+    QueryPerformanceCounter(&now_time);
+    // split into whole seconds and the remainder so the multiply can not overflow
+    u64 ticks = (u64)now_time.QuadPart;
+    return (ticks / counter_frequency) * 1000000000ULL + ((ticks % counter_frequency) * 1000000000ULL) / counter_frequency;
+}
+
 // not much to do on this for now
 void platform_sleep(u64 ms) {
     Sleep(ms);
 }
 
+i32 platform_get_processor_count() {
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (i32)sysinfo.dwNumberOfProcessors;
+}
+
+// NOTE: begin threads
+// windows wants a DWORD WINAPI (*)(LPVOID), so the start function and params are carried through this to a trampoline
+typedef struct win32_thread_start {
+    pfn_thread_start function;
+    void *params;
+} win32_thread_start;
+
+static DWORD WINAPI win32_thread_entry(LPVOID arg) {
+    win32_thread_start start = *(win32_thread_start *)arg;
+    platform_free(arg, false);
+    return (DWORD)start.function(start.params);
+}
+
+b8 kthread_create(pfn_thread_start start_function_ptr, void *params, kthread *out_thread) {
+    if (!start_function_ptr || !out_thread) {
+        return false;
+    }
+
+    win32_thread_start *start = platform_allocate(sizeof(win32_thread_start), false);
+    start->function = start_function_ptr;
+    start->params = params;
+
+    DWORD thread_id = 0;
+    HANDLE handle = CreateThread(0, 0, win32_thread_entry, start, 0, &thread_id);
+    if (!handle) {
+        platform_free(start, false);
+        KERROR("kthread_create - failed to create thread. Error: %lu", GetLastError());
+        return false;
+    }
+
+    out_thread->internal_data = handle;
+    out_thread->thread_id = thread_id;
+    return true;
+}
+
+b8 kthread_wait(kthread *thread) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    DWORD result = WaitForSingleObject(thread->internal_data, INFINITE);
+    CloseHandle(thread->internal_data);
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return result == WAIT_OBJECT_0;
+}
+
+b8 kthread_detach(kthread *thread) {
+    if (!thread || !thread->internal_data) {
+        return false;
+    }
+    // closing the handle is all it takes, the thread keeps running and cleans up after itself
+    CloseHandle(thread->internal_data);
+    thread->internal_data = 0;
+    thread->thread_id = 0;
+    return true;
+}
+
+void kthread_yield() {
+    SwitchToThread();
+}
+
+u64 kthread_get_current_id() {
+    return (u64)GetCurrentThreadId();
+}
+
+b8 kthread_set_affinity(kthread *thread, u32 processor_index) {
+    if (!thread || !thread->internal_data || processor_index >= 64) {
+        return false;
+    }
+    if (SetThreadAffinityMask(thread->internal_data, (DWORD_PTR)1 << processor_index) == 0) {
+        KWARN("kthread_set_affinity - failed to set affinity to processor %u. Error: %lu", processor_index, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+// SetThreadDescription only exists on windows 10 1607 and up, so look it up rather than link against it
+typedef HRESULT(WINAPI *PFN_SetThreadDescription)(HANDLE, PCWSTR);
+
+b8 kthread_set_name(kthread *thread, const char *name) {
+    if (!thread || !thread->internal_data || !name) {
+        return false;
+    }
+    PFN_SetThreadDescription set_description = (PFN_SetThreadDescription)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+    if (!set_description) {
+        return false;
+    }
+    WCHAR wide_name[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, 64) == 0) {
+        return false;
+    }
+    wide_name[63] = 0;
+    return SUCCEEDED(set_description(thread->internal_data, wide_name));
+}
+
+b8 ktls_slot_create(ktls_slot *out_slot) {
+    if (!out_slot) {
+        return false;
+    }
+    DWORD index = TlsAlloc();
+    if (index == TLS_OUT_OF_INDEXES) {
+        KERROR("ktls_slot_create - out of thread local storage slots.");
+        return false;
+    }
+    out_slot->key = index;
+    return true;
+}
+
+void ktls_slot_destroy(ktls_slot *slot) {
+    if (slot) {
+        TlsFree((DWORD)slot->key);
+    }
+}
+
+b8 ktls_slot_set(ktls_slot *slot, void *value) {
+    return slot && TlsSetValue((DWORD)slot->key, value) != 0;
+}
+
+void *ktls_slot_get(ktls_slot *slot) {
+    return slot ? TlsGetValue((DWORD)slot->key) : 0;
+}
+// NOTE: end threads
+
+// NOTE: begin mutexes
+// SRW locks are lighter than a full kernel mutex and only ever used within this process
+b8 kmutex_create(kmutex *out_mutex) {
+    if (!out_mutex) {
+        return false;
+    }
+    SRWLOCK *lock = platform_allocate(sizeof(SRWLOCK), false);
+    InitializeSRWLock(lock);
+    out_mutex->internal_data = lock;
+    return true;
+}
+
+void kmutex_destroy(kmutex *mutex) {
+    if (mutex && mutex->internal_data) {
+        platform_free(mutex->internal_data, false);
+        mutex->internal_data = 0;
+    }
+}
+
+b8 kmutex_lock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    AcquireSRWLockExclusive(mutex->internal_data);
+    return true;
+}
+
+b8 kmutex_try_lock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    return TryAcquireSRWLockExclusive(mutex->internal_data) != 0;
+}
+
+b8 kmutex_unlock(kmutex *mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return false;
+    }
+    ReleaseSRWLockExclusive(mutex->internal_data);
+    return true;
+}
+// NOTE: end mutexes
+
+// NOTE: begin semaphores
+b8 ksemaphore_create(u32 start_count, ksemaphore *out_semaphore) {
+    if (!out_semaphore) {
+        return false;
+    }
+    HANDLE handle = CreateSemaphoreA(0, start_count, 0x7FFFFFFF, 0);
+    if (!handle) {
+        KERROR("ksemaphore_create - failed to create semaphore. Error: %lu", GetLastError());
+        return false;
+    }
+    out_semaphore->internal_data = handle;
+    return true;
+}
+
+void ksemaphore_destroy(ksemaphore *semaphore) {
+    if (semaphore && semaphore->internal_data) {
+        CloseHandle(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+b8 ksemaphore_signal(ksemaphore *semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    return ReleaseSemaphore(semaphore->internal_data, 1, 0) != 0;
+}
+
+b8 ksemaphore_wait(ksemaphore *semaphore, u64 timeout_ms) {
+    if (!semaphore || !semaphore->internal_data) {
+        return false;
+    }
+    DWORD timeout = timeout_ms == KSEMAPHORE_WAIT_INFINITE ? INFINITE : (DWORD)timeout_ms;
+    return WaitForSingleObject(semaphore->internal_data, timeout) == WAIT_OBJECT_0;
+}
+// NOTE: end semaphores
+
+// NOTE: begin condition variables
+// these pair with the SRW locks kmutex is built on
+b8 kcondvar_create(kcondvar *out_condvar) {
+    if (!out_condvar) {
+        return false;
+    }
+    CONDITION_VARIABLE *cv = platform_allocate(sizeof(CONDITION_VARIABLE), false);
+    InitializeConditionVariable(cv);
+    out_condvar->internal_data = cv;
+    return true;
+}
+
+void kcondvar_destroy(kcondvar *condvar) {
+    if (condvar && condvar->internal_data) {
+        platform_free(condvar->internal_data, false);
+        condvar->internal_data = 0;
+    }
+}
+
+b8 kcondvar_wait(kcondvar *condvar, kmutex *mutex, u64 timeout_ms) {
+    if (!condvar || !condvar->internal_data || !mutex || !mutex->internal_data) {
+        return false;
+    }
+    DWORD timeout = timeout_ms == KCONDVAR_WAIT_INFINITE ? INFINITE : (DWORD)timeout_ms;
+    return SleepConditionVariableSRW(condvar->internal_data, mutex->internal_data, timeout, 0) != 0;
+}
+
+b8 kcondvar_signal(kcondvar *condvar) {
+    if (!condvar || !condvar->internal_data) {
+        return false;
+    }
+    WakeConditionVariable(condvar->internal_data);
+    return true;
+}
+
+b8 kcondvar_broadcast(kcondvar *condvar) {
+    if (!condvar || !condvar->internal_data) {
+        return false;
+    }
+    WakeAllConditionVariable(condvar->internal_data);
+    return true;
+}
+// NOTE: end condition variables
+
+// NOTE: begin fibers
+// windows has fibers built in, the only extra is carrying the start function and params through to the entry point
+typedef struct win32_fiber {
+    LPVOID handle;
+    b8 is_thread;
+    pfn_fiber_start start;
+    void *params;
+} win32_fiber;
+
+static VOID WINAPI win32_fiber_entry(LPVOID arg) {
+    win32_fiber *fiber = arg;
+    fiber->start(fiber->params);
+    // returning from a fiber entry point exits the whole thread
+    KFATAL("A fiber start function returned. This is not allowed.");
+    abort();
+}
+
+b8 kfiber_create_from_thread(kfiber *out_fiber) {
+    if (!out_fiber) {
+        return false;
+    }
+    LPVOID handle = ConvertThreadToFiber(0);
+    if (!handle) {
+        KERROR("kfiber_create_from_thread - failed to convert thread. Error: %lu", GetLastError());
+        return false;
+    }
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    platform_zero_memory(fiber, sizeof(win32_fiber));
+    fiber->handle = handle;
+    fiber->is_thread = true;
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy_from_thread(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        ConvertFiberToThread();
+        platform_free(fiber->internal_data, false);
+        fiber->internal_data = 0;
+    }
+}
+
+b8 kfiber_create(u64 stack_size, pfn_fiber_start start_function_ptr, void *params, kfiber *out_fiber) {
+    if (!start_function_ptr || !out_fiber) {
+        return false;
+    }
+    win32_fiber *fiber = platform_allocate(sizeof(win32_fiber), false);
+    platform_zero_memory(fiber, sizeof(win32_fiber));
+    fiber->start = start_function_ptr;
+    fiber->params = params;
+    fiber->handle = CreateFiber(stack_size, win32_fiber_entry, fiber);
+    if (!fiber->handle) {
+        KERROR("kfiber_create - failed to create fiber. Error: %lu", GetLastError());
+        platform_free(fiber, false);
+        return false;
+    }
+    out_fiber->internal_data = fiber;
+    return true;
+}
+
+void kfiber_destroy(kfiber *fiber) {
+    if (fiber && fiber->internal_data) {
+        win32_fiber *f = fiber->internal_data;
+        if (!f->is_thread) {
+            DeleteFiber(f->handle);
+        }
+        platform_free(f, false);
+        fiber->internal_data = 0;
+    }
+}
+
+void kfiber_switch(kfiber *from, kfiber *to) {
+    // windows keeps track of the current fiber itself, so from is not needed
+    SwitchToFiber(((win32_fiber *)to->internal_data)->handle);
+}
+// NOTE: end fibers
+
+// NOTE: begin file watcher
+// TODO: ReadDirectoryChangesW with FILE_NOTIFY_CHANGE_LAST_WRITE and bWatchSubtree covers this. until then hot reloading is unavailable on this platform
+b8 file_watcher_create(const char* directory, file_watcher* out_watcher) {
+    if (out_watcher) {
+        out_watcher->internal_data = 0;
+    }
+    return false;
+}
+
+void file_watcher_destroy(file_watcher* watcher) {
+}
+
+u32 file_watcher_poll(file_watcher* watcher, pfn_file_watcher_callback callback, void* user_data) {
+    return 0;
+}
+// NOTE: end file watcher
+
 // from vulcan_platform.h -- to get the platform specific extesion names for windows
 void platform_get_required_extension_names(const char ***names_darray) {
     darray_push(*names_darray, &"VK_KHR_win32_surface");  // push in the windows surface extension into the vulkan required estensions array
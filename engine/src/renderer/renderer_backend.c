@@ -26,6 +26,7 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* out_ren
         out_renderer_backend->shader_destroy = vulkan_renderer_shader_destroy;
         out_renderer_backend->shader_set_uniform = vulkan_renderer_set_uniform;
         out_renderer_backend->shader_initialize = vulkan_renderer_shader_initialize;
+        out_renderer_backend->shader_reload = vulkan_renderer_shader_reload;
         out_renderer_backend->shader_use = vulkan_renderer_shader_use;
         out_renderer_backend->shader_bind_globals = vulkan_renderer_shader_bind_globals;
         out_renderer_backend->shader_bind_instance = vulkan_renderer_shader_bind_instance;
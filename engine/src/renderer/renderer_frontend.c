@@ -314,6 +314,10 @@ b8 renderer_shader_initialize(shader* s) {
     return state_ptr->backend.shader_initialize(s);
 }
 
+b8 renderer_shader_reload(shader* s) {
+    return state_ptr->backend.shader_reload(s);
+}
+
 b8 renderer_shader_use(shader* s) {
     return state_ptr->backend.shader_use(s);
 }
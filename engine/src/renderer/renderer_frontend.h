@@ -85,6 +85,12 @@ void renderer_shader_destroy(struct shader* s);
 // @return true on success, otherwise false.
 b8 renderer_shader_initialize(struct shader* s);
 
+// @brief builds the stages and pipeline of an initialized shader again from its stage files, for when they have changed.
+// the layout stays as it is, so only changes to the code inside the stages are picked up
+// @param s a pointer to the shader to be reloaded.
+// @return true on success. on failure the shader is left as it was.
+b8 renderer_shader_reload(struct shader* s);
+
 // @brief uses the given shader, activating it for updates to attributes, uniforms and such,
 // and for use in draw calls.
 // @param s a pointer to the shader to be used.
@@ -21,6 +21,11 @@ typedef enum renderer_backend_type {
 typedef struct geometry_render_data {
     mat4 model;          // model matrix for a batch of geometry
     geometry* geometry;  // hold a pointer to a material
+    u32 lod;             // which of the geometry's levels of detail to draw, 0 being full detail
+    // @brief the ranges of the level of detail's indices to draw, such as the meshlets left after culling. 0 to draw
+    // all of it
+    u32 index_range_count;
+    geometry_index_range* index_ranges;
 } geometry_render_data;
 
 typedef enum renderer_debug_view_mode {
@@ -200,6 +205,12 @@ typedef struct renderer_backend {
     // @return b8 true on success, otherwise false
     b8 (*shader_initialize)(struct shader* shader);
 
+    // @brief builds the stages and pipeline of an initialized shader again from its stage files, for when they have
+    // changed. the layout stays as it is, so only changes to the code inside the stages are picked up
+    // @param s a pointer to the shader to be reloaded
+    // @return b8 true on success. on failure the shader is left as it was
+    b8 (*shader_reload)(struct shader* shader);
+
     // @brief uses the given shader, activating it for updates to attributes, uniforms and such, and for use in draw calls
     // @param s a pointer to the shader to be used
     // @return b8 true on success, otherwise false
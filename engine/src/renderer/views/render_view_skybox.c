@@ -3,6 +3,7 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/event.h"
+#include "core/profiler.h"
 #include "math/kmath.h"
 #include "math/transform.h"
 #include "containers/darray.h"
@@ -77,6 +78,7 @@ void render_view_skybox_on_resize(struct render_view* self, u32 width, u32 heigh
 }
 
 b8 render_view_skybox_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_SCOPE("render_view_skybox_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_skybox_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -98,6 +100,7 @@ b8 render_view_skybox_on_build_packet(const struct render_view* self, void* data
 }
 
 b8 render_view_skybox_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_SCOPE("render_view_skybox_on_render");
     render_view_skybox_internal_data* data = self->internal_data;
     u32 shader_id = data->shader_id;
 
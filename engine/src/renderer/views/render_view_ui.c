@@ -3,6 +3,7 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/event.h"
+#include "core/profiler.h"
 #include "math/kmath.h"
 #include "math/transform.h"
 #include "containers/darray.h"
@@ -66,6 +67,7 @@ void render_view_ui_on_resize(struct render_view* self, u32 width, u32 height) {
 }
 
 b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_SCOPE("render_view_ui_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_ui_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -89,6 +91,9 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, st
             geometry_render_data render_data;
             render_data.geometry = m->geometries[j];
             render_data.model = transform_get_world(&m->transform);
+            render_data.lod = 0;
+            render_data.index_range_count = 0;
+            render_data.index_ranges = 0;
             darray_push(out_packet->geometries, render_data);
             out_packet->geometry_count++;
         }
@@ -98,6 +103,7 @@ b8 render_view_ui_on_build_packet(const struct render_view* self, void* data, st
 }
 
 b8 render_view_ui_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_SCOPE("render_view_ui_on_render");
     render_view_ui_internal_data* data = self->internal_data;
     u32 shader_id = data->shader_id;
 
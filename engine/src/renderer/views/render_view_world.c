@@ -3,14 +3,20 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/event.h"
+#include "core/profiler.h"
 #include "math/kmath.h"
 #include "math/transform.h"
+#include "math/geometry_utils.h"
 #include "containers/darray.h"
 #include "systems/material_system.h"
 #include "systems/shader_system.h"
 #include "systems/camera_system.h"
 #include "renderer/renderer_frontend.h"
 
+// how big (in pixels) the difference between a level of detail and full detail can be on screen before it is too coarse
+// to use
+#define RENDER_VIEW_WORLD_LOD_ERROR_PIXELS 1.0f
+
 typedef struct render_view_world_internal_data {
     u32 shader_id;
     f32 fov;
@@ -20,6 +26,10 @@ typedef struct render_view_world_internal_data {
     camera* world_camera;
     vec4 ambient_colour;
     u32 render_mode;
+    // the index ranges left after culling meshlets, which each frame's render data points into. room for one per
+    // meshlet of everything drawn, the most there can be
+    geometry_index_range* index_ranges;
+    u32 index_range_capacity;
 } render_view_world_internal_data;
 
 // @brief a private structure used to sort geometry by distance form the camera
@@ -106,6 +116,10 @@ b8 render_view_world_on_create(struct render_view* self) {
 void render_view_world_on_destroy(struct render_view* self) {
     if (self && self->internal_data) {
         event_unregister(EVENT_CODE_SET_RENDER_MODE, self, render_view_on_event);
+        render_view_world_internal_data* data = self->internal_data;
+        if (data->index_ranges) {
+            kfree(data->index_ranges, sizeof(geometry_index_range) * data->index_range_capacity, MEMORY_TAG_RENDERER);
+        }
         kfree(self->internal_data, sizeof(render_view_world_internal_data), MEMORY_TAG_RENDERER);
         self->internal_data = 0;
     }
@@ -130,7 +144,52 @@ void render_view_world_on_resize(struct render_view* self, u32 width, u32 height
     }
 }
 
+// the largest scale in a model matrix, which bounds grow by
+static f32 model_scale(const mat4* model) {
+    f32 scale_x = vec3_length(vec3_create(model->data[0], model->data[1], model->data[2]));
+    f32 scale_y = vec3_length(vec3_create(model->data[4], model->data[5], model->data[6]));
+    f32 scale_z = vec3_length(vec3_create(model->data[8], model->data[9], model->data[10]));
+    f32 scale = scale_x > scale_y ? scale_x : scale_y;
+    return scale > scale_z ? scale : scale_z;
+}
+
+// picks the coarsest level of detail whose error still comes out under RENDER_VIEW_WORLD_LOD_ERROR_PIXELS on screen. the
+// error is taken at the nearest point of the geometry's bounding sphere, and scaled by the largest scale in the model
+// matrix, so nothing is ever coarser than it should be
+static u32 select_lod(const render_view_world_internal_data* data, u32 view_height, const geometry* g, const mat4* model, vec3 camera_position) {
+    if (g->lod_count < 2 || view_height == 0) {
+        return 0;
+    }
+    f32 scale = model_scale(model);
+
+    vec3 center = vec3_transform(g->center, *model);
+    f32 radius = vec3_distance(g->extents.min, g->extents.max) * 0.5f * scale;
+    f32 distance = vec3_distance(center, camera_position) - radius;
+    if (distance < data->near_clip) {
+        return 0;
+    }
+    // pixels per unit, at that distance
+    f32 pixels_per_unit = (f32)view_height / (2.0f * distance * ktan(data->fov * 0.5f));
+
+    for (u32 lod = g->lod_count - 1; lod > 0; --lod) {
+        if (g->lods[lod].error * scale * pixels_per_unit <= RENDER_VIEW_WORLD_LOD_ERROR_PIXELS) {
+            return lod;
+        }
+    }
+    return 0;
+}
+
+// checks the sphere around a geometry's bounds against the frustum. geometries without bounds are never culled
+static b8 geometry_in_frustum(const frustum* f, const geometry* g, const mat4* model) {
+    f32 radius = vec3_distance(g->extents.min, g->extents.max) * 0.5f;
+    if (radius == 0.0f) {
+        return true;
+    }
+    return frustum_intersects_sphere(f, vec3_transform(g->center, *model), radius * model_scale(model));
+}
+
 b8 render_view_world_on_build_packet(const struct render_view* self, void* data, struct render_view_packet* out_packet) {
+    KPROFILE_SCOPE("render_view_world_on_build_packet");
     if (!self || !data || !out_packet) {
         KWARN("render_view_world_on_build_packet requires valid pointer to view, packet, and data.");
         return false;
@@ -148,6 +207,23 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
     out_packet->view_position = camera_position_get(internal_data->world_camera);
     out_packet->ambient_colour = internal_data->ambient_colour;
 
+    // geometries are culled against the frustum whole, then by their meshlets
+    frustum f = frustum_from_matrix(mat4_mul(out_packet->view_matrix, out_packet->projection_matrix));
+    u32 meshlet_count = 0;
+    for (u32 i = 0; i < mesh_data->mesh_count; ++i) {
+        for (u32 j = 0; j < mesh_data->meshes[i].geometry_count; ++j) {
+            meshlet_count += mesh_data->meshes[i].geometries[j]->meshlet_count;
+        }
+    }
+    if (meshlet_count > internal_data->index_range_capacity) {
+        if (internal_data->index_ranges) {
+            kfree(internal_data->index_ranges, sizeof(geometry_index_range) * internal_data->index_range_capacity, MEMORY_TAG_RENDERER);
+        }
+        internal_data->index_range_capacity = meshlet_count;
+        internal_data->index_ranges = kallocate(sizeof(geometry_index_range) * meshlet_count, MEMORY_TAG_RENDERER);
+    }
+    u32 index_range_count = 0;
+
     // obtain all geometries from the current scene.
 
     geometry_distance* geometry_distances = darray_create(geometry_distance);
@@ -157,9 +233,30 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
         mat4 model = transform_get_world(&m->transform);
 
         for (u32 j = 0; j < m->geometry_count; ++j) {
+            if (!geometry_in_frustum(&f, m->geometries[j], &model)) {
+                continue;
+            }
             geometry_render_data render_data;
             render_data.geometry = m->geometries[j];
             render_data.model = model;
+            render_data.lod = select_lod(internal_data, self->height, render_data.geometry, &model, out_packet->view_position);
+            render_data.index_range_count = 0;
+            render_data.index_ranges = 0;
+            const geometry_lod* lod = &render_data.geometry->lods[render_data.lod];
+            if (lod->meshlet_count > 0) {
+                geometry_index_range* ranges = &internal_data->index_ranges[index_range_count];
+                render_data.index_range_count = geometry_cull_meshlets(lod->meshlet_count, &render_data.geometry->meshlets[lod->meshlet_offset], model, &f, out_packet->view_position, ranges);
+                if (render_data.index_range_count == 0) {
+                    // every meshlet was culled
+                    continue;
+                }
+                render_data.index_ranges = ranges;
+                index_range_count += render_data.index_range_count;
+            }
+            if (render_data.geometry->vertex_size == sizeof(vertex_3d_packed)) {
+                // packed positions are 0-1 across the bounds, so scaling them back out goes first
+                render_data.model = mat4_mul(geometry_packed_position_transform(render_data.geometry->extents.min, render_data.geometry->extents.max), model);
+            }
 
             // TODO: add something to material to check for transparency
             if ((m->geometries[j]->material->diffuse_map.texture->flags & TEXTURE_FLAG_HAS_TRANSPARENCY) == 0) {
@@ -196,6 +293,7 @@ b8 render_view_world_on_build_packet(const struct render_view* self, void* data,
 }
 
 b8 render_view_world_on_render(const struct render_view* self, const struct render_view_packet* packet, u64 frame_number, u64 render_target_index) {
+    KPROFILE_SCOPE("render_view_world_on_render");
     render_view_world_internal_data* data = self->internal_data;
     u32 shader_id = data->shader_id;
 
@@ -13,6 +13,7 @@
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
+#include "core/profiler.h"
 
 #include "containers/darray.h"
 
@@ -423,7 +424,9 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
 
     // if no resizing and no swapchain recreation then
     // wait for the execution of the current frame to complete. the fence being free will allow this one to move on
+    KPROFILE_BEGIN(fence_wait_scope, "vulkan_begin_frame_fence_wait");
     VkResult result = vkWaitForFences(context.device.logical_device, 1, &context.in_flight_fences[context.current_frame], true, UINT64_MAX);
+    KPROFILE_END(fence_wait_scope);
     if (!vulkan_result_is_success(result)) {
         KFATAL("In-flight fence wait failure! error: %s", vulkan_result_string(result, true));
         return false;
@@ -431,13 +434,16 @@ b8 vulkan_renderer_backend_begin_frame(renderer_backend* backend, f32 delta_time
 
     // aquire the next image from the swap chain. pass along the semaphore that should be signaled when this completes
     // this same semaphore will later be waited on by the queue submission to ensure this image is available
-    if (!vulkan_swapchain_acquire_next_image_index(                     // call the function to aquire the next image index
-            &context,                                                   // pass an address to the context
-            &context.swapchain,                                         // and an address to the swapchain
-            UINT64_MAX,                                                 // a bogus high value
-            context.image_available_semaphores[context.current_frame],  // the image available semaphore that is attached to the current frame - and should be signaled when this completes use current frame to sync them up
-            0,                                                          // no time out
-            &context.image_index)) {                                    // and the index of the image being aquired
+    KPROFILE_BEGIN(acquire_scope, "vulkan_begin_frame_acquire_image");
+    b8 acquired = vulkan_swapchain_acquire_next_image_index(  // call the function to aquire the next image index
+        &context,                                                   // pass an address to the context
+        &context.swapchain,                                         // and an address to the swapchain
+        UINT64_MAX,                                                 // a bogus high value
+        context.image_available_semaphores[context.current_frame],  // the image available semaphore that is attached to the current frame - and should be signaled when this completes use current frame to sync them up
+        0,                                                          // no time out
+        &context.image_index);                                      // and the index of the image being aquired
+    KPROFILE_END(acquire_scope);
+    if (!acquired) {
         KERROR("Failed to acquire next image index, booting.");
         return false;
     }
@@ -478,6 +484,7 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
 
     // make sure the previous frame is not using this image (i.e. its fence is being waited on)
     if (context.images_in_flight[context.image_index] != VK_NULL_HANDLE) {  // if there is acctually in images in flight at image index
+        KPROFILE_SCOPE("vulkan_end_frame_image_fence_wait");
         VkResult result = vkWaitForFences(context.device.logical_device, 1, &context.images_in_flight[context.image_index], true, UINT64_MAX);
         if (!vulkan_result_is_success(result)) {
             KERROR("vk_fence_wait error: %s", vulkan_result_string(result, true));
@@ -532,7 +539,8 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
     // end the queue submission
 
     // here is where it is drawn to the screen
-    // give the image back to the swapchain
+    // give the image back to the swapchain. with vsync on this is usually where the frame ends up waiting
+    KPROFILE_BEGIN(present_scope, "vulkan_end_frame_present");
     vulkan_swapchain_present(                                      // call our function to present the swapchain
         &context,                                                  // pass in an address to the context
         &context.swapchain,                                        // an address to the swapchain
@@ -540,6 +548,7 @@ b8 vulkan_renderer_backend_end_frame(renderer_backend* backend, f32 delta_time)
         context.device.present_queue,                              // the present queue
         context.queue_complete_semaphores[context.current_frame],  // the queue complete semaphore of the index of the current frame
         context.image_index);                                      // and the image index
+    KPROFILE_END(present_scope);
 
     // if all of this has passed, we have rendered to the screen
     return true;
@@ -985,7 +994,7 @@ b8 vulkan_renderer_create_geometry(geometry* geometry, u32 vertex_size, u32 vert
 
     // vertex data
     internal_data->vertex_count = vertex_count;
-    internal_data->vertex_element_size = sizeof(vertex_3d);
+    internal_data->vertex_element_size = vertex_size;
     u32 total_size = vertex_count * vertex_size;
     if (!upload_data_range(
             &context,
@@ -1046,11 +1055,11 @@ void vulkan_renderer_destroy_geometry(geometry* geometry) {
         vulkan_geometry_data* internal_data = &context.geometries[geometry->internal_id];
 
         // free the vertex data
-        free_data_range(&context.object_vertex_buffer, internal_data->vertex_buffer_offset, internal_data->vertex_element_size);
+        free_data_range(&context.object_vertex_buffer, internal_data->vertex_buffer_offset, internal_data->vertex_element_size * internal_data->vertex_count);
 
         // free index data, if applicable
         if (internal_data->index_element_size > 0) {
-            free_data_range(&context.object_index_buffer, internal_data->index_buffer_offset, internal_data->index_element_size);
+            free_data_range(&context.object_index_buffer, internal_data->index_buffer_offset, internal_data->index_element_size * internal_data->index_count);
         }
 
         // clean up data
@@ -1080,8 +1089,22 @@ void vulkan_renderer_draw_geometry(geometry_render_data* data) {
         // Bind index buffer at offset.
         vkCmdBindIndexBuffer(command_buffer->handle, context.object_index_buffer.handle, buffer_data->index_buffer_offset, VK_INDEX_TYPE_UINT32);
 
-        // Issue the draw.
-        vkCmdDrawIndexed(command_buffer->handle, buffer_data->index_count, 1, 0, 0, 0);
+        // just the ranges asked for, such as the meshlets left after culling
+        if (data->index_range_count > 0) {
+            for (u32 i = 0; i < data->index_range_count; ++i) {
+                vkCmdDrawIndexed(command_buffer->handle, data->index_ranges[i].index_count, 1, data->index_ranges[i].index_offset, 0, 0);
+            }
+            return;
+        }
+
+        // Issue the draw, of just the indices of the level of detail asked for.
+        u32 first_index = 0;
+        u32 index_count = buffer_data->index_count;
+        if (data->lod < data->geometry->lod_count) {
+            first_index = data->geometry->lods[data->lod].index_offset;
+            index_count = data->geometry->lods[data->lod].index_count;
+        }
+        vkCmdDrawIndexed(command_buffer->handle, index_count, 1, first_index, 0, 0);
     } else {
         vkCmdDraw(command_buffer->handle, buffer_data->vertex_count, 1, 0, 0);
     }
@@ -1321,6 +1344,53 @@ void vulkan_renderer_shader_destroy(struct shader* s) {
     }
 }
 
+// creates the pipeline for a shader out of the given stages. the descriptor set layouts must already exist
+static b8 create_shader_pipeline(struct shader* shader, const vulkan_shader_stage* stages, vulkan_pipeline* out_pipeline) {
+    vulkan_shader* s = (vulkan_shader*)shader->internal_data;
+
+    // TODO: possibly the wrong place for these, at least in this fashion.
+    // should probably be configured to pull from someplace instead
+    // viewport
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = (f32)context.framebuffer_height;
+    viewport.width = (f32)context.framebuffer_width;
+    viewport.height = -(f32)context.framebuffer_height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    // scissor
+    VkRect2D scissor;
+    scissor.offset.x = scissor.offset.y = 0;
+    scissor.extent.width = context.framebuffer_width;
+    scissor.extent.height = context.framebuffer_height;
+
+    VkPipelineShaderStageCreateInfo stage_create_infos[VULKAN_SHADER_MAX_STAGES];
+    kzero_memory(stage_create_infos, sizeof(VkPipelineShaderStageCreateInfo) * VULKAN_SHADER_MAX_STAGES);
+    for (u32 i = 0; i < s->config.stage_count; ++i) {
+        stage_create_infos[i] = stages[i].shader_stage_create_info;
+    }
+
+    return vulkan_graphics_pipeline_create(
+        &context,
+        s->renderpass,
+        shader->attribute_stride,
+        darray_length(shader->attributes),
+        s->config.attributes,  // shader->attributes
+        s->config.descriptor_set_count,
+        s->descriptor_set_layouts,
+        s->config.stage_count,
+        stage_create_infos,
+        viewport,
+        scissor,
+        s->config.cull_mode,
+        false,
+        true,
+        shader->push_constant_range_count,
+        shader->push_constant_ranges,
+        out_pipeline);
+}
+
 b8 vulkan_renderer_shader_initialize(struct shader* shader) {
     VkDevice logical_device = context.device.logical_device;
     VkAllocationCallbacks* vk_allocator = context.allocator;
@@ -1337,7 +1407,7 @@ b8 vulkan_renderer_shader_initialize(struct shader* shader) {
 
     // static lookup table for our types->vulkan ones
     static VkFormat* types = 0;
-    static VkFormat t[11];
+    static VkFormat t[14];
     if (!types) {
         t[SHADER_ATTRIB_TYPE_FLOAT32] = VK_FORMAT_R32_SFLOAT;
         t[SHADER_ATTRIB_TYPE_FLOAT32_2] = VK_FORMAT_R32G32_SFLOAT;
@@ -1349,6 +1419,9 @@ b8 vulkan_renderer_shader_initialize(struct shader* shader) {
         t[SHADER_ATTRIB_TYPE_UINT16] = VK_FORMAT_R16_UINT;
         t[SHADER_ATTRIB_TYPE_INT32] = VK_FORMAT_R32_SINT;
         t[SHADER_ATTRIB_TYPE_UINT32] = VK_FORMAT_R32_UINT;
+        t[SHADER_ATTRIB_TYPE_UNORM16_4] = VK_FORMAT_R16G16B16A16_UNORM;
+        t[SHADER_ATTRIB_TYPE_SNORM16_2] = VK_FORMAT_R16G16_SNORM;
+        t[SHADER_ATTRIB_TYPE_FLOAT16_2] = VK_FORMAT_R16G16_SFLOAT;
         types = t;
     }
 
@@ -1396,49 +1469,7 @@ b8 vulkan_renderer_shader_initialize(struct shader* shader) {
         }
     }
 
-    // TODO: possibly the wrong place for these, at least in this fashion.
-    // should probably be configured to pull from someplace instead
-    // viewport
-    VkViewport viewport;
-    viewport.x = 0.0f;
-    viewport.y = (f32)context.framebuffer_height;
-    viewport.width = (f32)context.framebuffer_width;
-    viewport.height = -(f32)context.framebuffer_height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    // scissor
-    VkRect2D scissor;
-    scissor.offset.x = scissor.offset.y = 0;
-    scissor.extent.width = context.framebuffer_width;
-    scissor.extent.height = context.framebuffer_height;
-
-    VkPipelineShaderStageCreateInfo stage_create_infos[VULKAN_SHADER_MAX_STAGES];
-    kzero_memory(stage_create_infos, sizeof(VkPipelineShaderStageCreateInfo) * VULKAN_SHADER_MAX_STAGES);
-    for (u32 i = 0; i < s->config.stage_count; ++i) {
-        stage_create_infos[i] = s->stages[i].shader_stage_create_info;
-    }
-
-    b8 pipeline_result = vulkan_graphics_pipeline_create(
-        &context,
-        s->renderpass,
-        shader->attribute_stride,
-        darray_length(shader->attributes),
-        s->config.attributes,  // shader->attributes
-        s->config.descriptor_set_count,
-        s->descriptor_set_layouts,
-        s->config.stage_count,
-        stage_create_infos,
-        viewport,
-        scissor,
-        s->config.cull_mode,
-        false,
-        true,
-        shader->push_constant_range_count,
-        shader->push_constant_ranges,
-        &s->pipeline);
-
-    if (!pipeline_result) {
+    if (!create_shader_pipeline(shader, s->stages, &s->pipeline)) {
         KERROR("Failed to load graphics pipeline for object shader.");
         return false;
     }
@@ -1490,6 +1521,49 @@ b8 vulkan_renderer_shader_initialize(struct shader* shader) {
     return true;
 }
 
+b8 vulkan_renderer_shader_reload(struct shader* shader) {
+    vulkan_shader* s = (vulkan_shader*)shader->internal_data;
+    if (!s || !s->pipeline.handle) {
+        return false;
+    }
+
+    // build everything new first, so a stage that fails leaves the shader as it was
+    vulkan_shader_stage stages[VULKAN_SHADER_MAX_STAGES];
+    kzero_memory(stages, sizeof(vulkan_shader_stage) * VULKAN_SHADER_MAX_STAGES);
+    u32 created_count = 0;
+    b8 success = true;
+    for (; created_count < s->config.stage_count; ++created_count) {
+        if (!create_module(s, s->config.stages[created_count], &stages[created_count])) {
+            KERROR("Unable to reload %s shader module for '%s'.", s->config.stages[created_count].file_name, shader->name);
+            success = false;
+            break;
+        }
+    }
+
+    vulkan_pipeline pipeline = {};
+    if (success && !create_shader_pipeline(shader, stages, &pipeline)) {
+        KERROR("Failed to create graphics pipeline while reloading shader '%s'.", shader->name);
+        success = false;
+    }
+
+    if (!success) {
+        for (u32 i = 0; i < created_count; ++i) {
+            vkDestroyShaderModule(context.device.logical_device, stages[i].handle, context.allocator);
+        }
+        return false;
+    }
+
+    // frames in flight may still be using the old pipeline
+    vkDeviceWaitIdle(context.device.logical_device);
+    vulkan_pipeline_destroy(&context, &s->pipeline);
+    for (u32 i = 0; i < s->config.stage_count; ++i) {
+        vkDestroyShaderModule(context.device.logical_device, s->stages[i].handle, context.allocator);
+    }
+    kcopy_memory(s->stages, stages, sizeof(vulkan_shader_stage) * VULKAN_SHADER_MAX_STAGES);
+    s->pipeline = pipeline;
+    return true;
+}
+
 #ifdef _DEBUG
 #define SHADER_VERIFY_SHADER_ID(shader_id)                                        \
     if (shader_id == INVALID_ID || context.shaders[shader_id].id == INVALID_ID) { \
@@ -1866,6 +1940,14 @@ b8 create_module(vulkan_shader* shader, vulkan_shader_stage_config config, vulka
         return false;
     }
 
+    // the file may have been caught half written when reloading, so check it at least looks like spir-v before handing
+    // it to the driver
+    if (binary_resource.data_size < sizeof(u32) || binary_resource.data_size % sizeof(u32) != 0 || *(u32*)binary_resource.data != 0x07230203) {
+        KERROR("Shader module '%s' is not valid SPIR-V.", config.file_name);
+        resource_system_unload(&binary_resource);
+        return false;
+    }
+
     kzero_memory(&shader_stage->create_info, sizeof(VkShaderModuleCreateInfo));
     shader_stage->create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     // use the resource's size and data directly
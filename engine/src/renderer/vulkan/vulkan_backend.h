@@ -66,6 +66,7 @@ b8 vulkan_renderer_shader_create(struct shader* shader, const shader_config* con
 void vulkan_renderer_shader_destroy(struct shader* s);
 
 b8 vulkan_renderer_shader_initialize(struct shader* shader);
+b8 vulkan_renderer_shader_reload(struct shader* shader);
 b8 vulkan_renderer_shader_use(struct shader* shader);
 
 b8 vulkan_renderer_shader_bind_globals(struct shader* s);
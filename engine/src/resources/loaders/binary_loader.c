@@ -7,7 +7,7 @@
 #include "systems/resource_system.h"
 #include "math/kmath.h"
 
-#include "platform/filesystem.h"
+#include "systems/vfs_system.h"
 #include "loader_utils.h"
 
 b8 binary_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
@@ -15,47 +15,48 @@ b8 binary_loader_load(struct resource_loader* self, const char* name, void* para
         return false;
     }
 
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, "");
+    char file_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, "", file_path);
 
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, true, &f)) {
-        KERROR("binary_loader_load - unable to open file for binary reading: '%s'.", full_file_path);
+    // the file is kept open until unload, so consumers (like shader module creation) work straight off the mapped file
+    // or archive, with no copy
+    vfs_file* f = kallocate(sizeof(vfs_file), MEMORY_TAG_RESOURCE);
+    if (!vfs_open(file_path, f)) {
+        KERROR("binary_loader_load - unable to open file for binary reading: '%s'.", file_path);
+        kfree(f, sizeof(vfs_file), MEMORY_TAG_RESOURCE);
         return false;
     }
+    resource_loader_record_read(self, f->size);
 
     // TODO: should be using an allocator here
-    out_resource->full_path = string_duplicate(full_file_path);
+    out_resource->full_path = string_duplicate(f->path);
 
-    u64 file_size = 0;
-    if (!filesystem_size(&f, &file_size)) {
-        KERROR("Unable to binary read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
-
-    // TODO: should be using an allocator here
-    u8* resource_data = kallocate(sizeof(u8) * file_size, MEMORY_TAG_ARRAY);
-    u64 read_size = 0;
-    if (!filesystem_read_all_bytes(&f, resource_data, &read_size)) {
-        KERROR("Unable to binary read file: %s", full_file_path);
-        return false;
-    }
-
-    filesystem_close(&f);
-
-    out_resource->data = resource_data;
-    out_resource->data_size = read_size;
+    // NOTE: the data is read only
+    out_resource->data = (void*)f->data;
+    out_resource->data_size = f->size;
+    out_resource->loader_data = f;
     out_resource->name = name;
 
     return true;
 }
 
 void binary_loader_unload(struct resource_loader* self, resource* resource) {
-    if (!resource_unload(self, resource, MEMORY_TAG_ARRAY)) {
+    if (!self || !resource) {
         KWARN("binary_loader_unload called with nullptr for self or resource.");
+        return;
     }
+
+    vfs_file* f = resource->loader_data;
+    if (f) {
+        vfs_close(f);
+        kfree(f, sizeof(vfs_file), MEMORY_TAG_RESOURCE);
+        resource->loader_data = 0;
+    }
+    resource->data = 0;
+    resource->data_size = 0;
+
+    // with the data already gone this just cleans up the path
+    resource_unload(self, resource, MEMORY_TAG_ARRAY);
 }
 
 resource_loader binary_resource_loader_create() {
@@ -65,6 +66,7 @@ resource_loader binary_resource_loader_create() {
     loader.load = binary_loader_load;
     loader.unload = binary_loader_unload;
     loader.type_path = "";
+    loader.params_size = 0;
 
     return loader;
 }
\ No newline at end of file
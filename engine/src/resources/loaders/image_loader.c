@@ -3,17 +3,115 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
-#include "platform/filesystem.h"
+#include "core/profiler.h"
 #include "resources/resource_types.h"
 #include "systems/resource_system.h"
+#include "systems/vfs_system.h"
 #include "platform/filesystem.h"
 #include "loader_utils.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "vendor/stb_image.h"
 
+// NOTE: begin cooked images
+// a .kti is an image already decoded to what gets uploaded: a 16 byte header followed by width * height *
+// channel_count bytes of 8 bit pixels. written by assetcook, so loading one is a lookup and (usually) nothing else
+#define KTI_MAGIC 0x4954424B  // "KBTI"
+#define KTI_VERSION 1
+// the rows are stored bottom up, as loaded with flip_y
+#define KTI_FLAG_FLIPPED_Y 0x1
+
+typedef struct kti_header {
+    u32 magic;
+    u16 version;
+    u8 channel_count;
+    u8 flags;
+    u32 width;
+    u32 height;
+} kti_header;
+
+// kept in resource->loader_data for images loaded from a .kti
+typedef struct kti_image {
+    // the file the pixels point straight into, when no flip was needed
+    vfs_file file;
+    // otherwise the pixels are a flipped copy, and the file is already closed
+    u8* flipped_pixels;
+    u64 pixel_size;
+} kti_image;
+
+static b8 load_kti_file(vfs_file* f, b8 flip_y, image_resource_data* out_data, kti_image** out_image) {
+    kti_header header;
+    if (f->size < sizeof(kti_header)) {
+        return false;
+    }
+    kcopy_memory(&header, f->data, sizeof(kti_header));
+    if (header.magic != KTI_MAGIC || header.version != KTI_VERSION || header.channel_count != 4) {
+        return false;
+    }
+    u64 row_size = (u64)header.width * header.channel_count;
+    u64 pixel_size = row_size * header.height;
+    if (f->size - sizeof(kti_header) < pixel_size) {
+        return false;
+    }
+
+    kti_image* image = kallocate(sizeof(kti_image), MEMORY_TAG_RESOURCE);
+    u8* pixels = (u8*)f->data + sizeof(kti_header);
+    b8 flipped_y = (header.flags & KTI_FLAG_FLIPPED_Y) != 0;
+    if (flipped_y == flip_y) {
+        // NOTE: the pixels are read only
+        image->file = *f;
+    } else {
+        image->pixel_size = pixel_size;
+        image->flipped_pixels = kallocate(pixel_size, MEMORY_TAG_TEXTURE);
+        for (u32 y = 0; y < header.height; ++y) {
+            kcopy_memory(image->flipped_pixels + row_size * y, pixels + row_size * (header.height - 1 - y), row_size);
+        }
+        pixels = image->flipped_pixels;
+        vfs_close(f);
+    }
+
+    out_data->pixels = pixels;
+    out_data->width = header.width;
+    out_data->height = header.height;
+    out_data->channel_count = header.channel_count;
+    *out_image = image;
+    return true;
+}
+
+b8 image_loader_write_kti(const char* path, const image_resource_data* image, b8 flipped_y) {
+    kti_header header;
+    kzero_memory(&header, sizeof(kti_header));
+    header.magic = KTI_MAGIC;
+    header.version = KTI_VERSION;
+    header.channel_count = image->channel_count;
+    header.flags = flipped_y ? KTI_FLAG_FLIPPED_Y : 0;
+    header.width = image->width;
+    header.height = image->height;
+    u64 pixel_size = (u64)image->width * image->height * image->channel_count;
+
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("image_loader_write_kti - unable to open '%s' for writing.", path);
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&f, sizeof(kti_header), &header, &written) && written == sizeof(kti_header);
+    result = result && filesystem_write(&f, pixel_size, image->pixels, &written) && written == pixel_size;
+    filesystem_close(&f);
+    if (!result) {
+        KERROR("image_loader_write_kti - failed writing '%s'.", path);
+        return false;
+    }
+
+    // so it can be found without remounting
+    vfs_track_file(path);
+    return true;
+}
+// NOTE: end cooked images
+
 // private method for loading an image loader
 b8 image_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_SCOPE("image_loader_load");
     // ensure that proper data was input
     if (!self || !name || !out_resource) {
         return false;
@@ -21,27 +119,44 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
 
     image_resource_params* typed_params = (image_resource_params*)params;
 
-    char* format_str = "%s/%s/%s%s";
     const i32 required_channel_count = 4;
-    stbi_set_flip_vertically_on_load(typed_params->flip_y);
-    char full_file_path[512];
-
-// try different extensions
-#define IMAGE_EXTENSION_COUNT 4
-    b8 found = false;
-    char* extensions[IMAGE_EXTENSION_COUNT] = {".tga", ".png", ".jpg", ".bmp"};
-    for (u32 i = 0; i < IMAGE_EXTENSION_COUNT; ++i) {
-        string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, extensions[i]);
-        if (filesystem_exists(full_file_path)) {
-            found = true;
-            break;
-        }
-    }
-
-    if (!found) {
-        KERROR("Image resource loader failed find file '%s' or at least with any supported extension.", full_file_path);
+    // the per thread version, as images can be loaded from several job threads at once
+    stbi_set_flip_vertically_on_load_thread(typed_params->flip_y);
+
+    // try each supported extension, in order. each is a lookup in the vfs rather than a trip to the file system. a
+    // cooked image comes first, unless the source is asked for
+#define IMAGE_EXTENSION_COUNT 5
+    const char* extensions[IMAGE_EXTENSION_COUNT] = {".kti", ".tga", ".png", ".jpg", ".bmp"};
+    u32 first_extension = typed_params->force_import ? 1 : 0;
+    char file_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, "", file_path);
+    vfs_file f;
+    u32 extension_index = 0;
+    if (!vfs_open_any(file_path, IMAGE_EXTENSION_COUNT - first_extension, extensions + first_extension, &f, &extension_index)) {
+        KERROR("Image resource loader failed find file '%s' or at least with any supported extension.", file_path);
         return false;
     }
+    resource_loader_record_read(self, f.size);
+
+    if (first_extension + extension_index == 0) {
+        image_resource_data* resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+        kti_image* image = 0;
+        // TODO: should be using an allocator here.
+        out_resource->full_path = string_duplicate(f.path);
+        if (!load_kti_file(&f, typed_params->flip_y, resource_data, &image)) {
+            KERROR("Image resource loader failed to load cooked image '%s'. It may need cooking again.", out_resource->full_path);
+            vfs_close(&f);
+            kfree(resource_data, sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
+            kfree(out_resource->full_path, string_length(out_resource->full_path) + 1, MEMORY_TAG_STRING);
+            out_resource->full_path = 0;
+            return false;
+        }
+        out_resource->data = resource_data;
+        out_resource->data_size = sizeof(image_resource_data);
+        out_resource->loader_data = image;
+        out_resource->name = name;
+        return true;
+    }
 
     i32 width;
     i32 height;
@@ -49,20 +164,23 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
 
     // for now, assume 8 bits per channel, 4 channels
     // TODO: extend this to make it configurable.
-    u8* data = stbi_load(
-        full_file_path,
+    u8* data = stbi_load_from_memory(
+        f.data,
+        (i32)f.size,
         &width,
         &height,
         &channel_count,
         required_channel_count);
 
     if (!data) {
-        KERROR("Image resource loader failed to load file '%s'.", full_file_path);
+        KERROR("Image resource loader failed to load file '%s'.", f.path);
+        vfs_close(&f);
         return false;
     }
 
     // TODO: should be using an allocator here.
-    out_resource->full_path = string_duplicate(full_file_path);
+    out_resource->full_path = string_duplicate(f.path);
+    vfs_close(&f);
 
     // TODO: should be using an allocator here.
     image_resource_data* resource_data = kallocate(sizeof(image_resource_data), MEMORY_TAG_TEXTURE);
@@ -73,13 +191,25 @@ b8 image_loader_load(struct resource_loader* self, const char* name, void* param
 
     out_resource->data = resource_data;
     out_resource->data_size = sizeof(image_resource_data);
+    out_resource->loader_data = 0;
     out_resource->name = name;
 
     return true;
 }
 
 void image_loader_unload(struct resource_loader* self, resource* resource) {
-    stbi_image_free(((image_resource_data*)resource->data)->pixels);
+    kti_image* image = resource->loader_data;
+    if (image) {
+        if (image->flipped_pixels) {
+            kfree(image->flipped_pixels, image->pixel_size, MEMORY_TAG_TEXTURE);
+        } else {
+            vfs_close(&image->file);
+        }
+        kfree(image, sizeof(kti_image), MEMORY_TAG_RESOURCE);
+        resource->loader_data = 0;
+    } else {
+        stbi_image_free(((image_resource_data*)resource->data)->pixels);
+    }
     if (!resource_unload(self, resource, MEMORY_TAG_TEXTURE)) {
         KWARN("image_loader_unload called with nullptr for self or resource.");
     }
@@ -92,6 +222,7 @@ resource_loader image_resource_loader_create() {
     loader.load = image_loader_load;
     loader.unload = image_loader_unload;
     loader.type_path = "textures";
+    loader.params_size = sizeof(image_resource_params);
 
     return loader;
 }
\ No newline at end of file
@@ -2,4 +2,12 @@
 
 #include "systems/resource_system.h"
 
-resource_loader image_resource_loader_create();
\ No newline at end of file
+resource_loader image_resource_loader_create();
+
+// @brief writes a cooked image (.kti), which holds the pixels exactly as they are uploaded so that loading one skips
+// decoding. the image loader picks a .kti ahead of any source image of the same name
+// @param path the path to write to
+// @param image the image to write, as loaded by the image loader
+// @param flipped_y true if the image was loaded with flip_y. loading it the other way round costs a copy
+// @return true on success, otherwise false
+KAPI b8 image_loader_write_kti(const char* path, const image_resource_data* image, b8 flipped_y);
@@ -3,6 +3,7 @@
 #include "core/kmemory.h"
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "systems/resource_system.h"
 
 b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag tag) {
     if (!self || !resource) {
@@ -23,4 +24,12 @@ b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag
     }
 
     return true;
-}
\ No newline at end of file
+}
+
+void resource_path(struct resource_loader* self, const char* name, const char* extension, char* out_path) {
+    if (self->type_path && self->type_path[0]) {
+        string_format(out_path, "%s/%s%s", self->type_path, name, extension);
+    } else {
+        string_format(out_path, "%s%s", name, extension);
+    }
+}
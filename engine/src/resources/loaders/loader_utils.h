@@ -6,4 +6,11 @@
 
 struct resource_loader;
 
-b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag tag);
\ No newline at end of file
+b8 resource_unload(struct resource_loader* self, resource* resource, memory_tag tag);
+
+// @brief builds the path a resource is found at in the vfs. that is the loader's type path, then the name, then the extension
+// @param self the loader
+// @param name the name of the resource
+// @param extension the extension, including the dot. can be empty
+// @param out_path a character array to hold the path, at least VFS_MAX_PATH_LENGTH long
+void resource_path(struct resource_loader* self, const char* name, const char* extension, char* out_path);
\ No newline at end of file
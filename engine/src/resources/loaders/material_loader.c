@@ -8,7 +8,7 @@
 #include "math/kmath.h"
 #include "loader_utils.h"
 
-#include "platform/filesystem.h"
+#include "systems/vfs_system.h"
 
 b8 material_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
     if (!self || !name || !out_resource) {
@@ -16,18 +16,18 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
     }
 
     // put all the different stuff together to make a string that is the filepath to the file
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, ".kmt");
+    char file_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, ".kmt", file_path);
 
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, false, &f)) {
-        KERROR("material_loader_load - unable to open material file for reading: '%s'.", full_file_path);
+    vfs_file f;
+    if (!vfs_open(file_path, &f)) {
+        KERROR("material_loader_load - unable to open material file for reading: '%s'.", file_path);
         return false;
     }
+    resource_loader_record_read(self, f.size);
 
     // TODO: should be using an allocator here
-    out_resource->full_path = string_duplicate(full_file_path);
+    out_resource->full_path = string_duplicate(f.path);
 
     // TODO: should be using an allocator here
     material_config* resource_data = kallocate(sizeof(material_config), MEMORY_TAG_MATERIAL_INSTANCE);
@@ -45,7 +45,7 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
     char* p = &line_buf[0];
     u64 line_length = 0;
     u32 line_number = 1;
-    while (filesystem_read_line(&f, 511, &p, &line_length)) {
+    while (vfs_read_line(&f, 511, &p, &line_length)) {
         // trim the string
         char* trimmed = string_trim(line_buf);
 
@@ -61,7 +61,7 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
         // split into var/value
         i32 equal_index = string_index_of(trimmed, '=');
         if (equal_index == -1) {
-            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", full_file_path, line_number);
+            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", f.path, line_number);
             line_number++;
             continue;
         }
@@ -92,7 +92,7 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
         } else if (strings_equali(trimmed_var_name, "diffuse_colour")) {
             // parse the color
             if (!string_to_vec4(trimmed_value, &resource_data->diffuse_colour)) {
-                KWARN("Error parsing diffuse_colour if file '%s'. Using default white instead.", full_file_path);
+                KWARN("Error parsing diffuse_colour if file '%s'. Using default white instead.", f.path);
                 // NOTE: already assigned above, no need to have it here
             }
         } else if (strings_equali(trimmed_var_name, "shader")) {
@@ -100,7 +100,7 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
             resource_data->shader_name = string_duplicate(trimmed_value);
         } else if (strings_equali(trimmed_var_name, "shininess")) {
             if (!string_to_f32(trimmed_value, &resource_data->shininess)) {
-                KWARN("Error parsing shininess in file '%s'. Using default of 32.0 instead.", full_file_path);
+                KWARN("Error parsing shininess in file '%s'. Using default of 32.0 instead.", f.path);
                 resource_data->shininess = 32.0f;
             }
         }
@@ -111,7 +111,7 @@ b8 material_loader_load(struct resource_loader* self, const char* name, void* pa
         line_number++;
     }
 
-    filesystem_close(&f);
+    vfs_close(&f);
 
     out_resource->data = resource_data;
     out_resource->data_size = sizeof(material_config);
@@ -133,6 +133,7 @@ resource_loader material_resource_loader_create() {
     loader.load = material_loader_load;
     loader.unload = material_loader_unload;
     loader.type_path = "materials";
+    loader.params_size = 0;
 
     return loader;
 }
\ No newline at end of file
@@ -3,15 +3,22 @@
 #include "core/logger.h"
 #include "core/kmemory.h"
 #include "core/kstring.h"
+#include "core/kbinary.h"
+#include "core/lz4.h"
+#include "core/profiler.h"
+#include "core/xxhash.h"
 #include "containers/darray.h"
 #include "resources/resource_types.h"
 #include "systems/resource_system.h"
 #include "systems/geometry_system.h"
+#include "systems/job_system.h"
 #include "math/kmath.h"
 #include "math/geometry_utils.h"
 #include "loader_utils.h"
+#include "obj_parser.h"
 
 #include "platform/filesystem.h"
+#include "systems/vfs_system.h"
 
 #include <stdio.h>  //sscanf
 
@@ -21,85 +28,320 @@ typedef enum mesh_file_type {
     MESH_FILE_TYPE_OBJ
 } mesh_file_type;
 
-typedef struct supported_mesh_filetype {
-    char* extension;
-    mesh_file_type type;
-    b8 is_binary;
-} supported_mesh_filetype;
-
-typedef struct mesh_vertex_index_data {
-    u32 position_index;
-    u32 normal_index;
-    u32 texcoord_index;
-} mesh_vertex_index_data;
-
-typedef struct mesh_face_data {
-    mesh_vertex_index_data vertices[3];
-} mesh_face_data;
-
 typedef struct mesh_group_data {
     // darray
     mesh_face_data* faces;
+    char material_name[MATERIAL_NAME_MAX_LENGTH];
 } mesh_group_data;
 
-b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray);
+b8 import_obj_file(struct resource_loader* self, vfs_file* obj_file, const char* obj_path, const char* out_ksm_filename, const mesh_resource_params* params, geometry_config** out_geometries_darray);
 void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data);
-b8 import_obj_material_library_file(const char* mtl_file_path);
+b8 import_obj_material_library_file(struct resource_loader* self, const char* mtl_file_path);
+
+b8 load_ksm_file(const vfs_file* ksm_file, geometry_config** out_geometries_darray, b8* out_borrowed);
+static void ksm_dispose_configs(const vfs_file* file, geometry_config* configs);
+static void ksm_pack_vertices(const vfs_file* file, geometry_config* configs);
+b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries, b8 pack_streams);
+b8 write_kmt_file(material_config* config);
+
+// bump whenever importing gives different output (the .ksm, or the .kmt files), so every model is imported again
+#define MESH_IMPORTER_VERSION 7
+// how much worse the vertex cache is allowed to get to cut down overdraw, when optimizing
+#define MESH_IMPORT_OVERDRAW_THRESHOLD 1.05f
+// the furthest a level of detail may move the surface, relative to the size of the geometry's bounds
+#define MESH_IMPORT_LOD_MAX_ERROR 0.05f
+// the most files a model is imported from, that is the obj and the material libraries it names
+#define MESH_IMPORT_MAX_SOURCE_COUNT 8
+// the levels of detail generated for each geometry by mesh_loader_cook_params, counting full detail
+#define MESH_COOK_LOD_COUNT 4
+
+// NOTE: begin import manifest
+
+// each imported .ksm has a .ksm.meta file next to it, recording what it was imported from. that is the importer
+// version, and the hash of each source file's content. if any of them no longer match, the .ksm is stale
+
+typedef struct mesh_import_source {
+    u64 content_hash;
+    char path[VFS_MAX_PATH_LENGTH];
+} mesh_import_source;
+
+typedef struct mesh_import_manifest {
+    u32 importer_version;
+    u32 source_count;
+    mesh_import_source sources[MESH_IMPORT_MAX_SOURCE_COUNT];
+} mesh_import_manifest;
+
+static void mesh_import_add_source(mesh_import_manifest* manifest, const char* path, u64 content_hash) {
+    if (manifest->source_count == MESH_IMPORT_MAX_SOURCE_COUNT) {
+        KWARN("Mesh import of '%s' has too many sources, changes to it will not be picked up.", path);
+        return;
+    }
+    mesh_import_source* source = &manifest->sources[manifest->source_count++];
+    source->content_hash = content_hash;
+    string_ncopy(source->path, path, VFS_MAX_PATH_LENGTH - 1);
+}
+
+// hashes the obj and each material library it names. a missing material library is recorded with a hash of 0, so the
+// model is imported again once it turns up
+static void mesh_import_hash_sources(const char* text, u64 size, const char* obj_path, mesh_import_manifest* out_manifest) {
+    KPROFILE_SCOPE("mesh_import_hash_sources");
+    mesh_import_add_source(out_manifest, obj_path, xxhash64(text, size, 0));
+
+    char directory[VFS_MAX_PATH_LENGTH] = "";
+    string_directory_from_path(directory, obj_path);
+
+    u64 position = 0;
+    while (position < size) {
+        u64 line_end = position;
+        while (line_end < size && text[line_end] != '\n') {
+            line_end++;
+        }
+
+        if (line_end - position > 7 && strings_nequal(text + position, "mtllib ", 7)) {
+            char line[VFS_MAX_PATH_LENGTH] = "";
+            u64 length = line_end - position - 7;
+            if (length >= VFS_MAX_PATH_LENGTH) {
+                length = VFS_MAX_PATH_LENGTH - 1;
+            }
+            kcopy_memory(line, text + position + 7, length);
+            char mtl_path[VFS_MAX_PATH_LENGTH * 2];
+            string_format(mtl_path, "%s%s", directory, string_trim(line));
+
+            u64 content_hash = 0;
+            vfs_file mtl_file;
+            if (vfs_open(mtl_path, &mtl_file)) {
+                content_hash = xxhash64(mtl_file.data, mtl_file.size, 0);
+                vfs_close(&mtl_file);
+            }
+            mesh_import_add_source(out_manifest, mtl_path, content_hash);
+        }
+        position = line_end + 1;
+    }
+}
+
+// parses a "source=<hash> <path>" line. done by hand, as the path is bounded by the size of what it is copied into
+// rather than a width written into a format string. false if the line is malformed or the path too long
+static b8 mesh_import_parse_source(const char* line, mesh_import_source* out_source) {
+    if (!strings_nequal(line, "source=", 7)) {
+        return false;
+    }
+    const char* c = line + 7;
+    u64 content_hash = 0;
+    u32 digit_count = 0;
+    for (;; ++c, ++digit_count) {
+        u32 digit;
+        if (*c >= '0' && *c <= '9') {
+            digit = *c - '0';
+        } else if (*c >= 'a' && *c <= 'f') {
+            digit = *c - 'a' + 10;
+        } else if (*c >= 'A' && *c <= 'F') {
+            digit = *c - 'A' + 10;
+        } else {
+            break;
+        }
+        if (digit_count == 16) {
+            return false;
+        }
+        content_hash = (content_hash << 4) | digit;
+    }
+    if (digit_count == 0 || *c != ' ') {
+        return false;
+    }
+
+    const char* path = c + 1;
+    u64 length = string_length(path);
+    if (length == 0 || length >= sizeof(out_source->path)) {
+        return false;
+    }
+    out_source->content_hash = content_hash;
+    kcopy_memory(out_source->path, path, length + 1);
+    return true;
+}
+
+// true if the manifest matches the sources as they are now. the name is only for messages
+static b8 mesh_import_manifest_matches(vfs_file* manifest_file, const char* name, const mesh_import_manifest* sources) {
+    char line_buffer[VFS_MAX_PATH_LENGTH + 64];
+    char* p = &line_buffer[0];
+    u64 line_length = 0;
+    u32 importer_version = 0;
+    u32 source_index = 0;
+    b8 matches = true;
+    while (matches && vfs_read_line(manifest_file, sizeof(line_buffer), &p, &line_length)) {
+        char* line = string_trim(line_buffer);
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+
+        mesh_import_source source;
+        kzero_memory(&source, sizeof(mesh_import_source));
+        if (sscanf(line, "importer_version=%u", &importer_version) == 1) {
+            matches = importer_version == MESH_IMPORTER_VERSION;
+        } else if (mesh_import_parse_source(line, &source)) {
+            const mesh_import_source* current = source_index < sources->source_count ? &sources->sources[source_index] : 0;
+            matches = current && current->content_hash == source.content_hash && strings_equal(current->path, source.path);
+            source_index++;
+        } else {
+            KWARN("Mesh import manifest for '%s' has an unknown line '%s'.", name, line);
+            matches = false;
+        }
+    }
+    return matches && importer_version == MESH_IMPORTER_VERSION && source_index == sources->source_count;
+}
+
+// true if the manifest next to the .ksm matches the sources as they are now
+static b8 mesh_import_manifest_up_to_date(struct resource_loader* self, const char* name, const mesh_import_manifest* sources) {
+    char path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, ".ksm.meta", path);
+    vfs_file f;
+    if (!vfs_open(path, &f)) {
+        // either never imported, or imported before there were manifests
+        return false;
+    }
+
+    b8 matches = mesh_import_manifest_matches(&f, name, sources);
+    vfs_close(&f);
+    if (!matches) {
+        KINFO("Mesh '%s' has changed since it was imported, importing it again.", name);
+    }
+    return matches;
+}
+
+static b8 mesh_import_write_line(kbinary_writer* writer, const char* text) {
+    return kbinary_write(writer, string_length(text), text) && kbinary_write_u8(writer, '\n');
+}
+
+static b8 mesh_import_manifest_format(kbinary_writer* writer, const mesh_import_manifest* manifest) {
+    char line_buffer[VFS_MAX_PATH_LENGTH + 64];
+    b8 result = mesh_import_write_line(writer, "#mesh import manifest. rewritten each time the mesh is imported");
+    string_format(line_buffer, "importer_version=%u", manifest->importer_version);
+    result = result && mesh_import_write_line(writer, line_buffer);
+    for (u32 i = 0; i < manifest->source_count && result; ++i) {
+        string_format(line_buffer, "source=%016llx %s", manifest->sources[i].content_hash, manifest->sources[i].path);
+        result = mesh_import_write_line(writer, line_buffer);
+    }
+    return result;
+}
+
+static b8 mesh_import_manifest_write(struct resource_loader* self, const char* name, const mesh_import_manifest* manifest) {
+    char path[512];
+    string_format(path, "%s/%s/%s%s", resource_system_base_path(), self->type_path, name, ".ksm.meta");
+    kbinary_writer writer;
+    if (!kbinary_writer_open(path, 0, &writer)) {
+        KERROR("Unable to open mesh import manifest '%s' for writing.", path);
+        return false;
+    }
+    b8 result = mesh_import_manifest_format(&writer, manifest);
+    result = kbinary_writer_close(&writer) && result;
+    if (!result) {
+        KERROR("Unable to write mesh import manifest '%s'.", path);
+        return false;
+    }
+    vfs_track_file(path);
+    return true;
+}
 
-b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray);
-b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries);
-b8 write_kmt_file(const char* directory, material_config* config);
+b8 mesh_loader_write_import_manifest(kbinary_writer* writer, const char* obj_path, const void* obj_data, u64 obj_size) {
+    mesh_import_manifest manifest;
+    kzero_memory(&manifest, sizeof(mesh_import_manifest));
+    mesh_import_hash_sources(obj_data, obj_size, obj_path, &manifest);
+    manifest.importer_version = MESH_IMPORTER_VERSION;
+    return mesh_import_manifest_format(writer, &manifest);
+}
+
+b8 mesh_loader_import_manifest_matches(const void* manifest_data, u64 manifest_size, const char* obj_path, const void* obj_data, u64 obj_size) {
+    mesh_import_manifest sources;
+    kzero_memory(&sources, sizeof(mesh_import_manifest));
+    mesh_import_hash_sources(obj_data, obj_size, obj_path, &sources);
+    vfs_file manifest_file;
+    kzero_memory(&manifest_file, sizeof(vfs_file));
+    manifest_file.data = manifest_data;
+    manifest_file.size = manifest_size;
+    return mesh_import_manifest_matches(&manifest_file, obj_path, &sources);
+}
+
+// NOTE: end import manifest
+
+mesh_resource_params mesh_loader_cook_params(b8 pack_streams) {
+    mesh_resource_params params = {};
+    params.pack_streams = pack_streams;
+    params.optimize = true;
+    params.lod_count = MESH_COOK_LOD_COUNT;
+    params.meshlets = true;
+    return params;
+}
 
 b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    KPROFILE_SCOPE("mesh_loader_load");
     if (!self || !name || !out_resource) {
         return false;
     }
 
-    char* format_str = "%s/%s/%s%s";
-    file_handle f;
-// supported extensions. note that these are in order of priority when looked up.  this is to prioritize the loading of a binary version
-// of the mesh, followed by importing various types of meshes to binary types, which would be loaded on the next run
-// TODO: may be goo to be able to specify an override to always import (i.e. skip binary versions) for debug purposes
-#define SUPPORTED_FILETYPE_COUNT 2
-    supported_mesh_filetype supported_filetypes[SUPPORTED_FILETYPE_COUNT];
-    supported_filetypes[0] = (supported_mesh_filetype){".ksm", MESH_FILE_TYPE_KSM, true};
-    supported_filetypes[1] = (supported_mesh_filetype){".obj", MESH_FILE_TYPE_OBJ, false};
+    // the binary .ksm is preferred, as long as the import manifest says it was made from the obj (and its material
+    // libraries) as they are now. otherwise the obj is imported again, writing a fresh .ksm to be loaded next time. a
+    // .ksm without its obj, as shipped in an archive, is always used. mesh_resource_params.force_import skips the .ksm,
+    // which is how assetcook rebuilds it
+    mesh_resource_params* typed_params = params;
+    b8 force_import = typed_params && typed_params->force_import;
+
+    char obj_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, ".obj", obj_path);
+    vfs_file obj_file;
+    b8 have_obj = vfs_open(obj_path, &obj_file);
+
+    mesh_import_manifest sources;
+    kzero_memory(&sources, sizeof(mesh_import_manifest));
+    b8 use_ksm = !force_import;
+    if (have_obj) {
+        mesh_import_hash_sources(obj_file.data, obj_file.size, obj_path, &sources);
+        use_ksm = use_ksm && mesh_import_manifest_up_to_date(self, name, &sources);
+    }
 
-    char full_file_path[512];
+    vfs_file f;
     mesh_file_type type = MESH_FILE_TYPE_NOT_FOUND;
-    // try each supported extension
-    for (u32 i = 0; i < SUPPORTED_FILETYPE_COUNT; ++i) {
-        string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, supported_filetypes[i].extension);
-        // if the file exists, open it and stop looking
-        if (filesystem_exists(full_file_path)) {
-            if (filesystem_open(full_file_path, FILE_MODE_READ, supported_filetypes[i].is_binary, &f)) {
-                type = supported_filetypes[i].type;
-                break;
-            }
+    char ksm_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, ".ksm", ksm_path);
+    if (use_ksm && vfs_open(ksm_path, &f)) {
+        type = MESH_FILE_TYPE_KSM;
+        if (have_obj) {
+            vfs_close(&obj_file);
         }
+    } else if (have_obj) {
+        type = MESH_FILE_TYPE_OBJ;
+        f = obj_file;
     }
 
     if (type == MESH_FILE_TYPE_NOT_FOUND) {
         KERROR("Unable to find mesh of supported type called '%s'.", name);
         return false;
     }
+    resource_loader_record_read(self, f.size);
 
-    out_resource->full_path = string_duplicate(full_file_path);
+    out_resource->full_path = string_duplicate(f.path);
 
     // the resource data is just an array of configs
     geometry_config* resource_data = darray_create(geometry_config);
 
     b8 result = false;
+    b8 borrowed = false;
     switch (type) {
         case MESH_FILE_TYPE_OBJ: {
             // generates the ksm filename
             char ksm_file_name[512];
             string_format(ksm_file_name, "%s/%s/%s%s", resource_system_base_path(), self->type_path, name, ".ksm");
-            result = import_obj_file(&f, ksm_file_name, &resource_data);
+            mesh_resource_params default_params = mesh_loader_cook_params(false);
+            result = import_obj_file(self, &f, obj_path, ksm_file_name, typed_params ? typed_params : &default_params, &resource_data);
+            // only once everything is written, so a failed import is tried again next time
+            if (result) {
+                sources.importer_version = MESH_IMPORTER_VERSION;
+                mesh_import_manifest_write(self, name, &sources);
+            }
             break;
         }
         case MESH_FILE_TYPE_KSM:
-            result = load_ksm_file(&f, &resource_data);
+            result = load_ksm_file(&f, &resource_data, &borrowed);
+            if (result) {
+                ksm_pack_vertices(&f, resource_data);
+            }
             break;
         default:
         case MESH_FILE_TYPE_NOT_FOUND:
@@ -108,16 +350,27 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
             break;
     }
 
-    filesystem_close(&f);
-
     if (!result) {
-        KERROR("Failed to process mesh file '%s'.", full_file_path);
+        KERROR("Failed to process mesh file '%s'.", f.path);
+        vfs_close(&f);
         darray_destroy(resource_data);
+        kfree(out_resource->full_path, string_length(out_resource->full_path) + 1, MEMORY_TAG_STRING);
+        out_resource->full_path = 0;
         out_resource->data = 0;
         out_resource->data_size = 0;
         return false;
     }
 
+    out_resource->loader_data = 0;
+    if (borrowed) {
+        // the geometries point straight into the file, so it stays open until unload
+        vfs_file* kept = kallocate(sizeof(vfs_file), MEMORY_TAG_RESOURCE);
+        *kept = f;
+        out_resource->loader_data = kept;
+    } else {
+        vfs_close(&f);
+    }
+
     out_resource->data = resource_data;
     // use the data size as a count
     out_resource->data_size = darray_length(resource_data);
@@ -126,404 +379,1300 @@ b8 mesh_loader_load(struct resource_loader* self, const char* name, void* params
 }
 
 void mesh_loader_unload(struct resource_loader* self, resource* resource) {
-    u32 count = darray_length(resource->data);
-    for (u32 i = 0; i < count; ++i) {
-        geometry_config* config = &((geometry_config*)resource->data)[i];
-        geometry_system_config_dispose(config);
-    }
+    vfs_file* file = resource->loader_data;
+    ksm_dispose_configs(file, resource->data);
     darray_destroy(resource->data);
+    if (file) {
+        vfs_close(file);
+        kfree(file, sizeof(vfs_file), MEMORY_TAG_RESOURCE);
+        resource->loader_data = 0;
+    }
     resource->data = 0;
     resource->data_size = 0;
+
+    if (resource->full_path) {
+        kfree(resource->full_path, string_length(resource->full_path) + 1, MEMORY_TAG_STRING);
+        resource->full_path = 0;
+    }
 }
 
-b8 load_ksm_file(file_handle* ksm_file, geometry_config** out_geometries_darray) {
-    // version
-    u64 bytes_read = 0;
-    u16 version = 0;
-    filesystem_read(ksm_file, sizeof(u16), &version, &bytes_read);
+// NOTE: begin ksm
+
+// version 2 of the format is laid out to be used straight out of a mapped file (or an archive), with nothing copied:
+//   header      KSM_HEADER_SIZE bytes. the version comes first, as in version 1 files, so one read tells them apart
+//   sections    section_count entries of KSM_SECTION_SIZE, saying where everything after them is
+//   geometries  geometry_count entries of KSM_GEOMETRY_SIZE, including the precomputed bounds
+//   strings     the mesh, geometry and material names, each terminated
+//   blobs       the vertices then indices of each geometry, each starting on a KSM_ALIGNMENT boundary
+//   lods        optional, KSM_LOD_SIZE entries for each level of detail of each geometry that has more than one. each is
+//               a range of the geometry's indices, which hold every level one after the other
+//   meshlets    optional, KSM_MESHLET_SIZE entries for each meshlet of each geometry that has them, in order of geometry
+//               then level of detail. each is a range of that level's indices, with its bounds
+// vertices are whatever the vertex size says. the importer writes vertex_3d_packed, relative to the geometry's extents.
+// vertex_3d ones, from older files, are packed as they're loaded
+// everything is little endian, and offsets are from the start of the file. the checksum covers everything after the
+// header. sections of a type the reader doesn't know are skipped, so new ones can be added without a new version.
+// version 1 files (the version, then each field in turn with nothing aligned) are still read
+
+#define KSM_VERSION_1 0x0001U
+#define KSM_VERSION_2 0x0002U
+// "KSM2", right after the version
+#define KSM_MAGIC 0x324d534bU
+// where every blob starts. enough for any vertex or index type, and for sse loads straight out of the file
+#define KSM_ALIGNMENT 16
+#define KSM_HEADER_SIZE 48
+#define KSM_SECTION_SIZE 32
+#define KSM_GEOMETRY_SIZE 72
+#define KSM_LOD_SIZE 16
+#define KSM_MESHLET_SIZE 48
+// the widest element ksm_pack_stream will pack. anything wider is stored as is
+#define KSM_MAX_PACKED_STRIDE 256
+
+typedef enum ksm_section_type {
+    KSM_SECTION_TYPE_GEOMETRIES = 1,
+    KSM_SECTION_TYPE_STRINGS = 2,
+    KSM_SECTION_TYPE_VERTICES = 3,
+    KSM_SECTION_TYPE_INDICES = 4,
+    KSM_SECTION_TYPE_LODS = 5,
+    KSM_SECTION_TYPE_MESHLETS = 6
+} ksm_section_type;
+
+typedef enum ksm_encoding {
+    // stored as is, so it can be used in place
+    KSM_ENCODING_NONE = 0,
+    // see ksm_pack_stream
+    KSM_ENCODING_PACKED = 1
+} ksm_encoding;
+
+typedef struct ksm_section {
+    u32 type;
+    u32 encoding;
+    u64 offset;
+    // the size in the file
+    u64 size;
+    // the size once unpacked. the same as size when not packed
+    u64 decoded_size;
+} ksm_section;
+
+// packs count elements of stride bytes each. each byte of the elements is stored together (every first byte, then
+// every second byte and so on) as the difference from the same byte of the element before, which is then lz4
+// compressed. neighbouring vertices are close, so the high bytes of each value mostly come out as runs of zeroes. the
+// same idea as meshoptimizer's vertex codec, leaving the entropy coding to lz4. returns 0 if it isn't worth it
+static u8* ksm_pack_stream(const void* data, u32 stride, u32 count, u64* out_capacity, u64* out_size) {
+    u64 size = (u64)stride * count;
+    if (size == 0 || stride > KSM_MAX_PACKED_STRIDE) {
+        return 0;
+    }
+    const u8* bytes = data;
+    u8* planes = kallocate(size, MEMORY_TAG_ARRAY);
+    for (u32 b = 0; b < stride; ++b) {
+        u8* plane = planes + (u64)b * count;
+        u8 previous = 0;
+        for (u32 i = 0; i < count; ++i) {
+            u8 value = bytes[(u64)i * stride + b];
+            plane[i] = value - previous;
+            previous = value;
+        }
+    }
 
-    // name length
-    u32 name_length = 0;
-    filesystem_read(ksm_file, sizeof(u32), &name_length, &bytes_read);
+    *out_capacity = lz4_compress_bound(size);
+    u8* packed = kallocate(*out_capacity, MEMORY_TAG_ARRAY);
+    *out_size = lz4_compress(planes, size, packed, *out_capacity);
+    kfree(planes, size, MEMORY_TAG_ARRAY);
+    if (*out_size == 0 || *out_size >= size) {
+        kfree(packed, *out_capacity, MEMORY_TAG_ARRAY);
+        return 0;
+    }
+    return packed;
+}
+
+// undoes ksm_pack_stream, into out_data which must hold stride * count bytes
+static b8 ksm_unpack_stream(const void* packed, u64 packed_size, u32 stride, u32 count, void* out_data) {
+    u64 size = (u64)stride * count;
+    if (stride > KSM_MAX_PACKED_STRIDE) {
+        return false;
+    }
+    u8* planes = kallocate(size, MEMORY_TAG_ARRAY);
+    b8 result = lz4_decompress(packed, packed_size, planes, size);
+    if (result) {
+        // a vertex at a time, so the output is written in order
+        u8 previous[KSM_MAX_PACKED_STRIDE] = {0};
+        u8* bytes = out_data;
+        for (u32 i = 0; i < count; ++i) {
+            for (u32 b = 0; b < stride; ++b) {
+                previous[b] += planes[(u64)b * count + i];
+                bytes[(u64)i * stride + b] = previous[b];
+            }
+        }
+    }
+    kfree(planes, size, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+// disposes of configs loaded from file, leaving alone any arrays that point straight into it. file can be 0
+static void ksm_dispose_configs(const vfs_file* file, geometry_config* configs) {
+    const u8* file_start = file ? file->data : 0;
+    const u8* file_end = file_start + (file ? file->size : 0);
+    u32 count = darray_length(configs);
+    for (u32 i = 0; i < count; ++i) {
+        geometry_config* config = &configs[i];
+        if ((const u8*)config->vertices >= file_start && (const u8*)config->vertices < file_end) {
+            config->vertices = 0;
+        }
+        if ((const u8*)config->indices >= file_start && (const u8*)config->indices < file_end) {
+            config->indices = 0;
+        }
+        geometry_system_config_dispose(config);
+    }
+    darray_clear(configs);
+}
+
+// packs the vertices of anything loaded unpacked, from a file written before they were. vertices in the file itself are
+// copied out first, as packing replaces them
+static void ksm_pack_vertices(const vfs_file* file, geometry_config* configs) {
+    const u8* file_start = file->data;
+    const u8* file_end = file_start + file->size;
+    u32 count = darray_length(configs);
+    for (u32 i = 0; i < count; ++i) {
+        geometry_config* config = &configs[i];
+        if (config->vertex_size != sizeof(vertex_3d)) {
+            continue;
+        }
+        if ((const u8*)config->vertices >= file_start && (const u8*)config->vertices < file_end) {
+            void* vertices = kallocate(sizeof(vertex_3d) * config->vertex_count, MEMORY_TAG_ARRAY);
+            kcopy_memory(vertices, config->vertices, sizeof(vertex_3d) * config->vertex_count);
+            config->vertices = vertices;
+        }
+        geometry_system_config_pack_vertices(config);
+    }
+}
+
+// reads a vec3 stored as a whole vertex_3d, as version 1 files do for the center and extents. only the leading vec3 means
+// anything
+static b8 ksm_read_padded_vec3(kbinary_reader* reader, vec3* out_value) {
+    return kbinary_read(reader, sizeof(vec3), out_value) && kbinary_read(reader, sizeof(vertex_3d) - sizeof(vec3), 0);
+}
+
+static b8 load_ksm_v1(kbinary_reader* reader, geometry_config** out_geometries_darray) {
     // name + terminator
     char name[256];
-    filesystem_read(ksm_file, sizeof(char) * name_length, name, &bytes_read);
+    if (!kbinary_read_string(reader, sizeof(name), name)) {
+        KERROR("load_ksm_file - invalid mesh name.");
+        return false;
+    }
 
     // geometry count
     u32 geometry_count = 0;
-    filesystem_read(ksm_file, sizeof(u32), &geometry_count, &bytes_read);
+    if (!kbinary_read_u32(reader, &geometry_count)) {
+        KERROR("load_ksm_file - file is truncated.");
+        return false;
+    }
 
     // each geometry
     for (u32 i = 0; i < geometry_count; ++i) {
         geometry_config g = {};
 
-        // vertices (size/count/array)
-        filesystem_read(ksm_file, sizeof(u32), &g.vertex_size, &bytes_read);
-        filesystem_read(ksm_file, sizeof(u32), &g.vertex_count, &bytes_read);
-        g.vertices = kallocate(g.vertex_size * g.vertex_count, MEMORY_TAG_ARRAY);
-        filesystem_read(ksm_file, g.vertex_size * g.vertex_count, g.vertices, &bytes_read);
+        // vertices (size/count/array). the array is checked to fit before anything is allocated for it
+        kbinary_read_u32(reader, &g.vertex_size);
+        kbinary_read_u32(reader, &g.vertex_count);
+        if ((u64)g.vertex_size * g.vertex_count <= kbinary_reader_remaining(reader)) {
+            g.vertices = kallocate(g.vertex_size * g.vertex_count, MEMORY_TAG_ARRAY);
+            kbinary_read_array(reader, g.vertex_count, g.vertex_size, g.vertices);
+        } else {
+            reader->failed = true;
+        }
 
         // indices (size/count/array)
-        filesystem_read(ksm_file, sizeof(u32), &g.index_size, &bytes_read);
-        filesystem_read(ksm_file, sizeof(u32), &g.index_count, &bytes_read);
-        g.indices = kallocate(g.index_size * g.index_count, MEMORY_TAG_ARRAY);
-        filesystem_read(ksm_file, g.index_size * g.index_count, g.indices, &bytes_read);
-
-        // name
-        u32 g_name_length = 0;
-        filesystem_read(ksm_file, sizeof(u32), &g_name_length, &bytes_read);
-        filesystem_read(ksm_file, sizeof(char) * g_name_length, g.name, &bytes_read);
-
-        // material name
-        u32 m_name_length = 0;
-        filesystem_read(ksm_file, sizeof(u32), &m_name_length, &bytes_read);
-        filesystem_read(ksm_file, sizeof(char) * m_name_length, g.material_name, &bytes_read);
-
-        // center
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.center, &bytes_read);
+        kbinary_read_u32(reader, &g.index_size);
+        kbinary_read_u32(reader, &g.index_count);
+        if ((u64)g.index_size * g.index_count <= kbinary_reader_remaining(reader)) {
+            g.indices = kallocate(g.index_size * g.index_count, MEMORY_TAG_ARRAY);
+            kbinary_read_array(reader, g.index_count, g.index_size, g.indices);
+        } else {
+            reader->failed = true;
+        }
 
-        // extents (min/max)
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.min_extents, &bytes_read);
-        filesystem_read(ksm_file, sizeof(vertex_3d), &g.max_extents, &bytes_read);
+        // name and material name
+        kbinary_read_string(reader, GEOMETRY_NAME_MAX_LENGTH, g.name);
+        kbinary_read_string(reader, MATERIAL_NAME_MAX_LENGTH, g.material_name);
+
+        // center, then extents (min/max)
+        ksm_read_padded_vec3(reader, &g.center);
+        ksm_read_padded_vec3(reader, &g.min_extents);
+        ksm_read_padded_vec3(reader, &g.max_extents);
+
+        // errors stick, so checking once covers everything read for this geometry
+        if (reader->failed) {
+            KERROR("load_ksm_file - geometry %u is truncated or corrupt.", i);
+            geometry_system_config_dispose(&g);
+            ksm_dispose_configs(0, *out_geometries_darray);
+            return false;
+        }
 
         // add to the output array
         darray_push(*out_geometries_darray, g);
     }
 
-    filesystem_close(ksm_file);
-
     return true;
 }
 
-b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries) {
-    if (filesystem_exists(path)) {
-        KINFO("File '%s' already exists and will be overwritten.", path);
+// copies a terminated string out of the strings section, failing if it runs off the end or is too long
+static b8 ksm_read_string_at(const char* strings, u64 strings_size, u32 offset, u64 max_length, char* out_string) {
+    if (offset >= strings_size) {
+        return false;
+    }
+    u64 length = 0;
+    while (offset + length < strings_size && strings[offset + length]) {
+        length++;
     }
+    if (offset + length == strings_size || length >= max_length) {
+        return false;
+    }
+    kcopy_memory(out_string, strings + offset, length);
+    out_string[length] = 0;
+    return true;
+}
 
-    file_handle f;
-    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
-        KERROR("Unable to open file '%s' for writing. KSM write failed.", path);
+// gets the vertices or indices of a geometry out of a section. unpacked data is used in place where it is aligned, and
+// copied where it is not (which only a hand built archive could cause)
+static b8 ksm_read_blob(const vfs_file* ksm_file, const ksm_section* sections, u32 section_count, u32 section_index, ksm_section_type type, u32 stride, u32 count, void** out_data, b8* out_borrowed) {
+    *out_data = 0;
+    if (section_index >= section_count) {
+        return false;
+    }
+    const ksm_section* section = &sections[section_index];
+    u64 size = (u64)stride * count;
+    if (section->type != type || section->decoded_size != size) {
         return false;
     }
+    if (size == 0) {
+        return true;
+    }
 
-    // version
-    u64 written = 0;
-    u16 version = 0x0001U;
-    filesystem_write(&f, sizeof(u16), &version, &written);
+    const u8* data = (const u8*)ksm_file->data + section->offset;
+    if (section->encoding == KSM_ENCODING_NONE) {
+        if (section->size != size) {
+            return false;
+        }
+        if (((u64)data & (KSM_ALIGNMENT - 1)) == 0) {
+            *out_data = (void*)data;
+            *out_borrowed = true;
+            return true;
+        }
+        *out_data = kallocate(size, MEMORY_TAG_ARRAY);
+        kcopy_memory(*out_data, data, size);
+        return true;
+    }
+    if (section->encoding == KSM_ENCODING_PACKED) {
+        *out_data = kallocate(size, MEMORY_TAG_ARRAY);
+        return ksm_unpack_stream(data, section->size, stride, count, *out_data);
+    }
+    return false;
+}
 
-    // name length
-    u32 name_length = string_length(name) + 1;
-    filesystem_write(&f, sizeof(u32), &name_length, &written);
-    // name + terminator
-    filesystem_write(&f, sizeof(char) * name_length, name, &written);
+static void ksm_read_meshlet(kbinary_reader* reader, u32* out_geometry_index, u32* out_lod, geometry_meshlet* out_meshlet) {
+    kbinary_read_u32(reader, out_geometry_index);
+    kbinary_read_u32(reader, out_lod);
+    kbinary_read_u32(reader, &out_meshlet->index_offset);
+    kbinary_read_u32(reader, &out_meshlet->index_count);
+    kbinary_read(reader, sizeof(vec3), &out_meshlet->center);
+    kbinary_read_f32(reader, &out_meshlet->radius);
+    kbinary_read(reader, sizeof(vec3), &out_meshlet->cone_axis);
+    kbinary_read_f32(reader, &out_meshlet->cone_cutoff);
+}
 
-    // geometry count
-    filesystem_write(&f, sizeof(u32), &geometry_count, &written);
+// reads the meshlets into each geometry, once its levels of detail are. a first pass checks and counts them, so each
+// geometry's array is allocated once
+static b8 ksm_read_meshlets(const vfs_file* ksm_file, const ksm_section* section, geometry_config* geometries, u32 geometry_count) {
+    u32 meshlet_count = (u32)(section->size / KSM_MESHLET_SIZE);
+    kbinary_reader reader;
+    kbinary_reader_from_memory((const u8*)ksm_file->data + section->offset, section->size, &reader);
+    u32 previous_geometry = 0;
+    u32 previous_lod = 0;
+    for (u32 i = 0; i < meshlet_count; ++i) {
+        u32 geometry_index = 0;
+        u32 lod = 0;
+        geometry_meshlet meshlet;
+        ksm_read_meshlet(&reader, &geometry_index, &lod, &meshlet);
+        geometry_config* g = geometry_index < geometry_count ? &geometries[geometry_index] : 0;
+        // a geometry with no levels of detail has the one covering all its indices
+        u32 lod_count = g && g->lod_count ? g->lod_count : 1;
+        b8 ordered = geometry_index > previous_geometry || (geometry_index == previous_geometry && lod >= previous_lod);
+        if (reader.failed || !g || !ordered || lod >= lod_count) {
+            KERROR("load_ksm_file - meshlet %u is invalid.", i);
+            return false;
+        }
+        u32 lod_offset = g->lod_count ? g->lods[lod].index_offset : 0;
+        u32 lod_index_count = g->lod_count ? g->lods[lod].index_count : g->index_count;
+        if (meshlet.index_offset < lod_offset || meshlet.index_count > lod_index_count || meshlet.index_offset - lod_offset > lod_index_count - meshlet.index_count) {
+            KERROR("load_ksm_file - meshlet %u is outside its level of detail.", i);
+            return false;
+        }
+        if (g->meshlet_count == 0 || lod != previous_lod || geometry_index != previous_geometry) {
+            g->lods[lod].meshlet_offset = g->meshlet_count;
+        }
+        g->lods[lod].meshlet_count++;
+        g->meshlet_count++;
+        previous_geometry = geometry_index;
+        previous_lod = lod;
+    }
 
-    // each geometry
     for (u32 i = 0; i < geometry_count; ++i) {
-        geometry_config* g = &geometries[i];
+        if (geometries[i].meshlet_count) {
+            geometries[i].meshlets = kallocate(sizeof(geometry_meshlet) * geometries[i].meshlet_count, MEMORY_TAG_ARRAY);
+        }
+    }
+    u32* filled = kallocate(sizeof(u32) * (geometry_count ? geometry_count : 1), MEMORY_TAG_ARRAY);
+    kbinary_reader_from_memory((const u8*)ksm_file->data + section->offset, section->size, &reader);
+    for (u32 i = 0; i < meshlet_count; ++i) {
+        u32 geometry_index = 0;
+        u32 lod = 0;
+        geometry_meshlet meshlet;
+        ksm_read_meshlet(&reader, &geometry_index, &lod, &meshlet);
+        geometries[geometry_index].meshlets[filled[geometry_index]++] = meshlet;
+    }
+    kfree(filled, sizeof(u32) * (geometry_count ? geometry_count : 1), MEMORY_TAG_ARRAY);
+    return true;
+}
 
-        // vertices (size/count/array)
-        filesystem_write(&f, sizeof(u32), &g->vertex_size, &written);
-        filesystem_write(&f, sizeof(u32), &g->vertex_count, &written);
-        filesystem_write(&f, g->vertex_size * g->vertex_count, g->vertices, &written);
+static b8 load_ksm_v2(const vfs_file* ksm_file, kbinary_reader* reader, geometry_config** out_geometries_darray, b8* out_borrowed) {
+    // the version has already been read
+    u16 header_size = 0;
+    u32 magic = 0;
+    u32 section_count = 0;
+    u32 geometry_count = 0;
+    u32 name_offset = 0;
+    u64 file_size = 0;
+    u64 checksum = 0;
+    kbinary_read_u16(reader, &header_size);
+    kbinary_read_u32(reader, &magic);
+    kbinary_read_u32(reader, &section_count);
+    kbinary_read_u32(reader, &geometry_count);
+    kbinary_read_u32(reader, &name_offset);
+    kbinary_read(reader, sizeof(u32), 0);
+    kbinary_read_u64(reader, &file_size);
+    kbinary_read_u64(reader, &checksum);
+    if (reader->failed || magic != KSM_MAGIC || header_size != KSM_HEADER_SIZE || file_size != ksm_file->size) {
+        KERROR("load_ksm_file - invalid or truncated header.");
+        return false;
+    }
+    if (xxhash64((const u8*)ksm_file->data + KSM_HEADER_SIZE, ksm_file->size - KSM_HEADER_SIZE, 0) != checksum) {
+        KERROR("load_ksm_file - checksum mismatch, the file is corrupt.");
+        return false;
+    }
 
-        // indices (size/count/array)
-        filesystem_write(&f, sizeof(u32), &g->index_size, &written);
-        filesystem_write(&f, sizeof(u32), &g->index_count, &written);
-        filesystem_write(&f, g->index_size * g->index_count, g->indices, &written);
+    // the section table, each checked to lie within the file
+    kbinary_reader_from_memory(ksm_file->data, ksm_file->size, reader);
+    kbinary_read(reader, KSM_HEADER_SIZE, 0);
+    if ((u64)section_count * KSM_SECTION_SIZE > kbinary_reader_remaining(reader)) {
+        KERROR("load_ksm_file - section table is truncated.");
+        return false;
+    }
+    ksm_section* sections = kallocate(sizeof(ksm_section) * (section_count ? section_count : 1), MEMORY_TAG_ARRAY);
+    const ksm_section* geometries = 0;
+    const ksm_section* strings = 0;
+    const ksm_section* lods = 0;
+    const ksm_section* meshlets = 0;
+    b8 result = true;
+    for (u32 i = 0; i < section_count; ++i) {
+        ksm_section* s = &sections[i];
+        kbinary_read_u32(reader, &s->type);
+        kbinary_read_u32(reader, &s->encoding);
+        kbinary_read_u64(reader, &s->offset);
+        kbinary_read_u64(reader, &s->size);
+        kbinary_read_u64(reader, &s->decoded_size);
+        if (s->size > file_size || s->offset > file_size - s->size) {
+            result = false;
+        }
+        if (s->type == KSM_SECTION_TYPE_GEOMETRIES && !geometries) {
+            geometries = s;
+        } else if (s->type == KSM_SECTION_TYPE_STRINGS && !strings) {
+            strings = s;
+        } else if (s->type == KSM_SECTION_TYPE_LODS && !lods) {
+            lods = s;
+        } else if (s->type == KSM_SECTION_TYPE_MESHLETS && !meshlets) {
+            meshlets = s;
+        }
+    }
+    if (!result || !geometries || !strings || geometries->size < (u64)geometry_count * KSM_GEOMETRY_SIZE) {
+        KERROR("load_ksm_file - invalid section table.");
+        kfree(sections, sizeof(ksm_section) * (section_count ? section_count : 1), MEMORY_TAG_ARRAY);
+        return false;
+    }
+
+    const char* string_data = (const char*)ksm_file->data + strings->offset;
+    kbinary_reader geometry_reader;
+    kbinary_reader_from_memory((const u8*)ksm_file->data + geometries->offset, geometries->size, &geometry_reader);
+    for (u32 i = 0; i < geometry_count && result; ++i) {
+        geometry_config g = {};
+        u32 vertex_section = 0;
+        u32 index_section = 0;
+        u32 geometry_name_offset = 0;
+        u32 material_name_offset = 0;
+        kbinary_read_u32(&geometry_reader, &g.vertex_size);
+        kbinary_read_u32(&geometry_reader, &g.vertex_count);
+        kbinary_read_u32(&geometry_reader, &g.index_size);
+        kbinary_read_u32(&geometry_reader, &g.index_count);
+        kbinary_read_u32(&geometry_reader, &vertex_section);
+        kbinary_read_u32(&geometry_reader, &index_section);
+        kbinary_read_u32(&geometry_reader, &geometry_name_offset);
+        kbinary_read_u32(&geometry_reader, &material_name_offset);
+        kbinary_read(&geometry_reader, sizeof(vec3), &g.center);
+        kbinary_read(&geometry_reader, sizeof(vec3), &g.min_extents);
+        kbinary_read(&geometry_reader, sizeof(vec3), &g.max_extents);
+        kbinary_read(&geometry_reader, sizeof(u32), 0);
+
+        // the renderer only knows these two vertex layouts and 32 bit indices, so anything else is corrupt rather than
+        // something to pass along
+        result = !geometry_reader.failed &&
+                 (g.vertex_size == sizeof(vertex_3d) || g.vertex_size == sizeof(vertex_3d_packed)) &&
+                 g.index_size == sizeof(u32) &&
+                 ksm_read_string_at(string_data, strings->size, geometry_name_offset, GEOMETRY_NAME_MAX_LENGTH, g.name) &&
+                 ksm_read_string_at(string_data, strings->size, material_name_offset, MATERIAL_NAME_MAX_LENGTH, g.material_name) &&
+                 ksm_read_blob(ksm_file, sections, section_count, vertex_section, KSM_SECTION_TYPE_VERTICES, g.vertex_size, g.vertex_count, &g.vertices, out_borrowed) &&
+                 ksm_read_blob(ksm_file, sections, section_count, index_section, KSM_SECTION_TYPE_INDICES, g.index_size, g.index_count, &g.indices, out_borrowed);
+        // pushed either way, so a half loaded geometry is cleaned up along with the rest
+        darray_push(*out_geometries_darray, g);
+        if (!result) {
+            KERROR("load_ksm_file - geometry %u is truncated or corrupt.", i);
+        }
+    }
+
+    // levels of detail, each appended to its geometry in turn
+    if (result && lods) {
+        kbinary_reader lod_reader;
+        kbinary_reader_from_memory((const u8*)ksm_file->data + lods->offset, lods->size, &lod_reader);
+        u32 lod_count = (u32)(lods->size / KSM_LOD_SIZE);
+        for (u32 i = 0; i < lod_count && result; ++i) {
+            u32 geometry_index = 0;
+            geometry_lod lod = {};
+            kbinary_read_u32(&lod_reader, &geometry_index);
+            kbinary_read_u32(&lod_reader, &lod.index_offset);
+            kbinary_read_u32(&lod_reader, &lod.index_count);
+            kbinary_read_f32(&lod_reader, &lod.error);
+            geometry_config* g = geometry_index < geometry_count ? &(*out_geometries_darray)[geometry_index] : 0;
+            result = !lod_reader.failed && g && g->lod_count < GEOMETRY_MAX_LOD_COUNT && lod.index_offset <= g->index_count &&
+                     lod.index_count <= g->index_count - lod.index_offset;
+            if (result) {
+                g->lods[g->lod_count++] = lod;
+            } else {
+                KERROR("load_ksm_file - level of detail %u is invalid.", i);
+            }
+        }
+    }
 
-        // name
-        u32 g_name_length = string_length(g->name) + 1;
-        filesystem_write(&f, sizeof(u32), &g_name_length, &written);
-        filesystem_write(&f, sizeof(char) * g_name_length, g->name, &written);
+    if (result && meshlets) {
+        result = ksm_read_meshlets(ksm_file, meshlets, *out_geometries_darray, geometry_count);
+    }
+    kfree(sections, sizeof(ksm_section) * (section_count ? section_count : 1), MEMORY_TAG_ARRAY);
 
-        // material name
-        u32 m_name_length = string_length(g->material_name) + 1;
-        filesystem_write(&f, sizeof(u32), &m_name_length, &written);
-        filesystem_write(&f, sizeof(char) * m_name_length, g->material_name, &written);
+    if (!result) {
+        ksm_dispose_configs(ksm_file, *out_geometries_darray);
+        *out_borrowed = false;
+    }
+    return result;
+}
 
-        // center
-        filesystem_write(&f, sizeof(vertex_3d), &g->center, &written);
+b8 load_ksm_file(const vfs_file* ksm_file, geometry_config** out_geometries_darray, b8* out_borrowed) {
+    KPROFILE_SCOPE("load_ksm_file");
+    *out_borrowed = false;
+    kbinary_reader reader;
+    kbinary_reader_from_memory(ksm_file->data, ksm_file->size, &reader);
 
-        // extents (min/max)
-        filesystem_write(&f, sizeof(vertex_3d), &g->min_extents, &written);
-        filesystem_write(&f, sizeof(vertex_3d), &g->max_extents, &written);
+    // version
+    u16 version = 0;
+    if (!kbinary_read_u16(&reader, &version)) {
+        KERROR("load_ksm_file - file is too small to be a ksm file.");
+        return false;
     }
 
-    filesystem_close(&f);
+    switch (version) {
+        case KSM_VERSION_1:
+            return load_ksm_v1(&reader, out_geometries_darray);
+        case KSM_VERSION_2:
+            return load_ksm_v2(ksm_file, &reader, out_geometries_darray, out_borrowed);
+        default:
+            KERROR("load_ksm_file - unsupported version %u.", version);
+            return false;
+    }
+}
 
+// copies out any arrays that point straight into the file, so the configs can outlive it
+static void ksm_copy_borrowed(const vfs_file* file, geometry_config* configs) {
+    const u8* file_start = file->data;
+    const u8* file_end = file_start + file->size;
+    u32 count = darray_length(configs);
+    for (u32 i = 0; i < count; ++i) {
+        geometry_config* config = &configs[i];
+        if ((const u8*)config->vertices >= file_start && (const u8*)config->vertices < file_end) {
+            void* vertices = kallocate((u64)config->vertex_size * config->vertex_count, MEMORY_TAG_ARRAY);
+            kcopy_memory(vertices, config->vertices, (u64)config->vertex_size * config->vertex_count);
+            config->vertices = vertices;
+        }
+        if ((const u8*)config->indices >= file_start && (const u8*)config->indices < file_end) {
+            void* indices = kallocate((u64)config->index_size * config->index_count, MEMORY_TAG_ARRAY);
+            kcopy_memory(indices, config->indices, (u64)config->index_size * config->index_count);
+            config->indices = indices;
+        }
+    }
+}
+
+b8 mesh_loader_read_ksm(const void* data, u64 size, geometry_config** out_geometries_darray) {
+    vfs_file file = {};
+    file.data = data;
+    file.size = size;
+    b8 borrowed = false;
+    if (!load_ksm_file(&file, out_geometries_darray, &borrowed)) {
+        return false;
+    }
+    if (borrowed) {
+        ksm_copy_borrowed(&file, *out_geometries_darray);
+    }
     return true;
 }
 
-b8 import_obj_file(file_handle* obj_file, const char* out_ksm_filename, geometry_config** out_geometries_darray) {
-    // positions
-    vec3* positions = darray_reserve(vec3, 16384);
+// what is written for each geometry's vertices or indices
+typedef struct ksm_blob {
+    const void* data;
+    ksm_section section;
+    // set if packed, and freed once written
+    u8* packed;
+    u64 packed_capacity;
+} ksm_blob;
+
+static void ksm_blob_create(const void* data, u32 stride, u32 count, ksm_section_type type, b8 pack, ksm_blob* out_blob) {
+    out_blob->data = data;
+    out_blob->section.type = type;
+    out_blob->section.encoding = KSM_ENCODING_NONE;
+    out_blob->section.size = (u64)stride * count;
+    out_blob->section.decoded_size = out_blob->section.size;
+    out_blob->packed = pack ? ksm_pack_stream(data, stride, count, &out_blob->packed_capacity, &out_blob->section.size) : 0;
+    if (out_blob->packed) {
+        out_blob->data = out_blob->packed;
+        out_blob->section.encoding = KSM_ENCODING_PACKED;
+    } else {
+        out_blob->section.size = out_blob->section.decoded_size;
+    }
+}
 
-    // normals
-    vec3* normals = darray_reserve(vec3, 16384);
+static void ksm_write_section(kbinary_writer* writer, const ksm_section* section) {
+    kbinary_write_u32(writer, section->type);
+    kbinary_write_u32(writer, section->encoding);
+    kbinary_write_u64(writer, section->offset);
+    kbinary_write_u64(writer, section->size);
+    kbinary_write_u64(writer, section->decoded_size);
+}
 
-    // normals
-    vec2* tex_coords = darray_reserve(vec2, 16384);
+b8 mesh_loader_write_ksm(kbinary_writer* writer, const char* name, u32 geometry_count, geometry_config* geometries, b8 pack_streams) {
+    // packed up front, as the layout depends on how big everything comes out
+    u32 blob_count = geometry_count * 2;
+    ksm_blob* blobs = kallocate(sizeof(ksm_blob) * (blob_count ? blob_count : 1), MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < geometry_count; ++i) {
+        geometry_config* g = &geometries[i];
+        ksm_blob_create(g->vertices, g->vertex_size, g->vertex_count, KSM_SECTION_TYPE_VERTICES, pack_streams, &blobs[i * 2]);
+        ksm_blob_create(g->indices, g->index_size, g->index_count, KSM_SECTION_TYPE_INDICES, pack_streams, &blobs[i * 2 + 1]);
+    }
 
-    // groups
-    mesh_group_data* groups = darray_reserve(mesh_group_data, 4);
+    u32 lod_entry_count = 0;
+    u32 meshlet_entry_count = 0;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        lod_entry_count += geometries[i].lod_count > 1 ? geometries[i].lod_count : 0;
+        meshlet_entry_count += geometries[i].meshlet_count;
+    }
 
-    char material_file_name[512] = "";
-    // b8 hit_name = false;
+    // the layout. the geometries and strings sections come first in the table, then a blob section for each blob, then
+    // the levels of detail and meshlets if there are any
+    u32 section_count = 2 + blob_count + (lod_entry_count ? 1 : 0) + (meshlet_entry_count ? 1 : 0);
+    ksm_section geometry_section = {KSM_SECTION_TYPE_GEOMETRIES, KSM_ENCODING_NONE, 0, 0, 0};
+    geometry_section.offset = KSM_HEADER_SIZE + (u64)section_count * KSM_SECTION_SIZE;
+    geometry_section.size = (u64)geometry_count * KSM_GEOMETRY_SIZE;
+    geometry_section.decoded_size = geometry_section.size;
+    ksm_section string_section = {KSM_SECTION_TYPE_STRINGS, KSM_ENCODING_NONE, 0, 0, 0};
+    string_section.offset = geometry_section.offset + geometry_section.size;
+    string_section.size = string_length(name) + 1;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        string_section.size += string_length(geometries[i].name) + 1 + string_length(geometries[i].material_name) + 1;
+    }
+    string_section.decoded_size = string_section.size;
+    u64 offset = string_section.offset + string_section.size;
+    for (u32 i = 0; i < blob_count; ++i) {
+        offset = (offset + KSM_ALIGNMENT - 1) & ~((u64)KSM_ALIGNMENT - 1);
+        blobs[i].section.offset = offset;
+        offset += blobs[i].section.size;
+    }
+    ksm_section lod_section = {KSM_SECTION_TYPE_LODS, KSM_ENCODING_NONE, 0, 0, 0};
+    lod_section.offset = (offset + KSM_ALIGNMENT - 1) & ~((u64)KSM_ALIGNMENT - 1);
+    lod_section.size = (u64)lod_entry_count * KSM_LOD_SIZE;
+    lod_section.decoded_size = lod_section.size;
+    if (lod_entry_count) {
+        offset = lod_section.offset + lod_section.size;
+    }
+    ksm_section meshlet_section = {KSM_SECTION_TYPE_MESHLETS, KSM_ENCODING_NONE, 0, 0, 0};
+    meshlet_section.offset = (offset + KSM_ALIGNMENT - 1) & ~((u64)KSM_ALIGNMENT - 1);
+    meshlet_section.size = (u64)meshlet_entry_count * KSM_MESHLET_SIZE;
+    meshlet_section.decoded_size = meshlet_section.size;
+    if (meshlet_entry_count) {
+        offset = meshlet_section.offset + meshlet_section.size;
+    }
+    u64 file_size = offset;
+
+    // everything after the header goes to memory first, so the header can carry its checksum
+    kbinary_writer body;
+    kbinary_writer_to_memory(file_size, &body);
+    kbinary_write_pad_to(&body, KSM_HEADER_SIZE);
+    ksm_write_section(&body, &geometry_section);
+    ksm_write_section(&body, &string_section);
+    for (u32 i = 0; i < blob_count; ++i) {
+        ksm_write_section(&body, &blobs[i].section);
+    }
+    if (lod_entry_count) {
+        ksm_write_section(&body, &lod_section);
+    }
+    if (meshlet_entry_count) {
+        ksm_write_section(&body, &meshlet_section);
+    }
 
-    char name[512];
-    u8 current_mat_name_count = 0;
-    char material_names[32][64];
+    u32 string_offset = (u32)string_length(name) + 1;
+    for (u32 i = 0; i < geometry_count; ++i) {
+        geometry_config* g = &geometries[i];
+        u32 name_offset = string_offset;
+        u32 material_name_offset = name_offset + (u32)string_length(g->name) + 1;
+        string_offset = material_name_offset + (u32)string_length(g->material_name) + 1;
+
+        kbinary_write_u32(&body, g->vertex_size);
+        kbinary_write_u32(&body, g->vertex_count);
+        kbinary_write_u32(&body, g->index_size);
+        kbinary_write_u32(&body, g->index_count);
+        kbinary_write_u32(&body, 2 + i * 2);
+        kbinary_write_u32(&body, 2 + i * 2 + 1);
+        kbinary_write_u32(&body, name_offset);
+        kbinary_write_u32(&body, material_name_offset);
+        kbinary_write(&body, sizeof(vec3), &g->center);
+        kbinary_write(&body, sizeof(vec3), &g->min_extents);
+        kbinary_write(&body, sizeof(vec3), &g->max_extents);
+        kbinary_write_u32(&body, 0);
+    }
 
-    char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u64 line_length = 0;
+    kbinary_write(&body, string_length(name) + 1, name);
+    for (u32 i = 0; i < geometry_count; ++i) {
+        kbinary_write(&body, string_length(geometries[i].name) + 1, geometries[i].name);
+        kbinary_write(&body, string_length(geometries[i].material_name) + 1, geometries[i].material_name);
+    }
 
-    // index 0 is previous before that
-    char prev_first_chars[2] = {0, 0};
-    while (true) {
-        if (!filesystem_read_line(obj_file, 511, &p, &line_length)) {
-            break;
+    for (u32 i = 0; i < blob_count; ++i) {
+        kbinary_write_pad_to(&body, blobs[i].section.offset);
+        kbinary_write(&body, blobs[i].section.size, blobs[i].data);
+        if (blobs[i].packed) {
+            kfree(blobs[i].packed, blobs[i].packed_capacity, MEMORY_TAG_ARRAY);
         }
+    }
+    kfree(blobs, sizeof(ksm_blob) * (blob_count ? blob_count : 1), MEMORY_TAG_ARRAY);
+
+    if (lod_entry_count) {
+        kbinary_write_pad_to(&body, lod_section.offset);
+        for (u32 i = 0; i < geometry_count; ++i) {
+            for (u32 l = 0; geometries[i].lod_count > 1 && l < geometries[i].lod_count; ++l) {
+                const geometry_lod* lod = &geometries[i].lods[l];
+                kbinary_write_u32(&body, i);
+                kbinary_write_u32(&body, lod->index_offset);
+                kbinary_write_u32(&body, lod->index_count);
+                kbinary_write_f32(&body, lod->error);
+            }
+        }
+    }
 
-        // skip blank lines
-        if (line_length < 1) {
-            continue;
+    if (meshlet_entry_count) {
+        kbinary_write_pad_to(&body, meshlet_section.offset);
+        for (u32 i = 0; i < geometry_count; ++i) {
+            const geometry_config* g = &geometries[i];
+            u32 lod_count = g->lod_count ? g->lod_count : 1;
+            for (u32 l = 0; g->meshlet_count && l < lod_count; ++l) {
+                for (u32 m = g->lods[l].meshlet_offset; m < g->lods[l].meshlet_offset + g->lods[l].meshlet_count; ++m) {
+                    const geometry_meshlet* meshlet = &g->meshlets[m];
+                    kbinary_write_u32(&body, i);
+                    kbinary_write_u32(&body, l);
+                    kbinary_write_u32(&body, meshlet->index_offset);
+                    kbinary_write_u32(&body, meshlet->index_count);
+                    kbinary_write(&body, sizeof(vec3), &meshlet->center);
+                    kbinary_write_f32(&body, meshlet->radius);
+                    kbinary_write(&body, sizeof(vec3), &meshlet->cone_axis);
+                    kbinary_write_f32(&body, meshlet->cone_cutoff);
+                }
+            }
         }
+    }
 
-        char first_char = line_buf[0];
+    u64 body_size = 0;
+    const u8* body_data = kbinary_writer_data(&body, &body_size);
+    b8 result = !body.failed && body_size == file_size;
+    if (result) {
+        kbinary_write_u16(writer, KSM_VERSION_2);
+        kbinary_write_u16(writer, KSM_HEADER_SIZE);
+        kbinary_write_u32(writer, KSM_MAGIC);
+        kbinary_write_u32(writer, section_count);
+        kbinary_write_u32(writer, geometry_count);
+        // the mesh name, first in the strings, then a reserved u32
+        kbinary_write_u32(writer, 0);
+        kbinary_write_u32(writer, 0);
+        kbinary_write_u64(writer, file_size);
+        kbinary_write_u64(writer, xxhash64(body_data + KSM_HEADER_SIZE, file_size - KSM_HEADER_SIZE, 0));
+        // reserved
+        kbinary_write_u64(writer, 0);
+        kbinary_write(writer, file_size - KSM_HEADER_SIZE, body_data + KSM_HEADER_SIZE);
+        // errors stick, so this covers every write above
+        result = !writer->failed;
+    }
+    kbinary_writer_close(&body);
+    return result;
+}
 
-        switch (first_char) {
-            case '#':
-                // skip comments
-                continue;
-            case 'v': {
-                char second_char = line_buf[1];
-                switch (second_char) {
-                    case ' ': {
-                        // vertex position
-                        vec3 pos;
-                        char t[2];
-                        sscanf(
-                            line_buf,
-                            "%s %f %f %f",
-                            t,
-                            &pos.x,
-                            &pos.y,
-                            &pos.z);
+b8 write_ksm_file(const char* path, const char* name, u32 geometry_count, geometry_config* geometries, b8 pack_streams) {
+    if (filesystem_exists(path)) {
+        KINFO("File '%s' already exists and will be overwritten.", path);
+    }
 
-                        darray_push(positions, pos);
-                    } break;
-                    case 'n': {
-                        // vertex normal
-                        vec3 norm;
-                        char t[2];
-                        sscanf(
-                            line_buf,
-                            "%s %f %f %f",
-                            t,
-                            &norm.x,
-                            &norm.y,
-                            &norm.z);
+    // written to the side and moved over the old file, which may still be mapped by a mesh loaded from it
+    char temp_path[VFS_MAX_PATH_LENGTH + 8];
+    string_format(temp_path, "%s.tmp", path);
+    kbinary_writer writer;
+    if (!kbinary_writer_open(temp_path, 0, &writer)) {
+        KERROR("Unable to open file '%s' for writing. KSM write failed.", temp_path);
+        return false;
+    }
+    b8 result = mesh_loader_write_ksm(&writer, name, geometry_count, geometries, pack_streams);
+    result = kbinary_writer_close(&writer) && result && filesystem_rename(temp_path, path);
+    if (!result) {
+        KERROR("Failed writing '%s'. KSM write failed.", path);
+        return false;
+    }
+    vfs_track_file(path);
 
-                        darray_push(normals, norm);
-                    } break;
-                    case 't': {
-                        // vertex texture coords
-                        vec2 tex_coord;
-                        char t[2];
+    return true;
+}
 
-                        // NOTE: ignoring z if present
-                        sscanf(
-                            line_buf,
-                            "%s %f %f",
-                            t,
-                            &tex_coord.x,
-                            &tex_coord.y);
+// NOTE: end ksm
+
+// NOTE: begin parallel import
+
+// the file is split into chunks at line boundaries, and each chunk is scanned by its own job. vertex attributes are
+// counted first so each chunk knows where its own go in the arrays for the whole file, then every chunk is parsed at
+// once. the groups the chunks found are stitched back together in file order, and each resulting geometry is expanded,
+// welded and given tangents by a job of its own
+
+// chunks are never made smaller than this when splitting a file up by itself, it would cost more than it saves
+#define OBJ_IMPORT_MIN_CHUNK_SIZE KIBIBYTES(256)
+// the most chunks a file is split into
+#define OBJ_IMPORT_MAX_CHUNK_COUNT 64
+// the longest mtllib file name kept
+#define OBJ_MATERIAL_FILE_NAME_MAX_LENGTH 512
+
+typedef enum obj_segment_type {
+    // faces carrying on in whatever group came before, possibly in an earlier chunk
+    OBJ_SEGMENT_TYPE_CONTINUE,
+    // a usemtl, starting a new group
+    OBJ_SEGMENT_TYPE_USEMTL,
+    // a g, starting a new object
+    OBJ_SEGMENT_TYPE_GROUP
+} obj_segment_type;
+
+// a run of faces within a chunk, along with the line that started it
+typedef struct obj_segment {
+    obj_segment_type type;
+    // the material name for usemtl, or the object name for g
+    char name[GEOMETRY_NAME_MAX_LENGTH];
+    // darray
+    mesh_face_data* faces;
+} obj_segment;
+
+typedef struct obj_chunk {
+    const char* start;
+    const char* end;
+    // how many of each attribute are in the chunk, from the counting pass
+    u64 position_count;
+    u64 normal_count;
+    u64 tex_coord_count;
+    // how many of each come before the chunk, which is where its own go in the arrays for the whole file
+    u64 position_base;
+    u64 normal_base;
+    u64 tex_coord_base;
+    // the arrays for the whole file, shared by every chunk
+    vec3* positions;
+    vec3* normals;
+    vec2* tex_coords;
+    // darray, in the order found
+    obj_segment* segments;
+    // the last mtllib in the chunk, if any
+    char material_file_name[OBJ_MATERIAL_FILE_NAME_MAX_LENGTH];
+    u64 skipped_face_count;
+} obj_chunk;
+
+// a geometry to be built from a group's faces
+typedef struct obj_geometry_job {
+    vec3* positions;
+    vec3* normals;
+    vec2* tex_coords;
+    // darray, destroyed by the job
+    mesh_face_data* faces;
+    // whether to optimize, and how many levels of detail to generate
+    const mesh_resource_params* params;
+    geometry_config config;
+} obj_geometry_job;
+
+// finds the next line that isn't blank or a comment, along with the length of its keyword (up to the first space).
+// returns false once there are no more lines
+static b8 obj_next_line(const char** text, const char* text_end, const char** out_line, const char** out_line_end, u64* out_keyword_length) {
+    while (*text < text_end) {
+        const char* line = obj_skip_spaces(*text, text_end);
+        const char* line_end = line;
+        while (line_end < text_end && *line_end != '\n') {
+            line_end++;
+        }
+        *text = line_end + 1;
 
-                        darray_push(tex_coords, tex_coord);
-                    } break;
-                }
-            } break;
-            // case 'g':
-            case 's': {
-            } break;
-            case 'f': {
-                // face
-                // f 1/1/1 2/2/2 3/3/3 = pos/tex/norm pos/tex/norm pos/tex/norm
-                mesh_face_data face;
-                char t[2];
-
-                u64 normal_count = darray_length(normals);
-                u64 tex_coord_count = darray_length(tex_coords);
-
-                if (normal_count == 0 || tex_coord_count == 0) {
-                    sscanf(
-                        line_buf,
-                        "%s %d %d %d",
-                        t,
-                        &face.vertices[0].position_index,
-                        &face.vertices[1].position_index,
-                        &face.vertices[2].position_index);
-                } else {
-                    sscanf(
-                        line_buf,
-                        "%s %d/%d/%d %d/%d/%d %d/%d/%d",
-                        t,
-                        &face.vertices[0].position_index,
-                        &face.vertices[0].texcoord_index,
-                        &face.vertices[0].normal_index,
-
-                        &face.vertices[1].position_index,
-                        &face.vertices[1].texcoord_index,
-                        &face.vertices[1].normal_index,
-
-                        &face.vertices[2].position_index,
-                        &face.vertices[2].texcoord_index,
-                        &face.vertices[2].normal_index);
-                }
-                u64 group_index = darray_length(groups) - 1;
-                darray_push(groups[group_index].faces, face);
-            } break;
-            case 'm': {
-                // material library file
-                char substr[7];
+        // skip blank lines and comments
+        if (line == line_end || *line == '#') {
+            continue;
+        }
 
-                sscanf(
-                    line_buf,
-                    "%s %s",
-                    substr,
-                    material_file_name);
+        const char* keyword_end = line;
+        while (keyword_end < line_end && *keyword_end != ' ' && *keyword_end != '\t' && *keyword_end != '\r') {
+            keyword_end++;
+        }
+        *out_line = line;
+        *out_line_end = line_end;
+        *out_keyword_length = (u64)(keyword_end - line);
+        return true;
+    }
+    return false;
+}
 
-                // if found, save off the material file name
-                if (strings_nequali(substr, "mtllib", 6)) {
-                    // TODO: verification
-                }
-            } break;
-            case 'u': {
-                // any time there is a usemtl, assume a new group.
-                // new named group or smoothing group, all faces coming after should be added to it
-                mesh_group_data new_group;
-                new_group.faces = darray_reserve(mesh_face_data, 16384);
-                darray_push(groups, new_group);
+static void obj_count_chunk_job_entry(void* params) {
+    obj_chunk* chunk = params;
+    const char* text = chunk->start;
+    const char* line;
+    const char* line_end;
+    u64 keyword_length;
+    while (obj_next_line(&text, chunk->end, &line, &line_end, &keyword_length)) {
+        if (line[0] != 'v') {
+            continue;
+        }
+        if (keyword_length == 1) {
+            chunk->position_count++;
+        } else if (keyword_length == 2 && line[1] == 'n') {
+            chunk->normal_count++;
+        } else if (keyword_length == 2 && line[1] == 't') {
+            chunk->tex_coord_count++;
+        }
+    }
+}
 
-                // usemtl
-                // read the material name
-                char t[8];
-                sscanf(line_buf, "%s %s", t, material_names[current_mat_name_count]);
-                current_mat_name_count++;
-            } break;
-            case 'g': {
-                u64 group_count = darray_length(groups);
-
-                // process each group as a subobject.
-                for (u64 i = 0; i < group_count; ++i) {
-                    geometry_config new_data = {};
-                    string_ncopy(new_data.name, name, 255);
-                    if (i > 0) {
-                        string_append_int(new_data.name, new_data.name, i);
-                    }
-                    string_ncopy(new_data.material_name, material_names[i], 255);
+static obj_segment* obj_push_segment(obj_chunk* chunk, obj_segment_type type) {
+    obj_segment segment = {};
+    segment.type = type;
+    segment.faces = darray_create(mesh_face_data);
+    darray_push(chunk->segments, segment);
+    return &chunk->segments[darray_length(chunk->segments) - 1];
+}
 
-                    process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-                    new_data.vertex_count = darray_length(new_data.vertices);
-                    new_data.vertex_size = sizeof(vertex_3d);
-                    new_data.index_count = darray_length(new_data.indices);
-                    new_data.index_size = sizeof(u32);
+static void obj_parse_chunk_job_entry(void* params) {
+    obj_chunk* chunk = params;
+    chunk->segments = darray_create(obj_segment);
+    // the first faces of a chunk carry on in whatever group the chunk before it ended in
+    obj_segment* segment = obj_push_segment(chunk, OBJ_SEGMENT_TYPE_CONTINUE);
+
+    // faces can only refer to attributes that come before them, including those from earlier chunks
+    u64 position_count = chunk->position_base;
+    u64 normal_count = chunk->normal_base;
+    u64 tex_coord_count = chunk->tex_coord_base;
+
+    const char* text = chunk->start;
+    const char* line;
+    const char* line_end;
+    u64 keyword_length;
+    while (obj_next_line(&text, chunk->end, &line, &line_end, &keyword_length)) {
+        const char* at = line + keyword_length;
+
+        if (keyword_length == 1 && line[0] == 'v') {
+            // vertex position
+            vec3 pos = vec3_zero();
+            obj_parse_float(&at, line_end, &pos.x);
+            obj_parse_float(&at, line_end, &pos.y);
+            obj_parse_float(&at, line_end, &pos.z);
+            chunk->positions[position_count++] = pos;
+        } else if (keyword_length == 2 && line[0] == 'v' && line[1] == 'n') {
+            // vertex normal
+            vec3 norm = vec3_zero();
+            obj_parse_float(&at, line_end, &norm.x);
+            obj_parse_float(&at, line_end, &norm.y);
+            obj_parse_float(&at, line_end, &norm.z);
+            chunk->normals[normal_count++] = norm;
+        } else if (keyword_length == 2 && line[0] == 'v' && line[1] == 't') {
+            // vertex texture coords. NOTE: ignoring w if present
+            vec2 tex_coord = vec2_zero();
+            obj_parse_float(&at, line_end, &tex_coord.x);
+            obj_parse_float(&at, line_end, &tex_coord.y);
+            chunk->tex_coords[tex_coord_count++] = tex_coord;
+        } else if (keyword_length == 1 && line[0] == 'f') {
+            // face, of any number of corners, each of p, p/t, p//n or p/t/n
+            if (!obj_parse_face(at, line_end, position_count, tex_coord_count, normal_count, &segment->faces)) {
+                chunk->skipped_face_count++;
+            }
+        } else if (keyword_length == 6 && strings_nequal(line, "mtllib", 6)) {
+            // material library file
+            obj_read_word(at, line_end, chunk->material_file_name, sizeof(chunk->material_file_name));
+        } else if (keyword_length == 6 && strings_nequal(line, "usemtl", 6)) {
+            // any time there is a usemtl, assume a new group. all faces coming after should be added to it
+            segment = obj_push_segment(chunk, OBJ_SEGMENT_TYPE_USEMTL);
+            obj_read_word(at, line_end, segment->name, MATERIAL_NAME_MAX_LENGTH);
+        } else if (keyword_length == 1 && line[0] == 'g') {
+            // a new object
+            segment = obj_push_segment(chunk, OBJ_SEGMENT_TYPE_GROUP);
+            obj_read_word(at, line_end, segment->name, GEOMETRY_NAME_MAX_LENGTH);
+        }
+        // anything else (smoothing groups, object names and so on) is ignored
+    }
+}
 
-                    darray_push(*out_geometries_darray, new_data);
+// simplifies a geometry into levels of detail, each aiming for half the triangles of the one before, and appends their
+// indices after the full detail ones. every level is simplified from full detail, so its error is against that. stops
+// early once a level no longer takes off enough triangles to be worth having
+static void obj_generate_lods(geometry_config* g, u32 lod_count, b8 optimize) {
+    lod_count = lod_count < GEOMETRY_MAX_LOD_COUNT ? lod_count : GEOMETRY_MAX_LOD_COUNT;
+    u32 base_count = g->index_count;
+    u32* indices = kallocate(sizeof(u32) * base_count * lod_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(indices, g->indices, sizeof(u32) * base_count);
+    g->lods[0].index_offset = 0;
+    g->lods[0].index_count = base_count;
+    g->lods[0].error = 0.0f;
+    g->lod_count = 1;
+
+    f32 max_error = vec3_distance(g->min_extents, g->max_extents) * MESH_IMPORT_LOD_MAX_ERROR;
+    u32 total = base_count;
+    u32 previous = base_count;
+    for (u32 lod = 1; lod < lod_count; ++lod) {
+        u32 target = (base_count >> lod) / 3 * 3;
+        f32 error = 0.0f;
+        u32 count = geometry_simplify(g->vertex_count, g->vertices, base_count, g->indices, target, max_error, &indices[total], &error);
+        if (count == 0 || count > previous / 4 * 3) {
+            break;
+        }
+        if (optimize) {
+            geometry_optimize_vertex_cache(g->vertex_count, count, &indices[total]);
+        }
+        g->lods[lod].index_offset = total;
+        g->lods[lod].index_count = count;
+        g->lods[lod].error = error;
+        g->lod_count++;
+        total += count;
+        previous = count;
+    }
 
-                    // increment the number of objects
-                    darray_destroy(groups[i].faces);
-                    kzero_memory(material_names[i], 64);
-                }
-                current_mat_name_count = 0;
-                darray_clear(groups);
-                kzero_memory(name, 512);
+    if (g->lod_count > 1) {
+        // an exact fit, as the indices are freed by their count
+        kfree(g->indices, sizeof(u32) * base_count, MEMORY_TAG_ARRAY);
+        g->indices = kallocate(sizeof(u32) * total, MEMORY_TAG_ARRAY);
+        kcopy_memory(g->indices, indices, sizeof(u32) * total);
+        g->index_count = total;
+        KINFO("Generated %u levels of detail for geometry '%s', down to %u triangles.", g->lod_count, g->name, previous / 3);
+    } else {
+        g->lod_count = 0;
+    }
+    kfree(indices, sizeof(u32) * base_count * lod_count, MEMORY_TAG_ARRAY);
+}
 
-                // read the name
-                char t[2];
-                sscanf(line_buf, "%s %s", t, name);
-            } break;
+// splits each level of detail into meshlets, reordering its triangles so each meshlet's are together
+static void obj_build_meshlets(geometry_config* g) {
+    u32 lod_count = g->lod_count ? g->lod_count : 1;
+    if (g->lod_count == 0) {
+        g->lods[0].index_offset = 0;
+        g->lods[0].index_count = g->index_count;
+    }
+    // every level together can't make more meshlets than they have triangles
+    u32 capacity = g->index_count / 3;
+    geometry_meshlet* meshlets = kallocate(sizeof(geometry_meshlet) * (capacity ? capacity : 1), MEMORY_TAG_ARRAY);
+    u32 total = 0;
+    for (u32 l = 0; l < lod_count; ++l) {
+        geometry_lod* lod = &g->lods[l];
+        u32 count = geometry_build_meshlets(g->vertex_count, g->vertices, lod->index_count, &((u32*)g->indices)[lod->index_offset], GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, &meshlets[total]);
+        for (u32 m = total; m < total + count; ++m) {
+            meshlets[m].index_offset += lod->index_offset;
         }
-        prev_first_chars[1] = prev_first_chars[0];
-        prev_first_chars[0] = first_char;
-    }  // each line
+        lod->meshlet_offset = total;
+        lod->meshlet_count = count;
+        total += count;
+    }
+
+    if (total) {
+        g->meshlets = kallocate(sizeof(geometry_meshlet) * total, MEMORY_TAG_ARRAY);
+        kcopy_memory(g->meshlets, meshlets, sizeof(geometry_meshlet) * total);
+        g->meshlet_count = total;
+        KDEBUG("Built %u meshlets for geometry '%s', %u at full detail.", total, g->name, g->lods[0].meshlet_count);
+    }
+    kfree(meshlets, sizeof(geometry_meshlet) * (capacity ? capacity : 1), MEMORY_TAG_ARRAY);
+}
+
+// expands a group's faces into vertices, then welds them and generates tangents, so tangents are also stored in the
+// output file
+static void obj_geometry_job_entry(void* params) {
+    obj_geometry_job* job = params;
+    geometry_config* g = &job->config;
+
+    process_subobject(job->positions, job->normals, job->tex_coords, job->faces, g);
+    darray_destroy(job->faces);
+    job->faces = 0;
+    g->vertex_size = sizeof(vertex_3d);
+    g->index_size = sizeof(u32);
+
+    KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", g->name);
+    u32 new_vert_count = 0;
+    vertex_3d* unique_verts = 0;
+    g->index_count = darray_length(g->indices);
+    geometry_deduplicate_vertices(darray_length(g->vertices), g->vertices, g->index_count, g->indices, &new_vert_count, &unique_verts);
+
+    // replace the old, large array with the de duplicated one
+    darray_destroy(g->vertices);
+    g->vertices = unique_verts;
+    g->vertex_count = new_vert_count;
+
+    // take a copy of the indices as a normal, non-darray
+    u32* indices = kallocate(sizeof(u32) * g->index_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(indices, g->indices, sizeof(u32) * g->index_count);
+    darray_destroy(g->indices);
+    g->indices = indices;
+
+    geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
+
+    if (job->params->optimize) {
+        // triangles for the vertex cache, then clusters of them for overdraw, then the vertices into the order that leaves
+        geometry_cache_stats before;
+        geometry_cache_stats after;
+        geometry_analyze_vertex_cache(g->vertex_count, g->index_count, g->indices, GEOMETRY_FIFO_CACHE_SIZE, &before);
+        geometry_optimize_vertex_cache(g->vertex_count, g->index_count, g->indices);
+        geometry_optimize_overdraw(g->vertex_count, g->vertices, g->index_count, g->indices, MESH_IMPORT_OVERDRAW_THRESHOLD);
+        geometry_optimize_vertex_fetch(g->vertex_count, g->vertices, g->index_count, g->indices);
+        geometry_analyze_vertex_cache(g->vertex_count, g->index_count, g->indices, GEOMETRY_FIFO_CACHE_SIZE, &after);
+        KINFO("Optimized geometry '%s': ACMR %.3f -> %.3f, ATVR %.3f -> %.3f.", g->name, before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    if (job->params->lod_count > 1) {
+        obj_generate_lods(g, job->params->lod_count, job->params->optimize);
+    }
+
+    // after the levels of detail, as each is split up on its own
+    if (job->params->meshlets) {
+        obj_build_meshlets(g);
+    }
 
-    // process the remaining group since the lase one will not have been triggered
-    // by the finding of a new name
-    // process each group as a subobject
+    // last, as everything before works on whole vertices
+    if (!geometry_system_config_pack_vertices(g)) {
+        KWARN("Geometry '%s' has vertex colours, which are dropped as the vertices are packed.", g->name);
+    }
+}
+
+// turns each group gathered so far into a geometry job, named after the object (and numbered after the first), then
+// clears them out for the next object
+static void obj_flush_groups(const char* name, vec3* positions, vec3* normals, vec2* tex_coords, const mesh_resource_params* params, mesh_group_data* groups, obj_geometry_job** geometry_jobs) {
     u64 group_count = darray_length(groups);
     for (u64 i = 0; i < group_count; ++i) {
-        geometry_config new_data = {};
-        string_ncopy(new_data.name, name, 255);
+        obj_geometry_job job = {};
+        job.positions = positions;
+        job.normals = normals;
+        job.tex_coords = tex_coords;
+        job.faces = groups[i].faces;
+        job.params = params;
+        string_ncopy(job.config.name, name, GEOMETRY_NAME_MAX_LENGTH - 1);
         if (i > 0) {
-            string_append_int(new_data.name, new_data.name, i);
+            string_append_int(job.config.name, job.config.name, i);
         }
-        string_ncopy(new_data.material_name, material_names[i], 255);
+        string_ncopy(job.config.material_name, groups[i].material_name, MATERIAL_NAME_MAX_LENGTH - 1);
+        darray_push(*geometry_jobs, job);
+    }
+    darray_clear(groups);
+}
 
-        process_subobject(positions, normals, tex_coords, groups[i].faces, &new_data);
-        new_data.vertex_count = darray_length(new_data.vertices);
-        new_data.vertex_size = sizeof(vertex_3d);
-        new_data.index_count = darray_length(new_data.indices);
-        new_data.index_size = sizeof(u32);
+// runs one job per entry of params, each stride bytes apart, and waits for them all. the waiting thread helps out
+static void obj_run_jobs(pfn_job_entry entry_point, void* params, u64 stride, u32 count) {
+    job_counter counter = {};
+    for (u32 i = 0; i < count; ++i) {
+        job_info info = job_create(entry_point, (u8*)params + stride * i, JOB_PRIORITY_NORMAL);
+        info.counter = &counter;
+        job_system_submit(info);
+    }
+    job_system_wait(&counter);
+}
 
-        darray_push(*out_geometries_darray, new_data);
+// NOTE: end parallel import
+
+// parses the obj text into a geometry per object and material, pushed onto out_geometries_darray, along with the name of
+// the last object and material library. the text is split into chunks of about chunk_size bytes, 0 for one per thread
+// that can work on it, as long as each is big enough to be worth it
+static void obj_import_text(const char* text, u64 size, u64 chunk_size, const mesh_resource_params* params, geometry_config** out_geometries_darray, char* out_name, char* out_material_file_name, u64* out_skipped_face_count) {
+    if (chunk_size == 0) {
+        u64 thread_count = job_system_worker_count() + 1;
+        chunk_size = (size + thread_count - 1) / thread_count;
+        if (chunk_size < OBJ_IMPORT_MIN_CHUNK_SIZE) {
+            chunk_size = OBJ_IMPORT_MIN_CHUNK_SIZE;
+        }
+    }
+    u64 chunk_count = size / chunk_size;
+    if (chunk_count > OBJ_IMPORT_MAX_CHUNK_COUNT) {
+        chunk_count = OBJ_IMPORT_MAX_CHUNK_COUNT;
+    }
+    if (chunk_count == 0) {
+        chunk_count = 1;
+    }
 
-        // increment the number of objects
-        darray_destroy(groups[i].faces);
+    // each chunk ends just after a line break, so no line is split between two
+    obj_chunk* chunks = kallocate(sizeof(obj_chunk) * chunk_count, MEMORY_TAG_ARRAY);
+    const char* text_end = text + size;
+    const char* chunk_start = text;
+    for (u64 i = 0; i < chunk_count; ++i) {
+        const char* chunk_end = text_end;
+        if (i + 1 < chunk_count) {
+            chunk_end = text + (size / chunk_count) * (i + 1);
+            if (chunk_end < chunk_start) {
+                chunk_end = chunk_start;
+            }
+            while (chunk_end < text_end && *chunk_end != '\n') {
+                chunk_end++;
+            }
+            if (chunk_end < text_end) {
+                chunk_end++;
+            }
+        }
+        chunks[i].start = chunk_start;
+        chunks[i].end = chunk_end;
+        chunk_start = chunk_end;
+    }
+
+    // count the attributes in each chunk, then size the arrays for the whole file
+    obj_run_jobs(obj_count_chunk_job_entry, chunks, sizeof(obj_chunk), (u32)chunk_count);
+    u64 position_count = 0;
+    u64 normal_count = 0;
+    u64 tex_coord_count = 0;
+    for (u64 i = 0; i < chunk_count; ++i) {
+        chunks[i].position_base = position_count;
+        chunks[i].normal_base = normal_count;
+        chunks[i].tex_coord_base = tex_coord_count;
+        position_count += chunks[i].position_count;
+        normal_count += chunks[i].normal_count;
+        tex_coord_count += chunks[i].tex_coord_count;
+    }
+    vec3* positions = darray_reserve(vec3, position_count ? position_count : 1);
+    vec3* normals = darray_reserve(vec3, normal_count ? normal_count : 1);
+    vec2* tex_coords = darray_reserve(vec2, tex_coord_count ? tex_coord_count : 1);
+    darray_length_set(positions, position_count);
+    darray_length_set(normals, normal_count);
+    darray_length_set(tex_coords, tex_coord_count);
+    for (u64 i = 0; i < chunk_count; ++i) {
+        chunks[i].positions = positions;
+        chunks[i].normals = normals;
+        chunks[i].tex_coords = tex_coords;
+    }
+    job_system_yield();
+
+    // parse every chunk at once
+    obj_run_jobs(obj_parse_chunk_job_entry, chunks, sizeof(obj_chunk), (u32)chunk_count);
+    job_system_yield();
+
+    // stitch the groups back together in file order
+    mesh_group_data* groups = darray_reserve(mesh_group_data, 4);
+    obj_geometry_job* geometry_jobs = darray_create(obj_geometry_job);
+    *out_skipped_face_count = 0;
+    for (u64 i = 0; i < chunk_count; ++i) {
+        obj_chunk* chunk = &chunks[i];
+        *out_skipped_face_count += chunk->skipped_face_count;
+        if (chunk->material_file_name[0]) {
+            string_ncopy(out_material_file_name, chunk->material_file_name, OBJ_MATERIAL_FILE_NAME_MAX_LENGTH);
+        }
+
+        u64 segment_count = darray_length(chunk->segments);
+        for (u64 s = 0; s < segment_count; ++s) {
+            obj_segment* segment = &chunk->segments[s];
+            if (segment->type == OBJ_SEGMENT_TYPE_USEMTL) {
+                mesh_group_data new_group = {};
+                new_group.faces = segment->faces;
+                string_ncopy(new_group.material_name, segment->name, MATERIAL_NAME_MAX_LENGTH - 1);
+                darray_push(groups, new_group);
+                continue;
+            }
+
+            if (segment->type == OBJ_SEGMENT_TYPE_GROUP) {
+                // a new object. process each group so far as a subobject of the last one, then take the name
+                obj_flush_groups(out_name, positions, normals, tex_coords, params, groups, &geometry_jobs);
+                string_ncopy(out_name, segment->name, GEOMETRY_NAME_MAX_LENGTH - 1);
+            }
+
+            u64 face_count = darray_length(segment->faces);
+            if (face_count == 0) {
+                darray_destroy(segment->faces);
+                continue;
+            }
+            if (darray_length(groups) == 0) {
+                // faces before any usemtl go in a group of their own, with no material
+                mesh_group_data new_group = {};
+                new_group.faces = segment->faces;
+                darray_push(groups, new_group);
+                continue;
+            }
+            mesh_group_data* group = &groups[darray_length(groups) - 1];
+            for (u64 f = 0; f < face_count; ++f) {
+                darray_push(group->faces, segment->faces[f]);
+            }
+            darray_destroy(segment->faces);
+        }
+        darray_destroy(chunk->segments);
     }
+    kfree(chunks, sizeof(obj_chunk) * chunk_count, MEMORY_TAG_ARRAY);
 
+    // process the remaining groups, since the last ones will not have been triggered by the finding of a new name
+    obj_flush_groups(out_name, positions, normals, tex_coords, params, groups, &geometry_jobs);
     darray_destroy(groups);
+
+    // build every geometry at once
+    u32 count = darray_length(geometry_jobs);
+    obj_run_jobs(obj_geometry_job_entry, geometry_jobs, sizeof(obj_geometry_job), count);
+    for (u32 i = 0; i < count; ++i) {
+        darray_push(*out_geometries_darray, geometry_jobs[i].config);
+    }
+    darray_destroy(geometry_jobs);
+
     darray_destroy(positions);
     darray_destroy(normals);
     darray_destroy(tex_coords);
+}
+
+void mesh_loader_import_obj_text(const char* text, u64 size, u64 chunk_size, const mesh_resource_params* params, geometry_config** out_geometries_darray, u64* out_skipped_face_count) {
+    char name[GEOMETRY_NAME_MAX_LENGTH] = "";
+    char material_file_name[OBJ_MATERIAL_FILE_NAME_MAX_LENGTH] = "";
+    obj_import_text(text, size, chunk_size, params, out_geometries_darray, name, material_file_name, out_skipped_face_count);
+}
+
+b8 import_obj_file(struct resource_loader* self, vfs_file* obj_file, const char* obj_path, const char* out_ksm_filename, const mesh_resource_params* params, geometry_config** out_geometries_darray) {
+    KPROFILE_SCOPE("import_obj_file");
+
+    char name[GEOMETRY_NAME_MAX_LENGTH] = "";
+    char material_file_name[OBJ_MATERIAL_FILE_NAME_MAX_LENGTH] = "";
+    u64 skipped_face_count = 0;
+    obj_import_text(obj_file->data, obj_file->size, 0, params, out_geometries_darray, name, material_file_name, &skipped_face_count);
+    if (skipped_face_count) {
+        KWARN("Skipped %llu faces with too few corners or bad indices in '%s'.", skipped_face_count, obj_path);
+    }
 
     if (string_length(material_file_name) > 0) {
-        // load up the material file
-        char full_mtl_path[512];
-        string_directory_from_path(full_mtl_path, out_ksm_filename);
+        // load up the material file, which sits next to the obj
+        char full_mtl_path[512] = "";
+        string_directory_from_path(full_mtl_path, obj_path);
         string_append_string(full_mtl_path, full_mtl_path, material_file_name);
 
         // process material library file
-        if (!import_obj_material_library_file(full_mtl_path)) {
+        if (!import_obj_material_library_file(self, full_mtl_path)) {
             KERROR("Error reading obj mtl file.");
         }
     }
 
-    // de duplicate geometry
-    u32 count = darray_length(*out_geometries_darray);
-    for (u64 i = 0; i < count; ++i) {
-        geometry_config* g = &((*out_geometries_darray)[i]);
-        KDEBUG("Geometry de-duplication process starting on geometry object named '%s'...", g->name);
-
-        u32 new_vert_count = 0;
-        vertex_3d* unique_verts = 0;
-        geometry_deduplicate_vertices(g->vertex_count, g->vertices, g->index_count, g->indices, &new_vert_count, &unique_verts);
-
-        // destroy the old, large array...
-        darray_destroy(g->vertices);
-
-        // and replace with the de duplicated one
-        g->vertices = unique_verts;
-        g->vertex_count = new_vert_count;
-
-        // take a copy of the indices as a normal, non-darray
-        u32* indices = kallocate(sizeof(u32) * g->index_count, MEMORY_TAG_ARRAY);
-        kcopy_memory(indices, g->indices, sizeof(u32) * g->index_count);
-        // destroy the darray
-        darray_destroy(g->indices);
-        // replace with the non-darray version
-        g->indices = indices;
-
-        // also generate tangents here, this way tangents are also stored in the output file
-        geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
-    }
-
     // output a ksm file, which will be loaded in the future
-    return write_ksm_file(out_ksm_filename, name, count, *out_geometries_darray);
+    return write_ksm_file(out_ksm_filename, name, darray_length(*out_geometries_darray), *out_geometries_darray, params->pack_streams);
 }
 
 void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, geometry_config* out_data) {
@@ -537,15 +1686,11 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
     u64 normal_count = darray_length(normals);
     u64 tex_coord_count = darray_length(tex_coords);
 
-    b8 skip_normals = false;
-    b8 skip_tex_coords = false;
     if (normal_count == 0) {
         KWARN("No normals are present in this model.");
-        skip_normals = true;
     }
     if (tex_coord_count == 0) {
         KWARN("No texture coordinates are present in this model.");
-        skip_tex_coords = true;
     }
     for (u64 f = 0; f < face_count; ++f) {
         mesh_face_data face = faces[f];
@@ -555,7 +1700,8 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
             mesh_vertex_index_data index_data = face.vertices[i];
             darray_push(out_data->indices, (u32)(i + (f * 3)));
 
-            vertex_3d vert;
+            // zeroed, as the tangent is only generated after welding, which looks at every attribute
+            vertex_3d vert = {};
 
             vec3 pos = positions[index_data.position_index - 1];
             vert.position = pos;
@@ -584,13 +1730,14 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
 
             extent_set = true;
 
-            if (skip_normals) {
+            // a corner can leave out either (p, p/t, p//n), and the parser gives 0 for those
+            if (index_data.normal_index == 0) {
                 vert.normal = vec3_create(0, 0, 1);
             } else {
                 vert.normal = normals[index_data.normal_index - 1];
             }
 
-            if (skip_tex_coords) {
+            if (index_data.texcoord_index == 0) {
                 vert.texcoord = vec2_zero();
             } else {
                 vert.texcoord = tex_coords[index_data.texcoord_index - 1];
@@ -616,14 +1763,15 @@ void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_fa
 // sure that material names are unique. when the material is acquired, the original existing material name would be used, which would
 // visually be wrong and serve as additional reinforcement of the message for material uniqueness.
 // material configs should not be returned or used here
-b8 import_obj_material_library_file(const char* mtl_file_path) {
+b8 import_obj_material_library_file(struct resource_loader* self, const char* mtl_file_path) {
     KDEBUG("Importing obj .mtl file '%s'...", mtl_file_path);
     // grab the .mtl file, if it exists, and read the material information
-    file_handle mtl_file;
-    if (!filesystem_open(mtl_file_path, FILE_MODE_READ, false, &mtl_file)) {
+    vfs_file mtl_file;
+    if (!vfs_open(mtl_file_path, &mtl_file)) {
         KERROR("Unable to open mtl file: %s", mtl_file_path);
         return false;
     }
+    resource_loader_record_read(self, mtl_file.size);
 
     material_config current_config;
     kzero_memory(&current_config, sizeof(current_config));
@@ -635,7 +1783,7 @@ b8 import_obj_material_library_file(const char* mtl_file_path) {
     char* p = &line_buffer[0];
     u64 line_length = 0;
     while (true) {
-        if (!filesystem_read_line(&mtl_file, 512, &p, &line_length)) {
+        if (!vfs_read_line(&mtl_file, 512, &p, &line_length)) {
             break;
         }
         // trim the line first
@@ -761,8 +1909,9 @@ b8 import_obj_material_library_file(const char* mtl_file_path) {
                     }
                     if (hit_name) {
                         //  Write out a kmt file and move on.
-                        if (!write_kmt_file(mtl_file_path, &current_config)) {
+                        if (!write_kmt_file(&current_config)) {
                             KERROR("Unable to write kmt file.");
+                            vfs_close(&mtl_file);
                             return false;
                         }
 
@@ -785,62 +1934,111 @@ b8 import_obj_material_library_file(const char* mtl_file_path) {
     if (current_config.shininess == 0.0f) {
         current_config.shininess = 8.0f;
     }
-    if (!write_kmt_file(mtl_file_path, &current_config)) {
+    if (!write_kmt_file(&current_config)) {
         KERROR("Unable to write kmt file.");
+        vfs_close(&mtl_file);
         return false;
     }
 
-    filesystem_close(&mtl_file);
+    vfs_close(&mtl_file);
+    return true;
+}
+
+static void kmt_write_text(kbinary_writer* writer, const char* text) {
+    kbinary_write(writer, string_length(text), text);
+}
+
+// a line of key=value
+static void kmt_write_field(kbinary_writer* writer, const char* key, const char* value) {
+    kmt_write_text(writer, key);
+    kmt_write_text(writer, "=");
+    kmt_write_text(writer, value);
+    kmt_write_text(writer, "\n");
+}
+
+// a line of key= and the values, space separated. false if a value would not fit, which no float should manage, but
+// it's checked rather than trusted
+static b8 kmt_write_floats(kbinary_writer* writer, const char* key, u32 count, const f32* values) {
+    kmt_write_text(writer, key);
+    kmt_write_text(writer, "=");
+    for (u32 i = 0; i < count; ++i) {
+        // the largest float is 39 digits before the point, so 47 characters at most
+        char number[64];
+        i32 length = snprintf(number, sizeof(number), i + 1 < count ? "%.6f " : "%.6f", values[i]);
+        if (length < 0 || length >= (i32)sizeof(number)) {
+            return false;
+        }
+        kbinary_write(writer, (u64)length, number);
+    }
+    kmt_write_text(writer, "\n");
     return true;
 }
 
 // @brief write out a kohi material file from config. this gets loaded by name later when the mesh is requested for load
-// @param mtl_file_path the filepath of the material library file which originally contained the material definition
 // @param config a pointer to the config to be converted to kmt
 // @return true on success, otherwise false
-b8 write_kmt_file(const char* mtl_file_path, material_config* config) {
-    // NOTE: the .obj file this came from (and resulting .mtl file) sit in the models directory.
-    // this moves up a level and back into the material folder.
-    // TODO: read from config and get an absolute parh for output
-    char* format_str = "%s../materials/%s%s";
-    file_handle f;
-    char directory[320];
-    string_directory_from_path(directory, mtl_file_path);
-
+b8 write_kmt_file(material_config* config) {
+    // NOTE: the material may have come out of an archive, so it always goes to the materials folder of the asset directory
     char full_file_path[512];
-    string_format(full_file_path, format_str, directory, config->name, ".kmt");
-    if (!filesystem_open(full_file_path, FILE_MODE_WRITE, false, &f)) {
-        KERROR("Error opening material file for writing: '%s'", full_file_path);
-        return false;
-    }
-    KDEBUG("Writing .kmt file '%s'...", full_file_path);
-
-    char line_buffer[512];
-    filesystem_write_line(&f, "#material file");
-    filesystem_write_line(&f, "");
-    filesystem_write_line(&f, "version=0.1");  // TODO: hardcoded version
-    string_format(line_buffer, "name=%s", config->name);
-    filesystem_write_line(&f, line_buffer);
-    string_format(line_buffer, "diffuse_colour=%.6f %.6f %.6f %.6f", config->diffuse_colour.r, config->diffuse_colour.g, config->diffuse_colour.b, config->diffuse_colour.a);
-    filesystem_write_line(&f, line_buffer);
-    string_format(line_buffer, "shininess=%.6f", config->shininess);
-    filesystem_write_line(&f, line_buffer);
+    string_format(full_file_path, "%s/materials/%s%s", resource_system_base_path(), config->name, ".kmt");
+
+    // built up in full first, so it can be compared with what is already there. in memory that grows, as the names
+    // have no limit that would fit them all in a fixed buffer
+    kbinary_writer text_writer;
+    kbinary_writer_to_memory(1024, &text_writer);
+    kmt_write_text(&text_writer, "#material file\n\nversion=0.1\n");  // TODO: hardcoded version
+    kmt_write_field(&text_writer, "name", config->name);
+    b8 formatted = kmt_write_floats(&text_writer, "diffuse_colour", 4, config->diffuse_colour.elements) &&
+                   kmt_write_floats(&text_writer, "shininess", 1, &config->shininess);
     if (config->diffuse_map_name[0]) {
-        string_format(line_buffer, "diffuse_map_name=%s", config->diffuse_map_name);
-        filesystem_write_line(&f, line_buffer);
+        kmt_write_field(&text_writer, "diffuse_map_name", config->diffuse_map_name);
     }
     if (config->specular_map_name[0]) {
-        string_format(line_buffer, "specular_map_name=%s", config->specular_map_name);
-        filesystem_write_line(&f, line_buffer);
+        kmt_write_field(&text_writer, "specular_map_name", config->specular_map_name);
     }
     if (config->normal_map_name[0]) {
-        string_format(line_buffer, "normal_map_name=%s", config->normal_map_name);
-        filesystem_write_line(&f, line_buffer);
+        kmt_write_field(&text_writer, "normal_map_name", config->normal_map_name);
+    }
+    kmt_write_field(&text_writer, "shader", config->shader_name ? config->shader_name : "");
+    u64 text_length = 0;
+    const char* text = kbinary_writer_data(&text_writer, &text_length);
+    if (!formatted || text_writer.failed) {
+        KERROR("Unable to put together material file '%s'.", full_file_path);
+        kbinary_writer_close(&text_writer);
+        return false;
     }
-    string_format(line_buffer, "shader=%s", config->shader_name);
-    filesystem_write_line(&f, line_buffer);
 
+    // re-importing a model usually gives the same materials. leaving them alone saves the write, and doesn't wake up
+    // anything watching the file
+    file_mapping existing;
+    if (filesystem_exists(full_file_path) && filesystem_map(full_file_path, FILE_ACCESS_PATTERN_SEQUENTIAL, &existing)) {
+        b8 unchanged = existing.size == text_length && strings_nequal(existing.data, text, text_length);
+        filesystem_unmap(&existing);
+        if (unchanged) {
+            KDEBUG("Material file '%s' is unchanged, skipping.", full_file_path);
+            kbinary_writer_close(&text_writer);
+            return true;
+        }
+    }
+
+    file_handle f;
+    if (!filesystem_open(full_file_path, FILE_MODE_WRITE, true, &f)) {
+        KERROR("Error opening material file for writing: '%s'", full_file_path);
+        kbinary_writer_close(&text_writer);
+        return false;
+    }
+    KDEBUG("Writing .kmt file '%s'...", full_file_path);
+
+    u64 written = 0;
+    b8 result = filesystem_write(&f, text_length, text, &written) && written == text_length;
     filesystem_close(&f);
+    kbinary_writer_close(&text_writer);
+    if (!result) {
+        KERROR("Failed to write material file '%s'.", full_file_path);
+        return false;
+    }
+    // so it can be found when the material is loaded, which is usually straight after this
+    vfs_track_file(full_file_path);
 
     return true;
 }
@@ -854,6 +2052,7 @@ resource_loader mesh_resource_loader_create() {
     loader.load = mesh_loader_load;
     loader.unload = mesh_loader_unload;
     loader.type_path = "models";
+    loader.params_size = sizeof(mesh_resource_params);
 
     return loader;
 }
\ No newline at end of file
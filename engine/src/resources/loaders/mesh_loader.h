@@ -1,7 +1,63 @@
 #pragma once
 
+#include "core/kbinary.h"
+#include "systems/geometry_system.h"
 #include "systems/resource_system.h"
 
 // @brief creates and returns a mesh resource loader
 // @return the newly created resource loader
-resource_loader mesh_resource_loader_create();
\ No newline at end of file
+resource_loader mesh_resource_loader_create();
+
+// @brief the parameters a mesh is imported with unless told otherwise: optimized, simplified into levels of detail and
+// split into meshlets. the asset cooker, hot reloading and loads without parameters all import this way, so a .ksm
+// comes out the same whichever of them wrote it
+// @param pack_streams whether the vertices and indices are packed. see mesh_resource_params.pack_streams
+// @return the parameters to import with. force_import is false
+KAPI mesh_resource_params mesh_loader_cook_params(b8 pack_streams);
+// @brief imports an obj held in memory, the way the mesh loader imports an obj file, but without loading its material
+// libraries or writing a .ksm. mostly for testing the importer
+// @param text the obj text, which need not be terminated
+// @param size the size of the text in bytes
+// @param chunk_size roughly how many bytes of the text each parsing job takes on. 0 to split it the way a file is
+// @param params how to build the geometries. see mesh_resource_params
+// @param out_geometries_darray a darray the geometries are pushed onto, a geometry per object and material. each is
+// disposed of with geometry_system_config_dispose
+// @param out_skipped_face_count set to the number of faces skipped for too few corners or bad indices
+KAPI void mesh_loader_import_obj_text(const char* text, u64 size, u64 chunk_size, const mesh_resource_params* params, geometry_config** out_geometries_darray, u64* out_skipped_face_count);
+
+// @brief writes a mesh in the .ksm format, as importing does. see mesh_loader_read_ksm
+// @param writer where to write it, such as a writer to memory
+// @param name the name of the mesh
+// @param geometry_count the number of geometries
+// @param geometries the geometries, including any levels of detail and meshlets
+// @param pack_streams true to pack the vertices and indices. see mesh_resource_params.pack_streams
+// @return true on success, otherwise false
+KAPI b8 mesh_loader_write_ksm(kbinary_writer* writer, const char* name, u32 geometry_count, geometry_config* geometries, b8 pack_streams);
+
+// @brief reads the geometries out of a .ksm held in memory, checking it the way loading a .ksm file does. nothing is left
+// pointing into data
+// @param data the contents of the .ksm
+// @param size the size of data in bytes
+// @param out_geometries_darray a darray the geometries are pushed onto. each is disposed of with
+// geometry_system_config_dispose
+// @return true on success, false if the file is truncated or corrupt
+KAPI b8 mesh_loader_read_ksm(const void* data, u64 size, geometry_config** out_geometries_darray);
+
+// @brief writes the import manifest (.ksm.meta) for an obj held in memory, as importing it does. it records the importer
+// version and the hash of the obj and each material library it names, which are found through the vfs
+// @param writer where to write it, such as a writer to memory
+// @param obj_path the path of the obj within the vfs. material libraries are looked for next to it
+// @param obj_data the contents of the obj
+// @param obj_size the size of obj_data in bytes
+// @return true on success, otherwise false
+KAPI b8 mesh_loader_write_import_manifest(kbinary_writer* writer, const char* obj_path, const void* obj_data, u64 obj_size);
+
+// @brief checks an import manifest held in memory against an obj as it is now, the way loading a mesh decides whether its
+// .ksm is stale. see mesh_loader_write_import_manifest
+// @param manifest_data the contents of the manifest
+// @param manifest_size the size of manifest_data in bytes
+// @param obj_path the path of the obj within the vfs
+// @param obj_data the contents of the obj
+// @param obj_size the size of obj_data in bytes
+// @return true if the manifest still matches, false if the mesh should be imported again
+KAPI b8 mesh_loader_import_manifest_matches(const void* manifest_data, u64 manifest_size, const char* obj_path, const void* obj_data, u64 obj_size);
@@ -0,0 +1,168 @@
+#include "obj_parser.h"
+
+#include "core/kmemory.h"
+#include "containers/darray.h"
+
+const char* obj_skip_spaces(const char* at, const char* end) {
+    while (at < end && (*at == ' ' || *at == '\t' || *at == '\r')) {
+        at++;
+    }
+    return at;
+}
+
+const char* obj_read_word(const char* at, const char* end, char* out_word, u64 max_length) {
+    at = obj_skip_spaces(at, end);
+    u64 length = 0;
+    while (at < end && *at != ' ' && *at != '\t' && *at != '\r') {
+        if (length < max_length - 1) {
+            out_word[length++] = *at;
+        }
+        at++;
+    }
+    out_word[length] = 0;
+    return at;
+}
+
+static const f64 obj_powers_of_10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// the digits are gathered into an integer and scaled once, which is exact enough for an f32
+b8 obj_parse_float(const char** at, const char* end, f32* out_value) {
+    const char* c = obj_skip_spaces(*at, end);
+    b8 negative = false;
+    if (c < end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        c++;
+    }
+
+    u64 mantissa = 0;
+    i32 exponent = 0;
+    b8 any_digits = false;
+    for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+        any_digits = true;
+        if (mantissa < 100000000000000000ULL) {
+            mantissa = mantissa * 10 + (u64)(*c - '0');
+        } else {
+            // more digits than an f32 can use, they only shift the value along
+            exponent++;
+        }
+    }
+    if (c < end && *c == '.') {
+        for (c++; c < end && *c >= '0' && *c <= '9'; ++c) {
+            any_digits = true;
+            if (mantissa < 100000000000000000ULL) {
+                mantissa = mantissa * 10 + (u64)(*c - '0');
+                exponent--;
+            }
+        }
+    }
+    if (!any_digits) {
+        return false;
+    }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        const char* e = c + 1;
+        b8 exponent_negative = false;
+        if (e < end && (*e == '-' || *e == '+')) {
+            exponent_negative = *e == '-';
+            e++;
+        }
+        if (e < end && *e >= '0' && *e <= '9') {
+            i32 value = 0;
+            for (; e < end && *e >= '0' && *e <= '9'; ++e) {
+                if (value < 10000) {
+                    value = value * 10 + (*e - '0');
+                }
+            }
+            exponent += exponent_negative ? -value : value;
+            c = e;
+        }
+    }
+
+    f64 result = (f64)mantissa;
+    while (exponent > 22) {
+        result *= 1e22;
+        exponent -= 22;
+    }
+    while (exponent < -22) {
+        result /= 1e22;
+        exponent += 22;
+    }
+    result = exponent < 0 ? result / obj_powers_of_10[-exponent] : result * obj_powers_of_10[exponent];
+    *out_value = (f32)(negative ? -result : result);
+    *at = c;
+    return true;
+}
+
+u32 obj_parse_index(const char** at, const char* end, u64 element_count) {
+    const char* c = *at;
+    b8 negative = false;
+    if (c < end && *c == '-') {
+        negative = true;
+        c++;
+    }
+    i64 value = 0;
+    b8 any_digits = false;
+    for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+        any_digits = true;
+        if (value < 0x100000000LL) {
+            value = value * 10 + (*c - '0');
+        }
+    }
+    *at = c;
+    if (!any_digits || value == 0) {
+        return 0;
+    }
+    if (negative) {
+        value = (i64)element_count + 1 - value;
+    }
+    return (value >= 1 && value <= (i64)element_count) ? (u32)value : 0;
+}
+
+b8 obj_parse_face_vertex(const char** at, const char* end, u64 position_count, u64 tex_coord_count, u64 normal_count, mesh_vertex_index_data* out_vertex) {
+    const char* c = obj_skip_spaces(*at, end);
+    if (c >= end) {
+        return false;
+    }
+    kzero_memory(out_vertex, sizeof(mesh_vertex_index_data));
+    out_vertex->position_index = obj_parse_index(&c, end, position_count);
+    if (c < end && *c == '/') {
+        c++;
+        if (c < end && *c != '/') {
+            out_vertex->texcoord_index = obj_parse_index(&c, end, tex_coord_count);
+        }
+        if (c < end && *c == '/') {
+            c++;
+            out_vertex->normal_index = obj_parse_index(&c, end, normal_count);
+        }
+    }
+    // skip anything left of a malformed corner, so the next one starts clean
+    while (c < end && *c != ' ' && *c != '\t' && *c != '\r') {
+        c++;
+    }
+    *at = c;
+    return true;
+}
+
+b8 obj_parse_face(const char* at, const char* end, u64 position_count, u64 tex_coord_count, u64 normal_count, mesh_face_data** faces_darray) {
+    // pushed as they come, and taken back off if a later corner turns out to be bad
+    u64 first_face = darray_length(*faces_darray);
+    mesh_face_data face;
+    u32 corner_count = 0;
+    mesh_vertex_index_data corner;
+    while (obj_parse_face_vertex(&at, end, position_count, tex_coord_count, normal_count, &corner)) {
+        if (corner.position_index == 0) {
+            darray_length_set(*faces_darray, first_face);
+            return false;
+        }
+        if (corner_count < 3) {
+            face.vertices[corner_count] = corner;
+        } else {
+            face.vertices[1] = face.vertices[2];
+            face.vertices[2] = corner;
+        }
+        corner_count++;
+        if (corner_count >= 3) {
+            darray_push(*faces_darray, face);
+        }
+    }
+    return corner_count >= 3;
+}
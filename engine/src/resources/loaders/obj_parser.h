@@ -0,0 +1,70 @@
+#pragma once
+
+#include "defines.h"
+
+// the obj tokenizer the mesh loader imports with. the obj is parsed straight out of the file's memory, a line at a time,
+// with nothing allocated along the way. a line is any length, and runs up to (not including) the end pointer passed
+// around here
+
+// @brief one corner of a face. each index is 1 based, and 0 where the corner leaves it out or it is out of range
+typedef struct mesh_vertex_index_data {
+    u32 position_index;
+    u32 normal_index;
+    u32 texcoord_index;
+} mesh_vertex_index_data;
+
+// @brief a triangle
+typedef struct mesh_face_data {
+    mesh_vertex_index_data vertices[3];
+} mesh_face_data;
+
+// @brief skips over spaces, tabs and carriage returns
+// @param at where to start
+// @param end the end of the line
+// @return the first character that isn't one, or end
+const char* obj_skip_spaces(const char* at, const char* end);
+
+// @brief copies the next word (up to a space) into out_word, truncated to fit
+// @param at where to start. leading spaces are skipped
+// @param end the end of the line
+// @param out_word a character array to hold the word
+// @param max_length the size of out_word, including the terminator
+// @return just past the end of the word
+const char* obj_read_word(const char* at, const char* end, char* out_word, u64 max_length);
+
+// @brief parses a float in the forms exporters write: an optional sign, digits with an optional fraction, and an
+// optional exponent. leading spaces are skipped
+// @param at where to start. moved past the float on success
+// @param end the end of the line
+// @param out_value set to the value on success
+// @return true if there was a float, otherwise false, leaving at and out_value alone
+KAPI b8 obj_parse_float(const char** at, const char* end, f32* out_value);
+
+// @brief parses an index, which is 1 based, or negative to count back from the last element read so far
+// @param at where the index starts. moved past its digits
+// @param end the end of the line
+// @param element_count how many elements have been read so far, which is how far a negative index counts back from
+// @return the 1 based index, or 0 if it is missing or out of range
+KAPI u32 obj_parse_index(const char** at, const char* end, u64 element_count);
+
+// @brief parses one corner of a face: p, p/t, p//n or p/t/n. leading spaces are skipped, and anything left of a
+// malformed corner is skipped over, so the next one starts clean
+// @param at where to start. moved past the corner
+// @param end the end of the line
+// @param position_count how many positions have been read so far
+// @param tex_coord_count how many texture coordinates have been read so far
+// @param normal_count how many normals have been read so far
+// @param out_vertex set to the indices of the corner, see mesh_vertex_index_data
+// @return true if there was a corner, false once at the end of the line
+KAPI b8 obj_parse_face_vertex(const char** at, const char* end, u64 position_count, u64 tex_coord_count, u64 normal_count, mesh_vertex_index_data* out_vertex);
+
+// @brief parses the corners of a face, of any number of them, fanning anything past a triangle out from the first
+// corner. a face with fewer than three corners, or a corner with a missing or out of range position, is skipped whole
+// @param at just past the f keyword
+// @param end the end of the line
+// @param position_count how many positions have been read so far
+// @param tex_coord_count how many texture coordinates have been read so far
+// @param normal_count how many normals have been read so far
+// @param faces_darray a darray the triangles are pushed onto
+// @return true if the face was added, false if it was skipped
+KAPI b8 obj_parse_face(const char* at, const char* end, u64 position_count, u64 tex_coord_count, u64 normal_count, mesh_face_data** faces_darray);
@@ -9,24 +9,24 @@
 #include "loader_utils.h"
 #include "containers/darray.h"
 
-#include "platform/filesystem.h"
+#include "systems/vfs_system.h"
 
 b8 shader_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
     if (!self || !name || !out_resource) {
         return false;
     }
 
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, ".shadercfg");
+    char file_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, ".shadercfg", file_path);
 
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, false, &f)) {
-        KERROR("shader_loader_load - unable to open shader file for reading: '%s'.", full_file_path);
+    vfs_file f;
+    if (!vfs_open(file_path, &f)) {
+        KERROR("shader_loader_load - unable to open shader file for reading: '%s'.", file_path);
         return false;
     }
+    resource_loader_record_read(self, f.size);
 
-    out_resource->full_path = string_duplicate(full_file_path);
+    out_resource->full_path = string_duplicate(f.path);
 
     shader_config* resource_data = kallocate(sizeof(shader_config), MEMORY_TAG_RESOURCE);
     // set some defaults, create arrays
@@ -49,7 +49,7 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
     char* p = &line_buf[0];
     u64 line_length = 0;
     u32 line_number = 1;
-    while (filesystem_read_line(&f, 511, &p, &line_length)) {
+    while (vfs_read_line(&f, 511, &p, &line_length)) {
         // trim the string
         char* trimmed = string_trim(line_buf);
 
@@ -65,7 +65,7 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
         // split into var/value
         i32 equal_index = string_index_of(trimmed, '=');
         if (equal_index == -1) {
-            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", full_file_path, line_number);
+            KWARN("Potential formatting issue found in file '%s': '=' token not found. Skipping line %ui.", f.path, line_number);
             line_number++;
             continue;
         }
@@ -172,8 +172,17 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
                 } else if (strings_equali(fields[0], "i32")) {
                     attribute.type = SHADER_ATTRIB_TYPE_INT32;
                     attribute.size = 4;
+                } else if (strings_equali(fields[0], "unorm16x4")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_UNORM16_4;
+                    attribute.size = 8;
+                } else if (strings_equali(fields[0], "snorm16x2")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_SNORM16_2;
+                    attribute.size = 4;
+                } else if (strings_equali(fields[0], "f16x2")) {
+                    attribute.type = SHADER_ATTRIB_TYPE_FLOAT16_2;
+                    attribute.size = 4;
                 } else {
-                    KERROR("shader_loader_load: Invalid file layout. Attribute type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, or u32.");
+                    KERROR("shader_loader_load: Invalid file layout. Attribute type must be f32, vec2, vec3, vec4, i8, i16, i32, u8, u16, u32, unorm16x4, snorm16x2 or f16x2.");
                     KWARN("Defaulting to f32.");
                     attribute.type = SHADER_ATTRIB_TYPE_FLOAT32;
                     attribute.size = 4;
@@ -275,7 +284,7 @@ b8 shader_loader_load(struct resource_loader* self, const char* name, void* para
         line_number++;
     }
 
-    filesystem_close(&f);
+    vfs_close(&f);
 
     out_resource->data = resource_data;
     out_resource->data_size = sizeof(shader_config);
@@ -328,6 +337,7 @@ resource_loader shader_resource_loader_create() {
     loader.load = shader_loader_load;
     loader.unload = shader_loader_unload;
     loader.type_path = "shaders";
+    loader.params_size = 0;
 
     return loader;
 }
\ No newline at end of file
@@ -8,43 +8,32 @@
 #include "math/kmath.h"
 #include "loader_utils.h"
 
-#include "platform/filesystem.h"
+#include "systems/vfs_system.h"
 
 b8 text_loader_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
     if (!self || !name || !out_resource) {
         return false;
     }
 
-    char* format_str = "%s/%s/%s%s";
-    char full_file_path[512];
-    string_format(full_file_path, format_str, resource_system_base_path(), self->type_path, name, "");
+    char file_path[VFS_MAX_PATH_LENGTH];
+    resource_path(self, name, "", file_path);
 
-    // TODO: Should be using an allocator here.
-    out_resource->full_path = string_duplicate(full_file_path);
-
-    file_handle f;
-    if (!filesystem_open(full_file_path, FILE_MODE_READ, false, &f)) {
-        KERROR("text_loader_load - unable to open file for text reading: '%s'.", full_file_path);
+    vfs_file f;
+    if (!vfs_open(file_path, &f)) {
+        KERROR("text_loader_load - unable to open file for text reading: '%s'.", file_path);
         return false;
     }
+    resource_loader_record_read(self, f.size);
 
-    u64 file_size = 0;
-    if (!filesystem_size(&f, &file_size)) {
-        KERROR("Unable to text read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
+    // TODO: Should be using an allocator here.
+    out_resource->full_path = string_duplicate(f.path);
 
     // TODO: Should be using an allocator here.
-    char* resource_data = kallocate(sizeof(char) * file_size, MEMORY_TAG_ARRAY);
-    u64 read_size = 0;
-    if (!filesystem_read_all_text(&f, resource_data, &read_size)) {
-        KERROR("Unable to text read file: %s.", full_file_path);
-        filesystem_close(&f);
-        return false;
-    }
+    char* resource_data = kallocate(sizeof(char) * f.size, MEMORY_TAG_ARRAY);
+    kcopy_memory(resource_data, f.data, f.size);
+    u64 read_size = f.size;
 
-    filesystem_close(&f);
+    vfs_close(&f);
 
     out_resource->data = resource_data;
     out_resource->data_size = read_size;
@@ -66,6 +55,7 @@ resource_loader text_resource_loader_create() {
     loader.load = text_loader_load;
     loader.unload = text_loader_unload;
     loader.type_path = "";
+    loader.params_size = 0;
 
     return loader;
 }
\ No newline at end of file
@@ -22,6 +22,8 @@ typedef struct resource {
     char* full_path;   // file path of the resource
     u64 data_size;     // size of the data in the resource
     void* data;        // pointer to the actual data
+    void* loader_data; // anything the loader needs to hang on to until unload, like the file the data lives in
+    u32 cache_index;   // where the resource sits in the resource system's cache, or INVALID_ID if it is not cached
 } resource;
 
 // different structs for different data types
@@ -38,8 +40,28 @@ typedef struct image_resource_data {
 typedef struct image_resource_params {
     // @brief indicates if the image should be flipped on the y axis when loaded
     b8 flip_y;
+    // @brief load from the source image (png, tga etc) even if a cooked .kti of the same name exists
+    b8 force_import;
 } image_resource_params;
 
+// @brief parameters used when loading a mesh. optional, passing 0 imports with mesh_loader_cook_params, if it imports
+typedef struct mesh_resource_params {
+    // @brief import from the source file (obj) even if an up to date .ksm of the same name exists, writing a fresh .ksm
+    b8 force_import;
+    // @brief when importing, store the vertices and indices in the .ksm packed (delta coded, then lz4 compressed). the
+    // file is smaller, but they are unpacked on load rather than used straight out of the file
+    b8 pack_streams;
+    // @brief when importing, reorder triangles for the vertex cache and overdraw, and vertices for fetching, before the
+    // .ksm is written. see geometry_optimize_vertex_cache and friends
+    b8 optimize;
+    // @brief when importing, the number of levels of detail to generate for each geometry, counting the full detail
+    // one. each aims for half the triangles of the one before. 0 or 1 for none. see geometry_simplify
+    u8 lod_count;
+    // @brief when importing, split each level of detail into meshlets, so they can be culled one by one. see
+    // geometry_build_meshlets
+    b8 meshlets;
+} mesh_resource_params;
+
 // @brief determines face culling mode when rendering
 typedef enum face_cull_mode {
     // @brief no faces are culled
@@ -179,6 +201,48 @@ typedef struct material {
 } material;
 
 #define GEOMETRY_NAME_MAX_LENGTH 256
+// the most levels of detail a geometry can have, counting the full detail one
+#define GEOMETRY_MAX_LOD_COUNT 8
+
+// @brief one level of detail of a geometry. each is a range of the geometry's indices, drawing fewer triangles from the
+// same vertices
+typedef struct geometry_lod {
+    // @brief the first index of the range
+    u32 index_offset;
+    // @brief the number of indices in the range
+    u32 index_count;
+    // @brief how far the surface is from the full detail one at most, in local units. 0 for full detail
+    f32 error;
+    // @brief the first of the geometry's meshlets that make up this level of detail
+    u32 meshlet_offset;
+    // @brief the number of meshlets making up this level of detail. 0 if it has none, and is drawn whole
+    u32 meshlet_count;
+} geometry_lod;
+
+// @brief a small cluster of a level of detail's triangles, with what's needed to cull it on its own. see
+// geometry_build_meshlets
+typedef struct geometry_meshlet {
+    // @brief the first index of the meshlet's triangles, which are together in the geometry's indices
+    u32 index_offset;
+    // @brief the number of indices
+    u32 index_count;
+    // @brief the center of a sphere around the meshlet, in local coordinates
+    vec3 center;
+    // @brief the radius of the sphere
+    f32 radius;
+    // @brief the direction the meshlet's triangles face, on average. a unit vector
+    vec3 cone_axis;
+    // @brief how far the triangles' directions spread from cone_axis, as the sine of the widest angle between them. the
+    // meshlet faces away from a camera, and can be culled, where dot(center - camera, cone_axis) >= cone_cutoff *
+    // length(center - camera) + radius. 1 where they spread too far for it ever to face away
+    f32 cone_cutoff;
+} geometry_meshlet;
+
+// @brief a range of a geometry's indices to draw
+typedef struct geometry_index_range {
+    u32 index_offset;
+    u32 index_count;
+} geometry_index_range;
 
 // @brief represents actual geometry in the world
 // typically (but not always, depending on use) paired with a material
@@ -194,6 +258,17 @@ typedef struct geometry {
     // @brief the geometry name
     char name[GEOMETRY_NAME_MAX_LENGTH];
     material* material;
+    // @brief the size of each vertex. sizeof(vertex_3d_packed) when packed, in which case positions are relative to the
+    // extents (see geometry_packed_position_transform)
+    u32 vertex_size;
+    // @brief the number of levels of detail. always at least 1, the first being full detail
+    u8 lod_count;
+    // @brief the levels of detail, each coarser than the last
+    geometry_lod lods[GEOMETRY_MAX_LOD_COUNT];
+    // @brief the number of meshlets, for every level of detail together
+    u32 meshlet_count;
+    // @brief the meshlets, each level of detail's after the one before. 0 if there are none
+    geometry_meshlet* meshlets;
 } geometry;
 
 typedef struct mesh {
@@ -231,6 +306,12 @@ typedef enum shader_attribute_type {
     SHADER_ATTRIB_TYPE_UINT16 = 8U,
     SHADER_ATTRIB_TYPE_INT32 = 9U,
     SHADER_ATTRIB_TYPE_UINT32 = 10U,
+    // @brief 4 u16s, read by the shader as floats from 0 to 1
+    SHADER_ATTRIB_TYPE_UNORM16_4 = 11U,
+    // @brief 2 i16s, read by the shader as floats from -1 to 1
+    SHADER_ATTRIB_TYPE_SNORM16_2 = 12U,
+    // @brief 2 half floats
+    SHADER_ATTRIB_TYPE_FLOAT16_2 = 13U,
 } shader_attribute_type;
 
 // @brief available uniform types
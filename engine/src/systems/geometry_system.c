@@ -4,9 +4,9 @@
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "math/geometry_utils.h"
+#include "math/kmath.h"
 #include "systems/material_system.h"
 #include "renderer/renderer_frontend.h"
-#include "math/geometry_utils.h"
 
 // keep refences to the geometries
 typedef struct geometry_reference {
@@ -33,6 +33,8 @@ static geometry_system_state* state_ptr = 0;
 b8 create_default_geometries(geometry_system_state* state);
 b8 create_geometry(geometry_system_state* state, geometry_config config, geometry* g);
 void destroy_geometry(geometry_system_state* state, geometry* g);
+static void set_lods(geometry* g, u32 index_count, u32 lod_count, const geometry_lod* lods);
+static void set_meshlets(geometry* g, const geometry_config* config);
 
 // initialize the geometry system - 2 stage initializatin, first stage is to get the memory requirement to allocate the memory, second call actually initializes it
 b8 geometry_system_initialize(u64* memory_requirement, void* state, geometry_system_config config) {
@@ -129,6 +131,41 @@ geometry* geometry_system_acquire_from_config(geometry_config config, b8 auto_re
     return g;
 }
 
+b8 geometry_system_reload(geometry* g, geometry_config config) {
+    if (!state_ptr || !g || g->id == INVALID_ID || g->internal_id == INVALID_ID) {
+        return false;
+    }
+
+    // the geometry already has an internal id, so the renderer uploads the new data and frees the old in its place
+    if (!renderer_create_geometry(g, config.vertex_size, config.vertex_count, config.vertices, config.index_size, config.index_count, config.indices)) {
+        KERROR("geometry_system_reload - failed to upload geometry '%s'.", g->name);
+        return false;
+    }
+
+    g->center = config.center;
+    g->extents.min = config.min_extents;
+    g->extents.max = config.max_extents;
+    g->vertex_size = config.vertex_size;
+    set_lods(g, config.index_count, config.lod_count, config.lods);
+    set_meshlets(g, &config);
+    g->generation = g->generation == INVALID_ID_U16 ? 0 : g->generation + 1;
+
+    // only swap the material if it is a different one, so an unchanged one is never released and loaded again
+    const char* current_material_name = g->material ? g->material->name : "";
+    if (!strings_equali(current_material_name, config.material_name)) {
+        material* old_material = g->material;
+        g->material = string_length(config.material_name) > 0 ? material_system_acquire(config.material_name) : 0;
+        if (!g->material && string_length(config.material_name) > 0) {
+            g->material = material_system_get_default();
+        }
+        if (old_material && string_length(old_material->name) > 0) {
+            material_system_release(old_material->name);
+        }
+    }
+
+    return true;
+}
+
 // @brief frees resources held by the provided configuration
 // @param config a pointer to the configuration to be disposed of
 void geometry_system_config_dispose(geometry_config* config) {
@@ -139,10 +176,41 @@ void geometry_system_config_dispose(geometry_config* config) {
         if (config->indices) {
             kfree(config->indices, config->index_size * config->index_count, MEMORY_TAG_ARRAY);
         }
+        if (config->meshlets) {
+            kfree(config->meshlets, sizeof(geometry_meshlet) * config->meshlet_count, MEMORY_TAG_ARRAY);
+        }
         kzero_memory(config, sizeof(geometry_config));
     }
 }
 
+b8 geometry_system_config_pack_vertices(geometry_config* config) {
+    if (!config || config->vertex_size != sizeof(vertex_3d) || config->vertex_count == 0) {
+        return true;
+    }
+
+    // the extents have to hold every vertex, and tighter is more precise, so they're worked out rather than trusted
+    vertex_3d* vertices = config->vertices;
+    vec3 min_extents = vertices[0].position;
+    vec3 max_extents = vertices[0].position;
+    for (u32 i = 1; i < config->vertex_count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 value = vertices[i].position.elements[c];
+            min_extents.elements[c] = value < min_extents.elements[c] ? value : min_extents.elements[c];
+            max_extents.elements[c] = value > max_extents.elements[c] ? value : max_extents.elements[c];
+        }
+    }
+
+    vertex_3d_packed* packed = kallocate(sizeof(vertex_3d_packed) * config->vertex_count, MEMORY_TAG_ARRAY);
+    b8 constant_colour = geometry_pack_vertices(config->vertex_count, vertices, min_extents, max_extents, packed);
+    kfree(vertices, sizeof(vertex_3d) * config->vertex_count, MEMORY_TAG_ARRAY);
+    config->vertices = packed;
+    config->vertex_size = sizeof(vertex_3d_packed);
+    config->min_extents = min_extents;
+    config->max_extents = max_extents;
+    config->center = vec3_mul_scalar(vec3_add(min_extents, max_extents), 0.5f);
+    return constant_colour;
+}
+
 // @brief realeases a reference to the provided geometry
 // @param geometry the geometry to be released
 void geometry_system_release(geometry* geometry) {
@@ -208,6 +276,9 @@ b8 create_geometry(geometry_system_state* state, geometry_config config, geometr
     g->center = config.center;
     g->extents.min = config.min_extents;
     g->extents.max = config.max_extents;
+    g->vertex_size = config.vertex_size;
+    set_lods(g, config.index_count, config.lod_count, config.lods);
+    set_meshlets(g, &config);
 
     // acquire the material
     if (string_length(config.material_name) > 0) {
@@ -220,11 +291,71 @@ b8 create_geometry(geometry_system_state* state, geometry_config config, geometr
     return true;
 }
 
+// copies the levels of detail over, or makes the one covering every index if there are none or they don't fit the indices
+static void set_lods(geometry* g, u32 index_count, u32 lod_count, const geometry_lod* lods) {
+    b8 valid = lod_count > 0 && lod_count <= GEOMETRY_MAX_LOD_COUNT;
+    for (u32 i = 0; valid && i < lod_count; ++i) {
+        valid = lods[i].index_offset <= index_count && lods[i].index_count <= index_count - lods[i].index_offset;
+    }
+    if (!valid) {
+        g->lod_count = 1;
+        g->lods[0].index_offset = 0;
+        g->lods[0].index_count = index_count;
+        g->lods[0].error = 0.0f;
+        return;
+    }
+    g->lod_count = (u8)lod_count;
+    kcopy_memory(g->lods, lods, sizeof(geometry_lod) * lod_count);
+}
+
+// copies the meshlets over, replacing any there were. they're dropped if they don't fit the levels of detail, which
+// are then drawn whole. must come after set_lods
+static void set_meshlets(geometry* g, const geometry_config* config) {
+    if (g->meshlets) {
+        kfree(g->meshlets, sizeof(geometry_meshlet) * g->meshlet_count, MEMORY_TAG_ARRAY);
+        g->meshlets = 0;
+    }
+    g->meshlet_count = 0;
+
+    // with no levels of detail in the config, lods[0] still says which meshlets cover the one there is
+    b8 valid = config->meshlet_count > 0 && config->meshlets;
+    for (u32 l = 0; valid && l < g->lod_count; ++l) {
+        const geometry_lod* lod = &config->lods[l];
+        valid = lod->meshlet_offset <= config->meshlet_count && lod->meshlet_count <= config->meshlet_count - lod->meshlet_offset;
+        for (u32 m = lod->meshlet_offset; valid && m < lod->meshlet_offset + lod->meshlet_count; ++m) {
+            const geometry_meshlet* meshlet = &config->meshlets[m];
+            valid = meshlet->index_offset >= g->lods[l].index_offset && meshlet->index_count <= g->lods[l].index_count &&
+                    meshlet->index_offset - g->lods[l].index_offset <= g->lods[l].index_count - meshlet->index_count;
+        }
+    }
+    for (u32 l = 0; l < g->lod_count; ++l) {
+        g->lods[l].meshlet_offset = valid ? config->lods[l].meshlet_offset : 0;
+        g->lods[l].meshlet_count = valid ? config->lods[l].meshlet_count : 0;
+    }
+    if (!valid) {
+        if (config->meshlet_count > 0) {
+            KWARN("Geometry '%s' has meshlets that don't fit its levels of detail. It will be drawn without them.", config->name);
+        }
+        return;
+    }
+
+    g->meshlet_count = config->meshlet_count;
+    g->meshlets = kallocate(sizeof(geometry_meshlet) * g->meshlet_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(g->meshlets, config->meshlets, sizeof(geometry_meshlet) * g->meshlet_count);
+}
+
 void destroy_geometry(geometry_system_state* state, geometry* g) {
     renderer_destroy_geometry(g);
     g->internal_id = INVALID_ID;
     g->generation = INVALID_ID_U16;
     g->id = INVALID_ID;
+    g->lod_count = 0;
+    g->vertex_size = 0;
+    if (g->meshlets) {
+        kfree(g->meshlets, sizeof(geometry_meshlet) * g->meshlet_count, MEMORY_TAG_ARRAY);
+        g->meshlets = 0;
+    }
+    g->meshlet_count = 0;
 
     string_empty(g->name);
 
@@ -263,13 +394,22 @@ b8 create_default_geometries(geometry_system_state* state) {
 
     u32 indices[6] = {0, 1, 2, 0, 3, 1};
 
+    // packed, as the material shader takes
+    vertex_3d_packed packed_verts[4];
+    state->default_geometry.extents.min = vec3_create(-0.5f * f, -0.5f * f, 0.0f);
+    state->default_geometry.extents.max = vec3_create(0.5f * f, 0.5f * f, 0.0f);
+    geometry_pack_vertices(4, verts, state->default_geometry.extents.min, state->default_geometry.extents.max, packed_verts);
+
     // send the geomtery off to the renderer to be uploaded to the GPU
     state->default_geometry.internal_id = INVALID_ID;
-    if (!renderer_create_geometry(&state->default_geometry, sizeof(vertex_3d), 4, verts, sizeof(u32), 6, indices)) {
+    if (!renderer_create_geometry(&state->default_geometry, sizeof(vertex_3d_packed), 4, packed_verts, sizeof(u32), 6, indices)) {
         KFATAL("Failed to create the default geometry. Application cannot continue.");
         return false;
     }
 
+    state->default_geometry.vertex_size = sizeof(vertex_3d_packed);
+    set_lods(&state->default_geometry, 6, 0, 0);
+
     // acquire the default material
     state->default_geometry.material = material_system_get_default();
 
@@ -306,23 +446,87 @@ b8 create_default_geometries(geometry_system_state* state) {
         return false;
     }
 
+    state->default_2d_geometry.vertex_size = sizeof(vertex_2d);
+    set_lods(&state->default_2d_geometry, 6, 0, 0);
+
     // acquire the default material
     state->default_2d_geometry.material = material_system_get_default();
 
     return true;
 }
 
-// @brief Generates configuration for plane geometries given the provided parameters.
-// NOTE: vertex and index arrays are dynamically allocated and should be freed upon object disposal.  Thus, this should not be considered production code
-// @param width the overall width of the plane. must be non zero
-// @param height the overall height of the plane. must be non zero
-// @param x_segment_count the number of segments along the x axis in the plane.  must be non-zero
-// @param y_segment_count the number of segments along the y axis in the plane.  must be non-zero
-// @param tile_x the number of times the texture should tile across the plane on the x axis. must be non zero
-// @param tile_y the number of times the texture should tile across the plane on the y axis. must be non zero
-// @param name the name of the generated geometry
-// @param material_name the name of the material to be used
-// @return a geometry configuration which can then be fed into geometry_system_acquire_from_config()
+// fills in the name and material of a generated configuration, or the defaults if none are given
+static void config_set_names(geometry_config* config, const char* name, const char* material_name) {
+    if (name && string_length(name) > 0) {
+        string_ncopy(config->name, name, GEOMETRY_NAME_MAX_LENGTH);
+    } else {
+        string_ncopy(config->name, DEFAULT_GEOMETRY_NAME, GEOMETRY_NAME_MAX_LENGTH);
+    }
+
+    if (material_name && string_length(material_name) > 0) {
+        string_ncopy(config->material_name, material_name, MATERIAL_NAME_MAX_LENGTH);
+    } else {
+        string_ncopy(config->material_name, DEFAULT_MATERIAL_NAME, MATERIAL_NAME_MAX_LENGTH);
+    }
+}
+
+geometry_config geometry_system_generate_shapes_config(u32 shape_count, const geometry_shape* shapes, b8 pack, linear_allocator* allocator, const char* name, const char* material_name) {
+    geometry_config config;
+    kzero_memory(&config, sizeof(geometry_config));
+    config.vertex_size = pack ? sizeof(vertex_3d_packed) : sizeof(vertex_3d);
+    config.index_size = sizeof(u32);
+    geometry_shapes_size(shape_count, shapes, &config.vertex_count, &config.index_count);
+    config_set_names(&config, name, material_name);
+    if (config.vertex_count == 0 || config.index_count == 0) {
+        KWARN("geometry_system_generate_shapes_config - no shapes to generate for '%s'.", config.name);
+        config.vertex_count = 0;
+        config.index_count = 0;
+        return config;
+    }
+
+    // packed vertices are generated somewhere of their own first, so only what is kept comes out of the allocator
+    u64 vertices_size = sizeof(vertex_3d) * config.vertex_count;
+    vertex_3d* vertices = 0;
+    if (allocator) {
+        config.vertices = linear_allocator_allocate(allocator, config.vertex_size * config.vertex_count);
+        config.indices = config.vertices ? linear_allocator_allocate(allocator, config.index_size * config.index_count) : 0;
+        if (!config.indices) {
+            KERROR("geometry_system_generate_shapes_config - the allocator is out of room for '%s'.", config.name);
+            kzero_memory(&config, sizeof(geometry_config));
+            return config;
+        }
+        vertices = pack ? kallocate(vertices_size, MEMORY_TAG_ARRAY) : config.vertices;
+    } else {
+        vertices = kallocate(vertices_size, MEMORY_TAG_ARRAY);
+        config.vertices = vertices;
+        config.indices = kallocate(config.index_size * config.index_count, MEMORY_TAG_ARRAY);
+    }
+    geometry_generate_shapes(shape_count, shapes, vertices, config.indices, 0);
+
+    // the bounds, which the world view culls by, and packed positions are relative to
+    config.min_extents = vertices[0].position;
+    config.max_extents = vertices[0].position;
+    for (u32 i = 1; i < config.vertex_count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 value = vertices[i].position.elements[c];
+            config.min_extents.elements[c] = value < config.min_extents.elements[c] ? value : config.min_extents.elements[c];
+            config.max_extents.elements[c] = value > config.max_extents.elements[c] ? value : config.max_extents.elements[c];
+        }
+    }
+    config.center = vec3_mul_scalar(vec3_add(config.min_extents, config.max_extents), 0.5f);
+
+    if (pack) {
+        if (allocator) {
+            geometry_pack_vertices(config.vertex_count, vertices, config.min_extents, config.max_extents, config.vertices);
+            kfree(vertices, vertices_size, MEMORY_TAG_ARRAY);
+        } else {
+            config.vertex_size = sizeof(vertex_3d);
+            geometry_system_config_pack_vertices(&config);
+        }
+    }
+    return config;
+}
+
 geometry_config geometry_system_generate_plane_config(f32 width, f32 height, u32 x_segment_count, u32 y_segment_count, f32 tile_x, f32 tile_y, const char* name, const char* material_name) {
     // if width and/or height are zero, set them to one
     if (width == 0) {
@@ -354,86 +558,14 @@ geometry_config geometry_system_generate_plane_config(f32 width, f32 height, u32
         tile_y = 1.0f;
     }
 
-    geometry_config config;
-    config.vertex_size = sizeof(vertex_3d);
-    config.vertex_count = x_segment_count * y_segment_count * 4;                             // 4 verts per segment
-    config.vertices = kallocate(sizeof(vertex_3d) * config.vertex_count, MEMORY_TAG_ARRAY);  // allocate memory for the vertex array
-    config.index_size = sizeof(u32);
-    config.index_count = x_segment_count * y_segment_count * 6;                      // 6 indices per segment
-    config.indices = kallocate(sizeof(u32) * config.index_count, MEMORY_TAG_ARRAY);  // allocate memory for the index array
-
-    // TODO: this generates extro vertices, but we can always deduplicate them later
-    f32 seg_width = width / x_segment_count;    // divide the width by count to get the length of each segment
-    f32 seg_height = height / y_segment_count;  // divide the height by count to get the length of each segment
-    f32 half_width = width * 0.5f;
-    f32 half_height = height * 0.5f;
-    for (u32 y = 0; y < y_segment_count; ++y) {      // iterate through the y segment count - the rows
-        for (u32 x = 0; x < x_segment_count; ++x) {  // iterate through the x segment count - the collums
-            // generate the vertices
-            // create centered geometry based on the inputs for each segment
-            f32 min_x = (x * seg_width) - half_width;    // this is the left position
-            f32 min_y = (y * seg_height) - half_height;  // this is the top postion
-            f32 max_x = min_x + seg_width;               // this is the right position
-            f32 max_y = min_y + seg_height;              // this is the left position
-
-            // texture coords, with the tiling calculated into it
-            f32 min_uvx = (x / (f32)x_segment_count) * tile_x;
-            f32 min_uvy = (y / (f32)y_segment_count) * tile_y;
-            f32 max_uvx = ((x + 1) / (f32)x_segment_count) * tile_x;
-            f32 max_uvy = ((y + 1) / (f32)y_segment_count) * tile_y;
-
-            // calculate the correct place in the array to put the vertex data
-            u32 v_offset = ((y * x_segment_count) + x) * 4;
-            vertex_3d* v0 = &((vertex_3d*)config.vertices)[v_offset + 0];
-            vertex_3d* v1 = &((vertex_3d*)config.vertices)[v_offset + 1];
-            vertex_3d* v2 = &((vertex_3d*)config.vertices)[v_offset + 2];
-            vertex_3d* v3 = &((vertex_3d*)config.vertices)[v_offset + 3];
-
-            // assign all the vertex points
-            v0->position.x = min_x;
-            v0->position.y = min_y;
-            v0->texcoord.x = min_uvx;
-            v0->texcoord.y = min_uvy;
-
-            v1->position.x = max_x;
-            v1->position.y = max_y;
-            v1->texcoord.x = max_uvx;
-            v1->texcoord.y = max_uvy;
-
-            v2->position.x = min_x;
-            v2->position.y = max_y;
-            v2->texcoord.x = min_uvx;
-            v2->texcoord.y = max_uvy;
-
-            v3->position.x = max_x;
-            v3->position.y = min_y;
-            v3->texcoord.x = max_uvx;
-            v3->texcoord.y = min_uvy;
-
-            // generate the indices
-            u32 i_offset = ((y * x_segment_count) + x) * 6;
-            ((u32*)config.indices)[i_offset + 0] = v_offset + 0;
-            ((u32*)config.indices)[i_offset + 1] = v_offset + 1;
-            ((u32*)config.indices)[i_offset + 2] = v_offset + 2;
-            ((u32*)config.indices)[i_offset + 3] = v_offset + 0;
-            ((u32*)config.indices)[i_offset + 4] = v_offset + 3;
-            ((u32*)config.indices)[i_offset + 5] = v_offset + 1;
-        }
-    }
-
-    if (name && string_length(name) > 0) {
-        string_ncopy(config.name, name, GEOMETRY_NAME_MAX_LENGTH);
-    } else {
-        string_ncopy(config.name, DEFAULT_GEOMETRY_NAME, GEOMETRY_NAME_MAX_LENGTH);
-    }
-
-    if (material_name && string_length(material_name) > 0) {
-        string_ncopy(config.material_name, material_name, MATERIAL_NAME_MAX_LENGTH);
-    } else {
-        string_ncopy(config.material_name, DEFAULT_MATERIAL_NAME, MATERIAL_NAME_MAX_LENGTH);
-    }
-
-    return config;
+    geometry_shape plane;
+    plane.type = GEOMETRY_SHAPE_PLANE;
+    plane.size = vec3_create(width, height, 0.0f);
+    plane.segments_x = x_segment_count;
+    plane.segments_y = y_segment_count;
+    plane.tiling = vec2_create(tile_x, tile_y);
+    plane.transform = mat4_identity();
+    return geometry_system_generate_shapes_config(1, &plane, false, 0, name, material_name);
 }
 
 geometry_config geometry_system_generate_cube_config(f32 width, f32 height, f32 depth, f32 tile_x, f32 tile_y, const char* name, const char* material_name) {
@@ -458,151 +590,12 @@ geometry_config geometry_system_generate_cube_config(f32 width, f32 height, f32
         tile_y = 1.0f;
     }
 
-    geometry_config config;
-    config.vertex_size = sizeof(vertex_3d);
-    config.vertex_count = 4 * 6;  // 4 verts per side, 6 sides
-    config.vertices = kallocate(sizeof(vertex_3d) * config.vertex_count, MEMORY_TAG_ARRAY);
-    config.index_size = sizeof(u32);
-    config.index_count = 6 * 6;  // 6 indices per side, 6 sides
-    config.indices = kallocate(sizeof(u32) * config.index_count, MEMORY_TAG_ARRAY);
-
-    f32 half_width = width * 0.5f;
-    f32 half_height = height * 0.5f;
-    f32 half_depth = depth * 0.5f;
-    f32 min_x = -half_width;
-    f32 min_y = -half_height;
-    f32 min_z = -half_depth;
-    f32 max_x = half_width;
-    f32 max_y = half_height;
-    f32 max_z = half_depth;
-    f32 min_uvx = 0.0f;
-    f32 min_uvy = 0.0f;
-    f32 max_uvx = tile_x;
-    f32 max_uvy = tile_y;
-
-    config.min_extents.x = min_x;
-    config.min_extents.y = min_y;
-    config.min_extents.z = min_z;
-    config.max_extents.x = max_x;
-    config.min_extents.y = max_y;
-    config.min_extents.z = max_z;
-    // alwaus 0 since min/max of each axis are -/+ half of the size
-    config.center.x = 0;
-    config.center.y = 0;
-    config.center.z = 0;
-
-    vertex_3d verts[24];
-
-    // front face
-    verts[(0 * 4) + 0].position = (vec3){min_x, min_y, max_z};
-    verts[(0 * 4) + 1].position = (vec3){max_x, max_y, max_z};
-    verts[(0 * 4) + 2].position = (vec3){min_x, max_y, max_z};
-    verts[(0 * 4) + 3].position = (vec3){max_x, min_y, max_z};
-    verts[(0 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(0 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(0 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(0 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(0 * 4) + 0].normal = (vec3){0.0f, 0.0f, 1.0f};
-    verts[(0 * 4) + 1].normal = (vec3){0.0f, 0.0f, 1.0f};
-    verts[(0 * 4) + 2].normal = (vec3){0.0f, 0.0f, 1.0f};
-    verts[(0 * 4) + 3].normal = (vec3){0.0f, 0.0f, 1.0f};
-
-    // Back face
-    verts[(1 * 4) + 0].position = (vec3){max_x, min_y, min_z};
-    verts[(1 * 4) + 1].position = (vec3){min_x, max_y, min_z};
-    verts[(1 * 4) + 2].position = (vec3){max_x, max_y, min_z};
-    verts[(1 * 4) + 3].position = (vec3){min_x, min_y, min_z};
-    verts[(1 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(1 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(1 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(1 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(1 * 4) + 0].normal = (vec3){0.0f, 0.0f, -1.0f};
-    verts[(1 * 4) + 1].normal = (vec3){0.0f, 0.0f, -1.0f};
-    verts[(1 * 4) + 2].normal = (vec3){0.0f, 0.0f, -1.0f};
-    verts[(1 * 4) + 3].normal = (vec3){0.0f, 0.0f, -1.0f};
-
-    // left face
-    verts[(2 * 4) + 0].position = (vec3){min_x, min_y, min_z};
-    verts[(2 * 4) + 1].position = (vec3){min_x, max_y, max_z};
-    verts[(2 * 4) + 2].position = (vec3){min_x, max_y, min_z};
-    verts[(2 * 4) + 3].position = (vec3){min_x, min_y, max_z};
-    verts[(2 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(2 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(2 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(2 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(2 * 4) + 0].normal = (vec3){-1.0f, 0.0f, 0.0f};
-    verts[(2 * 4) + 1].normal = (vec3){-1.0f, 0.0f, 0.0f};
-    verts[(2 * 4) + 2].normal = (vec3){-1.0f, 0.0f, 0.0f};
-    verts[(2 * 4) + 3].normal = (vec3){-1.0f, 0.0f, 0.0f};
-
-    // right face
-    verts[(3 * 4) + 0].position = (vec3){max_x, min_y, max_z};
-    verts[(3 * 4) + 1].position = (vec3){max_x, max_y, min_z};
-    verts[(3 * 4) + 2].position = (vec3){max_x, max_y, max_z};
-    verts[(3 * 4) + 3].position = (vec3){max_x, min_y, min_z};
-    verts[(3 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(3 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(3 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(3 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(3 * 4) + 0].normal = (vec3){1.0f, 0.0f, 0.0f};
-    verts[(3 * 4) + 1].normal = (vec3){1.0f, 0.0f, 0.0f};
-    verts[(3 * 4) + 2].normal = (vec3){1.0f, 0.0f, 0.0f};
-    verts[(3 * 4) + 3].normal = (vec3){1.0f, 0.0f, 0.0f};
-
-    // bottom face
-    verts[(4 * 4) + 0].position = (vec3){max_x, min_y, max_z};
-    verts[(4 * 4) + 1].position = (vec3){min_x, min_y, min_z};
-    verts[(4 * 4) + 2].position = (vec3){max_x, min_y, min_z};
-    verts[(4 * 4) + 3].position = (vec3){min_x, min_y, max_z};
-    verts[(4 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(4 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(4 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(4 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(4 * 4) + 0].normal = (vec3){0.0f, -1.0f, 0.0f};
-    verts[(4 * 4) + 1].normal = (vec3){0.0f, -1.0f, 0.0f};
-    verts[(4 * 4) + 2].normal = (vec3){0.0f, -1.0f, 0.0f};
-    verts[(4 * 4) + 3].normal = (vec3){0.0f, -1.0f, 0.0f};
-
-    // top face
-    verts[(5 * 4) + 0].position = (vec3){min_x, max_y, max_z};
-    verts[(5 * 4) + 1].position = (vec3){max_x, max_y, min_z};
-    verts[(5 * 4) + 2].position = (vec3){min_x, max_y, min_z};
-    verts[(5 * 4) + 3].position = (vec3){max_x, max_y, max_z};
-    verts[(5 * 4) + 0].texcoord = (vec2){min_uvx, min_uvy};
-    verts[(5 * 4) + 1].texcoord = (vec2){max_uvx, max_uvy};
-    verts[(5 * 4) + 2].texcoord = (vec2){min_uvx, max_uvy};
-    verts[(5 * 4) + 3].texcoord = (vec2){max_uvx, min_uvy};
-    verts[(5 * 4) + 0].normal = (vec3){0.0f, 1.0f, 0.0f};
-    verts[(5 * 4) + 1].normal = (vec3){0.0f, 1.0f, 0.0f};
-    verts[(5 * 4) + 2].normal = (vec3){0.0f, 1.0f, 0.0f};
-    verts[(5 * 4) + 3].normal = (vec3){0.0f, 1.0f, 0.0f};
-
-    kcopy_memory(config.vertices, verts, config.vertex_size * config.vertex_count);
-
-    for (u32 i = 0; i < 6; ++i) {
-        u32 v_offset = i * 4;
-        u32 i_offset = i * 6;
-        ((u32*)config.indices)[i_offset + 0] = v_offset + 0;
-        ((u32*)config.indices)[i_offset + 1] = v_offset + 1;
-        ((u32*)config.indices)[i_offset + 2] = v_offset + 2;
-        ((u32*)config.indices)[i_offset + 3] = v_offset + 0;
-        ((u32*)config.indices)[i_offset + 4] = v_offset + 3;
-        ((u32*)config.indices)[i_offset + 5] = v_offset + 1;
-    }
-
-    if (name && string_length(name) > 0) {
-        string_ncopy(config.name, name, GEOMETRY_NAME_MAX_LENGTH);
-    } else {
-        string_ncopy(config.name, DEFAULT_GEOMETRY_NAME, GEOMETRY_NAME_MAX_LENGTH);
-    }
-
-    if (material_name && string_length(material_name) > 0) {
-        string_ncopy(config.material_name, material_name, MATERIAL_NAME_MAX_LENGTH);
-    } else {
-        string_ncopy(config.material_name, DEFAULT_MATERIAL_NAME, MATERIAL_NAME_MAX_LENGTH);
-    }
-
-    geometry_generate_tangents(config.vertex_count, config.vertices, config.index_count, config.indices);
-
-    return config;
-}
\ No newline at end of file
+    geometry_shape cube;
+    cube.type = GEOMETRY_SHAPE_CUBE;
+    cube.size = vec3_create(width, height, depth);
+    cube.segments_x = 1;
+    cube.segments_y = 1;
+    cube.tiling = vec2_create(tile_x, tile_y);
+    cube.transform = mat4_identity();
+    return geometry_system_generate_shapes_config(1, &cube, false, 0, name, material_name);
+}
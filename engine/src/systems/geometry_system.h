@@ -1,6 +1,8 @@
 #pragma once
 
 #include "renderer/renderer_types.inl"
+#include "math/geometry_utils.h"
+#include "memory/linear_allocator.h"
 
 typedef struct geometry_system_config {
     // max number of geometries the can be loaded at once.
@@ -15,9 +17,18 @@ typedef struct geometry_config {
     u32 vertex_count;  // number of vertices in the geometry
     void* vertices;    // pointer to the array of vertices for the geometry
     u32 index_size;
-    u32 index_count;  // number of indices in the geometry
+    u32 index_count;  // number of indices in the geometry, of every level of detail
     void* indices;    // pointer to the array of indices for the geometry
 
+    // levels of detail, each a range of the indices. 0 for just the one, covering all of them
+    u32 lod_count;
+    geometry_lod lods[GEOMETRY_MAX_LOD_COUNT];
+
+    // meshlets, for every level of detail together. each level says which are its own. with no levels of detail, lods[0]
+    // still does, for the one covering all the indices. 0 for none
+    u32 meshlet_count;
+    geometry_meshlet* meshlets;
+
     vec3 center;
     vec3 min_extents;
     vec3 max_extents;
@@ -45,9 +56,24 @@ geometry* geometry_system_acquire_by_id(u32 id);
 // @return a pointer to the acquired geometry or nullptr if failed
 geometry* geometry_system_acquire_from_config(geometry_config config, b8 auto_release);
 
+// @brief replaces the data of an acquired geometry with the given config, for when the file it came from has changed.
+// the geometry stays at the same address and its generation goes up by one. the material is only changed if the config
+// names a different one
+// @param g a pointer to the geometry to be replaced
+// @param config the new geometry configuration
+// @return true on success, otherwise false
+b8 geometry_system_reload(geometry* g, geometry_config config);
+
 // @brief frees resources held by the provided configuration
 // @param config a pointer to the configuration to be disposed of
-void geometry_system_config_dispose(geometry_config* config);
+KAPI void geometry_system_config_dispose(geometry_config* config);
+
+// @brief packs a configuration's vertices into vertex_3d_packed, the layout the material shader takes, replacing them.
+// the extents and center are set to the bounds of the vertices, which the positions are then relative to. does nothing
+// if they aren't vertex_3d
+// @param config a pointer to the configuration
+// @return false if the vertices didn't all have the same colour, which packing drops. otherwise true
+b8 geometry_system_config_pack_vertices(geometry_config* config);
 
 // @brief realeases a reference to the provided geometry
 // @param geometry the geometry to be released
@@ -61,8 +87,23 @@ geometry* geometry_system_get_default();
 // @return a pointer to the default geometry
 geometry* geometry_system_get_default_2d();
 
+// @brief generates configuration for a batch of shapes, in one set of vertices and indices, so they are uploaded (and
+// drawn) as a single geometry. see geometry_generate_shapes
+// @param shape_count the number of shapes
+// @param shapes the shapes, each placed by its own transform
+// @param pack true to pack the vertices into vertex_3d_packed, the layout the material shader takes. see
+// geometry_system_config_pack_vertices
+// @param allocator where the vertex and index arrays come from. when given, the configuration must not be disposed of
+// or packed again, the arrays go when the allocator is freed. 0 to allocate them, so they are freed by
+// geometry_system_config_dispose()
+// @param name the name of the generated geometry
+// @param material_name the name of the material to be used
+// @return a geometry configuration which can then be fed into geometry_system_acquire_from_config(). with no vertices if
+// there were no shapes, or the allocator ran out of room
+geometry_config geometry_system_generate_shapes_config(u32 shape_count, const geometry_shape* shapes, b8 pack, linear_allocator* allocator, const char* name, const char* material_name);
+
 // @brief Generates configuration for plane geometries given the provided parameters.
-// NOTE: vertex and index arrays are dynamically allocated and should be freed upon object disposal.  Thus, this should not be considered production code
+// NOTE: vertex and index arrays are dynamically allocated and should be freed with geometry_system_config_dispose()
 // @param width the overall width of the plane. must be non zero
 // @param height the overall height of the plane. must be non zero
 // @param x_segment_count the number of segments along the x axis in the plane.  must be non-zero
@@ -74,4 +115,14 @@ geometry* geometry_system_get_default_2d();
 // @return a geometry configuration which can then be fed into geometry_system_acquire_from_config()
 geometry_config geometry_system_generate_plane_config(f32 width, f32 height, u32 x_segment_count, u32 y_segment_count, f32 tile_x, f32 tile_y, const char* name, const char* material_name);
 
+// @brief generates configuration for a cube, centred on the origin, given the provided parameters
+// NOTE: vertex and index arrays are dynamically allocated and should be freed with geometry_system_config_dispose()
+// @param width the size of the cube along x. must be non zero
+// @param height the size of the cube along y. must be non zero
+// @param depth the size of the cube along z. must be non zero
+// @param tile_x the number of times the texture should tile across each face on the x axis. must be non zero
+// @param tile_y the number of times the texture should tile across each face on the y axis. must be non zero
+// @param name the name of the generated geometry
+// @param material_name the name of the material to be used
+// @return a geometry configuration which can then be fed into geometry_system_acquire_from_config()
 geometry_config geometry_system_generate_cube_config(f32 width, f32 height, f32 depth, f32 tile_x, f32 tile_y, const char* name, const char* material_name);
@@ -0,0 +1,638 @@
+#include "hot_reload_system.h"
+
+#include "core/logger.h"
+#include "core/kstring.h"
+#include "core/kmemory.h"
+#include "platform/platform.h"
+#include "platform/file_watcher.h"
+
+#include "resources/loaders/mesh_loader.h"
+#include "systems/resource_system.h"
+#include "systems/vfs_system.h"
+#include "systems/texture_system.h"
+#include "systems/material_system.h"
+#include "systems/shader_system.h"
+
+struct hot_reload_slot;
+
+// one face of a cube map being reloaded. the faces load at the same time, and are put together once the last is in
+typedef struct hot_reload_face {
+    struct hot_reload_slot* slot;
+    resource_load_handle handle;
+    b8 loaded;
+    resource r;
+} hot_reload_face;
+
+// an asset waiting to be reloaded, or being reloaded
+typedef struct hot_reload_slot {
+    hot_reload_slot_state state;
+    hot_reload_kind kind;
+    // load from the source file, ignoring any cooked version. set when the source is what changed
+    b8 from_source;
+    // changed again while loading, and the load could not be cancelled. it goes again once the load is done
+    b8 changed_again;
+    // waiting: when to start. settling: when to let go of the slot
+    f64 ready_time;
+    resource_load_handle handle;
+    // cube maps only, which load a face at a time rather than through handle
+    hot_reload_face faces[6];
+    u8 faces_pending;
+    b8 faces_failed;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+} hot_reload_slot;
+
+typedef struct hot_reload_watch {
+    b8 in_use;
+    resource_type type;
+    pfn_hot_reload_callback callback;
+    void* user_data;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+} hot_reload_watch;
+
+typedef struct hot_reload_system_state {
+    hot_reload_system_config config;
+    // false if there is no watcher on this platform, in which case nothing else happens
+    b8 active;
+    file_watcher watcher;
+    f64 debounce_time;
+    hot_reload_slot* slots;
+    hot_reload_watch* watches;
+} hot_reload_system_state;
+
+static hot_reload_system_state* state_ptr = 0;
+
+// cancels whatever a slot is loading. false if any of it had already finished, in which case it comes back as usual
+static b8 slot_cancel(hot_reload_slot* slot) {
+    if (slot->kind != HOT_RELOAD_KIND_CUBE_TEXTURE) {
+        return resource_system_cancel_load(slot->handle);
+    }
+    // any face that can't be stopped finishes the slot when it comes back, as a failure, so it is loaded again
+    for (u32 i = 0; i < 6; ++i) {
+        hot_reload_face* face = &slot->faces[i];
+        if (face->handle && resource_system_cancel_load(face->handle)) {
+            face->handle = 0;
+            slot->faces_pending--;
+            slot->faces_failed = true;
+        }
+    }
+    if (slot->faces_pending > 0) {
+        return false;
+    }
+    for (u32 i = 0; i < 6; ++i) {
+        if (slot->faces[i].loaded) {
+            resource_system_unload(&slot->faces[i].r);
+        }
+    }
+    kzero_memory(slot->faces, sizeof(slot->faces));
+    return true;
+}
+
+b8 hot_reload_system_initialize(u64* memory_requirement, void* state, hot_reload_system_config config) {
+    if (config.debounce_ms == 0) {
+        config.debounce_ms = 200;
+    }
+    if (config.max_pending_count == 0) {
+        config.max_pending_count = 64;
+    }
+    if (config.max_watch_count == 0) {
+        config.max_watch_count = 64;
+    }
+
+    // the state, then the slots, then the watches
+    u64 struct_requirement = sizeof(hot_reload_system_state);
+    u64 slots_requirement = sizeof(hot_reload_slot) * config.max_pending_count;
+    u64 watches_requirement = sizeof(hot_reload_watch) * config.max_watch_count;
+    *memory_requirement = struct_requirement + slots_requirement + watches_requirement;
+
+    if (!state) {
+        return true;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->debounce_time = config.debounce_ms / 1000.0;
+    state_ptr->slots = (void*)((u8*)state + struct_requirement);
+    state_ptr->watches = (void*)((u8*)state_ptr->slots + slots_requirement);
+
+    const char* base_path = resource_system_base_path();
+    state_ptr->active = file_watcher_create(base_path, &state_ptr->watcher);
+    if (state_ptr->active) {
+        KINFO("Hot reloading assets in '%s'.", base_path);
+    } else {
+        KWARN("Unable to watch '%s' for changes, assets are only hot reloaded through hot_reload_system_file_changed.", base_path);
+    }
+
+    return true;
+}
+
+void hot_reload_system_shutdown(void* state) {
+    if (state_ptr) {
+        // loads that have already finished can't be cancelled. their callbacks see the system is gone and just unload
+        for (u32 i = 0; i < state_ptr->config.max_pending_count; ++i) {
+            hot_reload_slot* slot = &state_ptr->slots[i];
+            if (slot->state == HOT_RELOAD_SLOT_STATE_LOADING && !slot_cancel(slot)) {
+                // faces already in would otherwise never be unloaded
+                for (u32 j = 0; j < 6; ++j) {
+                    if (slot->faces[j].loaded) {
+                        resource_system_unload(&slot->faces[j].r);
+                    }
+                }
+            }
+        }
+        if (state_ptr->active) {
+            file_watcher_destroy(&state_ptr->watcher);
+        }
+    }
+    state_ptr = 0;
+}
+
+static const char* kind_name(hot_reload_kind kind) {
+    switch (kind) {
+        case HOT_RELOAD_KIND_TEXTURE:
+            return "texture";
+        case HOT_RELOAD_KIND_CUBE_TEXTURE:
+            return "cube texture";
+        case HOT_RELOAD_KIND_MATERIAL:
+            return "material";
+        case HOT_RELOAD_KIND_MESH:
+            return "mesh";
+        case HOT_RELOAD_KIND_SHADER:
+            return "shader";
+        case HOT_RELOAD_KIND_SHADER_STAGE:
+            return "shader stage";
+    }
+    return "asset";
+}
+
+static b8 is_watched(resource_type type, const char* name) {
+    for (u32 i = 0; i < state_ptr->config.max_watch_count; ++i) {
+        hot_reload_watch* w = &state_ptr->watches[i];
+        if (w->in_use && w->type == type && strings_equal(w->name, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void notify_watches(resource_type type, const char* name, const resource* r) {
+    for (u32 i = 0; i < state_ptr->config.max_watch_count; ++i) {
+        hot_reload_watch* w = &state_ptr->watches[i];
+        if (w->in_use && w->type == type && strings_equal(w->name, name)) {
+            w->callback(r, w->user_data);
+        }
+    }
+}
+
+// the resource type a kind is loaded as, for the cache and the watches
+static resource_type kind_resource_type(hot_reload_kind kind) {
+    switch (kind) {
+        case HOT_RELOAD_KIND_TEXTURE:
+        case HOT_RELOAD_KIND_CUBE_TEXTURE:
+            return RESOURCE_TYPE_IMAGE;
+        case HOT_RELOAD_KIND_MATERIAL:
+            return RESOURCE_TYPE_MATERIAL;
+        case HOT_RELOAD_KIND_MESH:
+            return RESOURCE_TYPE_MESH;
+        case HOT_RELOAD_KIND_SHADER:
+            return RESOURCE_TYPE_SHADER;
+        case HOT_RELOAD_KIND_SHADER_STAGE:
+            return RESOURCE_TYPE_BINARY;
+    }
+    return RESOURCE_TYPE_CUSTOM;
+}
+
+b8 hot_reload_classify_path(const char* path, hot_reload_kind* out_kind, b8* out_from_source, char* out_name) {
+    // the extension starts at the last dot of the file name, not of the whole path
+    const char* extension = 0;
+    for (const char* c = path; *c; ++c) {
+        if (*c == '.') {
+            extension = c;
+        } else if (*c == '/') {
+            extension = 0;
+        }
+    }
+    if (!extension) {
+        return false;
+    }
+
+    // names are the path within the type's folder, without the extension
+    typedef struct path_rule {
+        const char* folder;
+        const char* extension;
+        hot_reload_kind kind;
+        b8 from_source;
+    } path_rule;
+    static const path_rule rules[] = {
+        {"textures/", ".kti", HOT_RELOAD_KIND_TEXTURE, false},
+        {"textures/", ".tga", HOT_RELOAD_KIND_TEXTURE, true},
+        {"textures/", ".png", HOT_RELOAD_KIND_TEXTURE, true},
+        {"textures/", ".jpg", HOT_RELOAD_KIND_TEXTURE, true},
+        {"textures/", ".bmp", HOT_RELOAD_KIND_TEXTURE, true},
+        {"materials/", ".kmt", HOT_RELOAD_KIND_MATERIAL, false},
+        {"models/", ".ksm", HOT_RELOAD_KIND_MESH, false},
+        {"models/", ".obj", HOT_RELOAD_KIND_MESH, true},
+        // a material library is only ever read while importing the obj of the same name
+        {"models/", ".mtl", HOT_RELOAD_KIND_MESH, true},
+        {"shaders/", ".shadercfg", HOT_RELOAD_KIND_SHADER, false},
+    };
+    for (u32 i = 0; i < sizeof(rules) / sizeof(path_rule); ++i) {
+        const path_rule* rule = &rules[i];
+        u64 folder_length = string_length(rule->folder);
+        if (!strings_nequal(path, rule->folder, folder_length) || !strings_equali(extension, rule->extension)) {
+            continue;
+        }
+        u64 name_length = (u64)(extension - path) - folder_length;
+        if (name_length == 0 || name_length >= RESOURCE_LOAD_NAME_MAX_LENGTH) {
+            return false;
+        }
+        string_ncopy(out_name, path + folder_length, name_length);
+        out_name[name_length] = 0;
+        *out_kind = rule->kind;
+        *out_from_source = rule->from_source;
+        return true;
+    }
+
+    // shader stages are loaded by their path, as that is how the shader config names them
+    if (strings_nequal(path, "shaders/", 8) && strings_equali(extension, ".spv") && string_length(path) < RESOURCE_LOAD_NAME_MAX_LENGTH) {
+        string_ncopy(out_name, path, RESOURCE_LOAD_NAME_MAX_LENGTH);
+        *out_kind = HOT_RELOAD_KIND_SHADER_STAGE;
+        *out_from_source = false;
+        return true;
+    }
+    return false;
+}
+
+b8 hot_reload_resolve_loaded(hot_reload_kind* kind, char* name) {
+    switch (*kind) {
+        case HOT_RELOAD_KIND_TEXTURE: {
+            texture* t = texture_system_get_loaded(name);
+            if (t && t->type == TEXTURE_TYPE_2D) {
+                return true;
+            }
+            // faces are named after the cube map with a suffix for the side
+            u64 length = string_length(name);
+            if (length > 2 && name[length - 2] == '_' && string_index_of("rludfb", name[length - 1]) != -1) {
+                char cube_name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+                string_ncopy(cube_name, name, length - 2);
+                cube_name[length - 2] = 0;
+                t = texture_system_get_loaded(cube_name);
+                if (t && t->type == TEXTURE_TYPE_CUBE) {
+                    *kind = HOT_RELOAD_KIND_CUBE_TEXTURE;
+                    string_ncopy(name, cube_name, RESOURCE_LOAD_NAME_MAX_LENGTH);
+                    return true;
+                }
+            }
+            return is_watched(RESOURCE_TYPE_IMAGE, name);
+        }
+        case HOT_RELOAD_KIND_MATERIAL:
+            return material_system_get_loaded(name) != 0 || is_watched(RESOURCE_TYPE_MATERIAL, name);
+        case HOT_RELOAD_KIND_MESH:
+            return is_watched(RESOURCE_TYPE_MESH, name);
+        case HOT_RELOAD_KIND_SHADER:
+            return shader_system_get(name) != 0;
+        case HOT_RELOAD_KIND_SHADER_STAGE:
+            // shader_system_reload_stage_file finds out which shaders use it
+            return true;
+        default:
+            return false;
+    }
+}
+
+static hot_reload_slot* slot_find(hot_reload_kind kind, const char* name) {
+    for (u32 i = 0; i < state_ptr->config.max_pending_count; ++i) {
+        hot_reload_slot* slot = &state_ptr->slots[i];
+        if (slot->state != HOT_RELOAD_SLOT_STATE_FREE && slot->kind == kind && strings_equal(slot->name, name)) {
+            return slot;
+        }
+    }
+    return 0;
+}
+
+void hot_reload_system_file_changed(const char* path) {
+    if (!state_ptr || !path) {
+        return;
+    }
+
+    // new files have to be made known to the vfs before they can be loaded. harmless for ones it already knows. the
+    // watcher's paths can be longer than the vfs takes, and such a file could never be loaded anyway
+    const char* base_path = resource_system_base_path();
+    if (string_length(base_path) + 1 + string_length(path) >= VFS_MAX_PATH_LENGTH) {
+        KWARN("Hot reload - path too long, '%s/%s' will not be reloaded.", base_path, path);
+        return;
+    }
+    char full_path[VFS_MAX_PATH_LENGTH];
+    string_format(full_path, "%s/%s", base_path, path);
+    vfs_track_file(full_path);
+
+    hot_reload_kind kind;
+    b8 from_source;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    if (!hot_reload_classify_path(path, &kind, &from_source, name)) {
+        return;
+    }
+
+    // whether it is loaded or not, the cache may be holding on to the old version
+    resource_system_invalidate(name, kind_resource_type(kind));
+    if (!hot_reload_resolve_loaded(&kind, name)) {
+        return;
+    }
+
+    f64 ready_time = platform_get_absolute_time() + state_ptr->debounce_time;
+    hot_reload_slot* slot = slot_find(kind, name);
+    if (slot) {
+        // importing from source writes out the cooked file, which is no reason to load it all over again
+        b8 is_own_output = !from_source && slot->from_source;
+        switch (slot->state) {
+            case HOT_RELOAD_SLOT_STATE_WAITING:
+                slot->from_source |= from_source;
+                slot->ready_time = ready_time;
+                break;
+            case HOT_RELOAD_SLOT_STATE_LOADING:
+                if (is_own_output) {
+                    break;
+                }
+                slot->from_source |= from_source;
+                if (slot_cancel(slot)) {
+                    slot->state = HOT_RELOAD_SLOT_STATE_WAITING;
+                    slot->ready_time = ready_time;
+                } else {
+                    slot->changed_again = true;
+                }
+                break;
+            case HOT_RELOAD_SLOT_STATE_SETTLING:
+                if (is_own_output) {
+                    break;
+                }
+                slot->state = HOT_RELOAD_SLOT_STATE_WAITING;
+                slot->from_source = from_source;
+                slot->ready_time = ready_time;
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < state_ptr->config.max_pending_count; ++i) {
+        slot = &state_ptr->slots[i];
+        if (slot->state == HOT_RELOAD_SLOT_STATE_FREE) {
+            kzero_memory(slot, sizeof(hot_reload_slot));
+            slot->state = HOT_RELOAD_SLOT_STATE_WAITING;
+            slot->kind = kind;
+            slot->from_source = from_source;
+            slot->ready_time = ready_time;
+            string_ncopy(slot->name, name, RESOURCE_LOAD_NAME_MAX_LENGTH);
+            return;
+        }
+    }
+    KWARN("Too many assets waiting to be hot reloaded, '%s' will not be. Adjust configuration to allow more.", path);
+}
+
+static void on_file_changed(const char* path, void* user_data) {
+    hot_reload_system_file_changed(path);
+}
+
+hot_reload_slot_state hot_reload_system_reload_state(hot_reload_kind kind, const char* name) {
+    hot_reload_slot* slot = state_ptr && name ? slot_find(kind, name) : 0;
+    return slot ? slot->state : HOT_RELOAD_SLOT_STATE_FREE;
+}
+
+// done with a slot, but it lingers to soak up any changes the reload caused
+static void slot_settle(hot_reload_slot* slot) {
+    slot->state = HOT_RELOAD_SLOT_STATE_SETTLING;
+    slot->ready_time = platform_get_absolute_time() + state_ptr->debounce_time;
+    slot->handle = 0;
+}
+
+// a load is done with. it goes again if the file changed in the meantime
+static void slot_finish(hot_reload_slot* slot) {
+    if (slot->changed_again) {
+        slot->state = HOT_RELOAD_SLOT_STATE_WAITING;
+        slot->changed_again = false;
+        slot->ready_time = platform_get_absolute_time() + state_ptr->debounce_time;
+        slot->handle = 0;
+    } else {
+        slot_settle(slot);
+    }
+}
+
+static void on_reload_loaded(b8 success, resource* r, void* user_data) {
+    hot_reload_slot* slot = user_data;
+    if (!state_ptr) {
+        // shut down while loading
+        if (success) {
+            resource_system_unload(r);
+        }
+        return;
+    }
+
+    if (success) {
+        b8 applied = true;
+        switch (slot->kind) {
+            case HOT_RELOAD_KIND_TEXTURE:
+                // false when only a watch is interested
+                if (texture_system_get_loaded(slot->name)) {
+                    applied = texture_system_reload_from_image(slot->name, r->data);
+                }
+                break;
+            case HOT_RELOAD_KIND_MATERIAL:
+                if (material_system_get_loaded(slot->name)) {
+                    applied = material_system_reload_from_config(r->data);
+                }
+                break;
+            default:
+                break;
+        }
+        notify_watches(kind_resource_type(slot->kind), slot->name, r);
+        resource_system_unload(r);
+        if (applied) {
+            KINFO("Hot reloaded %s '%s'.", kind_name(slot->kind), slot->name);
+        }
+    } else {
+        KERROR("Failed to hot reload %s '%s'.", kind_name(slot->kind), slot->name);
+    }
+
+    slot_finish(slot);
+}
+
+static void on_face_loaded(b8 success, resource* r, void* user_data) {
+    hot_reload_face* face = user_data;
+    if (!state_ptr) {
+        // shut down while loading
+        if (success) {
+            resource_system_unload(r);
+        }
+        return;
+    }
+
+    hot_reload_slot* slot = face->slot;
+    face->handle = 0;
+    if (success) {
+        face->r = *r;
+        // only valid during the call
+        face->r.name = 0;
+        face->loaded = true;
+    } else {
+        slot->faces_failed = true;
+    }
+    slot->faces_pending--;
+    if (slot->faces_pending > 0) {
+        return;
+    }
+
+    if (!slot->faces_failed) {
+        const image_resource_data* images[6];
+        for (u32 i = 0; i < 6; ++i) {
+            images[i] = slot->faces[i].r.data;
+        }
+        if (texture_system_reload_cube_from_images(slot->name, images)) {
+            KINFO("Hot reloaded %s '%s'.", kind_name(slot->kind), slot->name);
+        }
+    } else if (!slot->changed_again) {
+        // when it changed again, some faces were cancelled, and it is about to go again anyway
+        KERROR("Failed to hot reload %s '%s'.", kind_name(slot->kind), slot->name);
+    }
+    for (u32 i = 0; i < 6; ++i) {
+        if (slot->faces[i].loaded) {
+            resource_system_unload(&slot->faces[i].r);
+        }
+    }
+    kzero_memory(slot->faces, sizeof(slot->faces));
+    slot_finish(slot);
+}
+
+static void slot_start(hot_reload_slot* slot) {
+    // anything loaded between the change and now came from the new file, but it may have been caught half written
+    resource_type type = kind_resource_type(slot->kind);
+    resource_system_invalidate(slot->name, type);
+
+    switch (slot->kind) {
+        case HOT_RELOAD_KIND_TEXTURE:
+        case HOT_RELOAD_KIND_MATERIAL:
+        case HOT_RELOAD_KIND_MESH: {
+            // read and parsed on the job system, applied back on the main thread
+            image_resource_params image_params = {};
+            // imported the same way the asset cooker does it, so the reloaded mesh matches a cooked one
+            mesh_resource_params mesh_params = mesh_loader_cook_params(false);
+            resource_load_info info = resource_load_info_create(slot->name, type, on_reload_loaded, slot);
+            if (slot->kind == HOT_RELOAD_KIND_TEXTURE) {
+                // the same way texture_system_acquire loads them
+                image_params.flip_y = true;
+                image_params.force_import = slot->from_source;
+                info.params = &image_params;
+                info.params_size = sizeof(image_resource_params);
+            } else if (slot->kind == HOT_RELOAD_KIND_MESH) {
+                mesh_params.force_import = slot->from_source;
+                info.params = &mesh_params;
+                info.params_size = sizeof(mesh_resource_params);
+            }
+            slot->handle = resource_system_load_async(info);
+            if (!slot->handle) {
+                KERROR("Failed to start hot reloading %s '%s'.", kind_name(slot->kind), slot->name);
+                slot->state = HOT_RELOAD_SLOT_STATE_FREE;
+                return;
+            }
+            slot->state = HOT_RELOAD_SLOT_STATE_LOADING;
+            return;
+        }
+        case HOT_RELOAD_KIND_CUBE_TEXTURE: {
+            // all six faces are read and decoded on the job system, and put together once the last of them is in
+            static const char sides[6] = {'r', 'l', 'u', 'd', 'f', 'b'};
+            char face_name[RESOURCE_LOAD_NAME_MAX_LENGTH + 2];
+            image_resource_params image_params = {};
+            image_params.force_import = slot->from_source;
+            kzero_memory(slot->faces, sizeof(slot->faces));
+            slot->faces_pending = 0;
+            slot->faces_failed = false;
+            for (u32 i = 0; i < 6; ++i) {
+                string_format(face_name, "%s_%c", slot->name, sides[i]);
+                resource_system_invalidate(face_name, RESOURCE_TYPE_IMAGE);
+                slot->faces[i].slot = slot;
+                resource_load_info info = resource_load_info_create(face_name, RESOURCE_TYPE_IMAGE, on_face_loaded, &slot->faces[i]);
+                info.params = &image_params;
+                info.params_size = sizeof(image_resource_params);
+                slot->faces[i].handle = resource_system_load_async(info);
+                if (!slot->faces[i].handle) {
+                    KERROR("Failed to start hot reloading %s '%s'.", kind_name(slot->kind), slot->name);
+                    // the faces already started still come back, and finish the slot as failed
+                    slot->faces_failed = true;
+                    break;
+                }
+                slot->faces_pending++;
+            }
+            if (slot->faces_pending == 0) {
+                slot->state = HOT_RELOAD_SLOT_STATE_FREE;
+                return;
+            }
+            slot->state = HOT_RELOAD_SLOT_STATE_LOADING;
+            return;
+        }
+        case HOT_RELOAD_KIND_SHADER:
+            // only what is in the stages can change without a restart. unlike the rest, shaders reload right here on the
+            // main thread, as the renderer reads their stages as it builds the pipelines, and that has to happen here
+            if (shader_system_reload(slot->name)) {
+                KINFO("Hot reloaded shader '%s'. Changes to its layout (attributes, uniforms, samplers) need a restart.", slot->name);
+            }
+            break;
+        case HOT_RELOAD_KIND_SHADER_STAGE: {
+            u32 reload_count = shader_system_reload_stage_file(slot->name);
+            if (reload_count) {
+                KINFO("Hot reloaded %s '%s' in %u shader(s).", kind_name(slot->kind), slot->name, reload_count);
+            }
+        } break;
+    }
+    slot_settle(slot);
+}
+
+void hot_reload_system_update() {
+    if (!state_ptr) {
+        return;
+    }
+
+    // without a watcher, changes can still come in through hot_reload_system_file_changed
+    if (state_ptr->active) {
+        file_watcher_poll(&state_ptr->watcher, on_file_changed, 0);
+    }
+
+    f64 now = platform_get_absolute_time();
+    for (u32 i = 0; i < state_ptr->config.max_pending_count; ++i) {
+        hot_reload_slot* slot = &state_ptr->slots[i];
+        if (slot->state == HOT_RELOAD_SLOT_STATE_WAITING && now >= slot->ready_time) {
+            slot_start(slot);
+        } else if (slot->state == HOT_RELOAD_SLOT_STATE_SETTLING && now >= slot->ready_time) {
+            slot->state = HOT_RELOAD_SLOT_STATE_FREE;
+        }
+    }
+}
+
+b8 hot_reload_system_watch(resource_type type, const char* name, pfn_hot_reload_callback callback, void* user_data) {
+    if (!state_ptr || !name || !callback || string_length(name) >= RESOURCE_LOAD_NAME_MAX_LENGTH) {
+        return false;
+    }
+    for (u32 i = 0; i < state_ptr->config.max_watch_count; ++i) {
+        hot_reload_watch* w = &state_ptr->watches[i];
+        if (!w->in_use) {
+            w->in_use = true;
+            w->type = type;
+            w->callback = callback;
+            w->user_data = user_data;
+            string_ncopy(w->name, name, RESOURCE_LOAD_NAME_MAX_LENGTH);
+            return true;
+        }
+    }
+    KWARN("hot_reload_system_watch - no room to watch '%s'. Adjust configuration to allow more.", name);
+    return false;
+}
+
+void hot_reload_system_unwatch(resource_type type, const char* name, void* user_data) {
+    if (!state_ptr || !name) {
+        return;
+    }
+    for (u32 i = 0; i < state_ptr->config.max_watch_count; ++i) {
+        hot_reload_watch* w = &state_ptr->watches[i];
+        if (w->in_use && w->type == type && w->user_data == user_data && strings_equal(w->name, name)) {
+            w->in_use = false;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/resource_types.h"
+
+// hot reloading - watches the asset directory, and when a file changes, reloads just the assets that came from it (and
+// only if they are loaded). textures, materials and shaders are replaced in place and their generation bumped, so
+// everything using them picks the change up on its own. anything else, such as meshes, is handed to whoever is watching
+// for it with hot_reload_system_watch
+
+// @brief what a changed file means has to be reloaded
+typedef enum hot_reload_kind {
+    HOT_RELOAD_KIND_TEXTURE,
+    // @brief any one of the six faces
+    HOT_RELOAD_KIND_CUBE_TEXTURE,
+    HOT_RELOAD_KIND_MATERIAL,
+    HOT_RELOAD_KIND_MESH,
+    // @brief the .shadercfg
+    HOT_RELOAD_KIND_SHADER,
+    // @brief a .spv, which may be used by any number of shaders
+    HOT_RELOAD_KIND_SHADER_STAGE
+} hot_reload_kind;
+
+// @brief where an asset is in being reloaded
+typedef enum hot_reload_slot_state {
+    // @brief not being reloaded
+    HOT_RELOAD_SLOT_STATE_FREE,
+    // @brief waiting for the file to stop changing
+    HOT_RELOAD_SLOT_STATE_WAITING,
+    // @brief being loaded on the job system
+    HOT_RELOAD_SLOT_STATE_LOADING,
+    // @brief reloaded. kept around a little longer to catch changes that were made by the reload itself
+    HOT_RELOAD_SLOT_STATE_SETTLING
+} hot_reload_slot_state;
+
+// @brief the hot reload system configuration
+typedef struct hot_reload_system_config {
+    // @brief how long a file has to go without changing before it is reloaded. editors and exporters often write a
+    // file in several steps, this keeps each save to a single reload. 0 uses a default of 200
+    u32 debounce_ms;
+    // @brief the max number of assets waiting to be reloaded, or being reloaded, at once. 0 uses a default of 64
+    u32 max_pending_count;
+    // @brief the max number of hot_reload_system_watch calls in effect at once. 0 uses a default of 64
+    u32 max_watch_count;
+} hot_reload_system_config;
+
+// @brief called on the main thread with a freshly loaded resource whose file has changed. the resource is unloaded
+// once the callback returns, so copy out anything that needs to stay
+// @param resource the newly loaded resource
+// @param user_data the user_data passed to hot_reload_system_watch
+typedef void (*pfn_hot_reload_callback)(const resource* resource, void* user_data);
+
+// @brief initializes the hot reload system. should be called twice, once to get the memory requirement (passing
+// state=0), and a second time passing a block of memory to actually initialize the system. must come after the
+// resource, texture, material and shader systems. on platforms without a file watcher only changes passed to
+// hot_reload_system_file_changed are reloaded
+// @param memory_requirement a pointer to hold the memory requirement as it is calculated
+// @param state a block of memory to hold the state or 0 if getting the memory requirement
+// @param config the configuration for this system
+// @return true on success, otherwise false
+KAPI b8 hot_reload_system_initialize(u64* memory_requirement, void* state, hot_reload_system_config config);
+
+// @brief shuts down the hot reload system, cancelling any reloads still in flight. must come before the systems it
+// reloads into are shut down
+// @param state the state block of memory
+KAPI void hot_reload_system_shutdown(void* state);
+
+// @brief picks up changed files and starts reloading anything that has settled. call once a frame on the main thread.
+// loads run on the job system, and are applied from job_system_update
+KAPI void hot_reload_system_update();
+
+// @brief lets the system know a file has changed, as if the watcher had seen it. for tools that write assets out
+// themselves, and for platforms without a watcher. call on the main thread
+// @param path the path of the file, relative to the resource system's base path, with forward slashes
+KAPI void hot_reload_system_file_changed(const char* path);
+
+// @brief obtains where an asset is in being reloaded
+// @param kind what the asset is
+// @param name the name of the asset
+// @return HOT_RELOAD_SLOT_STATE_FREE if it is not being reloaded
+KAPI hot_reload_slot_state hot_reload_system_reload_state(hot_reload_kind kind, const char* name);
+
+// @brief works out what a changed file is, by the folder it is in and its extension
+// @param path the path of the file, relative to the resource system's base path, with forward slashes
+// @param out_kind a pointer to hold what the file is
+// @param out_from_source a pointer to hold whether the file is a source (like a .png or .obj) rather than cooked
+// @param out_name a character array of RESOURCE_LOAD_NAME_MAX_LENGTH to hold the name of the asset
+// @return true if it is something that can be reloaded, otherwise false
+KAPI b8 hot_reload_classify_path(const char* path, hot_reload_kind* out_kind, b8* out_from_source, char* out_name);
+
+// @brief indicates if whatever came from a changed file is loaded right now, or watched. a face of a loaded cube map
+// switches kind and name over to the cube map
+// @param kind what the asset is. may be changed
+// @param name the name of the asset, in a character array of RESOURCE_LOAD_NAME_MAX_LENGTH. may be changed
+// @return true if it should be reloaded, otherwise false
+KAPI b8 hot_reload_resolve_loaded(hot_reload_kind* kind, char* name);
+
+// @brief asks for a resource to be loaded again and handed to callback whenever its file changes. this is the way to
+// hot reload anything the engine does not keep track of itself, such as meshes
+// @param type the type of the resource
+// @param name the name the resource is loaded by
+// @param callback called with the new resource
+// @param user_data passed to the callback. optional
+// @return true on success, false if there is no room for another watch
+KAPI b8 hot_reload_system_watch(resource_type type, const char* name, pfn_hot_reload_callback callback, void* user_data);
+
+// @brief stops a watch made with hot_reload_system_watch
+// @param type the type of the resource
+// @param name the name of the resource
+// @param user_data the user_data the watch was made with
+KAPI void hot_reload_system_unwatch(resource_type type, const char* name, void* user_data);
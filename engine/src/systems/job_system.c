@@ -0,0 +1,728 @@
+#include "job_system.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kthread.h"
+#include "core/kmutex.h"
+#include "core/ksemaphore.h"
+#include "core/katomic.h"
+#include "core/kfiber.h"
+#include "core/kstring.h"
+#include "core/profiler.h"
+#include "containers/darray.h"
+#include "platform/platform.h"
+
+// each worker owns a chase-lev deque per priority. the owning worker pushes and pops at the bottom (lifo, so the
+// freshest and most likely cached work runs first) while any other thread steals from the top (fifo). only the
+// steal and the pop of the very last job race, and those are resolved with a single compare and swap on top
+typedef struct job_deque {
+    volatile i64 top;
+    volatile i64 bottom;
+    u64 mask;  // capacity - 1, capacity is always a power of 2
+    job_info* jobs;
+} job_deque;
+
+// jobs submitted from outside the worker threads (i.e. the main thread) go here, to be picked up by any worker
+typedef struct job_queue {
+    kmutex lock;
+    u32 head;
+    volatile i32 count;
+    u32 capacity;
+    job_info* jobs;
+} job_queue;
+
+// fiber jobs run on one of these rather than directly on the worker's stack, so they can be switched out while they
+// wait and picked back up later, possibly by a different worker
+typedef enum job_fiber_status {
+    JOB_FIBER_STATUS_RUNNING,
+    JOB_FIBER_STATUS_WAITING,  // parked until waiting_on hits zero, or straight away if yielded
+    JOB_FIBER_STATUS_DONE
+} job_fiber_status;
+
+typedef struct job_fiber {
+    kfiber fiber;
+    job_info job;
+    job_fiber_status status;
+    job_counter* waiting_on;  // 0 if the fiber yielded rather than waited
+} job_fiber;
+
+typedef struct job_worker {
+    u32 index;
+    kthread thread;
+    kfiber thread_fiber;  // the worker thread's own context, fibers switch back to this when they finish or wait
+    u32 steal_seed;  // used to pick which worker to steal from first, so they dont all hammer the same one
+    job_deque deques[JOB_PRIORITY_MAX];
+} job_worker;
+
+// a finished job waiting for its on_complete to be run on the main thread
+typedef struct job_completion {
+    pfn_job_on_complete on_complete;
+    void* params;
+} job_completion;
+
+typedef struct job_system_state {
+    job_system_config config;
+    u32 worker_count;
+    u32 queue_capacity;
+    volatile i32 running;
+    u64 main_thread_id;
+    job_worker* workers;
+    job_queue injection_queues[JOB_PRIORITY_MAX];
+
+    // worker threads sleep on this while there is nothing to do. signaled once per submitted job
+    ksemaphore work_available;
+
+    kmutex completion_lock;
+    u32 completion_head;
+    u32 completion_count;
+    job_completion* completions;
+    // completions moved off the queue by the main thread while it waits, to make room for the workers without running
+    // any callbacks in the middle of the wait. run first by the next job_system_update. only touched by the main thread
+    job_completion* spilled_completions;  // darray
+    u32 spilled_head;
+
+    // the fiber pool. free_fibers and waiting_fibers are both guarded by fiber_lock
+    kmutex fiber_lock;
+    u32 fiber_count;
+    job_fiber* fibers;
+    job_fiber** free_fibers;
+    u32 free_fiber_count;
+    job_fiber** waiting_fibers;
+    volatile i32 waiting_fiber_count;
+} job_system_state;
+
+static job_system_state* state_ptr;
+
+// the index of the worker running on this thread, or -1 if this is not a worker thread
+static KTHREAD_LOCAL i32 current_worker_index = -1;
+// the fiber running on this thread, or 0 if running directly on the thread's stack
+static KTHREAD_LOCAL job_fiber* current_fiber = 0;
+
+// NOTE: fibers can be switched out on one thread and resumed on another. the compiler is free to keep the address of
+// a thread local around for the length of a function, so anything that switches fibers must go through these rather
+// than touch the thread locals directly
+static KNOINLINE i32 get_current_worker_index() {
+    return current_worker_index;
+}
+
+static KNOINLINE job_fiber* get_current_fiber() {
+    return current_fiber;
+}
+
+static KNOINLINE void set_current_fiber(job_fiber* fiber) {
+    current_fiber = fiber;
+}
+
+static u32 round_up_pow2(u32 value) {
+    u32 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// NOTE: begin deque
+static b8 deque_push(job_deque* d, const job_info* job) {
+    i64 b = katomic_load_i64(&d->bottom, KATOMIC_RELAXED);
+    i64 t = katomic_load_i64(&d->top, KATOMIC_ACQUIRE);
+    if ((u64)(b - t) > d->mask) {
+        return false;  // full
+    }
+    d->jobs[b & d->mask] = *job;
+    // the job has to be visible before the new bottom is
+    katomic_store_i64(&d->bottom, b + 1, KATOMIC_RELEASE);
+    return true;
+}
+
+static b8 deque_pop(job_deque* d, job_info* out_job) {
+    i64 b = katomic_load_i64(&d->bottom, KATOMIC_RELAXED) - 1;
+    katomic_store_i64(&d->bottom, b, KATOMIC_RELAXED);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 t = katomic_load_i64(&d->top, KATOMIC_RELAXED);
+
+    if (t > b) {
+        // empty, put bottom back
+        katomic_store_i64(&d->bottom, b + 1, KATOMIC_RELAXED);
+        return false;
+    }
+
+    *out_job = d->jobs[b & d->mask];
+    if (t == b) {
+        // last job, so this races against any thieves. whoever moves top wins it
+        b8 won = katomic_compare_exchange_i64(&d->top, &t, t + 1, KATOMIC_SEQ_CST);
+        katomic_store_i64(&d->bottom, b + 1, KATOMIC_RELAXED);
+        return won;
+    }
+    return true;
+}
+
+static b8 deque_steal(job_deque* d, job_info* out_job) {
+    i64 t = katomic_load_i64(&d->top, KATOMIC_ACQUIRE);
+    katomic_thread_fence(KATOMIC_SEQ_CST);
+    i64 b = katomic_load_i64(&d->bottom, KATOMIC_ACQUIRE);
+    if (t >= b) {
+        return false;
+    }
+
+    // copy out before claiming it. if the claim fails the copy may be torn, but it is thrown away anyway
+    job_info job = d->jobs[t & d->mask];
+    if (!katomic_compare_exchange_i64(&d->top, &t, t + 1, KATOMIC_SEQ_CST)) {
+        return false;
+    }
+    *out_job = job;
+    return true;
+}
+// NOTE: end deque
+
+// NOTE: begin injection queue
+static b8 queue_push(job_queue* q, const job_info* job) {
+    kmutex_lock(&q->lock);
+    b8 result = false;
+    if ((u32)q->count < q->capacity) {
+        q->jobs[(q->head + q->count) % q->capacity] = *job;
+        q->count++;
+        result = true;
+    }
+    kmutex_unlock(&q->lock);
+    return result;
+}
+
+static b8 queue_pop(job_queue* q, job_info* out_job) {
+    // cheap early out so idle workers dont fight over the lock
+    if (katomic_load_i32(&q->count, KATOMIC_RELAXED) == 0) {
+        return false;
+    }
+    kmutex_lock(&q->lock);
+    b8 result = false;
+    if (q->count > 0) {
+        *out_job = q->jobs[q->head];
+        q->head = (q->head + 1) % q->capacity;
+        q->count--;
+        result = true;
+    }
+    kmutex_unlock(&q->lock);
+    return result;
+}
+// NOTE: end injection queue
+
+// moves everything in the completion queue over to the spilled list, leaving the callbacks for job_system_update. must
+// be called on the main thread
+static void spill_completions() {
+    kmutex_lock(&state_ptr->completion_lock);
+    while (state_ptr->completion_count > 0) {
+        darray_push(state_ptr->spilled_completions, state_ptr->completions[state_ptr->completion_head]);
+        state_ptr->completion_head = (state_ptr->completion_head + 1) % state_ptr->queue_capacity;
+        state_ptr->completion_count--;
+    }
+    kmutex_unlock(&state_ptr->completion_lock);
+}
+
+static void queue_completion(const job_info* job) {
+    job_completion completion = {job->on_complete, job->params};
+    while (true) {
+        kmutex_lock(&state_ptr->completion_lock);
+        if (state_ptr->completion_count < state_ptr->queue_capacity) {
+            u32 index = (state_ptr->completion_head + state_ptr->completion_count) % state_ptr->queue_capacity;
+            state_ptr->completions[index] = completion;
+            state_ptr->completion_count++;
+            kmutex_unlock(&state_ptr->completion_lock);
+            return;
+        }
+        kmutex_unlock(&state_ptr->completion_lock);
+        if (kthread_get_current_id() == state_ptr->main_thread_id) {
+            // the main thread is the one that empties the queue, so it can't wait on itself. this may well be deep
+            // inside a wait, so make room without running anything
+            spill_completions();
+        } else {
+            // full, wait for the main thread to catch up
+            kthread_yield();
+        }
+    }
+}
+
+static void run_job(const job_info* job) {
+    // NOTE: a fiber job that parks part way through is recorded against whichever thread finishes it
+    KPROFILE_BEGIN(job_scope, "job");
+    job->entry_point(job->params);
+    KPROFILE_END(job_scope);
+
+    if (job->on_complete) {
+        if (state_ptr) {
+            queue_completion(job);
+        } else {
+            job->on_complete(job->params);
+        }
+    }
+
+    // done last, as whoever is waiting on the counter is free to clean up as soon as it hits zero
+    if (job->counter) {
+        job_counter_decrement(job->counter);
+    }
+}
+
+// NOTE: begin fibers
+static job_fiber* acquire_fiber() {
+    job_fiber* fiber = 0;
+    kmutex_lock(&state_ptr->fiber_lock);
+    if (state_ptr->free_fiber_count > 0) {
+        fiber = state_ptr->free_fibers[--state_ptr->free_fiber_count];
+    }
+    kmutex_unlock(&state_ptr->fiber_lock);
+    return fiber;
+}
+
+// called on the worker once a fiber has switched back to it
+static void park_or_release_fiber(job_fiber* fiber) {
+    kmutex_lock(&state_ptr->fiber_lock);
+    if (fiber->status == JOB_FIBER_STATUS_DONE) {
+        state_ptr->free_fibers[state_ptr->free_fiber_count++] = fiber;
+    } else {
+        // only now is the fiber fully switched out, so only now is it safe for another worker to pick it up
+        state_ptr->waiting_fibers[state_ptr->waiting_fiber_count] = fiber;
+        katomic_fetch_add_i32(&state_ptr->waiting_fiber_count, 1, KATOMIC_RELEASE);
+    }
+    kmutex_unlock(&state_ptr->fiber_lock);
+}
+
+// takes the oldest parked fiber of the given priority that is ready to continue. fibers that were waiting on a counter
+// and fibers that yielded are looked for separately, so yields can go to the back of the line
+static job_fiber* take_ready_fiber(job_priority priority, b8 yielded) {
+    if (katomic_load_i32(&state_ptr->waiting_fiber_count, KATOMIC_ACQUIRE) == 0) {
+        return 0;
+    }
+
+    job_fiber* result = 0;
+    kmutex_lock(&state_ptr->fiber_lock);
+    u32 count = (u32)state_ptr->waiting_fiber_count;
+    for (u32 i = 0; i < count; ++i) {
+        job_fiber* fiber = state_ptr->waiting_fibers[i];
+        if (fiber->job.priority != priority || (fiber->waiting_on == 0) != yielded) {
+            continue;
+        }
+        if (fiber->waiting_on && katomic_load_i32(&fiber->waiting_on->value, KATOMIC_ACQUIRE) > 0) {
+            continue;
+        }
+        // keep the rest in order
+        for (u32 j = i; j < count - 1; ++j) {
+            state_ptr->waiting_fibers[j] = state_ptr->waiting_fibers[j + 1];
+        }
+        katomic_fetch_add_i32(&state_ptr->waiting_fiber_count, -1, KATOMIC_RELEASE);
+        result = fiber;
+        break;
+    }
+    kmutex_unlock(&state_ptr->fiber_lock);
+    return result;
+}
+
+// switches from the worker thread over to the fiber, and deals with it once it switches back
+static void resume_fiber(job_fiber* fiber) {
+    job_worker* worker = &state_ptr->workers[get_current_worker_index()];
+    fiber->status = JOB_FIBER_STATUS_RUNNING;
+    fiber->waiting_on = 0;
+    set_current_fiber(fiber);
+    kfiber_switch(&worker->thread_fiber, &fiber->fiber);
+    set_current_fiber(0);
+    park_or_release_fiber(fiber);
+}
+
+// switches from the running fiber back to whichever worker thread it is currently running on
+static void suspend_fiber(job_fiber* fiber) {
+    job_worker* worker = &state_ptr->workers[get_current_worker_index()];
+    kfiber_switch(&fiber->fiber, &worker->thread_fiber);
+}
+
+static void job_fiber_entry(void* params) {
+    job_fiber* fiber = params;
+    // fibers are reused, so this never ends. each time through runs whatever job was handed to the fiber
+    while (true) {
+        run_job(&fiber->job);
+        fiber->status = JOB_FIBER_STATUS_DONE;
+        suspend_fiber(fiber);
+    }
+}
+// NOTE: end fibers
+
+// runs a job that was just picked up, on a fiber if it asked for one and one can be had. otherwise directly
+static void execute_job(i32 worker_index, job_info* job) {
+    if (job->use_fiber && worker_index >= 0 && !get_current_fiber() && state_ptr->workers[worker_index].thread_fiber.internal_data) {
+        job_fiber* fiber = acquire_fiber();
+        if (fiber) {
+            fiber->job = *job;
+            resume_fiber(fiber);
+            return;
+        }
+    }
+    run_job(job);
+}
+
+// looks for work, highest priority first. within a priority: parked fibers that are ready to continue, own queue, the
+// shared queue, stealing from other workers and finally fibers that yielded. fibers can only be picked up by workers,
+// so out_fiber is only ever set when worker_index is valid and this thread is not already on a fiber
+static b8 find_work(i32 worker_index, job_info* out_job, job_fiber** out_fiber) {
+    b8 can_resume = out_fiber && worker_index >= 0 && !get_current_fiber();
+    for (u32 p = 0; p < JOB_PRIORITY_MAX; ++p) {
+        if (can_resume && (*out_fiber = take_ready_fiber(p, false))) {
+            return true;
+        }
+
+        if (worker_index >= 0 && deque_pop(&state_ptr->workers[worker_index].deques[p], out_job)) {
+            return true;
+        }
+
+        if (queue_pop(&state_ptr->injection_queues[p], out_job)) {
+            return true;
+        }
+
+        u32 start = 0;
+        if (worker_index >= 0) {
+            // xorshift, just to spread the thieves out
+            u32* seed = &state_ptr->workers[worker_index].steal_seed;
+            *seed ^= *seed << 13;
+            *seed ^= *seed >> 17;
+            *seed ^= *seed << 5;
+            start = *seed % state_ptr->worker_count;
+        }
+        for (u32 i = 0; i < state_ptr->worker_count; ++i) {
+            u32 victim = (start + i) % state_ptr->worker_count;
+            if ((i32)victim == worker_index) {
+                continue;
+            }
+            if (deque_steal(&state_ptr->workers[victim].deques[p], out_job)) {
+                return true;
+            }
+        }
+
+        if (can_resume && (*out_fiber = take_ready_fiber(p, true))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// finds and runs one piece of work. returns false if there was nothing to do
+static b8 do_work(i32 worker_index) {
+    job_info job;
+    job_fiber* fiber = 0;
+    if (!find_work(worker_index, &job, &fiber)) {
+        return false;
+    }
+    if (fiber) {
+        resume_fiber(fiber);
+    } else {
+        execute_job(worker_index, &job);
+    }
+    return true;
+}
+
+static u32 job_worker_thread_run(void* params) {
+    job_worker* worker = params;
+    current_worker_index = (i32)worker->index;
+
+    char name[16];
+    string_format(name, "kohi_job_%u", worker->index);
+    profiler_set_thread_name(name);
+    if (state_ptr->fiber_count > 0 && !kfiber_create_from_thread(&worker->thread_fiber)) {
+        KWARN("Job worker %u could not create its thread fiber, fiber jobs will run directly on it instead.", worker->index);
+    }
+    KTRACE("Job worker %u started.", worker->index);
+
+    while (katomic_load_i32(&state_ptr->running, KATOMIC_ACQUIRE)) {
+        if (!do_work(current_worker_index)) {
+            // one signal is posted per job, so this only wakes once there is (probably) something to do. parked fibers
+            // can also be released by counters that are not decremented by jobs, so check back regularly while there are any
+            b8 fibers_waiting = katomic_load_i32(&state_ptr->waiting_fiber_count, KATOMIC_ACQUIRE) > 0;
+            ksemaphore_wait(&state_ptr->work_available, fibers_waiting ? 1 : KSEMAPHORE_WAIT_INFINITE);
+        }
+    }
+
+    kfiber_destroy_from_thread(&worker->thread_fiber);
+    KTRACE("Job worker %u stopped.", worker->index);
+    return 0;
+}
+
+b8 job_system_initialize(u64* memory_requirement, void* state, job_system_config config) {
+    u32 worker_count = config.worker_count;
+    if (worker_count == 0) {
+        i32 processor_count = platform_get_processor_count();
+        worker_count = processor_count > 1 ? (u32)(processor_count - 1) : 1;
+    }
+    u32 capacity = round_up_pow2(config.max_job_count > 0 ? config.max_job_count : 1024);
+
+    // the state, then the workers, then every worker's deques, then the injection queues, the completion queue and
+    // finally the fiber pool. fiber stacks are allocated by the platform layer
+    u64 workers_size = sizeof(job_worker) * worker_count;
+    u64 deques_size = sizeof(job_info) * capacity * JOB_PRIORITY_MAX * worker_count;
+    u64 injection_size = sizeof(job_info) * capacity * JOB_PRIORITY_MAX;
+    u64 completion_size = sizeof(job_completion) * capacity;
+    u64 fibers_size = (sizeof(job_fiber) + sizeof(job_fiber*) * 2) * config.fiber_count;
+    *memory_requirement = sizeof(job_system_state) + workers_size + deques_size + injection_size + completion_size + fibers_size;
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->worker_count = worker_count;
+    state_ptr->queue_capacity = capacity;
+    state_ptr->main_thread_id = kthread_get_current_id();
+
+    u8* block = (u8*)state + sizeof(job_system_state);
+    state_ptr->workers = (job_worker*)block;
+    block += workers_size;
+    for (u32 i = 0; i < worker_count; ++i) {
+        job_worker* worker = &state_ptr->workers[i];
+        worker->index = i;
+        worker->steal_seed = 0x9E3779B9u * (i + 1);
+        for (u32 p = 0; p < JOB_PRIORITY_MAX; ++p) {
+            worker->deques[p].mask = capacity - 1;
+            worker->deques[p].jobs = (job_info*)block;
+            block += sizeof(job_info) * capacity;
+        }
+    }
+    for (u32 p = 0; p < JOB_PRIORITY_MAX; ++p) {
+        job_queue* q = &state_ptr->injection_queues[p];
+        q->capacity = capacity;
+        q->jobs = (job_info*)block;
+        block += sizeof(job_info) * capacity;
+        if (!kmutex_create(&q->lock)) {
+            KERROR("job_system_initialize - failed to create injection queue mutex.");
+            return false;
+        }
+    }
+    state_ptr->completions = (job_completion*)block;
+    block += completion_size;
+
+    state_ptr->spilled_completions = darray_create(job_completion);
+    if (!kmutex_create(&state_ptr->completion_lock) || !ksemaphore_create(0, &state_ptr->work_available) || !kmutex_create(&state_ptr->fiber_lock)) {
+        KERROR("job_system_initialize - failed to create synchronization objects.");
+        return false;
+    }
+
+    state_ptr->fibers = (job_fiber*)block;
+    block += sizeof(job_fiber) * config.fiber_count;
+    state_ptr->free_fibers = (job_fiber**)block;
+    block += sizeof(job_fiber*) * config.fiber_count;
+    state_ptr->waiting_fibers = (job_fiber**)block;
+    u64 stack_size = config.fiber_stack_size > 0 ? config.fiber_stack_size : KIBIBYTES(256);
+    for (u32 i = 0; i < config.fiber_count; ++i) {
+        job_fiber* fiber = &state_ptr->fibers[state_ptr->fiber_count];
+        if (!kfiber_create(stack_size, job_fiber_entry, fiber, &fiber->fiber)) {
+            // not fatal, fiber jobs just run directly on the workers instead
+            KWARN("job_system_initialize - fibers are not available, only %u of %u were created.", i, config.fiber_count);
+            break;
+        }
+        state_ptr->free_fibers[state_ptr->free_fiber_count++] = fiber;
+        state_ptr->fiber_count++;
+    }
+
+    state_ptr->running = true;
+    for (u32 i = 0; i < worker_count; ++i) {
+        if (!kthread_create(job_worker_thread_run, &state_ptr->workers[i], &state_ptr->workers[i].thread)) {
+            KFATAL("job_system_initialize - failed to start worker thread %u.", i);
+            state_ptr->worker_count = i;
+            job_system_shutdown(state);
+            return false;
+        }
+        char name[16];
+        string_format(name, "kohi_job_%u", i);
+        kthread_set_name(&state_ptr->workers[i].thread, name);
+    }
+
+    KINFO("Job system started with %u worker threads and %u fibers.", worker_count, state_ptr->fiber_count);
+    return true;
+}
+
+void job_system_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+
+    katomic_store_i32(&state_ptr->running, false, KATOMIC_RELEASE);
+    // wake everybody up so they see they should stop
+    for (u32 i = 0; i < state_ptr->worker_count; ++i) {
+        ksemaphore_signal(&state_ptr->work_available);
+    }
+    for (u32 i = 0; i < state_ptr->worker_count; ++i) {
+        kthread_wait(&state_ptr->workers[i].thread);
+    }
+
+    // anything left over is dropped, but let it be known. their counters are still let go of, so nothing is left
+    // waiting forever on a job that will never run
+    u32 dropped = 0;
+    job_info job;
+    while (find_work(-1, &job, 0)) {
+        if (job.counter) {
+            job_counter_decrement(job.counter);
+        }
+        dropped++;
+    }
+    if (dropped > 0) {
+        KWARN("Job system shut down with %u jobs still queued. They were not run.", dropped);
+    }
+    if (state_ptr->waiting_fiber_count > 0) {
+        KWARN("Job system shut down with %d fiber jobs still waiting. They were not finished.", state_ptr->waiting_fiber_count);
+        for (i32 i = 0; i < state_ptr->waiting_fiber_count; ++i) {
+            if (state_ptr->waiting_fibers[i]->job.counter) {
+                job_counter_decrement(state_ptr->waiting_fibers[i]->job.counter);
+            }
+        }
+    }
+
+    for (u32 i = 0; i < state_ptr->fiber_count; ++i) {
+        kfiber_destroy(&state_ptr->fibers[i].fiber);
+    }
+    kmutex_destroy(&state_ptr->fiber_lock);
+
+    for (u32 p = 0; p < JOB_PRIORITY_MAX; ++p) {
+        kmutex_destroy(&state_ptr->injection_queues[p].lock);
+    }
+    kmutex_destroy(&state_ptr->completion_lock);
+    if (state_ptr->spilled_completions) {
+        darray_destroy(state_ptr->spilled_completions);
+    }
+    ksemaphore_destroy(&state_ptr->work_available);
+
+    state_ptr = 0;
+}
+
+void job_system_update() {
+    if (!state_ptr) {
+        return;
+    }
+
+    // anything spilled finished before whatever is still queued, so goes first. callbacks can wait on jobs of their
+    // own and spill more on the end, so keep going until the list is empty
+    while (state_ptr->spilled_head < darray_length(state_ptr->spilled_completions)) {
+        job_completion completion = state_ptr->spilled_completions[state_ptr->spilled_head++];
+        completion.on_complete(completion.params);
+    }
+    state_ptr->spilled_head = 0;
+    darray_length_set(state_ptr->spilled_completions, 0);
+
+    // take one at a time, so callbacks are free to submit more jobs
+    while (true) {
+        job_completion completion;
+        kmutex_lock(&state_ptr->completion_lock);
+        if (state_ptr->completion_count == 0) {
+            kmutex_unlock(&state_ptr->completion_lock);
+            break;
+        }
+        completion = state_ptr->completions[state_ptr->completion_head];
+        state_ptr->completion_head = (state_ptr->completion_head + 1) % state_ptr->queue_capacity;
+        state_ptr->completion_count--;
+        kmutex_unlock(&state_ptr->completion_lock);
+
+        completion.on_complete(completion.params);
+    }
+}
+
+job_info job_create(pfn_job_entry entry_point, void* params, job_priority priority) {
+    job_info info = {};
+    info.entry_point = entry_point;
+    info.params = params;
+    info.priority = priority;
+    return info;
+}
+
+void job_system_submit(job_info info) {
+    if (!info.entry_point) {
+        KERROR("job_system_submit - a job requires an entry point.");
+        return;
+    }
+    if (info.priority >= JOB_PRIORITY_MAX) {
+        info.priority = JOB_PRIORITY_LOW;
+    }
+    if (info.counter) {
+        job_counter_increment(info.counter);
+    }
+
+    if (!state_ptr || !state_ptr->running) {
+        // nothing to hand it to, so just do it now
+        run_job(&info);
+        return;
+    }
+
+    b8 queued = false;
+    if (current_worker_index >= 0) {
+        queued = deque_push(&state_ptr->workers[current_worker_index].deques[info.priority], &info);
+    }
+    if (!queued) {
+        queued = queue_push(&state_ptr->injection_queues[info.priority], &info);
+    }
+    if (!queued) {
+        // not an error, just back pressure. the submitting thread does the work itself rather than wait for room
+        KTRACE("job_system_submit - job queues are full, running job on the submitting thread.");
+        run_job(&info);
+        return;
+    }
+
+    ksemaphore_signal(&state_ptr->work_available);
+}
+
+void job_system_submit_batch(const job_info* jobs, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        job_system_submit(jobs[i]);
+    }
+}
+
+void job_counter_increment(job_counter* counter) {
+    katomic_fetch_add_i32(&counter->value, 1, KATOMIC_ACQ_REL);
+}
+
+void job_counter_decrement(job_counter* counter) {
+    i32 previous = katomic_fetch_add_i32(&counter->value, -1, KATOMIC_ACQ_REL);
+    // a parked fiber may have been waiting on this, so make sure a worker is awake to pick it up
+    if (previous == 1 && state_ptr && katomic_load_i32(&state_ptr->waiting_fiber_count, KATOMIC_ACQUIRE) > 0) {
+        ksemaphore_signal(&state_ptr->work_available);
+    }
+}
+
+void job_system_wait(job_counter* counter) {
+    if (!counter) {
+        return;
+    }
+
+    job_fiber* fiber = state_ptr ? get_current_fiber() : 0;
+    if (fiber) {
+        // park the fiber and let the worker get on with something else. it gets picked back up (by whichever worker
+        // gets there first) once the counter hits zero
+        while (katomic_load_i32(&counter->value, KATOMIC_ACQUIRE) > 0) {
+            fiber->status = JOB_FIBER_STATUS_WAITING;
+            fiber->waiting_on = counter;
+            suspend_fiber(fiber);
+        }
+        return;
+    }
+
+    while (katomic_load_i32(&counter->value, KATOMIC_ACQUIRE) > 0) {
+        if (state_ptr && do_work(get_current_worker_index())) {
+            // helped out rather than sit idle. whatever was picked up may well have been what is being waited on
+        } else {
+            // the jobs being waited on are running on other threads. if the main thread is the one waiting make room
+            // in the completion queue so workers are never stuck on it, but leave the callbacks for job_system_update
+            if (state_ptr && kthread_get_current_id() == state_ptr->main_thread_id) {
+                spill_completions();
+            }
+            kthread_yield();
+        }
+    }
+}
+
+void job_system_yield() {
+    job_fiber* fiber = state_ptr ? get_current_fiber() : 0;
+    if (!fiber) {
+        return;
+    }
+    fiber->status = JOB_FIBER_STATUS_WAITING;
+    fiber->waiting_on = 0;
+    suspend_fiber(fiber);
+}
+
+b8 job_system_is_on_fiber() {
+    return state_ptr && get_current_fiber() != 0;
+}
+
+u32 job_system_worker_count() {
+    return state_ptr ? state_ptr->worker_count : 0;
+}
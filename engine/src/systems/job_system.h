@@ -0,0 +1,104 @@
+#pragma once
+
+#include "defines.h"
+
+// @brief the work a job performs. called on whichever thread picks the job up, usually a worker thread
+typedef void (*pfn_job_entry)(void* params);
+
+// @brief called on the main thread (from job_system_update) once a job has finished
+typedef void (*pfn_job_on_complete)(void* params);
+
+// @brief the priority a job runs at. every higher priority job that can be found is run before a lower one is started
+typedef enum job_priority {
+    // @brief work something is actively waiting on, i.e. the current frame
+    JOB_PRIORITY_HIGH = 0,
+    JOB_PRIORITY_NORMAL = 1,
+    // @brief background work, like streaming in assets
+    JOB_PRIORITY_LOW = 2,
+    JOB_PRIORITY_MAX = 3
+} job_priority;
+
+// @brief used to wait on (fan in) a group of jobs. each job submitted with a counter increments it, and decrements it
+// again once finished. zero it before first use. a counter must outlive every job submitted with it
+typedef struct job_counter {
+    volatile i32 value;
+} job_counter;
+
+// @brief everything needed to run a job. copied on submit, so it can live on the stack
+typedef struct job_info {
+    // @brief the function to run. required
+    pfn_job_entry entry_point;
+    // @brief passed to both entry_point and on_complete. must stay valid until both have been called
+    void* params;
+    job_priority priority;
+    // @brief optional counter to track this job with
+    job_counter* counter;
+    // @brief optional function to run on the main thread after the job finishes
+    pfn_job_on_complete on_complete;
+    // @brief run the job on its own fiber. waiting (job_system_wait) or yielding (job_system_yield) inside a fiber job
+    // parks the fiber and frees up the worker thread, instead of tying it up. meant for long running jobs like loaders.
+    // if no fiber is free, or the job ends up run by a non worker thread, it runs directly on the thread instead
+    b8 use_fiber;
+} job_info;
+
+typedef struct job_system_config {
+    // @brief the number of worker threads to start. 0 uses one less than the processor count, leaving a core for the main thread
+    u8 worker_count;
+    // @brief the max number of jobs each worker can have queued per priority. rounded up to a power of 2
+    u32 max_job_count;
+    // @brief the number of fibers to create for fiber jobs, which is how many can be in flight (running or parked) at once. 0 disables fibers
+    u32 fiber_count;
+    // @brief the stack size of each fiber in bytes. 0 uses a default of 256KiB
+    u64 fiber_stack_size;
+} job_system_config;
+
+// initialize the job system, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
+// on the second pass - pass in the state as well as the memory requirement and actually initialize the system, starting the worker threads
+KAPI b8 job_system_initialize(u64* memory_requirement, void* state, job_system_config config);
+
+// shut down the job system. stops and joins the worker threads. anything still queued is dropped without being run,
+// or its on_complete called, but its counter is still decremented so nothing is left waiting on it
+KAPI void job_system_shutdown(void* state);
+
+// @brief runs the on_complete callbacks of any finished jobs, in the order they finished. must be called on the main
+// thread, once per frame. this is the only place callbacks are run from, never from inside job_system_wait
+KAPI void job_system_update();
+
+// @brief creates a job info with the given entry point, params and priority, and no counter or completion callback
+KAPI job_info job_create(pfn_job_entry entry_point, void* params, job_priority priority);
+
+// @brief submits a job to be run. if called from a worker thread the job goes onto that worker's own queue, otherwise
+// it is handed to whichever worker gets to it first. if the job system is not running, the job is run immediately
+// @param info the job to submit. copied, so it does not need to outlive this call
+KAPI void job_system_submit(job_info info);
+
+// @brief submits a number of jobs at once
+// @param jobs an array of jobs to submit
+// @param count the number of jobs in the array
+KAPI void job_system_submit_batch(const job_info* jobs, u32 count);
+
+// @brief blocks until the given counter reaches zero. inside a fiber job the fiber is parked until then. anywhere else
+// the calling thread runs other queued jobs while it waits, rather than sleeping. safe to call from inside any job.
+// on_complete callbacks are not run while waiting, not even on the main thread
+// @param counter the counter to wait on
+KAPI void job_system_wait(job_counter* counter);
+
+// @brief adds one to a counter for work that is not a job, like a file read, so that it can be waited on with
+// job_system_wait in the same way. pair each call with a job_counter_decrement once the work is done
+// @param counter the counter to increment
+KAPI void job_counter_increment(job_counter* counter);
+
+// @brief takes one from a counter once work added with job_counter_increment is done. safe to call from any thread.
+// wakes up anything parked waiting on the counter
+// @param counter the counter to decrement
+KAPI void job_counter_decrement(job_counter* counter);
+
+// @brief when running inside a fiber job, parks the fiber to let other work at the same (or a higher) priority run
+// first. long running fiber jobs should call this every so often. does nothing anywhere else
+KAPI void job_system_yield();
+
+// @brief indicates if the calling code is running inside a fiber job
+KAPI b8 job_system_is_on_fiber();
+
+// @brief obtains the number of worker threads running, 0 if the job system is not running
+KAPI u32 job_system_worker_count();
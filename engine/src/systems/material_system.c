@@ -2,6 +2,7 @@
 
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "core/profiler.h"
 #include "containers/hashtable.h"
 #include "math/kmath.h"
 #include "renderer/renderer_frontend.h"
@@ -313,6 +314,42 @@ void material_system_release(const char* name) {
     }
 }
 
+material* material_system_get_loaded(const char* name) {
+    material_reference ref;
+    if (!state_ptr || !name || !hashtable_get(&state_ptr->registered_material_table, name, &ref) || ref.handle == INVALID_ID) {
+        return 0;
+    }
+    material* m = &state_ptr->registered_materials[ref.handle];
+    // the table does not handle collisions, so make sure it is the right one
+    return strings_equali(m->name, name) ? m : 0;
+}
+
+b8 material_system_reload_from_config(const material_config* config) {
+    KPROFILE_SCOPE("material_system_reload_from_config");
+    material* m = material_system_get_loaded(config->name);
+    if (!m) {
+        return false;
+    }
+
+    // load the new one alongside the old, so textures used by both are never released in between, and a material that
+    // fails to load leaves the old one in place
+    material loaded;
+    if (!load_material(*config, &loaded)) {
+        KERROR("material_system_reload_from_config - failed to reload material '%s', keeping the old one.", config->name);
+        destroy_material(&loaded);
+        return false;
+    }
+
+    material old = *m;
+    *m = loaded;
+    m->id = old.id;
+    m->generation = old.generation + 1;
+    // the instance is new, so it has to be applied in full before its first draw
+    m->render_frame_number = INVALID_ID;
+    destroy_material(&old);
+    return true;
+}
+
 // get the default material
 material* material_system_get_default() {
     if (state_ptr) {
@@ -335,6 +372,7 @@ material* material_system_get_default() {
 // @param view a constant pointer to a view matrix
 // @return true on success, otherwise false
 b8 material_system_apply_global(u32 shader_id, u64 renderer_frame_number, const mat4* projection, const mat4* view, const vec4* ambient_colour, const vec3* view_position, u32 render_mode) {
+    KPROFILE_SCOPE("material_system_apply_global");
     shader* s = shader_system_get_by_id(shader_id);
     if (!s) {
         return false;
@@ -366,6 +404,7 @@ b8 material_system_apply_global(u32 shader_id, u64 renderer_frame_number, const
 // @param m a pointer to the material to be applied
 // @return true on success; otherwise false
 b8 material_system_apply_instance(material* m, b8 needs_update) {
+    KPROFILE_SCOPE("material_system_apply_instance");
     // apply instance level uniforms
     MATERIAL_APPLY_OR_FAIL(shader_system_bind_instance(m->internal_id));
     if (needs_update) {
@@ -395,6 +434,7 @@ b8 material_system_apply_instance(material* m, b8 needs_update) {
 // @param model a constant pointer to the model matrix to be applied
 // @return true on success, otherwise false
 b8 material_system_apply_local(material* m, const mat4* model) {
+    KPROFILE_SCOPE("material_system_apply_local");
     if (m->shader_id == state_ptr->material_shader_id) {
         return shader_system_uniform_set_by_index(state_ptr->material_locations.model, model);
     } else if (m->shader_id == state_ptr->ui_shader_id) {
@@ -407,6 +447,8 @@ b8 material_system_apply_local(material* m, const mat4* model) {
 
 b8 load_material(material_config config, material* m) {
     kzero_memory(m, sizeof(material));
+    // so a load that fails part way can still be destroyed
+    m->internal_id = INVALID_ID;
 
     // name
     string_ncopy(m->name, config.name, MATERIAL_NAME_MAX_LENGTH);
@@ -28,6 +28,18 @@ material* material_system_acquire_from_config(material_config config);
 // release a material by name
 void material_system_release(const char* name);
 
+// @brief gets a material that has already been loaded, without taking a reference to it
+// @param name the name of the material
+// @return a pointer to the material, or 0 if no material of that name is loaded
+material* material_system_get_loaded(const char* name);
+
+// @brief replaces a loaded material with a new config, for when the file it came from has changed. the material stays at
+// the same address, so anything using it sees the change, and its generation goes up by one
+// @param config the new config. its name picks the material to replace
+// @return true on success. false if no material of that name is loaded, or the new one failed to load, which leaves the
+// old one as it was
+b8 material_system_reload_from_config(const material_config* config);
+
 // get the default material
 material* material_system_get_default();
 
@@ -2,6 +2,15 @@
 
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "core/kmemory.h"
+#include "core/kmutex.h"
+#include "core/katomic.h"
+#include "core/xxhash.h"
+#include "systems/vfs_system.h"
+#include "systems/job_system.h"
+#include "systems/geometry_system.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
 
 // known resource loaders
 #include "resources/loaders/text_loader.h"
@@ -11,10 +20,113 @@
 #include "resources/loaders/shader_loader.h"
 #include "resources/loaders/mesh_loader.h"
 
+// one async load, from being queued until its callback has run
+typedef struct resource_load_slot {
+    // bumped each time the slot is reused, so stale handles can be told apart
+    u32 generation;
+    b8 in_use;
+    // where it sits in the queue, or INVALID_ID once it has been started
+    u32 queue_index;
+    // the order it was requested in, so loads of the same priority go first come first served
+    u64 sequence;
+    job_priority priority;
+    resource_loader* loader;
+    pfn_resource_load_complete callback;
+    void* user_data;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    u8 params[RESOURCE_LOAD_MAX_PARAMS_SIZE];
+    b8 has_params;
+
+    // written by the job. cancelled is written by whoever cancels
+    volatile b8 cancelled;
+    volatile b8 finished;
+    b8 success;
+    resource resource;
+} resource_load_slot;
+
+// what a cached resource is looked up by. the loader stands in for the type
+typedef struct resource_cache_key {
+    u64 hash;
+    u32 loader_id;
+    const char* name;
+    u64 name_length;
+    // zeroed past params_size, and all zeroes when loaded with no params
+    u8 params[RESOURCE_LOAD_MAX_PARAMS_SIZE];
+    u64 params_size;
+} resource_cache_key;
+
+// one resource held by the cache, loaded or not
+typedef struct resource_cache_entry {
+    b8 in_use;
+    // invalidated while still loaded. it can no longer be found, and is unloaded once the last holder lets go
+    b8 orphaned;
+    u64 hash;
+    // the next entry in the same bucket, or the next free entry. INVALID_ID at the end
+    u32 next;
+    // neighbours in the lru list, which holds the entries nobody has loaded
+    u32 lru_prev;
+    u32 lru_next;
+    u32 reference_count;
+    // roughly how much memory the resource holds, as counted against the budget
+    u64 memory_size;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    u8 params[RESOURCE_LOAD_MAX_PARAMS_SIZE];
+    resource resource;
+} resource_cache_entry;
+
+// a custom loader, by name
+typedef struct resource_custom_type_slot {
+    u32 hash;
+    // INVALID_ID if the slot is empty
+    u32 loader_id;
+    // the loader's custom_type points here
+    char name[RESOURCE_CUSTOM_TYPE_MAX_LENGTH];
+} resource_custom_type_slot;
+
+// the running totals behind resource_loader_stats. bumped from whichever thread does the load
+typedef struct resource_loader_counters {
+    volatile i64 load_count;
+    volatile i64 failed_count;
+    volatile i64 cache_hit_count;
+    volatile i64 bytes_read;
+    volatile i64 load_time_ns;
+} resource_loader_counters;
+
 // store the state for the resource system
 typedef struct resource_system_state {
     resource_system_config config;        // configuration settings
     resource_loader* registered_loaders;  // pointer to an array of loaders(img, txt, ect)
+    resource_loader_counters* loader_counters;
+    // loaders are never unregistered, so they fill registered_loaders from the front
+    u32 loader_count;
+    // the loader id for each type short of custom, or INVALID_ID
+    u32 type_loaders[RESOURCE_TYPE_CUSTOM];
+    // custom loaders by name, open addressed. a power of 2 in count, and at most half full
+    resource_custom_type_slot* custom_types;
+    u32 custom_type_slot_count;
+
+    // NOTE: everything below is guarded by load_lock
+    kmutex load_lock;
+    resource_load_slot* load_slots;
+    // a binary heap of the slots waiting to start, highest priority (then oldest) at the top
+    u32* load_queue;
+    u32 load_queue_count;
+    u32 in_flight_count;
+    u32 pending_count;
+    u64 next_sequence;
+
+    // NOTE: everything below is guarded by cache_lock
+    kmutex cache_lock;
+    resource_cache_entry* cache_entries;
+    // the first entry of each bucket, or INVALID_ID. a power of 2 in count
+    u32* cache_buckets;
+    u32 cache_bucket_count;
+    u32 cache_free_head;
+    // least recently used at the head
+    u32 cache_lru_head;
+    u32 cache_lru_tail;
+    u32 cache_entry_count;
+    u64 cache_memory_size;
 } resource_system_state;
 
 // pointer to the state for internal use
@@ -23,6 +135,10 @@ static resource_system_state* state_ptr = 0;
 // internal function that does the work of actually loading the files
 b8 load(const char* name, resource_loader* loader, void* params, resource* out_resource);
 
+static void resource_cache_flush();
+static void resource_cache_release(resource* resource);
+static void loader_stats_get(const resource_loader* loader, resource_loader_stats* out_stats);
+
 // initialize the resource system, will be handled in 2 steps, first stem the pointer to the state is not passed in, and the memory requirememnts are obtained
 // it actually initializes the second time the function is called, after memory has been allocated to hold the system
 b8 resource_system_initialize(u64* memory_requirement, void* state, resource_system_config config) {
@@ -31,26 +147,89 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
         return false;
     }
 
+    if (config.max_async_load_count == 0) {
+        config.max_async_load_count = 256;
+    }
+    if (config.max_cache_entry_count == 0) {
+        config.max_cache_entry_count = 1024;
+    }
+    // no cache, no need for the memory
+    if (config.cache_budget == 0) {
+        config.max_cache_entry_count = 0;
+    }
+    u32 bucket_count = 1;
+    while (bucket_count < config.max_cache_entry_count) {
+        bucket_count <<= 1;
+    }
+    u32 custom_type_slot_count = 1;
+    while (custom_type_slot_count < config.max_loader_count * 2) {
+        custom_type_slot_count <<= 1;
+    }
+
     // dereference the memory requirement and set to the size of a resource loader times the count of loaders plus the size of the state of the resource system
-    *memory_requirement = sizeof(resource_system_state) + (sizeof(resource_loader) * config.max_loader_count);
+    // and their counters and the custom type lookup, then the async load slots, and the queue of them, then the cache
+    // entries and their buckets
+    u64 loaders_size = sizeof(resource_loader) * config.max_loader_count;
+    u64 counters_size = sizeof(resource_loader_counters) * config.max_loader_count;
+    u64 custom_types_size = sizeof(resource_custom_type_slot) * custom_type_slot_count;
+    u64 slots_size = sizeof(resource_load_slot) * config.max_async_load_count;
+    u64 queue_size = sizeof(u32) * config.max_async_load_count;
+    u64 entries_size = sizeof(resource_cache_entry) * config.max_cache_entry_count;
+    u64 buckets_size = sizeof(u32) * bucket_count;
+    *memory_requirement = sizeof(resource_system_state) + loaders_size + counters_size + custom_types_size + slots_size + queue_size + entries_size + buckets_size;
 
     // if this is the first call, boot out after getting the required memory
     if (!state) {
         return true;
     }
 
+    if (config.max_concurrent_load_count == 0) {
+        u32 worker_count = job_system_worker_count();
+        config.max_concurrent_load_count = worker_count ? worker_count * 2 : 2;
+    }
+
     // pass through a pointer to the state, and the configuration settings
     state_ptr = state;
+    kzero_memory(state_ptr, *memory_requirement);
     state_ptr->config = config;
 
     void* array_block = state + sizeof(resource_system_state);  // set the pointer in the linear allocation for the array of loaders
     state_ptr->registered_loaders = array_block;                // save the pointer to the array in the state
+    state_ptr->loader_counters = (void*)((u8*)array_block + loaders_size);
+    state_ptr->custom_types = (void*)((u8*)state_ptr->loader_counters + counters_size);
+    state_ptr->custom_type_slot_count = custom_type_slot_count;
+    state_ptr->load_slots = (void*)((u8*)state_ptr->custom_types + custom_types_size);
+    state_ptr->load_queue = (void*)((u8*)state_ptr->load_slots + slots_size);
+    state_ptr->cache_entries = (void*)((u8*)state_ptr->load_queue + queue_size);
+    state_ptr->cache_buckets = (void*)((u8*)state_ptr->cache_entries + entries_size);
+    state_ptr->cache_bucket_count = bucket_count;
+    if (!kmutex_create(&state_ptr->load_lock) || !kmutex_create(&state_ptr->cache_lock)) {
+        KFATAL("resource_system_initialize - unable to create the resource system mutexes.");
+        return false;
+    }
+
+    // every entry starts on the free list
+    for (u32 i = 0; i < bucket_count; ++i) {
+        state_ptr->cache_buckets[i] = INVALID_ID;
+    }
+    for (u32 i = 0; i < config.max_cache_entry_count; ++i) {
+        state_ptr->cache_entries[i].next = i + 1 < config.max_cache_entry_count ? i + 1 : INVALID_ID;
+    }
+    state_ptr->cache_free_head = config.max_cache_entry_count ? 0 : INVALID_ID;
+    state_ptr->cache_lru_head = INVALID_ID;
+    state_ptr->cache_lru_tail = INVALID_ID;
 
     // invalidate all loaders
     u32 count = config.max_loader_count;
     for (u32 i = 0; i < count; i++) {
         state_ptr->registered_loaders[i].id = INVALID_ID;
     }
+    for (u32 i = 0; i < RESOURCE_TYPE_CUSTOM; ++i) {
+        state_ptr->type_loaders[i] = INVALID_ID;
+    }
+    for (u32 i = 0; i < custom_type_slot_count; ++i) {
+        state_ptr->custom_types[i].loader_id = INVALID_ID;
+    }
 
     // NOTE: auto register known loader types here
     resource_system_register_loader(text_resource_loader_create());
@@ -60,6 +239,18 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
     resource_system_register_loader(shader_resource_loader_create());
     resource_system_register_loader(mesh_resource_loader_create());
 
+    // every loader finds its files through the vfs. later mounts win, so the archive goes first
+    b8 mounted = false;
+    if (config.archive_path && filesystem_exists(config.archive_path)) {
+        mounted = vfs_mount_archive(config.archive_path) || mounted;
+    }
+    if (config.asset_base_path && filesystem_exists(config.asset_base_path)) {
+        mounted = vfs_mount_directory(config.asset_base_path) || mounted;
+    }
+    if (!mounted) {
+        KWARN("resource_system_initialize - no assets found at '%s' or in an archive.", config.asset_base_path);
+    }
+
     KINFO("Resource system initialized with base path '%s'.", config.asset_base_path);
 
     return true;
@@ -68,53 +259,120 @@ b8 resource_system_initialize(u64* memory_requirement, void* state, resource_sys
 // shut down the resource system
 void resource_system_shutdown(void* state) {
     if (state_ptr) {
+        // the job system is already down by now, so any load that finished without its callback being run is cleaned up
+        // here. anything still queued or parked never loaded anything
+        for (u32 i = 0; i < state_ptr->config.max_async_load_count; ++i) {
+            resource_load_slot* slot = &state_ptr->load_slots[i];
+            if (slot->in_use && slot->finished && slot->success) {
+                resource_system_unload(&slot->resource);
+            }
+        }
+        resource_cache_flush();
+
+        for (u32 i = 0; i < state_ptr->loader_count; ++i) {
+            resource_loader_stats stats;
+            resource_loader* l = &state_ptr->registered_loaders[i];
+            loader_stats_get(l, &stats);
+            if (stats.load_count || stats.cache_hit_count) {
+                KDEBUG("Resource loader %u (%s): %llu loads (%llu failed), %llu cache hits, %.2f MiB read, %.3fs loading.", l->id, l->custom_type ? l->custom_type : l->type_path,
+                       stats.load_count, stats.failed_count, stats.cache_hit_count, (f64)stats.bytes_read / (f64)(MEBIBYTES(1)), stats.load_time);
+            }
+        }
+
+        kmutex_destroy(&state_ptr->cache_lock);
+        kmutex_destroy(&state_ptr->load_lock);
         state_ptr = 0;
     }
 }
 
+// NOTE: begin loader lookup
+
+// fnv-1a over the name lowercased, so it agrees with strings_equali
+static u32 custom_type_hash(const char* name) {
+    u32 hash = 2166136261u;
+    for (const char* c = name; *c; ++c) {
+        char lower = (*c >= 'A' && *c <= 'Z') ? (char)(*c + ('a' - 'A')) : *c;
+        hash = (hash ^ (u8)lower) * 16777619u;
+    }
+    return hash;
+}
+
+// the slot holding the name, or the empty slot it would go in
+static resource_custom_type_slot* custom_type_slot(const char* name, u32 hash) {
+    u32 mask = state_ptr->custom_type_slot_count - 1;
+    for (u32 i = hash & mask;; i = (i + 1) & mask) {
+        resource_custom_type_slot* slot = &state_ptr->custom_types[i];
+        if (slot->loader_id == INVALID_ID || (slot->hash == hash && strings_equali(slot->name, name))) {
+            return slot;
+        }
+    }
+}
+
+// the loader for a type, or 0. a table lookup for the built in types, a hash lookup for custom ones
+static resource_loader* loader_find(resource_type type, const char* custom_type) {
+    if ((u32)type < RESOURCE_TYPE_CUSTOM) {
+        u32 id = state_ptr->type_loaders[type];
+        return id != INVALID_ID ? &state_ptr->registered_loaders[id] : 0;
+    }
+    if (type != RESOURCE_TYPE_CUSTOM || !custom_type || !custom_type[0]) {
+        return 0;
+    }
+    resource_custom_type_slot* slot = custom_type_slot(custom_type, custom_type_hash(custom_type));
+    return slot->loader_id != INVALID_ID ? &state_ptr->registered_loaders[slot->loader_id] : 0;
+}
+
 // exported function to register a loader
 b8 resource_system_register_loader(resource_loader loader) {
-    if (state_ptr) {
-        u32 count = state_ptr->config.max_loader_count;
-        // ensure that no other loaders for the given type already exist
-        for (u32 i = 0; i < count; ++i) {                            // iterater through the array of loaders
-            resource_loader* l = &state_ptr->registered_loaders[i];  // get a pointer to the loader at index i
-            if (l->id != INVALID_ID) {                               // if there is a loader there
-                if (l->type == loader.type) {                        // if the input loader type matched the loader at index i
-                    KERROR("resource_system_register_loader - Loader of type %d already exists and will not be registered.", loader.type);
-                    return false;
-                } else if (loader.custom_type && string_length(loader.custom_type) > 0 && strings_equali(l->custom_type, loader.custom_type)) {  // or if it matches another custom type
-                    KERROR("resource_system_register_loader - Loader of custom type %s already exists and will not be registered.", loader.custom_type);
-                    return false;
-                }
-            }
+    if (!state_ptr) {
+        return false;
+    }
+    if (state_ptr->loader_count >= state_ptr->config.max_loader_count) {
+        KERROR("resource_system_register_loader - no room for another loader. Raise max_loader_count.");
+        return false;
+    }
+    u32 id = state_ptr->loader_count;
+
+    if ((u32)loader.type < RESOURCE_TYPE_CUSTOM) {
+        if (state_ptr->type_loaders[loader.type] != INVALID_ID) {
+            KERROR("resource_system_register_loader - Loader of type %d already exists and will not be registered.", loader.type);
+            return false;
         }
-        for (u32 i = 0; i < count; ++i) {  // iterate through the array of loaders looking for the first empty slot - one thats id is invalid id
-            if (state_ptr->registered_loaders[i].id == INVALID_ID) {
-                state_ptr->registered_loaders[i] = loader;  // copy the loader into the array
-                state_ptr->registered_loaders[i].id = i;    // id becomes index i
-                KTRACE("Loader registered.");
-                return true;
-            }
+        state_ptr->type_loaders[loader.type] = id;
+    } else if (loader.type == RESOURCE_TYPE_CUSTOM) {
+        u64 length = loader.custom_type ? string_length(loader.custom_type) : 0;
+        if (length == 0 || length >= RESOURCE_CUSTOM_TYPE_MAX_LENGTH) {
+            KERROR("resource_system_register_loader - custom loaders need a custom_type of 1 to %d characters.", RESOURCE_CUSTOM_TYPE_MAX_LENGTH - 1);
+            return false;
         }
+        u32 hash = custom_type_hash(loader.custom_type);
+        resource_custom_type_slot* slot = custom_type_slot(loader.custom_type, hash);
+        if (slot->loader_id != INVALID_ID) {
+            KERROR("resource_system_register_loader - Loader of custom type %s already exists and will not be registered.", loader.custom_type);
+            return false;
+        }
+        // the name is kept here, so the caller's string does not have to outlive the loader
+        slot->hash = hash;
+        slot->loader_id = id;
+        kcopy_memory(slot->name, loader.custom_type, length);
+        loader.custom_type = slot->name;
+    } else {
+        KERROR("resource_system_register_loader - invalid loader type %d.", loader.type);
+        return false;
     }
 
-    // it failed
-    return false;
+    state_ptr->registered_loaders[id] = loader;  // copy the loader into the array
+    state_ptr->registered_loaders[id].id = id;   // id becomes the index
+    state_ptr->loader_count++;
+    KTRACE("Loader registered.");
+    return true;
 }
 
 // load functions
 // used by the system
 b8 resource_system_load(const char* name, resource_type type, void* params, resource* out_resource) {
-    if (state_ptr && type != RESOURCE_TYPE_CUSTOM) {
-        // Select loader.
-        u32 count = state_ptr->config.max_loader_count;
-        for (u32 i = 0; i < count; ++i) {
-            resource_loader* l = &state_ptr->registered_loaders[i];
-            if (l->id != INVALID_ID && l->type == type) {
-                return load(name, l, params, out_resource);
-            }
-        }
+    resource_loader* l = (state_ptr && type != RESOURCE_TYPE_CUSTOM) ? loader_find(type, 0) : 0;
+    if (l) {
+        return load(name, l, params, out_resource);
     }
 
     out_resource->loader_id = INVALID_ID;
@@ -124,15 +382,9 @@ b8 resource_system_load(const char* name, resource_type type, void* params, reso
 
 // used by user code
 b8 resource_system_load_custom(const char* name, const char* custom_type, void* params, resource* out_resource) {
-    if (state_ptr && custom_type && string_length(custom_type) > 0) {  // verify there is a state, a type was passed in, and the type had some value
-        // select the loader
-        u32 count = state_ptr->config.max_loader_count;
-        for (u32 i = 0; i < count; ++i) {                                                                                 // iterate through all of the loaders
-            resource_loader* l = &state_ptr->registered_loaders[i];                                                       // get a pointer to the loader in the array at index i
-            if (l->id != INVALID_ID && l->type == RESOURCE_TYPE_CUSTOM && strings_equali(l->custom_type, custom_type)) {  // if the id is valid, the type is custom, and the passed in custom type matches the type at index i
-                return load(name, l, params, out_resource);                                                               // load the resource and return it
-            }
-        }
+    resource_loader* l = state_ptr ? loader_find(RESOURCE_TYPE_CUSTOM, custom_type) : 0;
+    if (l) {
+        return load(name, l, params, out_resource);
     }
 
     out_resource->loader_id = INVALID_ID;
@@ -140,10 +392,596 @@ b8 resource_system_load_custom(const char* name, const char* custom_type, void*
     return false;
 }
 
+static void loader_stats_get(const resource_loader* loader, resource_loader_stats* out_stats) {
+    resource_loader_counters* c = &state_ptr->loader_counters[loader->id];
+    out_stats->load_count = (u64)katomic_load_i64(&c->load_count, KATOMIC_RELAXED);
+    out_stats->failed_count = (u64)katomic_load_i64(&c->failed_count, KATOMIC_RELAXED);
+    out_stats->cache_hit_count = (u64)katomic_load_i64(&c->cache_hit_count, KATOMIC_RELAXED);
+    out_stats->bytes_read = (u64)katomic_load_i64(&c->bytes_read, KATOMIC_RELAXED);
+    out_stats->load_time = (f64)katomic_load_i64(&c->load_time_ns, KATOMIC_RELAXED) / 1000000000.0;
+}
+
+b8 resource_system_loader_stats(resource_type type, const char* custom_type, resource_loader_stats* out_stats) {
+    resource_loader* l = (state_ptr && out_stats) ? loader_find(type, custom_type) : 0;
+    if (!l) {
+        return false;
+    }
+    loader_stats_get(l, out_stats);
+    return true;
+}
+
+void resource_loader_record_read(const resource_loader* self, u64 size) {
+    if (state_ptr && self && self->id < state_ptr->loader_count) {
+        katomic_fetch_add_i64(&state_ptr->loader_counters[self->id].bytes_read, (i64)size, KATOMIC_RELAXED);
+    }
+}
+
+// NOTE: end loader lookup
+
+// NOTE: begin async loads
+
+// true if slot a should start before slot b
+static b8 load_goes_first(const resource_load_slot* a, const resource_load_slot* b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    return a->sequence < b->sequence;
+}
+
+static void load_queue_place(u32 position, u32 slot_index) {
+    state_ptr->load_queue[position] = slot_index;
+    state_ptr->load_slots[slot_index].queue_index = position;
+}
+
+static void load_queue_sift_up(u32 position) {
+    u32 slot_index = state_ptr->load_queue[position];
+    while (position > 0) {
+        u32 parent = (position - 1) / 2;
+        if (!load_goes_first(&state_ptr->load_slots[slot_index], &state_ptr->load_slots[state_ptr->load_queue[parent]])) {
+            break;
+        }
+        load_queue_place(position, state_ptr->load_queue[parent]);
+        position = parent;
+    }
+    load_queue_place(position, slot_index);
+}
+
+static void load_queue_sift_down(u32 position) {
+    u32 slot_index = state_ptr->load_queue[position];
+    u32 count = state_ptr->load_queue_count;
+    while (true) {
+        u32 child = position * 2 + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && load_goes_first(&state_ptr->load_slots[state_ptr->load_queue[child + 1]], &state_ptr->load_slots[state_ptr->load_queue[child]])) {
+            child++;
+        }
+        if (!load_goes_first(&state_ptr->load_slots[state_ptr->load_queue[child]], &state_ptr->load_slots[slot_index])) {
+            break;
+        }
+        load_queue_place(position, state_ptr->load_queue[child]);
+        position = child;
+    }
+    load_queue_place(position, slot_index);
+}
+
+static void load_queue_remove(u32 position) {
+    u32 removed = state_ptr->load_queue[position];
+    state_ptr->load_slots[removed].queue_index = INVALID_ID;
+    state_ptr->load_queue_count--;
+    if (position == state_ptr->load_queue_count) {
+        return;
+    }
+    // the last entry fills the gap, then moves whichever way it needs to
+    u32 moved = state_ptr->load_queue[state_ptr->load_queue_count];
+    load_queue_place(position, moved);
+    load_queue_sift_up(position);
+    load_queue_sift_down(state_ptr->load_slots[moved].queue_index);
+}
+
+static resource_load_slot* slot_from_handle(resource_load_handle handle) {
+    u32 index = (u32)(handle & 0xFFFFFFFF);
+    u32 generation = (u32)(handle >> 32);
+    if (index == 0 || index > state_ptr->config.max_async_load_count) {
+        return 0;
+    }
+    resource_load_slot* slot = &state_ptr->load_slots[index - 1];
+    return slot->in_use && slot->generation == generation ? slot : 0;
+}
+
+static void release_slot(resource_load_slot* slot) {
+    slot->in_use = false;
+    slot->generation++;
+    state_ptr->pending_count--;
+}
+
+static void load_job_entry(void* params) {
+    resource_load_slot* slot = params;
+    // a cancel that gets in before the job starts skips the load altogether
+    if (!slot->cancelled) {
+        slot->success = load(slot->name, slot->loader, slot->has_params ? slot->params : 0, &slot->resource);
+        // and one that lands while loading gets the resource freed here, off the main thread
+        if (slot->cancelled && slot->success) {
+            resource_system_unload(&slot->resource);
+            slot->success = false;
+        }
+    }
+    slot->finished = true;
+}
+
+static void dispatch_loads();
+
+// run on the main thread by job_system_update
+static void load_job_complete(void* params) {
+    resource_load_slot* slot = params;
+    kmutex_lock(&state_ptr->load_lock);
+    state_ptr->in_flight_count--;
+    b8 cancelled = slot->cancelled;
+    kmutex_unlock(&state_ptr->load_lock);
+
+    if (cancelled) {
+        if (slot->success) {
+            resource_system_unload(&slot->resource);
+        }
+    } else {
+        if (!slot->success) {
+            kzero_memory(&slot->resource, sizeof(resource));
+        }
+        slot->callback(slot->success, &slot->resource, slot->user_data);
+    }
+
+    kmutex_lock(&state_ptr->load_lock);
+    release_slot(slot);
+    kmutex_unlock(&state_ptr->load_lock);
+
+    dispatch_loads();
+}
+
+// starts queued loads, best first, until as many are running as allowed
+static void dispatch_loads() {
+    job_info jobs[32];
+    while (true) {
+        u32 job_count = 0;
+        kmutex_lock(&state_ptr->load_lock);
+        while (job_count < 32 && state_ptr->load_queue_count > 0 && state_ptr->in_flight_count < state_ptr->config.max_concurrent_load_count) {
+            resource_load_slot* slot = &state_ptr->load_slots[state_ptr->load_queue[0]];
+            load_queue_remove(0);
+            state_ptr->in_flight_count++;
+
+            jobs[job_count] = job_create(load_job_entry, slot, slot->priority);
+            jobs[job_count].on_complete = load_job_complete;
+            // loaders may wait on reads, which parks the fiber rather than the worker
+            jobs[job_count].use_fiber = true;
+            job_count++;
+        }
+        kmutex_unlock(&state_ptr->load_lock);
+
+        if (job_count == 0) {
+            return;
+        }
+        job_system_submit_batch(jobs, job_count);
+    }
+}
+
+resource_load_info resource_load_info_create(const char* name, resource_type type, pfn_resource_load_complete callback, void* user_data) {
+    resource_load_info info;
+    kzero_memory(&info, sizeof(resource_load_info));
+    info.name = name;
+    info.type = type;
+    info.callback = callback;
+    info.user_data = user_data;
+    info.priority = JOB_PRIORITY_NORMAL;
+    return info;
+}
+
+resource_load_handle resource_system_load_async(resource_load_info info) {
+    if (!state_ptr || !info.name || !info.callback) {
+        KERROR("resource_system_load_async - requires a name and a callback.");
+        return 0;
+    }
+    u64 name_length = string_length(info.name);
+    if (name_length >= RESOURCE_LOAD_NAME_MAX_LENGTH || info.params_size > RESOURCE_LOAD_MAX_PARAMS_SIZE || (info.params_size && !info.params)) {
+        KERROR("resource_system_load_async - the name or params of '%s' are too long.", info.name);
+        return 0;
+    }
+
+    // the loader is picked now, so a missing one fails straight away rather than in the callback
+    resource_loader* loader = loader_find(info.type, info.custom_type);
+    if (!loader) {
+        KERROR("resource_system_load_async - No loader for type %d was found.", info.type);
+        return 0;
+    }
+
+    kmutex_lock(&state_ptr->load_lock);
+    resource_load_slot* slot = 0;
+    u32 index = 0;
+    for (; index < state_ptr->config.max_async_load_count; ++index) {
+        if (!state_ptr->load_slots[index].in_use) {
+            slot = &state_ptr->load_slots[index];
+            break;
+        }
+    }
+    if (!slot) {
+        kmutex_unlock(&state_ptr->load_lock);
+        KERROR("resource_system_load_async - too many loads in flight. Raise max_async_load_count.");
+        return 0;
+    }
+
+    u32 generation = slot->generation;
+    kzero_memory(slot, sizeof(resource_load_slot));
+    slot->generation = generation;
+    slot->in_use = true;
+    slot->sequence = state_ptr->next_sequence++;
+    slot->priority = info.priority < JOB_PRIORITY_MAX ? info.priority : JOB_PRIORITY_LOW;
+    slot->loader = loader;
+    slot->callback = info.callback;
+    slot->user_data = info.user_data;
+    kcopy_memory(slot->name, info.name, name_length);
+    if (info.params_size) {
+        kcopy_memory(slot->params, info.params, info.params_size);
+        slot->has_params = true;
+    }
+
+    state_ptr->pending_count++;
+    state_ptr->load_queue_count++;
+    load_queue_place(state_ptr->load_queue_count - 1, index);
+    load_queue_sift_up(state_ptr->load_queue_count - 1);
+    resource_load_handle handle = ((u64)generation << 32) | (u64)(index + 1);
+    kmutex_unlock(&state_ptr->load_lock);
+
+    dispatch_loads();
+    return handle;
+}
+
+b8 resource_system_cancel_load(resource_load_handle handle) {
+    if (!state_ptr) {
+        return false;
+    }
+    kmutex_lock(&state_ptr->load_lock);
+    resource_load_slot* slot = slot_from_handle(handle);
+    b8 result = slot && !slot->cancelled;
+    if (result) {
+        if (slot->queue_index != INVALID_ID) {
+            // not started, so it can go straight away
+            load_queue_remove(slot->queue_index);
+            release_slot(slot);
+        } else {
+            slot->cancelled = true;
+        }
+    }
+    kmutex_unlock(&state_ptr->load_lock);
+    return result;
+}
+
+u32 resource_system_pending_load_count() {
+    if (!state_ptr) {
+        return 0;
+    }
+    kmutex_lock(&state_ptr->load_lock);
+    u32 count = state_ptr->pending_count;
+    kmutex_unlock(&state_ptr->load_lock);
+    return count;
+}
+
+// NOTE: end async loads
+
+// NOTE: begin resource cache
+
+// roughly how much memory a loaded resource holds, for the budget. data_size means something different for each type
+static u64 resource_memory_size(const resource* r) {
+    resource_loader* loader = &state_ptr->registered_loaders[r->loader_id];
+    u64 size = sizeof(resource) + r->data_size;
+    switch (loader->type) {
+        case RESOURCE_TYPE_IMAGE: {
+            const image_resource_data* image = r->data;
+            size += (u64)image->width * image->height * image->channel_count;
+        } break;
+        case RESOURCE_TYPE_MESH: {
+            // data_size is the geometry count
+            const geometry_config* configs = r->data;
+            size = sizeof(resource) + sizeof(geometry_config) * r->data_size;
+            for (u64 i = 0; i < r->data_size; ++i) {
+                size += (u64)configs[i].vertex_size * configs[i].vertex_count + (u64)configs[i].index_size * configs[i].index_count;
+            }
+        } break;
+        default:
+            break;
+    }
+    return size;
+}
+
+// false if the resource can't be cached, because the loader does not say how big its params are or the name is too long
+static b8 cache_key_create(const char* name, resource_loader* loader, const void* params, resource_cache_key* out_key) {
+    if (!state_ptr->config.max_cache_entry_count || loader->params_size > RESOURCE_LOAD_MAX_PARAMS_SIZE) {
+        return false;
+    }
+    out_key->name_length = string_length(name);
+    if (out_key->name_length >= RESOURCE_LOAD_NAME_MAX_LENGTH) {
+        return false;
+    }
+    out_key->loader_id = loader->id;
+    out_key->name = name;
+    out_key->params_size = loader->params_size;
+    kzero_memory(out_key->params, RESOURCE_LOAD_MAX_PARAMS_SIZE);
+    if (params && loader->params_size) {
+        kcopy_memory(out_key->params, params, loader->params_size);
+    }
+    u64 name_hash = xxhash64(name, out_key->name_length, loader->id);
+    out_key->hash = xxhash64(out_key->params, out_key->params_size, name_hash);
+    return true;
+}
+
+static b8 params_equal(const u8* a, const u8* b, u64 size) {
+    for (u64 i = 0; i < size; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static u32 cache_find(const resource_cache_key* key) {
+    u32 index = state_ptr->cache_buckets[key->hash & (state_ptr->cache_bucket_count - 1)];
+    while (index != INVALID_ID) {
+        resource_cache_entry* e = &state_ptr->cache_entries[index];
+        if (e->hash == key->hash && e->resource.loader_id == key->loader_id && strings_equal(e->name, key->name) &&
+            params_equal(e->params, key->params, key->params_size)) {
+            return index;
+        }
+        index = e->next;
+    }
+    return INVALID_ID;
+}
+
+static void cache_lru_unlink(u32 index) {
+    resource_cache_entry* e = &state_ptr->cache_entries[index];
+    if (e->lru_prev != INVALID_ID) {
+        state_ptr->cache_entries[e->lru_prev].lru_next = e->lru_next;
+    } else {
+        state_ptr->cache_lru_head = e->lru_next;
+    }
+    if (e->lru_next != INVALID_ID) {
+        state_ptr->cache_entries[e->lru_next].lru_prev = e->lru_prev;
+    } else {
+        state_ptr->cache_lru_tail = e->lru_prev;
+    }
+    e->lru_prev = INVALID_ID;
+    e->lru_next = INVALID_ID;
+}
+
+static void cache_lru_push(u32 index) {
+    resource_cache_entry* e = &state_ptr->cache_entries[index];
+    e->lru_prev = state_ptr->cache_lru_tail;
+    e->lru_next = INVALID_ID;
+    if (state_ptr->cache_lru_tail != INVALID_ID) {
+        state_ptr->cache_entries[state_ptr->cache_lru_tail].lru_next = index;
+    } else {
+        state_ptr->cache_lru_head = index;
+    }
+    state_ptr->cache_lru_tail = index;
+}
+
+static void cache_bucket_unlink(u32 index) {
+    resource_cache_entry* e = &state_ptr->cache_entries[index];
+    u32* link = &state_ptr->cache_buckets[e->hash & (state_ptr->cache_bucket_count - 1)];
+    while (*link != index) {
+        link = &state_ptr->cache_entries[*link].next;
+    }
+    *link = e->next;
+}
+
+// unloads an entry nobody holds and puts it back on the free list. the unload happens under the lock, which is fine for
+// the loaders there are, as none of them do more than free memory or close a file
+static void cache_evict(u32 index) {
+    resource_cache_entry* e = &state_ptr->cache_entries[index];
+    cache_lru_unlink(index);
+
+    // orphans were taken out of their bucket when they were orphaned
+    if (!e->orphaned) {
+        cache_bucket_unlink(index);
+    }
+
+    resource_loader* loader = &state_ptr->registered_loaders[e->resource.loader_id];
+    if (loader->unload) {
+        loader->unload(loader, &e->resource);
+    }
+    state_ptr->cache_memory_size -= e->memory_size;
+    state_ptr->cache_entry_count--;
+    e->in_use = false;
+    e->orphaned = false;
+    e->next = state_ptr->cache_free_head;
+    state_ptr->cache_free_head = index;
+}
+
+static void cache_trim() {
+    while (state_ptr->cache_memory_size > state_ptr->config.cache_budget && state_ptr->cache_lru_head != INVALID_ID) {
+        cache_evict(state_ptr->cache_lru_head);
+    }
+}
+
+// hands out another reference to a cached entry
+static void cache_reference(u32 index, resource* out_resource) {
+    resource_cache_entry* e = &state_ptr->cache_entries[index];
+    if (e->reference_count == 0) {
+        cache_lru_unlink(index);
+    }
+    e->reference_count++;
+    *out_resource = e->resource;
+    out_resource->cache_index = index;
+}
+
+static b8 resource_cache_acquire(const resource_cache_key* key, resource* out_resource) {
+    kmutex_lock(&state_ptr->cache_lock);
+    u32 index = cache_find(key);
+    if (index != INVALID_ID) {
+        cache_reference(index, out_resource);
+    }
+    kmutex_unlock(&state_ptr->cache_lock);
+    return index != INVALID_ID;
+}
+
+// takes a freshly loaded resource into the cache. if another thread got the same one in first, that one is used and the
+// fresh one unloaded. if the cache is full of loaded resources it is left uncached
+static void resource_cache_insert(const resource_cache_key* key, resource* loaded) {
+    resource duplicate;
+    b8 has_duplicate = false;
+
+    kmutex_lock(&state_ptr->cache_lock);
+    u32 index = cache_find(key);
+    if (index != INVALID_ID) {
+        duplicate = *loaded;
+        has_duplicate = true;
+        cache_reference(index, loaded);
+    } else {
+        if (state_ptr->cache_free_head == INVALID_ID && state_ptr->cache_lru_head != INVALID_ID) {
+            cache_evict(state_ptr->cache_lru_head);
+        }
+        index = state_ptr->cache_free_head;
+        if (index != INVALID_ID) {
+            resource_cache_entry* e = &state_ptr->cache_entries[index];
+            state_ptr->cache_free_head = e->next;
+
+            e->in_use = true;
+            e->orphaned = false;
+            e->hash = key->hash;
+            e->lru_prev = INVALID_ID;
+            e->lru_next = INVALID_ID;
+            e->reference_count = 0;
+            e->memory_size = resource_memory_size(loaded);
+            kzero_memory(e->name, RESOURCE_LOAD_NAME_MAX_LENGTH);
+            kcopy_memory(e->name, key->name, key->name_length);
+            kcopy_memory(e->params, key->params, RESOURCE_LOAD_MAX_PARAMS_SIZE);
+            e->resource = *loaded;
+            // the caller's name won't outlive the call, the entry's will
+            e->resource.name = e->name;
+
+            u32* bucket = &state_ptr->cache_buckets[key->hash & (state_ptr->cache_bucket_count - 1)];
+            e->next = *bucket;
+            *bucket = index;
+            state_ptr->cache_entry_count++;
+            state_ptr->cache_memory_size += e->memory_size;
+
+            // handed straight out, so it never goes on the lru list. cache_reference would unlink it from a list it
+            // isn't in, and lose the list's head and tail doing so
+            e->reference_count = 1;
+            *loaded = e->resource;
+            loaded->cache_index = index;
+            cache_trim();
+        }
+    }
+    kmutex_unlock(&state_ptr->cache_lock);
+
+    if (has_duplicate) {
+        resource_loader* loader = &state_ptr->registered_loaders[duplicate.loader_id];
+        if (loader->unload) {
+            loader->unload(loader, &duplicate);
+        }
+    }
+}
+
+static void resource_cache_release(resource* resource) {
+    kmutex_lock(&state_ptr->cache_lock);
+    u32 index = resource->cache_index;
+    resource_cache_entry* e = index < state_ptr->config.max_cache_entry_count ? &state_ptr->cache_entries[index] : 0;
+    if (e && e->in_use && e->reference_count > 0 && e->resource.data == resource->data) {
+        e->reference_count--;
+        if (e->reference_count == 0) {
+            cache_lru_push(index);
+            if (e->orphaned) {
+                cache_evict(index);
+            } else {
+                cache_trim();
+            }
+        }
+    } else {
+        KWARN("resource_system_unload - '%s' was already unloaded.", resource->name ? resource->name : "");
+    }
+    kmutex_unlock(&state_ptr->cache_lock);
+
+    // the copy handed out is done with, so a second unload of it does nothing
+    resource->loader_id = INVALID_ID;
+    resource->cache_index = INVALID_ID;
+    resource->data = 0;
+    resource->data_size = 0;
+}
+
+// unloads everything, loaded or not. only for shutdown
+static void resource_cache_flush() {
+    for (u32 i = 0; i < state_ptr->config.max_cache_entry_count; ++i) {
+        resource_cache_entry* e = &state_ptr->cache_entries[i];
+        if (!e->in_use) {
+            continue;
+        }
+        if (e->reference_count > 0) {
+            KWARN("resource_system_shutdown - '%s' is still loaded %u time(s).", e->name, e->reference_count);
+            e->reference_count = 0;
+            cache_lru_push(i);
+        }
+        cache_evict(i);
+    }
+}
+
+static void resource_cache_invalidate(const char* name, resource_loader* loader) {
+    if (!name || !loader || !state_ptr->config.max_cache_entry_count) {
+        return;
+    }
+
+    kmutex_lock(&state_ptr->cache_lock);
+    // every set of params the resource was loaded with has an entry of its own. invalidating is rare enough to look
+    // through all of them rather than keep an index by name
+    for (u32 i = 0; i < state_ptr->config.max_cache_entry_count; ++i) {
+        resource_cache_entry* e = &state_ptr->cache_entries[i];
+        if (!e->in_use || e->orphaned || e->resource.loader_id != loader->id || !strings_equal(e->name, name)) {
+            continue;
+        }
+        if (e->reference_count == 0) {
+            cache_evict(i);
+        } else {
+            cache_bucket_unlink(i);
+            e->orphaned = true;
+        }
+    }
+    kmutex_unlock(&state_ptr->cache_lock);
+}
+
+void resource_system_invalidate(const char* name, resource_type type) {
+    if (state_ptr && type != RESOURCE_TYPE_CUSTOM) {
+        resource_cache_invalidate(name, loader_find(type, 0));
+    }
+}
+
+void resource_system_invalidate_custom(const char* name, const char* custom_type) {
+    if (state_ptr) {
+        resource_cache_invalidate(name, loader_find(RESOURCE_TYPE_CUSTOM, custom_type));
+    }
+}
+
+void resource_system_cache_usage(u64* out_memory_size, u32* out_entry_count) {
+    u64 memory_size = 0;
+    u32 entry_count = 0;
+    if (state_ptr) {
+        kmutex_lock(&state_ptr->cache_lock);
+        memory_size = state_ptr->cache_memory_size;
+        entry_count = state_ptr->cache_entry_count;
+        kmutex_unlock(&state_ptr->cache_lock);
+    }
+    if (out_memory_size) {
+        *out_memory_size = memory_size;
+    }
+    if (out_entry_count) {
+        *out_entry_count = entry_count;
+    }
+}
+
+// NOTE: end resource cache
+
 // unload
 void resource_system_unload(resource* resource) {
     if (state_ptr && resource) {
-        if (resource->loader_id != INVALID_ID) {
+        if (resource->loader_id != INVALID_ID && resource->cache_index != INVALID_ID) {
+            resource_cache_release(resource);
+        } else if (resource->loader_id != INVALID_ID) {
             resource_loader* l = &state_ptr->registered_loaders[resource->loader_id];  // get a pointer to the resource at the proper index
             if (l->id != INVALID_ID && l->unload) {
                 l->unload(l, resource);  // call unload function
@@ -173,5 +1011,29 @@ b8 load(const char* name, resource_loader* loader, void* params, resource* out_r
 
     // store the id in the resulting struct
     out_resource->loader_id = loader->id;
-    return loader->load(loader, name, params, out_resource);  // use load function to load the loader, and return it
+    out_resource->cache_index = INVALID_ID;
+
+    resource_loader_counters* counters = &state_ptr->loader_counters[loader->id];
+    resource_cache_key key;
+    b8 cacheable = cache_key_create(name, loader, params, &key);
+    if (cacheable && resource_cache_acquire(&key, out_resource)) {
+        katomic_fetch_add_i64(&counters->cache_hit_count, 1, KATOMIC_RELAXED);
+        out_resource->name = name;
+        return true;
+    }
+
+    u64 start_ns = platform_get_absolute_time_ns();
+    b8 result = loader->load(loader, name, params, out_resource);  // use load function to load the loader, and return it
+    katomic_fetch_add_i64(&counters->load_time_ns, (i64)(platform_get_absolute_time_ns() - start_ns), KATOMIC_RELAXED);
+    katomic_fetch_add_i64(&counters->load_count, 1, KATOMIC_RELAXED);
+    if (!result) {
+        katomic_fetch_add_i64(&counters->failed_count, 1, KATOMIC_RELAXED);
+        return false;
+    }
+
+    if (cacheable) {
+        resource_cache_insert(&key, out_resource);
+        out_resource->name = name;
+    }
+    return true;
 }
\ No newline at end of file
@@ -1,20 +1,47 @@
 #pragma once
 
 #include "resources/resource_types.h"
+#include "systems/job_system.h"
+
+// the longest name an async load can be given, including the terminator
+#define RESOURCE_LOAD_NAME_MAX_LENGTH 256
+// the largest params an async load can be given. they are copied, so they don't have to outlive the request
+#define RESOURCE_LOAD_MAX_PARAMS_SIZE 64
+// the longest custom type name a loader can be registered with, including the terminator
+#define RESOURCE_CUSTOM_TYPE_MAX_LENGTH 64
 
 // store the configuration settings for the resource system
 typedef struct resource_system_config {
     u32 max_loader_count;
     // the relative base path for assets
     char* asset_base_path;
+    // optional packed archive of assets. loose files under asset_base_path take priority over it, so a shipping build
+    // can have just the archive while a development build still picks up edits straight away
+    char* archive_path;
+    // @brief the max number of async loads that can be queued or in flight at once. 0 uses a default of 256
+    u32 max_async_load_count;
+    // @brief the max number of async loads run on the job system at once. the rest wait in the queue, highest priority
+    // first, which is what lets a later high priority load overtake a level's worth of streaming. 0 uses twice the
+    // number of job workers
+    u32 max_concurrent_load_count;
+    // @brief how much memory the resource cache may hold, in bytes. a resource stays cached once unloaded, so loading it
+    // again (with the same params) skips the loader, until the least recently used have to go to make room. resources
+    // still loaded are never evicted, but do count against it. 0 turns the cache off
+    u64 cache_budget;
+    // @brief the max number of resources cached at once. 0 uses a default of 1024
+    u32 max_cache_entry_count;
 } resource_system_config;
 
 // store the info for the resource loaders
 typedef struct resource_loader {
     u32 id;                   // internal id
     resource_type type;       // enum, type like image, text, ect
-    const char* custom_type;  // if type is custom, can provide a string to name it or describe it
+    const char* custom_type;  // if type is custom, the name to load it by (case insensitive). copied on register
     const char* type_path;    // base path for the given type of resource, like materials will be in a materials folder, textures in a texture folder, ect
+    // @brief the size of the params struct the loader takes, or 0 if it takes none. cached resources are looked up by
+    // name and params, so one loaded with different params is loaded again. must be set, and no more than
+    // RESOURCE_LOAD_MAX_PARAMS_SIZE for the loader's resources to be cached
+    u64 params_size;
 
     // @brief loads a resource using this loader
     // @param self a pointer to the loader itself
@@ -28,15 +55,44 @@ typedef struct resource_loader {
 
 // initialize the resource system, will be handled in 2 steps, first stem the pointer to the state is not passed in, and the memory requirememnts are obtained
 // it actually initializes the second time the function is called, after memory has been allocated to hold the system
-b8 resource_system_initialize(u64* memory_requirement, void* state, resource_system_config config);
+KAPI b8 resource_system_initialize(u64* memory_requirement, void* state, resource_system_config config);
 
 // shut down the resource system
-void resource_system_shutdown(void* state);
+KAPI void resource_system_shutdown(void* state);
 
-// exported function to register a loader
+// exported function to register a loader. there can be one loader per type, other than custom, where there can be one
+// per custom type name
 KAPI b8 resource_system_register_loader(resource_loader loader);
 
-// @brief loads a resource of the given name
+// @brief how much work a loader has done since startup
+typedef struct resource_loader_stats {
+    // @brief the number of loads that went to the loader, successful or not
+    u64 load_count;
+    // @brief how many of those failed
+    u64 failed_count;
+    // @brief the number of loads served from the cache instead
+    u64 cache_hit_count;
+    // @brief the size of every file the loader opened, in bytes
+    u64 bytes_read;
+    // @brief the total time spent in the loader's load function, reading and parsing, in seconds. summed over every
+    // thread, so it can be more than the time that has passed
+    f64 load_time;
+} resource_loader_stats;
+
+// @brief obtains the stats of the loader for a type
+// @param type the type of the loader
+// @param custom_type the custom type name, when type is RESOURCE_TYPE_CUSTOM
+// @param out_stats a pointer to hold the stats
+// @return true if there is such a loader, otherwise false
+KAPI b8 resource_system_loader_stats(resource_type type, const char* custom_type, resource_loader_stats* out_stats);
+
+// @brief lets the resource system know a loader read a file, for its stats. called by loaders, from any thread
+// @param self the loader that read it
+// @param size the size of the file in bytes
+KAPI void resource_loader_record_read(const resource_loader* self, u64 size);
+
+// @brief loads a resource of the given name. served from the cache if it is there, in which case the data is shared
+// with every other load of it, so must be treated as read only
 // @param name the name of the resource to load
 // @param type the type of resource to load
 // @param params parameters to be passed to the loader, or 0
@@ -52,8 +108,73 @@ KAPI b8 resource_system_load(const char* name, resource_type type, void* params,
 // @return true on success, otherwise false
 KAPI b8 resource_system_load_custom(const char* name, const char* custom_type, void* params, resource* out_resource);
 
-// unload
+// unload. a cached resource is only released back to the cache, and stays there until evicted
 KAPI void resource_system_unload(resource* resource);
 
+// @brief drops a resource from the cache, for when the file it came from has changed. the next load reads it again.
+// anything still holding it keeps its copy until it is unloaded
+// @param name the name the resource was loaded with
+// @param type the type of the resource
+KAPI void resource_system_invalidate(const char* name, resource_type type);
+
+// @brief drops a resource of a custom type from the cache, see resource_system_invalidate
+// @param name the name the resource was loaded with
+// @param custom_type the custom resource type
+KAPI void resource_system_invalidate_custom(const char* name, const char* custom_type);
+
+// @brief obtains how much memory the resource cache holds, and how many resources, loaded or not
+// @param out_memory_size a pointer to hold the memory held in bytes. optional
+// @param out_entry_count a pointer to hold the number of cached resources. optional
+KAPI void resource_system_cache_usage(u64* out_memory_size, u32* out_entry_count);
+
+// @brief identifies an async load. 0 is never a valid handle
+typedef u64 resource_load_handle;
+
+// @brief called on the main thread (from job_system_update) once an async load has finished, successfully or not
+// @param success true if the resource was loaded
+// @param resource the loaded resource. it belongs to the callback from here on, so copy it out and unload it with
+// resource_system_unload when done. its name is only valid during the call. empty on failure
+// @param user_data the user data of the request
+typedef void (*pfn_resource_load_complete)(b8 success, resource* resource, void* user_data);
+
+// @brief everything needed to start an async load. copied on submit, so it can live on the stack
+typedef struct resource_load_info {
+    // @brief the name of the resource to load. required. copied
+    const char* name;
+    // @brief the type of resource to load
+    resource_type type;
+    // @brief the custom type, when type is RESOURCE_TYPE_CUSTOM
+    const char* custom_type;
+    // @brief parameters to be passed to the loader, or 0. copied, up to RESOURCE_LOAD_MAX_PARAMS_SIZE bytes
+    const void* params;
+    // @brief the size of params in bytes
+    u64 params_size;
+    // @brief called with the result. required
+    pfn_resource_load_complete callback;
+    // @brief passed to the callback
+    void* user_data;
+    // @brief where in the queue the load goes. loads of the same priority start in the order they were requested
+    job_priority priority;
+} resource_load_info;
+
+// @brief creates a load info with the given name, type and callback, at normal priority, with no params
+KAPI resource_load_info resource_load_info_create(const char* name, resource_type type, pfn_resource_load_complete callback, void* user_data);
+
+// @brief queues a resource to be loaded on the job system, so reading the file and parsing it happen off the calling
+// thread. the callback is run on the main thread once done. safe to call from any thread
+// @param info the load to queue. copied, so it does not need to outlive this call
+// @return a handle to the load, which can be used to cancel it, or 0 if it could not be queued (in which case the
+// callback is never called)
+KAPI resource_load_handle resource_system_load_async(resource_load_info info);
+
+// @brief cancels an async load. a load that has not started yet is dropped from the queue. one already running
+// finishes, but its resource is unloaded rather than handed to the callback
+// @param handle the load to cancel
+// @return true if the callback will not be called, false if the load had already finished (or the handle is invalid)
+KAPI b8 resource_system_cancel_load(resource_load_handle handle);
+
+// @brief obtains the number of async loads that are queued or running
+KAPI u32 resource_system_pending_load_count();
+
 // getter for the resource system base path
 KAPI const char* resource_system_base_path();
\ No newline at end of file
@@ -130,6 +130,10 @@ b8 shader_system_create(const shader_config* config) {
     }
     out_shader->state = SHADER_STATE_NOT_CREATED;
     out_shader->name = string_duplicate(config->name);
+    out_shader->stage_filenames = darray_create(char*);
+    for (u8 i = 0; i < config->stage_count; ++i) {
+        darray_push(out_shader->stage_filenames, string_duplicate(config->stage_filenames[i]));
+    }
     out_shader->push_constant_range_count = 0;
     kzero_memory(out_shader->push_constant_ranges, sizeof(range) * 32);
     out_shader->bound_instance_id = INVALID_ID;
@@ -197,6 +201,7 @@ b8 shader_system_create(const shader_config* config) {
         // NOTE: initialize automatically destroys the shader if it fails
         return false;
     }
+    out_shader->state = SHADER_STATE_INITIALIZED;
 
     // at this point, creation is successful, so store the shader id in the hashtable
     // so this can be looked up by name later
@@ -209,6 +214,38 @@ b8 shader_system_create(const shader_config* config) {
     return true;
 }
 
+b8 shader_system_reload(const char* shader_name) {
+    shader* s = shader_system_get(shader_name);
+    if (!s || s->state != SHADER_STATE_INITIALIZED) {
+        return false;
+    }
+    if (!renderer_shader_reload(s)) {
+        KERROR("shader_system_reload - failed to reload shader '%s', keeping the old one.", shader_name);
+        return false;
+    }
+    return true;
+}
+
+u32 shader_system_reload_stage_file(const char* stage_filename) {
+    u32 reload_count = 0;
+    for (u32 i = 0; i < state_ptr->config.max_shader_count; ++i) {
+        shader* s = &state_ptr->shaders[i];
+        if (s->id == INVALID_ID || !s->stage_filenames) {
+            continue;
+        }
+        u32 stage_count = darray_length(s->stage_filenames);
+        for (u32 j = 0; j < stage_count; ++j) {
+            if (strings_equal(s->stage_filenames[j], stage_filename)) {
+                if (shader_system_reload(s->name)) {
+                    reload_count++;
+                }
+                break;
+            }
+        }
+    }
+    return reload_count;
+}
+
 // @brief gets the identifier of a shader by name
 // @param shader_name the name of the shader
 // @return the shader id, if found; otherwise invalid id
@@ -249,6 +286,15 @@ void shader_destroy(shader* s) {
     }
     darray_destroy(s->global_texture_maps);
 
+    if (s->stage_filenames) {
+        u32 stage_count = darray_length(s->stage_filenames);
+        for (u32 i = 0; i < stage_count; ++i) {
+            kfree(s->stage_filenames[i], string_length(s->stage_filenames[i]) + 1, MEMORY_TAG_STRING);
+        }
+        darray_destroy(s->stage_filenames);
+        s->stage_filenames = 0;
+    }
+
     // free the name
     if (s->name) {
         u32 length = string_length(s->name);
@@ -410,9 +456,12 @@ b8 add_attribute(shader* shader, const shader_attribute_config* config) {
         case SHADER_ATTRIB_TYPE_FLOAT32:
         case SHADER_ATTRIB_TYPE_INT32:
         case SHADER_ATTRIB_TYPE_UINT32:
+        case SHADER_ATTRIB_TYPE_SNORM16_2:
+        case SHADER_ATTRIB_TYPE_FLOAT16_2:
             size = 4;
             break;
         case SHADER_ATTRIB_TYPE_FLOAT32_2:
+        case SHADER_ATTRIB_TYPE_UNORM16_4:
             size = 8;
             break;
         case SHADER_ATTRIB_TYPE_FLOAT32_3:
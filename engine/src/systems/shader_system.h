@@ -62,6 +62,9 @@ typedef struct shader {
 
     char* name;
 
+    // @brief the files the stages were created from, in the same order as the stages. darray
+    char** stage_filenames;
+
     // @brief the amount of bytes that are required for ubo anlignment.
     // this is used along with the ubo size to determine the ultimate stride, which is how much the ubos are spaced
     // out in the buffer.  for example, a required alignment of 256 means that the stride must be a multiple of 256
@@ -144,6 +147,17 @@ void shader_system_shutdown(void* state);
 // @return true on success, otherwise false
 KAPI b8 shader_system_create(const shader_config* config);
 
+// @brief builds the stages of a shader again from its stage files, for when they have changed. only the code inside the
+// stages is picked up, anything that changes the layout (attributes, uniforms, samplers) needs a restart
+// @param shader_name the name of the shader
+// @return true on success. on failure the shader is left as it was
+KAPI b8 shader_system_reload(const char* shader_name);
+
+// @brief reloads every shader with a stage created from the given file
+// @param stage_filename the path of the stage file, as it appears in the shader config
+// @return the number of shaders that were reloaded
+KAPI u32 shader_system_reload_stage_file(const char* stage_filename);
+
 // @brief gets the identifier of a shader by name
 // @param shader_name the name of the shader
 // @return the shader id, if found; otherwise invalid id
@@ -3,11 +3,13 @@
 #include "core/logger.h"
 #include "core/kstring.h"
 #include "core/kmemory.h"
+#include "core/profiler.h"
 #include "containers/hashtable.h"
 
 #include "renderer/renderer_frontend.h"
 
 #include "systems/resource_system.h"
+#include "systems/job_system.h"
 
 typedef struct texture_system_state {
     texture_system_config config;  // hang on to a copy of the config state
@@ -41,7 +43,10 @@ static texture_system_state* state_ptr = 0;
 b8 create_default_textures(texture_system_state* state);
 void destroy_default_textures(texture_system_state* state);
 b8 load_texture(const char* texture_name, texture* t);
-b8 load_cube_texture(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t);
+b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t);
+static b8 create_cube_texture(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], const image_resource_data* faces[6], texture* t);
+static void cube_face_names(const char* name, char out_texture_names[6][TEXTURE_NAME_MAX_LENGTH]);
+static void upload_texture(const char* texture_name, const image_resource_data* resource_data, texture* t);
 void destroy_texture(texture* texture);
 b8 process_texture_reference(const char* name, texture_type type, i8 reference_diff, b8 auto_release, b8 skip_load, u32* out_texture_id);
 
@@ -191,6 +196,57 @@ void texture_system_release(const char* name) {
     }
 }
 
+texture* texture_system_get_loaded(const char* name) {
+    if (!state_ptr || !name) {
+        return 0;
+    }
+    texture_reference ref;
+    if (!hashtable_get(&state_ptr->registered_texture_table, name, &ref) || ref.handle == INVALID_ID) {
+        return 0;
+    }
+    texture* t = &state_ptr->registered_textures[ref.handle];
+    // the table does not handle collisions, so make sure it is the right one
+    if (t->generation == INVALID_ID || !strings_equal(t->name, name)) {
+        return 0;
+    }
+    return t;
+}
+
+b8 texture_system_reload_from_image(const char* name, const image_resource_data* image) {
+    KPROFILE_SCOPE("texture_system_reload_from_image");
+    texture* t = texture_system_get_loaded(name);
+    // writeable textures were never loaded from a file, and wrapped ones belong to the renderer
+    if (!t || t->type != TEXTURE_TYPE_2D || (t->flags & (TEXTURE_FLAG_IS_WRITEABLE | TEXTURE_FLAG_IS_WRAPPED))) {
+        return false;
+    }
+    upload_texture(name, image, t);
+    return true;
+}
+
+b8 texture_system_reload_cube_from_images(const char* name, const image_resource_data* faces[6]) {
+    KPROFILE_SCOPE("texture_system_reload_cube_from_images");
+    texture* t = texture_system_get_loaded(name);
+    if (!t || t->type != TEXTURE_TYPE_CUBE) {
+        return false;
+    }
+
+    char texture_names[6][TEXTURE_NAME_MAX_LENGTH];
+    cube_face_names(name, texture_names);
+
+    // made into a copy, so faces that don't match leave the cube map as it was
+    texture temp_texture = *t;
+    temp_texture.internal_data = 0;
+    if (!create_cube_texture(name, texture_names, faces, &temp_texture)) {
+        return false;
+    }
+    u32 current_generation = t->generation;
+    texture old = *t;
+    *t = temp_texture;
+    t->generation = current_generation + 1;
+    renderer_texture_destroy(&old);
+    return true;
+}
+
 texture* texture_system_wrap_internal(const char* name, u32 width, u32 height, u8 channel_count, b8 has_transparency, b8 is_writeable, b8 register_texture, void* internal_data) {
     u32 id = INVALID_ID;
     texture* t = 0;
@@ -391,20 +447,75 @@ void destroy_default_textures(texture_system_state* state) {
     }
 }
 
+// the names of the six faces of a cube map, from the name of the cube map
+static void cube_face_names(const char* name, char out_texture_names[6][TEXTURE_NAME_MAX_LENGTH]) {
+    // +X,-X,+Y,-Y,+Z,-Z in cubemap space, ehic is LH y-down
+    string_format(out_texture_names[0], "%s_r", name);  // right texture
+    string_format(out_texture_names[1], "%s_l", name);  // left texture
+    string_format(out_texture_names[2], "%s_u", name);  // up texture
+    string_format(out_texture_names[3], "%s_d", name);  // down texture
+    string_format(out_texture_names[4], "%s_f", name);  // front texture
+    string_format(out_texture_names[5], "%s_b", name);  // back texture
+}
+
+// loads a single face of a cube map. run as a job so all six faces can be read and decoded at the same time
+typedef struct cube_face_load_job {
+    const char* texture_name;
+    resource img_resource;
+    b8 success;
+} cube_face_load_job;
+
+static void cube_face_load_job_entry(void* params) {
+    cube_face_load_job* job = params;
+    image_resource_params img_params = {};
+    img_params.flip_y = false;
+    job->success = resource_system_load(job->texture_name, RESOURCE_TYPE_IMAGE, &img_params, &job->img_resource);
+}
+
 b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], texture* t) {
-    u8* pixels = 0;
-    u64 image_size = 0;
+    KPROFILE_SCOPE("load_cube_textures");
+    // kick off all the faces at once, then wait on them. the waiting thread helps out rather than idling
+    cube_face_load_job face_jobs[6] = {};
+    job_counter counter = {};
     for (u8 i = 0; i < 6; ++i) {
-        image_resource_params params;
-        params.flip_y = false;
+        face_jobs[i].texture_name = texture_names[i];
+        job_info info = job_create(cube_face_load_job_entry, &face_jobs[i], JOB_PRIORITY_HIGH);
+        info.counter = &counter;
+        info.use_fiber = true;
+        job_system_submit(info);
+    }
+    job_system_wait(&counter);
 
-        resource img_resource;
-        if (!resource_system_load(texture_names[i], RESOURCE_TYPE_IMAGE, &params, &img_resource)) {
+    b8 success = true;
+    const image_resource_data* faces[6];
+    for (u8 i = 0; i < 6; ++i) {
+        if (!face_jobs[i].success) {
             KERROR("load_cube_textures() - Failed to load image resource for texture '%s'", texture_names[i]);
-            return false;
+            success = false;
+            break;
         }
+        faces[i] = face_jobs[i].img_resource.data;
+    }
+    if (success) {
+        success = create_cube_texture(name, texture_names, faces, t);
+    }
 
-        image_resource_data* resource_data = img_resource.data;
+    // clean up data
+    for (u8 i = 0; i < 6; ++i) {
+        if (face_jobs[i].success) {
+            resource_system_unload(&face_jobs[i].img_resource);
+        }
+    }
+    return success;
+}
+
+// puts six loaded faces together into t and uploads them. they must all be the same size
+static b8 create_cube_texture(const char* name, const char texture_names[6][TEXTURE_NAME_MAX_LENGTH], const image_resource_data* faces[6], texture* t) {
+    u8* pixels = 0;
+    u64 image_size = 0;
+    b8 success = true;
+    for (u8 i = 0; i < 6; ++i) {
+        const image_resource_data* resource_data = faces[i];
         if (!pixels) {
             t->width = resource_data->width;
             t->height = resource_data->height;
@@ -421,43 +532,35 @@ b8 load_cube_textures(const char* name, const char texture_names[6][TEXTURE_NAME
         } else {
             // verify that all textures are the same size
             if (t->width != resource_data->width || t->height != resource_data->height || t->channel_count != resource_data->channel_count) {
-                KERROR("load_cube_textures - All textures must be the same resolution and bit depth.");
-                kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-                pixels = 0;
-                return false;
+                KERROR("load_cube_textures - All textures must be the same resolution and bit depth. '%s' is not.", texture_names[i]);
+                success = false;
+                break;
             }
         }
 
         // copy to the relevant portion of the array
         kcopy_memory(pixels + image_size * i, resource_data->pixels, image_size);
-
-        // clean up data
-        resource_system_unload(&img_resource);
     }
 
-    // Acquire internal texture resources and upload to gpu
-    renderer_texture_create(pixels, t);
-
-    kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
-    pixels = 0;
-
-    return true;
-}
-
-b8 load_texture(const char* texture_name, texture* t) {
-    image_resource_params params;
-    params.flip_y = true;
+    if (success) {
+        // Acquire internal texture resources and upload to gpu
+        renderer_texture_create(pixels, t);
+    }
 
-    resource img_resource;
-    if (!resource_system_load(texture_name, RESOURCE_TYPE_IMAGE, &params, &img_resource)) {
-        KERROR("Failed to load image resource for texture '%s'", texture_name);
-        return false;
+    if (pixels) {
+        kfree(pixels, sizeof(u8) * image_size * 6, MEMORY_TAG_ARRAY);
+        pixels = 0;
     }
 
-    image_resource_data* resource_data = img_resource.data;
+    return success;
+}
 
+// uploads an image into t, replacing whatever it held. the id and type are kept, the generation goes up by one
+static void upload_texture(const char* texture_name, const image_resource_data* resource_data, texture* t) {
     // use a temporary texture to load into
     texture temp_texture;
+    temp_texture.id = t->id;
+    temp_texture.type = t->type;
     temp_texture.width = resource_data->width;
     temp_texture.height = resource_data->height;
     temp_texture.channel_count = resource_data->channel_count;  // if the image has the wrong channel count overwrite it here
@@ -498,6 +601,20 @@ b8 load_texture(const char* texture_name, texture* t) {
     } else {
         t->generation = current_generation + 1;  // set generation to an increment generation by one
     }
+}
+
+b8 load_texture(const char* texture_name, texture* t) {
+    KPROFILE_SCOPE("load_texture");
+    image_resource_params params = {};
+    params.flip_y = true;
+
+    resource img_resource;
+    if (!resource_system_load(texture_name, RESOURCE_TYPE_IMAGE, &params, &img_resource)) {
+        KERROR("Failed to load image resource for texture '%s'", texture_name);
+        return false;
+    }
+
+    upload_texture(texture_name, img_resource.data, t);
 
     // clean up the data
     resource_system_unload(&img_resource);
@@ -542,6 +659,7 @@ b8 process_texture_reference(const char* name, texture_type type, i8 reference_d
             // take a copy of the name since it would be wiped out if destroyed,
             // (as passed in name is generally a pointer to the actual texture's name)
             char name_copy[TEXTURE_NAME_MAX_LENGTH];
+            string_ncopy(name_copy, name, TEXTURE_NAME_MAX_LENGTH);
 
             // if decrementing this means a release
             if (reference_diff < 0) {
@@ -588,14 +706,7 @@ b8 process_texture_reference(const char* name, texture_type type, i8 reference_d
                         } else {
                             if (type == TEXTURE_TYPE_CUBE) {
                                 char texture_names[6][TEXTURE_NAME_MAX_LENGTH];
-
-                                // +X,-X,+Y,-Y,+Z,-Z in cubemap space, ehic is LH y-down
-                                string_format(texture_names[0], "%s_r", name);  // right texture
-                                string_format(texture_names[1], "%s_l", name);  // left texture
-                                string_format(texture_names[2], "%s_u", name);  // up texture
-                                string_format(texture_names[3], "%s_d", name);  // down texture
-                                string_format(texture_names[4], "%s_f", name);  // front texture
-                                string_format(texture_names[5], "%s_b", name);  // back texture
+                                cube_face_names(name, texture_names);
 
                                 if (!load_cube_textures(name, texture_names, t)) {
                                     *out_texture_id = INVALID_ID;
@@ -59,6 +59,27 @@ texture* texture_system_acquire_writeable(const char* name, u32 width, u32 heigh
 // release the texture from memory
 void texture_system_release(const char* name);
 
+// @brief gets a texture that has already been loaded, without taking a reference to it
+// @param name the name of the texture
+// @return a pointer to the texture, or 0 if no texture of that name is loaded
+texture* texture_system_get_loaded(const char* name);
+
+// @brief replaces the contents of a loaded texture with a new image, for when the file it came from has changed.
+// anything using the texture sees the new image from then on, and its generation goes up by one
+// @param name the name of the texture
+// @param image the new image. must have been loaded with flip_y set, the same as texture_system_acquire loads them
+// @return true on success. false if no 2d texture of that name is loaded, or it is writeable or wrapped
+b8 texture_system_reload_from_image(const char* name, const image_resource_data* image);
+
+// @brief replaces all six faces of a loaded cube map, for when any of their files have changed. the generation goes up
+// by one
+// @param name the name of the cube map, as given to texture_system_acquire_cube
+// @param faces the new faces, in the order right, left, up, down, front, back. loaded without flip_y, the same as
+// texture_system_acquire_cube loads them
+// @return true on success. false if no cube map of that name is loaded or the faces aren't all the same size, which
+// leaves the cube map as it was
+b8 texture_system_reload_cube_from_images(const char* name, const image_resource_data* faces[6]);
+
 // @brief wraps the provided internal data in a texture stucture using the parameters provided. this is best used for when the
 // render system creates internal resources and they should be passed off to the texture system. can be looked up by name via
 // the acquire methods NOTE: wrapped textures are not auto released
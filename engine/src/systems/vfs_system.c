@@ -0,0 +1,806 @@
+#include "vfs_system.h"
+
+#include "core/logger.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/kbinary.h"
+#include "core/kmutex.h"
+#include "core/lz4.h"
+#include "core/profiler.h"
+#include "containers/darray.h"
+#include "platform/async_io.h"
+#include "systems/job_system.h"
+
+// "KPAK" as it appears in the file
+#define VFS_ARCHIVE_MAGIC 0x4B41504BU
+#define VFS_ARCHIVE_VERSION 1
+#define VFS_ARCHIVE_DEFAULT_ALIGNMENT 16
+// compressed files are only kept compressed when they come out at least 1/8th smaller
+#define VFS_COMPRESSION_MIN_SAVING_SHIFT 3
+
+typedef enum vfs_storage {
+    // points straight into a mounted archive, nothing to release
+    VFS_STORAGE_ARCHIVE = 0,
+    VFS_STORAGE_MAPPED = 1,
+    VFS_STORAGE_ALLOCATED = 2
+} vfs_storage;
+
+// NOTE: the archive layout is header, entries, slots, strings, then each file's data at an aligned offset. everything is
+// little endian and read in place from the mapping, so every struct here is a multiple of 8 bytes with no padding
+typedef struct vfs_archive_header {
+    u32 magic;
+    u16 version;
+    u16 reserved;
+    u32 alignment;
+    u32 entry_count;
+    // the size of the lookup table, a power of 2
+    u32 slot_count;
+    u32 reserved1;
+    u64 entries_offset;
+    u64 slots_offset;
+    u64 strings_offset;
+    u64 strings_size;
+    // the size of the whole archive, to catch truncated files
+    u64 file_size;
+} vfs_archive_header;
+
+typedef struct vfs_archive_entry {
+    u64 hash;
+    // where the data starts, from the start of the archive
+    u64 offset;
+    // the size of the data as stored
+    u64 size;
+    u64 uncompressed_size;
+    // where the path starts in the strings. paths are null terminated
+    u32 path_offset;
+    u32 path_length;
+    u32 compression;
+    u32 reserved;
+} vfs_archive_entry;
+
+// the lookup table is open addressed with linear probing. each slot holds an entry index + 1, 0 being empty
+
+typedef enum vfs_mount_type {
+    VFS_MOUNT_TYPE_DIRECTORY,
+    VFS_MOUNT_TYPE_ARCHIVE
+} vfs_mount_type;
+
+// a file in a mounted directory. the same open addressed scheme as archives, just built at mount time
+typedef struct directory_file {
+    u64 hash;
+    // relative to the mount root. 0 if the slot is empty
+    char* path;
+} directory_file;
+
+typedef struct vfs_mount {
+    vfs_mount_type type;
+    // the directory, or the archive file
+    char root[VFS_MAX_PATH_LENGTH];
+    u32 root_length;
+
+    // archive mounts
+    file_mapping mapping;
+    const vfs_archive_header* header;
+    const vfs_archive_entry* entries;
+    const u32* slots;
+    const char* strings;
+
+    // directory mounts. guarded by directory_lock, as vfs_track_file can add to them at any time
+    directory_file* files;
+    u32 file_slot_count;
+    u32 file_count;
+} vfs_mount;
+
+// where a file was found
+typedef struct vfs_location {
+    vfs_mount* mount;
+    const vfs_archive_entry* entry;
+    const char* relative_path;
+} vfs_location;
+
+typedef struct vfs_system_state {
+    vfs_system_config config;
+    u32 mount_count;
+    vfs_mount* mounts;
+    kmutex directory_lock;
+} vfs_system_state;
+
+static vfs_system_state* state_ptr;
+
+// fnv-1a. paths are hashed as if every separator were a forward slash, so both kinds find the same file
+static u64 hash_path(const char* path) {
+    u64 hash = 0xcbf29ce484222325ULL;
+    for (const char* c = path; *c; ++c) {
+        u8 value = *c == '\\' ? '/' : (u8)*c;
+        hash ^= value;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static b8 paths_equal(const char* a, const char* b) {
+    while (*a && *b) {
+        char ca = *a == '\\' ? '/' : *a;
+        char cb = *b == '\\' ? '/' : *b;
+        if (ca != cb) {
+            return false;
+        }
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static i32 path_compare(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (i32)(u8)*a - (i32)(u8)*b;
+}
+
+static u32 round_up_pow2(u32 value) {
+    u32 result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// NOTE: begin directory mounts
+// directory_lock must be held
+static directory_file* directory_find(vfs_mount* mount, const char* path, u64 hash) {
+    if (!mount->file_slot_count) {
+        return 0;
+    }
+    u32 mask = mount->file_slot_count - 1;
+    for (u32 i = (u32)hash & mask;; i = (i + 1) & mask) {
+        directory_file* file = &mount->files[i];
+        if (!file->path) {
+            return 0;
+        }
+        if (file->hash == hash && paths_equal(file->path, path)) {
+            return file;
+        }
+    }
+}
+
+// directory_lock must be held
+static void directory_insert(vfs_mount* mount, const char* path) {
+    u64 hash = hash_path(path);
+    if (directory_find(mount, path, hash)) {
+        return;
+    }
+
+    // keep the table at most 3/4 full, so probes stay short
+    if ((mount->file_count + 1) * 4 > mount->file_slot_count * 3) {
+        u32 old_count = mount->file_slot_count;
+        directory_file* old_files = mount->files;
+        mount->file_slot_count = old_count ? old_count * 2 : 256;
+        mount->files = kallocate(sizeof(directory_file) * mount->file_slot_count, MEMORY_TAG_ARRAY);
+        u32 mask = mount->file_slot_count - 1;
+        for (u32 i = 0; i < old_count; ++i) {
+            if (old_files[i].path) {
+                u32 slot = (u32)old_files[i].hash & mask;
+                while (mount->files[slot].path) {
+                    slot = (slot + 1) & mask;
+                }
+                mount->files[slot] = old_files[i];
+            }
+        }
+        if (old_files) {
+            kfree(old_files, sizeof(directory_file) * old_count, MEMORY_TAG_ARRAY);
+        }
+    }
+
+    u32 mask = mount->file_slot_count - 1;
+    u32 slot = (u32)hash & mask;
+    while (mount->files[slot].path) {
+        slot = (slot + 1) & mask;
+    }
+    mount->files[slot].hash = hash;
+    mount->files[slot].path = string_duplicate(path);
+    mount->file_count++;
+}
+
+static void directory_walk_callback(const char* path, u64 size, void* user_data) {
+    directory_insert((vfs_mount*)user_data, path);
+}
+// NOTE: end directory mounts
+
+// NOTE: begin archive mounts
+static const vfs_archive_entry* archive_find(vfs_mount* mount, const char* path, u64 hash) {
+    u32 mask = mount->header->slot_count - 1;
+    // a valid table always has an empty slot, but a corrupt one might not, so never probe more than once around
+    for (u32 probe = 0, i = (u32)hash & mask; probe < mount->header->slot_count; ++probe, i = (i + 1) & mask) {
+        u32 index = mount->slots[i];
+        if (index == 0) {
+            return 0;
+        }
+        if (index > mount->header->entry_count) {
+            return 0;
+        }
+        const vfs_archive_entry* entry = &mount->entries[index - 1];
+        if (entry->hash == hash && entry->path_offset < mount->header->strings_size &&
+            paths_equal(mount->strings + entry->path_offset, path)) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+static b8 archive_validate(const file_mapping* mapping, const char* path) {
+    if (mapping->size < sizeof(vfs_archive_header)) {
+        KERROR("vfs_mount_archive - '%s' is too small to be an archive.", path);
+        return false;
+    }
+    const vfs_archive_header* header = mapping->data;
+    if (header->magic != VFS_ARCHIVE_MAGIC) {
+        KERROR("vfs_mount_archive - '%s' is not an archive.", path);
+        return false;
+    }
+    if (header->version != VFS_ARCHIVE_VERSION) {
+        KERROR("vfs_mount_archive - '%s' is version %u, but only version %u is supported.", path, header->version, VFS_ARCHIVE_VERSION);
+        return false;
+    }
+    if (header->file_size != mapping->size) {
+        KERROR("vfs_mount_archive - '%s' is %llu bytes, but should be %llu. It may be truncated.", path, mapping->size, header->file_size);
+        return false;
+    }
+    u64 size = mapping->size;
+    b8 valid = header->slot_count > header->entry_count &&
+               (header->slot_count & (header->slot_count - 1)) == 0 &&
+               header->entries_offset % 8 == 0 &&
+               header->entries_offset <= size && (u64)header->entry_count * sizeof(vfs_archive_entry) <= size - header->entries_offset &&
+               header->slots_offset % 4 == 0 &&
+               header->slots_offset <= size && (u64)header->slot_count * sizeof(u32) <= size - header->slots_offset &&
+               header->strings_offset <= size && header->strings_size <= size - header->strings_offset &&
+               header->strings_size > 0 && ((const char*)mapping->data)[header->strings_offset + header->strings_size - 1] == 0;
+    if (!valid) {
+        KERROR("vfs_mount_archive - '%s' has a corrupt table of contents.", path);
+        return false;
+    }
+    return true;
+}
+// NOTE: end archive mounts
+
+b8 vfs_system_initialize(u64* memory_requirement, void* state, vfs_system_config config) {
+    if (config.max_mount_count == 0) {
+        KFATAL("vfs_system_initialize - config.max_mount_count must be > 0.");
+        return false;
+    }
+
+    *memory_requirement = sizeof(vfs_system_state) + sizeof(vfs_mount) * config.max_mount_count;
+    if (state == 0) {
+        return true;
+    }
+
+    kzero_memory(state, *memory_requirement);
+    state_ptr = state;
+    state_ptr->config = config;
+    state_ptr->mounts = (vfs_mount*)((u8*)state + sizeof(vfs_system_state));
+    if (!kmutex_create(&state_ptr->directory_lock)) {
+        KERROR("vfs_system_initialize - failed to create mutex.");
+        return false;
+    }
+    return true;
+}
+
+void vfs_system_shutdown(void* state) {
+    if (!state_ptr) {
+        return;
+    }
+    for (u32 i = 0; i < state_ptr->mount_count; ++i) {
+        vfs_mount* mount = &state_ptr->mounts[i];
+        if (mount->type == VFS_MOUNT_TYPE_ARCHIVE) {
+            filesystem_unmap(&mount->mapping);
+        } else if (mount->files) {
+            for (u32 f = 0; f < mount->file_slot_count; ++f) {
+                if (mount->files[f].path) {
+                    kfree(mount->files[f].path, string_length(mount->files[f].path) + 1, MEMORY_TAG_STRING);
+                }
+            }
+            kfree(mount->files, sizeof(directory_file) * mount->file_slot_count, MEMORY_TAG_ARRAY);
+        }
+    }
+    kmutex_destroy(&state_ptr->directory_lock);
+    state_ptr = 0;
+}
+
+static vfs_mount* begin_mount(const char* path) {
+    if (!state_ptr || !path) {
+        return 0;
+    }
+    if (state_ptr->mount_count == state_ptr->config.max_mount_count) {
+        KERROR("Unable to mount '%s', all %u mounts are in use.", path, state_ptr->config.max_mount_count);
+        return 0;
+    }
+    u64 length = string_length(path);
+    if (length >= VFS_MAX_PATH_LENGTH) {
+        KERROR("Unable to mount '%s', the path is too long.", path);
+        return 0;
+    }
+
+    vfs_mount* mount = &state_ptr->mounts[state_ptr->mount_count];
+    kzero_memory(mount, sizeof(vfs_mount));
+    string_ncopy(mount->root, path, VFS_MAX_PATH_LENGTH);
+    // trailing separators would otherwise end up doubled when paths are joined
+    while (length > 1 && (mount->root[length - 1] == '/' || mount->root[length - 1] == '\\')) {
+        mount->root[--length] = 0;
+    }
+    mount->root_length = (u32)length;
+    return mount;
+}
+
+b8 vfs_mount_directory(const char* path) {
+    KPROFILE_SCOPE("vfs_mount_directory");
+    vfs_mount* mount = begin_mount(path);
+    if (!mount) {
+        return false;
+    }
+    mount->type = VFS_MOUNT_TYPE_DIRECTORY;
+
+    // mounting happens before anything is loaded, but the lock is cheap and keeps the walk honest
+    kmutex_lock(&state_ptr->directory_lock);
+    b8 result = filesystem_walk_directory(mount->root, directory_walk_callback, mount);
+    kmutex_unlock(&state_ptr->directory_lock);
+    if (!result) {
+        KERROR("vfs_mount_directory - failed to index '%s'.", path);
+        // keep whatever was indexed, a partial mount is more use than none
+    }
+
+    state_ptr->mount_count++;
+    KINFO("Mounted directory '%s' with %u files.", mount->root, mount->file_count);
+    return true;
+}
+
+b8 vfs_mount_archive(const char* path) {
+    vfs_mount* mount = begin_mount(path);
+    if (!mount) {
+        return false;
+    }
+    mount->type = VFS_MOUNT_TYPE_ARCHIVE;
+
+    // files are read all over the place, so leave read ahead to the os defaults rather than asking for sequential
+    if (!filesystem_map(path, FILE_ACCESS_PATTERN_NORMAL, &mount->mapping)) {
+        return false;
+    }
+    if (!archive_validate(&mount->mapping, path)) {
+        filesystem_unmap(&mount->mapping);
+        return false;
+    }
+
+    const u8* base = mount->mapping.data;
+    mount->header = (const vfs_archive_header*)base;
+    mount->entries = (const vfs_archive_entry*)(base + mount->header->entries_offset);
+    mount->slots = (const u32*)(base + mount->header->slots_offset);
+    mount->strings = (const char*)(base + mount->header->strings_offset);
+
+    state_ptr->mount_count++;
+    KINFO("Mounted archive '%s' with %u files.", path, mount->header->entry_count);
+    return true;
+}
+
+// later mounts are searched first, so they override earlier ones
+static b8 find(const char* path, vfs_location* out_location) {
+    if (!state_ptr) {
+        return false;
+    }
+    u64 hash = hash_path(path);
+    for (i32 i = (i32)state_ptr->mount_count - 1; i >= 0; --i) {
+        vfs_mount* mount = &state_ptr->mounts[i];
+        if (mount->type == VFS_MOUNT_TYPE_ARCHIVE) {
+            const vfs_archive_entry* entry = archive_find(mount, path, hash);
+            if (entry) {
+                out_location->mount = mount;
+                out_location->entry = entry;
+                out_location->relative_path = mount->strings + entry->path_offset;
+                return true;
+            }
+        } else {
+            kmutex_lock(&state_ptr->directory_lock);
+            directory_file* file = directory_find(mount, path, hash);
+            // the path string is never freed while mounted, so it is safe to hang on to past the lock
+            const char* relative_path = file ? file->path : 0;
+            kmutex_unlock(&state_ptr->directory_lock);
+            if (relative_path) {
+                out_location->mount = mount;
+                out_location->entry = 0;
+                out_location->relative_path = relative_path;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static b8 open_location(const vfs_location* location, vfs_file* out_file) {
+    kzero_memory(out_file, sizeof(vfs_file));
+    vfs_mount* mount = location->mount;
+
+    if (mount->type == VFS_MOUNT_TYPE_ARCHIVE) {
+        const vfs_archive_entry* entry = location->entry;
+        string_ncopy(out_file->path, location->relative_path, VFS_MAX_PATH_LENGTH - 1);
+        out_file->is_archived = true;
+        if (entry->offset > mount->mapping.size || entry->size > mount->mapping.size - entry->offset) {
+            KERROR("vfs_open - '%s' runs past the end of archive '%s'.", out_file->path, mount->root);
+            return false;
+        }
+        const u8* stored = (const u8*)mount->mapping.data + entry->offset;
+
+        if (entry->compression == VFS_COMPRESSION_NONE) {
+            out_file->storage = VFS_STORAGE_ARCHIVE;
+            out_file->data = entry->size ? stored : 0;
+            out_file->size = entry->size;
+            return true;
+        }
+        if (entry->compression == VFS_COMPRESSION_LZ4) {
+            u8* data = entry->uncompressed_size ? kallocate(entry->uncompressed_size, MEMORY_TAG_ARRAY) : 0;
+            if (!lz4_decompress(stored, entry->size, data, entry->uncompressed_size)) {
+                KERROR("vfs_open - '%s' in archive '%s' failed to decompress.", out_file->path, mount->root);
+                if (data) {
+                    kfree(data, entry->uncompressed_size, MEMORY_TAG_ARRAY);
+                }
+                return false;
+            }
+            out_file->storage = VFS_STORAGE_ALLOCATED;
+            out_file->data = data;
+            out_file->size = entry->uncompressed_size;
+            return true;
+        }
+        KERROR("vfs_open - '%s' in archive '%s' uses unknown compression %u.", out_file->path, mount->root, entry->compression);
+        return false;
+    }
+
+    if (mount->root_length + 1 + string_length(location->relative_path) >= VFS_MAX_PATH_LENGTH) {
+        KERROR("vfs_open - path too long: '%s/%s'", mount->root, location->relative_path);
+        return false;
+    }
+    string_format(out_file->path, "%s/%s", mount->root, location->relative_path);
+
+    // inside a fiber job read it asynchronously, so the worker runs other jobs while the read is in flight, rather
+    // than stalling on page faults through a mapping
+    if (job_system_is_on_fiber()) {
+        void* data = 0;
+        if (!async_io_read_file_wait(out_file->path, &data, &out_file->size)) {
+            return false;
+        }
+        out_file->storage = VFS_STORAGE_ALLOCATED;
+        out_file->data = data;
+        return true;
+    }
+    if (!filesystem_map(out_file->path, FILE_ACCESS_PATTERN_SEQUENTIAL, &out_file->mapping)) {
+        return false;
+    }
+    out_file->storage = VFS_STORAGE_MAPPED;
+    out_file->data = out_file->mapping.data;
+    out_file->size = out_file->mapping.size;
+    return true;
+}
+
+b8 vfs_exists(const char* path) {
+    vfs_location location;
+    return path && find(path, &location);
+}
+
+b8 vfs_open(const char* path, vfs_file* out_file) {
+    vfs_location location;
+    if (!path || !out_file || !find(path, &location)) {
+        return false;
+    }
+    return open_location(&location, out_file);
+}
+
+b8 vfs_open_any(const char* path, u32 extension_count, const char** extensions, vfs_file* out_file, u32* out_extension_index) {
+    if (!path || !out_file) {
+        return false;
+    }
+    u64 length = string_length(path);
+    char candidate[VFS_MAX_PATH_LENGTH];
+    for (u32 i = 0; i < extension_count; ++i) {
+        if (length + string_length(extensions[i]) >= VFS_MAX_PATH_LENGTH) {
+            continue;
+        }
+        string_format(candidate, "%s%s", path, extensions[i]);
+        vfs_location location;
+        if (find(candidate, &location)) {
+            if (out_extension_index) {
+                *out_extension_index = i;
+            }
+            return open_location(&location, out_file);
+        }
+    }
+    return false;
+}
+
+void vfs_close(vfs_file* file) {
+    if (!file) {
+        return;
+    }
+    if (file->storage == VFS_STORAGE_MAPPED) {
+        filesystem_unmap(&file->mapping);
+    } else if (file->storage == VFS_STORAGE_ALLOCATED && file->data) {
+        kfree((void*)file->data, file->size, MEMORY_TAG_ARRAY);
+    }
+    file->data = 0;
+    file->size = 0;
+    file->position = 0;
+    file->storage = VFS_STORAGE_ARCHIVE;
+}
+
+b8 vfs_read_line(vfs_file* file, u64 max_length, char** line_buf, u64* out_line_length) {
+    if (!file || !line_buf || !*line_buf || !out_line_length || max_length == 0 || file->position >= file->size) {
+        return false;
+    }
+    const char* source = (const char*)file->data + file->position;
+    u64 remaining = file->size - file->position;
+    char* buf = *line_buf;
+    u64 length = 0;
+    while (length < max_length - 1 && length < remaining) {
+        char c = source[length];
+        buf[length++] = c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    buf[length] = 0;
+    file->position += length;
+    *out_line_length = length;
+    return true;
+}
+
+void vfs_track_file(const char* path) {
+    if (!state_ptr || !path) {
+        return;
+    }
+    // the most recent directory mount it falls under gets it
+    for (i32 i = (i32)state_ptr->mount_count - 1; i >= 0; --i) {
+        vfs_mount* mount = &state_ptr->mounts[i];
+        if (mount->type != VFS_MOUNT_TYPE_DIRECTORY || !strings_nequal(path, mount->root, mount->root_length)) {
+            continue;
+        }
+        char separator = path[mount->root_length];
+        if ((separator != '/' && separator != '\\') || !path[mount->root_length + 1]) {
+            continue;
+        }
+        kmutex_lock(&state_ptr->directory_lock);
+        directory_insert(mount, path + mount->root_length + 1);
+        kmutex_unlock(&state_ptr->directory_lock);
+        return;
+    }
+}
+
+// NOTE: begin archive writing
+typedef struct archive_build_file {
+    u64 hash;
+    char* path;
+    u64 uncompressed_size;
+    u64 offset;
+    u64 size;
+    // the compressed data if it was worth keeping, otherwise the file is read again when the data is written
+    u8* compressed;
+    u64 compressed_capacity;
+    u32 compression;
+} archive_build_file;
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void build_files_destroy(archive_build_file* build_files, u32 file_count) {
+    for (u32 i = 0; i < file_count; ++i) {
+        if (build_files[i].path) {
+            kfree(build_files[i].path, string_length(build_files[i].path) + 1, MEMORY_TAG_STRING);
+        }
+        if (build_files[i].compressed) {
+            kfree(build_files[i].compressed, build_files[i].compressed_capacity, MEMORY_TAG_ARRAY);
+        }
+    }
+    kfree(build_files, sizeof(archive_build_file) * (file_count ? file_count : 1), MEMORY_TAG_ARRAY);
+}
+
+b8 vfs_archive_write(const char* output_path, u32 file_count, const vfs_archive_file* files, u32 alignment) {
+    KPROFILE_SCOPE("vfs_archive_write");
+    if (!output_path || (file_count && !files)) {
+        return false;
+    }
+    if (alignment == 0) {
+        alignment = VFS_ARCHIVE_DEFAULT_ALIGNMENT;
+    }
+    if ((alignment & (alignment - 1)) != 0) {
+        KERROR("vfs_archive_write - alignment must be a power of 2, got %u.", alignment);
+        return false;
+    }
+
+    // work out everything that goes in the table of contents first, compressing as we go, as the header comes first
+    archive_build_file* build_files = kallocate(sizeof(archive_build_file) * (file_count ? file_count : 1), MEMORY_TAG_ARRAY);
+    u64 strings_size = 0;
+    u32 compressed_count = 0;
+    for (u32 i = 0; i < file_count; ++i) {
+        archive_build_file* bf = &build_files[i];
+        bf->path = string_duplicate(files[i].path);
+        for (char* c = bf->path; *c; ++c) {
+            if (*c == '\\') {
+                *c = '/';
+            }
+        }
+        bf->hash = hash_path(bf->path);
+        strings_size += string_length(bf->path) + 1;
+
+        file_mapping mapping;
+        if (!filesystem_map(files[i].source_path, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+            KERROR("vfs_archive_write - unable to read '%s'.", files[i].source_path);
+            build_files_destroy(build_files, file_count);
+            return false;
+        }
+        bf->uncompressed_size = mapping.size;
+        bf->size = mapping.size;
+        bf->compression = VFS_COMPRESSION_NONE;
+        if (files[i].compress && mapping.size > 0) {
+            bf->compressed_capacity = lz4_compress_bound(mapping.size);
+            bf->compressed = kallocate(bf->compressed_capacity, MEMORY_TAG_ARRAY);
+            u64 compressed_size = lz4_compress(mapping.data, mapping.size, bf->compressed, bf->compressed_capacity);
+            if (compressed_size && compressed_size <= mapping.size - (mapping.size >> VFS_COMPRESSION_MIN_SAVING_SHIFT)) {
+                bf->size = compressed_size;
+                bf->compression = VFS_COMPRESSION_LZ4;
+                compressed_count++;
+            } else {
+                // already compressed formats (png, jpg) end up here
+                kfree(bf->compressed, bf->compressed_capacity, MEMORY_TAG_ARRAY);
+                bf->compressed = 0;
+                bf->compressed_capacity = 0;
+            }
+        }
+        filesystem_unmap(&mapping);
+    }
+
+    vfs_archive_header header = {0};
+    header.magic = VFS_ARCHIVE_MAGIC;
+    header.version = VFS_ARCHIVE_VERSION;
+    header.alignment = alignment;
+    header.entry_count = file_count;
+    // at most half full, and always with an empty slot to stop probing on
+    header.slot_count = round_up_pow2(file_count * 2 > 16 ? file_count * 2 : 16);
+    header.entries_offset = sizeof(vfs_archive_header);
+    header.slots_offset = header.entries_offset + sizeof(vfs_archive_entry) * (u64)file_count;
+    header.strings_offset = header.slots_offset + sizeof(u32) * (u64)header.slot_count;
+    header.strings_size = strings_size ? strings_size : 1;
+    u64 position = align_up(header.strings_offset + header.strings_size, alignment);
+    for (u32 i = 0; i < file_count; ++i) {
+        build_files[i].offset = position;
+        position = align_up(position + build_files[i].size, alignment);
+    }
+    header.file_size = position;
+
+    vfs_archive_entry* entries = kallocate(sizeof(vfs_archive_entry) * (file_count ? file_count : 1), MEMORY_TAG_ARRAY);
+    u32* slots = kallocate(sizeof(u32) * header.slot_count, MEMORY_TAG_ARRAY);
+    char* strings = kallocate(header.strings_size, MEMORY_TAG_ARRAY);
+    u32 string_offset = 0;
+    u32 mask = header.slot_count - 1;
+    b8 result = true;
+    for (u32 i = 0; i < file_count && result; ++i) {
+        archive_build_file* bf = &build_files[i];
+        vfs_archive_entry* entry = &entries[i];
+        entry->hash = bf->hash;
+        entry->offset = bf->offset;
+        entry->size = bf->size;
+        entry->uncompressed_size = bf->uncompressed_size;
+        entry->compression = bf->compression;
+        entry->path_offset = string_offset;
+        entry->path_length = (u32)string_length(bf->path);
+        kcopy_memory(strings + string_offset, bf->path, entry->path_length + 1);
+        string_offset += entry->path_length + 1;
+
+        u32 slot = (u32)bf->hash & mask;
+        while (slots[slot]) {
+            archive_build_file* other = &build_files[slots[slot] - 1];
+            if (other->hash == bf->hash && strings_equal(other->path, bf->path)) {
+                KERROR("vfs_archive_write - '%s' is in the archive more than once.", bf->path);
+                result = false;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = i + 1;
+    }
+
+    kbinary_writer writer;
+    if (result && !kbinary_writer_open(output_path, MEBIBYTES(1), &writer)) {
+        KERROR("vfs_archive_write - unable to open '%s' for writing.", output_path);
+        result = false;
+    }
+    if (result) {
+        // errors stick, so only the close needs checking
+        kbinary_write(&writer, sizeof(vfs_archive_header), &header);
+        kbinary_write(&writer, sizeof(vfs_archive_entry) * (u64)file_count, entries);
+        kbinary_write(&writer, sizeof(u32) * (u64)header.slot_count, slots);
+        kbinary_write(&writer, header.strings_size, strings);
+        for (u32 i = 0; i < file_count && !writer.failed; ++i) {
+            archive_build_file* bf = &build_files[i];
+            kbinary_write_pad_to(&writer, bf->offset);
+            if (bf->compressed) {
+                kbinary_write(&writer, bf->size, bf->compressed);
+            } else {
+                file_mapping mapping;
+                if (!filesystem_map(files[i].source_path, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+                    writer.failed = true;
+                    break;
+                }
+                // the source changing size between the passes would throw every offset after it out
+                if (mapping.size != bf->size) {
+                    writer.failed = true;
+                } else {
+                    kbinary_write(&writer, bf->size, mapping.data);
+                }
+                filesystem_unmap(&mapping);
+            }
+        }
+        kbinary_write_pad_to(&writer, header.file_size);
+        result = kbinary_writer_close(&writer);
+        if (!result) {
+            KERROR("vfs_archive_write - failed writing '%s'.", output_path);
+        }
+    }
+
+    kfree(strings, header.strings_size, MEMORY_TAG_ARRAY);
+    kfree(slots, sizeof(u32) * header.slot_count, MEMORY_TAG_ARRAY);
+    kfree(entries, sizeof(vfs_archive_entry) * (file_count ? file_count : 1), MEMORY_TAG_ARRAY);
+    build_files_destroy(build_files, file_count);
+
+    if (result) {
+        KINFO("Wrote archive '%s': %u files (%u compressed), %llu bytes.", output_path, file_count, compressed_count, header.file_size);
+    }
+    return result;
+}
+
+static void collect_walk_callback(const char* path, u64 size, void* user_data) {
+    char*** paths = user_data;
+    char* copy = string_duplicate(path);
+    darray_push(*paths, copy);
+}
+
+b8 vfs_archive_write_directory(const char* source_directory, const char* output_path, b8 compress) {
+    char** paths = darray_create(char*);
+    if (!filesystem_walk_directory(source_directory, collect_walk_callback, &paths)) {
+        for (u32 i = 0; i < darray_length(paths); ++i) {
+            kfree(paths[i], string_length(paths[i]) + 1, MEMORY_TAG_STRING);
+        }
+        darray_destroy(paths);
+        return false;
+    }
+
+    // sorted, so the same directory always makes the same archive no matter what order the os lists it in
+    u32 count = (u32)darray_length(paths);
+    for (u32 i = 1; i < count; ++i) {
+        char* path = paths[i];
+        u32 j = i;
+        while (j > 0 && path_compare(paths[j - 1], path) > 0) {
+            paths[j] = paths[j - 1];
+            j--;
+        }
+        paths[j] = path;
+    }
+
+    vfs_archive_file* files = kallocate(sizeof(vfs_archive_file) * (count ? count : 1), MEMORY_TAG_ARRAY);
+    char** source_paths = kallocate(sizeof(char*) * (count ? count : 1), MEMORY_TAG_ARRAY);
+    char source_path[VFS_MAX_PATH_LENGTH];
+    for (u32 i = 0; i < count; ++i) {
+        string_format(source_path, "%s/%s", source_directory, paths[i]);
+        source_paths[i] = string_duplicate(source_path);
+        files[i].path = paths[i];
+        files[i].source_path = source_paths[i];
+        files[i].compress = compress;
+    }
+
+    b8 result = vfs_archive_write(output_path, count, files, 0);
+
+    for (u32 i = 0; i < count; ++i) {
+        kfree(source_paths[i], string_length(source_paths[i]) + 1, MEMORY_TAG_STRING);
+        kfree(paths[i], string_length(paths[i]) + 1, MEMORY_TAG_STRING);
+    }
+    kfree(source_paths, sizeof(char*) * (count ? count : 1), MEMORY_TAG_ARRAY);
+    kfree(files, sizeof(vfs_archive_file) * (count ? count : 1), MEMORY_TAG_ARRAY);
+    darray_destroy(paths);
+    return result;
+}
+// NOTE: end archive writing
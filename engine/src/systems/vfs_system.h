@@ -0,0 +1,120 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+
+// the longest path the vfs handles, including the mount root
+#define VFS_MAX_PATH_LENGTH 512
+
+// the configuration for the vfs
+typedef struct vfs_system_config {
+    // @brief the max number of directories and archives that can be mounted at once
+    u32 max_mount_count;
+} vfs_system_config;
+
+// @brief how an archived file is stored
+typedef enum vfs_compression {
+    VFS_COMPRESSION_NONE = 0,
+    // @brief an lz4 block. see core/lz4.h
+    VFS_COMPRESSION_LZ4 = 1
+} vfs_compression;
+
+// @brief the contents of a file opened through the vfs. read only, and valid until vfs_close
+typedef struct vfs_file {
+    // @brief the contents of the file. 0 if the file is empty
+    const void* data;
+    // @brief the size of the file in bytes
+    u64 size;
+    // @brief where the next vfs_read_line picks up from
+    u64 position;
+    // @brief where the file was found. the real path for files in a mounted directory, or the path within the archive for
+    // archived files
+    char path[VFS_MAX_PATH_LENGTH];
+    // @brief true if the file came out of an archive
+    b8 is_archived;
+
+    // how data has to be released. internal
+    u8 storage;
+    file_mapping mapping;
+} vfs_file;
+
+// @brief a file to be written into an archive by vfs_archive_write
+typedef struct vfs_archive_file {
+    // @brief the path the file is looked up by once the archive is mounted, such as "textures/cobblestone.png"
+    const char* path;
+    // @brief where the file is read from while writing the archive
+    const char* source_path;
+    // @brief try compressing the file. it is only kept compressed if that saves a worthwhile amount
+    b8 compress;
+} vfs_archive_file;
+
+// initialize the vfs, - always call twice - on first pass pass in the memory requirement to get the memory required, and zero for the state
+// on the second pass - pass in the state as well as the memory requirement and actually initialize the system
+KAPI b8 vfs_system_initialize(u64* memory_requirement, void* state, vfs_system_config config);
+
+// shut down the vfs, unmounting everything
+KAPI void vfs_system_shutdown(void* state);
+
+// @brief mounts a directory. every file in it (and its subdirectories) can then be opened by its path relative to the
+// directory. the directory is indexed once here, so lookups afterwards never touch the file system. files written into
+// it after this need passing to vfs_track_file to be seen. mounts made later take priority over earlier ones
+// @param path the path of the directory
+// @return true on success, otherwise false
+KAPI b8 vfs_mount_directory(const char* path);
+
+// @brief mounts an archive written by vfs_archive_write. the archive is mapped into memory as a whole, so opening an
+// uncompressed file from it costs a hash lookup and nothing else. mounts made later take priority over earlier ones
+// @param path the path of the archive
+// @return true on success, otherwise false
+KAPI b8 vfs_mount_archive(const char* path);
+
+// @brief checks if a file can be found in any mount
+// @param path the path of the file, relative to the mounts
+// @return true if found, otherwise false
+KAPI b8 vfs_exists(const char* path);
+
+// @brief opens a file from whichever mount has it
+// @param path the path of the file, relative to the mounts
+// @param out_file a pointer to hold the opened file
+// @return true on success, otherwise false
+KAPI b8 vfs_open(const char* path, vfs_file* out_file);
+
+// @brief opens the first of path followed by each extension (in order) that can be found. finding each candidate is a
+// hash lookup rather than a trip to the file system
+// @param path the path of the file without an extension, relative to the mounts
+// @param extension_count the number of extensions
+// @param extensions the extensions to try, including the dot, in order of preference
+// @param out_file a pointer to hold the opened file
+// @param out_extension_index a pointer to hold the index of the extension that was found. optional
+// @return true on success, otherwise false
+KAPI b8 vfs_open_any(const char* path, u32 extension_count, const char** extensions, vfs_file* out_file, u32* out_extension_index);
+
+// @brief closes a file opened with vfs_open or vfs_open_any. its data must not be used after this
+KAPI void vfs_close(vfs_file* file);
+
+// @brief reads up to a newline or the end of the file, the same way filesystem_read_line does
+// @param file a pointer to the file
+// @param max_length the maximum length to be read, including the terminator
+// @param line_buf a pointer to a character array to be populated. must already be allocated
+// @param out_line_length a pointer to hold the length of the line read
+// @return true if a line was read, false at the end of the file
+KAPI b8 vfs_read_line(vfs_file* file, u64 max_length, char** line_buf, u64* out_line_length);
+
+// @brief lets the vfs know about a file written after the directory it is in was mounted, so it can be found
+// @param path the real path of the file, starting with the path the directory was mounted with
+KAPI void vfs_track_file(const char* path);
+
+// @brief writes an archive for vfs_mount_archive
+// @param output_path the path of the archive to write
+// @param file_count the number of files
+// @param files the files to write into the archive. paths must be unique
+// @param alignment the alignment of each file's data within the archive, a power of 2. 0 uses a default of 16
+// @return true on success, otherwise false
+KAPI b8 vfs_archive_write(const char* output_path, u32 file_count, const vfs_archive_file* files, u32 alignment);
+
+// @brief writes every file in a directory (and its subdirectories) into an archive, with paths relative to it
+// @param source_directory the directory to archive
+// @param output_path the path of the archive to write. should not be inside source_directory
+// @param compress try compressing each file
+// @return true on success, otherwise false
+KAPI b8 vfs_archive_write_directory(const char* source_directory, const char* output_path, b8 compress);
@@ -3,6 +3,9 @@
 #include <entry.h>
 
 #include <core/kmemory.h>
+#include <core/kstring.h>
+
+#include <stdlib.h>  // getenv
 
 // define the function to create a game
 b8 create_game(game* out_game) {
@@ -12,6 +15,25 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Kohi Engine Testbed";
+
+    // input recording/replay, off unless KOHI_INPUT_RECORDING is set to "record" or "replay".
+    // replays run on a fixed 60hz timestep so benchmark runs get the same camera path every time
+    out_game->app_config.input_recording.mode = INPUT_RECORDING_MODE_NONE;
+    out_game->app_config.input_recording.file_path = "input_recording.kir";
+    out_game->app_config.input_recording.fixed_timestep = 1.0 / 60.0;
+    const char* recording_mode = getenv("KOHI_INPUT_RECORDING");
+    if (recording_mode && strings_equali(recording_mode, "record")) {
+        out_game->app_config.input_recording.mode = INPUT_RECORDING_MODE_RECORD;
+    } else if (recording_mode && strings_equali(recording_mode, "replay")) {
+        out_game->app_config.input_recording.mode = INPUT_RECORDING_MODE_REPLAY;
+    }
+
+    // profiling, off unless KOHI_PROFILE is set to the path to write a chrome trace to on exit
+    const char* profile_path = getenv("KOHI_PROFILE");
+    out_game->app_config.profiler.enabled = profile_path != 0;
+    out_game->app_config.profiler.events_per_thread = 0;
+    out_game->app_config.profiler.capture_path = profile_path;
+
     out_game->update = game_update;          // send these functions to the engine
     out_game->render = game_render;          // send these functions to the engine
     out_game->initialize = game_initialize;  // send these functions to the engine
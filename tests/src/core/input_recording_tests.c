@@ -0,0 +1,196 @@
+#include "input_recording_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/event.h>
+#include <core/input.h>
+#include <core/input_recording.h>
+
+#include <stdio.h>  // remove
+
+#define INPUT_RECORDING_TEST_FILE "input_recording_tests.bin"
+#define INPUT_RECORDING_TEST_MAX_EVENTS 32
+#define INPUT_RECORDING_TEST_FRAME_COUNT 3
+
+// an input event as the input system fired it. only the fields each code fills in are kept
+typedef struct logged_event {
+    u16 code;
+    i16 a;
+    i16 b;
+} logged_event;
+
+typedef struct event_log {
+    u32 count;
+    logged_event events[INPUT_RECORDING_TEST_MAX_EVENTS];
+} event_log;
+
+static const u16 input_event_codes[] = {
+    EVENT_CODE_KEY_PRESSED,
+    EVENT_CODE_KEY_RELEASED,
+    EVENT_CODE_BUTTON_PRESSED,
+    EVENT_CODE_BUTTON_RELEASED,
+    EVENT_CODE_MOUSE_MOVED,
+    EVENT_CODE_MOUSE_WHEEL};
+
+static const f64 recorded_deltas[INPUT_RECORDING_TEST_FRAME_COUNT] = {0.016, 0.033, 0.25};
+
+static b8 log_event(u16 code, void* sender, void* listener_inst, event_context context) {
+    event_log* log = listener_inst;
+    if (log->count == INPUT_RECORDING_TEST_MAX_EVENTS) {
+        return false;
+    }
+    logged_event* e = &log->events[log->count++];
+    e->code = code;
+    e->b = 0;
+    if (code == EVENT_CODE_MOUSE_MOVED) {
+        e->a = context.data.i16[0];
+        e->b = context.data.i16[1];
+    } else if (code == EVENT_CODE_MOUSE_WHEEL) {
+        e->a = context.data.i8[0];
+    } else {
+        e->a = context.data.u16[0];
+    }
+    return false;
+}
+
+static b8 same_events(const event_log* a, const event_log* b) {
+    if (a->count != b->count) {
+        return false;
+    }
+    for (u32 i = 0; i < a->count; ++i) {
+        if (a->events[i].code != b->events[i].code || a->events[i].a != b->events[i].a || a->events[i].b != b->events[i].b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct input_test_systems {
+    void* event_state;
+    u64 event_size;
+    void* input_state;
+    u64 input_size;
+    void* recording_state;
+    u64 recording_size;
+} input_test_systems;
+
+// starts the event and input systems fresh, so key and button states start out released
+static void start_input(input_test_systems* systems, event_log* log) {
+    event_system_initialize(&systems->event_size, 0);
+    systems->event_state = kallocate(systems->event_size, MEMORY_TAG_APPLICATION);
+    event_system_initialize(&systems->event_size, systems->event_state);
+    input_system_initialize(&systems->input_size, 0);
+    systems->input_state = kallocate(systems->input_size, MEMORY_TAG_APPLICATION);
+    input_system_initialize(&systems->input_size, systems->input_state);
+    for (u32 i = 0; i < sizeof(input_event_codes) / sizeof(input_event_codes[0]); ++i) {
+        event_register(input_event_codes[i], log, log_event);
+    }
+}
+
+static b8 start_recording(input_test_systems* systems, input_recording_mode mode, f64 fixed_timestep) {
+    input_recording_config config = {0};
+    config.mode = mode;
+    config.file_path = INPUT_RECORDING_TEST_FILE;
+    config.fixed_timestep = fixed_timestep;
+    input_recording_initialize(&systems->recording_size, 0, config);
+    systems->recording_state = kallocate(systems->recording_size, MEMORY_TAG_APPLICATION);
+    if (!input_recording_initialize(&systems->recording_size, systems->recording_state, config)) {
+        kfree(systems->recording_state, systems->recording_size, MEMORY_TAG_APPLICATION);
+        systems->recording_state = 0;
+        return false;
+    }
+    return true;
+}
+
+static void stop_input(input_test_systems* systems) {
+    if (systems->recording_state) {
+        input_recording_shutdown(systems->recording_state);
+        kfree(systems->recording_state, systems->recording_size, MEMORY_TAG_APPLICATION);
+        systems->recording_state = 0;
+    }
+    input_system_shutdown(systems->input_state);
+    kfree(systems->input_state, systems->input_size, MEMORY_TAG_APPLICATION);
+    event_system_shutdown(systems->event_state);
+    kfree(systems->event_state, systems->event_size, MEMORY_TAG_APPLICATION);
+}
+
+// the input for each frame, fed in the way the platform layer would
+static void play_frame(u32 frame) {
+    switch (frame) {
+        case 0:
+            input_process_key(KEY_A, true);
+            input_process_mouse_move(10, 20);
+            input_process_button(BUTTON_LEFT, true);
+            break;
+        case 1:
+            input_process_mouse_wheel(-1);
+            input_process_key(KEY_A, false);
+            input_process_mouse_move(-5, 300);
+            input_process_button(BUTTON_LEFT, false);
+            input_process_mouse_wheel(2);
+            break;
+        default:
+            // a frame with nothing going on still has its delta
+            break;
+    }
+}
+
+u8 input_recording_should_replay_what_was_recorded() {
+    event_log* recorded = kallocate(sizeof(event_log), MEMORY_TAG_APPLICATION);
+    event_log* replayed = kallocate(sizeof(event_log), MEMORY_TAG_APPLICATION);
+    u32 frame_ends[INPUT_RECORDING_TEST_FRAME_COUNT];
+
+    input_test_systems systems = {0};
+    start_input(&systems, recorded);
+    expect_to_be_true(start_recording(&systems, INPUT_RECORDING_MODE_RECORD, 0));
+    expect_to_be_true(input_recording_is_recording());
+    for (u32 i = 0; i < INPUT_RECORDING_TEST_FRAME_COUNT; ++i) {
+        play_frame(i);
+        input_recording_end_frame(recorded_deltas[i]);
+        frame_ends[i] = recorded->count;
+    }
+    stop_input(&systems);
+    // recording lets the input through as it goes
+    expect_should_be(8, recorded->count);
+
+    start_input(&systems, replayed);
+    expect_to_be_true(start_recording(&systems, INPUT_RECORDING_MODE_REPLAY, 0));
+    expect_to_be_true(input_recording_is_replaying());
+    // live input is dropped while replaying
+    input_process_key(KEY_B, true);
+    expect_should_be(0, replayed->count);
+    for (u32 i = 0; i < INPUT_RECORDING_TEST_FRAME_COUNT; ++i) {
+        f64 delta = 0;
+        expect_to_be_true(input_recording_replay_frame(&delta));
+        expect_float_to_be(recorded_deltas[i], delta);
+        // each frame gets just its own input
+        expect_should_be(frame_ends[i], replayed->count);
+    }
+    f64 delta = 0;
+    expect_to_be_false(input_recording_replay_frame(&delta));
+    expect_to_be_true(same_events(recorded, replayed));
+    expect_to_be_false(input_is_key_down(KEY_B));
+    stop_input(&systems);
+
+    // a fixed timestep replaces the recorded deltas, the input stays the same
+    replayed->count = 0;
+    start_input(&systems, replayed);
+    expect_to_be_true(start_recording(&systems, INPUT_RECORDING_MODE_REPLAY, 0.01));
+    for (u32 i = 0; i < INPUT_RECORDING_TEST_FRAME_COUNT; ++i) {
+        expect_to_be_true(input_recording_replay_frame(&delta));
+        expect_float_to_be(0.01, delta);
+    }
+    expect_to_be_true(same_events(recorded, replayed));
+    stop_input(&systems);
+
+    remove(INPUT_RECORDING_TEST_FILE);
+    kfree(replayed, sizeof(event_log), MEMORY_TAG_APPLICATION);
+    kfree(recorded, sizeof(event_log), MEMORY_TAG_APPLICATION);
+    return true;
+}
+
+void input_recording_register_tests() {
+    test_manager_register_test(input_recording_should_replay_what_was_recorded, "Input recording should replay the recorded input and frame deltas in order.");
+}
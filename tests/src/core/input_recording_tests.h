@@ -0,0 +1,3 @@
+#pragma once
+
+void input_recording_register_tests();
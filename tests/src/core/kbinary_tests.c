@@ -0,0 +1,155 @@
+#include "kbinary_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kbinary.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+
+#include <stdio.h>  // remove
+
+#define KBINARY_TEST_FILE "kbinary_tests.bin"
+#define KBINARY_TEST_BLOCK_SIZE 10000
+
+u8 kbinary_should_round_trip_values_in_memory() {
+    kbinary_writer writer;
+    kbinary_writer_to_memory(16, &writer);
+    expect_to_be_true(kbinary_write_u8(&writer, 0xAB));
+    expect_to_be_true(kbinary_write_u16(&writer, 0x1234));
+    expect_to_be_true(kbinary_write_u32(&writer, 0xDEADBEEF));
+    expect_to_be_true(kbinary_write_u64(&writer, 0x0102030405060708ULL));
+    expect_to_be_true(kbinary_write_i32(&writer, -42));
+    expect_to_be_true(kbinary_write_f32(&writer, 1.5f));
+    expect_to_be_true(kbinary_write_string(&writer, "kohi"));
+    expect_to_be_true(kbinary_write_align(&writer, 64));
+
+    u64 size = 0;
+    const u8* data = kbinary_writer_data(&writer, &size);
+    // grew past the 16 bytes it started with, and the padding rounded it up
+    expect_should_be(64, size);
+    // little endian, whatever the platform
+    expect_should_be(0x34, data[1]);
+    expect_should_be(0x12, data[2]);
+    expect_should_be(0xEF, data[3]);
+
+    kbinary_reader reader;
+    kbinary_reader_from_memory(data, size, &reader);
+    u8 a = 0;
+    u16 b = 0;
+    u32 c = 0;
+    u64 d = 0;
+    i32 e = 0;
+    f32 f = 0;
+    char str[16];
+    expect_to_be_true(kbinary_read_u8(&reader, &a));
+    expect_to_be_true(kbinary_read_u16(&reader, &b));
+    expect_to_be_true(kbinary_read_u32(&reader, &c));
+    expect_to_be_true(kbinary_read_u64(&reader, &d));
+    expect_to_be_true(kbinary_read_i32(&reader, &e));
+    expect_to_be_true(kbinary_read_f32(&reader, &f));
+    expect_to_be_true(kbinary_read_string(&reader, sizeof(str), str));
+    expect_should_be(0xAB, a);
+    expect_should_be(0x1234, b);
+    expect_should_be(0xDEADBEEF, c);
+    expect_should_be(0x0102030405060708ULL, d);
+    expect_should_be(-42, e);
+    expect_float_to_be(1.5f, f);
+    expect_to_be_true(strings_equal("kohi", str));
+    expect_should_be(32, kbinary_reader_remaining(&reader));
+
+    kbinary_reader_close(&reader);
+    expect_to_be_true(kbinary_writer_close(&writer));
+    return true;
+}
+
+u8 kbinary_should_fail_reads_past_the_end() {
+    u8 data[] = {0x05, 0x00, 0x00, 0x00, 'a', 'b', 0x01, 0x02};
+    kbinary_reader reader;
+    kbinary_reader_from_memory(data, sizeof(data), &reader);
+
+    // the string says it is 5 long, but the buffer given is smaller
+    char str[4];
+    expect_to_be_false(kbinary_read_string(&reader, sizeof(str), str));
+    // and once failed, everything fails
+    u8 value = 0;
+    expect_to_be_false(kbinary_read_u8(&reader, &value));
+    expect_should_be(0, kbinary_reader_remaining(&reader));
+
+    // a read that doesn't fit takes nothing
+    kbinary_reader_from_memory(data, sizeof(data), &reader);
+    u64 big = 0;
+    expect_to_be_false(kbinary_read_u64(&reader, &big) && kbinary_read_u8(&reader, &value));
+    kbinary_reader_from_memory(data, sizeof(data), &reader);
+    big = 0;
+    expect_to_be_true(kbinary_read(&reader, 6, 0));
+    expect_to_be_false(kbinary_read_u32(&reader, (u32*)&big));
+    expect_should_be(0, big);
+
+    // a count that would overflow the size
+    kbinary_reader_from_memory(data, sizeof(data), &reader);
+    expect_to_be_false(kbinary_read_array(&reader, 0x8000000000000001ULL, 2, &big));
+    return true;
+}
+
+u8 kbinary_should_round_trip_through_a_buffered_file() {
+    u8* block = kallocate(KBINARY_TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < KBINARY_TEST_BLOCK_SIZE; ++i) {
+        block[i] = (u8)(i * 7);
+    }
+
+    // a small buffer, so both small values spanning a flush and blocks bigger than the buffer are covered
+    kbinary_writer writer;
+    expect_to_be_true(kbinary_writer_open(KBINARY_TEST_FILE, 64, &writer));
+    for (u32 i = 0; i < 100; ++i) {
+        kbinary_write_u32(&writer, i);
+    }
+    kbinary_write(&writer, KBINARY_TEST_BLOCK_SIZE, block);
+    kbinary_write_string(&writer, "end");
+    expect_should_be(400 + KBINARY_TEST_BLOCK_SIZE + 8, writer.position);
+    expect_to_be_true(kbinary_writer_close(&writer));
+
+    file_handle f;
+    expect_to_be_true(filesystem_open(KBINARY_TEST_FILE, FILE_MODE_READ, true, &f));
+    kbinary_reader reader;
+    expect_to_be_true(kbinary_reader_from_file(&f, 64, &reader));
+    b8 matched = true;
+    for (u32 i = 0; i < 100; ++i) {
+        u32 value = 0;
+        matched = matched && kbinary_read_u32(&reader, &value) && value == i;
+    }
+    expect_to_be_true(matched);
+    u8* read_block = kallocate(KBINARY_TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true(kbinary_read(&reader, KBINARY_TEST_BLOCK_SIZE, read_block));
+    for (u32 i = 0; matched && i < KBINARY_TEST_BLOCK_SIZE; ++i) {
+        matched = read_block[i] == block[i];
+    }
+    expect_to_be_true(matched);
+    char str[8];
+    expect_to_be_true(kbinary_read_string(&reader, sizeof(str), str));
+    expect_to_be_true(strings_equal("end", str));
+    expect_should_be(0, kbinary_reader_remaining(&reader));
+    u8 value = 0;
+    expect_to_be_false(kbinary_read_u8(&reader, &value));
+    kbinary_reader_close(&reader);
+    filesystem_close(&f);
+
+    // the same through a mapping
+    expect_to_be_true(kbinary_reader_open_mapped(KBINARY_TEST_FILE, &reader));
+    expect_should_be(400 + KBINARY_TEST_BLOCK_SIZE + 8, kbinary_reader_remaining(&reader));
+    expect_to_be_true(kbinary_read(&reader, 400 + KBINARY_TEST_BLOCK_SIZE, 0));
+    expect_to_be_true(kbinary_read_string(&reader, sizeof(str), str));
+    expect_to_be_true(strings_equal("end", str));
+    kbinary_reader_close(&reader);
+
+    remove(KBINARY_TEST_FILE);
+    kfree(read_block, KBINARY_TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    kfree(block, KBINARY_TEST_BLOCK_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void kbinary_register_tests() {
+    test_manager_register_test(kbinary_should_round_trip_values_in_memory, "Binary streams should round trip values in memory.");
+    test_manager_register_test(kbinary_should_fail_reads_past_the_end, "Binary streams should fail reads past the end.");
+    test_manager_register_test(kbinary_should_round_trip_through_a_buffered_file, "Binary streams should round trip through a buffered file.");
+}
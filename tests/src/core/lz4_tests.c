@@ -0,0 +1,88 @@
+#include "lz4_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/lz4.h>
+
+#define LZ4_TEST_SIZE 100000
+
+// compresses then decompresses data, checking it comes back the same. returns the compressed size, or 0 on failure
+static u64 round_trip(const u8* data, u64 size) {
+    u64 capacity = lz4_compress_bound(size);
+    u8* compressed = kallocate(capacity, MEMORY_TAG_ARRAY);
+    u8* decompressed = kallocate(size ? size : 1, MEMORY_TAG_ARRAY);
+
+    u64 compressed_size = lz4_compress(data, size, compressed, capacity);
+    b8 matched = compressed_size > 0 && lz4_decompress(compressed, compressed_size, decompressed, size);
+    for (u64 i = 0; matched && i < size; ++i) {
+        matched = decompressed[i] == data[i];
+    }
+
+    kfree(decompressed, size ? size : 1, MEMORY_TAG_ARRAY);
+    kfree(compressed, capacity, MEMORY_TAG_ARRAY);
+    return matched ? compressed_size : 0;
+}
+
+u8 lz4_should_round_trip_compressible_data() {
+    u8* data = kallocate(LZ4_TEST_SIZE, MEMORY_TAG_ARRAY);
+    // short repeating runs, with long overlapping matches mixed in
+    for (u32 i = 0; i < LZ4_TEST_SIZE; ++i) {
+        data[i] = (i % 5000) < 2500 ? (u8)(i % 7) : 'a';
+    }
+    u64 compressed_size = round_trip(data, LZ4_TEST_SIZE);
+    kfree(data, LZ4_TEST_SIZE, MEMORY_TAG_ARRAY);
+
+    expect_should_not_be(0, compressed_size);
+    // it should actually have compressed
+    expect_to_be_true(compressed_size < LZ4_TEST_SIZE / 10);
+    return true;
+}
+
+u8 lz4_should_round_trip_incompressible_and_tiny_data() {
+    u8* data = kallocate(LZ4_TEST_SIZE, MEMORY_TAG_ARRAY);
+    u32 state = 12345;
+    for (u32 i = 0; i < LZ4_TEST_SIZE; ++i) {
+        state = state * 1664525 + 1013904223;
+        data[i] = (u8)(state >> 24);
+    }
+    u64 compressed_size = round_trip(data, LZ4_TEST_SIZE);
+    expect_should_not_be(0, compressed_size);
+    expect_to_be_true(compressed_size <= lz4_compress_bound(LZ4_TEST_SIZE));
+
+    // sizes around the point matches stop being looked for
+    for (u64 size = 0; size < 32; ++size) {
+        expect_should_not_be(0, round_trip(data, size));
+    }
+    kfree(data, LZ4_TEST_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 lz4_should_reject_bad_input() {
+    u8 data[256];
+    for (u32 i = 0; i < 256; ++i) {
+        data[i] = (u8)(i / 16);
+    }
+    u8 compressed[512];
+    u8 decompressed[256];
+    u64 compressed_size = lz4_compress(data, 256, compressed, sizeof(compressed));
+    expect_should_not_be(0, compressed_size);
+
+    // too small a destination to compress into
+    expect_should_be(0, lz4_compress(data, 256, compressed, 16));
+    // the wrong decompressed size
+    expect_to_be_false(lz4_decompress(compressed, compressed_size, decompressed, 255));
+    // truncated
+    expect_to_be_false(lz4_decompress(compressed, compressed_size - 1, decompressed, 256));
+    // a match reaching back before the start of the output
+    u8 bad[] = {0x1F, 'a', 0x10, 0x00, 0x00};
+    expect_to_be_false(lz4_decompress(bad, sizeof(bad), decompressed, 256));
+    return true;
+}
+
+void lz4_register_tests() {
+    test_manager_register_test(lz4_should_round_trip_compressible_data, "LZ4 should round trip compressible data.");
+    test_manager_register_test(lz4_should_round_trip_incompressible_and_tiny_data, "LZ4 should round trip incompressible and tiny data.");
+    test_manager_register_test(lz4_should_reject_bad_input, "LZ4 should reject bad input.");
+}
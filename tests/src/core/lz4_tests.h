@@ -0,0 +1,3 @@
+#pragma once
+
+void lz4_register_tests();
@@ -0,0 +1,245 @@
+#include "threading_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kthread.h>
+#include <core/kmutex.h>
+#include <core/ksemaphore.h>
+#include <core/kcondvar.h>
+#include <core/katomic.h>
+
+#define THREAD_TEST_WORKER_COUNT 4
+#define THREAD_TEST_ITERATIONS 10000
+
+// shared between the test threads and the test itself
+typedef struct thread_test_data {
+    kmutex mutex;
+    ksemaphore semaphore;
+    kcondvar condvar;
+    ktls_slot slot;
+    volatile i32 counter;
+    volatile i32 atomic_counter;
+    i32 ready;
+    u64 thread_id;
+    b8 tls_matched;
+} thread_test_data;
+
+static KTHREAD_LOCAL i32 thread_local_value = 0;
+
+static u32 set_id_thread(void* params) {
+    thread_test_data* data = params;
+    data->thread_id = kthread_get_current_id();
+    return 0;
+}
+
+static u32 locked_increment_thread(void* params) {
+    thread_test_data* data = params;
+    for (u32 i = 0; i < THREAD_TEST_ITERATIONS; ++i) {
+        kmutex_lock(&data->mutex);
+        data->counter++;
+        kmutex_unlock(&data->mutex);
+    }
+    return 0;
+}
+
+static u32 atomic_increment_thread(void* params) {
+    thread_test_data* data = params;
+    for (u32 i = 0; i < THREAD_TEST_ITERATIONS; ++i) {
+        katomic_fetch_add_i32(&data->atomic_counter, 1, KATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+static u32 semaphore_signal_thread(void* params) {
+    thread_test_data* data = params;
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        ksemaphore_signal(&data->semaphore);
+    }
+    return 0;
+}
+
+static u32 condvar_producer_thread(void* params) {
+    thread_test_data* data = params;
+    kmutex_lock(&data->mutex);
+    data->ready = 1;
+    kcondvar_signal(&data->condvar);
+    kmutex_unlock(&data->mutex);
+    return 0;
+}
+
+static u32 tls_thread(void* params) {
+    thread_test_data* data = params;
+    // a fresh thread should see its own zeroed copies, not the values the test thread set
+    b8 matched = thread_local_value == 0 && ktls_slot_get(&data->slot) == 0;
+    thread_local_value = 2;
+    ktls_slot_set(&data->slot, (void*)2);
+    data->tls_matched = matched && thread_local_value == 2 && ktls_slot_get(&data->slot) == (void*)2;
+    return 0;
+}
+
+u8 thread_should_create_and_wait() {
+    thread_test_data data = {};
+    kthread thread;
+    expect_to_be_true(kthread_create(set_id_thread, &data, &thread));
+    expect_to_be_true(kthread_wait(&thread));
+
+    // the thread ran, and it was not this one
+    expect_should_not_be(0, data.thread_id);
+    expect_should_not_be(kthread_get_current_id(), data.thread_id);
+
+    // cant wait twice
+    expect_to_be_false(kthread_wait(&thread));
+    return true;
+}
+
+u8 thread_should_name_and_detach() {
+    thread_test_data data = {};
+    kmutex_create(&data.mutex);
+    // hold the lock so the thread cant finish before it has been named
+    kmutex_lock(&data.mutex);
+
+    kthread thread;
+    expect_to_be_true(kthread_create(locked_increment_thread, &data, &thread));
+#if KPLATFORM_LINUX || KPLATFORM_WINDOWS
+    expect_to_be_true(kthread_set_name(&thread, "a_thread_name_too_long_for_linux"));
+#endif
+    // no system has this many processors
+    expect_to_be_false(kthread_set_affinity(&thread, 100000));
+    expect_to_be_true(kthread_detach(&thread));
+    kmutex_unlock(&data.mutex);
+
+    // detached threads can't be waited on, so poll until it is done
+    b8 done = false;
+    while (!done) {
+        kmutex_lock(&data.mutex);
+        done = data.counter == THREAD_TEST_ITERATIONS;
+        kmutex_unlock(&data.mutex);
+        kthread_yield();
+    }
+    kmutex_destroy(&data.mutex);
+    return true;
+}
+
+u8 mutex_should_guard_shared_data() {
+    thread_test_data data = {};
+    expect_to_be_true(kmutex_create(&data.mutex));
+
+    kthread threads[THREAD_TEST_WORKER_COUNT];
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        expect_to_be_true(kthread_create(locked_increment_thread, &data, &threads[i]));
+    }
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        kthread_wait(&threads[i]);
+    }
+    expect_should_be(THREAD_TEST_WORKER_COUNT * THREAD_TEST_ITERATIONS, data.counter);
+
+    // try lock should fail while the lock is held, and succeed once it is released
+    expect_to_be_true(kmutex_lock(&data.mutex));
+    expect_to_be_false(kmutex_try_lock(&data.mutex));
+    expect_to_be_true(kmutex_unlock(&data.mutex));
+    expect_to_be_true(kmutex_try_lock(&data.mutex));
+    expect_to_be_true(kmutex_unlock(&data.mutex));
+
+    kmutex_destroy(&data.mutex);
+    expect_should_be(0, data.mutex.internal_data);
+    return true;
+}
+
+u8 semaphore_should_count_signals() {
+    thread_test_data data = {};
+    expect_to_be_true(ksemaphore_create(1, &data.semaphore));
+
+    // one to start with, then nothing left so the wait times out
+    expect_to_be_true(ksemaphore_wait(&data.semaphore, 0));
+    expect_to_be_false(ksemaphore_wait(&data.semaphore, 10));
+
+    // every signal from another thread lets exactly one wait through
+    kthread thread;
+    expect_to_be_true(kthread_create(semaphore_signal_thread, &data, &thread));
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        expect_to_be_true(ksemaphore_wait(&data.semaphore, KSEMAPHORE_WAIT_INFINITE));
+    }
+    kthread_wait(&thread);
+    expect_to_be_false(ksemaphore_wait(&data.semaphore, 0));
+
+    ksemaphore_destroy(&data.semaphore);
+    return true;
+}
+
+u8 condvar_should_wake_waiter() {
+    thread_test_data data = {};
+    expect_to_be_true(kmutex_create(&data.mutex));
+    expect_to_be_true(kcondvar_create(&data.condvar));
+
+    // nobody is signaling yet, so this times out with the lock held again
+    kmutex_lock(&data.mutex);
+    expect_to_be_false(kcondvar_wait(&data.condvar, &data.mutex, 10));
+
+    kthread thread;
+    expect_to_be_true(kthread_create(condvar_producer_thread, &data, &thread));
+    while (!data.ready) {
+        kcondvar_wait(&data.condvar, &data.mutex, KCONDVAR_WAIT_INFINITE);
+    }
+    kmutex_unlock(&data.mutex);
+    kthread_wait(&thread);
+    expect_should_be(1, data.ready);
+
+    kcondvar_destroy(&data.condvar);
+    kmutex_destroy(&data.mutex);
+    return true;
+}
+
+u8 thread_local_storage_should_be_per_thread() {
+    thread_test_data data = {};
+    expect_to_be_true(ktls_slot_create(&data.slot));
+
+    thread_local_value = 1;
+    expect_to_be_true(ktls_slot_set(&data.slot, (void*)1));
+
+    kthread thread;
+    expect_to_be_true(kthread_create(tls_thread, &data, &thread));
+    kthread_wait(&thread);
+    expect_to_be_true(data.tls_matched);
+
+    // the other thread's writes did not touch this thread's copies
+    expect_should_be(1, thread_local_value);
+    expect_should_be((void*)1, ktls_slot_get(&data.slot));
+
+    ktls_slot_destroy(&data.slot);
+    return true;
+}
+
+u8 atomics_should_not_lose_updates() {
+    thread_test_data data = {};
+    kthread threads[THREAD_TEST_WORKER_COUNT];
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        expect_to_be_true(kthread_create(atomic_increment_thread, &data, &threads[i]));
+    }
+    for (u32 i = 0; i < THREAD_TEST_WORKER_COUNT; ++i) {
+        kthread_wait(&threads[i]);
+    }
+    expect_should_be(THREAD_TEST_WORKER_COUNT * THREAD_TEST_ITERATIONS, katomic_load_i32(&data.atomic_counter, KATOMIC_SEQ_CST));
+
+    // compare exchange only swaps when the expected value matches, and reports the actual value when it does not
+    volatile i64 value = 5;
+    i64 expected = 4;
+    expect_to_be_false(katomic_compare_exchange_i64(&value, &expected, 10, KATOMIC_SEQ_CST));
+    expect_should_be(5, expected);
+    expect_to_be_true(katomic_compare_exchange_i64(&value, &expected, 10, KATOMIC_SEQ_CST));
+    expect_should_be(10, katomic_load_i64(&value, KATOMIC_SEQ_CST));
+    expect_should_be(10, katomic_exchange_i64(&value, 3, KATOMIC_SEQ_CST));
+    expect_should_be(3, katomic_fetch_add_i64(&value, 2, KATOMIC_SEQ_CST));
+    expect_should_be(5, value);
+    return true;
+}
+
+void threading_register_tests() {
+    test_manager_register_test(thread_should_create_and_wait, "Thread should create, run and be waited on.");
+    test_manager_register_test(thread_should_name_and_detach, "Thread should be named and detached.");
+    test_manager_register_test(mutex_should_guard_shared_data, "Mutex should guard data shared between threads.");
+    test_manager_register_test(semaphore_should_count_signals, "Semaphore should let one wait through per signal.");
+    test_manager_register_test(condvar_should_wake_waiter, "Condition variable should wake a waiting thread.");
+    test_manager_register_test(thread_local_storage_should_be_per_thread, "Thread local storage should be separate per thread.");
+    test_manager_register_test(atomics_should_not_lose_updates, "Atomics should not lose concurrent updates.");
+}
@@ -0,0 +1,49 @@
+#include "xxhash_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/xxhash.h>
+
+u8 xxhash64_should_match_reference_values() {
+    // values from the reference implementation
+    expect_should_be(0xEF46DB3751D8E999ULL, xxhash64(0, 0, 0));
+    expect_should_be(0x44BC2CF5AD770999ULL, xxhash64("abc", 3, 0));
+
+    // long enough to run all four lanes, with a tail left over
+    u8 data[100];
+    for (u32 i = 0; i < 100; ++i) {
+        data[i] = (u8)i;
+    }
+    expect_should_be(0x6AC1E58032166597ULL, xxhash64(data, 100, 0));
+    expect_should_be(0x028BA1AE2DE4DE27ULL, xxhash64(data, 100, 12345));
+    return true;
+}
+
+u8 xxhash64_streamed_should_match_one_shot() {
+    u8 data[300];
+    for (u32 i = 0; i < 300; ++i) {
+        data[i] = (u8)(i * 31 + 7);
+    }
+
+    // odd sized pieces, so stripes get split across updates
+    for (u64 size = 0; size <= 300; size += 13) {
+        xxhash64_state state;
+        xxhash64_begin(&state, 99);
+        u64 offset = 0;
+        u64 piece = 1;
+        while (offset < size) {
+            u64 count = size - offset < piece ? size - offset : piece;
+            xxhash64_update(&state, data + offset, count);
+            offset += count;
+            piece = piece * 3 % 41 + 1;
+        }
+        expect_should_be(xxhash64(data, size, 99), xxhash64_end(&state));
+    }
+    return true;
+}
+
+void xxhash_register_tests() {
+    test_manager_register_test(xxhash64_should_match_reference_values, "xxhash64 should match reference values.");
+    test_manager_register_test(xxhash64_streamed_should_match_one_shot, "xxhash64 streamed should match one shot.");
+}
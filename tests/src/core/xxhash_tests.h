@@ -0,0 +1,3 @@
+#pragma once
+
+void xxhash_register_tests();
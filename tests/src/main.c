@@ -4,6 +4,19 @@
 #include "containers/hashtable_tests.h"
 #include "containers/freelist_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "core/threading_tests.h"
+#include "core/lz4_tests.h"
+#include "core/xxhash_tests.h"
+#include "core/kbinary_tests.h"
+#include "core/input_recording_tests.h"
+#include "math/geometry_utils_tests.h"
+#include "resources/obj_parser_tests.h"
+#include "resources/mesh_loader_tests.h"
+#include "systems/job_system_tests.h"
+#include "systems/resource_system_tests.h"
+#include "systems/hot_reload_system_tests.h"
+#include "systems/vfs_system_tests.h"
+#include "platform/async_io_tests.h"
 
 #include <core/logger.h>
 
@@ -16,6 +29,19 @@ int main() {
     hashtable_register_tests();
     freelist_register_tests();
     dynamic_allocator_register_tests();
+    threading_register_tests();
+    lz4_register_tests();
+    xxhash_register_tests();
+    kbinary_register_tests();
+    input_recording_register_tests();
+    geometry_utils_register_tests();
+    obj_parser_register_tests();
+    mesh_loader_register_tests();
+    job_system_register_tests();
+    resource_system_register_tests();
+    hot_reload_system_register_tests();
+    vfs_system_register_tests();
+    async_io_register_tests();
 
     KDEBUG("starting tests...");
 
@@ -0,0 +1,788 @@
+#include "geometry_utils_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/xxhash.h>
+#include <math/geometry_utils.h>
+#include <math/kmath.h>
+
+// a quad as two separate triangles, the way the obj importer expands faces before welding
+static void make_quad(vertex_3d* out_vertices, u32* out_indices) {
+    kzero_memory(out_vertices, sizeof(vertex_3d) * 6);
+    f32 corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    for (u32 i = 0; i < 6; ++i) {
+        out_vertices[i].position = vec3_create(corners[i][0], corners[i][1], 0);
+        out_vertices[i].normal = vec3_create(0, 0, 1);
+        out_vertices[i].texcoord = vec2_create(corners[i][0], corners[i][1]);
+        out_vertices[i].colour = vec4_one();
+        out_indices[i] = i;
+    }
+}
+
+u8 geometry_weld_should_merge_identical_vertices() {
+    vertex_3d vertices[6];
+    u32 indices[6];
+    make_quad(vertices, indices);
+    // -0 is the same as 0
+    vertices[3].position.x = -0.0f;
+
+    u32 remap[6];
+    u32 count = 0;
+    vertex_3d* welded = 0;
+    geometry_weld_vertices(6, vertices, 6, indices, 0.0f, &count, &welded, remap);
+    expect_should_be(4, count);
+    // first appearances keep their order
+    u32 expected_indices[6] = {0, 1, 2, 0, 2, 3};
+    for (u32 i = 0; i < 6; ++i) {
+        expect_should_be(expected_indices[i], indices[i]);
+        expect_should_be(expected_indices[i], remap[i]);
+    }
+    expect_float_to_be(0.0f, welded[3].position.x);
+    expect_float_to_be(1.0f, welded[3].position.y);
+    kfree(welded, sizeof(vertex_3d) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_weld_should_respect_epsilon() {
+    vertex_3d vertices[6];
+    u32 indices[6];
+    make_quad(vertices, indices);
+    // a tiny bit off, as from rounding in an exporter
+    vertices[4].position.x = 1.0f + 0.00001f;
+
+    u32 count = 0;
+    vertex_3d* welded = 0;
+    geometry_weld_vertices(6, vertices, 6, indices, 0.0f, &count, &welded, 0);
+    expect_should_be(5, count);
+    kfree(welded, sizeof(vertex_3d) * count, MEMORY_TAG_ARRAY);
+
+    make_quad(vertices, indices);
+    vertices[4].position.x = 1.0f + 0.00001f;
+    geometry_weld_vertices(6, vertices, 6, indices, 0.001f, &count, &welded, 0);
+    expect_should_be(4, count);
+    expect_should_be(2, indices[4]);
+    kfree(welded, sizeof(vertex_3d) * count, MEMORY_TAG_ARRAY);
+
+    // attributes other than position count too
+    make_quad(vertices, indices);
+    vertices[3].texcoord.y = 0.5f;
+    geometry_weld_vertices(6, vertices, 6, indices, 0.001f, &count, &welded, 0);
+    expect_should_be(5, count);
+    kfree(welded, sizeof(vertex_3d) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_weld_should_scale_to_large_meshes() {
+    // a grid of quads, expanded into separate triangles. quadratic welding would take minutes
+    const u32 size = 300;
+    u32 vertex_count = size * size * 6;
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    f32 corners[6][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}};
+    for (u32 q = 0; q < size * size; ++q) {
+        for (u32 c = 0; c < 6; ++c) {
+            vertex_3d* v = &vertices[q * 6 + c];
+            v->position = vec3_create((f32)(q % size) + corners[c][0], (f32)(q / size) + corners[c][1], 0);
+            v->normal = vec3_create(0, 0, 1);
+            indices[q * 6 + c] = q * 6 + c;
+        }
+    }
+
+    u32 count = 0;
+    vertex_3d* welded = 0;
+    geometry_weld_vertices(vertex_count, vertices, vertex_count, indices, 0.0f, &count, &welded, 0);
+    expect_should_be((size + 1) * (size + 1), count);
+    b8 in_range = true;
+    for (u32 i = 0; i < vertex_count; ++i) {
+        in_range = in_range && indices[i] < count;
+    }
+    expect_to_be_true(in_range);
+
+    kfree(welded, sizeof(vertex_3d) * count, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+// a welded grid of size by size quads, with its triangles in a scrambled (but always the same) order, as a badly
+// exported mesh might be
+static void make_scrambled_grid(u32 size, vertex_3d** out_vertices, u32* out_vertex_count, u32** out_indices, u32* out_index_count) {
+    *out_vertex_count = (size + 1) * (size + 1);
+    *out_index_count = size * size * 6;
+    *out_vertices = kallocate(sizeof(vertex_3d) * *out_vertex_count, MEMORY_TAG_ARRAY);
+    *out_indices = kallocate(sizeof(u32) * *out_index_count, MEMORY_TAG_ARRAY);
+    for (u32 v = 0; v < *out_vertex_count; ++v) {
+        (*out_vertices)[v].position = vec3_create((f32)(v % (size + 1)), (f32)(v / (size + 1)), 0);
+        (*out_vertices)[v].normal = vec3_create(0, 0, 1);
+    }
+    u32* indices = *out_indices;
+    for (u32 q = 0; q < size * size; ++q) {
+        u32 corner = (q / size) * (size + 1) + q % size;
+        u32 quad[6] = {corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1};
+        kcopy_memory(&indices[q * 6], quad, sizeof(quad));
+    }
+    // fisher yates over the triangles, with a fixed lcg
+    u32 triangle_count = *out_index_count / 3;
+    u32 state = 12345;
+    for (u32 t = triangle_count - 1; t > 0; --t) {
+        state = state * 1664525u + 1013904223u;
+        u32 other = state % (t + 1);
+        for (u32 c = 0; c < 3; ++c) {
+            u32 temp = indices[t * 3 + c];
+            indices[t * 3 + c] = indices[other * 3 + c];
+            indices[other * 3 + c] = temp;
+        }
+    }
+}
+
+// a checksum of the triangles that doesn't depend on their order, or which corner each starts from, but does on winding
+static u64 triangle_set_checksum(const vertex_3d* vertices, u32 index_count, const u32* indices) {
+    u64 sum = 0;
+    for (u32 i = 0; i < index_count; i += 3) {
+        vec3 p[3] = {vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position};
+        u32 first = 0;
+        for (u32 c = 1; c < 3; ++c) {
+            if (p[c].x < p[first].x || (p[c].x == p[first].x && p[c].y < p[first].y)) {
+                first = c;
+            }
+        }
+        vec3 rotated[3] = {p[first], p[(first + 1) % 3], p[(first + 2) % 3]};
+        sum += xxhash64(rotated, sizeof(rotated), 0);
+    }
+    return sum;
+}
+
+u8 geometry_optimize_vertex_cache_should_lower_acmr() {
+    vertex_3d* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    make_scrambled_grid(64, &vertices, &vertex_count, &indices, &index_count);
+    u64 checksum = triangle_set_checksum(vertices, index_count, indices);
+
+    geometry_cache_stats before;
+    geometry_analyze_vertex_cache(vertex_count, index_count, indices, GEOMETRY_FIFO_CACHE_SIZE, &before);
+    // scrambled, almost every vertex misses
+    expect_to_be_true(before.acmr > 2.5f);
+
+    u32* second = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(second, indices, sizeof(u32) * index_count);
+    geometry_optimize_vertex_cache(vertex_count, index_count, indices);
+    geometry_optimize_vertex_cache(vertex_count, index_count, second);
+
+    geometry_cache_stats after;
+    geometry_analyze_vertex_cache(vertex_count, index_count, indices, GEOMETRY_FIFO_CACHE_SIZE, &after);
+    // a grid this size gets well under one miss per triangle
+    expect_to_be_true(after.acmr < 0.8f);
+    expect_to_be_true(after.atvr < 1.6f);
+    // the same triangles, in the same order every time
+    expect_should_be(checksum, triangle_set_checksum(vertices, index_count, indices));
+    b8 same = true;
+    for (u32 i = 0; i < index_count; ++i) {
+        same = same && indices[i] == second[i];
+    }
+    expect_to_be_true(same);
+
+    kfree(second, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_optimize_overdraw_and_fetch_should_keep_triangles() {
+    vertex_3d* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    make_scrambled_grid(32, &vertices, &vertex_count, &indices, &index_count);
+    u64 checksum = triangle_set_checksum(vertices, index_count, indices);
+
+    geometry_optimize_vertex_cache(vertex_count, index_count, indices);
+    geometry_cache_stats optimized;
+    geometry_analyze_vertex_cache(vertex_count, index_count, indices, GEOMETRY_FIFO_CACHE_SIZE, &optimized);
+    geometry_optimize_overdraw(vertex_count, vertices, index_count, indices, 1.05f);
+    expect_should_be(checksum, triangle_set_checksum(vertices, index_count, indices));
+    geometry_cache_stats reordered;
+    geometry_analyze_vertex_cache(vertex_count, index_count, indices, GEOMETRY_FIFO_CACHE_SIZE, &reordered);
+    expect_to_be_true(reordered.acmr <= optimized.acmr * 1.1f);
+
+    geometry_optimize_vertex_fetch(vertex_count, vertices, index_count, indices);
+    expect_should_be(checksum, triangle_set_checksum(vertices, index_count, indices));
+    // vertices are numbered in the order they are first used
+    u32 next = 0;
+    b8 in_order = true;
+    for (u32 i = 0; i < index_count; ++i) {
+        if (indices[i] == next) {
+            next++;
+        }
+        in_order = in_order && indices[i] < next;
+    }
+    expect_to_be_true(in_order);
+    expect_should_be(vertex_count, next);
+
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_simplify_should_keep_the_surface() {
+    vertex_3d* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    make_scrambled_grid(32, &vertices, &vertex_count, &indices, &index_count);
+
+    // a flat grid simplifies without moving the surface at all
+    u32 target = index_count / 4;
+    u32* simplified = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    u32* second = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    f32 error = 1.0f;
+    u32 count = geometry_simplify(vertex_count, vertices, index_count, indices, target, 0.01f, simplified, &error);
+    expect_to_be_true(count <= target);
+    expect_to_be_true(count > 0);
+    expect_float_to_be(0.0f, error);
+
+    // nothing folded over or left out, so the triangles still cover exactly the grid, all facing the same way
+    f32 area = 0.0f;
+    b8 valid = true;
+    for (u32 i = 0; i < count; i += 3) {
+        valid = valid && simplified[i] < vertex_count && simplified[i + 1] < vertex_count && simplified[i + 2] < vertex_count;
+        vec3 p0 = vertices[simplified[i]].position;
+        vec3 cross = vec3_cross(vec3_sub(vertices[simplified[i + 1]].position, p0), vec3_sub(vertices[simplified[i + 2]].position, p0));
+        valid = valid && cross.z > 0.0f;
+        area += cross.z * 0.5f;
+    }
+    expect_to_be_true(valid);
+    expect_float_to_be(32.0f * 32.0f, area);
+
+    // the same every time
+    u32 second_count = geometry_simplify(vertex_count, vertices, index_count, indices, target, 0.01f, second, 0);
+    expect_should_be(count, second_count);
+    b8 same = true;
+    for (u32 i = 0; i < count; ++i) {
+        same = same && simplified[i] == second[i];
+    }
+    expect_to_be_true(same);
+
+    // made rough, nothing can go without moving the surface further than it is allowed to
+    u32 state = 12345;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        state = state * 1664525u + 1013904223u;
+        vertices[v].position.z = (f32)(state >> 16) / 65536.0f;
+    }
+    count = geometry_simplify(vertex_count, vertices, index_count, indices, target, 0.01f, simplified, &error);
+    expect_should_be(index_count, count);
+    expect_to_be_true(error <= 0.01f);
+
+    kfree(second, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(simplified, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_pack_vertices_should_round_trip_closely() {
+    expect_should_be(20, sizeof(vertex_3d_packed));
+
+    const u32 vertex_count = 4096;
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    vertex_3d* unpacked = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    vertex_3d_packed* packed = kallocate(sizeof(vertex_3d_packed) * vertex_count, MEMORY_TAG_ARRAY);
+    vec3 min_extents = vec3_create(-30.0f, -2.0f, 5.0f);
+    vec3 max_extents = vec3_create(10.0f, 8.0f, 6.0f);
+    u32 state = 777;
+#define NEXT_UNIT() (state = state * 1664525u + 1013904223u, (f32)(state >> 8) / 16777216.0f)
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vertex_3d* vertex = &vertices[v];
+        for (u32 c = 0; c < 3; ++c) {
+            vertex->position.elements[c] = min_extents.elements[c] + NEXT_UNIT() * (max_extents.elements[c] - min_extents.elements[c]);
+        }
+        // every direction, including straight down the axes where the octahedron folds. values are drawn one
+        // statement at a time, as the order function arguments are worked out in isn't defined
+        if (v < 6) {
+            vertex->normal = vec3_zero();
+            vertex->normal.elements[v / 2] = v % 2 ? -1.0f : 1.0f;
+        } else {
+            for (u32 c = 0; c < 3; ++c) {
+                vertex->normal.elements[c] = NEXT_UNIT() * 2.0f - 1.0f;
+            }
+            vertex->normal = vec3_normalized(vertex->normal);
+        }
+        vec3 tangent = vec3_normalized(vec3_cross(vertex->normal, vec3_create(0.3f, 0.4f, 0.5f)));
+        vertex->tangent = vec4_create(tangent.x, tangent.y, tangent.z, v % 3 ? 1.0f : -1.0f);
+        f32 u = NEXT_UNIT() * 8.0f;
+        f32 t = NEXT_UNIT() * -2.0f;
+        vertex->texcoord = vec2_create(u, t);
+        vertex->colour = vec4_one();
+    }
+#undef NEXT_UNIT
+
+    expect_to_be_true(geometry_pack_vertices(vertex_count, vertices, min_extents, max_extents, packed));
+    geometry_unpack_vertices(vertex_count, packed, min_extents, max_extents, unpacked);
+
+    // positions to within half a step of the largest side, directions to within a hundredth of a degree or so, and
+    // texcoords to half float precision
+    f32 position_error = 0.0f;
+    f32 normal_dot = 1.0f;
+    f32 tangent_dot = 1.0f;
+    f32 texcoord_error = 0.0f;
+    b8 handedness = true;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 error = kabs(unpacked[v].position.elements[c] - vertices[v].position.elements[c]);
+            position_error = error > position_error ? error : position_error;
+        }
+        f32 dot = vec3_dot(unpacked[v].normal, vertices[v].normal);
+        normal_dot = dot < normal_dot ? dot : normal_dot;
+        vec3 tangent = vec3_create(vertices[v].tangent.x, vertices[v].tangent.y, vertices[v].tangent.z);
+        dot = vec3_dot(vec3_create(unpacked[v].tangent.x, unpacked[v].tangent.y, unpacked[v].tangent.z), tangent);
+        tangent_dot = dot < tangent_dot ? dot : tangent_dot;
+        handedness = handedness && unpacked[v].tangent.w == vertices[v].tangent.w;
+        for (u32 c = 0; c < 2; ++c) {
+            f32 error = kabs(unpacked[v].texcoord.elements[c] - vertices[v].texcoord.elements[c]);
+            texcoord_error = error > texcoord_error ? error : texcoord_error;
+        }
+    }
+    expect_to_be_true(position_error <= 40.0f / 65535.0f * 0.5f + 0.0001f);
+    expect_to_be_true(normal_dot > 0.99999f);
+    expect_to_be_true(tangent_dot > 0.99999f);
+    expect_to_be_true(handedness);
+    expect_to_be_true(texcoord_error <= 8.0f / 2048.0f);
+
+    // the one place the positions go through a matrix, as the material shader does with them
+    mat4 transform = geometry_packed_position_transform(min_extents, max_extents);
+    vec3 relative = vec3_create(packed[7].position[0] / 65535.0f, packed[7].position[1] / 65535.0f, packed[7].position[2] / 65535.0f);
+    expect_to_be_true(vec3_compare(vec3_transform(relative, transform), unpacked[7].position, 0.0001f));
+
+    // colour is dropped, so anything but a single colour is reported
+    vertices[vertex_count - 1].colour.r = 0.5f;
+    expect_to_be_false(geometry_pack_vertices(vertex_count, vertices, min_extents, max_extents, packed));
+
+    kfree(packed, sizeof(vertex_3d_packed) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(unpacked, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+// the largest difference between any normal, or any tangent, of two copies of the same mesh
+static f32 frame_difference(u32 vertex_count, const vertex_3d* a, const vertex_3d* b) {
+    f32 difference = 0.0f;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 normal = kabs(a[v].normal.elements[c] - b[v].normal.elements[c]);
+            f32 tangent = kabs(a[v].tangent.elements[c] - b[v].tangent.elements[c]);
+            difference = normal > difference ? normal : difference;
+            difference = tangent > difference ? tangent : difference;
+        }
+        f32 handedness = kabs(a[v].tangent.w - b[v].tangent.w);
+        difference = handedness > difference ? handedness : difference;
+    }
+    return difference;
+}
+
+u8 geometry_generate_frames_should_be_smooth_and_agree() {
+    geometry_simd_level best = geometry_simd_level_get();
+
+    // two triangles folded along x, one twice the area of the other. the vertices on the fold get the normals of both,
+    // weighted by area
+    vertex_3d fold[4];
+    kzero_memory(fold, sizeof(fold));
+    fold[0].position = vec3_create(0, 0, 0);
+    fold[1].position = vec3_create(1, 0, 0);
+    fold[2].position = vec3_create(0, 1, 0);
+    fold[3].position = vec3_create(0, 0, 2);
+    u32 fold_indices[6] = {0, 1, 2, 0, 3, 1};
+    geometry_generate_normals(4, fold, 6, fold_indices);
+    vec3 expected = vec3_normalized(vec3_create(0, 2, 1));
+    expect_to_be_true(vec3_compare(fold[0].normal, expected, 0.00001f));
+    expect_to_be_true(vec3_compare(fold[1].normal, expected, 0.00001f));
+    expect_to_be_true(vec3_compare(fold[2].normal, vec3_create(0, 0, 1), 0.00001f));
+
+    // a bumpy grid, with texture coordinates following x and y
+    const u32 size = 48;
+    vertex_3d* vertices = 0;
+    u32* indices = 0;
+    u32 vertex_count = 0;
+    u32 index_count = 0;
+    make_scrambled_grid(size, &vertices, &vertex_count, &indices, &index_count);
+    u32 state = 4242;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        state = state * 1664525u + 1013904223u;
+        vertices[v].position.z = (f32)(state >> 16) / 65536.0f * 0.5f;
+        vertices[v].texcoord = vec2_create(vertices[v].position.x / size, vertices[v].position.y / size);
+    }
+    // and one vertex in no triangle at all, which is left alone
+    vertex_3d* padded = kallocate(sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kcopy_memory(padded, vertices, sizeof(vertex_3d) * vertex_count);
+    padded[vertex_count].normal = vec3_create(0, 1, 0);
+    padded[vertex_count].tangent = vec4_create(0, 0, 1, 1);
+
+    // every instruction set gives the same answer as plain c
+    vertex_3d* reference = kallocate(sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    vertex_3d* other = kallocate(sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kcopy_memory(reference, padded, sizeof(vertex_3d) * (vertex_count + 1));
+    geometry_simd_level_set(GEOMETRY_SIMD_LEVEL_SCALAR);
+    geometry_generate_normals(vertex_count + 1, reference, index_count, indices);
+    geometry_generate_tangents(vertex_count + 1, reference, index_count, indices);
+    for (u32 level = GEOMETRY_SIMD_LEVEL_SSE; level <= best; ++level) {
+        kcopy_memory(other, padded, sizeof(vertex_3d) * (vertex_count + 1));
+        expect_should_be(level, geometry_simd_level_set(level));
+        geometry_generate_normals(vertex_count + 1, other, index_count, indices);
+        geometry_generate_tangents(vertex_count + 1, other, index_count, indices);
+        expect_to_be_true(frame_difference(vertex_count + 1, reference, other) < 0.00001f);
+    }
+    geometry_simd_level_set(best);
+
+    // unit length, upwards facing normals, with unit tangents perpendicular to them, pointing along x
+    b8 normals_up = true;
+    b8 tangents_perpendicular = true;
+    b8 tangents_along_x = true;
+    b8 handedness = true;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vec3 tangent = vec3_create(reference[v].tangent.x, reference[v].tangent.y, reference[v].tangent.z);
+        normals_up = normals_up && kabs(vec3_length(reference[v].normal) - 1.0f) < 0.0001f && reference[v].normal.z > 0.5f;
+        tangents_perpendicular = tangents_perpendicular && kabs(vec3_length(tangent) - 1.0f) < 0.0001f && kabs(vec3_dot(tangent, reference[v].normal)) < 0.0001f;
+        tangents_along_x = tangents_along_x && tangent.x > 0.5f;
+        // the same handedness as ever, -1 where the texture coordinates wind the same way as the triangles
+        handedness = handedness && reference[v].tangent.w == -1.0f;
+    }
+    expect_to_be_true(normals_up);
+    expect_to_be_true(tangents_perpendicular);
+    expect_to_be_true(tangents_along_x);
+    expect_to_be_true(handedness);
+    expect_to_be_true(vec3_compare(reference[vertex_count].normal, vec3_create(0, 1, 0), 0.0f));
+    expect_to_be_true(reference[vertex_count].tangent.z == 1.0f);
+
+    // with no texture coordinates to go by, tangents are still unit length and perpendicular
+    for (u32 v = 0; v < vertex_count; ++v) {
+        reference[v].texcoord = vec2_create(0, 0);
+    }
+    geometry_generate_tangents(vertex_count, reference, index_count, indices);
+    tangents_perpendicular = true;
+    for (u32 v = 0; v < vertex_count; ++v) {
+        vec3 tangent = vec3_create(reference[v].tangent.x, reference[v].tangent.y, reference[v].tangent.z);
+        tangents_perpendicular = tangents_perpendicular && kabs(vec3_length(tangent) - 1.0f) < 0.0001f && kabs(vec3_dot(tangent, reference[v].normal)) < 0.0001f;
+    }
+    expect_to_be_true(tangents_perpendicular);
+
+    kfree(other, sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(reference, sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(padded, sizeof(vertex_3d) * (vertex_count + 1), MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+// checks meshlets are back to back, cover every index, and keep to the limits, with every vertex in the bounding sphere
+// and every triangle facing within the cone
+static b8 meshlets_valid(const vertex_3d* vertices, u32 index_count, const u32* indices, u32 meshlet_count, const geometry_meshlet* meshlets) {
+    u32 offset = 0;
+    for (u32 m = 0; m < meshlet_count; ++m) {
+        const geometry_meshlet* meshlet = &meshlets[m];
+        if (meshlet->index_offset != offset || meshlet->index_count == 0 || meshlet->index_count % 3 != 0) {
+            return false;
+        }
+        if (meshlet->index_count / 3 > GEOMETRY_MESHLET_MAX_TRIANGLES) {
+            return false;
+        }
+        u32 unique[GEOMETRY_MESHLET_MAX_TRIANGLES * 3];
+        u32 unique_count = 0;
+        for (u32 i = meshlet->index_offset; i < meshlet->index_offset + meshlet->index_count; ++i) {
+            b8 seen = false;
+            for (u32 u = 0; u < unique_count && !seen; ++u) {
+                seen = unique[u] == indices[i];
+            }
+            if (!seen) {
+                unique[unique_count++] = indices[i];
+            }
+            if (vec3_distance(vertices[indices[i]].position, meshlet->center) > meshlet->radius * 1.0001f + 0.0001f) {
+                return false;
+            }
+        }
+        if (unique_count > GEOMETRY_MESHLET_MAX_VERTICES) {
+            return false;
+        }
+        if (meshlet->cone_cutoff < 1.0f) {
+            f32 min_dot = ksqrt(1.0f - meshlet->cone_cutoff * meshlet->cone_cutoff);
+            for (u32 i = meshlet->index_offset; i < meshlet->index_offset + meshlet->index_count; i += 3) {
+                vec3 p0 = vertices[indices[i]].position;
+                vec3 normal = vec3_normalized(vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0)));
+                if (vec3_dot(normal, meshlet->cone_axis) < min_dot - 0.001f) {
+                    return false;
+                }
+            }
+        }
+        offset += meshlet->index_count;
+    }
+    return offset == index_count;
+}
+
+static b8 same_bytes(const void* a, const void* b, u64 size) {
+    const u8* x = a;
+    const u8* y = b;
+    for (u64 i = 0; i < size; ++i) {
+        if (x[i] != y[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a uv sphere of the given radius around the origin, wound to face outwards
+static void make_sphere(u32 rings, u32 segments, f32 radius, vertex_3d** out_vertices, u32* out_vertex_count, u32** out_indices, u32* out_index_count) {
+    *out_vertex_count = (rings + 1) * (segments + 1);
+    *out_index_count = rings * segments * 6;
+    *out_vertices = kallocate(sizeof(vertex_3d) * *out_vertex_count, MEMORY_TAG_ARRAY);
+    *out_indices = kallocate(sizeof(u32) * *out_index_count, MEMORY_TAG_ARRAY);
+    for (u32 r = 0; r <= rings; ++r) {
+        f32 phi = K_PI * (f32)r / (f32)rings;
+        for (u32 s = 0; s <= segments; ++s) {
+            f32 theta = K_PI_2 * (f32)s / (f32)segments;
+            vec3 normal = vec3_create(ksin(phi) * kcos(theta), kcos(phi), -ksin(phi) * ksin(theta));
+            (*out_vertices)[r * (segments + 1) + s].position = vec3_mul_scalar(normal, radius);
+            (*out_vertices)[r * (segments + 1) + s].normal = normal;
+        }
+    }
+    u32 count = 0;
+    for (u32 r = 0; r < rings; ++r) {
+        for (u32 s = 0; s < segments; ++s) {
+            u32 a = r * (segments + 1) + s;
+            u32 b = a + segments + 1;
+            u32 quad[6] = {a, b, a + 1, a + 1, b, b + 1};
+            kcopy_memory(&(*out_indices)[count], quad, sizeof(quad));
+            count += 6;
+        }
+    }
+}
+
+u8 geometry_build_meshlets_should_cover_every_triangle_within_limits() {
+    vertex_3d* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    make_scrambled_grid(48, &vertices, &vertex_count, &indices, &index_count);
+    u64 checksum = triangle_set_checksum(vertices, index_count, indices);
+    u32* second = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kcopy_memory(second, indices, sizeof(u32) * index_count);
+
+    geometry_meshlet* meshlets = kallocate(sizeof(geometry_meshlet) * (index_count / 3), MEMORY_TAG_ARRAY);
+    geometry_meshlet* second_meshlets = kallocate(sizeof(geometry_meshlet) * (index_count / 3), MEMORY_TAG_ARRAY);
+    u32 meshlet_count = geometry_build_meshlets(vertex_count, vertices, index_count, indices, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, meshlets);
+    expect_to_be_true(meshlets_valid(vertices, index_count, indices, meshlet_count, meshlets));
+    expect_should_be(checksum, triangle_set_checksum(vertices, index_count, indices));
+    // scrambled or not, neighbours are found, so meshlets fill up rather than stopping at a triangle or two
+    expect_to_be_true(meshlet_count < (index_count / 3) / 48);
+    // all flat, so every cone is as tight as it gets
+    b8 flat = true;
+    for (u32 m = 0; m < meshlet_count; ++m) {
+        flat = flat && meshlets[m].cone_cutoff < 0.001f && meshlets[m].cone_axis.z > 0.999f;
+    }
+    expect_to_be_true(flat);
+
+    // the same every time
+    u32 second_count = geometry_build_meshlets(vertex_count, vertices, index_count, second, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, second_meshlets);
+    expect_should_be(meshlet_count, second_count);
+    expect_to_be_true(same_bytes(indices, second, sizeof(u32) * index_count));
+    expect_to_be_true(same_bytes(meshlets, second_meshlets, sizeof(geometry_meshlet) * meshlet_count));
+
+    // smaller limits are kept to as well
+    meshlet_count = geometry_build_meshlets(vertex_count, vertices, index_count, second, 3, 1, second_meshlets);
+    expect_should_be(index_count / 3, meshlet_count);
+    expect_to_be_true(meshlets_valid(vertices, index_count, second, meshlet_count, second_meshlets));
+
+    kfree(second_meshlets, sizeof(geometry_meshlet) * (index_count / 3), MEMORY_TAG_ARRAY);
+    kfree(meshlets, sizeof(geometry_meshlet) * (index_count / 3), MEMORY_TAG_ARRAY);
+    kfree(second, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 geometry_cull_meshlets_should_cull_conservatively() {
+    vertex_3d* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    make_sphere(32, 64, 1.0f, &vertices, &vertex_count, &indices, &index_count);
+    u32 meshlet_capacity = index_count / 3;
+    geometry_meshlet* meshlets = kallocate(sizeof(geometry_meshlet) * meshlet_capacity, MEMORY_TAG_ARRAY);
+    u32 meshlet_count = geometry_build_meshlets(vertex_count, vertices, index_count, indices, GEOMETRY_MESHLET_MAX_VERTICES, GEOMETRY_MESHLET_MAX_TRIANGLES, meshlets);
+    expect_to_be_true(meshlets_valid(vertices, index_count, indices, meshlet_count, meshlets));
+
+    // looking down -z from 5 units away
+    vec3 camera = vec3_create(0, 0, 5);
+    mat4 view = mat4_translation(vec3_create(0, 0, -5));
+    mat4 projection = mat4_perspective(deg_to_rad(45.0f), 1.0f, 0.1f, 100.0f);
+    frustum f = frustum_from_matrix(mat4_mul(view, projection));
+
+    geometry_index_range* ranges = kallocate(sizeof(geometry_index_range) * meshlet_count, MEMORY_TAG_ARRAY);
+    geometry_index_range* second = kallocate(sizeof(geometry_index_range) * meshlet_count, MEMORY_TAG_ARRAY);
+    u32 range_count = geometry_cull_meshlets(meshlet_count, meshlets, mat4_identity(), &f, camera, ranges);
+    expect_to_be_true(range_count > 0);
+
+    // in order, never touching (they would have been merged), and every triangle facing the camera is drawn
+    b8 ordered = true;
+    u32 drawn = 0;
+    for (u32 r = 0; r < range_count; ++r) {
+        ordered = ordered && ranges[r].index_count > 0 && ranges[r].index_offset + ranges[r].index_count <= index_count;
+        ordered = ordered && (r == 0 || ranges[r].index_offset > ranges[r - 1].index_offset + ranges[r - 1].index_count);
+        drawn += ranges[r].index_count;
+    }
+    expect_to_be_true(ordered);
+    b8 front_drawn = true;
+    for (u32 i = 0; i < index_count; i += 3) {
+        vec3 p0 = vertices[indices[i]].position;
+        vec3 normal = vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0));
+        if (vec3_dot(normal, vec3_sub(p0, camera)) >= 0.0f) {
+            continue;
+        }
+        b8 found = false;
+        for (u32 r = 0; r < range_count && !found; ++r) {
+            found = i >= ranges[r].index_offset && i < ranges[r].index_offset + ranges[r].index_count;
+        }
+        front_drawn = front_drawn && found;
+    }
+    expect_to_be_true(front_drawn);
+    // well over a third of the back of the sphere is culled
+    expect_to_be_true(drawn < index_count * 5 / 6);
+
+    // the same every time
+    u32 second_count = geometry_cull_meshlets(meshlet_count, meshlets, mat4_identity(), &f, camera, second);
+    expect_should_be(range_count, second_count);
+    expect_to_be_true(same_bytes(ranges, second, sizeof(geometry_index_range) * range_count));
+
+    // behind the camera, nothing is drawn
+    expect_should_be(0, geometry_cull_meshlets(meshlet_count, meshlets, mat4_translation(vec3_create(0, 0, 10)), &f, camera, ranges));
+
+    // scaled unevenly, cones can't be trusted, so everything in view is drawn
+    range_count = geometry_cull_meshlets(meshlet_count, meshlets, mat4_scale(vec3_create(1.0f, 0.5f, 1.0f)), &f, camera, ranges);
+    expect_should_be(1, range_count);
+    expect_should_be(0, ranges[0].index_offset);
+    expect_should_be(index_count, ranges[0].index_count);
+
+    kfree(second, sizeof(geometry_index_range) * meshlet_count, MEMORY_TAG_ARRAY);
+    kfree(ranges, sizeof(geometry_index_range) * meshlet_count, MEMORY_TAG_ARRAY);
+    kfree(meshlets, sizeof(geometry_meshlet) * meshlet_capacity, MEMORY_TAG_ARRAY);
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+// the volume a closed mesh holds, which is only positive if its triangles all wind counter clockwise seen from outside
+static f32 signed_volume(const vertex_3d* vertices, u32 index_count, const u32* indices) {
+    f32 volume = 0.0f;
+    for (u32 i = 0; i < index_count; i += 3) {
+        vec3 p0 = vertices[indices[i]].position;
+        volume += vec3_dot(p0, vec3_cross(vertices[indices[i + 1]].position, vertices[indices[i + 2]].position)) / 6.0f;
+    }
+    return volume;
+}
+
+u8 geometry_generate_shapes_should_be_closed_and_face_outwards() {
+    geometry_shape shapes[5];
+    kzero_memory(shapes, sizeof(shapes));
+    shapes[0].type = GEOMETRY_SHAPE_PLANE;
+    shapes[0].size = vec3_create(4.0f, 2.0f, 0.0f);
+    shapes[0].segments_x = 4;
+    shapes[0].segments_y = 2;
+    shapes[1].type = GEOMETRY_SHAPE_CUBE;
+    shapes[1].size = vec3_create(1.0f, 2.0f, 3.0f);
+    shapes[2].type = GEOMETRY_SHAPE_SPHERE;
+    shapes[2].size = vec3_create(2.0f, 2.0f, 2.0f);
+    shapes[2].segments_x = 64;
+    shapes[2].segments_y = 32;
+    shapes[3].type = GEOMETRY_SHAPE_CYLINDER;
+    shapes[3].size = vec3_create(2.0f, 3.0f, 2.0f);
+    shapes[3].segments_x = 64;
+    // the same cylinder again, mirrored, stretched and moved, which has to come out facing the right way still
+    shapes[4] = shapes[3];
+    for (u32 i = 0; i < 5; ++i) {
+        shapes[i].tiling = vec2_create(1.0f, 1.0f);
+        shapes[i].transform = mat4_identity();
+    }
+    vec3 moved_to = vec3_create(10.0f, 5.0f, 0.0f);
+    shapes[4].transform = mat4_mul(mat4_scale(vec3_create(-1.0f, 1.0f, 2.0f)), mat4_translation(moved_to));
+
+    u32 vertex_count, index_count;
+    geometry_shapes_size(5, shapes, &vertex_count, &index_count);
+    vertex_3d* vertices = kallocate(sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    u32* indices = kallocate(sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    geometry_index_range ranges[5];
+    geometry_generate_shapes(5, shapes, vertices, indices, ranges);
+
+    // one after the other, filling exactly what was asked for
+    b8 valid = true;
+    u32 offset = 0;
+    for (u32 i = 0; i < 5; ++i) {
+        valid = valid && ranges[i].index_offset == offset && ranges[i].index_count > 0;
+        offset += ranges[i].index_count;
+    }
+    for (u32 i = 0; i < index_count; ++i) {
+        valid = valid && indices[i] < vertex_count;
+    }
+    expect_to_be_true(valid);
+    expect_should_be(index_count, offset);
+
+    // the plane covers its whole size, facing +z
+    f32 area = 0.0f;
+    b8 facing = true;
+    for (u32 i = ranges[0].index_offset; i < ranges[0].index_offset + ranges[0].index_count; i += 3) {
+        vec3 p0 = vertices[indices[i]].position;
+        vec3 cross = vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0));
+        facing = facing && cross.z > 0.0f && vertices[indices[i]].normal.z == 1.0f;
+        area += cross.z * 0.5f;
+    }
+    expect_to_be_true(facing);
+    expect_float_to_be(8.0f, area);
+
+    // the closed shapes hold what they should, so they are closed and wound outwards. the round ones a little less,
+    // being made of flat faces
+    f32 volumes[5];
+    for (u32 i = 1; i < 5; ++i) {
+        volumes[i] = signed_volume(vertices, ranges[i].index_count, &indices[ranges[i].index_offset]);
+    }
+    expect_float_to_be(6.0f, volumes[1]);
+    expect_to_be_true(volumes[2] < 4.0f / 3.0f * K_PI);
+    expect_to_be_true(volumes[2] > 4.0f / 3.0f * K_PI * 0.99f);
+    expect_to_be_true(volumes[3] < 3.0f * K_PI);
+    expect_to_be_true(volumes[3] > 3.0f * K_PI * 0.99f);
+    expect_to_be_true(kabs(volumes[4] - volumes[3] * 2.0f) < 0.01f);
+
+    // every normal is unit length, and points out of the shape and the same way as its triangles
+    vec3 centres[5] = {vec3_zero(), vec3_zero(), vec3_zero(), vec3_zero(), moved_to};
+    b8 outwards = true;
+    for (u32 s = 1; s < 5; ++s) {
+        for (u32 i = ranges[s].index_offset; i < ranges[s].index_offset + ranges[s].index_count; i += 3) {
+            vec3 p0 = vertices[indices[i]].position;
+            vec3 cross = vec3_cross(vec3_sub(vertices[indices[i + 1]].position, p0), vec3_sub(vertices[indices[i + 2]].position, p0));
+            for (u32 c = 0; c < 3; ++c) {
+                const vertex_3d* v = &vertices[indices[i + c]];
+                vec3 tangent = vec3_create(v->tangent.x, v->tangent.y, v->tangent.z);
+                outwards = outwards && kabs(vec3_length(v->normal) - 1.0f) < 0.0001f && vec3_dot(v->normal, cross) > 0.0f;
+                outwards = outwards && vec3_dot(v->normal, vec3_sub(v->position, centres[s])) >= 0.0f;
+                outwards = outwards && kabs(vec3_length(tangent) - 1.0f) < 0.001f && kabs(vec3_dot(tangent, v->normal)) < 0.001f;
+            }
+        }
+    }
+    expect_to_be_true(outwards);
+
+    kfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    kfree(vertices, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void geometry_utils_register_tests() {
+    test_manager_register_test(geometry_weld_should_merge_identical_vertices, "Vertex welding should merge identical vertices.");
+    test_manager_register_test(geometry_weld_should_respect_epsilon, "Vertex welding should respect epsilon.");
+    test_manager_register_test(geometry_weld_should_scale_to_large_meshes, "Vertex welding should scale to large meshes.");
+    test_manager_register_test(geometry_optimize_vertex_cache_should_lower_acmr, "Vertex cache optimization should lower ACMR, deterministically.");
+    test_manager_register_test(geometry_optimize_overdraw_and_fetch_should_keep_triangles, "Overdraw and vertex fetch optimization should keep every triangle.");
+    test_manager_register_test(geometry_simplify_should_keep_the_surface, "Simplification should keep the surface, deterministically.");
+    test_manager_register_test(geometry_pack_vertices_should_round_trip_closely, "Packed vertices should round trip closely.");
+    test_manager_register_test(geometry_generate_frames_should_be_smooth_and_agree, "Normals and tangents should be smooth, and the same with or without simd.");
+    test_manager_register_test(geometry_build_meshlets_should_cover_every_triangle_within_limits, "Meshlets should cover every triangle within their limits, deterministically.");
+    test_manager_register_test(geometry_cull_meshlets_should_cull_conservatively, "Meshlet culling should be conservative and deterministic.");
+    test_manager_register_test(geometry_generate_shapes_should_be_closed_and_face_outwards, "Generated shapes should be closed and face outwards, however they are placed.");
+}
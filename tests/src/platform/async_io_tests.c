@@ -0,0 +1,296 @@
+#include "async_io_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/katomic.h>
+#include <core/kthread.h>
+#include <core/clock.h>
+#include <platform/filesystem.h>
+#include <platform/async_io.h>
+
+#include <stdio.h>  // remove
+
+#define ASYNC_IO_TEST_FILE "async_io_tests.bin"
+#define ASYNC_IO_TEST_MISSING_FILE "async_io_tests_missing.bin"
+#define ASYNC_IO_TEST_FILE_SIZE 1000
+#define ASYNC_IO_TEST_TIMEOUT_SECONDS 5.0
+
+typedef struct callback_data {
+    u32 call_count;
+    async_read_result result;
+} callback_data;
+
+static void read_complete(async_read_result result, void* user_data) {
+    callback_data* data = user_data;
+    data->call_count++;
+    data->result = result;
+}
+
+// each byte holds the low bits of its own offset, so a read from the wrong place shows up
+static b8 write_test_file() {
+    u8 bytes[ASYNC_IO_TEST_FILE_SIZE];
+    for (u32 i = 0; i < ASYNC_IO_TEST_FILE_SIZE; ++i) {
+        bytes[i] = (u8)(i * 7);
+    }
+    file_handle f;
+    if (!filesystem_open(ASYNC_IO_TEST_FILE, FILE_MODE_WRITE, true, &f)) {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&f, ASYNC_IO_TEST_FILE_SIZE, bytes, &written) && written == ASYNC_IO_TEST_FILE_SIZE;
+    filesystem_close(&f);
+    return result;
+}
+
+static b8 bytes_match_file(const void* data, u64 offset, u64 size) {
+    const u8* bytes = data;
+    for (u64 i = 0; i < size; ++i) {
+        if (bytes[i] != (u8)((offset + i) * 7)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void* start_async_io(b8 force_fallback, u64* out_size) {
+    async_io_config config = {0};
+    config.max_request_count = 16;
+    config.fallback_thread_count = 2;
+    config.force_fallback = force_fallback;
+    async_io_initialize(out_size, 0, config);
+    void* state = kallocate(*out_size, MEMORY_TAG_APPLICATION);
+    if (!async_io_initialize(out_size, state, config)) {
+        kfree(state, *out_size, MEMORY_TAG_APPLICATION);
+        return 0;
+    }
+    return state;
+}
+
+static void stop_async_io(void* state, u64 size) {
+    async_io_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+}
+
+static b8 wait_for_counter(job_counter* counter) {
+    clock timer;
+    clock_start(&timer);
+    while (katomic_load_i32(&counter->value, KATOMIC_ACQUIRE) > 0) {
+        clock_update(&timer);
+        if (timer.elapsed > ASYNC_IO_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+// polls until the read is done. false if it took too long
+static b8 wait_for_poll(async_read_handle handle, async_read_result* out_result) {
+    clock timer;
+    clock_start(&timer);
+    while (!async_io_poll(handle, out_result)) {
+        clock_update(&timer);
+        if (timer.elapsed > ASYNC_IO_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+// runs async_io_update until the callback has been called. false if it took too long
+static b8 wait_for_callback(callback_data* data) {
+    clock timer;
+    clock_start(&timer);
+    while (data->call_count == 0) {
+        async_io_update();
+        clock_update(&timer);
+        if (timer.elapsed > ASYNC_IO_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+// submits a read to be collected with async_io_poll and waits for it
+static b8 read_and_poll(const char* path, u64 offset, u64 size, async_read_result* out_result) {
+    async_read_info info = {0};
+    info.path = path;
+    info.offset = offset;
+    info.size = size;
+    async_read_handle handle = async_io_read(&info);
+    return handle && wait_for_poll(handle, out_result);
+}
+
+static u8 complete_reads_on(b8 force_fallback) {
+    u64 size = 0;
+    void* state = start_async_io(force_fallback, &size);
+    expect_should_not_be(0, state);
+    if (force_fallback) {
+        expect_to_be_false(async_io_is_using_io_uring());
+    }
+
+    // a callback, with a counter to know when the read has finished. the callback still waits for async_io_update
+    callback_data data = {0};
+    job_counter counter = {0};
+    async_read_info info = {0};
+    info.path = ASYNC_IO_TEST_FILE;
+    info.offset = 100;
+    info.size = 200;
+    info.callback = read_complete;
+    info.user_data = &data;
+    info.counter = &counter;
+    expect_should_not_be(0, async_io_read(&info));
+    expect_to_be_true(wait_for_counter(&counter));
+    expect_should_be(0, data.call_count);
+    async_io_update();
+    expect_should_be(1, data.call_count);
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, data.result.status);
+    expect_should_be(200, data.result.size);
+    expect_to_be_true(bytes_match_file(data.result.data, 100, 200));
+    kfree(data.result.data, data.result.size, MEMORY_TAG_ARRAY);
+    // and only the once
+    async_io_update();
+    expect_should_be(1, data.call_count);
+
+    // polling
+    async_read_result result = {0};
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, 0, 64, &result));
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, result.status);
+    expect_should_be(64, result.size);
+    expect_to_be_true(bytes_match_file(result.data, 0, 64));
+    kfree(result.data, result.size, MEMORY_TAG_ARRAY);
+
+    // a counter into a supplied buffer. once the counter is done the poll never has to wait
+    u8 buffer[300];
+    counter.value = 0;
+    async_read_info counted = {0};
+    counted.path = ASYNC_IO_TEST_FILE;
+    counted.offset = 700;
+    counted.size = sizeof(buffer);
+    counted.buffer = buffer;
+    counted.counter = &counter;
+    async_read_handle handle = async_io_read(&counted);
+    expect_should_not_be(0, handle);
+    expect_to_be_true(wait_for_counter(&counter));
+    expect_to_be_true(async_io_poll(handle, &result));
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, result.status);
+    expect_should_be(buffer, result.data);
+    expect_to_be_true(bytes_match_file(buffer, 700, sizeof(buffer)));
+    // the handle is gone once collected
+    expect_to_be_false(async_io_poll(handle, &result));
+
+    stop_async_io(state, size);
+    return true;
+}
+
+static u8 read_whole_files_on(b8 force_fallback) {
+    u64 size = 0;
+    void* state = start_async_io(force_fallback, &size);
+    expect_should_not_be(0, state);
+
+    async_read_result result = {0};
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, 0, 0, &result));
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, result.status);
+    expect_should_be(ASYNC_IO_TEST_FILE_SIZE, result.size);
+    expect_to_be_true(bytes_match_file(result.data, 0, ASYNC_IO_TEST_FILE_SIZE));
+    kfree(result.data, result.size, MEMORY_TAG_ARRAY);
+
+    // everything from the offset on
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, 600, 0, &result));
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, result.status);
+    expect_should_be(ASYNC_IO_TEST_FILE_SIZE - 600, result.size);
+    expect_to_be_true(bytes_match_file(result.data, 600, ASYNC_IO_TEST_FILE_SIZE - 600));
+    kfree(result.data, result.size, MEMORY_TAG_ARRAY);
+
+    // right at the end there is nothing left, which is not an error
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, ASYNC_IO_TEST_FILE_SIZE, 0, &result));
+    expect_should_be(ASYNC_READ_STATUS_COMPLETE, result.status);
+    expect_should_be(0, result.size);
+    expect_should_be(0, result.data);
+
+    void* data = 0;
+    u64 data_size = 0;
+    expect_to_be_true(async_io_read_file_wait(ASYNC_IO_TEST_FILE, &data, &data_size));
+    expect_should_be(ASYNC_IO_TEST_FILE_SIZE, data_size);
+    expect_to_be_true(bytes_match_file(data, 0, ASYNC_IO_TEST_FILE_SIZE));
+    kfree(data, data_size, MEMORY_TAG_ARRAY);
+
+    stop_async_io(state, size);
+    return true;
+}
+
+static u8 fail_bad_reads_on(b8 force_fallback) {
+    u64 size = 0;
+    void* state = start_async_io(force_fallback, &size);
+    expect_should_not_be(0, state);
+
+    async_read_result result = {0};
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, ASYNC_IO_TEST_FILE_SIZE + 1, 0, &result));
+    expect_should_be(ASYNC_READ_STATUS_FAILED, result.status);
+    expect_should_be(0, result.data);
+    expect_should_be(0, result.size);
+
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, 2000, 16, &result));
+    expect_should_be(ASYNC_READ_STATUS_FAILED, result.status);
+
+    // starts inside the file but runs off the end
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_FILE, 900, 200, &result));
+    expect_should_be(ASYNC_READ_STATUS_FAILED, result.status);
+    expect_should_be(0, result.data);
+
+    expect_to_be_true(read_and_poll(ASYNC_IO_TEST_MISSING_FILE, 0, 0, &result));
+    expect_should_be(ASYNC_READ_STATUS_FAILED, result.status);
+
+    // failures still come through the callback and release the counter
+    callback_data data = {0};
+    job_counter counter = {0};
+    async_read_info info = {0};
+    info.path = ASYNC_IO_TEST_FILE;
+    info.offset = ASYNC_IO_TEST_FILE_SIZE + 1;
+    info.callback = read_complete;
+    info.user_data = &data;
+    info.counter = &counter;
+    expect_should_not_be(0, async_io_read(&info));
+    expect_to_be_true(wait_for_callback(&data));
+    expect_should_be(0, counter.value);
+    expect_should_be(ASYNC_READ_STATUS_FAILED, data.result.status);
+    expect_should_be(0, data.result.data);
+
+    stop_async_io(state, size);
+    return true;
+}
+
+u8 async_io_should_complete_reads_by_callback_poll_and_counter() {
+    expect_to_be_true(write_test_file());
+    expect_to_be_true(complete_reads_on(true));
+    expect_to_be_true(complete_reads_on(false));
+    remove(ASYNC_IO_TEST_FILE);
+    return true;
+}
+
+u8 async_io_should_read_whole_files_without_a_size() {
+    expect_to_be_true(write_test_file());
+    expect_to_be_true(read_whole_files_on(true));
+    expect_to_be_true(read_whole_files_on(false));
+    remove(ASYNC_IO_TEST_FILE);
+    return true;
+}
+
+u8 async_io_should_fail_reads_past_the_end() {
+    expect_to_be_true(write_test_file());
+    expect_to_be_true(fail_bad_reads_on(true));
+    expect_to_be_true(fail_bad_reads_on(false));
+    remove(ASYNC_IO_TEST_FILE);
+    return true;
+}
+
+void async_io_register_tests() {
+    // each runs on the thread pool, then on io_uring where the platform has it (the thread pool again where it doesn't)
+    test_manager_register_test(async_io_should_complete_reads_by_callback_poll_and_counter, "Async io should complete reads by callback, poll and counter.");
+    test_manager_register_test(async_io_should_read_whole_files_without_a_size, "Async io should read to the end of a file when no size is given.");
+    test_manager_register_test(async_io_should_fail_reads_past_the_end, "Async io should fail reads past the end of a file.");
+}
@@ -0,0 +1,515 @@
+#include "mesh_loader_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kbinary.h>
+#include <core/kstring.h>
+#include <core/xxhash.h>
+#include <resources/loaders/mesh_loader.h>
+#include <platform/filesystem.h>
+#include <systems/vfs_system.h>
+
+#include <stdio.h>  // remove
+
+// where things are in a .ksm (version 2). see write_ksm_file
+#define KSM_HEADER_SIZE 48
+#define KSM_HEADER_SECTION_COUNT 8
+#define KSM_HEADER_FILE_SIZE 24
+#define KSM_HEADER_CHECKSUM 32
+#define KSM_SECTION_SIZE 32
+#define KSM_SECTION_OFFSET 8
+#define KSM_SECTION_LENGTH 16
+#define KSM_SECTION_TYPE_GEOMETRIES 1
+#define KSM_GEOMETRY_SIZE 72
+#define KSM_GEOMETRY_VERTEX_SIZE 0
+#define KSM_GEOMETRY_VERTEX_COUNT 4
+#define KSM_GEOMETRY_INDEX_SIZE 8
+#define KSM_GEOMETRY_INDEX_COUNT 12
+
+#define MANIFEST_TEST_MTL_SOURCE "mesh_loader_tests.mtl"
+#define MANIFEST_TEST_ARCHIVE "mesh_loader_tests.kpk"
+#define MANIFEST_TEST_CHANGED_ARCHIVE "mesh_loader_tests_changed.kpk"
+
+// faces before any usemtl, usemtl and g lines, and negative indices reaching back past the lines in between. small
+// chunks split it everywhere, including through the middle of each group
+static const char* test_obj =
+    "# a test model\n"
+    "mtllib shapes.mtl\n"
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n"
+    "vt 0 0\n"
+    "vt 1 0\n"
+    "vt 1 1\n"
+    "vt 0 1\n"
+    "vn 0 0 1\n"
+    "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+    "f 4 1 3\n"
+    "g first\n"
+    "usemtl red\n"
+    "v 0 0 1\n"
+    "v 1 0 1\n"
+    "v 1 1 1\n"
+    "vn 0 1 0\n"
+    "f 5//2 6//2 7//2\n"
+    "f -3 -2 -1\n"
+    "\n"
+    "f -7/-4/-2 -6/-3/-2 -5/-2/-2\n"
+    "f 1 2 99\n"
+    "usemtl blue\n"
+    "s off\n"
+    "f 1/1 3/3 4/4\n"
+    "g second\n"
+    "v 2 2 2\n"
+    "v 3 2 2\n"
+    "v 3 3 2\n"
+    "v 2 3 2\n"
+    "usemtl red\n"
+    "f -4 -3 -2 -1\n"
+    "f 1 2\n"
+    "f -1 -2 -12\n";
+
+static b8 same_bytes(const void* a, const void* b, u64 size) {
+    const u8* x = a;
+    const u8* y = b;
+    for (u64 i = 0; i < size; ++i) {
+        if (x[i] != y[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static b8 same_geometry(const geometry_config* a, const geometry_config* b) {
+    return strings_equal(a->name, b->name) && strings_equal(a->material_name, b->material_name) &&
+           a->vertex_size == b->vertex_size && a->vertex_count == b->vertex_count && a->index_size == b->index_size &&
+           a->index_count == b->index_count && a->lod_count == b->lod_count && a->meshlet_count == b->meshlet_count &&
+           same_bytes(a->vertices, b->vertices, (u64)a->vertex_size * a->vertex_count) &&
+           same_bytes(a->indices, b->indices, (u64)a->index_size * a->index_count) &&
+           same_bytes(a->lods, b->lods, sizeof(a->lods)) &&
+           same_bytes(a->meshlets, b->meshlets, sizeof(geometry_meshlet) * a->meshlet_count) &&
+           same_bytes(&a->min_extents, &b->min_extents, sizeof(vec3)) && same_bytes(&a->max_extents, &b->max_extents, sizeof(vec3));
+}
+
+// a bumpy grid of cells by cells quads, the first half in one material and the rest in another. big enough to be
+// simplified into levels of detail and split into meshlets
+static char* make_grid_obj(u32 cells, u64* out_capacity, u64* out_size) {
+    u32 side = cells + 1;
+    *out_capacity = (u64)side * side * 160 + (u64)cells * cells * 64 + 64;
+    char* text = kallocate(*out_capacity, MEMORY_TAG_STRING);
+    u64 size = 0;
+    for (u32 y = 0; y < side; ++y) {
+        for (u32 x = 0; x < side; ++x) {
+            f32 height = ksin((f32)x * 0.7f) * kcos((f32)y * 0.4f) * 0.5f;
+            size += string_format(text + size, "v %u %u %f\nvt %f %f\nvn 0 0 1\n", x, y, height, (f32)x / cells, (f32)y / cells);
+        }
+    }
+    for (u32 y = 0; y < cells; ++y) {
+        if (y == 0 || y == cells / 2) {
+            size += string_format(text + size, "usemtl %s\n", y ? "second" : "first");
+        }
+        for (u32 x = 0; x < cells; ++x) {
+            u32 v = y * side + x + 1;
+            size += string_format(text + size, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", v, v, v, v + 1, v + 1, v + 1, v + side + 1, v + side + 1, v + side + 1, v + side, v + side, v + side);
+        }
+    }
+    *out_size = size;
+    return text;
+}
+
+static void dispose_geometries(geometry_config* geometries) {
+    u32 count = darray_length(geometries);
+    for (u32 i = 0; i < count; ++i) {
+        geometry_system_config_dispose(&geometries[i]);
+    }
+    darray_destroy(geometries);
+}
+
+u8 mesh_loader_should_import_obj_text_into_groups() {
+    mesh_resource_params params = {};
+    geometry_config* geometries = darray_create(geometry_config);
+    u64 skipped_face_count = 0;
+    mesh_loader_import_obj_text(test_obj, string_length(test_obj), 0, &params, &geometries, &skipped_face_count);
+
+    // the faces before any g or usemtl, then first's two materials, then second's
+    expect_should_be(4, darray_length(geometries));
+    expect_to_be_true(strings_equal("", geometries[0].name));
+    expect_to_be_true(strings_equal("", geometries[0].material_name));
+    expect_to_be_true(strings_equal("first", geometries[1].name));
+    expect_to_be_true(strings_equal("red", geometries[1].material_name));
+    expect_to_be_true(strings_equal("first1", geometries[2].name));
+    expect_to_be_true(strings_equal("blue", geometries[2].material_name));
+    expect_to_be_true(strings_equal("second", geometries[3].name));
+    expect_to_be_true(strings_equal("red", geometries[3].material_name));
+
+    // a quad and a triangle, three triangles (the last of them reaching back past the g line), one triangle and another
+    // quad
+    expect_should_be(9, geometries[0].index_count);
+    expect_should_be(9, geometries[1].index_count);
+    expect_should_be(3, geometries[2].index_count);
+    expect_should_be(6, geometries[3].index_count);
+    // f 1 2 99, f 1 2 and the one reaching back before the first vertex
+    expect_should_be(3, skipped_face_count);
+
+    // the extents are of the positions each geometry's faces use
+    expect_float_to_be(0.0f, geometries[0].min_extents.z);
+    expect_float_to_be(0.0f, geometries[1].min_extents.z);
+    expect_float_to_be(1.0f, geometries[1].max_extents.z);
+    expect_float_to_be(2.0f, geometries[3].min_extents.x);
+    expect_float_to_be(3.0f, geometries[3].max_extents.y);
+
+    dispose_geometries(geometries);
+    return true;
+}
+
+u8 mesh_loader_should_import_the_same_however_the_obj_is_split() {
+    u64 size = string_length(test_obj);
+    // optimized, with levels of detail and meshlets, as models are cooked
+    mesh_resource_params params = mesh_loader_cook_params(false);
+    geometry_config* expected = darray_create(geometry_config);
+    u64 expected_skipped_face_count = 0;
+    mesh_loader_import_obj_text(test_obj, size, size, &params, &expected, &expected_skipped_face_count);
+    u32 count = darray_length(expected);
+    expect_should_be(4, count);
+
+    // from a chunk for every few characters (more than the chunks allowed, so they are capped) up to a couple of them
+    const u64 chunk_sizes[] = {1, 7, 16, 33, 64, 100, 250};
+    for (u32 c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++c) {
+        geometry_config* geometries = darray_create(geometry_config);
+        u64 skipped_face_count = 0;
+        mesh_loader_import_obj_text(test_obj, size, chunk_sizes[c], &params, &geometries, &skipped_face_count);
+        expect_should_be(expected_skipped_face_count, skipped_face_count);
+        expect_should_be(count, darray_length(geometries));
+        for (u32 i = 0; i < count; ++i) {
+            expect_to_be_true(same_geometry(&expected[i], &geometries[i]));
+        }
+        dispose_geometries(geometries);
+    }
+
+    dispose_geometries(expected);
+    return true;
+}
+
+// imports the grid the way models are cooked, then writes it to a .ksm in memory. the caller frees the result with
+// kfree(data, *out_size, MEMORY_TAG_ARRAY)
+static u8* make_ksm(b8 pack_streams, geometry_config** out_geometries_darray, u64* out_size) {
+    u64 capacity = 0;
+    u64 size = 0;
+    char* text = make_grid_obj(32, &capacity, &size);
+    mesh_resource_params params = mesh_loader_cook_params(pack_streams);
+    u64 skipped_face_count = 0;
+    mesh_loader_import_obj_text(text, size, 0, &params, out_geometries_darray, &skipped_face_count);
+    kfree(text, capacity, MEMORY_TAG_STRING);
+
+    kbinary_writer writer;
+    kbinary_writer_to_memory(KIBIBYTES(64), &writer);
+    u8* data = 0;
+    *out_size = 0;
+    if (mesh_loader_write_ksm(&writer, "grid", darray_length(*out_geometries_darray), *out_geometries_darray, pack_streams)) {
+        const void* written = kbinary_writer_data(&writer, out_size);
+        // a copy of just the right size, so reading past the end of it is caught
+        data = kallocate(*out_size, MEMORY_TAG_ARRAY);
+        kcopy_memory(data, written, *out_size);
+    }
+    kbinary_writer_close(&writer);
+    return data;
+}
+
+static void put_u64(u8* at, u64 value) {
+    kcopy_memory(at, &value, sizeof(u64));
+}
+
+static u32 get_u32(const u8* at) {
+    u32 value;
+    kcopy_memory(&value, at, sizeof(u32));
+    return value;
+}
+
+static void put_u32(u8* at, u32 value) {
+    kcopy_memory(at, &value, sizeof(u32));
+}
+
+// puts the right checksum back after changing the file, so the loader gets as far as what was changed
+static void fix_checksum(u8* data, u64 size) {
+    put_u64(data + KSM_HEADER_CHECKSUM, xxhash64(data + KSM_HEADER_SIZE, size - KSM_HEADER_SIZE, 0));
+}
+
+// expects a copy of the file to fail to load, without anything being left behind
+static b8 rejects(const u8* data, u64 size) {
+    u8* copy = kallocate(size ? size : 1, MEMORY_TAG_ARRAY);
+    kcopy_memory(copy, data, size);
+    geometry_config* geometries = darray_create(geometry_config);
+    b8 loaded = mesh_loader_read_ksm(copy, size, &geometries);
+    u32 count = darray_length(geometries);
+    dispose_geometries(geometries);
+    kfree(copy, size ? size : 1, MEMORY_TAG_ARRAY);
+    return !loaded && count == 0;
+}
+
+u8 ksm_should_round_trip_geometries() {
+    u64 sizes[2] = {0, 0};
+    for (u32 pack = 0; pack < 2; ++pack) {
+        geometry_config* expected = darray_create(geometry_config);
+        u64 size = 0;
+        u8* data = make_ksm(pack, &expected, &size);
+        expect_to_be_true(data != 0);
+        sizes[pack] = size;
+        u32 count = darray_length(expected);
+        expect_should_be(2, count);
+        // everything the format holds is there to be checked
+        expect_to_be_true(expected[0].lod_count > 1);
+        expect_to_be_true(expected[0].meshlet_count > 0);
+
+        geometry_config* geometries = darray_create(geometry_config);
+        expect_to_be_true(mesh_loader_read_ksm(data, size, &geometries));
+        expect_should_be(count, darray_length(geometries));
+        for (u32 i = 0; i < count; ++i) {
+            expect_to_be_true(same_geometry(&expected[i], &geometries[i]));
+            expect_to_be_true(same_bytes(&expected[i].center, &geometries[i].center, sizeof(vec3)));
+        }
+
+        dispose_geometries(geometries);
+        dispose_geometries(expected);
+        kfree(data, size, MEMORY_TAG_ARRAY);
+    }
+    // packing is worth it on a mesh like this
+    expect_to_be_true(sizes[1] < sizes[0]);
+    return true;
+}
+
+u8 ksm_should_reject_truncated_files() {
+    for (u32 pack = 0; pack < 2; ++pack) {
+        geometry_config* geometries = darray_create(geometry_config);
+        u64 size = 0;
+        u8* data = make_ksm(pack, &geometries, &size);
+        dispose_geometries(geometries);
+        expect_to_be_true(data != 0);
+
+        // cut off anywhere
+        for (u64 length = 0; length < size; ++length) {
+            expect_to_be_true(rejects(data, length));
+        }
+
+        // cut off anywhere after the section table, with the header changed to agree, so it is the sections that run
+        // off the end
+        u32 section_count = get_u32(data + KSM_HEADER_SECTION_COUNT);
+        for (u64 length = KSM_HEADER_SIZE + (u64)section_count * KSM_SECTION_SIZE; length < size; length += 61) {
+            put_u64(data + KSM_HEADER_FILE_SIZE, length);
+            fix_checksum(data, length);
+            expect_to_be_true(rejects(data, length));
+        }
+        kfree(data, size, MEMORY_TAG_ARRAY);
+    }
+    return true;
+}
+
+u8 ksm_should_reject_a_bad_checksum() {
+    geometry_config* geometries = darray_create(geometry_config);
+    u64 size = 0;
+    u8* data = make_ksm(true, &geometries, &size);
+    dispose_geometries(geometries);
+    expect_to_be_true(data != 0);
+
+    // a bit flipped anywhere after the header, or in the checksum itself
+    const u64 positions[] = {KSM_HEADER_SIZE, KSM_HEADER_SIZE + KSM_SECTION_OFFSET, size / 2, size - 1, KSM_HEADER_CHECKSUM};
+    for (u32 i = 0; i < sizeof(positions) / sizeof(positions[0]); ++i) {
+        data[positions[i]] ^= 0x10;
+        expect_to_be_true(rejects(data, size));
+        data[positions[i]] ^= 0x10;
+    }
+
+    // and with everything put back, it loads
+    expect_to_be_false(rejects(data, size));
+    kfree(data, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 ksm_should_reject_sections_outside_the_file() {
+    for (u32 pack = 0; pack < 2; ++pack) {
+        geometry_config* geometries = darray_create(geometry_config);
+        u64 size = 0;
+        u8* data = make_ksm(pack, &geometries, &size);
+        dispose_geometries(geometries);
+        expect_to_be_true(data != 0);
+
+        u32 section_count = get_u32(data + KSM_HEADER_SECTION_COUNT);
+        expect_to_be_true(section_count > 4);
+        u8* original = kallocate(size, MEMORY_TAG_ARRAY);
+        kcopy_memory(original, data, size);
+        for (u32 i = 0; i < section_count; ++i) {
+            u8* section = data + KSM_HEADER_SIZE + (u64)i * KSM_SECTION_SIZE;
+            u64 length;
+            kcopy_memory(&length, section + KSM_SECTION_LENGTH, sizeof(u64));
+
+            // starting a byte too late, so the end is past the end of the file
+            put_u64(section + KSM_SECTION_OFFSET, size - length + 1);
+            fix_checksum(data, size);
+            expect_to_be_true(rejects(data, size));
+
+            // so far along that the end wraps around
+            put_u64(section + KSM_SECTION_OFFSET, 0xFFFFFFFFFFFFFFF0ULL);
+            fix_checksum(data, size);
+            expect_to_be_true(rejects(data, size));
+
+            // bigger than the file
+            kcopy_memory(data, original, size);
+            put_u64(section + KSM_SECTION_LENGTH, size + 1);
+            fix_checksum(data, size);
+            expect_to_be_true(rejects(data, size));
+
+            kcopy_memory(data, original, size);
+        }
+        kfree(original, size, MEMORY_TAG_ARRAY);
+        kfree(data, size, MEMORY_TAG_ARRAY);
+    }
+    return true;
+}
+
+// halves a size in a geometry record and doubles the count after it, so the stream is still the size the section says
+// and it is only the size itself that is wrong
+static void halve_stride(u8* record, u32 size_offset, u32 count_offset) {
+    put_u32(record + size_offset, get_u32(record + size_offset) / 2);
+    put_u32(record + count_offset, get_u32(record + count_offset) * 2);
+}
+
+u8 ksm_should_reject_unknown_vertex_and_index_sizes() {
+    for (u32 pack = 0; pack < 2; ++pack) {
+        geometry_config* geometries = darray_create(geometry_config);
+        u64 size = 0;
+        u8* data = make_ksm(pack, &geometries, &size);
+        u32 geometry_count = darray_length(geometries);
+        dispose_geometries(geometries);
+        expect_to_be_true(data != 0);
+
+        u8* records = 0;
+        u32 section_count = get_u32(data + KSM_HEADER_SECTION_COUNT);
+        for (u32 i = 0; i < section_count && !records; ++i) {
+            u8* section = data + KSM_HEADER_SIZE + (u64)i * KSM_SECTION_SIZE;
+            if (get_u32(section) == KSM_SECTION_TYPE_GEOMETRIES) {
+                u64 offset;
+                kcopy_memory(&offset, section + KSM_SECTION_OFFSET, sizeof(u64));
+                records = data + offset;
+            }
+        }
+        expect_to_be_true(records != 0);
+
+        u8* original = kallocate(size, MEMORY_TAG_ARRAY);
+        kcopy_memory(original, data, size);
+        for (u32 i = 0; i < geometry_count; ++i) {
+            u8* record = records + (u64)i * KSM_GEOMETRY_SIZE;
+
+            halve_stride(record, KSM_GEOMETRY_VERTEX_SIZE, KSM_GEOMETRY_VERTEX_COUNT);
+            fix_checksum(data, size);
+            expect_to_be_true(rejects(data, size));
+            kcopy_memory(data, original, size);
+
+            // 16 bit indices
+            halve_stride(record, KSM_GEOMETRY_INDEX_SIZE, KSM_GEOMETRY_INDEX_COUNT);
+            fix_checksum(data, size);
+            expect_to_be_true(rejects(data, size));
+            kcopy_memory(data, original, size);
+        }
+        // and as written, it loads
+        expect_to_be_false(rejects(data, size));
+        kfree(original, size, MEMORY_TAG_ARRAY);
+        kfree(data, size, MEMORY_TAG_ARRAY);
+    }
+    return true;
+}
+
+// writes an archive holding the material library the manifest test's obj names
+static b8 write_mtl_archive(const char* archive_path, const char* mtl_text) {
+    file_handle f;
+    if (!filesystem_open(MANIFEST_TEST_MTL_SOURCE, FILE_MODE_WRITE, true, &f)) {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&f, string_length(mtl_text), mtl_text, &written);
+    filesystem_close(&f);
+    vfs_archive_file file = {"models/ship.mtl", MANIFEST_TEST_MTL_SOURCE, false};
+    return result && vfs_archive_write(archive_path, 1, &file, 0);
+}
+
+static b8 manifest_matches(const char* manifest, const char* obj) {
+    return mesh_loader_import_manifest_matches(manifest, string_length(manifest), "models/ship.obj", obj, string_length(obj));
+}
+
+u8 mesh_import_manifest_should_go_stale_when_sources_change() {
+    const char* obj = "mtllib ship.mtl\nv 0 0 0\nv 1 0 0\nv 0 1 0\nusemtl hull\nf 1 2 3\n";
+    const char* edited_obj = "mtllib ship.mtl\nv 0 0 0\nv 2 0 0\nv 0 1 0\nusemtl hull\nf 1 2 3\n";
+
+    vfs_system_config config = {4};
+    u64 vfs_size = 0;
+    vfs_system_initialize(&vfs_size, 0, config);
+    void* vfs_state = kallocate(vfs_size, MEMORY_TAG_APPLICATION);
+    expect_to_be_true(vfs_system_initialize(&vfs_size, vfs_state, config));
+    expect_to_be_true(write_mtl_archive(MANIFEST_TEST_ARCHIVE, "newmtl hull\nKd 1 1 1\n"));
+    expect_to_be_true(write_mtl_archive(MANIFEST_TEST_CHANGED_ARCHIVE, "newmtl hull\nKd 1 0 0\n"));
+    expect_to_be_true(vfs_mount_archive(MANIFEST_TEST_ARCHIVE));
+
+    kbinary_writer writer;
+    kbinary_writer_to_memory(0, &writer);
+    expect_to_be_true(mesh_loader_write_import_manifest(&writer, "models/ship.obj", obj, string_length(obj)));
+    u64 size = 0;
+    const char* written = kbinary_writer_data(&writer, &size);
+    char manifest[2048] = "";
+    expect_to_be_true(size < sizeof(manifest));
+    kcopy_memory(manifest, written, size);
+    kbinary_writer_close(&writer);
+
+    // the obj and its material library, as they were
+    expect_to_be_true(manifest_matches(manifest, obj));
+    expect_to_be_false(manifest_matches(manifest, edited_obj));
+
+    // a newer importer
+    const char* at = manifest;
+    u32 version = 0;
+    while (*at && sscanf(at, "importer_version=%u", &version) != 1) {
+        at++;
+    }
+    expect_to_be_true(version > 0);
+    const char* after = at;
+    while (*after && *after != '\n') {
+        after++;
+    }
+    char older[2048];
+    string_format(older, "%.*simporter_version=%u%s", (i32)(at - manifest), manifest, version + 1, after);
+    expect_to_be_false(manifest_matches(older, obj));
+
+    // a source that isn't there any more, and a path too long for the manifest to hold
+    char extra[2048 + VFS_MAX_PATH_LENGTH * 2];
+    string_format(extra, "%ssource=0123456789abcdef models/gone.mtl\n", manifest);
+    expect_to_be_false(manifest_matches(extra, obj));
+    u64 manifest_length = string_length(manifest);
+    kcopy_memory(extra, manifest, manifest_length);
+    kcopy_memory(extra + manifest_length, "source=0 ", 9);
+    kset_memory(extra + manifest_length + 9, 'x', VFS_MAX_PATH_LENGTH + 8);
+    extra[manifest_length + 9 + VFS_MAX_PATH_LENGTH + 8] = 0;
+    expect_to_be_false(manifest_matches(extra, obj));
+
+    // the material library changing under the same obj
+    expect_to_be_true(vfs_mount_archive(MANIFEST_TEST_CHANGED_ARCHIVE));
+    expect_to_be_false(manifest_matches(manifest, obj));
+
+    vfs_system_shutdown(vfs_state);
+    kfree(vfs_state, vfs_size, MEMORY_TAG_APPLICATION);
+    remove(MANIFEST_TEST_MTL_SOURCE);
+    remove(MANIFEST_TEST_ARCHIVE);
+    remove(MANIFEST_TEST_CHANGED_ARCHIVE);
+    return true;
+}
+
+void mesh_loader_register_tests() {
+    test_manager_register_test(mesh_loader_should_import_obj_text_into_groups, "Mesh loader should import obj text into a geometry per object and material.");
+    test_manager_register_test(mesh_loader_should_import_the_same_however_the_obj_is_split, "Mesh loader should import the same however the obj is split into chunks.");
+    test_manager_register_test(ksm_should_round_trip_geometries, "Ksm files should round trip geometries, packed or not.");
+    test_manager_register_test(ksm_should_reject_truncated_files, "Ksm files should be rejected when truncated.");
+    test_manager_register_test(ksm_should_reject_a_bad_checksum, "Ksm files should be rejected when the checksum doesn't match.");
+    test_manager_register_test(ksm_should_reject_sections_outside_the_file, "Ksm files should be rejected when a section lies outside the file.");
+    test_manager_register_test(ksm_should_reject_unknown_vertex_and_index_sizes, "Ksm files should be rejected when a geometry has a vertex or index size the renderer doesn't know.");
+    test_manager_register_test(mesh_import_manifest_should_go_stale_when_sources_change, "Mesh import manifests should go stale when the obj, its material library or the importer changes.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void mesh_loader_register_tests();
@@ -0,0 +1,245 @@
+#include "obj_parser_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <containers/darray.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <resources/loaders/obj_parser.h>
+
+// parses a whole string as one float
+static b8 parse_float(const char* text, f32* out_value) {
+    const char* at = text;
+    return obj_parse_float(&at, text + string_length(text), out_value);
+}
+
+// within a millionth of expected, relative to its size
+static b8 close_to(f32 expected, f32 value) {
+    return kabs(value - expected) <= kabs(expected) * 1e-6f;
+}
+
+static u32 parse_index(const char* text, u64 element_count) {
+    const char* at = text;
+    return obj_parse_index(&at, text + string_length(text), element_count);
+}
+
+static b8 same_corner(mesh_vertex_index_data corner, u32 position_index, u32 texcoord_index, u32 normal_index) {
+    return corner.position_index == position_index && corner.texcoord_index == texcoord_index && corner.normal_index == normal_index;
+}
+
+u8 obj_parse_float_should_read_the_forms_exporters_write() {
+    f32 value = 0.0f;
+    expect_to_be_true(parse_float("1", &value));
+    expect_float_to_be(1.0f, value);
+    expect_to_be_true(parse_float("-2.5", &value));
+    expect_float_to_be(-2.5f, value);
+    expect_to_be_true(parse_float("+0.125", &value));
+    expect_float_to_be(0.125f, value);
+    expect_to_be_true(parse_float(".5", &value));
+    expect_float_to_be(0.5f, value);
+    expect_to_be_true(parse_float("7.", &value));
+    expect_float_to_be(7.0f, value);
+    expect_to_be_true(parse_float("  \t-0.000001", &value));
+    expect_float_to_be(-0.000001f, value);
+
+    // exponents, either case and with either sign
+    expect_to_be_true(parse_float("1.5e3", &value));
+    expect_float_to_be(1500.0f, value);
+    expect_to_be_true(parse_float("2E-2", &value));
+    expect_float_to_be(0.02f, value);
+    expect_to_be_true(parse_float("-3.25e+1", &value));
+    expect_float_to_be(-32.5f, value);
+    expect_to_be_true(parse_float("6.02214076e23", &value));
+    expect_to_be_true(close_to(6.02214076e23f, value));
+    expect_to_be_true(parse_float("1.60217663e-19", &value));
+    expect_to_be_true(close_to(1.60217663e-19f, value));
+    // past the table of powers, so scaled more than once
+    expect_to_be_true(parse_float("3.4e38", &value));
+    expect_to_be_true(close_to(3.4e38f, value));
+    expect_to_be_true(parse_float("1.2e-30", &value));
+    expect_to_be_true(close_to(1.2e-30f, value));
+
+    // mantissas with more digits than an f32 can use, before and after the point
+    expect_to_be_true(parse_float("3.14159265358979323846264338327950288", &value));
+    expect_to_be_true(close_to(K_PI, value));
+    expect_to_be_true(parse_float("123456789012345678901234567890", &value));
+    expect_to_be_true(close_to(1.23456789e29f, value));
+    expect_to_be_true(parse_float("0.000000000000000000000000123456789012345678901234", &value));
+    expect_to_be_true(close_to(1.23456789e-25f, value));
+    expect_to_be_true(parse_float("-99999999999999999999.5e-10", &value));
+    expect_to_be_true(close_to(-1e10f, value));
+    return true;
+}
+
+u8 obj_parse_float_should_stop_where_the_float_does() {
+    // several in a row, as a v line has them
+    const char* text = " 1 -2\t3.5e1\r";
+    const char* end = text + string_length(text);
+    const char* at = text;
+    vec3 v = vec3_zero();
+    expect_to_be_true(obj_parse_float(&at, end, &v.x));
+    expect_to_be_true(obj_parse_float(&at, end, &v.y));
+    expect_to_be_true(obj_parse_float(&at, end, &v.z));
+    expect_float_to_be(1.0f, v.x);
+    expect_float_to_be(-2.0f, v.y);
+    expect_float_to_be(35.0f, v.z);
+    f32 value = 0.0f;
+    expect_to_be_false(obj_parse_float(&at, end, &value));
+
+    // an e with no digits after it isn't an exponent
+    text = "4e x";
+    at = text;
+    expect_to_be_true(obj_parse_float(&at, text + string_length(text), &value));
+    expect_float_to_be(4.0f, value);
+    expect_should_be(1, at - text);
+
+    // nothing to parse leaves everything alone
+    const char* bad[] = {"", "   ", "-", "+.", "e5", "abc"};
+    for (u32 i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        value = 42.0f;
+        at = bad[i];
+        expect_to_be_false(obj_parse_float(&at, bad[i] + string_length(bad[i]), &value));
+        expect_should_be(0, at - bad[i]);
+        expect_float_to_be(42.0f, value);
+    }
+
+    // the end passed in is the end of the line, even with more text after it
+    text = "12345";
+    at = text;
+    expect_to_be_true(obj_parse_float(&at, text + 3, &value));
+    expect_float_to_be(123.0f, value);
+    return true;
+}
+
+u8 obj_parse_index_should_resolve_positive_and_negative_indices() {
+    expect_should_be(5, parse_index("5", 10));
+    expect_should_be(10, parse_index("10", 10));
+    // negative counts back from the last element read so far
+    expect_should_be(10, parse_index("-1", 10));
+    expect_should_be(1, parse_index("-10", 10));
+    expect_should_be(3, parse_index("-1", 3));
+
+    // missing or out of range
+    expect_should_be(0, parse_index("", 10));
+    expect_should_be(0, parse_index("-", 10));
+    expect_should_be(0, parse_index("0", 10));
+    expect_should_be(0, parse_index("-0", 10));
+    expect_should_be(0, parse_index("11", 10));
+    expect_should_be(0, parse_index("-11", 10));
+    expect_should_be(0, parse_index("1", 0));
+    expect_should_be(0, parse_index("-1", 0));
+    expect_should_be(0, parse_index("99999999999999999999", 10));
+    expect_should_be(0, parse_index("-99999999999999999999", 10));
+
+    // stops at the first thing that isn't a digit
+    const char* text = "7/8";
+    const char* at = text;
+    expect_should_be(7, obj_parse_index(&at, text + 3, 10));
+    expect_should_be(1, at - text);
+    return true;
+}
+
+u8 obj_parse_face_vertex_should_read_each_corner_form() {
+    const char* text = " 3 3/2 3//1 3/2/1 -1/-2/-3\t2/x/1 4";
+    const char* end = text + string_length(text);
+    const char* at = text;
+    mesh_vertex_index_data corner;
+
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 3, 0, 0));
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 3, 2, 0));
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 3, 0, 1));
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 3, 2, 1));
+    // each negative index counts back through its own attribute
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 4, 4, 4));
+    // a malformed corner is skipped over, so the one after it still reads
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 2, 0, 0));
+    expect_to_be_true(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    expect_to_be_true(same_corner(corner, 4, 0, 0));
+    expect_to_be_false(obj_parse_face_vertex(&at, end, 4, 5, 6, &corner));
+    return true;
+}
+
+u8 obj_parse_face_should_fan_polygons_and_skip_bad_faces() {
+    mesh_face_data* faces = darray_create(mesh_face_data);
+
+    // a triangle, then a quad and a pentagon fanned out from their first corner
+    const char* triangle = " 1/1/1 2/2/2 3/3/3";
+    expect_to_be_true(obj_parse_face(triangle, triangle + string_length(triangle), 5, 3, 3, &faces));
+    expect_should_be(1, darray_length(faces));
+    expect_to_be_true(same_corner(faces[0].vertices[2], 3, 3, 3));
+    const char* quad = " 1 2 3 4";
+    expect_to_be_true(obj_parse_face(quad, quad + string_length(quad), 5, 0, 0, &faces));
+    const char* pentagon = " 5 4 3 2 1\r";
+    expect_to_be_true(obj_parse_face(pentagon, pentagon + string_length(pentagon), 5, 0, 0, &faces));
+    expect_should_be(6, darray_length(faces));
+    u32 expected[5][3] = {{1, 2, 3}, {1, 3, 4}, {5, 4, 3}, {5, 3, 2}, {5, 2, 1}};
+    for (u32 f = 0; f < 5; ++f) {
+        for (u32 c = 0; c < 3; ++c) {
+            expect_should_be(expected[f][c], faces[f + 1].vertices[c].position_index);
+        }
+    }
+
+    // too few corners, or a position out of range anywhere in the face, skips all of it. only the texture coordinate or
+    // normal being out of range leaves the corner without one
+    const char* bad[] = {"", " 1", " 1 2", " 1 2 6", " 0 1 2", " 1 2 3 4 -6", " x 2 3"};
+    for (u32 i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        expect_to_be_false(obj_parse_face(bad[i], bad[i] + string_length(bad[i]), 5, 0, 0, &faces));
+        expect_should_be(6, darray_length(faces));
+    }
+    const char* missing_normal = " 1//9 2//9 3//9";
+    expect_to_be_true(obj_parse_face(missing_normal, missing_normal + string_length(missing_normal), 5, 0, 2, &faces));
+    expect_should_be(7, darray_length(faces));
+    expect_to_be_true(same_corner(faces[6].vertices[0], 1, 0, 0));
+
+    darray_destroy(faces);
+    return true;
+}
+
+u8 obj_parse_should_read_lines_of_any_length() {
+    // well past the 512 characters lines used to be read into
+    const u32 corner_count = 200;
+    const u64 capacity = corner_count * 16 + 1;
+    char* text = kallocate(capacity, MEMORY_TAG_STRING);
+    u64 length = 0;
+    for (u32 i = 0; i < corner_count; ++i) {
+        length += string_format(text + length, " %u/%u/-%u", i + 1, i + 1, i % 3 + 1);
+    }
+    b8 long_line = length > 511;
+    expect_to_be_true(long_line);
+
+    mesh_face_data* faces = darray_create(mesh_face_data);
+    expect_to_be_true(obj_parse_face(text, text + length, corner_count, corner_count, 3, &faces));
+    expect_should_be(corner_count - 2, darray_length(faces));
+    mesh_face_data last = faces[corner_count - 3];
+    expect_to_be_true(same_corner(last.vertices[0], 1, 1, 3));
+    expect_to_be_true(same_corner(last.vertices[1], corner_count - 1, corner_count - 1, 3));
+    expect_to_be_true(same_corner(last.vertices[2], corner_count, corner_count, 2));
+    darray_destroy(faces);
+
+    // a float after a long run of spaces
+    kset_memory(text, ' ', capacity - 1);
+    string_ncopy(text + 600, "-1.25e2", 8);
+    const char* at = text;
+    f32 value = 0.0f;
+    expect_to_be_true(obj_parse_float(&at, text + string_length(text), &value));
+    expect_float_to_be(-125.0f, value);
+
+    kfree(text, capacity, MEMORY_TAG_STRING);
+    return true;
+}
+
+void obj_parser_register_tests() {
+    test_manager_register_test(obj_parse_float_should_read_the_forms_exporters_write, "Obj parsing should read floats in the forms exporters write.");
+    test_manager_register_test(obj_parse_float_should_stop_where_the_float_does, "Obj parsing should stop at the end of each float.");
+    test_manager_register_test(obj_parse_index_should_resolve_positive_and_negative_indices, "Obj parsing should resolve positive and negative indices.");
+    test_manager_register_test(obj_parse_face_vertex_should_read_each_corner_form, "Obj parsing should read each form of face corner.");
+    test_manager_register_test(obj_parse_face_should_fan_polygons_and_skip_bad_faces, "Obj parsing should fan out polygons and skip bad faces.");
+    test_manager_register_test(obj_parse_should_read_lines_of_any_length, "Obj parsing should read lines of any length.");
+}
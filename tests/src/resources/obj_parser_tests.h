@@ -0,0 +1,3 @@
+#pragma once
+
+void obj_parser_register_tests();
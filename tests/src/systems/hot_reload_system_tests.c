@@ -0,0 +1,240 @@
+#include "hot_reload_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/kthread.h>
+#include <core/ksemaphore.h>
+#include <core/clock.h>
+#include <systems/job_system.h>
+#include <systems/resource_system.h>
+#include <systems/hot_reload_system.h>
+#include <systems/vfs_system.h>
+
+// long enough that a slow machine doesn't blow through it between two steps of a test
+#define HOT_RELOAD_TEST_DEBOUNCE_MS 200
+#define HOT_RELOAD_TEST_TIMEOUT_SECONDS 5.0
+
+// a job worker for the reloads to load on, a resource system with no assets for them to fail to find, and the hot
+// reload system itself, with no watcher. changes are fed in by hand
+typedef struct hot_reload_test_systems {
+    void* job_state;
+    u64 job_size;
+    void* resource_state;
+    u64 resource_size;
+    void* hot_reload_state;
+    u64 hot_reload_size;
+    ksemaphore never_signaled;
+} hot_reload_test_systems;
+
+static b8 start_systems(hot_reload_test_systems* systems) {
+    job_system_config job_config = {};
+    job_config.worker_count = 1;
+    job_config.max_job_count = 64;
+    job_system_initialize(&systems->job_size, 0, job_config);
+    systems->job_state = kallocate(systems->job_size, MEMORY_TAG_JOB);
+    if (!job_system_initialize(&systems->job_size, systems->job_state, job_config)) {
+        return false;
+    }
+
+    resource_system_config resource_config = {};
+    resource_config.max_loader_count = 16;
+    resource_config.asset_base_path = "";
+    resource_system_initialize(&systems->resource_size, 0, resource_config);
+    systems->resource_state = kallocate(systems->resource_size, MEMORY_TAG_RESOURCE);
+    if (!resource_system_initialize(&systems->resource_size, systems->resource_state, resource_config)) {
+        return false;
+    }
+
+    hot_reload_system_config config = {};
+    config.debounce_ms = HOT_RELOAD_TEST_DEBOUNCE_MS;
+    hot_reload_system_initialize(&systems->hot_reload_size, 0, config);
+    systems->hot_reload_state = kallocate(systems->hot_reload_size, MEMORY_TAG_APPLICATION);
+    return hot_reload_system_initialize(&systems->hot_reload_size, systems->hot_reload_state, config) && ksemaphore_create(0, &systems->never_signaled);
+}
+
+static void stop_systems(hot_reload_test_systems* systems) {
+    hot_reload_system_shutdown(systems->hot_reload_state);
+    kfree(systems->hot_reload_state, systems->hot_reload_size, MEMORY_TAG_APPLICATION);
+    job_system_shutdown(systems->job_state);
+    kfree(systems->job_state, systems->job_size, MEMORY_TAG_JOB);
+    resource_system_shutdown(systems->resource_state);
+    kfree(systems->resource_state, systems->resource_size, MEMORY_TAG_RESOURCE);
+    ksemaphore_destroy(&systems->never_signaled);
+}
+
+static void sleep_ms(hot_reload_test_systems* systems, u64 ms) {
+    ksemaphore_wait(&systems->never_signaled, ms);
+}
+
+// runs the frame updates until the mesh leaves the given state. false if it took too long
+static b8 update_while(hot_reload_slot_state state, const char* name) {
+    clock timer;
+    clock_start(&timer);
+    while (hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, name) == state) {
+        hot_reload_system_update();
+        job_system_update();
+        clock_update(&timer);
+        if (timer.elapsed > HOT_RELOAD_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+static void on_reloaded(const resource* resource, void* user_data) {
+    u32* count = user_data;
+    (*count)++;
+}
+
+static b8 classified_as(const char* path, hot_reload_kind kind, b8 from_source, const char* name) {
+    hot_reload_kind out_kind;
+    b8 out_from_source;
+    char out_name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    return hot_reload_classify_path(path, &out_kind, &out_from_source, out_name) && out_kind == kind && out_from_source == from_source &&
+           strings_equal(out_name, name);
+}
+
+static b8 rejected(const char* path) {
+    hot_reload_kind kind;
+    b8 from_source;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    return !hot_reload_classify_path(path, &kind, &from_source, name);
+}
+
+u8 hot_reload_should_classify_paths() {
+    expect_to_be_true(classified_as("textures/wood.kti", HOT_RELOAD_KIND_TEXTURE, false, "wood"));
+    expect_to_be_true(classified_as("textures/wood.png", HOT_RELOAD_KIND_TEXTURE, true, "wood"));
+    expect_to_be_true(classified_as("textures/sub/wood.TGA", HOT_RELOAD_KIND_TEXTURE, true, "sub/wood"));
+    expect_to_be_true(classified_as("materials/a.b/c.kmt", HOT_RELOAD_KIND_MATERIAL, false, "a.b/c"));
+    expect_to_be_true(classified_as("models/ship.ksm", HOT_RELOAD_KIND_MESH, false, "ship"));
+    expect_to_be_true(classified_as("models/ship.obj", HOT_RELOAD_KIND_MESH, true, "ship"));
+    expect_to_be_true(classified_as("models/ship.mtl", HOT_RELOAD_KIND_MESH, true, "ship"));
+    expect_to_be_true(classified_as("shaders/builtin.shadercfg", HOT_RELOAD_KIND_SHADER, false, "builtin"));
+    // stages keep their whole path, as that is what shader configs name them by
+    expect_to_be_true(classified_as("shaders/builtin.vert.spv", HOT_RELOAD_KIND_SHADER_STAGE, false, "shaders/builtin.vert.spv"));
+
+    // no extension, an extension the folder doesn't take, no name and an unknown folder
+    expect_to_be_true(rejected("textures/wood"));
+    expect_to_be_true(rejected("textures.d/wood"));
+    expect_to_be_true(rejected("models/ship.png"));
+    expect_to_be_true(rejected("textures/.png"));
+    expect_to_be_true(rejected("sounds/boom.png"));
+    return true;
+}
+
+u8 hot_reload_should_resolve_what_is_loaded() {
+    hot_reload_test_systems systems = {};
+    expect_to_be_true(start_systems(&systems));
+    u32 reload_count = 0;
+
+    // nothing is loaded, so only what is watched counts
+    hot_reload_kind kind = HOT_RELOAD_KIND_MESH;
+    char name[RESOURCE_LOAD_NAME_MAX_LENGTH] = "ship";
+    expect_to_be_false(hot_reload_resolve_loaded(&kind, name));
+    expect_to_be_true(hot_reload_system_watch(RESOURCE_TYPE_MESH, "ship", on_reloaded, &reload_count));
+    expect_to_be_true(hot_reload_resolve_loaded(&kind, name));
+    hot_reload_system_unwatch(RESOURCE_TYPE_MESH, "ship", &reload_count);
+    expect_to_be_false(hot_reload_resolve_loaded(&kind, name));
+
+    kind = HOT_RELOAD_KIND_MATERIAL;
+    string_ncopy(name, "stone", RESOURCE_LOAD_NAME_MAX_LENGTH);
+    expect_to_be_true(hot_reload_system_watch(RESOURCE_TYPE_MATERIAL, "stone", on_reloaded, &reload_count));
+    expect_to_be_true(hot_reload_resolve_loaded(&kind, name));
+
+    // a face of a cube map that isn't loaded stays a texture of its own
+    kind = HOT_RELOAD_KIND_TEXTURE;
+    string_ncopy(name, "sky_r", RESOURCE_LOAD_NAME_MAX_LENGTH);
+    expect_to_be_false(hot_reload_resolve_loaded(&kind, name));
+    expect_should_be(HOT_RELOAD_KIND_TEXTURE, kind);
+    expect_to_be_true(strings_equal("sky_r", name));
+    expect_to_be_true(hot_reload_system_watch(RESOURCE_TYPE_IMAGE, "sky_r", on_reloaded, &reload_count));
+    expect_to_be_true(hot_reload_resolve_loaded(&kind, name));
+
+    // the shader system works out for itself which shaders use a stage
+    kind = HOT_RELOAD_KIND_SHADER_STAGE;
+    string_ncopy(name, "shaders/builtin.vert.spv", RESOURCE_LOAD_NAME_MAX_LENGTH);
+    expect_to_be_true(hot_reload_resolve_loaded(&kind, name));
+
+    expect_should_be(0, reload_count);
+    stop_systems(&systems);
+    return true;
+}
+
+u8 hot_reload_should_debounce_changes() {
+    hot_reload_test_systems systems = {};
+    expect_to_be_true(start_systems(&systems));
+    u32 reload_count = 0;
+    expect_to_be_true(hot_reload_system_watch(RESOURCE_TYPE_MESH, "ship", on_reloaded, &reload_count));
+
+    // anything not loaded or watched is not reloaded at all
+    hot_reload_system_file_changed("models/boat.obj");
+    expect_should_be(HOT_RELOAD_SLOT_STATE_FREE, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "boat"));
+
+    // each change puts the reload off again, so it waits past when the first change alone would have started it
+    hot_reload_system_file_changed("models/ship.obj");
+    expect_should_be(HOT_RELOAD_SLOT_STATE_WAITING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+    sleep_ms(&systems, HOT_RELOAD_TEST_DEBOUNCE_MS * 6 / 10);
+    hot_reload_system_file_changed("models/ship.mtl");
+    sleep_ms(&systems, HOT_RELOAD_TEST_DEBOUNCE_MS * 6 / 10);
+    hot_reload_system_update();
+    expect_should_be(HOT_RELOAD_SLOT_STATE_WAITING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+
+    // once settled it loads, and stays loading until the job system update hands the result back
+    clock timer;
+    clock_start(&timer);
+    while (hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship") == HOT_RELOAD_SLOT_STATE_WAITING && timer.elapsed < HOT_RELOAD_TEST_TIMEOUT_SECONDS) {
+        hot_reload_system_update();
+        clock_update(&timer);
+        kthread_yield();
+    }
+    expect_should_be(HOT_RELOAD_SLOT_STATE_LOADING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+    // importing from source writes out the cooked file, which is not a change of its own
+    hot_reload_system_file_changed("models/ship.ksm");
+    expect_should_be(HOT_RELOAD_SLOT_STATE_LOADING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+
+    // there is no such file, so the load fails, but the slot still settles
+    expect_to_be_true(update_while(HOT_RELOAD_SLOT_STATE_LOADING, "ship"));
+    expect_should_be(HOT_RELOAD_SLOT_STATE_SETTLING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+    expect_should_be(0, reload_count);
+    hot_reload_system_file_changed("models/ship.ksm");
+    expect_should_be(HOT_RELOAD_SLOT_STATE_SETTLING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+
+    // a change to the source while settling is a real one, and starts it over
+    hot_reload_system_file_changed("models/ship.obj");
+    expect_should_be(HOT_RELOAD_SLOT_STATE_WAITING, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+    expect_to_be_true(update_while(HOT_RELOAD_SLOT_STATE_WAITING, "ship"));
+    expect_to_be_true(update_while(HOT_RELOAD_SLOT_STATE_LOADING, "ship"));
+    expect_to_be_true(update_while(HOT_RELOAD_SLOT_STATE_SETTLING, "ship"));
+    expect_should_be(HOT_RELOAD_SLOT_STATE_FREE, hot_reload_system_reload_state(HOT_RELOAD_KIND_MESH, "ship"));
+
+    stop_systems(&systems);
+    return true;
+}
+
+u8 hot_reload_should_ignore_paths_too_long() {
+    hot_reload_test_systems systems = {};
+    expect_to_be_true(start_systems(&systems));
+
+    // as long as the watcher hands out, which is more than the vfs takes
+    char path[VFS_MAX_PATH_LENGTH + 16];
+    kset_memory(path, 'x', sizeof(path) - 1);
+    path[sizeof(path) - 1] = 0;
+    kcopy_memory(path, "models/", 7);
+    kcopy_memory(path + sizeof(path) - 5, ".obj", 4);
+    hot_reload_system_file_changed(path);
+    hot_reload_system_update();
+
+    stop_systems(&systems);
+    return true;
+}
+
+void hot_reload_system_register_tests() {
+    test_manager_register_test(hot_reload_should_classify_paths, "Hot reload should work out what a changed file is.");
+    test_manager_register_test(hot_reload_should_resolve_what_is_loaded, "Hot reload should only reload what is loaded or watched.");
+    test_manager_register_test(hot_reload_should_debounce_changes, "Hot reload should wait for changes to settle, load, then settle again.");
+    test_manager_register_test(hot_reload_should_ignore_paths_too_long, "Hot reload should ignore paths too long for the vfs.");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void hot_reload_system_register_tests();
@@ -0,0 +1,404 @@
+#include "job_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/kthread.h>
+#include <core/ksemaphore.h>
+#include <core/katomic.h>
+#include <core/clock.h>
+#include <systems/job_system.h>
+
+#define JOB_TEST_JOB_COUNT 256
+// long enough for a stuck job to be a failure rather than a slow machine
+#define JOB_TEST_TIMEOUT_SECONDS 5.0
+
+typedef struct job_test_data job_test_data;
+
+// what each job is handed, so it knows where it is in the test
+typedef struct job_test_item {
+    job_test_data* data;
+    u32 index;
+    u64 thread_id;
+} job_test_item;
+
+// shared between the jobs and the test itself
+typedef struct job_test_data {
+    job_counter counter;
+    job_counter children;
+    job_test_item items[JOB_TEST_JOB_COUNT];
+    volatile i32 hits[JOB_TEST_JOB_COUNT];
+    volatile i32 sum;
+    volatile i32 order[JOB_TEST_JOB_COUNT];
+    volatile i32 order_count;
+    volatile i32 started;
+    volatile i32 released;
+    volatile i32 completed;
+    volatile i32 completed_off_main;
+    u64 main_thread_id;
+    u64 spawner_thread_id;
+    ksemaphore never_signaled;
+    // what the fiber jobs saw
+    volatile i32 fiber_step;
+    i32 step_seen_by_other;
+    b8 fiber_was_on_fiber;
+    b8 other_was_on_fiber;
+    u64 fiber_thread_id;
+    b8 fiber_finished;
+} job_test_data;
+
+static void* start_job_system(u8 worker_count, u32 max_job_count, u32 fiber_count, u64* out_size) {
+    job_system_config config = {};
+    config.worker_count = worker_count;
+    config.max_job_count = max_job_count;
+    config.fiber_count = fiber_count;
+    config.fiber_stack_size = KIBIBYTES(64);
+    job_system_initialize(out_size, 0, config);
+    void* state = kallocate(*out_size, MEMORY_TAG_JOB);
+    if (!job_system_initialize(out_size, state, config)) {
+        kfree(state, *out_size, MEMORY_TAG_JOB);
+        return 0;
+    }
+    return state;
+}
+
+static void stop_job_system(void* state, u64 size) {
+    job_system_shutdown(state);
+    kfree(state, size, MEMORY_TAG_JOB);
+}
+
+static void setup_data(job_test_data* data) {
+    kzero_memory(data, sizeof(job_test_data));
+    data->main_thread_id = kthread_get_current_id();
+    for (u32 i = 0; i < JOB_TEST_JOB_COUNT; ++i) {
+        data->items[i].data = data;
+        data->items[i].index = i;
+    }
+}
+
+// waits on the counter without helping out, so only the workers run anything. false if it took too long
+static b8 wait_without_helping(job_counter* counter) {
+    clock timer;
+    clock_start(&timer);
+    while (katomic_load_i32(&counter->value, KATOMIC_ACQUIRE) > 0) {
+        clock_update(&timer);
+        if (timer.elapsed > JOB_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+static void count_job(void* params) {
+    job_test_item* item = params;
+    item->thread_id = kthread_get_current_id();
+    katomic_fetch_add_i32(&item->data->hits[item->index], 1, KATOMIC_RELAXED);
+    katomic_fetch_add_i32(&item->data->sum, (i32)item->index, KATOMIC_RELAXED);
+    // just enough work that the other threads get a look in
+    for (volatile u32 i = 0; i < 2000; ++i) {
+    }
+}
+
+static void record_order_job(void* params) {
+    job_test_item* item = params;
+    i32 slot = katomic_fetch_add_i32(&item->data->order_count, 1, KATOMIC_ACQ_REL);
+    item->data->order[slot] = (i32)item->index;
+}
+
+static void count_complete(void* params) {
+    job_test_item* item = params;
+    item->data->completed++;
+    if (kthread_get_current_id() != item->data->main_thread_id) {
+        item->data->completed_off_main++;
+    }
+}
+
+// submits every counting job from a worker, so they all land on that worker's own deque, then holds on to the worker
+// until they are done. the only way any of them can run is by being stolen
+static void spawner_job(void* params) {
+    job_test_data* data = params;
+    data->spawner_thread_id = kthread_get_current_id();
+    for (u32 i = 0; i < JOB_TEST_JOB_COUNT; ++i) {
+        job_info info = job_create(count_job, &data->items[i], JOB_PRIORITY_NORMAL);
+        info.counter = &data->children;
+        job_system_submit(info);
+    }
+    while (katomic_load_i32(&data->children.value, KATOMIC_ACQUIRE) > 0) {
+        kthread_yield();
+    }
+}
+
+// holds its worker until released
+static void blocker_job(void* params) {
+    job_test_data* data = params;
+    katomic_store_i32(&data->started, 1, KATOMIC_RELEASE);
+    while (!katomic_load_i32(&data->released, KATOMIC_ACQUIRE)) {
+        kthread_yield();
+    }
+}
+
+// holds its worker for a while, long enough for a shutdown to have begun by the time it is done
+static void slow_job(void* params) {
+    job_test_data* data = params;
+    katomic_store_i32(&data->started, 1, KATOMIC_RELEASE);
+    ksemaphore_wait(&data->never_signaled, 50);
+}
+
+// runs while a fiber job is parked or yielded, noting down how far along it was
+static void other_job(void* params) {
+    job_test_data* data = params;
+    data->step_seen_by_other = data->fiber_step;
+    data->other_was_on_fiber = job_system_is_on_fiber();
+    data->items[0].thread_id = kthread_get_current_id();
+}
+
+// hands a job to its own worker, then parks until it is done
+static void parking_fiber_job(void* params) {
+    job_test_data* data = params;
+    data->fiber_was_on_fiber = job_system_is_on_fiber();
+    data->fiber_thread_id = kthread_get_current_id();
+    data->fiber_step = 1;
+    job_info info = job_create(other_job, data, JOB_PRIORITY_NORMAL);
+    info.counter = &data->children;
+    job_system_submit(info);
+    job_system_wait(&data->children);
+    data->fiber_step = 2;
+    data->fiber_finished = katomic_load_i32(&data->children.value, KATOMIC_ACQUIRE) == 0;
+}
+
+// yields a few times, letting something else in on the first one
+static void yielding_fiber_job(void* params) {
+    job_test_data* data = params;
+    data->fiber_was_on_fiber = job_system_is_on_fiber();
+    for (i32 step = 1; step <= 3; ++step) {
+        data->fiber_step = step;
+        if (step == 1) {
+            job_info info = job_create(other_job, data, JOB_PRIORITY_NORMAL);
+            info.counter = &data->children;
+            job_system_submit(info);
+        }
+        job_system_yield();
+    }
+    data->fiber_finished = true;
+}
+
+u8 job_system_should_run_stolen_jobs_once() {
+    u64 size = 0;
+    void* state = start_job_system(4, 512, 0, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    job_info spawner = job_create(spawner_job, &data, JOB_PRIORITY_NORMAL);
+    spawner.counter = &data.counter;
+    job_system_submit(spawner);
+    // not helping out here, or this thread could end up as the spawner
+    expect_to_be_true(wait_without_helping(&data.counter));
+
+    // every job ran exactly once, and none on the worker whose deque they were pushed onto
+    for (u32 i = 0; i < JOB_TEST_JOB_COUNT; ++i) {
+        expect_should_be(1, data.hits[i]);
+        expect_should_not_be(data.spawner_thread_id, data.items[i].thread_id);
+    }
+    expect_should_not_be(data.main_thread_id, data.spawner_thread_id);
+    expect_should_be(0, data.children.value);
+
+    stop_job_system(state, size);
+    return true;
+}
+
+u8 job_system_should_run_higher_priorities_first() {
+    u64 size = 0;
+    void* state = start_job_system(1, 64, 0, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+
+    // tie up the only worker, so everything below is queued before any of it runs
+    job_system_submit(job_create(blocker_job, &data, JOB_PRIORITY_HIGH));
+    while (!katomic_load_i32(&data.started, KATOMIC_ACQUIRE)) {
+        kthread_yield();
+    }
+    job_priority priorities[4] = {JOB_PRIORITY_LOW, JOB_PRIORITY_NORMAL, JOB_PRIORITY_HIGH, JOB_PRIORITY_NORMAL};
+    for (u32 i = 0; i < 4; ++i) {
+        job_info info = job_create(record_order_job, &data.items[i], priorities[i]);
+        info.counter = &data.counter;
+        job_system_submit(info);
+    }
+    katomic_store_i32(&data.released, 1, KATOMIC_RELEASE);
+    expect_to_be_true(wait_without_helping(&data.counter));
+
+    // highest first, and in the order submitted within a priority
+    expect_should_be(4, data.order_count);
+    expect_should_be(2, data.order[0]);
+    expect_should_be(1, data.order[1]);
+    expect_should_be(3, data.order[2]);
+    expect_should_be(0, data.order[3]);
+
+    stop_job_system(state, size);
+    return true;
+}
+
+u8 job_system_should_fan_in_on_a_counter() {
+    // small queues, so the completion queue fills up well before everything is done
+    u64 size = 0;
+    void* state = start_job_system(4, 16, 0, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    i32 expected_sum = 0;
+    for (u32 i = 0; i < JOB_TEST_JOB_COUNT; ++i) {
+        job_info info = job_create(count_job, &data.items[i], JOB_PRIORITY_NORMAL);
+        info.counter = &data.counter;
+        info.on_complete = count_complete;
+        job_system_submit(info);
+        expected_sum += (i32)i;
+    }
+    job_system_wait(&data.counter);
+    expect_should_be(0, data.counter.value);
+    expect_should_be(expected_sum, data.sum);
+
+    // waiting never runs callbacks, they are all left for the update, which runs them on this thread
+    expect_should_be(0, data.completed);
+    job_system_update();
+    expect_should_be(JOB_TEST_JOB_COUNT, data.completed);
+    expect_should_be(0, data.completed_off_main);
+
+    stop_job_system(state, size);
+    return true;
+}
+
+u8 job_system_should_submit_a_batch() {
+    u64 size = 0;
+    void* state = start_job_system(2, 64, 0, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    job_info jobs[16];
+    for (u32 i = 0; i < 16; ++i) {
+        jobs[i] = job_create(count_job, &data.items[i], (job_priority)(i % JOB_PRIORITY_MAX));
+        jobs[i].counter = &data.counter;
+    }
+    job_system_submit_batch(jobs, 16);
+    job_system_wait(&data.counter);
+
+    for (u32 i = 0; i < 16; ++i) {
+        expect_should_be(1, data.hits[i]);
+    }
+    expect_should_be(0, data.hits[16]);
+
+    stop_job_system(state, size);
+    return true;
+}
+
+u8 job_system_should_drop_queued_jobs_on_shutdown() {
+    u64 size = 0;
+    void* state = start_job_system(1, 64, 0, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    expect_to_be_true(ksemaphore_create(0, &data.never_signaled));
+
+    // the only worker is still busy with this by the time the shutdown starts, so never gets to the rest
+    job_system_submit(job_create(slow_job, &data, JOB_PRIORITY_NORMAL));
+    while (!katomic_load_i32(&data.started, KATOMIC_ACQUIRE)) {
+        kthread_yield();
+    }
+    for (u32 i = 0; i < 8; ++i) {
+        job_info info = job_create(count_job, &data.items[i], JOB_PRIORITY_NORMAL);
+        info.counter = &data.counter;
+        info.on_complete = count_complete;
+        job_system_submit(info);
+    }
+    expect_should_be(8, data.counter.value);
+    stop_job_system(state, size);
+
+    // none of them ran, nor were their callbacks called, but the counter was let go of so a wait on it won't hang
+    for (u32 i = 0; i < 8; ++i) {
+        expect_should_be(0, data.hits[i]);
+    }
+    expect_should_be(0, data.completed);
+    expect_should_be(0, data.counter.value);
+    job_system_wait(&data.counter);
+
+    // with nothing running, jobs are run straight away on the submitting thread
+    expect_should_be(0, job_system_worker_count());
+    job_system_submit(job_create(count_job, &data.items[0], JOB_PRIORITY_NORMAL));
+    expect_should_be(1, data.hits[0]);
+    expect_should_be(data.main_thread_id, data.items[0].thread_id);
+
+    ksemaphore_destroy(&data.never_signaled);
+    return true;
+}
+
+u8 job_system_fiber_should_park_on_a_counter() {
+    // a single worker, so the job being waited on can only run if the fiber gets out of its way
+    u64 size = 0;
+    void* state = start_job_system(1, 64, 2, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    job_info info = job_create(parking_fiber_job, &data, JOB_PRIORITY_NORMAL);
+    info.counter = &data.counter;
+    info.use_fiber = true;
+    job_system_submit(info);
+    expect_to_be_true(wait_without_helping(&data.counter));
+
+    expect_to_be_true(data.fiber_was_on_fiber);
+    // the other job ran on the same worker, straight on the thread, while the fiber was parked part way through
+    expect_should_be(1, data.step_seen_by_other);
+    expect_to_be_false(data.other_was_on_fiber);
+    expect_should_be(data.fiber_thread_id, data.items[0].thread_id);
+    // and then the fiber picked up where it left off
+    expect_should_be(2, data.fiber_step);
+    expect_to_be_true(data.fiber_finished);
+    expect_should_be(0, data.children.value);
+
+    stop_job_system(state, size);
+    return true;
+}
+
+u8 job_system_fiber_should_finish_after_yielding() {
+    u64 size = 0;
+    void* state = start_job_system(1, 64, 2, &size);
+    expect_should_not_be(0, state);
+
+    job_test_data data;
+    setup_data(&data);
+    job_info info = job_create(yielding_fiber_job, &data, JOB_PRIORITY_NORMAL);
+    info.counter = &data.counter;
+    info.use_fiber = true;
+    job_system_submit(info);
+    expect_to_be_true(wait_without_helping(&data.counter));
+
+    expect_to_be_true(data.fiber_was_on_fiber);
+    // the job submitted before the first yield went ahead of the fiber at the same priority
+    expect_should_be(1, data.step_seen_by_other);
+    expect_to_be_false(data.other_was_on_fiber);
+    expect_should_be(3, data.fiber_step);
+    expect_to_be_true(data.fiber_finished);
+
+    // yielding and fiber checks do nothing off a fiber
+    expect_to_be_false(job_system_is_on_fiber());
+    job_system_yield();
+
+    stop_job_system(state, size);
+    return true;
+}
+
+void job_system_register_tests() {
+    test_manager_register_test(job_system_should_run_stolen_jobs_once, "Job system should run every job once when stolen.");
+    test_manager_register_test(job_system_should_run_higher_priorities_first, "Job system should run higher priorities first.");
+    test_manager_register_test(job_system_should_fan_in_on_a_counter, "Job system should fan in on a counter, leaving callbacks for the update.");
+    test_manager_register_test(job_system_should_submit_a_batch, "Job system should run a submitted batch.");
+    test_manager_register_test(job_system_fiber_should_park_on_a_counter, "Job system fiber should park on a counter and resume once it is done.");
+    test_manager_register_test(job_system_fiber_should_finish_after_yielding, "Job system fiber should let other work in when yielding, and still finish.");
+    test_manager_register_test(job_system_should_drop_queued_jobs_on_shutdown, "Job system should drop queued jobs and release their counters on shutdown.");
+}
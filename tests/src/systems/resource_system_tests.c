@@ -0,0 +1,560 @@
+#include "resource_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <core/kthread.h>
+#include <core/katomic.h>
+#include <core/clock.h>
+#include <systems/resource_system.h>
+#include <systems/job_system.h>
+
+#define STUB_TYPE "stub"
+// the cost of a resource the stub loads, as counted against the cache budget
+#define STUB_ENTRY_SIZE(size) (sizeof(resource) + (size))
+// long enough for a stuck load to be a failure rather than a slow machine
+#define ASYNC_TEST_TIMEOUT_SECONDS 5.0
+
+// what the stub loader is asked to load. only the size and variant make it into the cache key
+typedef struct stub_params {
+    u32 size;
+    u32 variant;
+} stub_params;
+
+// what the stub loader has been up to
+typedef struct stub_loader_state {
+    u32 load_count;
+    u32 unload_count;
+    char last_unloaded[RESOURCE_LOAD_NAME_MAX_LENGTH];
+    // while set, a load holds on to its worker until it is cleared. holding is set once one is
+    volatile i32 hold;
+    volatile i32 holding;
+    // the first letter of each name loaded, in the order they were
+    char load_order[16];
+    u32 load_order_count;
+} stub_loader_state;
+
+static stub_loader_state stub;
+
+static b8 stub_load(struct resource_loader* self, const char* name, void* params, resource* out_resource) {
+    stub.load_count++;
+    stub.load_order[stub.load_order_count++ % 16] = name[0];
+    if (katomic_load_i32(&stub.hold, KATOMIC_ACQUIRE)) {
+        katomic_store_i32(&stub.holding, 1, KATOMIC_RELEASE);
+        while (katomic_load_i32(&stub.hold, KATOMIC_ACQUIRE)) {
+            kthread_yield();
+        }
+    }
+    // anything called missing fails to load, as if the file was not there
+    if (strings_equal(name, "missing")) {
+        return false;
+    }
+    stub_params* p = params;
+    u32 size = p ? p->size : 16;
+    out_resource->name = name;
+    out_resource->data = kallocate(size, MEMORY_TAG_RESOURCE);
+    out_resource->data_size = size;
+    resource_loader_record_read(self, size);
+    return true;
+}
+
+static void stub_unload(struct resource_loader* self, resource* resource) {
+    stub.unload_count++;
+    string_ncopy(stub.last_unloaded, resource->name, RESOURCE_LOAD_NAME_MAX_LENGTH - 1);
+    kfree(resource->data, resource->data_size, MEMORY_TAG_RESOURCE);
+    resource->data = 0;
+    resource->data_size = 0;
+}
+
+static resource_loader stub_loader_create() {
+    resource_loader loader = {};
+    loader.type = RESOURCE_TYPE_CUSTOM;
+    loader.custom_type = STUB_TYPE;
+    loader.params_size = sizeof(stub_params);
+    loader.load = stub_load;
+    loader.unload = stub_unload;
+    return loader;
+}
+
+// starts the resource system with no assets, and the stub loader registered
+static void* start_resource_system(u64 cache_budget, u32 max_cache_entry_count, u64* out_size) {
+    kzero_memory(&stub, sizeof(stub_loader_state));
+    resource_system_config config = {};
+    config.max_loader_count = 16;
+    config.asset_base_path = "";
+    config.cache_budget = cache_budget;
+    config.max_cache_entry_count = max_cache_entry_count;
+    resource_system_initialize(out_size, 0, config);
+    void* state = kallocate(*out_size, MEMORY_TAG_RESOURCE);
+    if (!resource_system_initialize(out_size, state, config) || !resource_system_register_loader(stub_loader_create())) {
+        kfree(state, *out_size, MEMORY_TAG_RESOURCE);
+        return 0;
+    }
+    return state;
+}
+
+static void stop_resource_system(void* state, u64 size) {
+    resource_system_shutdown(state);
+    kfree(state, size, MEMORY_TAG_RESOURCE);
+}
+
+static b8 load_stub(const char* name, u32 size, u32 variant, resource* out_resource) {
+    stub_params params = {size, variant};
+    return resource_system_load_custom(name, STUB_TYPE, &params, out_resource);
+}
+
+static u32 cache_entry_count() {
+    u32 count = 0;
+    resource_system_cache_usage(0, &count);
+    return count;
+}
+
+static u64 cache_memory_size() {
+    u64 size = 0;
+    resource_system_cache_usage(&size, 0);
+    return size;
+}
+
+// what the async load callbacks have seen
+typedef struct async_test_data {
+    u64 main_thread_id;
+    b8 in_update;
+    u32 callback_count;
+    u32 callbacks_outside_update;
+    char callback_order[16];
+} async_test_data;
+
+static void async_load_complete(b8 success, resource* resource, void* user_data) {
+    async_test_data* data = user_data;
+    if (!data->in_update || kthread_get_current_id() != data->main_thread_id) {
+        data->callbacks_outside_update++;
+    }
+    data->callback_order[data->callback_count++ % 16] = success ? resource->name[0] : '!';
+    resource_system_unload(resource);
+}
+
+static resource_load_handle load_stub_async(const char* name, job_priority priority, async_test_data* data) {
+    resource_load_info info = resource_load_info_create(name, RESOURCE_TYPE_CUSTOM, async_load_complete, data);
+    info.custom_type = STUB_TYPE;
+    info.priority = priority;
+    return resource_system_load_async(info);
+}
+
+// runs job_system_update until every async load is done, as the application would once per frame. false if it took
+// too long
+static b8 pump_loads(async_test_data* data) {
+    clock timer;
+    clock_start(&timer);
+    while (resource_system_pending_load_count() > 0) {
+        data->in_update = true;
+        job_system_update();
+        data->in_update = false;
+        clock_update(&timer);
+        if (timer.elapsed > ASYNC_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+// waits until a load is held up in the stub loader
+static b8 wait_for_hold() {
+    clock timer;
+    clock_start(&timer);
+    while (!katomic_load_i32(&stub.holding, KATOMIC_ACQUIRE)) {
+        clock_update(&timer);
+        if (timer.elapsed > ASYNC_TEST_TIMEOUT_SECONDS) {
+            return false;
+        }
+        kthread_yield();
+    }
+    return true;
+}
+
+// a single worker and a single load at a time, so the queue order is the order things are loaded in. no cache
+typedef struct async_test_systems {
+    void* job_state;
+    u64 job_size;
+    void* resource_state;
+    u64 resource_size;
+} async_test_systems;
+
+static b8 start_async_systems(async_test_systems* systems) {
+    job_system_config job_config = {};
+    job_config.worker_count = 1;
+    job_config.max_job_count = 64;
+    job_system_initialize(&systems->job_size, 0, job_config);
+    systems->job_state = kallocate(systems->job_size, MEMORY_TAG_JOB);
+    if (!job_system_initialize(&systems->job_size, systems->job_state, job_config)) {
+        kfree(systems->job_state, systems->job_size, MEMORY_TAG_JOB);
+        return false;
+    }
+
+    kzero_memory(&stub, sizeof(stub_loader_state));
+    resource_system_config config = {};
+    config.max_loader_count = 16;
+    config.asset_base_path = "";
+    config.max_async_load_count = 16;
+    config.max_concurrent_load_count = 1;
+    resource_system_initialize(&systems->resource_size, 0, config);
+    systems->resource_state = kallocate(systems->resource_size, MEMORY_TAG_RESOURCE);
+    return resource_system_initialize(&systems->resource_size, systems->resource_state, config) && resource_system_register_loader(stub_loader_create());
+}
+
+static void stop_async_systems(async_test_systems* systems) {
+    job_system_shutdown(systems->job_state);
+    kfree(systems->job_state, systems->job_size, MEMORY_TAG_JOB);
+    resource_system_shutdown(systems->resource_state);
+    kfree(systems->resource_state, systems->resource_size, MEMORY_TAG_RESOURCE);
+}
+
+static void empty_job(void* params) {
+}
+
+u8 resource_cache_should_count_references() {
+    u64 size = 0;
+    void* state = start_resource_system(MEBIBYTES(1), 16, &size);
+    expect_should_not_be(0, state);
+
+    // the second load is served from the cache, and shares the first one's data
+    resource first, second;
+    expect_to_be_true(load_stub("a", 64, 0, &first));
+    expect_to_be_true(load_stub("a", 64, 0, &second));
+    expect_should_be(1, stub.load_count);
+    expect_should_be(first.data, second.data);
+    expect_should_be(1, cache_entry_count());
+    expect_should_be(STUB_ENTRY_SIZE(64), cache_memory_size());
+
+    // letting go of both leaves it cached, not unloaded
+    resource_system_unload(&first);
+    expect_should_be(0, first.data);
+    resource_system_unload(&second);
+    expect_should_be(0, stub.unload_count);
+    expect_should_be(1, cache_entry_count());
+
+    // a second unload of the same copy does nothing
+    resource_system_unload(&second);
+    expect_should_be(0, stub.unload_count);
+
+    // and the next load still skips the loader
+    expect_to_be_true(load_stub("a", 64, 0, &first));
+    expect_should_be(1, stub.load_count);
+    resource_system_unload(&first);
+
+    // shutting down unloads whatever is still cached
+    stop_resource_system(state, size);
+    expect_should_be(1, stub.unload_count);
+    return true;
+}
+
+u8 resource_cache_should_evict_least_recently_used() {
+    // room for two of them, but not three
+    u64 size = 0;
+    void* state = start_resource_system(STUB_ENTRY_SIZE(1000) * 2 + 10, 16, &size);
+    expect_should_not_be(0, state);
+
+    const char* names[3] = {"a", "b", "c"};
+    resource r;
+    for (u32 i = 0; i < 3; ++i) {
+        expect_to_be_true(load_stub(names[i], 1000, 0, &r));
+        resource_system_unload(&r);
+    }
+    // a was the oldest
+    expect_should_be(1, stub.unload_count);
+    expect_to_be_true(strings_equal("a", stub.last_unloaded));
+    expect_should_be(2, cache_entry_count());
+
+    // using b again moves it to the back, so c is next to go
+    expect_to_be_true(load_stub("b", 1000, 0, &r));
+    expect_should_be(3, stub.load_count);
+    resource_system_unload(&r);
+    expect_to_be_true(load_stub("a", 1000, 0, &r));
+    expect_should_be(4, stub.load_count);
+    resource_system_unload(&r);
+    expect_should_be(2, stub.unload_count);
+    expect_to_be_true(strings_equal("c", stub.last_unloaded));
+    expect_should_be(STUB_ENTRY_SIZE(1000) * 2, cache_memory_size());
+
+    stop_resource_system(state, size);
+    return true;
+}
+
+u8 resource_cache_should_not_evict_referenced_resources() {
+    // room for one
+    u64 size = 0;
+    void* state = start_resource_system(STUB_ENTRY_SIZE(1000) + 10, 16, &size);
+    expect_should_not_be(0, state);
+
+    // both stay while held, even though that is over budget
+    resource a, b;
+    expect_to_be_true(load_stub("a", 1000, 0, &a));
+    expect_to_be_true(load_stub("b", 1000, 0, &b));
+    expect_should_be(0, stub.unload_count);
+    expect_should_be(2, cache_entry_count());
+    expect_should_be(STUB_ENTRY_SIZE(1000) * 2, cache_memory_size());
+
+    // letting go of one brings it back under budget
+    resource_system_unload(&a);
+    expect_should_be(1, stub.unload_count);
+    expect_to_be_true(strings_equal("a", stub.last_unloaded));
+    resource_system_unload(&b);
+    expect_should_be(1, stub.unload_count);
+    expect_should_be(1, cache_entry_count());
+
+    stop_resource_system(state, size);
+    return true;
+}
+
+u8 resource_cache_should_key_on_params() {
+    u64 size = 0;
+    void* state = start_resource_system(MEBIBYTES(1), 16, &size);
+    expect_should_not_be(0, state);
+
+    // the same name with params that differ by a single byte are two resources
+    resource first, second, again;
+    expect_to_be_true(load_stub("a", 64, 1, &first));
+    expect_to_be_true(load_stub("a", 64, 2, &second));
+    expect_should_be(2, stub.load_count);
+    expect_should_not_be(first.data, second.data);
+    expect_should_be(2, cache_entry_count());
+
+    expect_to_be_true(load_stub("a", 64, 1, &again));
+    expect_should_be(2, stub.load_count);
+    expect_should_be(first.data, again.data);
+
+    resource_system_unload(&first);
+    resource_system_unload(&second);
+    resource_system_unload(&again);
+    stop_resource_system(state, size);
+    return true;
+}
+
+u8 resource_cache_should_invalidate_with_live_references() {
+    u64 size = 0;
+    void* state = start_resource_system(MEBIBYTES(1), 16, &size);
+    expect_should_not_be(0, state);
+
+    resource held, unheld;
+    expect_to_be_true(load_stub("a", 64, 0, &held));
+    expect_to_be_true(load_stub("a", 64, 1, &unheld));
+    resource_system_unload(&unheld);
+
+    // the copy nobody holds goes now, the held one stays with its holder
+    resource_system_invalidate_custom("a", STUB_TYPE);
+    expect_should_be(1, stub.unload_count);
+    expect_should_not_be(0, held.data);
+    expect_should_be(1, cache_entry_count());
+
+    // but can't be found any more, so loading it again goes to the loader
+    resource fresh;
+    expect_to_be_true(load_stub("a", 64, 0, &fresh));
+    expect_should_be(3, stub.load_count);
+    expect_should_not_be(held.data, fresh.data);
+    expect_should_be(2, cache_entry_count());
+
+    // the old copy is unloaded once let go of, and the new one cached as normal
+    resource_system_unload(&held);
+    expect_should_be(2, stub.unload_count);
+    expect_should_be(1, cache_entry_count());
+    resource_system_unload(&fresh);
+    expect_should_be(2, stub.unload_count);
+    expect_to_be_true(load_stub("a", 64, 0, &fresh));
+    expect_should_be(3, stub.load_count);
+    resource_system_unload(&fresh);
+
+    stop_resource_system(state, size);
+    return true;
+}
+
+u8 resource_async_should_load_by_priority() {
+    async_test_systems systems = {};
+    expect_to_be_true(start_async_systems(&systems));
+    async_test_data data = {};
+    data.main_thread_id = kthread_get_current_id();
+
+    // the first one takes the only load slot, and is held there while the rest queue up behind it
+    katomic_store_i32(&stub.hold, 1, KATOMIC_RELEASE);
+    expect_should_not_be(0, load_stub_async("a", JOB_PRIORITY_LOW, &data));
+    expect_to_be_true(wait_for_hold());
+    expect_should_not_be(0, load_stub_async("b", JOB_PRIORITY_LOW, &data));
+    expect_should_not_be(0, load_stub_async("c", JOB_PRIORITY_NORMAL, &data));
+    expect_should_not_be(0, load_stub_async("d", JOB_PRIORITY_HIGH, &data));
+    expect_should_not_be(0, load_stub_async("e", JOB_PRIORITY_HIGH, &data));
+    expect_should_be(5, resource_system_pending_load_count());
+    katomic_store_i32(&stub.hold, 0, KATOMIC_RELEASE);
+    expect_to_be_true(pump_loads(&data));
+
+    // highest priority first, then in the order requested
+    expect_should_be(5, stub.load_order_count);
+    expect_to_be_true(strings_nequal("adecb", stub.load_order, 5));
+    expect_should_be(5, data.callback_count);
+    expect_to_be_true(strings_nequal("adecb", data.callback_order, 5));
+    expect_should_be(0, data.callbacks_outside_update);
+
+    stop_async_systems(&systems);
+    return true;
+}
+
+u8 resource_async_should_cancel_loads() {
+    async_test_systems systems = {};
+    expect_to_be_true(start_async_systems(&systems));
+    async_test_data data = {};
+    data.main_thread_id = kthread_get_current_id();
+
+    katomic_store_i32(&stub.hold, 1, KATOMIC_RELEASE);
+    resource_load_handle running = load_stub_async("a", JOB_PRIORITY_NORMAL, &data);
+    expect_to_be_true(wait_for_hold());
+    resource_load_handle queued = load_stub_async("b", JOB_PRIORITY_NORMAL, &data);
+
+    // one not started yet is gone straight away, and never loaded
+    expect_to_be_true(resource_system_cancel_load(queued));
+    expect_should_be(1, resource_system_pending_load_count());
+    expect_to_be_false(resource_system_cancel_load(queued));
+
+    // one already loading finishes, but what it loaded is thrown away
+    expect_to_be_true(resource_system_cancel_load(running));
+    expect_to_be_false(resource_system_cancel_load(running));
+    katomic_store_i32(&stub.hold, 0, KATOMIC_RELEASE);
+    expect_to_be_true(pump_loads(&data));
+    expect_should_be(0, data.callback_count);
+    expect_should_be(1, stub.load_count);
+    expect_should_be(1, stub.unload_count);
+
+    // and one that has finished can't be cancelled any more
+    resource_load_handle finished = load_stub_async("c", JOB_PRIORITY_NORMAL, &data);
+    expect_to_be_true(pump_loads(&data));
+    expect_should_be(1, data.callback_count);
+    expect_to_be_false(resource_system_cancel_load(finished));
+    expect_to_be_false(resource_system_cancel_load(0));
+
+    stop_async_systems(&systems);
+    return true;
+}
+
+u8 resource_async_should_only_call_back_from_update() {
+    async_test_systems systems = {};
+    expect_to_be_true(start_async_systems(&systems));
+    async_test_data data = {};
+    data.main_thread_id = kthread_get_current_id();
+
+    expect_should_not_be(0, load_stub_async("a", JOB_PRIORITY_NORMAL, &data));
+    clock timer;
+    clock_start(&timer);
+    while (stub.load_count == 0 && timer.elapsed < ASYNC_TEST_TIMEOUT_SECONDS) {
+        clock_update(&timer);
+        kthread_yield();
+    }
+    expect_should_be(1, stub.load_count);
+
+    // waiting on jobs, even once the load has finished, doesn't run the callback
+    job_counter counter = {};
+    job_info info = job_create(empty_job, 0, JOB_PRIORITY_LOW);
+    info.counter = &counter;
+    job_system_submit(info);
+    job_system_wait(&counter);
+    expect_should_be(0, data.callback_count);
+    expect_should_be(1, resource_system_pending_load_count());
+
+    // only the update does, on this thread
+    expect_to_be_true(pump_loads(&data));
+    expect_should_be(1, data.callback_count);
+    expect_should_be(0, data.callbacks_outside_update);
+
+    stop_async_systems(&systems);
+    return true;
+}
+
+u8 resource_loader_should_register_by_type_and_name() {
+    // the stub loader is registered as "stub"
+    u64 size = 0;
+    void* state = start_resource_system(0, 0, &size);
+    expect_should_not_be(0, state);
+
+    // custom names are looked up whatever their case
+    resource r;
+    expect_to_be_true(resource_system_load_custom("a", "STUB", 0, &r));
+    expect_should_be(1, stub.load_count);
+    resource_system_unload(&r);
+    expect_to_be_true(resource_system_load_custom("a", "Stub", 0, &r));
+    expect_should_be(2, stub.load_count);
+    resource_system_unload(&r);
+    expect_to_be_false(resource_system_load_custom("a", "stubs", 0, &r));
+    expect_should_be(INVALID_ID, r.loader_id);
+
+    // a second loader for a name already taken, in any case, is turned away
+    resource_loader loader = stub_loader_create();
+    loader.custom_type = "STUB";
+    expect_to_be_false(resource_system_register_loader(loader));
+
+    // as is a second one for a built in type, or a custom one with no name or one too long to keep
+    loader.type = RESOURCE_TYPE_TEXT;
+    expect_to_be_false(resource_system_register_loader(loader));
+    loader.type = RESOURCE_TYPE_CUSTOM;
+    loader.custom_type = "";
+    expect_to_be_false(resource_system_register_loader(loader));
+    char long_name[RESOURCE_CUSTOM_TYPE_MAX_LENGTH + 1];
+    kset_memory(long_name, 'x', RESOURCE_CUSTOM_TYPE_MAX_LENGTH);
+    long_name[RESOURCE_CUSTOM_TYPE_MAX_LENGTH] = 0;
+    loader.custom_type = long_name;
+    expect_to_be_false(resource_system_register_loader(loader));
+
+    // a different name is fine, and its name is kept by the system rather than pointing at the caller's string
+    char name[16] = "other";
+    loader.custom_type = name;
+    expect_to_be_true(resource_system_register_loader(loader));
+    kset_memory(name, 0, sizeof(name));
+    expect_to_be_true(resource_system_load_custom("a", "OTHER", 0, &r));
+    resource_system_unload(&r);
+
+    stop_resource_system(state, size);
+    return true;
+}
+
+u8 resource_loader_should_keep_stats() {
+    u64 size = 0;
+    void* state = start_resource_system(MEBIBYTES(1), 16, &size);
+    expect_should_not_be(0, state);
+
+    resource_loader_stats stats;
+    expect_to_be_true(resource_system_loader_stats(RESOURCE_TYPE_CUSTOM, "Stub", &stats));
+    expect_should_be(0, stats.load_count);
+
+    // two loads, one of them failed, and a cache hit
+    resource first, second, failed;
+    expect_to_be_true(load_stub("a", 100, 0, &first));
+    expect_to_be_true(load_stub("a", 100, 0, &second));
+    expect_to_be_false(load_stub("missing", 100, 0, &failed));
+    resource_system_unload(&first);
+    resource_system_unload(&second);
+
+    expect_to_be_true(resource_system_loader_stats(RESOURCE_TYPE_CUSTOM, STUB_TYPE, &stats));
+    expect_should_be(2, stats.load_count);
+    expect_should_be(1, stats.failed_count);
+    expect_should_be(1, stats.cache_hit_count);
+    expect_should_be(100, stats.bytes_read);
+
+    // other loaders are counted separately, and there are no stats for a loader that isn't there
+    expect_to_be_true(resource_system_loader_stats(RESOURCE_TYPE_TEXT, 0, &stats));
+    expect_should_be(0, stats.load_count);
+    expect_to_be_false(resource_system_loader_stats(RESOURCE_TYPE_CUSTOM, "nothing", &stats));
+    expect_to_be_false(resource_system_loader_stats(RESOURCE_TYPE_CUSTOM, 0, &stats));
+
+    stop_resource_system(state, size);
+    return true;
+}
+
+void resource_system_register_tests() {
+    test_manager_register_test(resource_cache_should_count_references, "Resource cache should share loads and count references.");
+    test_manager_register_test(resource_cache_should_evict_least_recently_used, "Resource cache should evict the least recently used to stay in budget.");
+    test_manager_register_test(resource_cache_should_not_evict_referenced_resources, "Resource cache should not evict resources still loaded.");
+    test_manager_register_test(resource_cache_should_key_on_params, "Resource cache should keep resources with different params apart.");
+    test_manager_register_test(resource_cache_should_invalidate_with_live_references, "Resource cache should invalidate resources that are still loaded.");
+    test_manager_register_test(resource_loader_should_register_by_type_and_name, "Resource loaders should register once per type or custom name.");
+    test_manager_register_test(resource_loader_should_keep_stats, "Resource loaders should count loads, failures, cache hits and reads.");
+    test_manager_register_test(resource_async_should_load_by_priority, "Resource async loads should start highest priority first.");
+    test_manager_register_test(resource_async_should_cancel_loads, "Resource async loads should cancel whether queued or running.");
+    test_manager_register_test(resource_async_should_only_call_back_from_update, "Resource async loads should only call back from the job system update.");
+}
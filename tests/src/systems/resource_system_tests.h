@@ -0,0 +1,3 @@
+#pragma once
+
+void resource_system_register_tests();
@@ -0,0 +1,310 @@
+#include "vfs_system_tests.h"
+#include "../test_manager.h"
+#include "../expect.h"
+
+#include <defines.h>
+#include <core/kmemory.h>
+#include <core/kstring.h>
+#include <platform/filesystem.h>
+#include <systems/vfs_system.h>
+
+#include <stdio.h>  // remove
+
+#define VFS_TEST_TEXT_SOURCE "vfs_tests_text.txt"
+#define VFS_TEST_NOISE_SOURCE "vfs_tests_noise.bin"
+#define VFS_TEST_OVERRIDE_SOURCE "vfs_tests_override.txt"
+#define VFS_TEST_ARCHIVE "vfs_tests.kpk"
+#define VFS_TEST_OVERRIDE_ARCHIVE "vfs_tests_override.kpk"
+#define VFS_TEST_BROKEN_ARCHIVE "vfs_tests_broken.kpk"
+
+#define VFS_TEST_TEXT_SIZE 4096
+#define VFS_TEST_NOISE_SIZE 4096
+
+// NOTE: these mirror the archive layout in vfs_system.c, so the tests can look at and break what vfs_archive_write wrote
+#define VFS_TEST_HEADER_ENTRY_COUNT 12
+#define VFS_TEST_HEADER_SLOT_COUNT 16
+#define VFS_TEST_HEADER_ENTRIES_OFFSET 24
+#define VFS_TEST_ENTRY_SIZE 48
+#define VFS_TEST_ENTRY_STORED_SIZE 16
+#define VFS_TEST_ENTRY_UNCOMPRESSED_SIZE 24
+#define VFS_TEST_ENTRY_COMPRESSION 40
+
+static const char* override_text = "the later mount wins";
+
+static b8 write_file(const char* path, u64 size, const void* data) {
+    file_handle f;
+    if (!filesystem_open(path, FILE_MODE_WRITE, true, &f)) {
+        return false;
+    }
+    u64 written = 0;
+    b8 result = filesystem_write(&f, size, data, &written) && written == size;
+    filesystem_close(&f);
+    return result;
+}
+
+static void fill_text(u8* text) {
+    const char* line = "the quick brown fox jumps over the lazy dog\n";
+    u32 line_length = string_length(line);
+    for (u32 i = 0; i < VFS_TEST_TEXT_SIZE; ++i) {
+        text[i] = line[i % line_length];
+    }
+}
+
+// xorshift, so the noise is the same every run and leaves lz4 nothing to find
+static void fill_noise(u8* noise) {
+    u32 x = 0x9E3779B9;
+    for (u32 i = 0; i < VFS_TEST_NOISE_SIZE; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        noise[i] = (u8)(x >> 24);
+    }
+}
+
+static u32 read_u32(const u8* data, u64 offset) {
+    u32 value;
+    kcopy_memory(&value, data + offset, sizeof(u32));
+    return value;
+}
+
+static u64 read_u64(const u8* data, u64 offset) {
+    u64 value;
+    kcopy_memory(&value, data + offset, sizeof(u64));
+    return value;
+}
+
+static b8 bytes_equal(const void* a, const void* b, u64 size) {
+    const u8* x = a;
+    const u8* y = b;
+    for (u64 i = 0; i < size; ++i) {
+        if (x[i] != y[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static b8 file_matches(const char* path, u64 size, const void* data, b8 archived) {
+    vfs_file file;
+    if (!vfs_open(path, &file)) {
+        return false;
+    }
+    b8 result = file.size == size && file.is_archived == archived && bytes_equal(file.data, data, size);
+    vfs_close(&file);
+    return result;
+}
+
+// writes the text and noise files and an archive holding both, compression on for each
+static b8 write_test_archive(u8* text, u8* noise) {
+    fill_text(text);
+    fill_noise(noise);
+    if (!write_file(VFS_TEST_TEXT_SOURCE, VFS_TEST_TEXT_SIZE, text) || !write_file(VFS_TEST_NOISE_SOURCE, VFS_TEST_NOISE_SIZE, noise)) {
+        return false;
+    }
+    vfs_archive_file files[2] = {
+        {"textures/a.txt", VFS_TEST_TEXT_SOURCE, true},
+        {"data/noise.bin", VFS_TEST_NOISE_SOURCE, true}};
+    return vfs_archive_write(VFS_TEST_ARCHIVE, 2, files, 0);
+}
+
+// copies the test archive to the broken one, minus trim bytes off the end
+static b8 copy_archive(u64 trim, u8** out_data, u64* out_size) {
+    file_mapping mapping;
+    if (!filesystem_map(VFS_TEST_ARCHIVE, FILE_ACCESS_PATTERN_SEQUENTIAL, &mapping)) {
+        return false;
+    }
+    *out_size = mapping.size - trim;
+    *out_data = kallocate(mapping.size, MEMORY_TAG_ARRAY);
+    kcopy_memory(*out_data, mapping.data, mapping.size);
+    filesystem_unmap(&mapping);
+    return write_file(VFS_TEST_BROKEN_ARCHIVE, *out_size, *out_data);
+}
+
+static void remove_test_files() {
+    remove(VFS_TEST_TEXT_SOURCE);
+    remove(VFS_TEST_NOISE_SOURCE);
+    remove(VFS_TEST_OVERRIDE_SOURCE);
+    remove(VFS_TEST_ARCHIVE);
+    remove(VFS_TEST_OVERRIDE_ARCHIVE);
+    remove(VFS_TEST_BROKEN_ARCHIVE);
+}
+
+static void* start_vfs(u64* out_size) {
+    vfs_system_config config = {4};
+    vfs_system_initialize(out_size, 0, config);
+    void* state = kallocate(*out_size, MEMORY_TAG_APPLICATION);
+    if (!vfs_system_initialize(out_size, state, config)) {
+        kfree(state, *out_size, MEMORY_TAG_APPLICATION);
+        return 0;
+    }
+    return state;
+}
+
+static void stop_vfs(void* state, u64 size) {
+    vfs_system_shutdown(state);
+    kfree(state, size, MEMORY_TAG_APPLICATION);
+}
+
+u8 vfs_should_open_archived_files_by_either_separator() {
+    u8* text = kallocate(VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    u8* noise = kallocate(VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true(write_test_archive(text, noise));
+    u64 size = 0;
+    void* state = start_vfs(&size);
+    expect_should_not_be(0, state);
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_ARCHIVE));
+
+    expect_to_be_true(vfs_exists("textures/a.txt"));
+    expect_to_be_true(vfs_exists("textures\\a.txt"));
+    expect_to_be_false(vfs_exists("textures/b.txt"));
+    expect_to_be_true(file_matches("textures/a.txt", VFS_TEST_TEXT_SIZE, text, true));
+    expect_to_be_true(file_matches("textures\\a.txt", VFS_TEST_TEXT_SIZE, text, true));
+    expect_to_be_true(file_matches("data\\noise.bin", VFS_TEST_NOISE_SIZE, noise, true));
+
+    // the extension lookup goes through the same hashing
+    const char* extensions[2] = {".png", ".txt"};
+    vfs_file file;
+    u32 extension_index = 0;
+    expect_to_be_true(vfs_open_any("textures\\a", 2, extensions, &file, &extension_index));
+    expect_should_be(1, extension_index);
+    expect_should_be(VFS_TEST_TEXT_SIZE, file.size);
+    vfs_close(&file);
+
+    stop_vfs(state, size);
+    remove_test_files();
+    kfree(noise, VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    kfree(text, VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 vfs_later_mount_should_override_earlier() {
+    u8* text = kallocate(VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    u8* noise = kallocate(VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true(write_test_archive(text, noise));
+    u32 override_length = string_length(override_text);
+    expect_to_be_true(write_file(VFS_TEST_OVERRIDE_SOURCE, override_length, override_text));
+    vfs_archive_file override_file = {"textures/a.txt", VFS_TEST_OVERRIDE_SOURCE, false};
+    expect_to_be_true(vfs_archive_write(VFS_TEST_OVERRIDE_ARCHIVE, 1, &override_file, 0));
+
+    u64 size = 0;
+    void* state = start_vfs(&size);
+    expect_should_not_be(0, state);
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_ARCHIVE));
+    expect_to_be_true(file_matches("textures/a.txt", VFS_TEST_TEXT_SIZE, text, true));
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_OVERRIDE_ARCHIVE));
+    expect_to_be_true(file_matches("textures\\a.txt", override_length, override_text, true));
+    // what the later mount doesn't have still comes from the earlier one
+    expect_to_be_true(file_matches("data/noise.bin", VFS_TEST_NOISE_SIZE, noise, true));
+    stop_vfs(state, size);
+
+    // the other way around, the original wins
+    state = start_vfs(&size);
+    expect_should_not_be(0, state);
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_OVERRIDE_ARCHIVE));
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_ARCHIVE));
+    expect_to_be_true(file_matches("textures/a.txt", VFS_TEST_TEXT_SIZE, text, true));
+    stop_vfs(state, size);
+
+    remove_test_files();
+    kfree(noise, VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    kfree(text, VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 vfs_archive_should_store_incompressible_files_raw() {
+    u8* text = kallocate(VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    u8* noise = kallocate(VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true(write_test_archive(text, noise));
+
+    file_mapping mapping;
+    expect_to_be_true(filesystem_map(VFS_TEST_ARCHIVE, FILE_ACCESS_PATTERN_NORMAL, &mapping));
+    const u8* data = mapping.data;
+    expect_should_be(2, read_u32(data, VFS_TEST_HEADER_ENTRY_COUNT));
+    u64 entries_offset = read_u64(data, VFS_TEST_HEADER_ENTRIES_OFFSET);
+    u32 found = 0;
+    for (u32 i = 0; i < 2; ++i) {
+        const u8* entry = data + entries_offset + i * VFS_TEST_ENTRY_SIZE;
+        u64 stored = read_u64(entry, VFS_TEST_ENTRY_STORED_SIZE);
+        u32 compression = read_u32(entry, VFS_TEST_ENTRY_COMPRESSION);
+        // the sizes differ, so they tell the entries apart whatever order they were written in
+        if (read_u64(entry, VFS_TEST_ENTRY_UNCOMPRESSED_SIZE) == VFS_TEST_NOISE_SIZE && compression == VFS_COMPRESSION_NONE) {
+            expect_should_be(VFS_TEST_NOISE_SIZE, stored);
+            found++;
+        } else if (compression == VFS_COMPRESSION_LZ4) {
+            expect_should_be(VFS_TEST_TEXT_SIZE, read_u64(entry, VFS_TEST_ENTRY_UNCOMPRESSED_SIZE));
+            expect_to_be_true(stored < VFS_TEST_TEXT_SIZE / 2);
+            found++;
+        }
+    }
+    filesystem_unmap(&mapping);
+    expect_should_be(2, found);
+
+    // and both read back the same either way
+    u64 size = 0;
+    void* state = start_vfs(&size);
+    expect_should_not_be(0, state);
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_ARCHIVE));
+    expect_to_be_true(file_matches("data/noise.bin", VFS_TEST_NOISE_SIZE, noise, true));
+    expect_to_be_true(file_matches("textures/a.txt", VFS_TEST_TEXT_SIZE, text, true));
+    stop_vfs(state, size);
+
+    remove_test_files();
+    kfree(noise, VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    kfree(text, VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 vfs_should_reject_broken_archives() {
+    u8* text = kallocate(VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    u8* noise = kallocate(VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    expect_to_be_true(write_test_archive(text, noise));
+    u64 size = 0;
+    void* state = start_vfs(&size);
+    expect_should_not_be(0, state);
+
+    // truncated
+    u8* copy = 0;
+    u64 copy_size = 0;
+    u64 full_size = 0;
+    expect_to_be_true(copy_archive(16, &copy, &copy_size));
+    full_size = copy_size + 16;
+    expect_to_be_false(vfs_mount_archive(VFS_TEST_BROKEN_ARCHIVE));
+
+    // the whole of it is fine
+    expect_to_be_true(write_file(VFS_TEST_BROKEN_ARCHIVE, full_size, copy));
+    expect_to_be_true(vfs_mount_archive(VFS_TEST_BROKEN_ARCHIVE));
+    stop_vfs(state, size);
+    state = start_vfs(&size);
+    expect_should_not_be(0, state);
+
+    // a lookup table that isn't a power of 2
+    u32 slot_count = read_u32(copy, VFS_TEST_HEADER_SLOT_COUNT) + 1;
+    kcopy_memory(copy + VFS_TEST_HEADER_SLOT_COUNT, &slot_count, sizeof(u32));
+    expect_to_be_true(write_file(VFS_TEST_BROKEN_ARCHIVE, full_size, copy));
+    expect_to_be_false(vfs_mount_archive(VFS_TEST_BROKEN_ARCHIVE));
+    slot_count--;
+    kcopy_memory(copy + VFS_TEST_HEADER_SLOT_COUNT, &slot_count, sizeof(u32));
+
+    // entries past the end of the file
+    u64 entries_offset = full_size - 8;
+    kcopy_memory(copy + VFS_TEST_HEADER_ENTRIES_OFFSET, &entries_offset, sizeof(u64));
+    expect_to_be_true(write_file(VFS_TEST_BROKEN_ARCHIVE, full_size, copy));
+    expect_to_be_false(vfs_mount_archive(VFS_TEST_BROKEN_ARCHIVE));
+
+    // none of it got mounted
+    expect_to_be_false(vfs_exists("textures/a.txt"));
+
+    stop_vfs(state, size);
+    kfree(copy, full_size, MEMORY_TAG_ARRAY);
+    remove_test_files();
+    kfree(noise, VFS_TEST_NOISE_SIZE, MEMORY_TAG_ARRAY);
+    kfree(text, VFS_TEST_TEXT_SIZE, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void vfs_system_register_tests() {
+    test_manager_register_test(vfs_should_open_archived_files_by_either_separator, "Vfs should open archived files with either path separator.");
+    test_manager_register_test(vfs_later_mount_should_override_earlier, "Vfs mounts made later should take priority.");
+    test_manager_register_test(vfs_archive_should_store_incompressible_files_raw, "Vfs archives should store files that don't compress raw.");
+    test_manager_register_test(vfs_should_reject_broken_archives, "Vfs should reject truncated and corrupt archives.");
+}